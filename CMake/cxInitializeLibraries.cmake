@@ -177,6 +177,7 @@ macro(cx_initialize_VTK)
 		vtkRenderingVolume
 		vtkIOGeometry vtkIOLegacy vtkIOMINC vtkIOXML
 		vtkIOXMLParser
+		vtkzlib
 		vtkFiltersModeling
 		vtkInteractionWidgets
 		vtkParallelCore
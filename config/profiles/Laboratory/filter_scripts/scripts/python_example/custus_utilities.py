@@ -1,5 +1,7 @@
 import os
+import sys
 import shutil
+import struct
 import SimpleITK as sitk
 import numpy as np
 import matplotlib.pyplot as plt
@@ -88,3 +90,44 @@ class simpleView():
 
 
 
+
+
+# Memory mapped volume exchange, see cx::ScriptDataExchange
+exchange_header_size = 128
+exchange_dtypes = {3: np.uint8, 4: np.int16, 5: np.uint16, 6: np.int32, 10: np.float32, 11: np.float64}
+
+def read_exchange(path):
+    """Map a .cximg file. Returns (array[z,y,x,c], spacing, origin)."""
+    with open(path, 'rb') as f:
+        header = f.read(80)
+    magic, header_size, scalar_type, components, dx, dy, dz, sx, sy, sz, ox, oy, oz = struct.unpack('<8s6i3d3d', header)
+    if magic != b'CXIMG001':
+        raise ValueError('Not a CustusX exchange file: ' + path)
+    data = np.memmap(path, dtype=exchange_dtypes[scalar_type], mode='r', offset=header_size,
+                     shape=(dz, dy, dx, components))
+    return data, (sx, sy, sz), (ox, oy, oz)
+
+def write_exchange(path, data, spacing, origin=(0, 0, 0)):
+    """Write array[z,y,x] or array[z,y,x,c] to a .cximg file."""
+    if data.ndim == 3:
+        data = data[..., np.newaxis]
+    scalar_type = [k for k, v in exchange_dtypes.items() if v == data.dtype.type][0]
+    dz, dy, dx, components = data.shape
+    header = struct.pack('<8s6i3d3d', b'CXIMG001', exchange_header_size, scalar_type, components, dx, dy, dz,
+                         spacing[0], spacing[1], spacing[2], origin[0], origin[1], origin[2])
+    with open(path, 'wb') as f:
+        f.write(header.ljust(exchange_header_size, b'\0'))
+        f.write(np.ascontiguousarray(data).tobytes())
+
+def run_worker(process):
+    """Call process(input_path, output_path) for each request from CustusX, see cx::ScriptWorker.
+    Load models etc. before calling this, they are kept between requests."""
+    for line in sys.stdin:
+        request_id, input_path, output_path = line.rstrip('\n').split('\t')
+        try:
+            process(input_path, output_path)
+            code = 0
+        except Exception as e:
+            print('Worker request failed: ', e)
+            code = 1
+        print('CX_DONE', code, request_id, flush=True)
@@ -28,8 +28,21 @@ class custusVolume():
         new_raw_path = new_path + '.raw'
         shutil.copy(raw_path, new_raw_path)
 
-# Duplcate input volume:
-input_image_path = sys.argv[1] # First argument should always be input volume
-output_image_path = sys.argv[2] # Second argument should always be destination volume file
-input_volume = custusVolume(input_image_path)
-input_volume.duplicate(output_image_path)
+# Duplcate input volume, either .mhd files or a memory mapped .cximg file:
+def duplicate(input_image_path, output_image_path):
+    if input_image_path.endswith('.cximg'):
+        shutil.copy(input_image_path, os.path.splitext(output_image_path)[0] + '.cximg')
+    else:
+        input_volume = custusVolume(input_image_path)
+        input_volume.duplicate(output_image_path)
+
+if '--worker' in sys.argv:
+    # Persistent mode: one request per line on stdin, see custus_utilities.run_worker
+    for line in sys.stdin:
+        input_image_path, output_image_path = line.rstrip('\n').split('\t')
+        duplicate(input_image_path, output_image_path)
+        print('CX_DONE 0', flush=True)
+else:
+    input_image_path = sys.argv[1] # First argument should always be input volume
+    output_image_path = sys.argv[2] # Second argument should always be destination volume file
+    duplicate(input_image_path, output_image_path)
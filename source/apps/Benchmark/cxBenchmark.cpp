@@ -0,0 +1,337 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxBenchmark.h"
+
+#include <algorithm>
+#include <iostream>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QThread>
+#include <QSysInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "cxLogger.h"
+#include "cxTime.h"
+
+#ifdef CX_WINDOWS
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace cx
+{
+
+double BenchmarkResult::getMedianWallTime() const
+{
+	if (wallTimes.empty())
+		return 0;
+	std::vector<double> sorted = wallTimes;
+	std::sort(sorted.begin(), sorted.end());
+	size_t n = sorted.size();
+	if (n%2)
+		return sorted[n/2];
+	return (sorted[n/2-1] + sorted[n/2]) / 2;
+}
+
+double BenchmarkResult::getThroughput() const
+{
+	double time = this->getMedianWallTime();
+	if (time <= 0)
+		return 0;
+	return work / time;
+}
+
+Benchmark::Benchmark(BenchmarkContext context) :
+	mContext(context)
+{
+}
+
+void Benchmark::addScenario(BenchmarkScenarioPtr scenario)
+{
+	mScenarios.push_back(scenario);
+}
+
+QStringList Benchmark::getScenarioNames() const
+{
+	QStringList retval;
+	for (unsigned i=0; i<mScenarios.size(); ++i)
+		retval << mScenarios[i]->getName();
+	return retval;
+}
+
+BenchmarkScenarioPtr Benchmark::getScenario(QString name) const
+{
+	for (unsigned i=0; i<mScenarios.size(); ++i)
+		if (mScenarios[i]->getName() == name)
+			return mScenarios[i];
+	return BenchmarkScenarioPtr();
+}
+
+void Benchmark::run(QStringList names, int repeats)
+{
+	for (int i=0; i<names.size(); ++i)
+	{
+		BenchmarkScenarioPtr scenario = this->getScenario(names[i]);
+		if (!scenario)
+		{
+			CX_LOG_WARNING() << "Benchmark: Unknown scenario " << names[i];
+			continue;
+		}
+		std::cout << "Running " << names[i].toStdString() << "..." << std::endl;
+		BenchmarkResult result = this->runScenario(scenario, repeats);
+		print(result);
+		mResults.push_back(result);
+	}
+}
+
+BenchmarkResult Benchmark::runScenario(BenchmarkScenarioPtr scenario, int repeats)
+{
+	BenchmarkResult result;
+	result.name = scenario->getName();
+	result.unit = scenario->getUnit();
+
+	QString skipReason = scenario->setUp(mContext);
+	if (!skipReason.isEmpty())
+	{
+		result.status = "skipped";
+		result.message = skipReason;
+		scenario->tearDown();
+		return result;
+	}
+
+	result.status = "ok";
+	for (int i=0; i<repeats; ++i)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		double work = scenario->run();
+		double seconds = double(timer.nsecsElapsed()) / 1.0E9;
+
+		if (work < 0)
+		{
+			result.status = "failed";
+			result.message = QString("run %1 failed").arg(i);
+			break;
+		}
+		result.work = work;
+		result.wallTimes.push_back(seconds);
+	}
+
+	scenario->tearDown();
+	result.peakRSS = getPeakRSS();
+	return result;
+}
+
+/** Run each scenario in a fresh process, so that setup and memory use of
+ *  one scenario does not affect the others.
+ */
+void Benchmark::runIsolated(QStringList names, QStringList arguments)
+{
+	for (int i=0; i<names.size(); ++i)
+	{
+		QString resultFile = QString("%1/result_%2.json").arg(mContext.tempFolder).arg(names[i]);
+		QFile::remove(resultFile);
+
+		QStringList childArguments = arguments;
+		childArguments << "--scenario" << names[i] << "--output" << resultFile << "--no-isolate";
+
+		QProcess process;
+		process.setProcessChannelMode(QProcess::ForwardedChannels);
+		process.start(QCoreApplication::applicationFilePath(), childArguments);
+		process.waitForFinished(-1);
+
+		std::vector<BenchmarkResult> results = readResults(resultFile);
+		QFile::remove(resultFile);
+		if (results.empty())
+		{
+			BenchmarkResult failed;
+			failed.name = names[i];
+			failed.status = "failed";
+			failed.message = QString("process exited with code %1").arg(process.exitCode());
+			if (process.exitStatus() == QProcess::CrashExit)
+				failed.message = "process crashed";
+			print(failed);
+			results.push_back(failed);
+		}
+		mResults.insert(mResults.end(), results.begin(), results.end());
+	}
+}
+
+void Benchmark::print(const BenchmarkResult& result)
+{
+	QString text = QString("  %1: %2").arg(result.name, -32).arg(result.status);
+	if (result.isOk())
+		text += QString(", %1 s, %2 %3/s, peak %4 MB")
+				.arg(result.getMedianWallTime(), 0, 'f', 3)
+				.arg(result.getThroughput(), 0, 'f', 1)
+				.arg(result.unit)
+				.arg(result.peakRSS, 0, 'f', 0);
+	if (!result.message.isEmpty())
+		text += " (" + result.message + ")";
+	std::cout << text.toStdString() << std::endl;
+}
+
+bool Benchmark::writeResults(QString filename) const
+{
+	QJsonArray scenarios;
+	for (unsigned i=0; i<mResults.size(); ++i)
+	{
+		const BenchmarkResult& result = mResults[i];
+		QJsonArray wallTimes;
+		for (unsigned j=0; j<result.wallTimes.size(); ++j)
+			wallTimes.append(result.wallTimes[j]);
+
+		QJsonObject scenario;
+		scenario["name"] = result.name;
+		scenario["status"] = result.status;
+		scenario["message"] = result.message;
+		scenario["unit"] = result.unit;
+		scenario["work"] = result.work;
+		scenario["wallTimes"] = wallTimes;
+		scenario["medianWallTime"] = result.getMedianWallTime();
+		scenario["throughput"] = result.getThroughput();
+		scenario["peakRSS"] = result.peakRSS;
+		scenarios.append(scenario);
+	}
+
+	QJsonObject system;
+	system["os"] = QSysInfo::prettyProductName();
+	system["cpu"] = QSysInfo::currentCpuArchitecture();
+	system["threads"] = QThread::idealThreadCount();
+
+	QJsonObject root;
+	root["version"] = 1;
+	root["timestamp"] = QDateTime::currentDateTime().toString(timestampSecondsFormat());
+	root["seed"] = double(mContext.seed);
+	root["dataFolder"] = mContext.dataFolder;
+	root["system"] = system;
+	root["scenarios"] = scenarios;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "Benchmark: Failed to write results to " << filename;
+		return false;
+	}
+	file.write(QJsonDocument(root).toJson());
+	return true;
+}
+
+std::vector<BenchmarkResult> Benchmark::readResults(QString filename)
+{
+	std::vector<BenchmarkResult> retval;
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return retval;
+
+	QJsonArray scenarios = QJsonDocument::fromJson(file.readAll()).object()["scenarios"].toArray();
+	for (int i=0; i<scenarios.size(); ++i)
+	{
+		QJsonObject scenario = scenarios[i].toObject();
+		BenchmarkResult result;
+		result.name = scenario["name"].toString();
+		result.status = scenario["status"].toString();
+		result.message = scenario["message"].toString();
+		result.unit = scenario["unit"].toString();
+		result.work = scenario["work"].toDouble();
+		result.peakRSS = scenario["peakRSS"].toDouble();
+		QJsonArray wallTimes = scenario["wallTimes"].toArray();
+		for (int j=0; j<wallTimes.size(); ++j)
+			result.wallTimes.push_back(wallTimes[j].toDouble());
+		retval.push_back(result);
+	}
+	return retval;
+}
+
+bool Benchmark::compare(std::vector<BenchmarkResult> results, std::vector<BenchmarkResult> baseline, double tolerance)
+{
+	bool success = true;
+	std::cout << "Comparison with baseline, tolerance " << tolerance*100 << "%:" << std::endl;
+
+	for (unsigned i=0; i<results.size(); ++i)
+	{
+		const BenchmarkResult& current = results[i];
+		const BenchmarkResult* base = NULL;
+		for (unsigned j=0; j<baseline.size(); ++j)
+			if (baseline[j].name == current.name)
+				base = &baseline[j];
+
+		QString verdict;
+		QString details;
+		if (!base || !base->isOk())
+		{
+			verdict = "new";
+		}
+		else if (current.status == "skipped")
+		{
+			verdict = "skipped";
+		}
+		else if (!current.isOk())
+		{
+			verdict = "REGRESSION";
+			details = "failed, ok in baseline";
+		}
+		else
+		{
+			double time = current.getMedianWallTime() / base->getMedianWallTime() - 1;
+			double memory = base->peakRSS > 0 ? current.peakRSS / base->peakRSS - 1 : 0;
+			details = QString("time %1%, memory %2%")
+					.arg(time*100, 0, 'f', 1)
+					.arg(memory*100, 0, 'f', 1);
+			verdict = "ok";
+			if (time > tolerance || memory > tolerance)
+				verdict = "REGRESSION";
+		}
+
+		if (verdict == "REGRESSION")
+			success = false;
+		std::cout << QString("  %1: %2 %3").arg(current.name, -32).arg(verdict, -10).arg(details).toStdString() << std::endl;
+	}
+
+	for (unsigned j=0; j<baseline.size(); ++j)
+	{
+		bool found = false;
+		for (unsigned i=0; i<results.size(); ++i)
+			found = found || (results[i].name == baseline[j].name);
+		if (!found)
+			std::cout << QString("  %1: not run").arg(baseline[j].name, -32).toStdString() << std::endl;
+	}
+
+	return success;
+}
+
+double Benchmark::getPeakRSS()
+{
+#ifdef CX_WINDOWS
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return double(counters.PeakWorkingSetSize) / (1024*1024);
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return double(usage.ru_maxrss) / (1024*1024); // bytes on mac
+#else
+	return double(usage.ru_maxrss) / 1024; // kB on linux
+#endif
+#endif
+}
+
+} // namespace cx
@@ -0,0 +1,86 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXBENCHMARK_H
+#define CXBENCHMARK_H
+
+#include <vector>
+#include <QStringList>
+#include "cxBenchmarkScenario.h"
+
+namespace cx
+{
+
+/** Measurements from all runs of one scenario.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+struct BenchmarkResult
+{
+	BenchmarkResult() : work(0), peakRSS(0) {}
+	QString name;
+	QString status; ///< "ok", "failed" or "skipped"
+	QString message;
+	QString unit;
+	std::vector<double> wallTimes; ///< seconds, one per run
+	double work; ///< per run, in unit
+	double peakRSS; ///< MB, high water mark of the process after the runs
+
+	double getMedianWallTime() const;
+	double getThroughput() const; ///< work per second, based on the median wall time
+	bool isOk() const { return status == "ok"; }
+};
+
+/** Headless benchmark of core pipelines.
+ *
+ * Runs a set of BenchmarkScenarios a number of times each, and collects
+ * wall time, peak resident memory and throughput. Results are stored
+ * as JSON, and can be compared to a stored baseline: a scenario regresses
+ * if its median wall time or peak memory exceeds the baseline by more
+ * than a tolerance.
+ *
+ * Peak memory is a process wide high water mark, so for the memory
+ * numbers to be comparable each scenario should run in its own process,
+ * see runIsolated().
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class Benchmark
+{
+public:
+	explicit Benchmark(BenchmarkContext context);
+	void addScenario(BenchmarkScenarioPtr scenario);
+	QStringList getScenarioNames() const;
+
+	void run(QStringList names, int repeats); ///< run in this process
+	void runIsolated(QStringList names, QStringList arguments); ///< run each scenario in a child process, passing arguments on
+	std::vector<BenchmarkResult> getResults() const { return mResults; }
+
+	bool writeResults(QString filename) const;
+	static std::vector<BenchmarkResult> readResults(QString filename);
+	static bool compare(std::vector<BenchmarkResult> results, std::vector<BenchmarkResult> baseline, double tolerance); ///< print a comparison, return false on regression
+
+	static double getPeakRSS(); ///< MB
+
+private:
+	BenchmarkResult runScenario(BenchmarkScenarioPtr scenario, int repeats);
+	BenchmarkScenarioPtr getScenario(QString name) const;
+	static void print(const BenchmarkResult& result);
+
+	BenchmarkContext mContext;
+	std::vector<BenchmarkScenarioPtr> mScenarios;
+	std::vector<BenchmarkResult> mResults;
+};
+
+} // namespace cx
+
+#endif // CXBENCHMARK_H
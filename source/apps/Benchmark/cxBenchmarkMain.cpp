@@ -0,0 +1,140 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include <algorithm>
+#include <iostream>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDateTime>
+#include "cxBenchmark.h"
+#include "cxBenchmarkScenarios.h"
+#include "cxLogicManager.h"
+#include "cxSessionStorageService.h"
+#include "cxDataLocations.h"
+#include "cxTime.h"
+
+/** Headless benchmark of core pipelines, see cx::Benchmark.
+ *
+ *   cxBenchmark --data <folder> --output result.json
+ *   cxBenchmark --data <folder> --baseline baseline.json
+ *
+ * Exit code is 1 if a scenario regressed compared to the baseline,
+ * 2 if a scenario failed.
+ */
+int main(int argc, char **argv)
+{
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen"); // no display or GPU needed
+
+	QApplication app(argc, argv);
+	app.setApplicationName("cxBenchmark");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless benchmark of CustusX core pipelines.");
+	parser.addHelpOption();
+	QCommandLineOption dataOption("data", "Dataset folder, with the layout of the CustusX test data. Default is the test data folder.", "folder");
+	QCommandLineOption outputOption("output", "Write results as JSON to <file>.", "file");
+	QCommandLineOption baselineOption("baseline", "Compare with results stored in <file>.", "file");
+	QCommandLineOption toleranceOption("tolerance", "Allowed relative increase in time and memory. Default 0.15.", "fraction", "0.15");
+	QCommandLineOption repeatOption("repeat", "Runs per scenario. Default 5.", "count", "5");
+	QCommandLineOption seedOption("seed", "Seed for synthetic input. Default 42.", "seed", "42");
+	QCommandLineOption scenarioOption("scenario", "Run only this scenario. Can be repeated.", "name");
+	QCommandLineOption listOption("list", "List the scenarios.");
+	QCommandLineOption noIsolateOption("no-isolate", "Run all scenarios in this process, instead of one process per scenario.");
+	parser.addOption(dataOption);
+	parser.addOption(outputOption);
+	parser.addOption(baselineOption);
+	parser.addOption(toleranceOption);
+	parser.addOption(repeatOption);
+	parser.addOption(seedOption);
+	parser.addOption(scenarioOption);
+	parser.addOption(listOption);
+	parser.addOption(noIsolateOption);
+	parser.process(app);
+
+	cx::DataLocations::setTestMode(); // keep settings apart from the users settings
+
+	cx::BenchmarkContext context;
+	context.dataFolder = parser.isSet(dataOption) ? parser.value(dataOption) : cx::DataLocations::getTestDataPath();
+	context.seed = parser.value(seedOption).toUInt();
+	context.tempFolder = QString("%1/cxBenchmark_%2").arg(QDir::tempPath()).arg(app.applicationPid());
+	QDir().mkpath(context.tempFolder);
+	int repeats = std::max(1, parser.value(repeatOption).toInt());
+
+	std::vector<cx::BenchmarkScenarioPtr> scenarios = cx::createStandardBenchmarkScenarios();
+	QStringList names = parser.values(scenarioOption);
+	if (names.isEmpty())
+		for (unsigned i=0; i<scenarios.size(); ++i)
+			names << scenarios[i]->getName();
+
+	if (parser.isSet(listOption))
+	{
+		for (unsigned i=0; i<scenarios.size(); ++i)
+			std::cout << scenarios[i]->getName().toStdString() << std::endl;
+		return 0;
+	}
+
+	bool isolated = !parser.isSet(noIsolateOption) && names.size() > 1;
+	if (!isolated)
+	{
+		cx::LogicManager::initialize();
+		context.pluginContext = cx::logicManager()->getPluginContext();
+		cx::logicManager()->getSessionStorageService()->load(context.tempFolder + "/session.cx3");
+	}
+
+	cx::Benchmark benchmark(context);
+	for (unsigned i=0; i<scenarios.size(); ++i)
+		benchmark.addScenario(scenarios[i]);
+
+	if (isolated)
+	{
+		QStringList arguments;
+		arguments << "--data" << context.dataFolder
+				  << "--repeat" << QString::number(repeats)
+				  << "--seed" << QString::number(context.seed);
+		benchmark.runIsolated(names, arguments);
+	}
+	else
+	{
+		benchmark.run(names, repeats);
+		cx::LogicManager::shutdown();
+	}
+
+	std::vector<cx::BenchmarkResult> results = benchmark.getResults();
+	int exitCode = 0;
+	for (unsigned i=0; i<results.size(); ++i)
+		if (results[i].status == "failed")
+			exitCode = 2;
+
+	QString output = parser.value(outputOption);
+	if (output.isEmpty())
+		output = QString("cxBenchmark_%1.json").arg(QDateTime::currentDateTime().toString(cx::timestampSecondsFormat()));
+	if (benchmark.writeResults(output) && !parser.isSet(noIsolateOption))
+		std::cout << "Results written to " << output.toStdString() << std::endl;
+
+	if (parser.isSet(baselineOption))
+	{
+		std::vector<cx::BenchmarkResult> baseline = cx::Benchmark::readResults(parser.value(baselineOption));
+		if (baseline.empty())
+		{
+			std::cout << "No results in baseline " << parser.value(baselineOption).toStdString() << std::endl;
+			exitCode = 2;
+		}
+		else if (!cx::Benchmark::compare(results, baseline, parser.value(toleranceOption).toDouble()))
+		{
+			exitCode = 1;
+		}
+	}
+
+	QDir(context.tempFolder).removeRecursively();
+	return exitCode;
+}
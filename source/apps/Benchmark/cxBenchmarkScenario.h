@@ -0,0 +1,63 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXBENCHMARKSCENARIO_H
+#define CXBENCHMARKSCENARIO_H
+
+#include <QString>
+#include <boost/shared_ptr.hpp>
+
+class ctkPluginContext;
+
+namespace cx
+{
+
+/** Input shared by all benchmark scenarios.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+struct BenchmarkContext
+{
+	BenchmarkContext() : seed(42), pluginContext(NULL) {}
+	QString dataFolder; ///< root of the dataset, same layout as the CustusX test data
+	QString tempFolder; ///< scratch space, removed after the run
+	unsigned seed; ///< seed for all synthetic input
+	ctkPluginContext* pluginContext;
+
+	QString getDataFile(QString relativePath) const { return dataFolder + "/" + relativePath; }
+};
+
+/** One benchmark scenario: a core pipeline run on a fixed input.
+ *
+ * setUp() prepares the input and is not timed. run() is timed, and
+ * returns the amount of work done, in getUnit(), used to compute the
+ * throughput. Scenarios are run several times, so run() must not
+ * change the input.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class BenchmarkScenario
+{
+public:
+	virtual ~BenchmarkScenario() {}
+	virtual QString getName() const = 0;
+	virtual QString getUnit() const = 0; ///< unit of the work done by run(), e.g. "frames"
+
+	virtual QString setUp(const BenchmarkContext& context) = 0; ///< return empty string on success, otherwise the reason for skipping
+	virtual double run() = 0; ///< return work done, negative on failure
+	virtual void tearDown() {}
+};
+typedef boost::shared_ptr<BenchmarkScenario> BenchmarkScenarioPtr;
+
+} // namespace cx
+
+#endif // CXBENCHMARKSCENARIO_H
@@ -0,0 +1,477 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxBenchmarkScenarios.h"
+
+#include <cmath>
+#include <random>
+#include <string.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include "igtlImageMessage.h"
+#include "cxLogger.h"
+#include "cxLogicManager.h"
+#include "cxImage.h"
+#include "cxMesh.h"
+#include "cxProperty.h"
+#include "cxRegistrationTransform.h"
+#include "cxVolumeHelpers.h"
+#include "cxPositionStorageFile.h"
+#include "cxPatientModelService.h"
+#include "cxPatientModelServiceProxy.h"
+#include "cxFileManagerServiceProxy.h"
+#include "cxSessionStorageService.h"
+#include "cxViewService.h"
+#include "cxUsReconstructionServiceProxy.h"
+#include "cxReconstructionExecuter.h"
+#include "cxTemporalCalibration.h"
+#include "cxContourFilter.h"
+#include "SeansVesselReg.hxx"
+#include "cxIGTLinkConversionImage.h"
+#ifdef CX_BENCHMARK_WITH_DICOM
+#include "cxDicomSeriesIndex.h"
+#include "cxDicomConverter.h"
+#endif
+
+namespace cx
+{
+
+namespace
+{
+const QString sweepFile = "testing/US_Acquisition_angio_lab/US-Acq_03_20121024T132330.mhd";
+const QString ctFile = "Phantoms/Kaisa/MetaImage/Kaisa.mhd";
+const QString dicomFolder = "Phantoms/Kaisa/DICOM";
+const QString temporalCalibrationFile = "testing/20110511T092103_temporal_calib_mac.cx3/US_Acq/US-Acq_01_20110511T092317/US-Acq_01_20110511T092317.mhd";
+
+QString checkExists(QString path)
+{
+	if (QFileInfo(path).exists())
+		return "";
+	return "missing " + path;
+}
+}
+
+std::vector<BenchmarkScenarioPtr> createStandardBenchmarkScenarios()
+{
+	std::vector<BenchmarkScenarioPtr> retval;
+	retval.push_back(BenchmarkScenarioPtr(new ReconstructionBenchmark("pnn")));
+	retval.push_back(BenchmarkScenarioPtr(new ReconstructionBenchmark("vnncl")));
+#ifdef CX_BENCHMARK_WITH_DICOM
+	retval.push_back(BenchmarkScenarioPtr(new DicomImportBenchmark()));
+#endif
+	retval.push_back(BenchmarkScenarioPtr(new ContourBenchmark()));
+	retval.push_back(BenchmarkScenarioPtr(new VesselICPBenchmark()));
+	retval.push_back(BenchmarkScenarioPtr(new TemporalCalibrationBenchmark()));
+	retval.push_back(BenchmarkScenarioPtr(new PatientLoadSaveBenchmark()));
+	retval.push_back(BenchmarkScenarioPtr(new IGTLinkDecodeBenchmark()));
+	retval.push_back(BenchmarkScenarioPtr(new TrackingHistoryBenchmark()));
+	return retval;
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString ReconstructionBenchmark::setUp(const BenchmarkContext& context)
+{
+	QString filename = context.getDataFile(sweepFile);
+	QString missing = checkExists(filename);
+	if (!missing.isEmpty())
+		return missing;
+
+	mPatientModelService = PatientModelServiceProxy::create(context.pluginContext);
+	mReconstructer.reset(new UsReconstructionServiceProxy(context.pluginContext));
+	mReconstructer->selectData(filename);
+	mReconstructer->getParam("Algorithm")->setValueFromVariant(mAlgorithm);
+	mReconstructer->getParam("Angio data")->setValueFromVariant(false);
+	mReconstructer->getParam("Dual Angio")->setValueFromVariant(false);
+
+	if (!mReconstructer->createAlgorithm())
+		return QString("algorithm %1 not available").arg(mAlgorithm);
+	return "";
+}
+
+double ReconstructionBenchmark::run()
+{
+	USReconstructInputData fileData = mReconstructer->getSelectedFileData();
+	ReconstructionExecuterPtr executer(new ReconstructionExecuter(mPatientModelService, ViewService::getNullObject()));
+	bool success = executer->startNonThreadedReconstruction(mReconstructer->createAlgorithm(),
+															 mReconstructer->createCoreParameters(),
+															 fileData,
+															 false);
+	if (!success || executer->getResult().empty())
+		return -1;
+	return fileData.mFrames.size();
+}
+
+void ReconstructionBenchmark::tearDown()
+{
+	mReconstructer.reset();
+	mPatientModelService.reset();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString DicomImportBenchmark::setUp(const BenchmarkContext& context)
+{
+	mFolder = context.getDataFile(dicomFolder);
+	mIndexFilename = context.tempFolder + "/dicom_index.bin";
+	return checkExists(mFolder);
+}
+
+double DicomImportBenchmark::run()
+{
+#ifdef CX_BENCHMARK_WITH_DICOM
+	DicomSeriesIndex index(mIndexFilename); // empty index: parse all headers
+	index.scanDirectory(mFolder);
+
+	std::vector<DicomSeriesIndex::Series> series = index.getSeries();
+	unsigned largest = 0;
+	for (unsigned i=0; i<series.size(); ++i)
+		if (series[i].slices.size() > series[largest].slices.size())
+			largest = i;
+	if (series.empty())
+		return -1;
+
+	ImagePtr image = DicomConverter().convertSlicesToImage(series[largest].slices);
+	if (!image)
+		return -1;
+	return series[largest].slices.size();
+#else
+	return -1;
+#endif
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString ContourBenchmark::setUp(const BenchmarkContext& context)
+{
+	QString filename = context.getDataFile(ctFile);
+	QString missing = checkExists(filename);
+	if (!missing.isEmpty())
+		return missing;
+
+	mImage = FileManagerServiceProxy::create(context.pluginContext)->loadVtkImageData(filename);
+	if (!mImage)
+		return "failed to load " + filename;
+
+	double range[2];
+	mImage->GetScalarRange(range);
+	mThreshold = (range[0] + range[1]) / 2;
+	return "";
+}
+
+double ContourBenchmark::run()
+{
+	vtkPolyDataPtr contour = ContourFilter::execute(mImage, mThreshold);
+	if (!contour || !contour->GetNumberOfPoints())
+		return -1;
+	return double(mImage->GetNumberOfPoints()) / 1.0E6;
+}
+
+void ContourBenchmark::tearDown()
+{
+	mImage = vtkImageDataPtr();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+namespace
+{
+/** Sample a random branching tree of vessel centerlines, 0.5 mm between points.
+ */
+void appendVesselBranch(std::vector<Vector3D>* points, std::mt19937& rng, Vector3D start, Vector3D direction, double length, int level)
+{
+	std::uniform_real_distribution<double> uniform(-1, 1);
+	Vector3D p = start;
+	for (double l=0; l<length; l+=0.5)
+	{
+		Vector3D bend(uniform(rng), uniform(rng), uniform(rng));
+		direction = (direction + 0.05*bend).normalized();
+		p += 0.5*direction;
+		points->push_back(p);
+
+		if (level < 4 && uniform(rng) > 0.97)
+		{
+			Vector3D branchDirection = (direction + 0.8*Vector3D(uniform(rng), uniform(rng), uniform(rng))).normalized();
+			appendVesselBranch(points, rng, p, branchDirection, length*0.6, level+1);
+		}
+	}
+}
+
+MeshPtr createVesselMesh(QString uid, const std::vector<Vector3D>& centerline, std::mt19937& rng, double noise, int stride)
+{
+	std::normal_distribution<double> gaussian(0, noise);
+	vtkPointsPtr points = vtkPointsPtr::New();
+	vtkCellArrayPtr verts = vtkCellArrayPtr::New();
+	for (unsigned i=0; i<centerline.size(); i+=stride)
+	{
+		Vector3D p = centerline[i] + Vector3D(gaussian(rng), gaussian(rng), gaussian(rng));
+		vtkIdType id = points->InsertNextPoint(p.data());
+		verts->InsertNextCell(1, &id);
+	}
+	vtkPolyDataPtr poly = vtkPolyDataPtr::New();
+	poly->SetPoints(points);
+	poly->SetVerts(verts);
+	return MeshPtr(new Mesh(uid, uid, poly));
+}
+}
+
+QString VesselICPBenchmark::setUp(const BenchmarkContext& context)
+{
+	std::mt19937 rng(context.seed);
+	std::vector<Vector3D> centerline;
+	appendVesselBranch(&centerline, rng, Vector3D(0,0,0), Vector3D(0,0,1), 150, 0);
+
+	mTarget = createVesselMesh("target", centerline, rng, 0.3, 1);
+	mSource = createVesselMesh("source", centerline, rng, 0.3, 2);
+
+	std::uniform_real_distribution<double> uniform(-1, 1);
+	Transform3D perturbation = createTransformTranslate(5*Vector3D(uniform(rng), uniform(rng), uniform(rng)))
+			* createTransformRotateX(uniform(rng)*5*M_PI/180)
+			* createTransformRotateY(uniform(rng)*5*M_PI/180)
+			* createTransformRotateZ(uniform(rng)*5*M_PI/180);
+	mSource->get_rMd_History()->setRegistration(perturbation);
+
+	mLogFolder = context.tempFolder + "/vessel_icp";
+	QDir().mkpath(mLogFolder);
+	return "";
+}
+
+double VesselICPBenchmark::run()
+{
+	SeansVesselReg registration;
+	registration.mt_doOnlyLinear = true;
+	if (!registration.initialize(mSource, mTarget, mLogFolder))
+		return -1;
+	if (!registration.execute())
+		return -1;
+	return mSource->getVtkPolyData()->GetNumberOfPoints();
+}
+
+void VesselICPBenchmark::tearDown()
+{
+	mSource.reset();
+	mTarget.reset();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString TemporalCalibrationBenchmark::setUp(const BenchmarkContext& context)
+{
+	QString filename = context.getDataFile(temporalCalibrationFile);
+	QString missing = checkExists(filename);
+	if (!missing.isEmpty())
+		return missing;
+
+	mCalibration.reset(new TemporalCalibration());
+	mCalibration->selectData(filename, FileManagerServiceProxy::create(context.pluginContext));
+	return "";
+}
+
+double TemporalCalibrationBenchmark::run()
+{
+	bool success = false;
+	mCalibration->calibrate(&success);
+	return success ? 1 : -1;
+}
+
+void TemporalCalibrationBenchmark::tearDown()
+{
+	mCalibration.reset();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString PatientLoadSaveBenchmark::setUp(const BenchmarkContext& context)
+{
+	QStringList files;
+	files << context.getDataFile(ctFile) << context.getDataFile(sweepFile);
+	for (int i=0; i<files.size(); ++i)
+	{
+		QString missing = checkExists(files[i]);
+		if (!missing.isEmpty())
+			return missing;
+	}
+
+	SessionStorageServicePtr session = logicManager()->getSessionStorageService();
+	mPreviousFolder = session->getRootFolder();
+	mFolder = context.tempFolder + "/patient_benchmark.cx3";
+	QDir(mFolder).removeRecursively();
+	session->load(mFolder);
+
+	PatientModelServicePtr patient = logicManager()->getPatientModelService();
+	for (int i=0; i<files.size(); ++i)
+	{
+		QString info;
+		if (!patient->importData(files[i], info))
+			return "failed to import " + files[i];
+	}
+	session->save();
+	return "";
+}
+
+double PatientLoadSaveBenchmark::run()
+{
+	SessionStorageServicePtr session = logicManager()->getSessionStorageService();
+	session->clear();
+	session->load(mFolder);
+	int count = logicManager()->getPatientModelService()->getDatas().size();
+	if (!count)
+		return -1;
+	session->save();
+	return count;
+}
+
+void PatientLoadSaveBenchmark::tearDown()
+{
+	SessionStorageServicePtr session = logicManager()->getSessionStorageService();
+	session->clear();
+	if (!mPreviousFolder.isEmpty())
+		session->load(mPreviousFolder);
+	QDir(mFolder).removeRecursively();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+QString IGTLinkDecodeBenchmark::setUp(const BenchmarkContext& context)
+{
+	std::mt19937 rng(context.seed);
+	std::uniform_int_distribution<int> uniform(0, 255);
+
+	IGTLinkConversionImage converter;
+	for (int i=0; i<16; ++i)
+	{
+		vtkImageDataPtr raw = generateVtkImageData(Eigen::Array3i(640, 480, 1), Vector3D(0.2, 0.2, 1), 0);
+		unsigned char* ptr = static_cast<unsigned char*>(raw->GetScalarPointer());
+		for (vtkIdType j=0; j<raw->GetNumberOfPoints(); ++j)
+			ptr[j] = uniform(rng);
+
+		ImagePtr image(new Image("benchmark_us", raw));
+		image->setAcquisitionTime(QDateTime::currentDateTime());
+		igtl::ImageMessage::Pointer message = converter.encode(image, pcsLPS);
+		message->Pack();
+		mPackedMessages.push_back(QByteArray(static_cast<const char*>(message->GetPackPointer()), int(message->GetPackSize())));
+	}
+	return "";
+}
+
+/** Unpack as in IGTLinkClientStreamer, then convert.
+ */
+double IGTLinkDecodeBenchmark::run()
+{
+	IGTLinkConversionImage converter;
+	int count = 1000;
+	for (int i=0; i<count; ++i)
+	{
+		const QByteArray& packed = mPackedMessages[i % mPackedMessages.size()];
+
+		igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+		header->InitPack();
+		memcpy(header->GetPackPointer(), packed.constData(), header->GetPackSize());
+		header->Unpack();
+
+		igtl::ImageMessage::Pointer message = igtl::ImageMessage::New();
+		message->SetMessageHeader(header);
+		message->AllocatePack();
+		memcpy(message->GetPackBodyPointer(), packed.constData() + header->GetPackSize(), message->GetPackBodySize());
+		message->Unpack(1);
+
+		if (!converter.decode(message))
+			return -1;
+	}
+	return count;
+}
+
+void IGTLinkDecodeBenchmark::tearDown()
+{
+	mPackedMessages.clear();
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+/** Record 20 minutes of three tools at 60 Hz.
+ */
+QString TrackingHistoryBenchmark::setUp(const BenchmarkContext& context)
+{
+	mSeed = context.seed;
+	mFilename = context.tempFolder + "/tracking_history.snwpos";
+	QFile::remove(mFilename);
+
+	std::mt19937 rng(context.seed);
+	std::normal_distribution<double> step(0, 0.5);
+
+	QStringList tools;
+	tools << "probe" << "pointer" << "reference";
+	std::vector<Vector3D> positions(tools.size(), Vector3D(0,0,0));
+
+	mStartTime = 1.6E12;
+	int samples = 60*60*20;
+	{
+		PositionStorageWriter writer(mFilename);
+		for (int i=0; i<samples; ++i)
+		{
+			for (int t=0; t<tools.size(); ++t)
+			{
+				positions[t] += Vector3D(step(rng), step(rng), step(rng));
+				Transform3D prMt = createTransformTranslate(positions[t]) * createTransformRotateZ(step(rng));
+				writer.write(prMt, uint64_t(mStartTime + i*1000.0/60 + t), tools[t]);
+			}
+		}
+	}
+	mEndTime = mStartTime + samples*1000.0/60;
+	return "";
+}
+
+double TrackingHistoryBenchmark::run()
+{
+	PositionStorageReader reader(mFilename);
+	if (!reader.isIndexed())
+		return -1;
+
+	std::mt19937 rng(mSeed);
+	std::uniform_real_distribution<double> time(mStartTime, mEndTime - 1000);
+	int count = 10000;
+	for (int i=0; i<count; ++i)
+	{
+		double start = time(rng);
+		if (reader.readRange(start, start + 100).empty())
+			return -1;
+	}
+	return count;
+}
+
+void TrackingHistoryBenchmark::tearDown()
+{
+	QFile::remove(mFilename);
+}
+
+} // namespace cx
@@ -0,0 +1,178 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXBENCHMARKSCENARIOS_H
+#define CXBENCHMARKSCENARIOS_H
+
+#include <vector>
+#include <QByteArray>
+#include "cxBenchmarkScenario.h"
+#include "cxForwardDeclarations.h"
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class UsReconstructionService> UsReconstructionServicePtr;
+typedef boost::shared_ptr<class TemporalCalibration> TemporalCalibrationPtr;
+
+/** The standard scenarios, in run order.
+ */
+std::vector<BenchmarkScenarioPtr> createStandardBenchmarkScenarios();
+
+/** Reconstruct a recorded B-mode sweep with the given algorithm.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class ReconstructionBenchmark : public BenchmarkScenario
+{
+public:
+	explicit ReconstructionBenchmark(QString algorithm) : mAlgorithm(algorithm) {}
+	virtual QString getName() const { return "reconstruction_" + mAlgorithm; }
+	virtual QString getUnit() const { return "frames"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	QString mAlgorithm;
+	UsReconstructionServicePtr mReconstructer;
+	PatientModelServicePtr mPatientModelService;
+};
+
+/** Index a DICOM folder from scratch and convert the largest series.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class DicomImportBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "dicom_import"; }
+	virtual QString getUnit() const { return "slices"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+private:
+	QString mFolder;
+	QString mIndexFilename;
+};
+
+/** Extract an iso surface from a CT volume.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class ContourBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "contour"; }
+	virtual QString getUnit() const { return "Mvoxels"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	vtkImageDataPtr mImage;
+	double mThreshold;
+};
+
+/** Linear vessel to vessel ICP between two noisy samplings of a
+ *  synthetic vessel tree, with a known perturbation.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class VesselICPBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "vessel_icp"; }
+	virtual QString getUnit() const { return "points"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	MeshPtr mSource;
+	MeshPtr mTarget;
+	QString mLogFolder;
+};
+
+/** Temporal calibration of a recorded sweep.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class TemporalCalibrationBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "temporal_calibration"; }
+	virtual QString getUnit() const { return "calibrations"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	TemporalCalibrationPtr mCalibration;
+};
+
+/** Save and reload a patient containing a CT volume and a US sweep.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class PatientLoadSaveBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "patient_load_save"; }
+	virtual QString getUnit() const { return "data"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	QString mFolder;
+	QString mPreviousFolder;
+};
+
+/** Unpack and convert OpenIGTLink image messages, as received from a scanner.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class IGTLinkDecodeBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "igtlink_decode"; }
+	virtual QString getUnit() const { return "messages"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	std::vector<QByteArray> mPackedMessages;
+};
+
+/** Random time range queries into a recorded tracking history.
+ *
+ * \ingroup cx
+ * \date Oct 19, 2026
+ */
+class TrackingHistoryBenchmark : public BenchmarkScenario
+{
+public:
+	virtual QString getName() const { return "tracking_history"; }
+	virtual QString getUnit() const { return "queries"; }
+	virtual QString setUp(const BenchmarkContext& context);
+	virtual double run();
+	virtual void tearDown();
+private:
+	QString mFilename;
+	unsigned mSeed;
+	double mStartTime; ///< ms
+	double mEndTime; ///< ms
+};
+
+} // namespace cx
+
+#endif // CXBENCHMARKSCENARIOS_H
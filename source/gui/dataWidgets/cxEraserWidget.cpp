@@ -203,7 +203,7 @@ void EraserWidget::saveSlot()
 
 
 template <class TYPE>
-void EraserWidget::eraseVolume(TYPE* volumePointer)
+IntBoundingBox3D EraserWidget::eraseVolume(TYPE* volumePointer)
 {
 	ImagePtr image = mActiveData->getActive<Image>();
 	vtkImageDataPtr img = image->getBaseVtkImageData();
@@ -237,6 +237,8 @@ void EraserWidget::eraseVolume(TYPE* volumePointer)
 				if ((Vector3D((x-c(0))*spacing[0], (y-c(1))*spacing[1], (z-c(2))*spacing[2])).length() < r)
 					volumePointer[index] = replaceVal;
 			}
+
+	return IntBoundingBox3D(lowVoxIdx(0), highVoxIdx(0)-1, lowVoxIdx(1), highVoxIdx(1)-1, lowVoxIdx(2), highVoxIdx(2)-1);
 }
 
 //#define VTK_VOID            0
@@ -266,20 +268,21 @@ void EraserWidget::removeSlot()
 	vtkImageDataPtr img = image->getBaseVtkImageData();
 	int vtkScalarType = img->GetScalarType();
 
+	IntBoundingBox3D erased;
 	if (vtkScalarType==VTK_CHAR)
-		this->eraseVolume(static_cast<char*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<char*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_UNSIGNED_CHAR)
-		this->eraseVolume(static_cast<unsigned char*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<unsigned char*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_SIGNED_CHAR)
-		this->eraseVolume(static_cast<signed char*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<signed char*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_UNSIGNED_SHORT)
-		this->eraseVolume(static_cast<unsigned short*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<unsigned short*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_SHORT)
-		this->eraseVolume(static_cast<short*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<short*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_UNSIGNED_INT)
-		this->eraseVolume(static_cast<unsigned int*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<unsigned int*> (img->GetScalarPointer()));
 	else if (vtkScalarType==VTK_INT)
-		this->eraseVolume(static_cast<int*> (img->GetScalarPointer()));
+		erased = this->eraseVolume(static_cast<int*> (img->GetScalarPointer()));
 	else
 		reportError(QString("Unknown VTK ScalarType: %1").arg(vtkScalarType));
 
@@ -288,6 +291,7 @@ void EraserWidget::removeSlot()
 
 //	img->Modified();
 	setDeepModified(img);
+	image->updatePyramidRegion(erased);
 	image->setVtkImageData(img);
 
 	// keep existing transfer functions
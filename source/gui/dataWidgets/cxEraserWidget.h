@@ -17,6 +17,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxBaseWidget.h"
 
 #include "cxVector3D.h"
+#include "cxBoundingBox3D.h"
 #include "vtkForwardDeclarations.h"
 #include "cxDoubleProperty.h"
 #include "cxActiveImageProxy.h"
@@ -62,7 +63,7 @@ private:
 
 	void enableButtons();
 	template <class TYPE>
-	void eraseVolume(TYPE* volumePointer);
+	IntBoundingBox3D eraseVolume(TYPE* volumePointer); ///< return the voxel extent that might have changed
 
 	QTimer* mContinousEraseTimer;
 
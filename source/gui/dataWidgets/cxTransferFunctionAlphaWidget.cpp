@@ -14,7 +14,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <limits.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
-#include <vtkImageAccumulate.h>
 #include <QPainter>
 #include <QPen>
 #include <QColor>
@@ -51,8 +50,13 @@ void TransferFunctionAlphaWidget::setData(ImagePtr image, ImageTFDataPtr tfData)
   if (( mImage == image )&&( mImageTF==tfData ))
     return;
 
+  if (mImage)
+	  disconnect(mImage.get(), &Image::statisticsChanged, this, &TransferFunctionAlphaWidget::activeImageTransferFunctionsChangedSlot);
   mImage = image;
   mImageTF = tfData;
+  // the histogram is a sampled estimate until the full statistics are ready
+  if (mImage)
+	  connect(mImage.get(), &Image::statisticsChanged, this, &TransferFunctionAlphaWidget::activeImageTransferFunctionsChangedSlot);
   this->update();
 }
 
@@ -263,20 +267,19 @@ void TransferFunctionAlphaWidget::paintHistogram(QPainter& painter)
 	// Draw histogram
 	// with log compression
 
-	vtkImageAccumulatePtr histogram = mImage->getHistogram();
-	int histogramSize = histogram->GetComponentExtent()[1] -
-						histogram->GetComponentExtent()[0];
+	ImageStatistics::Result statistics = mImage->getStatistics();
+	int histogramSize = mImage->getRange();
 
 	painter.setPen(QColor(140, 140, 210));
 
-	double numElementsInBinWithMostElements = log(histogram->GetOutput()->GetPointData()->GetScalars()->GetRange()[1]+1);
+	double numElementsInBinWithMostElements = log(double(statistics.getMaxCount())+1);
 	double barHeightMult = (this->height() - mBorder*2) / numElementsInBinWithMostElements;
 
 	double posMult = (this->width() - mBorder*2) / double(histogramSize);
 	for (int i = mImage->getMin(); i <= mImage->getMax(); i++)
 	{
 		int x = int(std::lround(((i- mImage->getMin()) * posMult))); //Offset with min value
-		int y = int(std::lround(log(double(static_cast<int*>(histogram->GetOutput()->GetScalarPointer(i - mImage->getMin(), 0, 0))[0]+1)) * barHeightMult));
+		int y = int(std::lround(log(double(statistics.getCount(i))+1) * barHeightMult));
 	  if (y > 0)
 	  {
 		painter.drawLine(x + mBorder, height() - mBorder,
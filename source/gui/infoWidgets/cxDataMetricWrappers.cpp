@@ -58,6 +58,13 @@ QString MetricBase::getValue() const
 	return retval;
 }
 
+QString MetricBase::formatValue(const MetricEvaluator::Result& cached) const
+{
+	if (cached.value.isEmpty())
+		return "NA";
+	return cached.value;
+}
+
 void MetricBase::addColorWidget(QVBoxLayout* layout)
 {
 	mColorSelector = ColorProperty::initialize("color", "Color",
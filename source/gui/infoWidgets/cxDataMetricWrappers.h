@@ -34,6 +34,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFilePathProperty.h"
 #include "cxStringListProperty.h"
 #include "cxSelectDataStringProperty.h"
+#include "cxMetricEvaluator.h"
 
 class QVBoxLayout;
 class QTableWidget;
@@ -58,6 +59,7 @@ public:
 	virtual ~MetricBase() {}
 	virtual QWidget* createWidget() = 0;
 	virtual QString getValue() const;
+	virtual QString formatValue(const MetricEvaluator::Result& cached) const; ///< the value as in getValue(), from a result cached by MetricEvaluator
 	virtual DataMetricPtr getData() const = 0;
 	virtual QString getArguments() const = 0;
 	virtual QString getType() const = 0;
@@ -66,6 +66,11 @@ QString FrameMetricWrapper::getValue() const
 	return prettyFormat(mData->getRefCoord(), 1, 3);
 }
 
+QString FrameMetricWrapper::formatValue(const MetricEvaluator::Result& cached) const
+{
+	return prettyFormat(cached.refCoord, 1, 3);
+}
+
 DataMetricPtr FrameMetricWrapper::getData() const
 {
 	return mData;
@@ -34,6 +34,7 @@ public:
   virtual ~FrameMetricWrapper();
   virtual QWidget* createWidget();
   virtual QString getValue() const;
+  virtual QString formatValue(const MetricEvaluator::Result& cached) const;
   virtual DataMetricPtr getData() const;
   virtual QString getArguments() const;
   virtual QString getType() const;
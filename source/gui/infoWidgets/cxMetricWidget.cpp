@@ -34,6 +34,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTime.h"
 #include "cxMetricManager.h"
 #include "cxMetricUtilities.h"
+#include "cxMetricEvaluator.h"
 #include "cxPatientModelService.h"
 #include "cxVisServices.h"
 
@@ -67,10 +68,14 @@ MetricWidget::MetricWidget(VisServicesPtr services, QWidget* parent) :
 	connect(mMetricManager.get(), SIGNAL(activeMetricChanged()), this, SLOT(setModified()));
 	connect(mMetricManager.get(), SIGNAL(metricsChanged()), this, SLOT(setModified()));
 
+	mEvaluator.reset(new MetricEvaluator());
+	connect(mEvaluator.get(), SIGNAL(changed()), this, SLOT(setModified()));
+
   //table widget
   connect(mTable, SIGNAL(itemSelectionChanged()), this, SLOT(itemSelectionChanged()));
   connect(mTable, SIGNAL(cellChanged(int, int)), this, SLOT(cellChangedSlot(int, int)));
   connect(mTable, SIGNAL(cellClicked(int, int)), this, SLOT(cellClickedSlot(int, int)));
+  connect(mTable->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(setModified()));
 
   this->setLayout(mVerticalLayout);
 
@@ -183,6 +188,7 @@ void MetricWidget::itemSelectionChanged()
 
   mMetricManager->setActiveUid(item->data(Qt::UserRole).toString());
   mEditWidgets->setCurrentIndex(mTable->currentRow());
+  this->updateMetricWrappers();
 
   mMetricManager->setSelection(this->getSelectedUids());
 
@@ -218,7 +224,14 @@ void MetricWidget::prePaintEvent()
   }
 
   this->updateMetricWrappers();
-  this->updateTableContents();
+
+  // after a rebuild all rows are filled, otherwise only visible metrics are reevaluated
+  if (rebuild)
+	  mEvaluator->clearVisibleMetrics();
+  else
+	  mEvaluator->setVisibleMetrics(this->getVisibleUids());
+  mEvaluator->evaluate();
+  this->updateTableContents(rebuild);
 
   if (rebuild)
   {
@@ -264,20 +277,37 @@ void MetricWidget::initializeTable()
 	mTable->blockSignals(false);
 }
 
+/** Only the edit widget currently shown needs to be updated,
+ *  the others are updated when selected.
+ */
 void MetricWidget::updateMetricWrappers()
 {
-	for (unsigned i = 0; i < mMetrics.size(); ++i)
-	{
-		mMetrics[i]->update();
-	}
+	int current = mEditWidgets->currentIndex();
+	if (current >= 0 && current < int(mMetrics.size()))
+		mMetrics[current]->update();
 }
 
-void MetricWidget::updateTableContents()
+/** Rows currently inside the table viewport, plus the active metric.
+ */
+std::set<QString> MetricWidget::getVisibleUids() const
+{
+	std::set<QString> retval;
+	int first = std::max(mTable->rowAt(0), 0);
+	int last = mTable->rowAt(mTable->viewport()->height()-1);
+	if (last < 0)
+		last = int(mMetrics.size())-1;
+
+	for (int i = first; i <= last && i < int(mMetrics.size()); ++i)
+		retval.insert(mMetrics[i]->getData()->getUid());
+	retval.insert(mMetricManager->getActiveUid());
+	return retval;
+}
+
+void MetricWidget::updateTableContents(bool updateAll)
 {
 	mTable->blockSignals(true);
 	// update contents:
-	QTime timer;
-	timer.start();
+	std::set<QString> visible = this->getVisibleUids();
 
 	for (unsigned i = 0; i < mMetrics.size(); ++i)
 	{
@@ -287,23 +317,30 @@ void MetricWidget::updateTableContents()
 			std::cout << "no qitem for:: " << i << " " << current->getData()->getName() << std::endl;
 			continue;
 		}
-		QString name = current->getData()->getName();
-		QString value = current->getValue();
-		QString arguments = current->getArguments();
-		QString type = current->getType();
+		QString uid = current->getData()->getUid();
 
-		mTable->item(i,0)->setText(name);
-		mTable->item(i,1)->setText(value);
-		mTable->item(i,2)->setText(arguments);
-		mTable->item(i,3)->setText(type);
+		if (updateAll || visible.count(uid))
+		{
+			QString name = current->getData()->getName();
+			QString value = current->formatValue(mEvaluator->getResult(uid));
+			QString arguments = current->getArguments();
+			QString type = current->getType();
+
+			mTable->item(i,0)->setText(name);
+			mTable->item(i,1)->setText(value);
+			mTable->item(i,2)->setText(arguments);
+			mTable->item(i,3)->setText(type);
+		}
 
 		//highlight selected row
-		if (current->getData()->getUid() == mMetricManager->getActiveUid())
+		if (uid == mMetricManager->getActiveUid())
 		{
 			mTable->setCurrentCell(i,1);
 			mEditWidgets->setCurrentIndex(i);
 		}
 	}
+	if (mTable->horizontalHeaderItem(1))
+		mTable->horizontalHeaderItem(1)->setToolTip(QString("Evaluating %1 metrics/s").arg(mEvaluator->getMetricsPerSecond(), 0, 'f', 0));
 	mTable->blockSignals(false);
 }
 
@@ -330,17 +367,12 @@ void MetricWidget::resetWrappersAndEditWidgets(std::vector<MetricBasePtr> wrappe
 		mEditWidgets->removeWidget(mEditWidgets->widget(0));
 	}
 
-	for (unsigned i=0; i<mMetrics.size(); ++i)
-	{
-		disconnect(mMetrics[i]->getData().get(), SIGNAL(transformChanged()), this, SLOT(setModified()));
-	}
-
 	mMetrics = wrappers;
 
+	std::vector<DataMetricPtr> metrics;
 	for (unsigned i=0; i<mMetrics.size(); ++i)
-	{
-		connect(mMetrics[i]->getData().get(), SIGNAL(transformChanged()), this, SLOT(setModified()));
-	}
+		metrics.push_back(mMetrics[i]->getData());
+	mEvaluator->setMetrics(metrics);
 
 	for (unsigned i=0; i<mMetrics.size(); ++i)
 	{
@@ -56,6 +56,7 @@ public:
 namespace cx
 {
 typedef boost::shared_ptr<class MetricManager> MetricManagerPtr;
+typedef boost::shared_ptr<class MetricEvaluator> MetricEvaluatorPtr;
 
 
 /**
@@ -116,7 +117,8 @@ private:
   bool checkEqual(const std::vector<MetricBasePtr>& a, const std::vector<MetricBasePtr>& b) const;
   void resetWrappersAndEditWidgets(std::vector<MetricBasePtr> wrappers);
   void initializeTable();
-  void updateTableContents();
+  std::set<QString> getVisibleUids() const;
+  void updateTableContents(bool updateAll);
   void expensizeColumnResize();
   void updateMetricWrappers();
 
@@ -131,6 +133,7 @@ private:
   QAction* mLoadReferencePointsAction; ///< button for loading a reference tools reference points
   QStackedWidget* mEditWidgets;
   MetricManagerPtr mMetricManager;
+  MetricEvaluatorPtr mEvaluator; ///< cached metric values, only dirty and visible metrics are recomputed
   int mModifiedCount;
   int mPaintCount;
   QTimer* mDelayedUpdateTimer;
@@ -39,7 +39,7 @@ SamplerWidget::SamplerWidget(TrackingServicePtr trackingService, PatientModelSer
 
 	mActiveTool = ActiveToolProxy::New(trackingService);
 	connect(mActiveTool.get(), SIGNAL(activeToolChanged(const QString&)), this, SLOT(setModified()));
-	connect(mActiveTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), SLOT(setModified()));
+	connect(mActiveTool.get(), SIGNAL(toolTransformCoalesced(Transform3D, double)), SLOT(setModified()));
 	connect(spaceProvider.get(), &SpaceProvider::spaceAddedOrRemoved, this, &SamplerWidget::spacesChangedSlot);
 
 	mLayout = new QHBoxLayout(this);
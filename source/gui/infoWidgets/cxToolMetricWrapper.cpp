@@ -103,6 +103,11 @@ QString ToolMetricWrapper::getValue() const
 	return prettyFormat(mData->getRefCoord(), 1, 3);
 }
 
+QString ToolMetricWrapper::formatValue(const MetricEvaluator::Result& cached) const
+{
+	return prettyFormat(cached.refCoord, 1, 3);
+}
+
 DataMetricPtr ToolMetricWrapper::getData() const
 {
 	return mData;
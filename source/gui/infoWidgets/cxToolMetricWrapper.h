@@ -33,6 +33,7 @@ public:
   virtual ~ToolMetricWrapper();
   virtual QWidget* createWidget();
   virtual QString getValue() const;
+  virtual QString formatValue(const MetricEvaluator::Result& cached) const;
   virtual DataMetricPtr getData() const;
   virtual QString getArguments() const;
   virtual QString getType() const;
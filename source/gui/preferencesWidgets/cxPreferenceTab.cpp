@@ -92,9 +92,20 @@ void PerformanceTab::init()
 																											"<p>Restart needed.</p>",
 																											stillUpdateRate, DoubleRange(0.0001, 20, 0.0001), 4, QDomNode());
 
+  mOutOfCoreMemoryBudget = DoubleProperty::initialize("OutOfCoreMemoryBudget", "Out-of-core Memory Budget (MB)",
+														"Memory used for the bricks of images kept on disk.",
+														settings()->value("OutOfCore/memoryBudget").toDouble(),
+														DoubleRange(64, 64*1024, 64), 0, QDomNode());
+  mOutOfCoreLoadThreshold = DoubleProperty::initialize("OutOfCoreLoadThreshold", "Out-of-core Load Threshold (MB)",
+														 "<p>Uncompressed images larger than this are kept on disk and "
+														 "read in bricks on demand. 0 loads all images into memory.</p>"
+														 "<p>Applies to images loaded later.</p>",
+														 settings()->value("OutOfCore/loadThreshold").toDouble(),
+														 DoubleRange(0, 1024*1024, 64), 0, QDomNode());
+
   mSmartRenderCheckBox = new QCheckBox("Smart Render");
   mSmartRenderCheckBox->setChecked(settings()->value("smartRender", true).toBool());
-  mSmartRenderCheckBox->setToolTip("Render only when scene has changed, plus once per second.");
+  mSmartRenderCheckBox->setToolTip("Render only views that have changed, and stop rendering when nothing changes.");
 
   m3DVisualizer = StringProperty::initialize("ImageRender3DVisualizer",
 	  "3D Renderer",
@@ -142,6 +153,8 @@ void PerformanceTab::init()
 	mMainLayout->addWidget(mGPU3DDepthPeelingCheckBox, 8, 0);
 	new SpinBoxGroupWidget(this, mStillUpdateRate, mMainLayout, 9);
 	mMainLayout->addWidget(sscCreateDataWidget(this, m3DVisualizer), 10, 0, 1, 2);
+	new SpinBoxGroupWidget(this, mOutOfCoreMemoryBudget, mMainLayout, 11);
+	new SpinBoxGroupWidget(this, mOutOfCoreLoadThreshold, mMainLayout, 12);
 
   mMainLayout->setColumnStretch(0, 2);
   mMainLayout->setColumnStretch(1, 2);
@@ -191,6 +204,8 @@ void PerformanceTab::saveParametersSlot()
   settings()->setValue("stillUpdateRate",   mStillUpdateRate->getValue());
   settings()->setValue("View3D/depthPeeling", mGPU3DDepthPeelingCheckBox->isChecked());
   settings()->setValue("View3D/ImageRender3DVisualizer",   m3DVisualizer->getValue());
+  settings()->setValue("OutOfCore/memoryBudget", mOutOfCoreMemoryBudget->getValue());
+  settings()->setValue("OutOfCore/loadThreshold", mOutOfCoreLoadThreshold->getValue());
 }
 
 } /* namespace cx */
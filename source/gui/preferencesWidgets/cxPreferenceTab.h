@@ -76,6 +76,8 @@ protected:
   QGridLayout* mMainLayout;
   DoublePropertyPtr mMaxRenderSize;
   DoublePropertyPtr mStillUpdateRate;
+  DoublePropertyPtr mOutOfCoreMemoryBudget;
+  DoublePropertyPtr mOutOfCoreLoadThreshold;
   StringPropertyPtr m3DVisualizer;
 
 private slots:
@@ -613,6 +613,7 @@ DebugTab::DebugTab(PatientModelServicePtr patientModelService, TrackingServicePt
 	mIGSTKDebugLoggingCheckBox(NULL),
 	mManualToolPhysicalPropertiesCheckBox(NULL),
 	mRenderSpeedLoggingCheckBox(NULL),
+	mPerformanceTracingCheckBox(NULL),
 	mMainLayout(NULL),
 	mPatientModelService(patientModelService),
 	mTrackingService(trackingService)
@@ -638,6 +639,12 @@ void DebugTab::init()
 	mRenderSpeedLoggingCheckBox->setChecked(settings()->value("renderSpeedLogging", true).toBool());
 	mRenderSpeedLoggingCheckBox->setToolTip("Dump render speed statistics to the console");
 
+	mPerformanceTracingCheckBox = new QCheckBox("Performance Tracing");
+	mPerformanceTracingCheckBox->setChecked(settings()->value("performanceTracing").toBool());
+	mPerformanceTracingCheckBox->setToolTip("Record a timeline of video, tracking, reconstruction, filters and rendering.\n"
+											"The trace is written to the log folder when turned off or on exit,\n"
+											"view it in chrome://tracing or ui.perfetto.dev");
+
 	//Layout
 	mMainLayout = new QGridLayout;
 	int i=0;
@@ -645,6 +652,7 @@ void DebugTab::init()
 	mMainLayout->addWidget(mManualToolPhysicalPropertiesCheckBox, i++, 0);
 	mMainLayout->addWidget(runDebugToolButton, i++, 0);
 	mMainLayout->addWidget(mRenderSpeedLoggingCheckBox, i++, 0);
+	mMainLayout->addWidget(mPerformanceTracingCheckBox, i++, 0);
 
 	mTopLayout->addLayout(mMainLayout);
 }
@@ -671,6 +679,7 @@ void DebugTab::saveParametersSlot()
 	settings()->setValue("IGSTKDebugLogging", mIGSTKDebugLoggingCheckBox->isChecked());
 	settings()->setValue("giveManualToolPhysicalProperties", mManualToolPhysicalPropertiesCheckBox->isChecked());
 	settings()->setValue("renderSpeedLogging", mRenderSpeedLoggingCheckBox->isChecked());
+	settings()->setValue("performanceTracing", mPerformanceTracingCheckBox->isChecked());
 }
 
 }//namespace cx
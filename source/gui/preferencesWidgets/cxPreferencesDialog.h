@@ -265,6 +265,7 @@ protected:
   QCheckBox* mIGSTKDebugLoggingCheckBox;
   QCheckBox* mManualToolPhysicalPropertiesCheckBox;
   QCheckBox* mRenderSpeedLoggingCheckBox;
+  QCheckBox* mPerformanceTracingCheckBox;
   QGridLayout *mMainLayout;
   PatientModelServicePtr mPatientModelService;
   TrackingServicePtr mTrackingService;
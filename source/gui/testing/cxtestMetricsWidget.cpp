@@ -20,6 +20,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxErrorObserver.h"
 #include "cxtestMetricManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxFrameMetricWrapper.h"
+#include "cxMetricEvaluator.h"
 
 namespace cxtest
 {
@@ -60,6 +62,31 @@ TestMetricData readTestMetricData(QString filename) {
 
 }
 
+TEST_CASE("Frame metric value is shown from the cached evaluation", "[unit][metrics][widget]")
+{
+	MetricFixture fixture;
+	cx::FrameMetricPtr frame = fixture.getFrameMetricWithInput().mMetric;
+	cx::FrameMetricWrapper wrapper(cx::VisServicesPtr(), frame);
+
+	std::vector<cx::DataMetricPtr> metrics;
+	metrics.push_back(frame);
+	cx::MetricEvaluator evaluator;
+	evaluator.setMetrics(metrics);
+	evaluator.evaluate();
+
+	// FrameMetric has no string value, the wrapper shows the position
+	QString value = wrapper.formatValue(evaluator.getResult(frame->getUid()));
+	CHECK(value != "NA");
+	CHECK(value == wrapper.getValue());
+
+	frame->setFrame(cx::createTransformTranslate(cx::Vector3D(4,5,6)));
+	evaluator.evaluate();
+	CHECK(wrapper.formatValue(evaluator.getResult(frame->getUid())) == wrapper.getValue());
+	CHECK(wrapper.getValue() != value);
+
+	CHECK_FALSE(fixture.messageListenerContainErrors());
+}
+
 //Fails on Ubuntu 20.04
 TEST_CASE("Export and import metrics to and from file", "[integration][metrics][widget][not_ubuntu2004]")
 {
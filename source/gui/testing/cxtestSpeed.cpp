@@ -37,6 +37,7 @@ void initTest()
 {
 	cx::DataLocations::setTestMode();
 	cx::settings()->setValue("renderingInterval", 4);
+	cx::settings()->setValue("smartRender", false); // measure continuous rendering, a static scene is idle with smart render
 }
 
 void requireVolumeIn3DScene()
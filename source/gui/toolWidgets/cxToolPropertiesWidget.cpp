@@ -247,13 +247,13 @@ void ToolPropertiesWidget::reconnectTools()
 	for (TrackingService::ToolMap::iterator i=mTools.begin(); i!=mTools.end(); ++i)
 	{
 		disconnect(i->second.get(), &Tool::toolVisible, this, &ToolPropertiesWidget::setModified);
-		disconnect(i->second.get(), &Tool::toolTransformAndTimestamp, this, &ToolPropertiesWidget::setModified);
+		disconnect(i->second.get(), &Tool::toolTransformCoalesced, this, &ToolPropertiesWidget::setModified);
 	}
 	mTools = mTrackingService->getTools();
 	for (TrackingService::ToolMap::iterator i=mTools.begin(); i!=mTools.end(); ++i)
 	{
 		connect(i->second.get(), &Tool::toolVisible, this, &ToolPropertiesWidget::setModified);
-		connect(i->second.get(), &Tool::toolTransformAndTimestamp, this, &ToolPropertiesWidget::setModified);
+		connect(i->second.get(), &Tool::toolTransformCoalesced, this, &ToolPropertiesWidget::setModified);
 	}
 }
 
@@ -36,6 +36,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFileManagerServiceProxy.h"
 #include "cxReporter.h"
 #include "cxProfile.h"
+#include "cxTraceController.h"
+#include "cxToolTransformHub.h"
 
 namespace cx
 {
@@ -122,6 +124,7 @@ void LogicManager::basicSetup()
 {
 	ProfileManager::initialize();
 	Reporter::initialize();
+	TraceController::initialize();
 
 	mPluginFramework = PluginFrameworkManager::create();
 	mPluginFramework->start();
@@ -200,6 +203,8 @@ void LogicManager::shutdownServices()
 	this->shutdownLegacyStoredServices();
 	mPluginFramework.reset();
 	GPUImageBufferRepository::shutdown();
+	ToolTransformHub::shutdown();
+	TraceController::shutdown();
 	Reporter::shutdown();
 	ProfileManager::shutdown();
 
@@ -225,6 +230,8 @@ void LogicManager::shutdownServicesLight()
 	this->shutdownLegacyStoredServices();
 
 	GPUImageBufferRepository::shutdown();
+	ToolTransformHub::shutdown();
+	TraceController::shutdown();
 	Reporter::shutdown();
 	ProfileManager::shutdown();
 
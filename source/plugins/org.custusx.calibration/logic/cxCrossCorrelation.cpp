@@ -0,0 +1,166 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxCrossCorrelation.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cx
+{
+
+void correlate(double* x, double* y, double* corr, int maxdelay, int n)
+{
+  int i, j;
+  double mx, my, sx, sy, sxy, denom, r;
+  int delay;
+
+  /* Calculate the mean of the two series x[], y[] */
+  mx = 0;
+  my = 0;
+  for (i = 0; i < n; i++)
+  {
+    mx += x[i];
+    my += y[i];
+  }
+  mx /= n;
+  my /= n;
+
+  /* Calculate the denominator */
+  sx = 0;
+  sy = 0;
+  for (i = 0; i < n; i++)
+  {
+    sx += (x[i] - mx) * (x[i] - mx);
+    sy += (y[i] - my) * (y[i] - my);
+  }
+  denom = sqrt(sx * sy);
+
+  /* Calculate the correlation series */
+  for (delay = -maxdelay; delay < maxdelay; delay++)
+  {
+    sxy = 0;
+    for (i = 0; i < n; i++)
+    {
+      j = i + delay;
+      if (j < 0 || j >= n)
+        continue;
+      else
+        sxy += (x[i] - mx) * (y[j] - my);
+    }
+    r = sxy / denom;
+    corr[delay+maxdelay] = r;//(sxy/denom+1) * 128;
+
+    /* r is the correlation coefficient at "delay" */
+
+  }
+
+}
+
+void fft(std::vector<std::complex<double> >& data, bool inverse)
+{
+	size_t n = data.size();
+
+	// bit reversal permutation
+	for (size_t i=1, j=0; i<n; ++i)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	for (size_t len=2; len<=n; len <<= 1)
+	{
+		double angle = 2*M_PI/len * (inverse ? 1 : -1);
+		std::complex<double> wlen(cos(angle), sin(angle));
+		for (size_t i=0; i<n; i+=len)
+		{
+			std::complex<double> w(1);
+			for (size_t j=0; j<len/2; ++j)
+			{
+				std::complex<double> u = data[i+j];
+				std::complex<double> v = data[i+j+len/2] * w;
+				data[i+j] = u + v;
+				data[i+j+len/2] = u - v;
+				w *= wlen;
+			}
+		}
+	}
+
+	if (inverse)
+		for (size_t i=0; i<n; ++i)
+			data[i] /= double(n);
+}
+
+FFTCrossCorrelator::FFTCrossCorrelator(const std::vector<double>& x, int maxdelay) :
+	mN(x.size()),
+	mMaxDelay(maxdelay),
+	mFFTSize(1),
+	mSumOfSquaresX(0)
+{
+	// pad to at least 2n to avoid circular wrap-around of the correlation
+	while (mFFTSize < 2*mN)
+		mFFTSize <<= 1;
+
+	mX = this->transform(x, &mSumOfSquaresX);
+	for (unsigned i=0; i<mX.size(); ++i)
+		mX[i] = std::conj(mX[i]);
+}
+
+std::vector<FFTCrossCorrelator::ComplexType> FFTCrossCorrelator::transform(const std::vector<double>& series, double* sumOfSquares) const
+{
+	double mean = 0;
+	for (int i=0; i<mN; ++i)
+		mean += series[i];
+	mean /= mN;
+
+	std::vector<ComplexType> retval(mFFTSize, ComplexType(0));
+	*sumOfSquares = 0;
+	for (int i=0; i<mN; ++i)
+	{
+		double val = series[i] - mean;
+		retval[i] = val;
+		*sumOfSquares += val*val;
+	}
+
+	fft(retval, false);
+	return retval;
+}
+
+std::vector<double> FFTCrossCorrelator::correlate(const std::vector<double>& y) const
+{
+	std::vector<double> retval(2*mMaxDelay, 0);
+	if (int(y.size()) != mN || mN == 0)
+		return retval;
+
+	double sumOfSquaresY = 0;
+	std::vector<ComplexType> Y = this->transform(y, &sumOfSquaresY);
+	for (int i=0; i<mFFTSize; ++i)
+		Y[i] *= mX[i];
+	fft(Y, true);
+
+	double denom = sqrt(mSumOfSquaresX * sumOfSquaresY);
+
+	// Y[delay mod size] now contains sum_i x[i]*y[i+delay]
+	for (int delay = -mMaxDelay; delay < mMaxDelay; ++delay)
+	{
+		if (delay <= -mN || delay >= mN)
+			continue;
+		int index = (delay + mFFTSize) % mFFTSize;
+		retval[delay+mMaxDelay] = Y[index].real() / denom;
+	}
+
+	return retval;
+}
+
+} // namespace cx
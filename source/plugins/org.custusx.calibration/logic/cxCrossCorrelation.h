@@ -0,0 +1,82 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXCROSSCORRELATION_H_
+#define CXCROSSCORRELATION_H_
+
+#include "org_custusx_calibration_Export.h"
+
+#include <vector>
+#include <complex>
+
+namespace cx
+{
+/**
+ * \file
+ * \addtogroup org_custusx_calibration
+ * @{
+ */
+
+/**
+ * Normalized time-domain cross correlation.
+ * Found this on
+ * http://paulbourke.net/miscellaneous/correlate/
+ * Slightly modified.
+ *
+ * x: first input series, size n
+ * y: second input series, size n
+ * corr: correlation result, size maxdelay*2 (zero shif is found at corr[maxdelay]
+ *
+ * Complexity is O(n*maxdelay), use FFTCrossCorrelator for long series.
+ */
+org_custusx_calibration_EXPORT void correlate(double* x, double* y, double* corr, int maxdelay, int n);
+
+/**
+ * Normalized cross correlation computed in the frequency domain.
+ *
+ * Gives the same result as correlate(), but in O(n log n).
+ * The reference series x is transformed once in the constructor,
+ * and can then be correlated against any number of series y of
+ * the same length. correlate() is const and can be called
+ * concurrently from several threads.
+ *
+ * \date Oct 19, 2026
+ */
+class org_custusx_calibration_EXPORT FFTCrossCorrelator
+{
+public:
+	FFTCrossCorrelator(const std::vector<double>& x, int maxdelay);
+	/** Correlate y against the reference x.
+	 *  Result has size maxdelay*2, zero shift is found at [maxdelay].
+	 */
+	std::vector<double> correlate(const std::vector<double>& y) const;
+	int getMaxDelay() const { return mMaxDelay; }
+
+private:
+	typedef std::complex<double> ComplexType;
+	std::vector<ComplexType> transform(const std::vector<double>& series, double* sumOfSquares) const;
+
+	int mN;
+	int mMaxDelay;
+	int mFFTSize;
+	std::vector<ComplexType> mX; ///< conjugated transform of the centered reference series
+	double mSumOfSquaresX;
+};
+
+/** In-place iterative radix-2 FFT. data.size() must be a power of two.
+ */
+org_custusx_calibration_EXPORT void fft(std::vector<std::complex<double> >& data, bool inverse);
+
+/**
+ * @}
+ */
+}
+
+#endif /* CXCROSSCORRELATION_H_ */
@@ -29,10 +29,12 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxUsReconstructionFileReader.h"
 #include "cxLogger.h"
 #include "cxTime.h"
-#include <vtkImageMask.h>
 #include "cxFileManagerServiceProxy.h"
+#include "cxCrossCorrelation.h"
+#include <QtConcurrent>
+#include <limits>
+#include <cmath>
 
-typedef vtkSmartPointer<vtkImageMask> vtkImageMaskPtr;
 typedef vtkSmartPointer<vtkImageCorrelation> vtkImageCorrelationPtr;
 
 namespace cx
@@ -42,63 +44,6 @@ typedef unsigned char uchar; // for removing eclipse warnings
 
 
 
-/**
- * Found this on
- * http://paulbourke.net/miscellaneous/correlate/
- * Slightly modified.
- *
- * x: first input series, size n
- * y: second input series, size n
- * corr: correlation result, size maxdelay*2 (zero shif is found at corr[maxdelay]
- */
-void correlate(double* x, double* y, double* corr, int maxdelay, int n)
-{
-  int i, j;
-  double mx, my, sx, sy, sxy, denom, r;
-  int delay;
-
-  /* Calculate the mean of the two series x[], y[] */
-  mx = 0;
-  my = 0;
-  for (i = 0; i < n; i++)
-  {
-    mx += x[i];
-    my += y[i];
-  }
-  mx /= n;
-  my /= n;
-
-  /* Calculate the denominator */
-  sx = 0;
-  sy = 0;
-  for (i = 0; i < n; i++)
-  {
-    sx += (x[i] - mx) * (x[i] - mx);
-    sy += (y[i] - my) * (y[i] - my);
-  }
-  denom = sqrt(sx * sy);
-
-  /* Calculate the correlation series */
-  for (delay = -maxdelay; delay < maxdelay; delay++)
-  {
-    sxy = 0;
-    for (i = 0; i < n; i++)
-    {
-      j = i + delay;
-      if (j < 0 || j >= n)
-        continue;
-      else
-        sxy += (x[i] - mx) * (y[j] - my);
-    }
-    r = sxy / denom;
-    corr[delay+maxdelay] = r;//(sxy/denom+1) * 128;
-
-    /* r is the correlation coefficient at "delay" */
-
-  }
-
-}
-
 TemporalCalibration::TemporalCalibration()
 {
 	mAddRawToDebug = false;
@@ -267,28 +212,45 @@ double TemporalCalibration::findLeastSquares(std::vector<double> frames, std::ve
 /** Find the correlation shift between the regularly spaces series frames and tracking,
  *  with a spacing of resolution.
  *
+ *  The search is coarse-to-fine: The RMS is first evaluated on a sparse grid
+ *  of shifts, then densely around the best coarse hit. The RMS function is
+ *  smooth on the scale of the coarse step for physical probe movement.
+ *
  *  the returned shift is shift frames-tracking: frame = tracking + shift.
  */
 double TemporalCalibration::findLSShift(std::vector<double> frames, std::vector<double> tracking, double resolution) const
 {
 	double maxShift = 1000;
+	double coarseResolution = 20; // ms
 	size_t N = std::min(tracking.size(), frames.size());
   N = std::min<int>(N, 2*maxShift/resolution); // constrain search to 1 second in each direction
-  std::vector<double> result(N, 0);
+  std::vector<double> result(N, std::numeric_limits<double>::quiet_NaN());
   int W = N/2;
+  int step = std::max<int>(1, coarseResolution/resolution);
+
+  int coarseTop = 0;
+  for (int i=-W; i<W; i+=step)
+  {
+  	result[i+W] = this->findLeastSquares(frames, tracking, i);
+  	if (std::isnan(result[coarseTop]) || result[i+W] < result[coarseTop])
+  		coarseTop = i+W;
+  }
 
-  for (int i=-W; i<W; ++i)
+  int top = coarseTop;
+  for (int i=std::max(0, coarseTop-step+1); i<std::min<int>(N, coarseTop+step); ++i)
   {
-  	double rms = this->findLeastSquares(frames, tracking, i);
-  	result[i+W] = rms;
+  	if (std::isnan(result[i]))
+  		result[i] = this->findLeastSquares(frames, tracking, i-W);
+  	if (result[i] < result[top])
+  		top = i;
   }
 
-  int top = std::distance(result.begin(), std::min_element(result.begin(), result.end()));
   double shift = (W-top) * resolution; // convert to shift in ms.
 
   mDebugStream << "=======================================" << std::endl;
   mDebugStream << "tracking vs frames fit using least squares:" << std::endl;
   mDebugStream << "Temporal resolution " << resolution << " ms" << std::endl;
+  mDebugStream << "Coarse search step " << step*resolution << " ms" << std::endl;
   mDebugStream << "Max shift " << maxShift << " ms" << std::endl;
   mDebugStream << "#frames=" << frames.size() << ", #tracks=" << tracking.size() << std::endl;
   mDebugStream << std::endl;
@@ -296,7 +258,7 @@ double TemporalCalibration::findLSShift(std::vector<double> frames, std::vector<
 	for (size_t x = 0; x < std::min<int>(tracking.size(), frames.size()); ++x)
   {
     mDebugStream << frames[x] << "\t" << tracking[x];
-    if (x<N)
+    if (x<N && !std::isnan(result[x]))
     	mDebugStream << "\t" << result[x];
   	mDebugStream << std::endl;
   }
@@ -426,22 +388,38 @@ std::vector<double> TemporalCalibration::computeTrackingMovement()
 
 /** Calculate offset values from the first frame for all frames.
  *
+ *  The correlations against the first frame are independent and run
+ *  in parallel. The peak search is seeded with the previous hit, and
+ *  is therefore done sequentially afterwards.
  */
 std::vector<double> TemporalCalibration::computeProbeMovement()
 {
   int N_frames = mFileData.mUsRaw->getDimensions()[2];
+  int dimY = mFileData.mUsRaw->getDimensions()[1];
 
   std::vector<double> retval;
 
   double maxSingleStep = 5; // assume max 5mm movement per frame
-//	double currentMaxShift;
   double lastVal = 0;
 
 	mMask = mFileData.getMask();
+	int line_index_x = mFileData.mProbeDefinition.mData.getOrigin_p()[0];
+	std::vector<std::vector<double> > lines = this->extractLines_y(line_index_x);
+
+	//result vector allocate space on both sides of zero
+	FFTCrossCorrelator correlator(lines[0], dimY);
+	std::vector<std::vector<double> > correlations(N_frames);
+	std::vector<int> frameIndices(N_frames);
+	for (int i=0; i<N_frames; ++i)
+		frameIndices[i] = i;
+	QtConcurrent::blockingMap(frameIndices, [&](int i)
+	{
+		correlations[i] = correlator.correlate(lines[i]);
+	});
+
   for (int i=0; i<N_frames; ++i)
   {
-    double val = this->findCorrelation(mFileData.mUsRaw, 0, i, maxSingleStep, lastVal);
-//    currentMaxShift =  fabs(val) + maxSingleStep;
+    double val = this->findCorrelationPeak(correlations[i], maxSingleStep, lastVal);
     lastVal = val;
     retval.push_back(val);
   }
@@ -463,25 +441,16 @@ std::vector<double> TemporalCalibration::computeProbeMovement()
   return retval;
 }
 
-double TemporalCalibration::findCorrelation(USFrameDataPtr data, int frame_a, int frame_b, double maxShift, double lastVal)
+/**Find the shift in mm from the correlation between two frames,
+ * by looking for a maximum in the vicinity of the last hit.
+ *
+ */
+double TemporalCalibration::findCorrelationPeak(const std::vector<double>& correlation, double maxShift, double lastVal) const
 {
 	int maxShift_pix = maxShift / mFileData.mUsRaw->getSpacing()[1];
 	int lastVal_pix = lastVal / mFileData.mUsRaw->getSpacing()[1];
 
-	int line_index_x = mFileData.mProbeDefinition.mData.getOrigin_p()[0];
-
-  int dimY = mFileData.mUsRaw->getDimensions()[1];
-
-	vtkImageDataPtr line1 = this->extractLine_y(mFileData.mUsRaw, line_index_x, frame_a);
-	vtkImageDataPtr line2 = this->extractLine_y(mFileData.mUsRaw, line_index_x, frame_b);
-
-  int N = 2*dimY; //result vector allocate space on both sides of zero
-  std::vector<double> result(N, 0);
-  double* line_a = static_cast<double*>(line1->GetScalarPointer());
-  double* line_b = static_cast<double*>(line2->GetScalarPointer());
-  double* line_c = &*result.begin();
-
-  correlate(line_a, line_b, line_c, N/2, dimY);
+  int N = correlation.size();
 
   // use the last found hit as a seed for looking for a local maximum
   int lastTop = N/2 - lastVal_pix;
@@ -490,49 +459,45 @@ double TemporalCalibration::findCorrelation(USFrameDataPtr data, int frame_a, in
   range.second = std::min(N, range.second);
 
   // look for a max in the vicinity of the last hit
-  int top = std::distance(result.begin(), std::max_element(result.begin()+range.first, result.begin()+range.second));
+  int top = std::distance(correlation.begin(), std::max_element(correlation.begin()+range.first, correlation.begin()+range.second));
 
   double hit = (N/2-top) * mFileData.mUsRaw->getSpacing()[1]; // convert to downwards movement in mm.
 
   return hit;
 }
 
-/**extract the y-line with x-index line_index_x from frame ( data[line_index_x, y_varying, frame] )
+/**extract the y-line with x-index line_index_x from all frames ( data[line_index_x, y_varying, frame] ),
+ * with the mask applied.
  *
+ * Only the line itself is read from each frame and mask.
  */
-vtkImageDataPtr TemporalCalibration::extractLine_y(USFrameDataPtr data, int line_index_x, int frame)
+std::vector<std::vector<double> > TemporalCalibration::extractLines_y(int line_index_x) const
 {
-  int dimX = data->getDimensions()[0];
-  int dimY = data->getDimensions()[1];
-
-  vtkImageDataPtr retval = generateVtkImageDataDouble(Eigen::Array3i(dimY, 1, 1), Vector3D(1,1,1), 1);
-
-  vtkImageDataPtr base = mProcessedFrames[frame];
+  int dimX = mFileData.mUsRaw->getDimensions()[0];
+  int dimY = mFileData.mUsRaw->getDimensions()[1];
 
-  // run the base frame through the mask. Result is source.
-  vtkImageMaskPtr maskFilter = vtkImageMaskPtr::New();
-	maskFilter->SetMaskInputData(mMask);
-  maskFilter->SetImageInputData(base);
-  maskFilter->SetMaskedOutputValue(0.0);
-  maskFilter->Update();
-  uchar* source = static_cast<uchar*>(maskFilter->GetOutput()->GetScalarPointer());
+  const uchar* mask = NULL;
+  if (mMask && mMask->GetScalarType()==VTK_UNSIGNED_CHAR)
+  	mask = static_cast<const uchar*>(mMask->GetScalarPointer());
 
-  double* dest = static_cast<double*>(retval->GetScalarPointer());
+  std::vector<std::vector<double> > retval(mProcessedFrames.size(), std::vector<double>(dimY, 0));
 
-  for (int y=0; y<dimY; ++y)
+  for (unsigned frame=0; frame<mProcessedFrames.size(); ++frame)
   {
-    dest[y] = source[y*dimX + line_index_x];
+    const uchar* source = static_cast<const uchar*>(mProcessedFrames[frame]->GetScalarPointer());
+    std::vector<double>& dest = retval[frame];
+
+    for (int y=0; y<dimY; ++y)
+    {
+      int index = y*dimX + line_index_x;
+      if (!mask || mask[index])
+        dest[y] = source[index];
+    }
   }
 
   return retval;
 }
 
-
-
-
-
-
-
 }//namespace cx
 
 
@@ -39,6 +39,11 @@ typedef std::map<double,double> TimeSeriesType;
  * The shift sign is given from:
  *   frames = tracking + shift
  *
+ * The probe movement is found by extracting one scan line from
+ * each frame and correlating it against the first frame. The
+ * correlations are computed in the frequency domain and run
+ * in parallel over the frames.
+ *
  */
 class org_custusx_calibration_EXPORT TemporalCalibration
 {
@@ -49,8 +54,8 @@ public:
   double calibrate(bool* success);
 
 private:
-	vtkImageDataPtr extractLine_y(USFrameDataPtr data, int line_index_x, int frame);
-  double findCorrelation(USFrameDataPtr data, int frame_a, int frame_b, double maxShift, double lastVal);
+  std::vector<std::vector<double> > extractLines_y(int line_index_x) const;
+  double findCorrelationPeak(const std::vector<double>& correlation, double maxShift, double lastVal) const;
   std::vector<double> computeProbeMovement();
   std::vector<double> resample(std::vector<double> shift, std::vector<TimedPosition> time, double resolution);
   std::vector<double> computeTrackingMovement();
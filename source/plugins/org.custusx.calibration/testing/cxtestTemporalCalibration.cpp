@@ -13,6 +13,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxDataLocations.h"
 #include "cxTemporalCalibration.h"
+#include "cxCrossCorrelation.h"
+#include "cxVector3D.h"
+#include <algorithm>
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
 
@@ -36,3 +39,29 @@ TEST_CASE("TemporalCalibration reproduces old results on a test data set", "[uni
 
 
 
+TEST_CASE("FFTCrossCorrelator gives same result as time-domain correlation", "[unit][modules][calibration]")
+{
+	int n = 300;
+	int maxdelay = n;
+	std::vector<double> x(n);
+	std::vector<double> y(n);
+	for (int i=0; i<n; ++i)
+	{
+		x[i] = sin(i*0.1) + 0.1*(i%7);
+		y[i] = sin((i-13)*0.1) + 0.05*(i%5);
+	}
+
+	std::vector<double> expected(2*maxdelay);
+	cx::correlate(&*x.begin(), &*y.begin(), &*expected.begin(), maxdelay, n);
+
+	cx::FFTCrossCorrelator correlator(x, maxdelay);
+	std::vector<double> result = correlator.correlate(y);
+
+	REQUIRE(result.size() == expected.size());
+	for (unsigned i=0; i<result.size(); ++i)
+		CHECK(cx::similar(result[i], expected[i], 1.0E-9));
+
+	int top = std::distance(result.begin(), std::max_element(result.begin(), result.end()));
+	CHECK(top-maxdelay == 13);
+}
+
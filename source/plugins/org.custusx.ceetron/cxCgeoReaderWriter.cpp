@@ -81,7 +81,7 @@ void CgeoReaderWriter::writeToStream(DataPtr data, QDataStream &out)
 		CX_LOG_ERROR() << "Couldn't find mesh.";
 		return;
 	}
-	vtkPolyDataPtr polyData = mesh->getTransformedPolyDataCopy(mesh->get_rMd());
+	vtkPolyDataPtr polyData = mesh->getTransformedPolyData(mesh->get_rMd());
 	vtkCellArrayPtr polys = polyData->GetPolys();
 
 	out.setByteOrder(QDataStream::LittleEndian);
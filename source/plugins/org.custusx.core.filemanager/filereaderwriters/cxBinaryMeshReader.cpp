@@ -0,0 +1,103 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxBinaryMeshReader.h"
+
+#include <QFileInfo>
+#include <vtkPolyData.h>
+#include "cxMesh.h"
+#include "cxMeshIO.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+BinaryMeshReader::BinaryMeshReader(PatientModelServicePtr patientModelService) :
+	FileReaderWriterImplService("BinaryMeshReader", Mesh::getTypeName(), Mesh::getTypeName(), MeshIO::getFileEnding(), patientModelService)
+{
+}
+
+bool BinaryMeshReader::canRead(const QString &type, const QString &filename)
+{
+	QString fileType = QFileInfo(filename).suffix();
+	return (fileType.compare(MeshIO::getFileEnding(), Qt::CaseInsensitive) == 0);
+}
+
+bool BinaryMeshReader::readInto(DataPtr data, QString filename)
+{
+	return this->readInto(boost::dynamic_pointer_cast<Mesh>(data), filename);
+}
+
+bool BinaryMeshReader::readInto(MeshPtr mesh, QString filename)
+{
+	if (!mesh)
+		return false;
+	vtkPolyDataPtr raw = this->loadVtkPolyData(filename);
+	if(!raw)
+		return false;
+	mesh->setVtkPolyData(raw);
+	return true;
+}
+
+QString BinaryMeshReader::canReadDataType() const
+{
+	return Mesh::getTypeName();
+}
+
+vtkPolyDataPtr BinaryMeshReader::loadVtkPolyData(QString fileName)
+{
+	return MeshIO::read(fileName);
+}
+
+DataPtr BinaryMeshReader::read(const QString& uid, const QString& filename)
+{
+	MeshPtr mesh(new Mesh(uid));
+	this->readInto(mesh, filename);
+	return mesh;
+}
+
+std::vector<DataPtr> BinaryMeshReader::read(const QString &filename)
+{
+	std::vector<DataPtr> retval;
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(this->createData(Mesh::getTypeName(), filename));
+
+	vtkPolyDataPtr raw = this->loadVtkPolyData(filename);
+	if(!raw)
+		return retval;
+	mesh->setVtkPolyData(raw);
+
+	retval.push_back(mesh);
+	return retval;
+}
+
+void BinaryMeshReader::write(DataPtr data, const QString &filename)
+{
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(data);
+	if(!mesh)
+	{
+		reportError("Could not cast data to mesh");
+		return;
+	}
+	if (!MeshIO::write(filename, mesh->getVtkPolyData()))
+		reportError("Could not write mesh to " + filename);
+}
+
+QString BinaryMeshReader::canWriteDataType() const
+{
+	return Mesh::getTypeName();
+}
+
+bool BinaryMeshReader::canWrite(const QString &type, const QString &filename) const
+{
+	return this->canWriteInternal(type, filename);
+}
+
+}
@@ -14,7 +14,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QDir>
 #include "cxTypeConversions.h"
 #include <vtkMetaImageReader.h>
-#include <vtkMetaImageWriter.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
 #include "cxErrorObserver.h"
@@ -24,12 +23,41 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxRegistrationTransform.h"
 #include "cxCoreServices.h"
 #include "cxPatientModelService.h"
+#include "cxBrickedVolume.h"
+#include "cxSettings.h"
+#include "cxMetaImageIO.h"
 
 namespace cx {
 
+namespace
+{
+/** Open filename as a volume kept on disk if it is larger than the
+ *  setting OutOfCore/loadThreshold and can be memory mapped.
+ */
+BrickedVolumePtr openOutOfCore(QString filename)
+{
+	double threshold = settings()->value("OutOfCore/loadThreshold").toDouble(); // MB
+	if (threshold <= 0)
+		return BrickedVolumePtr();
+	BrickedVolumePtr volume = BrickedVolume::openMetaImage(filename);
+	if (!volume || volume->getSizeInBytes() < threshold*1024*1024)
+		return BrickedVolumePtr();
+	CX_LOG_INFO() << QString("Keeping %1 (%2 MB) on disk, reading it in bricks.")
+					 .arg(filename).arg(volume->getSizeInBytes()/(1024*1024));
+	return volume;
+}
+} // namespace
+
 vtkImageDataPtr MetaImageReader::loadVtkImageData(QString filename)
 {
-	//load the image from file
+	vtkImageDataPtr image = MetaImageIO::read(filename);
+	if (image)
+	{
+		image->SetOrigin(0, 0, 0);
+		return image;
+	}
+
+	// formats not handled by MetaImageIO, e.g. one file per slice
 	vtkMetaImageReaderPtr reader = vtkMetaImageReaderPtr::New();
 	reader->SetFileName(cstring_cast(filename));
 	reader->ReleaseDataFlagOn();
@@ -77,11 +105,18 @@ bool MetaImageReader::readInto(ImagePtr image, QString filename)
 	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
 	Transform3D rMd = customReader->readTransform();
 
-	vtkImageDataPtr raw = this->loadVtkImageData(filename);
-	if(!raw)
-		return false;
-
-	image->setVtkImageData(raw);
+	BrickedVolumePtr bricked = openOutOfCore(filename);
+	if (bricked)
+	{
+		image->setBrickedVolume(bricked);
+	}
+	else
+	{
+		vtkImageDataPtr raw = this->loadVtkImageData(filename);
+		if(!raw)
+			return false;
+		image->setVtkImageData(raw);
+	}
 //	ImagePtr image(new Image(uid, raw));
 
 	//  RegistrationTransform regTrans(rMd, QFileInfo(filename).lastModified(), "From MHD file");
@@ -120,11 +155,18 @@ std::vector<DataPtr> MetaImageReader::read(const QString &filename)
 	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
 	Transform3D rMd = customReader->readTransform();
 
-	vtkImageDataPtr raw = this->loadVtkImageData(filename);
-	if(!raw)
-		return retval;
-
-	image->setVtkImageData(raw);
+	BrickedVolumePtr bricked = openOutOfCore(filename);
+	if (bricked)
+	{
+		image->setBrickedVolume(bricked);
+	}
+	else
+	{
+		vtkImageDataPtr raw = this->loadVtkImageData(filename);
+		if(!raw)
+			return retval;
+		image->setVtkImageData(raw);
+	}
 //	ImagePtr image(new Image(uid, raw));
 
 	//  RegistrationTransform regTrans(rMd, QFileInfo(filename).lastModified(), "From MHD file");
@@ -157,24 +199,28 @@ void MetaImageReader::write(DataPtr data, const QString& filename)
 		CX_LOG_ERROR() << "MetaImageReader::write: Could not cast data to image";
 		return;
 	}
-	if(!image->getBaseVtkImageData())
+	if (image->isOutOfCore())
 	{
-		CX_LOG_ERROR() << "MetaImageReader::write: cxImage has no VtkImageData";
-		return;
+		// copy from disk instead of loading the volume
+		if (!image->getBrickedVolume()->writeMetaImage(filename))
+		{
+			CX_LOG_ERROR() << "MetaImageReader::write: Failed to write out-of-core image to " << filename;
+			return;
+		}
+	}
+	else
+	{
+		if(!image->getBaseVtkImageData())
+		{
+			CX_LOG_ERROR() << "MetaImageReader::write: cxImage has no VtkImageData";
+			return;
+		}
+		if (!MetaImageIO::write(filename, image->getBaseVtkImageData()))
+		{
+			CX_LOG_ERROR() << "MetaImageReader::write: Failed to write " << filename;
+			return;
+		}
 	}
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
-	writer->SetInputData(image->getBaseVtkImageData());
-	writer->SetFileDimensionality(3);
-	writer->SetFileName(cstring_cast(filename));
-	QDir().mkpath(QFileInfo(filename).path());
-
-//	std::cout << "SAVING MHD COMPRESSED " << filename << std::endl;
-//	writer->SetCompression(true);
-	writer->SetCompression(false);
-//	writer->Update(); // caused writing of (null).0 files - not necessary
-	writer->Write();
-
-	writer = 0;
 
 	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
 	customReader->setTransform(image->get_rMd());
@@ -29,7 +29,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "igtlioUsSectorDefinitions.h"
 
 #include "cxLogger.h"
-#include "cxProbeSector.h"
 #include "cxProbeDefinition.h"
 
 namespace cx
@@ -366,27 +365,23 @@ bool NetworkHandler::convertZeroesInsideSectorToOnes(ImagePtr cximage, int thres
 	if(!mUSMask)
 		return retval;
 
-	Eigen::Array3i maskDims(mUSMask->GetDimensions());
-	unsigned char* maskPtr = static_cast<unsigned char*> (mUSMask->GetScalarPointer());
+	Eigen::Array3i maskDims = mUSMask->getDimensions();
 	unsigned char* imagePtr = static_cast<unsigned char*> (cximage->getBaseVtkImageData()->GetScalarPointer());
 	unsigned components = cximage->getBaseVtkImageData()->GetNumberOfScalarComponents();
-	unsigned dimX = maskDims[0];
-	unsigned dimY = maskDims[1];
-	for (unsigned x = 0; x < dimX; x++)
-		for (unsigned y = 0; y < dimY; y++)
+	unsigned colors = std::min(components, 3u); //Only set RGB components, not Alpha
+	for (int y = 0; y < maskDims[1]; y++)
+		for (const ProbeMask::Span* span = mUSMask->beginRow(y); span != mUSMask->endRow(y); ++span)
 		{
-			unsigned pos = x + y * dimX;
-			unsigned imagePos = pos*components;
-			unsigned char maskVal = maskPtr[pos];
-			unsigned char imageVal = imagePtr[imagePos];
-			if (maskVal != 0 && imageVal <= threshold)
+			unsigned char* pixel = imagePtr + (span->begin + y * maskDims[0]) * components;
+			unsigned char* end = imagePtr + (span->end + y * maskDims[0]) * components;
+			for (; pixel != end; pixel += components)
 			{
-				for(unsigned i=0; i < components; ++i)
-					if(i < 3) //Only set RGB components, not Alpha
-					{
-						imagePtr[imagePos + i] = newValue;
-						retval = true;
-					}
+				if (pixel[0] <= threshold)
+				{
+					for(unsigned i=0; i < colors; ++i)
+						pixel[i] = newValue;
+					retval = retval || (colors > 0);
+				}
 			}
 		}
 	return retval;
@@ -399,10 +394,7 @@ bool NetworkHandler::createMask()
 		CX_LOG_WARNING() << "No ProbeDefinition";
 		return false;
 	}
-	ProbeSector probeSector;
-	probeSector.setData(*mProbeDefinition.get());
-
-	mUSMask = probeSector.getMask();
+	mUSMask = ProbeMask::get(*mProbeDefinition.get());
 	return true;
 }
 
@@ -20,6 +20,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxImage.h"
 #include "cxMesh.h"
 #include "cxProbeDefinitionFromStringMessages.h"
+#include "cxProbeMask.h"
 
 #include "ctkVTKObject.h"
 
@@ -81,7 +82,7 @@ protected:
 
 	ProbeDefinitionPtr mProbeDefinition;
 	bool mZeroesInImage;
-	vtkImageDataPtr mUSMask;
+	ProbeMaskPtr mUSMask;
 	int mSkippedImages;
 };
 
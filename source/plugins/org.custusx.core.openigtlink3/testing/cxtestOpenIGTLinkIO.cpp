@@ -66,7 +66,7 @@ public:
 
 	vtkImageDataPtr getMask()
 	{
-		return mUSMask;
+		return mUSMask ? mUSMask->getImage() : vtkImageDataPtr();
 	}
 	void setProbeDefinition(cx::ProbeDefinitionPtr probeDefinition)
 	{
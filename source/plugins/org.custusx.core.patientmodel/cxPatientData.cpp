@@ -127,12 +127,14 @@ void PatientData::exportPatient(PATIENT_COORDINATE_SYSTEM externalSpace)
 		Transform3D sMr = createTransformFromReferenceToExternal(externalSpace);
 		Transform3D sMd = sMr * rMd;
 
-		vtkPolyDataPtr poly = mesh->getTransformedPolyDataCopy(sMd);
+		vtkPolyDataPtr poly = mesh->getTransformedPolyData(sMd);
 		// create a copy with the SAME UID as the original. Do not load this one into the datamanager!
 		mesh = mDataManager->getDataFactory()->createSpecific<Mesh>(mesh->getUid(), mesh->getName());
 		mesh->setVtkPolyData(poly);
-		mesh->setFilename("Images");
-		mesh->save(targetFolder, mFileManagerService);
+		// exported meshes are read by other tools: always use .vtk
+		QString filename = targetFolder + "/Images/" + mesh->getUid() + ".vtk";
+		mesh->setFilename(QDir(targetFolder).relativeFilePath(filename));
+		mFileManagerService->save(mesh, filename);
 	}
 
 	report("Exported patient data to " + targetFolder + ".");
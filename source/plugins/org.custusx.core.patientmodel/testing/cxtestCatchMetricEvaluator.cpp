@@ -0,0 +1,121 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxMetricEvaluator.h"
+#include "cxtestMetricFixture.h"
+
+TEST_CASE("MetricEvaluator reevaluates only changed metrics and their dependents", "[unit]")
+{
+	cxtest::MetricFixture fixture;
+	cx::PointMetricPtr p0 = fixture.getPointMetricWithInput(cx::Vector3D(0,0,0)).mMetric;
+	cx::PointMetricPtr p1 = fixture.getPointMetricWithInput(cx::Vector3D(2,0,0)).mMetric;
+	cx::PointMetricPtr unrelated = fixture.getPointMetricWithInput(cx::Vector3D(0,0,5)).mMetric;
+	cx::DistanceMetricPtr distance = fixture.getDistanceMetricWithInput(2, p0, p1).mMetric;
+
+	std::vector<cx::DataMetricPtr> metrics;
+	metrics.push_back(p0);
+	metrics.push_back(p1);
+	metrics.push_back(unrelated);
+	metrics.push_back(distance);
+
+	cx::MetricEvaluator evaluator;
+	evaluator.setMetrics(metrics);
+
+	std::set<QString> dependents = evaluator.getDependents(p0->getUid());
+	CHECK(dependents.size()==1);
+	CHECK(dependents.count(distance->getUid()));
+	CHECK(evaluator.getDependents(unrelated->getUid()).empty());
+
+	CHECK(evaluator.evaluate()==4);
+	CHECK(evaluator.evaluate()==0);
+	CHECK(evaluator.getResult(distance->getUid()).value == distance->getValueAsString());
+
+	p0->setCoordinate(cx::Vector3D(-3,0,0));
+	CHECK(evaluator.isDirty(p0->getUid()));
+	CHECK(evaluator.isDirty(distance->getUid()));
+	CHECK_FALSE(evaluator.isDirty(p1->getUid()));
+	CHECK_FALSE(evaluator.isDirty(unrelated->getUid()));
+
+	CHECK(evaluator.evaluate()==2);
+	CHECK(evaluator.getResult(distance->getUid()).value == "5.0 mm");
+	CHECK(evaluator.getTotalEvaluations()==6);
+	CHECK(evaluator.getDependencyRebuilds()==0);
+
+	CHECK_FALSE(fixture.messageListenerContainErrors());
+}
+
+TEST_CASE("MetricEvaluator postpones hidden metrics until they are visible", "[unit]")
+{
+	cxtest::MetricFixture fixture;
+	cx::PointMetricPtr p0 = fixture.getPointMetricWithInput(cx::Vector3D(0,0,0)).mMetric;
+	cx::PointMetricPtr p1 = fixture.getPointMetricWithInput(cx::Vector3D(2,0,0)).mMetric;
+	cx::DistanceMetricPtr distance = fixture.getDistanceMetricWithInput(2, p0, p1).mMetric;
+
+	std::vector<cx::DataMetricPtr> metrics;
+	metrics.push_back(p0);
+	metrics.push_back(p1);
+	metrics.push_back(distance);
+
+	cx::MetricEvaluator evaluator;
+	evaluator.setMetrics(metrics);
+	evaluator.evaluate();
+
+	std::set<QString> visible;
+	visible.insert(p1->getUid());
+	evaluator.setVisibleMetrics(visible);
+
+	p1->setCoordinate(cx::Vector3D(4,0,0));
+	CHECK(evaluator.evaluate()==1);
+	CHECK(evaluator.isDirty(distance->getUid()));
+	CHECK(evaluator.getResult(distance->getUid()).value == "2.0 mm");
+
+	evaluator.clearVisibleMetrics();
+	CHECK(evaluator.evaluate()==1);
+	CHECK(evaluator.getResult(distance->getUid()).value == "4.0 mm");
+
+	CHECK_FALSE(fixture.messageListenerContainErrors());
+}
+
+TEST_CASE("MetricEvaluator rebuilds the graph only when arguments are replaced", "[unit]")
+{
+	cxtest::MetricFixture fixture;
+	cx::PointMetricPtr p0 = fixture.getPointMetricWithInput(cx::Vector3D(0,0,0)).mMetric;
+	cx::PointMetricPtr p1 = fixture.getPointMetricWithInput(cx::Vector3D(2,0,0)).mMetric;
+	cx::PointMetricPtr p2 = fixture.getPointMetricWithInput(cx::Vector3D(0,0,5)).mMetric;
+	cx::DistanceMetricPtr distance = fixture.getDistanceMetricWithInput(2, p0, p1).mMetric;
+
+	std::vector<cx::DataMetricPtr> metrics;
+	metrics.push_back(p0);
+	metrics.push_back(p1);
+	metrics.push_back(p2);
+	metrics.push_back(distance);
+
+	cx::MetricEvaluator evaluator;
+	evaluator.setMetrics(metrics);
+	evaluator.evaluate();
+
+	for (int i=0; i<10; ++i)
+		p1->setCoordinate(cx::Vector3D(i,0,0));
+	CHECK(evaluator.isDirty(distance->getUid()));
+	CHECK(evaluator.getDependencyRebuilds()==0);
+
+	distance->getArguments()->set(1, p2);
+	CHECK(evaluator.getDependencyRebuilds()==1);
+	CHECK(evaluator.getDependents(p2->getUid()).count(distance->getUid()));
+	CHECK(evaluator.getDependents(p1->getUid()).empty());
+
+	evaluator.evaluate();
+	CHECK(evaluator.getResult(distance->getUid()).value == "5.0 mm");
+
+	CHECK_FALSE(fixture.messageListenerContainErrors());
+}
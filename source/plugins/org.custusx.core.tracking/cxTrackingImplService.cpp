@@ -22,6 +22,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QFileInfo>
 #include <vtkDoubleArray.h>
 #include <QCoreApplication>
+#include <limits>
 
 #include "cxRegistrationTransform.h"
 #include "cxLogger.h"
@@ -396,26 +397,27 @@ void TrackingImplService::loadPositionHistory()
 	QString filename = this->getLoggingFolder()+ "/toolpositions.snwpos";
 
 	PositionStorageReader reader(filename);
-
-	Transform3D matrix = Transform3D::Identity();
-	double timestamp;
-	QString toolUid;
+	std::vector<PositionStorageReader::Position> positions
+			= reader.readRange(-std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
 
 	QStringList missingTools;
 
-	while (!reader.atEnd())
+	// positions are sorted by time: appending at the end is constant time
+	ToolPtr current;
+	for (unsigned i=0; i<positions.size(); ++i)
 	{
-		if (!reader.read(&matrix, &timestamp, &toolUid))
-			break;
+		const PositionStorageReader::Position& position = positions[i];
+		if (!current || current->getUid()!=position.toolUid)
+			current = this->getTool(position.toolUid);
 
-		ToolPtr current = this->getTool(toolUid);
 		if (current)
 		{
-			(*current->getPositionHistory())[timestamp] = matrix;
+			TimedTransformMapPtr history = current->getPositionHistory();
+			history->insert(history->end(), std::make_pair(position.timestamp, position.matrix))->second = position.matrix;
 		}
 		else
 		{
-			missingTools << toolUid;
+			missingTools << position.toolUid;
 		}
 	}
 
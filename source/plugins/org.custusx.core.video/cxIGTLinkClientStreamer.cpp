@@ -11,9 +11,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxIGTLinkClientStreamer.h"
 
 #include <QTcpSocket>
+#include <QTimer>
+#include <QHostAddress>
+#include <algorithm>
 #include "igtlOSUtil.h"
 #include "igtlMessageHeader.h"
 #include "igtlTransformMessage.h"
+#include "igtlStringMessage.h"
 #include "igtlPositionMessage.h"
 #include "igtlImageMessage.h"
 #include "igtlClientSocket.h"
@@ -28,7 +32,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxUtilHelpers.h"
 #include "cxTime.h"
 #include "cxSender.h"
+#include "cxSharedMemoryImageFrame.h"
 #include "vtkImageData.h"
+#include "boost/bind.hpp"
 
 namespace cx
 {
@@ -36,7 +42,8 @@ namespace cx
 IGTLinkClientStreamer::IGTLinkClientStreamer() :
 	mHeadingReceived(false),
 	mAddress(""),
-	mPort(0)
+	mPort(0),
+	mUseSharedMemory(true)
 {
 }
 
@@ -51,6 +58,16 @@ void IGTLinkClientStreamer::setAddress(QString address, int port)
 	mPort = port;
 }
 
+void IGTLinkClientStreamer::setUseSharedMemory(bool on)
+{
+	mUseSharedMemory = on;
+}
+
+bool IGTLinkClientStreamer::isLocalHost() const
+{
+	return (mAddress.toLower() == "localhost") || QHostAddress(mAddress).isLoopback();
+}
+
 
 void IGTLinkClientStreamer::startStreaming(SenderPtr sender)
 {
@@ -78,6 +95,29 @@ void IGTLinkClientStreamer::startStreaming(SenderPtr sender)
 
 	// Create a message buffer to receive header
 	mHeaderMsg = igtl::MessageHeader::New();
+
+	mDecoder.reset(new VideoDecodeWorker());
+	mDecoder->start();
+
+	// Ask a local server for the images through shared memory. Images come
+	// through the socket until the server has announced its ring.
+	if (mUseSharedMemory && this->isLocalHost())
+	{
+		mSharedMemory.reset(new SharedMemoryRingReader());
+		mSharedMemoryTimer.reset(new QTimer());
+		mSharedMemoryTimer->setTimerType(Qt::PreciseTimer);
+		connect(mSharedMemoryTimer.get(), SIGNAL(timeout()), this, SLOT(sharedMemoryPollSlot()), Qt::DirectConnection);
+		this->requestSharedMemory();
+	}
+}
+
+void IGTLinkClientStreamer::requestSharedMemory()
+{
+	igtl::StringMessage::Pointer msg = igtl::StringMessage::New();
+	msg->SetDeviceName(SharedMemoryImageFrame::getRequestDeviceName().toStdString().c_str());
+	msg->SetString("1");
+	msg->Pack();
+	mSocket->write(reinterpret_cast<const char*>(msg->GetPackPointer()), msg->GetPackSize());
 }
 
 bool IGTLinkClientStreamer::multipleTryConnectToHost()
@@ -112,6 +152,9 @@ bool IGTLinkClientStreamer::tryConnectToHost()
 
 void IGTLinkClientStreamer::stopStreaming()
 {
+	mSharedMemoryTimer.reset();
+	mSharedMemory.reset();
+	mDecoder.reset(); // stops the thread, the jobs use mSender
 	if (mSocket)
 	{
 		mSocket->disconnectFromHost();
@@ -152,6 +195,34 @@ void IGTLinkClientStreamer::errorSlot(QAbstractSocket::SocketError socketError)
 		   .arg(mSocket->errorString()));
 }
 
+/**Read all new images from the shared memory ring,
+ * attach to it first. Attach attempts back off up to
+ * maxAttachInterval, frames are polled every ms.
+ */
+void IGTLinkClientStreamer::sharedMemoryPollSlot()
+{
+	const int maxAttachInterval = 500;
+	if (!mSharedMemory || mSharedMemoryKey.isEmpty())
+		return;
+	if (!mSharedMemory->isValid())
+	{
+		if (!mSharedMemory->attach(mSharedMemoryKey))
+		{
+			mSharedMemoryTimer->setInterval(std::min(2*mSharedMemoryTimer->interval(), maxAttachInterval));
+			return;
+		}
+		mSharedMemoryTimer->setInterval(1);
+		report(QString("[%1] Receiving images through shared memory").arg(this->hostDescription()));
+	}
+
+	while (const void* data = mSharedMemory->beginRead())
+	{
+		ImagePtr image = SharedMemoryImageFrame::decode(data, mSharedMemory->size());
+		if (mSharedMemory->endRead() && image && mDecoder)
+			mDecoder->push(boost::bind(&IGTLinkClientStreamer::send, this, image, mUnsentUSStatusMessage));
+	}
+}
+
 void IGTLinkClientStreamer::readyReadSlot()
 {
 	// read messages until one fails
@@ -210,6 +281,10 @@ bool IGTLinkClientStreamer::readOneMessage()
 		{
 			success = this->ReceiveSonixStatus(mSocket.get(), mHeaderMsg);
 		}
+		else if (QString(mHeaderMsg->GetDeviceType()) == "STRING")
+		{
+			success = this->ReceiveString(mSocket.get(), mHeaderMsg);
+		}
 //    else if (QString(mHeaderMsg->GetDeviceType() == "STATUS")
 //    {
 //      ReceiveStatus(mSocket, mHeaderMsg);
@@ -229,6 +304,29 @@ bool IGTLinkClientStreamer::readOneMessage()
 	return true;
 }
 
+/** The server announces the key of each new shared memory ring.
+ */
+bool IGTLinkClientStreamer::ReceiveString(QTcpSocket* socket, igtl::MessageHeader::Pointer& header)
+{
+	igtl::StringMessage::Pointer msg = igtl::StringMessage::New();
+	msg->SetMessageHeader(header);
+	msg->AllocatePack();
+
+	if (socket->bytesAvailable() < msg->GetPackBodySize())
+		return false;
+	socket->read(reinterpret_cast<char*>(msg->GetPackBodyPointer()), msg->GetPackBodySize());
+
+	int c = msg->Unpack();
+	bool ok = c & (igtl::MessageHeader::UNPACK_BODY | igtl::MessageHeader::UNPACK_UNDEF);
+	if (ok && mSharedMemory && (QString(msg->GetDeviceName()) == SharedMemoryImageFrame::getKeyDeviceName()))
+	{
+		mSharedMemoryKey = QString(msg->GetString());
+		mSharedMemory->detach();
+		mSharedMemoryTimer->start(1);
+	}
+	return true;
+}
+
 bool IGTLinkClientStreamer::ReceiveSonixStatus(QTcpSocket* socket, igtl::MessageHeader::Pointer& header)
 {
 	IGTLinkUSStatusMessage::Pointer msg;
@@ -297,20 +395,10 @@ bool IGTLinkClientStreamer::ReceiveImage(QTcpSocket* socket, igtl::MessageHeader
 	}
 
 	socket->read(reinterpret_cast<char*>(imgMsg->GetPackBodyPointer()), imgMsg->GetPackBodySize());
-	// Deserialize the transform data
-	// If you want to do a CRC check, call Unpack(1).
-	// If you want to skip CRC check, call Unpack() without argument.
-	int c = imgMsg->Unpack();
-
-//	write_time_info(imgMsg);
 
-	if (c & (igtl::MessageHeader::UNPACK_BODY | igtl::MessageHeader::UNPACK_UNDEF)) // if CRC check is OK or skipped
-	{
-		this->addToQueue(imgMsg);
-		return true;
-	}
-
-	std::cout << "body crc failed!" << std::endl;
+	// unpack and convert in the decoder, blocks if it is behind
+	if (mDecoder)
+		mDecoder->push(boost::bind(&IGTLinkClientStreamer::decodeAndSend, this, imgMsg, mUnsentUSStatusMessage));
 	return true;
 }
 
@@ -320,8 +408,21 @@ void IGTLinkClientStreamer::addToQueue(IGTLinkUSStatusMessage::Pointer msg)
 	mUnsentUSStatusMessage = msg;
 }
 
-void IGTLinkClientStreamer::addToQueue(igtl::ImageMessage::Pointer msg)
+void IGTLinkClientStreamer::decodeAndSend(igtl::ImageMessage::Pointer msg, IGTLinkUSStatusMessage::Pointer status)
 {
+	// Deserialize the image data
+	// If you want to do a CRC check, call Unpack(1).
+	// If you want to skip CRC check, call Unpack() without argument.
+	int c = msg->Unpack();
+
+//	write_time_info(msg);
+
+	if (!(c & (igtl::MessageHeader::UNPACK_BODY | igtl::MessageHeader::UNPACK_UNDEF))) // if CRC check is OK or skipped
+	{
+		std::cout << "body crc failed!" << std::endl;
+		return;
+	}
+
 	IGTLinkConversion converter;
 	IGTLinkConversionImage imageconverter;
     IGTLinkConversionSonixCXLegacy cxconverter;
@@ -338,11 +439,11 @@ void IGTLinkClientStreamer::addToQueue(igtl::ImageMessage::Pointer msg)
     }
 
 	// if us status not sent, do it here
-	if (mUnsentUSStatusMessage)
+	if (status)
 	{
-        package->mProbe = converter.decode(mUnsentUSStatusMessage, msg, ProbeDefinitionPtr());
+        package->mProbe = converter.decode(status, msg, ProbeDefinitionPtr());
 
-        if (cxconverter.guessIsSonixLegacyFormat(mUnsentUSStatusMessage->GetDeviceName()))
+        if (cxconverter.guessIsSonixLegacyFormat(status->GetDeviceName()))
         {
             package->mProbe = cxconverter.decode(package->mProbe);
         }
@@ -351,11 +452,43 @@ void IGTLinkClientStreamer::addToQueue(igtl::ImageMessage::Pointer msg)
 //				mUnsentUSStatusMessage = IGTLinkUSStatusMessage::Pointer();
 	}
 
+	this->sendPackage(package);
+}
+
+void IGTLinkClientStreamer::send(ImagePtr image, IGTLinkUSStatusMessage::Pointer status)
+{
+	IGTLinkConversion converter;
+	IGTLinkConversionSonixCXLegacy cxconverter;
+
+	PackagePtr package(new Package());
+	package->mImage = image;
+
+	// as for IGTLink, but with the image dimensions read from the decoded image
+	if (status)
+	{
+		package->mProbe = converter.decode(status, igtl::ImageMessage::Pointer(), ProbeDefinitionPtr());
+
+		int* dim = image->getBaseVtkImageData()->GetDimensions();
+		double* spacing = image->getBaseVtkImageData()->GetSpacing();
+		package->mProbe->setSpacing(Vector3D(spacing[0], spacing[1], spacing[2]));
+		package->mProbe->setSize(QSize(dim[0], dim[1]));
+		package->mProbe->setClipRect_p(DoubleBoundingBox3D(0, dim[0], 0, dim[1], 0, 0));
+
+		if (cxconverter.guessIsSonixLegacyFormat(status->GetDeviceName()))
+			package->mProbe = cxconverter.decode(package->mProbe);
+	}
+
+	this->sendPackage(package);
+}
+
+void IGTLinkClientStreamer::sendPackage(PackagePtr package)
+{
     //Should only be needed if time stamp is set on another computer that is
     //not synched with the one running this code: e.g. The Ultrasonix scanner
     mStreamSynchronizer.syncToCurrentTime(package->mImage);
 
-	mSender->send(package);
+	if (mSender)
+		mSender->send(package);
 }
 
 
@@ -17,8 +17,12 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxIGTLinkImageMessage.h"
 #include "cxIGTLinkUSStatusMessage.h"
 #include "cxStreamedTimestampSynchronizer.h"
+#include "cxSharedMemoryRing.h"
+#include "cxSender.h"
+#include "cxVideoDecodeWorker.h"
 
 class QTcpSocket;
+class QTimer;
 
 namespace cx
 {
@@ -27,6 +31,15 @@ namespace cx
  * Streamer that listens to an IGTLink connection, then
  * streams the incoming data.
  *
+ * If the server is on the same machine, the client asks for the images
+ * through shared memory, and reads them from the ring the server
+ * announces. Until then, and from servers that do not understand the
+ * request, images arrive through the socket.
+ *
+ * The socket is read in the calling thread, while unpacking, converting
+ * and sending the images is done by a VideoDecodeWorker. When it falls
+ * behind, reading stops until there is room in its queue.
+ *
  * \addtogroup org_custusx_core_video
  * \author Christian Askeland, SINTEF
  * \date 2014-11-20
@@ -40,6 +53,7 @@ public:
 	virtual ~IGTLinkClientStreamer();
 
 	void setAddress(QString address, int port);
+	void setUseSharedMemory(bool on); ///< Read images from shared memory when the server is local (default on)
 
 	virtual void startStreaming(SenderPtr sender);
 	virtual void stopStreaming();
@@ -55,6 +69,7 @@ private slots:
 	void connectedSlot();
 	void disconnectedSlot();
 	void errorSlot(QAbstractSocket::SocketError);
+	void sharedMemoryPollSlot();
 
 private:
 	SenderPtr mSender;
@@ -64,7 +79,12 @@ private:
 	bool ReceiveSonixStatus(QTcpSocket* socket, igtl::MessageHeader::Pointer& header);
 	bool readOneMessage();
 	void addToQueue(IGTLinkUSStatusMessage::Pointer msg);
-	void addToQueue(igtl::ImageMessage::Pointer msg);
+	void decodeAndSend(igtl::ImageMessage::Pointer msg, IGTLinkUSStatusMessage::Pointer status); ///< run by mDecoder
+	void send(ImagePtr image, IGTLinkUSStatusMessage::Pointer status); ///< run by mDecoder
+	void requestSharedMemory();
+	bool ReceiveString(QTcpSocket* socket, igtl::MessageHeader::Pointer& header);
+	void sendPackage(PackagePtr package);
+	bool isLocalHost() const;
 	bool multipleTryConnectToHost();
 	bool tryConnectToHost();
 
@@ -75,6 +95,11 @@ private:
     boost::shared_ptr<QTcpSocket> mSocket;
 	igtl::MessageHeader::Pointer mHeaderMsg;
 	IGTLinkUSStatusMessage::Pointer mUnsentUSStatusMessage; ///< received message, will be added to queue when next image arrives
+	bool mUseSharedMemory;
+	SharedMemoryRingReaderPtr mSharedMemory;
+	QString mSharedMemoryKey; ///< ring announced by the server
+	boost::shared_ptr<QTimer> mSharedMemoryTimer;
+	VideoDecodeWorkerPtr mDecoder;
 
 
 };
@@ -18,6 +18,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDirectlyLinkedSender.h"
 #include "cxLogger.h"
 #include "cxProfile.h"
+#include "cxTracer.h"
 
 namespace cx
 {
@@ -91,6 +92,7 @@ void ImageReceiverThread::addSonixStatusToQueueSlot()
 
 void ImageReceiverThread::addImageToQueue(ImagePtr imgMsg)
 {
+	CX_TRACE_SCOPE("video", "receive image");
 	this->reportFPS(imgMsg->getUid());
 
 //	bool needToCalibrateMsgTimeStamp = this->imageComesFromSonix(imgMsg);
@@ -101,11 +103,22 @@ void ImageReceiverThread::addImageToQueue(ImagePtr imgMsg)
 //	if (needToCalibrateMsgTimeStamp)
 //        mStreamSynchronizer.syncToCurrentTime(imgMsg);
 
-	QMutexLocker sentry(&mImageMutex);
-	mMutexedImageMessageQueue.push_back(imgMsg);
-	sentry.unlock();
+	ImageStreamQueuePtr stream = this->getStream(imgMsg->getUid(), true);
+	if (stream->push(imgMsg))
+		emit imageReceived(imgMsg->getUid()); // emit signal outside lock, catch possibly in another thread
+}
 
-	emit imageReceived(); // emit signal outside lock, catch possibly in another thread
+ImageStreamQueuePtr ImageReceiverThread::getStream(QString streamUid, bool create)
+{
+	QMutexLocker sentry(&mStreamsMutex);
+	std::map<QString, ImageStreamQueuePtr>::iterator iter = mStreams.find(streamUid);
+	if (iter != mStreams.end())
+		return iter->second;
+	if (!create)
+		return ImageStreamQueuePtr();
+	ImageStreamQueuePtr stream(new ImageStreamQueue(streamUid));
+	mStreams[streamUid] = stream;
+	return stream;
 }
 
 void ImageReceiverThread::addSonixStatusToQueue(ProbeDefinitionPtr msg)
@@ -116,15 +129,22 @@ void ImageReceiverThread::addSonixStatusToQueue(ProbeDefinitionPtr msg)
 	emit sonixStatusReceived(); // emit signal outside lock, catch possibly in another thread
 }
 
-ImagePtr ImageReceiverThread::getLastImageMessage()
+std::vector<ImagePtr> ImageReceiverThread::getImageMessages(QString streamUid)
 {
-	QMutexLocker sentry(&mImageMutex);
-	if (mMutexedImageMessageQueue.empty())
-		return ImagePtr();
-	ImagePtr retval = mMutexedImageMessageQueue.front();
-	mMutexedImageMessageQueue.pop_front();
+	ImageStreamQueuePtr stream = this->getStream(streamUid, false);
+	if (!stream)
+		return std::vector<ImagePtr>();
+	return stream->popAll();
+}
 
-	return retval;
+int ImageReceiverThread::getDroppedImageCount(QString streamUid)
+{
+	ImageStreamQueuePtr stream = this->getStream(streamUid, false);
+	if (!stream)
+		return 0;
+	int dropped = stream->popDroppedCount();
+	CX_TRACE_COUNTER("video", "dropped images", dropped);
+	return dropped;
 }
 
 ProbeDefinitionPtr ImageReceiverThread::getLastSonixStatusMessage()
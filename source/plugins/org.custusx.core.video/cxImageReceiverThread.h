@@ -23,6 +23,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QMutex>
 #include <QDateTime>
 #include "cxForwardDeclarations.h"
+#include "cxImageStreamQueue.h"
 
 namespace cx
 {
@@ -43,6 +44,9 @@ typedef boost::shared_ptr<class ImageReceiverThread> ImageReceiverThreadPtr;
 /** \brief Base class for receiving images from a video stream.
  *
  * Subclass to implement for a specific protocol.
+ * Images are queued per stream, see ImageStreamQueue. Streamers may
+ * decode in their own thread (see VideoDecodeWorker), images are then
+ * queued from that thread.
  * Supported messages:
  *  - Image : contains vtkImageData, timestamp, uid, all else is discarded.
  *  - ProbeDefinition : contains sector and image definition, temporal cal is discarded.
@@ -57,7 +61,8 @@ Q_OBJECT
 public:
 	ImageReceiverThread(StreamerServicePtr streamerInterface, QObject* parent = NULL);
 	virtual ~ImageReceiverThread() {}
-	virtual ImagePtr getLastImageMessage(); // threadsafe, Threadsafe retrieval of last image message.
+	virtual std::vector<ImagePtr> getImageMessages(QString streamUid); // threadsafe, retrieve all queued images from one stream, oldest first.
+	virtual int getDroppedImageCount(QString streamUid); // threadsafe, images dropped from a full queue since last call.
 	virtual ProbeDefinitionPtr getLastSonixStatusMessage(); // threadsafe,Threadsafe retrieval of last status message.
 	virtual QString hostDescription() const; // threadsafe
 
@@ -66,7 +71,7 @@ public slots:
 	void shutdown(); // not threadsafe, call via postevent
 
 signals:
-	void imageReceived();
+	void imageReceived(QString streamUid); ///< emitted when the queue for the stream becomes nonempty
 	void sonixStatusReceived();
 	void fps(QString, double);
 	void finished(); // emitted when object has completed shutdown
@@ -90,11 +95,12 @@ private:
 	void reportFPS(QString streamUid);
 //	bool imageComesFromSonix(ImagePtr imgMsg);
 	bool attemptInitialize();
+	ImageStreamQueuePtr getStream(QString streamUid, bool create); // threadsafe
 
 	std::map<QString, cx::CyclicActionLoggerPtr> mFPSTimer;
-	QMutex mImageMutex;
+	QMutex mStreamsMutex; ///< guards mStreams, each stream has its own lock.
+	std::map<QString, ImageStreamQueuePtr> mStreams;
 	QMutex mSonixStatusMutex;
-	std::list<ImagePtr> mMutexedImageMessageQueue;
 	std::list<ProbeDefinitionPtr> mMutexedSonixStatusMessageQueue;
 
 //    StreamedTimestampSynchronizer mStreamSynchronizer;
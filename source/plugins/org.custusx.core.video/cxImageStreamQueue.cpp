@@ -0,0 +1,61 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImageStreamQueue.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+
+namespace cx
+{
+
+ImageStreamQueue::ImageStreamQueue(QString uid, unsigned capacity) :
+	mUid(uid),
+	mCapacity(std::max<unsigned>(capacity, 1)),
+	mDropped(0)
+{
+}
+
+QString ImageStreamQueue::getUid() const
+{
+	return mUid;
+}
+
+bool ImageStreamQueue::push(ImagePtr image)
+{
+	QMutexLocker sentry(&mMutex);
+	bool wasEmpty = mImages.empty();
+	if (mImages.size() >= mCapacity)
+	{
+		mImages.pop_front();
+		++mDropped;
+	}
+	mImages.push_back(image);
+	return wasEmpty;
+}
+
+std::vector<ImagePtr> ImageStreamQueue::popAll()
+{
+	QMutexLocker sentry(&mMutex);
+	std::vector<ImagePtr> retval(mImages.begin(), mImages.end());
+	mImages.clear();
+	return retval;
+}
+
+int ImageStreamQueue::popDroppedCount()
+{
+	QMutexLocker sentry(&mMutex);
+	int retval = mDropped;
+	mDropped = 0;
+	return retval;
+}
+
+} /* namespace cx */
@@ -0,0 +1,71 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGESTREAMQUEUE_H_
+#define CXIMAGESTREAMQUEUE_H_
+
+#include "org_custusx_core_video_Export.h"
+
+#include <deque>
+#include <vector>
+#include "boost/shared_ptr.hpp"
+#include <QMutex>
+#include <QString>
+#include "cxForwardDeclarations.h"
+
+namespace cx
+{
+
+/**
+ * \file
+ * \addtogroup org_custusx_core_video
+ * @{
+ */
+
+typedef boost::shared_ptr<class ImageStreamQueue> ImageStreamQueuePtr;
+
+/** \brief Bounded, thread-safe queue of images from one video stream.
+ *
+ * Each stream has its own queue, so a stream that is consumed slowly
+ * does not delay the others. When the queue is full the oldest image
+ * is dropped: the consumer always gets the newest images, and the
+ * latency stays bounded.
+ *
+ * The producer notifies the consumer only when push() returns true,
+ * i.e. for the first image after the consumer emptied the queue.
+ * Notifications thus never pile up in the consumer's event queue.
+ *
+ * \ingroup org_custusx_core_video
+ * \date Oct 19, 2026
+ */
+class org_custusx_core_video_EXPORT ImageStreamQueue
+{
+public:
+	explicit ImageStreamQueue(QString uid, unsigned capacity = 8);
+	QString getUid() const;
+	bool push(ImagePtr image); ///< threadsafe. Returns true if the queue was empty, i.e. the consumer must be notified.
+	std::vector<ImagePtr> popAll(); ///< threadsafe. All queued images, oldest first.
+	int popDroppedCount(); ///< threadsafe. Number of images dropped since the last call.
+
+private:
+	QString mUid;
+	unsigned mCapacity;
+	QMutex mMutex;
+	std::deque<ImagePtr> mImages;
+	int mDropped;
+};
+
+/**
+ * @}
+ */
+} //end namespace cx
+
+#endif /* CXIMAGESTREAMQUEUE_H_ */
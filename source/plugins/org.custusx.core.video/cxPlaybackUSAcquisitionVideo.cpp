@@ -28,6 +28,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxBasicVideoSource.h"
 #include "cxImage.h"
 #include "cxImageDataContainer.h"
+#include "cxPrefetchingImageDataContainer.h"
+#include "cxLogger.h"
 #include "cxVideoServiceBackend.h"
 #include "cxFileHelpers.h"
 #include <QtConcurrent>
@@ -50,6 +52,7 @@ USAcquisitionVideoPlayback::USAcquisitionVideoPlayback(VideoServiceBackendPtr ba
 
 USAcquisitionVideoPlayback::~USAcquisitionVideoPlayback()
 {
+	this->clearFrameCache();
 }
 
 
@@ -158,6 +161,7 @@ void USAcquisitionVideoPlayback::loadFullData(QString filename)
 		return;
 
 	// clear data
+	this->clearFrameCache();
 	mCurrentData = USReconstructInputData();
 
 	// if no new data, return
@@ -198,9 +202,28 @@ void USAcquisitionVideoPlayback::usDataLoadFinishedSlot()
 	for (unsigned i=0; i<mCurrentData.mFrames.size(); ++i)
 		mCurrentTimestamps.push_back(mCurrentData.mFrames[i].mTime);
 
+	if (mCurrentData.mUsRaw)
+		mFrameCache.reset(new PrefetchingImageDataContainer(mCurrentData.mUsRaw->getImageContainer()));
+
 	this->updateFrame(mCurrentData.mFilename);
 }
 
+void USAcquisitionVideoPlayback::clearFrameCache()
+{
+	if (!mFrameCache)
+		return;
+
+	PrefetchingImageDataContainer::Statistics stats = mFrameCache->getStatistics();
+	CX_LOG_DEBUG() << QString("Playback of %1: %2 frames shown, hit rate %3%, load time mean %4 ms max %5 ms, max wait %6 ms")
+					  .arg(mCurrentData.mFilename)
+					  .arg(stats.hits+stats.misses)
+					  .arg(100*stats.getHitRate(), 0, 'f', 1)
+					  .arg(stats.getMeanLoadTime(), 0, 'f', 1)
+					  .arg(stats.maxLoadTime, 0, 'f', 1)
+					  .arg(stats.maxWaitTime, 0, 'f', 1);
+	mFrameCache.reset();
+}
+
 void  USAcquisitionVideoPlayback::updateFrame(QString filename)
 {
 	if (mUSImageDataReader)
@@ -234,7 +257,7 @@ void  USAcquisitionVideoPlayback::updateFrame(QString filename)
 	int timeout = 1000; // invalidate data if timestamp differ from time too much
 	mVideoSource->overrideTimeout(fabs(timestamp-*iter)>timeout);
 
-	ImagePtr image(new Image(mVideoSourceUid, mCurrentData.mUsRaw->getImageContainer()->get(index)));
+	ImagePtr image(new Image(mVideoSourceUid, mFrameCache->get(index)));
 	image->setAcquisitionTime(QDateTime::fromMSecsSinceEpoch(timestamp));
 
 	mVideoSource->setInfoString(QString("%1 - Frame %2").arg(mCurrentData.mUsRaw->getName()).arg(index));
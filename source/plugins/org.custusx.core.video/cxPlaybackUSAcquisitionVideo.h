@@ -26,6 +26,7 @@ namespace cx
 {
 typedef boost::shared_ptr<class BasicVideoSource> BasicVideoSourcePtr;
 typedef boost::shared_ptr<class VideoServiceBackend> VideoServiceBackendPtr;
+typedef boost::shared_ptr<class PrefetchingImageDataContainer> PrefetchingImageDataContainerPtr;
 
 /**
  * \file
@@ -62,6 +63,7 @@ private slots:
 private:
     void updateFrame(QString filename);
 	void loadFullData(QString filename);
+	void clearFrameCache();
 	QStringList getAbsolutePathToFtsFiles(QString folder);
 	QString mRoot;
     QString mType;
@@ -72,6 +74,7 @@ private:
 
 	USReconstructInputData mCurrentData;
 	std::vector<double> mCurrentTimestamps; // copy of time frame timestamps from mCurrentData.
+	PrefetchingImageDataContainerPtr mFrameCache; // prefetching cache in front of the frames in mCurrentData.
 
 	UsReconstructionFileReaderPtr mUSImageDataReader;
 	QFuture<USReconstructInputData> mUSImageDataFutureResult;
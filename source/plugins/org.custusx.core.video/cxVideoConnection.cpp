@@ -20,6 +20,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxImageReceiverThread.h"
 #include "cxImage.h"
 #include "cxLogger.h"
+#include "cxCyclicActionLogger.h"
 #include <QApplication>
 #include "boost/function.hpp"
 #include "boost/bind.hpp"
@@ -63,7 +64,7 @@ void VideoConnection::waitForClientFinished()
 
 void VideoConnection::fpsSlot(QString source, double fpsNumber)
 {
-	mFPS = fpsNumber;
+	mFPS[source] = fpsNumber;
 	emit fps(source, fpsNumber);
 }
 
@@ -127,11 +128,13 @@ void VideoConnection::runDirectLinkClient(StreamerServicePtr service)
 	mThread->start();
 }
 
-void VideoConnection::imageReceivedSlot()
+void VideoConnection::imageReceivedSlot(QString streamUid)
 {
 	if (!mClient)
 		return;
-	this->updateImage(mClient->getLastImageMessage());
+	std::vector<ImagePtr> images = mClient->getImageMessages(streamUid);
+	for (unsigned i=0; i<images.size(); ++i)
+		this->updateImage(images[i]);
 }
 
 void VideoConnection::statusReceivedSlot()
@@ -187,6 +190,8 @@ void VideoConnection::onDisconnected()
 
 	mSources.clear();
 	mStreamerInterface.reset();
+	mFPS.clear();
+	mLatency.clear();
 
 	emit connected(false);
 	emit videoSourcesChanged();
@@ -294,8 +299,9 @@ void VideoConnection::updateImage(ImagePtr message)
 	// set input.
 	source->setInput(message);
 
-	QString info = mClient->hostDescription() + " - " + QString::number(mFPS, 'f', 1) + " fps";
+	QString info = mClient->hostDescription() + " - " + QString::number(mFPS[source->getUid()], 'f', 1) + " fps";
 	source->setInfoString(info);
+	this->reportLatency(message);
 
 	if (newSource)
 	{
@@ -304,6 +310,40 @@ void VideoConnection::updateImage(ImagePtr message)
 	}
 }
 
+/** Log a histogram of the time from capture to display for each stream,
+ *  along with the number of images dropped by the receiver.
+ */
+void VideoConnection::reportLatency(ImagePtr message)
+{
+	if (!message || !mClient)
+		return;
+
+	int interval = 10000;
+	CyclicActionLoggerPtr& logger = mLatency[message->getUid()];
+	if (!logger)
+	{
+		logger.reset(new CyclicActionLogger(message->getUid()));
+		logger->reset(interval);
+	}
+
+	logger->begin();
+	logger->add("latency", message->getAcquisitionTime().msecsTo(QDateTime::currentDateTime()));
+	if (logger->intervalPassed())
+	{
+		std::vector<double> limits;
+		limits.push_back(10);
+		limits.push_back(20);
+		limits.push_back(50);
+		limits.push_back(100);
+		limits.push_back(200);
+		CX_LOG_DEBUG() << QString("%1, %2 fps, %3 dropped")
+						  .arg(logger->dumpHistogram("latency", limits))
+						  .arg(logger->getFPS())
+						  .arg(mClient->getDroppedImageCount(message->getUid()));
+		logger->reset(interval);
+	}
+}
+
 std::vector<VideoSourcePtr> VideoConnection::getVideoSources()
 {
 	std::vector<VideoSourcePtr> retval;
@@ -44,6 +44,10 @@ typedef boost::shared_ptr<class VideoServiceBackend> VideoServiceBackendPtr;
  * Video Streams are also available directly from this
  * object.
  *
+ * Each stream is received through its own bounded queue in
+ * the receiver thread, see ImageStreamQueue. The latency from
+ * capture to display is logged per stream.
+ *
  * Refactored from old class OpenIGTLinkRTSource.
  *
  *  \ingroup org_custusx_core_video
@@ -71,7 +75,7 @@ signals:
 private slots:
 	void onConnected();
 	void onDisconnected();
-	void imageReceivedSlot();
+	void imageReceivedSlot(QString streamUid);
 	void statusReceivedSlot();
 	void fpsSlot(QString, double fps);
 	void connectVideoToProbe();
@@ -87,11 +91,13 @@ private:
 	void startAllSources();
 	void stopAllSources();
 	void removeSourceFromProbe(ToolPtr tool);
+	void reportLatency(ImagePtr message);
 
 	QPointer<ImageReceiverThread> mClient;
 	QPointer<QThread> mThread;
 
-	double mFPS;
+	std::map<QString, double> mFPS; ///< received fps per stream
+	std::map<QString, CyclicActionLoggerPtr> mLatency; ///< capture to display latency per stream
 	std::vector<ProbeDefinitionPtr> mUnusedProbeDefinitionVector;
 	std::vector<BasicVideoSourcePtr> mSources;
 	VideoServiceBackendPtr mBackend;
@@ -0,0 +1,81 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxVideoDecodeWorker.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+#include "cxTracer.h"
+
+namespace cx
+{
+
+VideoDecodeWorker::VideoDecodeWorker(unsigned capacity) :
+	mCapacity(std::max<unsigned>(capacity, 1)),
+	mStopped(false)
+{
+	this->setObjectName("org.custusx.core.video.decoder");
+}
+
+VideoDecodeWorker::~VideoDecodeWorker()
+{
+	this->stop();
+}
+
+bool VideoDecodeWorker::push(Job job)
+{
+	QMutexLocker sentry(&mMutex);
+	while (!mStopped && mJobs.size() >= mCapacity)
+		mNotFull.wait(&mMutex);
+	if (mStopped)
+		return false;
+	mJobs.push_back(job);
+	mNotEmpty.wakeOne();
+	return true;
+}
+
+void VideoDecodeWorker::stop()
+{
+	QMutexLocker sentry(&mMutex);
+	mStopped = true;
+	mJobs.clear();
+	mNotEmpty.wakeAll();
+	mNotFull.wakeAll();
+	sentry.unlock();
+	this->wait();
+}
+
+int VideoDecodeWorker::getQueueSize() const
+{
+	QMutexLocker sentry(&mMutex);
+	return mJobs.size();
+}
+
+void VideoDecodeWorker::run()
+{
+	while (true)
+	{
+		QMutexLocker sentry(&mMutex);
+		while (!mStopped && mJobs.empty())
+			mNotEmpty.wait(&mMutex);
+		if (mStopped)
+			return;
+		Job job = mJobs.front();
+		mJobs.pop_front();
+		mNotFull.wakeOne();
+		CX_TRACE_COUNTER("video", "decode queue", int(mJobs.size()));
+		sentry.unlock();
+
+		CX_TRACE_SCOPE("video", "decode image");
+		job();
+	}
+}
+
+} /* namespace cx */
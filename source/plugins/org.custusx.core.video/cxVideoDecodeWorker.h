@@ -0,0 +1,75 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXVIDEODECODEWORKER_H_
+#define CXVIDEODECODEWORKER_H_
+
+#include "org_custusx_core_video_Export.h"
+
+#include <deque>
+#include "boost/shared_ptr.hpp"
+#include "boost/function.hpp"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace cx
+{
+
+/**
+ * \file
+ * \addtogroup org_custusx_core_video
+ * @{
+ */
+
+typedef boost::shared_ptr<class VideoDecodeWorker> VideoDecodeWorkerPtr;
+
+/** \brief Thread decoding received video messages.
+ *
+ * The receiver pushes one job per message, and goes on reading the
+ * next while the worker decodes and sends the image. The queue is
+ * bounded: push() blocks while it is full, so a receiver reading
+ * faster than the images can be decoded stops reading its socket,
+ * and the sender is slowed down by the transport instead of the
+ * latency growing.
+ *
+ * \ingroup org_custusx_core_video
+ * \date Oct 19, 2026
+ */
+class org_custusx_core_video_EXPORT VideoDecodeWorker : public QThread
+{
+public:
+	typedef boost::function<void()> Job;
+
+	explicit VideoDecodeWorker(unsigned capacity = 4);
+	virtual ~VideoDecodeWorker(); ///< calls stop()
+
+	bool push(Job job); ///< threadsafe. Blocks while the queue is full, false if stopped.
+	void stop(); ///< finish the running job, discard the queued ones and wait for the thread
+	int getQueueSize() const; ///< threadsafe
+
+protected:
+	virtual void run();
+
+private:
+	unsigned mCapacity;
+	mutable QMutex mMutex;
+	QWaitCondition mNotEmpty;
+	QWaitCondition mNotFull;
+	std::deque<Job> mJobs;
+	bool mStopped;
+};
+
+/**
+ * @}
+ */
+} //end namespace cx
+
+#endif /* CXVIDEODECODEWORKER_H_ */
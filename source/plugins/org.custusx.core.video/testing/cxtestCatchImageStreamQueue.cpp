@@ -0,0 +1,58 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxImageStreamQueue.h"
+#include "cxImage.h"
+
+namespace
+{
+cx::ImagePtr createImage(QString uid)
+{
+	vtkImageDataPtr raw = vtkImageDataPtr::New();
+	raw->SetDimensions(4, 4, 1);
+	raw->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+	return cx::ImagePtr(new cx::Image(uid, raw));
+}
+}
+
+TEST_CASE("ImageStreamQueue: Notify only when the queue becomes nonempty", "[unit][plugins][org.custusx.core.video]")
+{
+	cx::ImageStreamQueue queue("stream", 4);
+	CHECK(queue.getUid() == "stream");
+
+	CHECK(queue.push(createImage("stream")));
+	CHECK_FALSE(queue.push(createImage("stream")));
+	CHECK(queue.popAll().size() == 2);
+	CHECK(queue.popAll().empty());
+
+	CHECK(queue.push(createImage("stream")));
+}
+
+TEST_CASE("ImageStreamQueue: Drop the oldest images when full", "[unit][plugins][org.custusx.core.video]")
+{
+	cx::ImageStreamQueue queue("stream", 3);
+	std::vector<cx::ImagePtr> images;
+	for (int i=0; i<5; ++i)
+	{
+		images.push_back(createImage("stream"));
+		queue.push(images.back());
+	}
+
+	std::vector<cx::ImagePtr> popped = queue.popAll();
+	REQUIRE(popped.size() == 3);
+	CHECK(popped[0] == images[2]);
+	CHECK(popped[2] == images[4]);
+	CHECK(queue.popDroppedCount() == 2);
+	CHECK(queue.popDroppedCount() == 0);
+}
@@ -0,0 +1,140 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <vtkImageData.h>
+
+#include "cxImage.h"
+#include "cxIGTLinkClientStreamer.h"
+#include "cxGrabberSenderQTcpSocket.h"
+#include "cxGrabberSenderSharedMemory.h"
+#include "cxtestSender.h"
+#include "cxtestJenkinsMeasurement.h"
+
+namespace
+{
+
+struct TransportResult
+{
+	TransportResult() : received(0), latency(0), fps(0) {}
+	int received;
+	double latency; ///< mean ms from send to arrival at the client sender
+	double fps;
+};
+
+cx::ImagePtr createUSImage()
+{
+	vtkImageDataPtr raw = vtkImageDataPtr::New();
+	raw->SetDimensions(640, 480, 1);
+	raw->AllocateScalars(VTK_UNSIGNED_CHAR, 4);
+	return cx::ImagePtr(new cx::Image("benchmark", raw, "benchmark"));
+}
+
+bool waitFor(const int& value, int target, int timeout)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (value < target && timer.elapsed() < timeout)
+		qApp->processEvents();
+	return value >= target;
+}
+
+/** Send frames one at a time from a server sender to an IGTLinkClientStreamer
+ *  over loopback, wait for each frame to arrive before sending the next.
+ */
+TransportResult runTransport(bool useSharedMemory, int frames)
+{
+	QTcpServer server;
+	REQUIRE(server.listen(QHostAddress::LocalHost, 0));
+
+	cxtest::TestSenderPtr receiver(new cxtest::TestSender());
+	int received = 0;
+	QObject::connect(receiver.get(), &cxtest::TestSender::newPackage, [&received](){ ++received; });
+
+	cx::IGTLinkClientStreamer client;
+	client.setAddress("127.0.0.1", server.serverPort());
+	client.setUseSharedMemory(useSharedMemory);
+	client.startStreaming(receiver);
+	REQUIRE(server.waitForNewConnection(5000));
+	QTcpSocket* socket = server.nextPendingConnection();
+	REQUIRE(socket);
+
+	cx::SenderPtr sender(new cx::GrabberSenderQTcpSocket(socket));
+	cx::GrabberSenderSharedMemory* sharedMemorySender = NULL;
+	if (useSharedMemory)
+	{
+		sharedMemorySender = new cx::GrabberSenderSharedMemory(socket, server.serverPort());
+		sender.reset(sharedMemorySender);
+	}
+
+	cx::PackagePtr package(new cx::Package());
+	package->mImage = createUSImage();
+
+	// warm up: frames go through the socket until the client has asked for
+	// shared memory, then lets the client attach to the announced ring.
+	for (int i=0; i<10; ++i)
+	{
+		package->mImage->setAcquisitionTime(QDateTime::currentDateTime());
+		sender->send(package);
+		bool arrived = waitFor(received, i+1, 1000);
+		received = i+1;
+		if (arrived && (!sharedMemorySender || !sharedMemorySender->getKey().isEmpty()))
+			break;
+	}
+	if (sharedMemorySender)
+		CHECK(sharedMemorySender->isSharedMemoryRequested());
+	received = 0;
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<frames; ++i)
+	{
+		package->mImage->setAcquisitionTime(QDateTime::currentDateTime());
+		sender->send(package);
+		if (!waitFor(received, i+1, 1000))
+			break;
+	}
+	double elapsed = timer.nsecsElapsed()/1.0E6;
+
+	client.stopStreaming();
+
+	TransportResult retval;
+	retval.received = received;
+	if (received > 0)
+	{
+		retval.latency = elapsed/received;
+		retval.fps = 1000.0/retval.latency;
+	}
+	return retval;
+}
+
+}
+
+TEST_CASE("Speed: Local video transport, IGTLink vs shared memory", "[speed][integration][org.custusx.core.video]")
+{
+	int frames = 200;
+	TransportResult tcp = runTransport(false, frames);
+	TransportResult shm = runTransport(true, frames);
+
+	CHECK(tcp.received == frames);
+	CHECK(shm.received == frames);
+
+	cxtest::JenkinsMeasurement jenkins;
+	jenkins.createOutput("IGTLink_latency_ms", QString::number(tcp.latency));
+	jenkins.createOutput("IGTLink_fps", QString::number(tcp.fps));
+	jenkins.createOutput("SharedMemory_latency_ms", QString::number(shm.latency));
+	jenkins.createOutput("SharedMemory_fps", QString::number(shm.fps));
+}
@@ -0,0 +1,63 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QAtomicInt>
+#include <QSemaphore>
+#include "cxVideoDecodeWorker.h"
+
+namespace
+{
+class Producer : public QThread
+{
+public:
+	Producer(cx::VideoDecodeWorker* worker, cx::VideoDecodeWorker::Job job) : mWorker(worker), mJob(job), pushed(0) {}
+	virtual void run() { pushed = mWorker->push(mJob) ? 1 : 0; }
+	cx::VideoDecodeWorker* mWorker;
+	cx::VideoDecodeWorker::Job mJob;
+	QAtomicInt pushed;
+};
+}
+
+TEST_CASE("VideoDecodeWorker: Runs jobs in order and blocks when full", "[unit][plugins][org.custusx.core.video]")
+{
+	cx::VideoDecodeWorker worker(2);
+	worker.start();
+
+	QSemaphore release;
+	QSemaphore started;
+	std::vector<int> order;
+	REQUIRE(worker.push([&]() { started.release(); release.acquire(); order.push_back(0); }));
+	started.acquire(); // the first job is running, the queue is empty
+
+	REQUIRE(worker.push([&]() { order.push_back(1); }));
+	REQUIRE(worker.push([&]() { order.push_back(2); }));
+	CHECK(worker.getQueueSize() == 2);
+
+	// the queue is full: the producer waits until the worker takes the next job
+	Producer producer(&worker, [&]() { order.push_back(3); });
+	producer.start();
+	CHECK(!producer.wait(50));
+	CHECK(int(producer.pushed) == 0);
+
+	release.release();
+	REQUIRE(producer.wait(5000));
+	CHECK(int(producer.pushed) == 1);
+
+	while (worker.getQueueSize() > 0)
+		QThread::msleep(1);
+	worker.stop();
+	REQUIRE(order.size() == 4);
+	for (int i=0; i<4; ++i)
+		CHECK(order[i] == i);
+	CHECK(!worker.push([]() {}));
+}
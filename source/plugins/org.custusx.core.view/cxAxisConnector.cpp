@@ -50,7 +50,7 @@ void AxisConnector::connectTo(ToolPtr tool)
 
 void AxisConnector::changedSlot()
 {
-	Transform3D  rMs = mSpaceProvider->get_toMfrom(mListener->getSpace(), CoordinateSystem(csREF));
+	Transform3D  rMs = mListener->get_rMs();
 	mRep->setTransform(rMs);
 
 	mRep->setVisible(true);
@@ -62,7 +62,7 @@ void AxisConnector::changedSlot()
 	// Dont show if equal to base
 	if (mBase)
 	{
-		Transform3D rMb = mSpaceProvider->get_toMfrom(mBase->getSpace(), CoordinateSystem(csREF));
+		Transform3D rMb = mBase->get_rMs();
 		if (similar(rMb, rMs))
 			mRep->setVisible(false);
 	}
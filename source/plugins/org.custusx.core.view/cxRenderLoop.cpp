@@ -10,54 +10,90 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 #include "cxRenderLoop.h"
 
-#include "cxCyclicActionLogger.h"
+#include <algorithm>
+#include <cmath>
 #include <QTimer>
+#include <QStringList>
+#include <QEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include "cxCyclicActionLogger.h"
 #include "cxView.h"
 #include "vtkRenderWindow.h"
 #include "cxTypeConversions.h"
 #include "cxLogger.h"
 #include "cxViewCollectionWidget.h"
+#include "cxToolTransformHub.h"
+#include "cxToolRep3D.h"
+#include "cxTracer.h"
 
 
 namespace cx
 {
 
+namespace
+{
+const int settleInterval = 1000; ///< ms from the last rendered frame to the final check
+const int viewRenderLoggerInterval = 10000;
+}
+
 RenderLoop::RenderLoop() :
 	QObject(NULL),
 	mTimer(NULL),
+	mLastFrameStart(0),
+	mRunning(false),
+	mSettleCheck(false),
 	mSmartRender(false),
-	mLogging(false),
-	mBaseRenderInterval(40)
+	mBaseRenderInterval(40),
+	mLogging(false)
 {
-	mLastFullRender = QDateTime::currentDateTime();
+	mClock.start();
 	mCyclicLogger.reset(new CyclicActionLogger("Main Render timer"));
+	mViewRenderLogger.reset(new CyclicActionLogger("View render time"));
+	mViewRenderLogger->reset(viewRenderLoggerInterval);
 
 	mTimer = new QTimer(this);
+	mTimer->setSingleShot(true);
+	mTimer->setTimerType(Qt::PreciseTimer);
 	connect(mTimer, SIGNAL(timeout()), this, SLOT(timeoutSlot()));
 
-	this->sendRenderIntervalToTimer(mBaseRenderInterval);
+	// catch effects the change notifications miss
+	mSettleTimer = new QTimer(this);
+	mSettleTimer->setSingleShot(true);
+	mSettleTimer->setInterval(settleInterval);
+	connect(mSettleTimer, SIGNAL(timeout()), this, SLOT(settleSlot()));
+
+	// every tool reports to the hub, see Tool::Tool()
+	connect(ToolTransformHub::getInstance(), &ToolTransformHub::transformsPending, this, &RenderLoop::toolsMovedSlot);
 }
 
 void RenderLoop::start()
 {
-	mTimer->start();
+	mRunning = true;
+	for (unsigned i=0; i<mLayoutWidgets.size(); ++i)
+		this->watchInput(mLayoutWidgets[i]);
+	this->requestFullRender();
 }
 
 void RenderLoop::stop()
 {
+	mRunning = false;
+	this->unwatchInput();
 	mTimer->stop();
+	mSettleTimer->stop();
 	emit fps(0);
 }
 
 bool RenderLoop::isRunning() const
 {
-	return mTimer->isActive();
+	return mRunning;
 }
 
 void RenderLoop::setRenderingInterval(int interval)
 {
+	if (interval <= 0)
+		interval = 30;
 	mBaseRenderInterval = interval;
-	this->sendRenderIntervalToTimer(mBaseRenderInterval);
 }
 
 void RenderLoop::setLogging(bool on)
@@ -68,81 +104,352 @@ void RenderLoop::setLogging(bool on)
 void RenderLoop::setSmartRender(bool val)
 {
 	mSmartRender = val;
+	this->requestRender();
 }
 
-void RenderLoop::sendRenderIntervalToTimer(int interval)
+void RenderLoop::setActiveTool(ToolPtr tool)
 {
-	if (interval==mTimer->interval())
-		return;
-	if (interval == 0)
-		interval = 30;
-
-	bool active = this->isRunning();
-	if (active)
-		mTimer->stop();
-	mTimer->setInterval(interval);
-	if (active)
-		mTimer->start();
+	mActiveTool = tool;
 }
 
 void RenderLoop::addLayout(ViewCollectionWidget* layout)
 {
 	mLayoutWidgets.push_back(layout);
+	if (mRunning)
+		this->watchInput(layout);
+	this->requestFullRender();
 }
 
-
 void RenderLoop::clearViews()
 {
+	this->unwatchInput();
 	mLayoutWidgets.clear();
+	this->updateViewStates();
+}
+
+/** User input in the view widgets might change the view, e.g. through
+ *  the camera. The widgets of a layout can change with the views, so
+ *  this is repeated when new views appear.
+ */
+void RenderLoop::watchInput(ViewCollectionWidget* layout)
+{
+	if (!layout)
+		return;
+	QList<QWidget*> widgets = layout->findChildren<QWidget*>();
+	widgets.push_front(layout);
+	for (int i=0; i<widgets.size(); ++i)
+	{
+		if (std::find(mInputWidgets.begin(), mInputWidgets.end(), widgets[i]) != mInputWidgets.end())
+			continue;
+		widgets[i]->installEventFilter(this);
+		mInputWidgets.push_back(widgets[i]);
+	}
+}
+
+void RenderLoop::unwatchInput()
+{
+	for (unsigned i=0; i<mInputWidgets.size(); ++i)
+	{
+		if (mInputWidgets[i])
+			mInputWidgets[i]->removeEventFilter(this);
+	}
+	mInputWidgets.clear();
+}
+
+void RenderLoop::requestRender()
+{
+	this->updateViewStates();
+	this->markAllViewsDirty();
+	this->scheduleNextFrame();
+}
+
+void RenderLoop::requestFullRender()
+{
+	for (unsigned i=0; i<mLayoutWidgets.size(); ++i)
+	{
+		if (mLayoutWidgets[i])
+			mLayoutWidgets[i]->setModified();
+	}
+	this->requestRender();
+}
+
+bool RenderLoop::eventFilter(QObject* watched, QEvent* event)
+{
+	switch (event->type())
+	{
+	case QEvent::MouseButtonPress:
+	case QEvent::MouseButtonRelease:
+	case QEvent::MouseMove:
+	case QEvent::Wheel:
+	case QEvent::KeyPress:
+	case QEvent::KeyRelease:
+		if (mSmartRender)
+			this->markInputTargetDirty(watched, event);
+		break;
+	default:
+		break;
+	}
+	return QObject::eventFilter(watched, event);
+}
+
+/** Mark the view under the mouse dirty, or all views in the
+ *  layout for key events.
+ */
+void RenderLoop::markInputTargetDirty(QObject* watched, QEvent* event)
+{
+	QWidget* widget = qobject_cast<QWidget*>(watched);
+	if (!widget)
+		return;
+
+	QPoint pos;
+	bool hasPos = false;
+	if (event->type()==QEvent::Wheel)
+	{
+		pos = static_cast<QWheelEvent*>(event)->pos();
+		hasPos = true;
+	}
+	else if (event->type()!=QEvent::KeyPress && event->type()!=QEvent::KeyRelease)
+	{
+		pos = static_cast<QMouseEvent*>(event)->pos();
+		hasPos = true;
+	}
+
+	this->updateViewStates();
+	bool found = false;
+	for (ViewStateMap::iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+	{
+		ViewState& state = iter->second;
+		if (!state.layout || (widget!=state.layout && !state.layout->isAncestorOf(widget)))
+			continue;
+		if (hasPos)
+		{
+			QPoint pos_layout = widget->mapTo(state.layout, pos);
+			QRect rect(state.layout->getPosition(state.view), state.view->size());
+			if (!rect.contains(pos_layout))
+				continue;
+		}
+		state.dirty = true;
+		found = true;
+	}
+
+	if (found)
+		this->scheduleNextFrame();
+}
+
+void RenderLoop::viewModifiedSlot()
+{
+	View* view = qobject_cast<View*>(this->sender());
+	ViewStateMap::iterator iter = mViewStates.find(view);
+	if (iter == mViewStates.end())
+	{
+		this->requestRender();
+		return;
+	}
+	iter->second.dirty = true;
+	this->scheduleNextFrame();
+}
+
+void RenderLoop::settleSlot()
+{
+	mSettleCheck = true;
+	this->requestRender();
+}
+
+/** Run a frame to flush the hub. The reps following the tools mark
+ *  their views dirty when the transforms are delivered.
+ */
+void RenderLoop::toolsMovedSlot()
+{
+	this->scheduleNextFrame();
+}
+
+void RenderLoop::scheduleNextFrame()
+{
+	if (!mRunning || mTimer->isActive())
+		return;
+	mTimer->start(this->getTimeToNextFrame());
+}
+
+/** Keep frames at least one rendering interval apart.
+ */
+int RenderLoop::getTimeToNextFrame() const
+{
+	double sinceLastFrame = double(mClock.nsecsElapsed() - mLastFrameStart) / 1.0E6;
+	int leftover = int(std::ceil(mBaseRenderInterval - sinceLastFrame));
+	return std::max(1, leftover); // always wait at least 1ms - give others time to do stuff
 }
 
 void RenderLoop::timeoutSlot()
 {
+	CX_TRACE_SCOPE("render", "frame");
+	mLastFrameStart = mClock.nsecsElapsed();
 	mCyclicLogger->begin();
-	mLastBeginRender = QDateTime::currentDateTime();
-	this->sendRenderIntervalToTimer(mBaseRenderInterval);
+	this->updateViewStates();
+
+	// deliver the latest tool positions once per frame, see ToolTransformHub.
+	// Reps depending on the tools or on slices following them mark their
+	// views dirty through View::modified().
+	ToolTransformHub::getInstance()->flush();
+	mCyclicLogger->time("transforms");
 
 	emit preRender();
 
-	this->renderViews();
+	if (!mSmartRender)
+		this->requestFullRender();
+
+	int rendered = this->renderViews();
 
 	this->emitFPSIfRequired();
 
-	int timeToNext = this->calculateTimeToNextRender();
-	this->sendRenderIntervalToTimer(timeToNext);
+	if (!mSmartRender || this->hasDirtyViews())
+		this->scheduleNextFrame();
+	else if (rendered)
+		mSettleTimer->start();
+	else if (mSettleCheck)
+		emit fps(0); // going idle
+
+	mSettleCheck = false;
 }
 
-void RenderLoop::renderViews()
+/** Render dirty views in priority order. Views showing the active tool
+ *  are always rendered, views deferred in the previous frame next,
+ *  the rest as long as the frame budget allows.
+ */
+int RenderLoop::renderViews()
 {
-	bool smart = this->pollForSmartRenderingThisCycle();
+	std::vector<ViewState*> dirty = this->getDirtyViewsInPriorityOrder();
+	qint64 budget = qint64(mBaseRenderInterval) * 1000000;
+	int rendered = 0;
+	CX_TRACE_COUNTER("render", "dirty views", dirty.size());
 
-	for (unsigned i=0; i<mLayoutWidgets.size(); ++i)
+	for (unsigned i=0; i<dirty.size(); ++i)
 	{
-		if (mLayoutWidgets[i])
+		ViewState* state = dirty[i];
+		bool overBudget = (mClock.nsecsElapsed() - mLastFrameStart) > budget;
+		if (overBudget && !state->deferred && !this->hasPriority(state->view))
 		{
-			if (!smart)
-				mLayoutWidgets[i]->setModified();
-			mLayoutWidgets[i]->render();
+			state->deferred = true;
+			continue;
+		}
+
+		state->dirty = false;
+		state->deferred = false;
+		if (!state->layout)
+			continue;
+
+		qint64 traceStart = Tracer::isEnabled() ? Tracer::now() : 0;
+		QElapsedTimer timer;
+		timer.start();
+		if (state->layout->renderView(state->view))
+		{
+			mViewRenderLogger->add(state->view->getUid(), double(timer.nsecsElapsed()) / 1.0E6);
+			if (Tracer::isEnabled())
+				Tracer::span("render", state->traceName, traceStart, Tracer::now() - traceStart);
+			++rendered;
 		}
 	}
 
 	mCyclicLogger->time("render");
 	emit renderFinished();
+	return rendered;
+}
+
+std::vector<RenderLoop::ViewState*> RenderLoop::getDirtyViewsInPriorityOrder()
+{
+	std::vector<ViewState*> priority;
+	std::vector<ViewState*> deferred;
+	std::vector<ViewState*> other;
+
+	for (ViewStateMap::iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+	{
+		ViewState* state = &iter->second;
+		if (!state->dirty)
+			continue;
+		if (this->hasPriority(state->view))
+			priority.push_back(state);
+		else if (state->deferred)
+			deferred.push_back(state);
+		else
+			other.push_back(state);
+	}
+
+	priority.insert(priority.end(), deferred.begin(), deferred.end());
+	priority.insert(priority.end(), other.begin(), other.end());
+	return priority;
+}
+
+/** The 2D views follow the active tool, 3D views might show it.
+ */
+bool RenderLoop::hasPriority(ViewPtr view) const
+{
+	if (!mActiveTool)
+		return false;
+	if (view->getType() == View::VIEW_2D)
+		return true;
+
+	std::vector<RepPtr> reps = view->getReps();
+	for (unsigned i=0; i<reps.size(); ++i)
+	{
+		ToolRep3DPtr toolRep = boost::dynamic_pointer_cast<ToolRep3D>(reps[i]);
+		if (toolRep && toolRep->getTool() == mActiveTool)
+			return true;
+	}
+	return false;
+}
+
+bool RenderLoop::hasDirtyViews() const
+{
+	for (ViewStateMap::const_iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+	{
+		if (iter->second.dirty)
+			return true;
+	}
+	return false;
+}
+
+void RenderLoop::markAllViewsDirty()
+{
+	for (ViewStateMap::iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+		iter->second.dirty = true;
 }
 
-bool RenderLoop::pollForSmartRenderingThisCycle()
+/** Track the views currently in the layouts. Layouts add and remove views
+ *  without telling us, so this is done every frame.
+ */
+void RenderLoop::updateViewStates()
 {
-	// do a full render anyway at low rate. This is a convenience hack for rendering
-	// occational effects that the smart render is too dumb to see.
-	bool smart = mSmartRender;
-	int smartInterval = mTimer->interval() * 40;
-	int passed = mLastFullRender.time().msecsTo(QDateTime::currentDateTime().time());
+	ViewStateMap current;
+	for (unsigned i=0; i<mLayoutWidgets.size(); ++i)
+	{
+		if (!mLayoutWidgets[i])
+			continue;
+		std::vector<ViewPtr> views = mLayoutWidgets[i]->getViews();
+		for (unsigned j=0; j<views.size(); ++j)
+		{
+			ViewStateMap::iterator old = mViewStates.find(views[j].get());
+			if (old != mViewStates.end())
+			{
+				current[views[j].get()] = old->second;
+				mViewStates.erase(old);
+				continue;
+			}
+
+			ViewState state;
+			state.view = views[j];
+			state.layout = mLayoutWidgets[i];
+			state.traceName = Tracer::intern("render " + views[j]->getUid());
+			current[views[j].get()] = state;
+			connect(views[j].get(), &View::modified, this, &RenderLoop::viewModifiedSlot);
+			if (mRunning)
+				this->watchInput(mLayoutWidgets[i]);
+		}
+	}
 
-	if (passed > smartInterval)
-		smart = false;
-	if (!smart)
-		mLastFullRender = QDateTime::currentDateTime();
-	return smart;
+	// remaining states belong to removed views
+	for (ViewStateMap::iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+		disconnect(iter->second.view.get(), &View::modified, this, &RenderLoop::viewModifiedSlot);
+
+	mViewStates.swap(current);
 }
 
 void RenderLoop::emitFPSIfRequired()
@@ -151,11 +458,15 @@ void RenderLoop::emitFPSIfRequired()
 	{
 		emit fps(mCyclicLogger->getFPS());
 		this->dumpStatistics();
-//		static int counter=0;
-//		if (++counter%3==0)
-//			reportDebug(mCyclicLogger->dumpStatisticsSmall());
 		mCyclicLogger->reset();
 	}
+
+	if (mViewRenderLogger->intervalPassed())
+	{
+		if (mLogging)
+			reportDebug(this->dumpViewRenderTimeHistograms());
+		mViewRenderLogger->reset(viewRenderLoggerInterval);
+	}
 }
 
 void RenderLoop::dumpStatistics()
@@ -168,17 +479,21 @@ void RenderLoop::dumpStatistics()
 		reportDebug(mCyclicLogger->dumpStatisticsSmall());
 }
 
-int RenderLoop::calculateTimeToNextRender()
+QString RenderLoop::dumpViewRenderTimeHistograms()
 {
-	// tests show that the application wait between renderings even if the rendering uses more time
-	// than the interval. This hack shortens the wait time between renderings but keeps below the
-	// input update rate at all times.
-	int usage = mLastBeginRender.msecsTo(QDateTime::currentDateTime()); // time spent in rendering
-	int leftover = std::max(0, mTimer->interval() - usage); // time left of the rendering interval
-	int timeToNext = std::max(1, leftover); // always wait at least 1ms - give others time to do stuff
-	//    std::cout << QString("setting interval %1, usage is %2").arg(timeToNext).arg(usage) << std::endl;
-	return timeToNext;
+	std::vector<double> limits;
+	limits.push_back(1);
+	limits.push_back(2);
+	limits.push_back(4);
+	limits.push_back(8);
+	limits.push_back(16);
+	limits.push_back(33);
+	limits.push_back(66);
+
+	QStringList retval;
+	for (ViewStateMap::iterator iter=mViewStates.begin(); iter!=mViewStates.end(); ++iter)
+		retval << mViewRenderLogger->dumpHistogram(iter->second.view->getUid(), limits);
+	return retval.join("\n");
 }
 
 } // namespace cx
-
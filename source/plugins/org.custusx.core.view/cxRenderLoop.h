@@ -14,10 +14,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "org_custusx_core_view_Export.h"
 
 #include <QObject>
+#include <QPointer>
+#include <QElapsedTimer>
 #include "cxForwardDeclarations.h"
 class QTimer;
-#include <QDateTime>
-#include <set>
+class QWidget;
+#include <map>
+#include <vector>
 
 namespace cx
 {
@@ -27,6 +30,20 @@ class ViewCollectionWidget;
  *
  * This is the main render loop in Custus.
  *
+ * With smart render on, rendering is event driven: Views are marked dirty
+ * by View::modified(), emitted by reps when their content changes, e.g.
+ * on new tool transforms or slice changes, and by user input in the view.
+ * Only dirty views are rendered. Frames are paced against the rendering
+ * interval. Views showing the active tool are
+ * rendered first, the rest are deferred to the next frame if the frame
+ * budget is used up. The loop stops completely when nothing is dirty,
+ * after a final check of all views.
+ *
+ * With smart render off, all views are rendered every interval.
+ *
+ * Render times per view are collected in getViewRenderTimer(), see
+ * dumpViewRenderTimeHistograms().
+ *
  * \ingroup org_custusx_core_view
  * \date 2014-02-06
  * \author christiana
@@ -40,48 +57,79 @@ public:
 	void stop();
 	bool isRunning() const;
 	void setRenderingInterval(int interval);
-	void setSmartRender(bool val); ///< If set: Render only views with modified props using the given interval, render nonmodified at a slower pace.
+	void setSmartRender(bool val); ///< If set: Render only views that have been modified, idle when nothing happens.
 	void setLogging(bool on);
+	void setActiveTool(ToolPtr tool); ///< views showing this tool are rendered first
 
 	void clearViews();
 	void addLayout(ViewCollectionWidget* layout);
 
 	CyclicActionLoggerPtr getRenderTimer() { return mCyclicLogger; }
+	CyclicActionLoggerPtr getViewRenderTimer() { return mViewRenderLogger; } ///< render time for each view uid, in ms
+	QString dumpViewRenderTimeHistograms();
 
-//public slots:
-//	void requestPreRenderSignal();
+public slots:
+	void requestRender(); ///< schedule a check of all views
+	void requestFullRender(); ///< schedule a forced render of all views, e.g. after a layout change
 
 signals:
 	void preRender();
 	void fps(int number); ///< Emits number of frames per second
 	void renderFinished();
 
+protected:
+	virtual bool eventFilter(QObject* watched, QEvent* event);
+
 private slots:
 	void timeoutSlot();
+	void settleSlot();
+	void viewModifiedSlot();
+	void toolsMovedSlot();
 
 private:
-	void sendRenderIntervalToTimer(int interval);
-	void emitPreRenderIfRequested();
-	void renderViews();
-	bool pollForSmartRenderingThisCycle();
-	int calculateTimeToNextRender();
+	struct ViewState
+	{
+		ViewState() : traceName(""), dirty(true), deferred(false) {}
+		ViewPtr view;
+		QPointer<ViewCollectionWidget> layout;
+		const char* traceName; ///< see Tracer
+		bool dirty;
+		bool deferred; ///< skipped last frame because of the frame budget
+	};
+	typedef std::map<View*, ViewState> ViewStateMap;
+
+	void scheduleNextFrame();
+	void updateViewStates();
+	void markAllViewsDirty();
+	void markInputTargetDirty(QObject* watched, QEvent* event);
+	void watchInput(ViewCollectionWidget* layout);
+	void unwatchInput();
+	int renderViews(); ///< return number of views rendered
+	std::vector<ViewState*> getDirtyViewsInPriorityOrder();
+	bool hasPriority(ViewPtr view) const;
+	bool hasDirtyViews() const;
+	int getTimeToNextFrame() const;
 	void emitFPSIfRequired();
 	void dumpStatistics();
 
 	QTimer* mTimer; ///< timer that drives rendering
-	QDateTime mLastFullRender;
-	QDateTime mLastBeginRender;
+	QTimer* mSettleTimer; ///< triggers a final check of all views after activity
+	QElapsedTimer mClock;
+	qint64 mLastFrameStart; ///< ns
+	bool mRunning;
+	bool mSettleCheck; ///< this frame is the final check after activity
 
 	CyclicActionLoggerPtr mCyclicLogger;
+	CyclicActionLoggerPtr mViewRenderLogger;
 
 	bool mSmartRender;
-//	bool mPreRenderSignalRequested;
 	int mBaseRenderInterval;
 	bool mLogging;
+	ToolPtr mActiveTool;
 
-//	typedef std::set<ViewPtr> ViewSet;
-//	ViewSet mViews;
 	std::vector<QPointer<ViewCollectionWidget> > mLayoutWidgets;
+	std::vector<QPointer<QWidget> > mInputWidgets; ///< layout widgets and their children, see eventFilter()
+	ViewStateMap mViewStates;
 };
 
 typedef boost::shared_ptr<RenderLoop> RenderLoopPtr;
@@ -41,6 +41,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxViewWrapper3D.h"
 #include "cxViewWrapperVideo.h"
 #include "cxProfile.h"
+#include "cxTrackingService.h"
 
 namespace cx
 {
@@ -80,6 +81,8 @@ void ViewImplService::init()
 	mRenderLoop->setLogging(settings()->value("renderSpeedLogging").toBool());
 	mRenderLoop->setSmartRender(settings()->value("smartRender", true).toBool());
 	connect(settings(), SIGNAL(valueChangedFor(QString)), this, SLOT(settingsChangedSlot(QString)));
+	connect(mServices->tracking().get(), &TrackingService::activeToolChanged, this, &ViewImplService::activeToolChangedSlot);
+	this->activeToolChangedSlot();
 
 	const unsigned VIEW_GROUP_COUNT = 5; // set this to enough
 	// initialize view groups:
@@ -226,6 +229,11 @@ void ViewImplService::updateViews()
 	}
 }
 
+void ViewImplService::activeToolChangedSlot()
+{
+	mRenderLoop->setActiveTool(mServices->tracking()->getActiveTool());
+}
+
 void ViewImplService::settingsChangedSlot(QString key)
 {
 	if (key == "smartRender")
@@ -433,6 +441,7 @@ void ViewImplService::rebuildLayouts()
 	this->setSlicePlanesProxyInViewsUpTo2DViewgroup();
 
 	mCameraControl->refreshView(this->get3DView());
+	mRenderLoop->requestFullRender();
 }
 
 void ViewImplService::setSlicePlanesProxyInViewsUpTo2DViewgroup()
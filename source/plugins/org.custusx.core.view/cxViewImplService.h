@@ -135,6 +135,7 @@ private slots:
 	void onLayoutRepositoryChanged(QString uid);
 	void setActiveView(QString viewUid);
 	void settingsChangedSlot(QString key);
+	void activeToolChangedSlot();
 
 protected:
 	void rebuildLayouts();
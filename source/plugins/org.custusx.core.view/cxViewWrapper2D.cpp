@@ -87,6 +87,8 @@ ViewWrapper2D::ViewWrapper2D(ViewPtr view, VisServicesPtr backend) :
 
 	// slice proxy
 	mSliceProxy = SliceProxy::create(mServices->patient());
+	connect(mSliceProxy.get(), SIGNAL(transformChanged(Transform3D)), this, SLOT(sliceProxyChangedSlot()));
+	connect(mSliceProxy.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this, SLOT(sliceProxyChangedSlot()));
 
 	mDataRepContainer.reset(new DataRepContainer());
 	mDataRepContainer->setSliceProxy(mSliceProxy);
@@ -232,6 +234,11 @@ void ViewWrapper2D::toggleShowManualTool()
 		mView->removeRep(mToolRep2D);
 }
 
+void ViewWrapper2D::sliceProxyChangedSlot()
+{
+	mView->setModified();
+}
+
 void ViewWrapper2D::removeAndResetSliceRep()
 {
 	if (mSliceRep)
@@ -423,9 +430,21 @@ ImagePtr ViewWrapper2D::getImageToDisplay()
 	return image;
 }
 
+/** The GPU slicer uploads whole volumes as textures, thus views showing
+ *  out-of-core images use the software slicer, which reads only the
+ *  bricks around the slice.
+ */
 bool ViewWrapper2D::useGPU2DRendering()
 {
-	return settings()->value("View2D/useGPU2DRendering").toBool();
+	if (!settings()->value("View2D/useGPU2DRendering").toBool())
+		return false;
+	if (!mGroupData)
+		return true;
+	std::vector<ImagePtr> images = this->getImagesToView();
+	for (unsigned i=0; i<images.size(); ++i)
+		if (images[i]->isOutOfCore())
+			return false;
+	return true;
 }
 
 void ViewWrapper2D::createAndAddSliceRep()
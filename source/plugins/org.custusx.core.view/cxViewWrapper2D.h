@@ -90,6 +90,7 @@ private slots:
 	void optionChangedSlot();
 	void showManualToolSlot(bool visible);
 	void toggleShowManualTool();
+	void sliceProxyChangedSlot(); ///< all reps follow the slice, render the view
 
 protected slots:
 	void samplePoint(Vector3D click_vp);
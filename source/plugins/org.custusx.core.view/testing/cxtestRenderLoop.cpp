@@ -0,0 +1,60 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxLogicManager.h"
+#include "cxDataLocations.h"
+#include "cxtestViewServiceMock.h"
+#include "cxtestQueuedSignalListener.h"
+#include "cxRenderLoop.h"
+#include "cxCyclicActionLogger.h"
+#include "cxView.h"
+
+namespace
+{
+int waitUntilIdle(cx::RenderLoopPtr renderLoop)
+{
+	int frames = 0;
+	while (frames < 1000 && cxtest::waitForQueuedSignal(renderLoop.get(), SIGNAL(renderFinished()), 2000, true))
+		++frames;
+	return frames;
+}
+}
+
+TEST_CASE("RenderLoop: Renders modified views only, idle otherwise", "[integration][plugins][org.custusx.core.view]")
+{
+	cx::DataLocations::setTestMode();
+	cx::LogicManager::initialize();
+
+	ctkPluginContext* context = cx::LogicManager::getInstance()->getPluginContext();
+	cxtest::ViewServiceMockPtr viewservice(new cxtest::ViewServiceMock(context));
+	viewservice->createLayoutWidget(NULL, 0);
+	cx::RenderLoopPtr renderLoop = viewservice->getRenderLoop();
+	REQUIRE(renderLoop->isRunning());
+
+	// initial render of the layout, then the loop stops
+	CHECK(waitUntilIdle(renderLoop) < 1000);
+	CHECK(renderLoop->isRunning());
+
+	cx::ViewPtr view = viewservice->get3DView();
+	REQUIRE(view);
+	view->setModified();
+	CHECK(cxtest::waitForQueuedSignal(renderLoop.get(), SIGNAL(renderFinished()), 500, true));
+	CHECK(waitUntilIdle(renderLoop) < 1000);
+
+	std::vector<double> limits(1, 1000.0);
+	std::vector<int> histogram = renderLoop->getViewRenderTimer()->getHistogram(view->getUid(), limits);
+	CHECK(histogram[0] + histogram[1] > 0);
+
+	viewservice.reset();
+	cx::LogicManager::shutdown();
+}
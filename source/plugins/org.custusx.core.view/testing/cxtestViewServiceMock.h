@@ -19,5 +19,6 @@ public:
 	std::vector<QPointer<cx::ViewCollectionWidget> > getViewCollectionWidgets() const;
 
 	QList<unsigned> getAutoShowViewGroupNumbers();
+	cx::RenderLoopPtr getRenderLoop() { return mRenderLoop; }
 };
 }
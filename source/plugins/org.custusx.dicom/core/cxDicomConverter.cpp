@@ -28,13 +28,18 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxDicomImageReader.h"
 #include "cxCustomMetaImage.h"
+#include "cxVolumeHelpers.h"
+#include <QtConcurrent>
+#include <iterator>
 
 typedef vtkSmartPointer<vtkImageAppend> vtkImageAppendPtr;
 
 namespace cx
 {
 
-DicomConverter::DicomConverter()
+DicomConverter::DicomConverter() :
+	mDatabase(NULL),
+	mUseSliceLevelThreading(true)
 {
 }
 
@@ -47,20 +52,29 @@ void DicomConverter::setDicomDatabase(ctkDICOMDatabase* database)
 	mDatabase = database;
 }
 
+void DicomConverter::setUseSliceLevelThreading(bool on)
+{
+	mUseSliceLevelThreading = on;
+}
+
 QString DicomConverter::generateUid(DicomImageReaderPtr reader)
 {
 	QString seriesDescription = reader->item()->GetElementAsString(DCM_SeriesDescription);
 	QString seriesNumber = reader->item()->GetElementAsString(DCM_SeriesNumber);
+	return this->generateUid(seriesDescription, seriesNumber);
+}
 
+QString DicomConverter::generateUid(QString seriesDescription, QString seriesNumber) const
+{
 	// uid: uid _ <timestamp>
 	// name: find something from series
 	QString currentTimestamp = QDateTime::currentDateTime().toString(timestampSecondsFormat());
 	QString uid = QString("%1_%2_%3").arg(seriesDescription).arg(seriesNumber).arg(currentTimestamp);
-	uid = this->convertToValidName(uid);
+	uid = convertToValidName(uid);
 	return uid;
 }
 
-QString DicomConverter::convertToValidName(QString text) const
+QString DicomConverter::convertToValidName(QString text)
 {
 	QStringList illegal;
 	illegal << "\\s" << "\\." << ":" << ";" << "\\<" << "\\>" << "\\*"
@@ -139,28 +153,26 @@ std::vector<ImagePtr> DicomConverter::createImages(QStringList files)
 	return retval;
 }
 
-std::map<double, ImagePtr> DicomConverter::sortImagesAlongDirection(std::vector<ImagePtr> images, Vector3D  e_sort)
+DicomConverter::SortedSlices DicomConverter::sortImagesAlongDirection(std::vector<Transform3D> rMd, Vector3D e_sort) const
 {
-	std::map<double, ImagePtr> sorted;
-	for (unsigned i=0; i<images.size(); ++i)
+	SortedSlices sorted;
+	for (unsigned i=0; i<rMd.size(); ++i)
 	{
-		Vector3D pos = images[i]->get_rMd().coord(Vector3D(0,0,0));
+		Vector3D pos = rMd[i].coord(Vector3D(0,0,0));
 		double dist = dot(pos, e_sort);
 
-		sorted[dist] = images[i];
+		sorted[dist] = i;
 	}
 	return sorted;
 }
 
-bool DicomConverter::slicesFormRegularGrid(std::map<double, ImagePtr> sorted, Vector3D e_sort) const
+bool DicomConverter::slicesFormRegularGrid(std::vector<Transform3D> rMd, SortedSlices sorted, Vector3D e_sort) const
 {
 	std::vector<Vector3D> positions;
 	std::vector<double> distances;
-	for (std::map<double, ImagePtr>::iterator iter=sorted.begin(); iter!=sorted.end(); ++iter)
+	for (SortedSlices::iterator iter=sorted.begin(); iter!=sorted.end(); ++iter)
 	{
-		ImagePtr current = iter->second;
-
-		Vector3D pos = current->get_rMd().coord(Vector3D(0,0,0));
+		Vector3D pos = rMd[iter->second].coord(Vector3D(0,0,0));
 		positions.push_back(pos);
 
 		if (positions.size()>=2)
@@ -195,16 +207,8 @@ bool DicomConverter::slicesFormRegularGrid(std::map<double, ImagePtr> sorted, Ve
 	return true;
 }
 
-double DicomConverter::getMeanSliceDistance(std::map<double, ImagePtr> sorted) const
+double DicomConverter::getMeanSliceDistance(SortedSlices sorted) const
 {
-	if (sorted.size()==0)
-		return 0;
-
-	// check for multislice image
-	vtkImageDataPtr first = sorted.begin()->second->getBaseVtkImageData();
-	if (first->GetDimensions()[2]>1)
-		return first->GetSpacing()[2];
-
 	if (sorted.size()<2)
 		return 0;
 
@@ -215,18 +219,24 @@ double DicomConverter::getMeanSliceDistance(std::map<double, ImagePtr> sorted) c
 	return (zValueLastImage-zValueFirstImage)/numHolesBetweenImages;
 }
 
-ImagePtr DicomConverter::mergeSlices(std::map<double, ImagePtr> sorted) const
+ImagePtr DicomConverter::mergeSlices(std::vector<ImagePtr> images, SortedSlices sorted) const
 {
 	vtkImageAppendPtr appender = vtkImageAppendPtr::New();
 	appender->SetAppendAxis(2);
 
-	ImagePtr retval = sorted.begin()->second;
+	ImagePtr retval = images[sorted.begin()->second];
+
+	// keep the scalar type if all slices share it, otherwise convert to short
+	int scalarType = retval->getBaseVtkImageData()->GetScalarType();
+	for (unsigned j=0; j<images.size(); ++j)
+		if (images[j]->getBaseVtkImageData()->GetScalarType()!=scalarType)
+			scalarType = VTK_SHORT;
 
 	int i = 0;
 
-	for (std::map<double, ImagePtr>::iterator iter=sorted.begin(); iter!=sorted.end(); ++iter)
+	for (SortedSlices::iterator iter=sorted.begin(); iter!=sorted.end(); ++iter)
 	{
-		ImagePtr current = iter->second;
+		ImagePtr current = images[iter->second];
 
 		// Set window width and level to the values of the middle frame
 		if (i == sorted.size() / 2)
@@ -236,7 +246,7 @@ ImagePtr DicomConverter::mergeSlices(std::map<double, ImagePtr> sorted) const
 		//Convert all slices to same format
 		vtkImageCastPtr imageCast = vtkImageCastPtr::New();
 		imageCast->SetInputData(current->getBaseVtkImageData());
-		imageCast->SetOutputScalarTypeToShort();
+		imageCast->SetOutputScalarType(scalarType);
 		imageCast->Update();
 
 		appender->AddInputData(imageCast->GetOutput());
@@ -245,7 +255,12 @@ ImagePtr DicomConverter::mergeSlices(std::map<double, ImagePtr> sorted) const
 
 	vtkImageDataPtr wholeImage = appender->GetOutput();
 	Eigen::Array3d spacing(wholeImage->GetSpacing());
-	spacing[2] = this->getMeanSliceDistance(sorted);
+	// check for multislice image
+	vtkImageDataPtr first = retval->getBaseVtkImageData();
+	if (first->GetDimensions()[2]>1)
+		spacing[2] = first->GetSpacing()[2];
+	else
+		spacing[2] = this->getMeanSliceDistance(sorted);
 	wholeImage->SetSpacing(spacing.data());
 
 	retval->setVtkImageData(wholeImage);
@@ -256,7 +271,18 @@ ImagePtr DicomConverter::mergeSlices(std::map<double, ImagePtr> sorted) const
 ImagePtr DicomConverter::convertToImage(QString series)
 {
 	QStringList files = mDatabase->filesForSeries(series);
+	return this->convertFilesToImage(files);
+}
 
+ImagePtr DicomConverter::convertFilesToImage(QStringList files)
+{
+	if (mUseSliceLevelThreading)
+		return this->convertParallel(files);
+	return this->convertSerial(files);
+}
+
+ImagePtr DicomConverter::convertSerial(QStringList files)
+{
 	std::vector<ImagePtr> images = this->createImages(files);
 
 	if (images.empty())
@@ -267,15 +293,179 @@ ImagePtr DicomConverter::convertToImage(QString series)
 		return images.front();
 	}
 
-	Vector3D e_sort = images.front()->get_rMd().vector(Vector3D(0,0,1));
+	std::vector<Transform3D> rMd;
+	for (unsigned i=0; i<images.size(); ++i)
+		rMd.push_back(images[i]->get_rMd());
+
+	Vector3D e_sort = rMd.front().vector(Vector3D(0,0,1));
 
-	std::map<double, ImagePtr> sorted = this->sortImagesAlongDirection(images, e_sort);
+	SortedSlices sorted = this->sortImagesAlongDirection(rMd, e_sort);
 
-	if (!this->slicesFormRegularGrid(sorted, e_sort))
+	if (!this->slicesFormRegularGrid(rMd, sorted, e_sort))
 		return ImagePtr();
 
-	ImagePtr retval = this->mergeSlices(sorted);
+	ImagePtr retval = this->mergeSlices(images, sorted);
 	return retval;
 }
 
+DicomSliceHeader DicomConverter::readSliceHeader(QString filename)
+{
+	DicomImageReaderPtr reader = DicomImageReader::createHeaderFromFile(filename);
+	if (!reader)
+	{
+		reportWarning(QString("File not found: %1").arg(filename));
+		return DicomSliceHeader();
+	}
+
+	DicomSliceHeader retval = reader->getSliceHeader();
+
+	if (retval.localizer)
+	{
+		reportWarning(QString("Localizer image removed from series: %1").arg(filename));
+		return retval;
+	}
+
+	if (retval.numberOfFrames==0)
+	{
+		reportWarning(QString("Found no images in %1, skipping.").arg(filename));
+		return retval;
+	}
+
+	retval.valid = true;
+	return retval;
+}
+
+std::vector<DicomSliceHeader> DicomConverter::readSliceHeaders(QStringList files)
+{
+	std::vector<DicomSliceHeader> headers(files.size());
+	std::vector<int> indices(files.size());
+	for (unsigned i=0; i<indices.size(); ++i)
+		indices[i] = i;
+
+	QtConcurrent::blockingMap(indices, [&](int i)
+	{
+		headers[i] = readSliceHeader(files[i]);
+	});
+
+	std::vector<DicomSliceHeader> retval;
+	for (unsigned i=0; i<headers.size(); ++i)
+		if (headers[i].valid)
+			retval.push_back(headers[i]);
+	return retval;
+}
+
+bool DicomConverter::canDecodeDirectly(const std::vector<DicomSliceHeader>& headers) const
+{
+	for (unsigned i=0; i<headers.size(); ++i)
+	{
+		if (headers[i].samplesPerPixel!=1)
+			return false;
+		if (headers[i].dim[2]!=1)
+			return false;
+		if ((headers[i].dim.head<2>()!=headers.front().dim.head<2>()).any())
+			return false;
+	}
+	return true;
+}
+
+ImagePtr DicomConverter::convertParallel(QStringList files)
+{
+	std::vector<DicomSliceHeader> headers = this->readSliceHeaders(files);
+	return this->convertSlicesToImage(headers);
+}
+
+ImagePtr DicomConverter::convertSlicesToImage(std::vector<DicomSliceHeader> headers)
+{
+	if (headers.empty())
+		return ImagePtr();
+
+	if (headers.size()==1 || !this->canDecodeDirectly(headers))
+	{
+		QStringList files;
+		for (unsigned i=0; i<headers.size(); ++i)
+			files << headers[i].filename;
+		return this->convertSerial(files);
+	}
+
+	std::vector<Transform3D> rMd;
+	for (unsigned i=0; i<headers.size(); ++i)
+		rMd.push_back(headers[i].rMd);
+
+	Vector3D e_sort = rMd.front().vector(Vector3D(0,0,1));
+
+	SortedSlices sorted = this->sortImagesAlongDirection(rMd, e_sort);
+
+	if (!this->slicesFormRegularGrid(rMd, sorted, e_sort))
+		return ImagePtr();
+
+	return this->decodeSlices(headers, sorted);
+}
+
+/** Allocate the output volume, then decode all slices in parallel
+ *  directly into their position in the volume.
+ *
+ *  The volume gets the scalar type DCMTK decodes the first slice to,
+ *  as in the serial conversion. If a slice decodes to another type,
+ *  the serial conversion is used instead.
+ */
+ImagePtr DicomConverter::decodeSlices(const std::vector<DicomSliceHeader>& headers, SortedSlices sorted)
+{
+	const DicomSliceHeader& first = headers[sorted.begin()->second];
+	const DicomSliceHeader& middle = headers[std::next(sorted.begin(), sorted.size()/2)->second];
+
+	Eigen::Array3i dim(first.dim[0], first.dim[1], sorted.size());
+	Eigen::Array3d spacing = first.spacing;
+	spacing[2] = this->getMeanSliceDistance(sorted);
+
+	int scalarType = DicomImageReader::getDecodedScalarType(first.filename);
+	if (scalarType==VTK_VOID)
+	{
+		reportWarning(QString("Failed to create image for %1.").arg(first.filename));
+		return ImagePtr();
+	}
+
+	vtkImageDataPtr wholeImage = vtkImageDataPtr::New();
+	wholeImage->SetSpacing(spacing.data());
+	wholeImage->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	wholeImage->AllocateScalars(scalarType, 1);
+	char* buffer = static_cast<char*>(wholeImage->GetScalarPointer());
+	long sliceSize = long(dim[0])*dim[1];
+	long sliceBytes = sliceSize*wholeImage->GetScalarSize();
+
+	std::vector<int> order;
+	for (SortedSlices::iterator iter=sorted.begin(); iter!=sorted.end(); ++iter)
+		order.push_back(iter->second);
+	std::vector<int> slices(order.size());
+	for (unsigned i=0; i<slices.size(); ++i)
+		slices[i] = i;
+
+	std::vector<char> success(order.size(), 0);
+	QtConcurrent::blockingMap(slices, [&](int z)
+	{
+		QString filename = headers[order[z]].filename;
+		success[z] = DicomImageReader::decodePixels(filename, buffer + z*sliceBytes, scalarType, sliceSize);
+	});
+
+	if (std::find(success.begin(), success.end(), 0) != success.end())
+	{
+		QStringList files;
+		for (unsigned i=0; i<order.size(); ++i)
+			files << headers[order[i]].filename;
+		return this->convertSerial(files);
+	}
+	setDeepModified(wholeImage);
+
+	QString uid = this->generateUid(first.seriesDescription, first.seriesNumber);
+	QString name = convertToValidName(first.seriesDescription);
+	cx::ImagePtr image = cx::Image::create(uid, name);
+	image->setVtkImageData(wholeImage);
+	image->setModality(convertToModality(first.modality));
+	image->setImageType(istEMPTY);
+	// Set window width and level to the values of the middle frame
+	image->setInitialWindowLevel(middle.windowLevel.width, middle.windowLevel.center);
+	image->get_rMd_History()->setRegistration(first.rMd);
+
+	return image;
+}
+
 } /* namespace cx */
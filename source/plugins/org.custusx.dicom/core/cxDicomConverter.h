@@ -13,6 +13,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #define CXDICOMCONVERTER_H_
 
 #include "cxImage.h"
+#include "cxDicomImageReader.h"
 #include "org_custusx_dicom_Export.h"
 class ctkDICOMDatabase;
 
@@ -23,6 +24,14 @@ typedef boost::shared_ptr<class DicomImageReader> DicomImageReaderPtr;
 /**
  * Import dicom series into cx Image.
  *
+ * Headers for all files in the series are parsed in parallel, and
+ * geometry and sort order is computed from the headers only. The pixel
+ * data are then decoded in parallel directly into the output volume.
+ *
+ * Series that cannot be handled this way (multiframe files in a series,
+ * color images) are converted using the serial path, which creates one
+ * Image per file and merges them afterwards.
+ *
  * \ingroup org_custusx_dicom
  *
  * \date 2014-04-04
@@ -35,21 +44,35 @@ public:
 	virtual ~DicomConverter();
 
 	void setDicomDatabase(ctkDICOMDatabase* database);
+	void setUseSliceLevelThreading(bool on); ///< default on. Off gives the serial, one Image per file conversion.
 	ImagePtr convertToImage(QString seriesUid);
+	ImagePtr convertFilesToImage(QStringList files);
+	ImagePtr convertSlicesToImage(std::vector<DicomSliceHeader> headers); ///< convert using already known headers, e.g. from DicomSeriesIndex
+	static DicomSliceHeader readSliceHeader(QString filename);
 
 private:
+	typedef std::map<double, int> SortedSlices; ///< distance along sort direction -> slice index
+
 	QString generateUid(DicomImageReaderPtr reader);
 	QString generateName(DicomImageReaderPtr reader);
-	std::map<double, ImagePtr> sortImagesAlongDirection(std::vector<ImagePtr> images, Vector3D  e_sort);
-	ImagePtr mergeSlices(std::map<double, ImagePtr> sorted) const;
-	double getMeanSliceDistance(std::map<double, ImagePtr> sorted) const;
-	bool slicesFormRegularGrid(std::map<double, ImagePtr> sorted, Vector3D e_sort) const;
+	QString generateUid(QString seriesDescription, QString seriesNumber) const;
+	SortedSlices sortImagesAlongDirection(std::vector<Transform3D> rMd, Vector3D e_sort) const;
+	ImagePtr mergeSlices(std::vector<ImagePtr> images, SortedSlices sorted) const;
+	double getMeanSliceDistance(SortedSlices sorted) const;
+	bool slicesFormRegularGrid(std::vector<Transform3D> rMd, SortedSlices sorted, Vector3D e_sort) const;
 	// ignoreLocalizerImages is a tag to ignore special images. For now only localizer images are ignored
 	ImagePtr createCxImageFromDicomFile(QString filename, bool ignoreLocalizerImages);
 	std::vector<ImagePtr> createImages(QStringList files);
-	QString convertToValidName(QString text) const;
+	static QString convertToValidName(QString text);
+
+	ImagePtr convertSerial(QStringList files);
+	ImagePtr convertParallel(QStringList files);
+	std::vector<DicomSliceHeader> readSliceHeaders(QStringList files);
+	bool canDecodeDirectly(const std::vector<DicomSliceHeader>& headers) const;
+	ImagePtr decodeSlices(const std::vector<DicomSliceHeader>& headers, SortedSlices sorted);
 
 	ctkDICOMDatabase* mDatabase;
+	bool mUseSliceLevelThreading;
 };
 
 } /* namespace cx */
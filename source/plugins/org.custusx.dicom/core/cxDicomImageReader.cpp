@@ -14,6 +14,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxVolumeHelpers.h"
 #include "dcvrpn.h"
 #include "cxLogger.h"
+#include "vtkDataArray.h"
+#include <algorithm>
 
 namespace cx
 {
@@ -21,7 +23,18 @@ namespace cx
 DicomImageReaderPtr DicomImageReader::createFromFile(QString filename)
 {
 	DicomImageReaderPtr retval(new DicomImageReader);
-	if (retval->loadFile(filename))
+	if (retval->loadFile(filename, DCM_UndefinedTagKey))
+		return retval;
+	else
+		return DicomImageReaderPtr();
+}
+
+DicomImageReaderPtr DicomImageReader::createHeaderFromFile(QString filename)
+{
+	// All elements before the pixel data are read in full,
+	// parsing stops at the pixel data.
+	DicomImageReaderPtr retval(new DicomImageReader);
+	if (retval->loadFile(filename, DCM_PixelData))
 		return retval;
 	else
 		return DicomImageReaderPtr();
@@ -32,10 +45,11 @@ DicomImageReader::DicomImageReader() :
 {
 }
 
-bool DicomImageReader::loadFile(QString filename)
+bool DicomImageReader::loadFile(QString filename, const DcmTagKey& stopParsingAtElement)
 {
 	mFilename = filename;
-	OFCondition status = mFileFormat.loadFile(filename.toLatin1().data());
+	OFCondition status = mFileFormat.loadFileUntilTag(filename.toLatin1().data(), EXS_Unknown, EGL_noChange,
+													  DCM_MaxReadLength, ERM_autoDetect, stopParsingAtElement);
 	if( !status.good() )
 	{
 		return false;
@@ -195,41 +209,116 @@ vtkImageDataPtr DicomImageReader::createVtkImageData()
 	int scalarSize = dim.prod() * samplesPerPixel;
 	int pixelDepth = dicomImage.getDepth();
 
-	switch (pixels->getRepresentation())
+	data->AllocateScalars(getVtkScalarType(pixels->getRepresentation()), samplesPerPixel);
+
+	int bytesPerPixel = data->GetScalarSize() * samplesPerPixel;
+
+	memcpy(data->GetScalarPointer(), pixels->getData(), pixels->getCount()*bytesPerPixel);
+	if (pixels->getCount()!=scalarSize)
+		this->error("Mismatch in pixel counts");
+	setDeepModified(data);
+	return data;
+}
+
+int DicomImageReader::getVtkScalarType(EP_Representation representation)
+{
+	switch (representation)
 	{
 	case EPR_Uint8:
-//		std::cout << "  VTK_UNSIGNED_CHAR" << std::endl;
-		data->AllocateScalars(VTK_UNSIGNED_CHAR, samplesPerPixel);
-		break;
+		return VTK_UNSIGNED_CHAR;
 	case EPR_Uint16:
-//		std::cout << "  VTK_UNSIGNED_SHORT" << std::endl;
-		data->AllocateScalars(VTK_UNSIGNED_SHORT, samplesPerPixel);
-		break;
+		return VTK_UNSIGNED_SHORT;
 	case EPR_Uint32:
-//		std::cout << "  VTK_UNSIGNED_INT" << std::endl;
-		data->AllocateScalars(VTK_UNSIGNED_INT, samplesPerPixel);
-		break;
+		return VTK_UNSIGNED_INT;
 	case EPR_Sint8:
-//		std::cout << "  VTK_CHAR" << std::endl;
-		data->AllocateScalars(VTK_CHAR, samplesPerPixel);
-		break;
+		return VTK_CHAR;
 	case EPR_Sint16:
-//		std::cout << "  VTK_SHORT" << std::endl;
-		data->AllocateScalars(VTK_SHORT, samplesPerPixel);
-		break;
+		return VTK_SHORT;
 	case EPR_Sint32:
-//		std::cout << "  VTK_INT" << std::endl;
-		data->AllocateScalars(VTK_INT, samplesPerPixel);
-		break;
+		return VTK_INT;
 	}
+	return VTK_VOID;
+}
 
-	int bytesPerPixel = data->GetScalarSize() * samplesPerPixel;
+int DicomImageReader::getDecodedScalarType(QString filename)
+{
+	DicomImage dicomImage(filename.toLatin1().data());
+	const DiPixel *pixels = dicomImage.getInterData();
+	if (!pixels)
+		return VTK_VOID;
+	return getVtkScalarType(pixels->getRepresentation());
+}
 
-	memcpy(data->GetScalarPointer(), pixels->getData(), pixels->getCount()*bytesPerPixel);
-	if (pixels->getCount()!=scalarSize)
-		this->error("Mismatch in pixel counts");
-	setDeepModified(data);
-	return data;
+bool DicomImageReader::decodePixels(QString filename, void* dest, int scalarType, long count)
+{
+	DicomImage dicomImage(filename.toLatin1().data());
+	const DiPixel *pixels = dicomImage.getInterData();
+	QString error;
+	if (!pixels)
+		error = "Found no pixel data";
+	else if (pixels->getPlanes()!=1)
+		error = "Direct decoding supports single-component images only";
+	else if (long(pixels->getCount())!=count)
+		error = "Mismatch in pixel counts";
+	else if (getVtkScalarType(pixels->getRepresentation())!=scalarType)
+		error = "Pixel representation differs from the rest of the series";
+	if (!error.isEmpty())
+	{
+		reportWarning(QString("Dicom convert: [%1] in %2").arg(error).arg(filename));
+		return false;
+	}
+
+	memcpy(dest, pixels->getData(), count*vtkDataArray::GetDataTypeSize(scalarType));
+	return true;
+}
+
+Eigen::Array3i DicomImageReader::getDimensions() const
+{
+	Eigen::Array3i dim;
+	unsigned short rows = 0;
+	unsigned short columns = 0;
+	mDataset->findAndGetUint16(DCM_Rows, rows, 0, OFTrue);
+	mDataset->findAndGetUint16(DCM_Columns, columns, 0, OFTrue);
+	dim[0] = columns;
+	dim[1] = rows;
+	dim[2] = std::max(1, this->getNumberOfFrames());
+	return dim;
+}
+
+int DicomImageReader::getSamplesPerPixel() const
+{
+	unsigned short samplesPerPixel = 1;
+	mDataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel, 0, OFTrue);
+	return samplesPerPixel;
+}
+
+DicomSliceHeader DicomImageReader::getSliceHeader() const
+{
+	ctkDICOMItemPtr item = this->item();
+
+	DicomSliceHeader retval;
+	retval.filename = mFilename;
+	retval.patientId = item->GetElementAsString(DCM_PatientID);
+	retval.patientName = this->getPatientName();
+	retval.studyInstanceUid = item->GetElementAsString(DCM_StudyInstanceUID);
+	retval.studyDescription = item->GetElementAsString(DCM_StudyDescription);
+	retval.studyDate = item->GetElementAsString(DCM_StudyDate);
+	retval.seriesInstanceUid = item->GetElementAsString(DCM_SeriesInstanceUID);
+	retval.seriesDescription = item->GetElementAsString(DCM_SeriesDescription);
+	retval.seriesNumber = item->GetElementAsString(DCM_SeriesNumber);
+	retval.modality = item->GetElementAsString(DCM_Modality);
+	retval.localizer = this->isLocalizerImage();
+	retval.numberOfFrames = this->getNumberOfFrames();
+	retval.instanceNumber = item->GetElementAsInteger(DCM_InstanceNumber);
+	if (retval.numberOfFrames==0)
+		return retval;
+
+	retval.rMd = this->getImageTransformPatient();
+	retval.dim = this->getDimensions();
+	retval.spacing = this->getSpacing();
+	retval.samplesPerPixel = this->getSamplesPerPixel();
+	retval.windowLevel = this->getWindowLevel();
+	return retval;
 }
 
 Eigen::Array3d DicomImageReader::getSpacing() const
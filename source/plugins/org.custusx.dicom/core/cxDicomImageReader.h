@@ -52,8 +52,16 @@ public:
 
 public:
 	static DicomImageReaderPtr createFromFile(QString filename);
+	static DicomImageReaderPtr createHeaderFromFile(QString filename); ///< read header only, large elements such as pixel data are left on disk
+	static int getDecodedScalarType(QString filename); ///< VTK scalar type of the decoded pixel data, VTK_VOID on failure
+	static bool decodePixels(QString filename, void* dest, int scalarType, long count); ///< decode pixel data of a single-component image directly into dest, fail if not of scalarType
+	static int getVtkScalarType(EP_Representation representation);
 	Transform3D getImageTransformPatient() const;
 	vtkImageDataPtr createVtkImageData();
+	Eigen::Array3i getDimensions() const; ///< image dimensions, read from header tags
+	Eigen::Array3d getSpacing() const;
+	int getSamplesPerPixel() const;
+	struct DicomSliceHeader getSliceHeader() const;
 	ctkDICOMItemPtr item() const;
 	WindowLevel getWindowLevel() const;
 	int getNumberOfFrames() const;
@@ -66,8 +74,7 @@ private:
 	QString mFilename;
 
 	DicomImageReader();
-	bool loadFile(QString filename);
-	Eigen::Array3d getSpacing() const;
+	bool loadFile(QString filename, const DcmTagKey& stopParsingAtElement); ///< read elements up to stopParsingAtElement, or all if undefined
 	Eigen::Array3i getDim(const DicomImage& dicomImage) const;
 	void error(QString message) const;
 	double getDouble(const DcmTagKey& tag, const unsigned long pos=0, const OFBool searchIntoSub = OFFalse) const;
@@ -81,6 +88,35 @@ private:
 	double calculateMultiFrameSpacing(int frameIndex) const;
 };
 
+/** Header info for one dicom file, as needed for
+ *  browsing and importing series.
+ *
+ * \ingroup org.custusx.dicom
+ */
+struct org_custusx_dicom_EXPORT DicomSliceHeader
+{
+	DicomSliceHeader() : valid(false), localizer(false), numberOfFrames(0), samplesPerPixel(0), instanceNumber(0) {}
+	bool valid;
+	QString filename;
+	QString patientId;
+	QString patientName;
+	QString studyInstanceUid;
+	QString studyDescription;
+	QString studyDate;
+	QString seriesInstanceUid;
+	QString seriesDescription;
+	QString seriesNumber;
+	QString modality;
+	bool localizer;
+	int numberOfFrames;
+	Transform3D rMd;
+	Eigen::Array3i dim;
+	Eigen::Array3d spacing;
+	int samplesPerPixel;
+	int instanceNumber;
+	DicomImageReader::WindowLevel windowLevel;
+};
+
 
 } // namespace cx
 
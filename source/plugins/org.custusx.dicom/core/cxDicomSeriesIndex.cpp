@@ -0,0 +1,446 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxDicomSeriesIndex.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QDataStream>
+#include <QDateTime>
+#include <QtConcurrent>
+#include <set>
+#include <algorithm>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const char* indexMagic = "CXDCMIDX";
+const qint32 indexVersion = 1;
+
+void writeHeader(QDataStream& stream, const DicomSliceHeader& header)
+{
+	stream << header.valid;
+	stream << header.filename;
+	stream << header.patientId << header.patientName;
+	stream << header.studyInstanceUid << header.studyDescription << header.studyDate;
+	stream << header.seriesInstanceUid << header.seriesDescription << header.seriesNumber;
+	stream << header.modality;
+	stream << header.localizer << qint32(header.numberOfFrames);
+	for (int i=0; i<16; ++i)
+		stream << header.rMd.matrix().data()[i];
+	for (int i=0; i<3; ++i)
+		stream << qint32(header.dim[i]) << header.spacing[i];
+	stream << qint32(header.samplesPerPixel) << qint32(header.instanceNumber);
+	stream << header.windowLevel.center << header.windowLevel.width;
+}
+
+DicomSliceHeader readHeader(QDataStream& stream)
+{
+	DicomSliceHeader header;
+	qint32 val;
+	stream >> header.valid;
+	stream >> header.filename;
+	stream >> header.patientId >> header.patientName;
+	stream >> header.studyInstanceUid >> header.studyDescription >> header.studyDate;
+	stream >> header.seriesInstanceUid >> header.seriesDescription >> header.seriesNumber;
+	stream >> header.modality;
+	stream >> header.localizer >> val;
+	header.numberOfFrames = val;
+	for (int i=0; i<16; ++i)
+		stream >> header.rMd.matrix().data()[i];
+	for (int i=0; i<3; ++i)
+	{
+		stream >> val >> header.spacing[i];
+		header.dim[i] = val;
+	}
+	stream >> val;
+	header.samplesPerPixel = val;
+	stream >> val;
+	header.instanceNumber = val;
+	stream >> header.windowLevel.center >> header.windowLevel.width;
+	return header;
+}
+
+bool instanceNumberLessThan(const DicomSliceHeader& a, const DicomSliceHeader& b)
+{
+	if (a.instanceNumber != b.instanceNumber)
+		return a.instanceNumber < b.instanceNumber;
+	return a.filename < b.filename;
+}
+}
+
+DicomSeriesIndexPtr DicomSeriesIndex::create(QString indexFilename)
+{
+	DicomSeriesIndexPtr retval(new DicomSeriesIndex(indexFilename));
+	retval->load();
+	return retval;
+}
+
+DicomSeriesIndex::DicomSeriesIndex(QString indexFilename) :
+	mIndexFilename(indexFilename),
+	mMutex(QMutex::Recursive),
+	mSeriesValid(false)
+{
+}
+
+void DicomSeriesIndex::clear()
+{
+	QMutexLocker locker(&mMutex);
+	mFiles.clear();
+	mThumbnails.clear();
+	mSeries.clear();
+	mSeriesValid = false;
+}
+
+bool DicomSeriesIndex::load()
+{
+	QMutexLocker locker(&mMutex);
+	this->clear();
+
+	QFile file(mIndexFilename);
+	if (!file.exists())
+		return true;
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		reportWarning(QString("Failed to open dicom index %1").arg(mIndexFilename));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	QByteArray magic;
+	qint32 version;
+	stream >> magic >> version;
+	if (magic != indexMagic || version != indexVersion)
+	{
+		reportWarning(QString("Unknown dicom index format in %1, rebuilding.").arg(mIndexFilename));
+		return false;
+	}
+
+	quint32 numFiles;
+	stream >> numFiles;
+	for (quint32 i=0; i<numFiles && stream.status()==QDataStream::Ok; ++i)
+	{
+		FileEntry entry;
+		stream >> entry.lastModified >> entry.size;
+		entry.header = readHeader(stream);
+		mFiles[entry.header.filename] = entry;
+	}
+	mSeriesValid = false;
+
+	quint32 numThumbnails;
+	stream >> numThumbnails;
+	for (quint32 i=0; i<numThumbnails && stream.status()==QDataStream::Ok; ++i)
+	{
+		QString uid;
+		QImage thumbnail;
+		stream >> uid >> thumbnail;
+		mThumbnails[uid] = thumbnail;
+	}
+
+	if (stream.status()!=QDataStream::Ok)
+	{
+		reportWarning(QString("Corrupt dicom index %1, rebuilding.").arg(mIndexFilename));
+		this->clear();
+		return false;
+	}
+	return true;
+}
+
+bool DicomSeriesIndex::save() const
+{
+	QMutexLocker locker(&mMutex);
+	QDir().mkpath(QFileInfo(mIndexFilename).absolutePath());
+	QFile file(mIndexFilename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		reportWarning(QString("Failed to write dicom index %1").arg(mIndexFilename));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream << QByteArray(indexMagic) << indexVersion;
+
+	stream << quint32(mFiles.size());
+	for (FileMap::const_iterator iter=mFiles.begin(); iter!=mFiles.end(); ++iter)
+	{
+		stream << iter->second.lastModified << iter->second.size;
+		writeHeader(stream, iter->second.header);
+	}
+
+	stream << quint32(mThumbnails.size());
+	for (std::map<QString, QImage>::const_iterator iter=mThumbnails.begin(); iter!=mThumbnails.end(); ++iter)
+		stream << iter->first << iter->second;
+
+	return stream.status()==QDataStream::Ok;
+}
+
+/** Read the header tags, stopping before the pixel data.
+ *  Invalid headers are returned for non-dicom files and localizers.
+ */
+DicomSliceHeader DicomSeriesIndex::parseHeader(QString filename)
+{
+	DicomImageReaderPtr reader = DicomImageReader::createHeaderFromFile(filename);
+	if (!reader)
+	{
+		DicomSliceHeader retval;
+		retval.filename = filename;
+		return retval;
+	}
+
+	DicomSliceHeader retval = reader->getSliceHeader();
+	retval.valid = !retval.localizer && retval.numberOfFrames>0 && !retval.seriesInstanceUid.isEmpty();
+	return retval;
+}
+
+/** The directory is listed and the headers parsed without holding the
+ *  lock, so that the index can be read while a scan is running.
+ */
+DicomSeriesIndex::ScanResult DicomSeriesIndex::scanDirectory(QString directory)
+{
+	ScanResult result;
+	QString root = QDir(directory).absolutePath();
+
+	std::vector<QString> toParse;
+	std::vector<FileEntry> parsed;
+	std::set<QString> found;
+
+	std::vector<QFileInfo> files;
+	QDirIterator dirIter(root, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+	while (dirIter.hasNext())
+	{
+		dirIter.next();
+		files.push_back(dirIter.fileInfo());
+	}
+
+	{
+		QMutexLocker locker(&mMutex);
+		for (unsigned i=0; i<files.size(); ++i)
+		{
+			QString path = files[i].absoluteFilePath();
+			found.insert(path);
+
+			FileEntry entry;
+			entry.lastModified = files[i].lastModified().toMSecsSinceEpoch();
+			entry.size = files[i].size();
+
+			FileMap::iterator current = mFiles.find(path);
+			if (current!=mFiles.end() && current->second.lastModified==entry.lastModified && current->second.size==entry.size)
+				continue;
+
+			toParse.push_back(path);
+			parsed.push_back(entry);
+		}
+	}
+	result.filesFound = found.size();
+	result.filesParsed = toParse.size();
+
+	std::vector<int> indices(toParse.size());
+	for (unsigned i=0; i<indices.size(); ++i)
+		indices[i] = i;
+	QtConcurrent::blockingMap(indices, [&](int i)
+	{
+		parsed[i].header = parseHeader(toParse[i]);
+	});
+
+	QMutexLocker locker(&mMutex);
+	std::set<QString> changedSeries;
+	for (unsigned i=0; i<parsed.size(); ++i)
+	{
+		FileMap::iterator old = mFiles.find(toParse[i]);
+		if (old!=mFiles.end())
+			changedSeries.insert(old->second.header.seriesInstanceUid);
+		changedSeries.insert(parsed[i].header.seriesInstanceUid);
+		mFiles[toParse[i]] = parsed[i];
+	}
+
+	// remove entries for files deleted from this directory
+	QString prefix = root + "/";
+	for (FileMap::iterator iter=mFiles.begin(); iter!=mFiles.end(); )
+	{
+		if (iter->first.startsWith(prefix) && !found.count(iter->first))
+		{
+			changedSeries.insert(iter->second.header.seriesInstanceUid);
+			mFiles.erase(iter++);
+			++result.filesRemoved;
+		}
+		else
+			++iter;
+	}
+
+	for (std::set<QString>::iterator iter=changedSeries.begin(); iter!=changedSeries.end(); ++iter)
+		mThumbnails.erase(*iter);
+
+	if (result.filesParsed || result.filesRemoved)
+	{
+		mSeriesValid = false;
+		this->save();
+	}
+
+	return result;
+}
+
+/** Group the valid files into series. Only done after the index has changed.
+ *  Must be called with the lock held.
+ */
+const DicomSeriesIndex::SeriesMap& DicomSeriesIndex::updateSeries() const
+{
+	if (mSeriesValid)
+		return mSeries;
+
+	mSeries.clear();
+	for (FileMap::const_iterator iter=mFiles.begin(); iter!=mFiles.end(); ++iter)
+	{
+		const DicomSliceHeader& header = iter->second.header;
+		if (!header.valid)
+			continue;
+
+		Series& current = mSeries[header.seriesInstanceUid];
+		if (current.slices.empty())
+		{
+			current.seriesInstanceUid = header.seriesInstanceUid;
+			current.seriesDescription = header.seriesDescription;
+			current.seriesNumber = header.seriesNumber;
+			current.modality = header.modality;
+			current.patientId = header.patientId;
+			current.patientName = header.patientName;
+			current.studyInstanceUid = header.studyInstanceUid;
+			current.studyDescription = header.studyDescription;
+			current.studyDate = header.studyDate;
+			current.dim = header.dim;
+			current.dim[2] = 0;
+			current.spacing = header.spacing;
+		}
+		current.slices.push_back(header);
+		current.dim[2] += header.dim[2];
+	}
+
+	for (SeriesMap::iterator iter=mSeries.begin(); iter!=mSeries.end(); ++iter)
+		std::sort(iter->second.slices.begin(), iter->second.slices.end(), instanceNumberLessThan);
+	mSeriesValid = true;
+	return mSeries;
+}
+
+std::vector<DicomSeriesIndex::Series> DicomSeriesIndex::getSeries() const
+{
+	QMutexLocker locker(&mMutex);
+	const SeriesMap& series = this->updateSeries();
+	std::vector<Series> retval;
+	for (SeriesMap::const_iterator iter=series.begin(); iter!=series.end(); ++iter)
+		retval.push_back(iter->second);
+	return retval;
+}
+
+DicomSeriesIndex::Series DicomSeriesIndex::getSeries(QString seriesInstanceUid) const
+{
+	QMutexLocker locker(&mMutex);
+	const SeriesMap& series = this->updateSeries();
+	SeriesMap::const_iterator iter = series.find(seriesInstanceUid);
+	if (iter==series.end())
+		return Series();
+	return iter->second;
+}
+
+int DicomSeriesIndex::getNumberOfIndexedFiles() const
+{
+	QMutexLocker locker(&mMutex);
+	return mFiles.size();
+}
+
+QImage DicomSeriesIndex::getCachedThumbnail(QString seriesInstanceUid) const
+{
+	QMutexLocker locker(&mMutex);
+	std::map<QString, QImage>::const_iterator iter = mThumbnails.find(seriesInstanceUid);
+	if (iter==mThumbnails.end())
+		return QImage();
+	return iter->second;
+}
+
+/** Return the middle slice of the series the thumbnail is generated from,
+ *  and its file entry. Must be called with the lock held.
+ */
+QString DicomSeriesIndex::getThumbnailFile(QString seriesInstanceUid, FileEntry* entry) const
+{
+	const SeriesMap& series = this->updateSeries();
+	SeriesMap::const_iterator iter = series.find(seriesInstanceUid);
+	if (iter==series.end() || iter->second.slices.empty())
+		return "";
+	const std::vector<DicomSliceHeader>& slices = iter->second.slices;
+	QString filename = slices[slices.size()/2].filename;
+
+	FileMap::const_iterator file = mFiles.find(filename);
+	if (file==mFiles.end())
+		return "";
+	*entry = file->second;
+	return filename;
+}
+
+/** The pixel data is decoded without holding the lock. The thumbnail is
+ *  cached only if the series still has the same middle slice file when
+ *  done, i.e. if no scan replaced it meanwhile.
+ */
+QImage DicomSeriesIndex::getThumbnail(QString seriesInstanceUid)
+{
+	QString filename;
+	FileEntry entry;
+	{
+		QMutexLocker locker(&mMutex);
+		if (mThumbnails.count(seriesInstanceUid))
+			return mThumbnails[seriesInstanceUid];
+		filename = this->getThumbnailFile(seriesInstanceUid, &entry);
+		if (filename.isEmpty())
+			return QImage();
+	}
+
+	QImage thumbnail = generateThumbnail(filename);
+
+	QMutexLocker locker(&mMutex);
+	FileEntry current;
+	QString currentFilename = this->getThumbnailFile(seriesInstanceUid, &current);
+	if (currentFilename==filename && current.lastModified==entry.lastModified && current.size==entry.size)
+		mThumbnails[seriesInstanceUid] = thumbnail;
+	return thumbnail;
+}
+
+/** Render a 128x128 grayscale thumbnail using the first window in the image,
+ *  or min/max if none. This is the only place the index reads pixel data.
+ */
+QImage DicomSeriesIndex::generateThumbnail(QString filename)
+{
+	DicomImage dicomImage(filename.toLatin1().data());
+	if (dicomImage.getStatus()!=EIS_Normal || !dicomImage.isMonochrome())
+		return QImage();
+
+	if (dicomImage.getWindowCount() > 0)
+		dicomImage.setWindow(0);
+	else
+		dicomImage.setMinMaxWindow(OFTrue /* ignore extreme values */);
+
+	int width = dicomImage.getWidth();
+	int height = dicomImage.getHeight();
+	QImage image(width, height, QImage::Format_Indexed8);
+	for (int i=0; i<256; ++i)
+		image.setColor(i, qRgb(i,i,i));
+
+	std::vector<uchar> buffer(width*height);
+	if (!dicomImage.getOutputData(&*buffer.begin(), buffer.size(), 8, 0))
+		return QImage();
+	for (int y=0; y<height; ++y)
+		memcpy(image.scanLine(y), &buffer[y*width], width);
+
+	return image.scaled(128, 128, Qt::KeepAspectRatio);
+}
+
+} /* namespace cx */
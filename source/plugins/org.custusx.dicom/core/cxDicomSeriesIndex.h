@@ -0,0 +1,110 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXDICOMSERIESINDEX_H_
+#define CXDICOMSERIESINDEX_H_
+
+#include "org_custusx_dicom_Export.h"
+
+#include <map>
+#include <vector>
+#include <QImage>
+#include <QMutex>
+#include "cxDicomImageReader.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class DicomSeriesIndex> DicomSeriesIndexPtr;
+
+/**
+ * Persistent index of the dicom tags needed to browse and import series.
+ *
+ * Files are parsed in parallel, header only, and the result is stored
+ * keyed on file path + modification time + size. A rescan of a folder
+ * only parses new or changed files. Series can then be listed and
+ * converted (see DicomConverter::convertSlicesToImage()) without
+ * rereading any headers.
+ *
+ * Non-dicom files are remembered as invalid entries, so that they
+ * are not reparsed either.
+ *
+ * All methods are thread safe. scanDirectory() and getThumbnail() read
+ * files and are meant to be called from a worker thread, the list of
+ * series is built once per change of the index.
+ *
+ * \ingroup org_custusx_dicom
+ */
+class org_custusx_dicom_EXPORT DicomSeriesIndex
+{
+public:
+	struct Series
+	{
+		Series() : dim(0,0,0), spacing(0,0,0) {}
+		QString seriesInstanceUid;
+		QString seriesDescription;
+		QString seriesNumber;
+		QString modality;
+		QString patientId;
+		QString patientName;
+		QString studyInstanceUid;
+		QString studyDescription;
+		QString studyDate;
+		Eigen::Array3i dim; ///< dim[2] is the number of slices
+		Eigen::Array3d spacing; ///< in-plane spacing only
+		std::vector<DicomSliceHeader> slices; ///< sorted on instance number
+	};
+	struct ScanResult
+	{
+		ScanResult() : filesFound(0), filesParsed(0), filesRemoved(0) {}
+		int filesFound;
+		int filesParsed; ///< new or changed files
+		int filesRemoved;
+	};
+
+	static DicomSeriesIndexPtr create(QString indexFilename);
+	explicit DicomSeriesIndex(QString indexFilename);
+
+	bool load();
+	bool save() const;
+	void clear();
+
+	ScanResult scanDirectory(QString directory);
+	std::vector<Series> getSeries() const;
+	Series getSeries(QString seriesInstanceUid) const;
+	QImage getThumbnail(QString seriesInstanceUid); ///< generated from the middle slice on first request, then cached
+	QImage getCachedThumbnail(QString seriesInstanceUid) const; ///< null if not generated yet
+	int getNumberOfIndexedFiles() const;
+
+private:
+	struct FileEntry
+	{
+		qint64 lastModified;
+		qint64 size;
+		DicomSliceHeader header;
+	};
+	typedef std::map<QString, FileEntry> FileMap;
+	typedef std::map<QString, Series> SeriesMap;
+
+	static DicomSliceHeader parseHeader(QString filename);
+	static QImage generateThumbnail(QString filename);
+	const SeriesMap& updateSeries() const;
+	QString getThumbnailFile(QString seriesInstanceUid, FileEntry* entry) const;
+
+	QString mIndexFilename;
+	mutable QMutex mMutex;
+	FileMap mFiles;
+	std::map<QString, QImage> mThumbnails;
+	mutable SeriesMap mSeries; ///< series in mFiles, keyed on uid
+	mutable bool mSeriesValid;
+};
+
+} /* namespace cx */
+#endif /* CXDICOMSERIESINDEX_H_ */
@@ -30,6 +30,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDicomWidget.h"
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxDicomSeriesIndex.h"
+#include "cxDicomImageReader.h"
+#include "dcuid.h"
+#include <QTime>
 
 typedef vtkSmartPointer<vtkImageAccumulate> vtkImageAccumulatePtr;
 typedef vtkSmartPointer<vtkImageMathematics> vtkImageMathematicsPtr;
@@ -132,6 +136,63 @@ public:
 		return DICOMDatabase;
 	}
 
+	/** Write a synthetic CT series, one file per slice, with filenames in
+	 *  reverse slice order. Unsigned pixels use the full 16 bit range.
+	 */
+	QStringList writeSyntheticSeries(QString folder, Eigen::Array3i dim, bool unsignedPixels=false)
+	{
+		QDir(folder).removeRecursively();
+		QDir().mkpath(folder);
+
+		char studyUid[100];
+		char seriesUid[100];
+		dcmGenerateUniqueIdentifier(studyUid, SITE_STUDY_UID_ROOT);
+		dcmGenerateUniqueIdentifier(seriesUid, SITE_SERIES_UID_ROOT);
+
+		QStringList retval;
+		std::vector<Sint16> pixels(dim[0]*dim[1]);
+		for (int z=0; z<dim[2]; ++z)
+		{
+			char instanceUid[100];
+			dcmGenerateUniqueIdentifier(instanceUid, SITE_INSTANCE_UID_ROOT);
+
+			DcmFileFormat fileformat;
+			DcmDataset* dataset = fileformat.getDataset();
+			dataset->putAndInsertString(DCM_SOPClassUID, UID_CTImageStorage);
+			dataset->putAndInsertString(DCM_SOPInstanceUID, instanceUid);
+			dataset->putAndInsertString(DCM_StudyInstanceUID, studyUid);
+			dataset->putAndInsertString(DCM_SeriesInstanceUID, seriesUid);
+			dataset->putAndInsertString(DCM_PatientName, "Synthetic^Series");
+			dataset->putAndInsertString(DCM_PatientID, "synthetic");
+			dataset->putAndInsertString(DCM_Modality, "CT");
+			dataset->putAndInsertString(DCM_SeriesDescription, "synthetic");
+			dataset->putAndInsertString(DCM_SeriesNumber, "1");
+			dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+			dataset->putAndInsertString(DCM_ImagePositionPatient, QString("-10\\20\\%1").arg(0.75*z).toLatin1().data());
+			dataset->putAndInsertString(DCM_PixelSpacing, "0.5\\0.5");
+			dataset->putAndInsertString(DCM_WindowCenter, QString::number(40+z).toLatin1().data());
+			dataset->putAndInsertString(DCM_WindowWidth, "400");
+			dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+			dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+			dataset->putAndInsertUint16(DCM_Rows, dim[1]);
+			dataset->putAndInsertUint16(DCM_Columns, dim[0]);
+			dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+			dataset->putAndInsertUint16(DCM_BitsStored, 16);
+			dataset->putAndInsertUint16(DCM_HighBit, 15);
+			dataset->putAndInsertUint16(DCM_PixelRepresentation, unsignedPixels ? 0 : 1);
+
+			for (int y=0; y<dim[1]; ++y)
+				for (int x=0; x<dim[0]; ++x)
+					pixels[y*dim[0]+x] = unsignedPixels ? Sint16(Uint16(60000 + x + 2*y - 3*z)) : Sint16(x + 2*y - 3*z - 1000);
+			dataset->putAndInsertUint16Array(DCM_PixelData, reinterpret_cast<Uint16*>(&*pixels.begin()), pixels.size());
+
+			QString filename = QString("%1/slice_%2.dcm").arg(folder).arg(dim[2]-z, 4, 10, QChar('0'));
+			REQUIRE(fileformat.saveFile(filename.toLatin1().data(), EXS_LittleEndianExplicit).good());
+			retval << filename;
+		}
+		return retval;
+	}
+
 	QString getOneFromList(QStringList strings)
 	{
 		REQUIRE(strings.size()==1);
@@ -366,6 +427,159 @@ TEST_CASE("DicomConverter: US data from SW, missing position data", "[integratio
 }
 #endif
 
+TEST_CASE("DicomConverter: Slice-level threaded conversion equals serial conversion", "[unit][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+	QString folder = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_small";
+	QStringList files = fixture.writeSyntheticSeries(folder, Eigen::Array3i(32, 24, 10));
+
+	cx::DicomConverter serial;
+	serial.setUseSliceLevelThreading(false);
+	cx::ImagePtr serialImage = serial.convertFilesToImage(files);
+
+	cx::DicomConverter threaded;
+	cx::ImagePtr threadedImage = threaded.convertFilesToImage(files);
+
+	REQUIRE(threadedImage);
+	CHECK(Eigen::Array3i(threadedImage->getBaseVtkImageData()->GetDimensions()).isApprox(Eigen::Array3i(32, 24, 10)));
+	CHECK(cx::similar(threadedImage->getSpacing(), cx::Vector3D(0.5, 0.5, 0.75)));
+	CHECK(cx::similar(threadedImage->getInitialWindowLevel(), 45));
+	fixture.checkImagesEqual(threadedImage, serialImage);
+
+	QDir(folder).removeRecursively();
+	cx::Reporter::shutdown();
+}
+
+TEST_CASE("DicomConverter: Slice-level threaded conversion keeps unsigned 16 bit values", "[unit][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+	QString folder = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_unsigned";
+	QStringList files = fixture.writeSyntheticSeries(folder, Eigen::Array3i(32, 24, 10), true);
+
+	cx::DicomConverter serial;
+	serial.setUseSliceLevelThreading(false);
+	cx::ImagePtr serialImage = serial.convertFilesToImage(files);
+
+	cx::DicomConverter threaded;
+	cx::ImagePtr threadedImage = threaded.convertFilesToImage(files);
+
+	REQUIRE(threadedImage);
+	REQUIRE(serialImage);
+	vtkImageDataPtr data = threadedImage->getBaseVtkImageData();
+	CHECK(data->GetScalarType() == VTK_UNSIGNED_SHORT);
+	CHECK(serialImage->getBaseVtkImageData()->GetScalarType() == VTK_UNSIGNED_SHORT);
+	// slice z has its minimum 60000-3z at voxel (0,0,z), sorted along z
+	CHECK(data->GetScalarComponentAsDouble(0, 0, 0, 0) == Approx(60000));
+	CHECK(data->GetScalarRange()[1] == Approx(60000 + 31 + 2*23));
+	fixture.checkImagesEqual(threadedImage, serialImage);
+
+	QDir(folder).removeRecursively();
+	cx::Reporter::shutdown();
+}
+
+TEST_CASE("DicomConverter: Header reader reads long elements before the pixel data", "[unit][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+	QString folder = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_header";
+	QString filename = fixture.getOneFromList(fixture.writeSyntheticSeries(folder, Eigen::Array3i(32, 24, 1)));
+
+	QString comment(3000, QChar('x'));
+	DcmFileFormat fileformat;
+	REQUIRE(fileformat.loadFile(filename.toLatin1().data()).good());
+	fileformat.getDataset()->putAndInsertString(DCM_ImageComments, comment.toLatin1().data());
+	REQUIRE(fileformat.saveFile(filename.toLatin1().data(), EXS_LittleEndianExplicit).good());
+
+	cx::DicomImageReaderPtr reader = cx::DicomImageReader::createHeaderFromFile(filename);
+	REQUIRE(reader);
+	CHECK(reader->item()->GetElementAsString(DCM_ImageComments) == comment);
+	CHECK(reader->getDimensions().isApprox(Eigen::Array3i(32, 24, 1)));
+
+	QDir(folder).removeRecursively();
+	cx::Reporter::shutdown();
+}
+
+TEST_CASE("Speed: DicomConverter slice-level threaded vs serial conversion", "[speed][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+	QString folder = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_large";
+	QStringList files = fixture.writeSyntheticSeries(folder, Eigen::Array3i(512, 512, 300));
+
+	QTime clock;
+	cx::DicomConverter serial;
+	serial.setUseSliceLevelThreading(false);
+	clock.start();
+	cx::ImagePtr serialImage = serial.convertFilesToImage(files);
+	int serialMs = clock.elapsed();
+
+	cx::DicomConverter threaded;
+	clock.start();
+	cx::ImagePtr threadedImage = threaded.convertFilesToImage(files);
+	int threadedMs = clock.elapsed();
+
+	std::cout << "Convert " << files.size() << " slices, serial: " << serialMs << " ms, slice-level threading: " << threadedMs << " ms" << std::endl;
+
+	fixture.checkImagesEqual(threadedImage, serialImage);
+
+	QDir(folder).removeRecursively();
+	cx::Reporter::shutdown();
+}
+
+TEST_CASE("DicomSeriesIndex: Index is persistent and rescans only new files", "[unit][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+	QString folder = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_index";
+	QString indexFilename = cx::DataLocations::getTestDataPath()+"/temp/synthetic_dicom_index.bin";
+	QFile(indexFilename).remove();
+	QStringList files = fixture.writeSyntheticSeries(folder+"/series", Eigen::Array3i(32, 24, 10));
+	QFile nonDicom(folder+"/readme.txt");
+	nonDicom.open(QIODevice::WriteOnly);
+	nonDicom.write("not a dicom file");
+	nonDicom.close();
+
+	{
+		cx::DicomSeriesIndexPtr index = cx::DicomSeriesIndex::create(indexFilename);
+		cx::DicomSeriesIndex::ScanResult result = index->scanDirectory(folder);
+		CHECK(result.filesFound == 11);
+		CHECK(result.filesParsed == 11);
+
+		std::vector<cx::DicomSeriesIndex::Series> series = index->getSeries();
+		REQUIRE(series.size() == 1);
+		CHECK(series[0].modality == "CT");
+		CHECK(series[0].slices.size() == 10);
+		CHECK(series[0].dim.isApprox(Eigen::Array3i(32, 24, 10)));
+		CHECK(index->getCachedThumbnail(series[0].seriesInstanceUid).isNull());
+		CHECK(!index->getThumbnail(series[0].seriesInstanceUid).isNull());
+		CHECK(!index->getCachedThumbnail(series[0].seriesInstanceUid).isNull());
+	}
+
+	{
+		cx::DicomSeriesIndexPtr index = cx::DicomSeriesIndex::create(indexFilename);
+		CHECK(index->getNumberOfIndexedFiles() == 11);
+		QFile(files.front()).remove();
+		cx::DicomSeriesIndex::ScanResult result = index->scanDirectory(folder);
+		CHECK(result.filesParsed == 0);
+		CHECK(result.filesRemoved == 1);
+
+		std::vector<cx::DicomSeriesIndex::Series> series = index->getSeries();
+		REQUIRE(series.size() == 1);
+		CHECK(series[0].slices.size() == 9);
+
+		cx::DicomConverter converter;
+		cx::ImagePtr image = converter.convertSlicesToImage(series[0].slices);
+		REQUIRE(image);
+		CHECK(image->getBaseVtkImageData()->GetDimensions()[2] == 9);
+	}
+
+	QDir(folder).removeRecursively();
+	QFile(indexFilename).remove();
+	cx::Reporter::shutdown();
+}
+
 TEST_CASE("DicomConverter: Auto delete database", "[integration][plugins][org.custusx.dicom]")
 {
 	cx::DataLocations::setTestMode();
@@ -0,0 +1,200 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxDicomSeriesIndexWidget.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QLabel>
+#include <QFileDialog>
+#include <QtConcurrent>
+#include <functional>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+DicomSeriesIndexWidget::DicomSeriesIndexWidget(DicomSeriesIndexPtr index, QWidget* parent) :
+	QWidget(parent),
+	mIndex(index)
+{
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	layout->setMargin(0);
+
+	QHBoxLayout* buttonLayout = new QHBoxLayout;
+	mScanButton = new QPushButton("Scan folder...", this);
+	mScanButton->setToolTip("Index all DICOM files in a folder. Only new or changed files are read.");
+	connect(mScanButton, SIGNAL(clicked()), this, SLOT(onScanFolder()));
+	QPushButton* importButton = new QPushButton("Import selected", this);
+	importButton->setToolTip("Import the selected series into the application as a volume");
+	connect(importButton, SIGNAL(clicked()), this, SLOT(onImport()));
+	mStatus = new QLabel(this);
+	buttonLayout->addWidget(mScanButton);
+	buttonLayout->addWidget(importButton);
+	buttonLayout->addWidget(mStatus, 1);
+	layout->addLayout(buttonLayout);
+
+	mTable = new QTableWidget(this);
+	mTable->setColumnCount(6);
+	mTable->setHorizontalHeaderLabels(QStringList() << "" << "Patient" << "Study" << "Series" << "Modality" << "Dimensions");
+	mTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+	mTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	mTable->setIconSize(QSize(64, 64));
+	mTable->verticalHeader()->hide();
+	mTable->horizontalHeader()->setStretchLastSection(true);
+	connect(mTable, SIGNAL(cellDoubleClicked(int,int)), this, SLOT(onImport()));
+	layout->addWidget(mTable, 1);
+
+	connect(&mScanWatcher, SIGNAL(finished()), this, SLOT(scanFinishedSlot()));
+	connect(&mThumbnailWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(thumbnailReadySlot(int)));
+	connect(&mThumbnailWatcher, SIGNAL(finished()), this, SLOT(thumbnailsFinishedSlot()));
+
+	this->updateTable();
+}
+
+DicomSeriesIndexWidget::~DicomSeriesIndexWidget()
+{
+	this->stopThumbnails();
+	mScanWatcher.waitForFinished();
+}
+
+void DicomSeriesIndexWidget::onScanFolder()
+{
+	QString folder = QFileDialog::getExistingDirectory(this, "Scan DICOM files in directory ...", "", QFileDialog::ShowDirsOnly);
+	if (!folder.isEmpty())
+		this->scanDirectory(folder);
+}
+
+void DicomSeriesIndexWidget::scanDirectory(QString directory)
+{
+	if (mScanWatcher.isRunning())
+		return;
+
+	mScanButton->setEnabled(false);
+	mStatus->setText(QString("Scanning %1 ...").arg(directory));
+	mScanClock.start();
+	DicomSeriesIndexPtr index = mIndex;
+	mScanWatcher.setFuture(QtConcurrent::run([index, directory]()
+	{
+		return index->scanDirectory(directory);
+	}));
+}
+
+void DicomSeriesIndexWidget::scanFinishedSlot()
+{
+	DicomSeriesIndex::ScanResult result = mScanWatcher.result();
+	mScanButton->setEnabled(true);
+
+	QString message = QString("Scanned %1 files in %2 s, %3 new or changed, %4 removed")
+			.arg(result.filesFound)
+			.arg(mScanClock.elapsed()/1000.0, 0, 'f', 1)
+			.arg(result.filesParsed)
+			.arg(result.filesRemoved);
+	mStatus->setText(message);
+	CX_LOG_CHANNEL_INFO("dicom") << message;
+
+	this->updateTable();
+}
+
+void DicomSeriesIndexWidget::stopThumbnails()
+{
+	mThumbnailWatcher.cancel();
+	mThumbnailWatcher.waitForFinished();
+}
+
+/** Fill the table using cached thumbnails, and generate the missing
+ *  ones in the background.
+ */
+void DicomSeriesIndexWidget::updateTable()
+{
+	this->stopThumbnails();
+	std::vector<DicomSeriesIndex::Series> series = mIndex->getSeries();
+	QStringList missing;
+	mRows.clear();
+
+	mTable->setRowCount(series.size());
+	for (unsigned i=0; i<series.size(); ++i)
+	{
+		const DicomSeriesIndex::Series& current = series[i];
+
+		QTableWidgetItem* thumbnail = new QTableWidgetItem;
+		QImage image = mIndex->getCachedThumbnail(current.seriesInstanceUid);
+		if (image.isNull())
+			missing << current.seriesInstanceUid;
+		else
+			thumbnail->setIcon(QIcon(QPixmap::fromImage(image)));
+		thumbnail->setData(Qt::UserRole, current.seriesInstanceUid);
+		mTable->setItem(i, 0, thumbnail);
+		mRows[current.seriesInstanceUid] = i;
+		mTable->setItem(i, 1, new QTableWidgetItem(current.patientName));
+		mTable->setItem(i, 2, new QTableWidgetItem(QString("%1 %2").arg(current.studyDate).arg(current.studyDescription)));
+		mTable->setItem(i, 3, new QTableWidgetItem(QString("%1: %2").arg(current.seriesNumber).arg(current.seriesDescription)));
+		mTable->setItem(i, 4, new QTableWidgetItem(current.modality));
+		mTable->setItem(i, 5, new QTableWidgetItem(QString("%1x%2x%3").arg(current.dim[0]).arg(current.dim[1]).arg(current.dim[2])));
+		mTable->setRowHeight(i, 68);
+	}
+	mTable->resizeColumnsToContents();
+
+	if (missing.empty())
+		return;
+	DicomSeriesIndexPtr index = mIndex;
+	std::function<QString(const QString&)> generate = [index](const QString& uid)
+	{
+		index->getThumbnail(uid);
+		return uid;
+	};
+	mThumbnailWatcher.setFuture(QtConcurrent::mapped(missing, generate));
+}
+
+void DicomSeriesIndexWidget::thumbnailReadySlot(int index)
+{
+	QString uid = mThumbnailWatcher.resultAt(index);
+	std::map<QString, int>::iterator row = mRows.find(uid);
+	if (row==mRows.end())
+		return;
+	QTableWidgetItem* item = mTable->item(row->second, 0);
+	if (item)
+		item->setIcon(QIcon(QPixmap::fromImage(mIndex->getCachedThumbnail(uid))));
+}
+
+void DicomSeriesIndexWidget::thumbnailsFinishedSlot()
+{
+	if (!mThumbnailWatcher.isCanceled())
+		mIndex->save(); // store generated thumbnails
+}
+
+QStringList DicomSeriesIndexWidget::getSelectedSeries() const
+{
+	QStringList retval;
+	QList<QTableWidgetItem*> items = mTable->selectedItems();
+	for (int i=0; i<items.size(); ++i)
+	{
+		QString uid = mTable->item(items[i]->row(), 0)->data(Qt::UserRole).toString();
+		if (!retval.contains(uid))
+			retval << uid;
+	}
+	return retval;
+}
+
+void DicomSeriesIndexWidget::onImport()
+{
+	QStringList series = this->getSelectedSeries();
+	if (series.empty())
+		CX_LOG_CHANNEL_WARNING("dicom") << "No DICOM series selected, import failed.";
+
+	for (int i=0; i<series.size(); ++i)
+		emit importSeries(series[i]);
+}
+
+} /* namespace cx */
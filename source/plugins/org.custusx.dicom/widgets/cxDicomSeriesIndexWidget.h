@@ -0,0 +1,77 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXDICOMSERIESINDEXWIDGET_H_
+#define CXDICOMSERIESINDEXWIDGET_H_
+
+#include "org_custusx_dicom_Export.h"
+
+#include <map>
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QTime>
+#include "cxDicomSeriesIndex.h"
+class QTableWidget;
+class QLabel;
+class QPushButton;
+
+namespace cx
+{
+
+/**
+ * Lists the series found in a DicomSeriesIndex, with thumbnails.
+ *
+ * Scanning a folder only parses new or changed files, and the listed
+ * series can be imported without rereading the headers.
+ *
+ * Scanning and thumbnail decoding run on worker threads. The table is
+ * shown immediately, and thumbnails are filled in as they are ready.
+ *
+ * \ingroup org_custusx_dicom
+ */
+class org_custusx_dicom_EXPORT DicomSeriesIndexWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	DicomSeriesIndexWidget(DicomSeriesIndexPtr index, QWidget* parent=0);
+	virtual ~DicomSeriesIndexWidget();
+	QStringList getSelectedSeries() const;
+
+public slots:
+	void scanDirectory(QString directory); ///< start scanning in the background
+	void updateTable();
+
+signals:
+	void importSeries(QString seriesInstanceUid);
+
+private slots:
+	void onScanFolder();
+	void onImport();
+	void scanFinishedSlot();
+	void thumbnailReadySlot(int index);
+	void thumbnailsFinishedSlot();
+
+private:
+	void stopThumbnails();
+
+	DicomSeriesIndexPtr mIndex;
+	QTableWidget* mTable;
+	QLabel* mStatus;
+	QPushButton* mScanButton;
+	QTime mScanClock;
+	QFutureWatcher<DicomSeriesIndex::ScanResult> mScanWatcher;
+	QFutureWatcher<QString> mThumbnailWatcher; ///< results are uids with a generated thumbnail
+	std::map<QString, int> mRows; ///< table row of each series uid
+};
+
+} /* namespace cx */
+
+#endif /* CXDICOMSERIESINDEXWIDGET_H_ */
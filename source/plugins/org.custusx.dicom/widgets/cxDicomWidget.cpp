@@ -24,6 +24,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxProfile.h"
 #include "cxTypeConversions.h"
 #include "cxDicomConverter.h"
+#include "cxDicomSeriesIndex.h"
+#include "cxDicomSeriesIndexWidget.h"
 #include "cxLogger.h"
 
 #include "cxPatientModelService.h"
@@ -40,6 +42,7 @@ DicomWidget::DicomWidget(ctkPluginContext *context, QWidget *parent) :
 	mVerticalLayout(new QVBoxLayout(this)),
 	mBrowser(NULL),
 	mContext(context),
+	mSeriesIndexWidget(NULL),
 	mDicomShowAdvancedSettingsString("Dicom/ShowAdvanced")
 {
 	this->setModified();
@@ -81,9 +84,16 @@ void DicomWidget::createUI()
 										"Advanced", "Toggle advanced options",
 										SLOT(toggleDetailsSlot()));
 
+	mSeriesIndexAction = this->createAction(this,
+										QIcon(":/icons/open_icon_library/document-open-7.png"),
+										"Quick browse", "Toggle fast series browsing using a header-only index of DICOM folders",
+										SLOT(toggleSeriesIndexSlot()));
+	mSeriesIndexAction->setCheckable(true);
+
 	mBrowser = new DICOMAppWidget;
 	mBrowser->addActionToToolbar(mViewHeaderAction);
 	mBrowser->addActionToToolbar(mImportIntoCustusXAction);
+	mBrowser->addActionToToolbar(mSeriesIndexAction);
 	mBrowser->addActionToToolbar(mDetailsAction);
 	this->showOrHideDetails();
 
@@ -91,6 +101,33 @@ void DicomWidget::createUI()
 	mVerticalLayout->addWidget(mBrowser);
 
 	this->setupDatabaseDirectory();
+
+	mSeriesIndex = DicomSeriesIndex::create(this->getDICOMDatabaseDirectory() + "/seriesIndex.bin");
+	mSeriesIndexWidget = new DicomSeriesIndexWidget(mSeriesIndex, this);
+	connect(mSeriesIndexWidget, &DicomSeriesIndexWidget::importSeries, this, &DicomWidget::importIndexedSeries);
+	mSeriesIndexWidget->setVisible(false);
+	mVerticalLayout->addWidget(mSeriesIndexWidget);
+}
+
+void DicomWidget::toggleSeriesIndexSlot()
+{
+	mSeriesIndexWidget->setVisible(mSeriesIndexAction->isChecked());
+}
+
+void DicomWidget::importIndexedSeries(QString seriesInstanceUid)
+{
+	DicomSeriesIndex::Series series = mSeriesIndex->getSeries(seriesInstanceUid);
+
+	cx::DicomConverter converter;
+	cx::ImagePtr convertedImage = converter.convertSlicesToImage(series.slices);
+
+	if (!convertedImage)
+	{
+		reportError(QString("Failed to convert DICOM series %1").arg(seriesInstanceUid));
+		return;
+	}
+
+	this->loadIntoPatientModel(convertedImage, seriesInstanceUid);
 }
 
 void DicomWidget::toggleDetailsSlot()
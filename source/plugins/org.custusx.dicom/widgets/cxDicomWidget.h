@@ -25,7 +25,9 @@ class ctkDICOMDatabase;
 namespace cx
 {
 class DICOMAppWidget;
+class DicomSeriesIndexWidget;
 typedef boost::shared_ptr<class Image> ImagePtr;
+typedef boost::shared_ptr<class DicomSeriesIndex> DicomSeriesIndexPtr;
 
 /**
  * Widget for dicom interaction
@@ -52,6 +54,8 @@ private slots:
     void onImportIntoCustusXAction();
     void deleteDICOMDB();
 	void toggleDetailsSlot();
+	void toggleSeriesIndexSlot();
+	void importIndexedSeries(QString seriesInstanceUid);
 
 private:
     virtual QSize sizeHint () const { return QSize(600, 100);};///< Define a recommended size
@@ -61,6 +65,9 @@ private:
 	QAction* mViewHeaderAction;
 	QAction* mImportIntoCustusXAction;
 	QAction* mDetailsAction;
+	QAction* mSeriesIndexAction;
+	DicomSeriesIndexPtr mSeriesIndex;
+	DicomSeriesIndexWidget* mSeriesIndexWidget;
 	QString mDicomShowAdvancedSettingsString;
 	void createUI();
 	void setupDatabaseDirectory();
@@ -20,10 +20,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 typedef boost::shared_ptr<class Data> DataPtr;
+typedef boost::shared_ptr<class FrameForest> FrameForestPtr;
 
 /**
  * Algorithms for applying registration to backend
  *
+ * Pass a FrameForest kept between registrations to avoid rebuilding it.
+ *
  * \ingroup org_custusx_registration
  *
  *  \date 2014-08-28
@@ -33,13 +36,14 @@ class org_custusx_registration_EXPORT RegistrationApplicator
 {
 public:
 
-  RegistrationApplicator(const std::map<QString, DataPtr>& source);
+  RegistrationApplicator(const std::map<QString, DataPtr>& source, FrameForestPtr forest = FrameForestPtr());
   ~RegistrationApplicator();
 
   virtual void updateRegistration(QDateTime oldTime, RegistrationTransform deltaTransform);
 
 private:
   std::map<QString, DataPtr> mSource;
+  FrameForestPtr mForest;
   void changeParentSpace(QDateTime oldTime, std::vector<DataPtr> data, QString oldParentSpace, ParentSpace newParentSpace);
   void updateTransform(QDateTime oldTime, std::vector<DataPtr> data, RegistrationTransform delta_pre_rMd);
   void changeParentSpace(QDateTime oldTime, DataPtr data, ParentSpace newParentSpace);
@@ -42,6 +42,7 @@ RegistrationImplService::RegistrationImplService(ctkPluginContext *context) :
 	connect(mSession.get(), &SessionStorageService::cleared, this, &RegistrationImplService::clearSlot);
     connect(mSession.get(), &SessionStorageService::isLoadingSecond, this, &RegistrationImplService::duringLoadPatientSlot);
 	connect(mSession.get(), &SessionStorageService::isSaving, this, &RegistrationImplService::duringSavePatientSlot);
+	connect(mPatientModelService.get(), &PatientModelService::dataAddedOrRemoved, this, &RegistrationImplService::dataAddedOrRemovedSlot);
 }
 
 RegistrationImplService::~RegistrationImplService()
@@ -99,6 +100,15 @@ void RegistrationImplService::clearSlot()
 {
 	this->setLastRegistrationTime(QDateTime());
 	this->setFixedData(DataPtr());
+	mFrameForest.reset();
+}
+
+/** Keep the forest in sync with the patient, so that it drops removed data.
+ */
+void RegistrationImplService::dataAddedOrRemovedSlot()
+{
+	if (mFrameForest)
+		mFrameForest->setSource(mPatientModelService->getDatas());
 }
 
 void RegistrationImplService::setMovingData(DataPtr data)
@@ -445,7 +455,9 @@ void RegistrationImplService::performPatientRegistration(Transform3D rMpr_new, Q
  */
 void RegistrationImplService::updateRegistration_rMd(QDateTime oldTime, RegistrationTransform dMd, DataPtr data)
 {
-	RegistrationApplicator applicator(mPatientModelService->getDatas());
+	if (!mFrameForest)
+		mFrameForest.reset(new FrameForest());
+	RegistrationApplicator applicator(mPatientModelService->getDatas(), mFrameForest);
 	dMd.mMoving = data->getUid();
 	applicator.updateRegistration(oldTime, dMd);
 
@@ -27,6 +27,7 @@ class RegistrationTransform;
 class PatientModelService;
 typedef boost::shared_ptr<class PatientModelService> PatientModelServicePtr;
 typedef boost::shared_ptr<class SessionStorageService> SessionStorageServicePtr;
+typedef boost::shared_ptr<class FrameForest> FrameForestPtr;
 
 
 /**
@@ -73,6 +74,7 @@ private slots:
 	void addXml(QDomNode &parentNode);
 	void parseXml(QDomNode &dataNode);
 	void clearSlot();
+	void dataAddedOrRemovedSlot();
 private:
 	virtual void updateRegistration_rMd(QDateTime oldTime, RegistrationTransform dMd, DataPtr data);
 //	PatientModelService* getPatientModelService();
@@ -93,6 +95,7 @@ private:
 	ctkPluginContext* mContext;
 	PatientModelServicePtr mPatientModelService;
 	SessionStorageServicePtr mSession;
+	FrameForestPtr mFrameForest; ///< space relations between all data, kept between registrations
 	void performImage2ImageRegistration(Transform3D dMd, QString description, bool temporaryRegistration = false);
 	void performPatientRegistration(Transform3D rMpr_new, QString description, bool temporaryRegistration = false);
 };
@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTypeConversions.h"
 #include "cxVolumeHelpers.h"
 #include "cxTimeKeeper.h"
+#include "cxTracer.h"
 #include "cxUSFrameData.h"
 #include <vtkImageData.h>
 #include "cxImage.h"
@@ -64,6 +65,7 @@ void optimizedCoordTransform(Vector3D* p, boost::array<double, 16> tt)
 bool PNNReconstructionMethodService::reconstruct(ProcessedUSInputDataPtr input,
 		vtkImageDataPtr outputData, QDomElement settings)
 {
+	CX_TRACE_SCOPE("reconstruction", "PNN");
 	input->validate();
 
 	std::vector<TimedPosition> frameInfo = input->getFrames();
@@ -229,6 +231,7 @@ vtkImageDataPtr PNNReconstructionMethodService::createMask(vtkImageDataPtr input
 
 void PNNReconstructionMethodService::interpolate(ImagePtr inputData, vtkImageDataPtr outputData, QDomElement settings)
 {
+	CX_TRACE_SCOPE("reconstruction", "PNN interpolate");
 	TimeKeeper timer;
 	DoublePropertyPtr interpolationStepsOption = this->getInterpolationStepsOption(settings);
 	int interpolationSteps = static_cast<int> (interpolationStepsOption->getValue());
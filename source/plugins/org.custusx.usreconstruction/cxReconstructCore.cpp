@@ -24,6 +24,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "vtkPointData.h"
 #include "vtkDataArray.h"
 #include "cxPatientModelService.h"
+#include "cxTracer.h"
 
 namespace cx
 {
@@ -69,6 +70,7 @@ void ReconstructCore::threadedPreReconstruct()
 {
 	if (!this->validInputData())
 		return;
+	CX_TRACE_SCOPE("reconstruction", "pre reconstruct");
 	mRawOutput = this->generateRawOutputVolume();
 }
 
@@ -81,6 +83,7 @@ void ReconstructCore::threadedReconstruct()
 		return;
     CX_ASSERT(mRawOutput);
 
+	CX_TRACE_SCOPE("reconstruction", "reconstruct");
 	TimeKeeper timer;
 
 	mSuccess = mAlgorithm->reconstruct(mFileData, mRawOutput, mInput.mAlgoSettings);
@@ -95,6 +98,7 @@ void ReconstructCore::threadedPostReconstruct()
 {
 	if (!this->validInputData())
 		return;
+	CX_TRACE_SCOPE("reconstruction", "post reconstruct");
 
 	if (mSuccess)
 	{
@@ -28,6 +28,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxPatientModelService.h"
 #include "cxMathUtils.h"
 #include "cxPositionFilter.h"
+#include "cxTracer.h"
 
 #include <QThread>
 
@@ -50,6 +51,7 @@ ReconstructPreprocessor::~ReconstructPreprocessor()
 
 std::vector<ProcessedUSInputDataPtr> ReconstructPreprocessor::createProcessedInput(std::vector<bool> angio)
 {
+	CX_TRACE_SCOPE("reconstruction", "preprocess input");
 
 	std::vector<std::vector<vtkImageDataPtr> > frames = mFileData.mUsRaw->initializeFrames(angio);
 
@@ -298,24 +300,11 @@ std::vector<Vector3D> ReconstructPreprocessor::generateInputRectangle()
 								.arg(qstring_cast(dims))
 								.arg(qstring_cast(maskDims)));
 
-	int xmin = maskDims[0];
-	int xmax = 0;
-	int ymin = maskDims[1];
-	int ymax = 0;
-
-	unsigned char* ptr = static_cast<unsigned char*> (mask->GetScalarPointer());
-	for (int x = 0; x < maskDims[0]; x++)
-		for (int y = 0; y < maskDims[1]; y++)
-		{
-			unsigned char val = ptr[x + y * maskDims[0]];
-			if (val != 0)
-			{
-				xmin = std::min(xmin, x);
-				ymin = std::min(ymin, y);
-				xmax = std::max(xmax, x);
-				ymax = std::max(ymax, y);
-			}
-		}
+	IntBoundingBox3D bb = mFileData.getProbeMask()->getBoundingBox();
+	int xmin = bb[0];
+	int xmax = bb[1];
+	int ymin = bb[2];
+	int ymax = bb[3];
 
 	//Reduce the output volume by reducing the mask when determining output volume size
 	double red = mInput.mMaskReduce;
@@ -454,6 +443,7 @@ void ReconstructPreprocessor::initialize(ReconstructCore::InputParams input, USR
 {
 	mInput = input;
 	mFileData = fileData;
+	CX_TRACE_SCOPE("reconstruction", "preprocess positions");
 	this->updateFromOriginalFileData();
 }
 
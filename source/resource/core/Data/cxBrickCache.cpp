@@ -0,0 +1,170 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxBrickCache.h"
+
+#include <limits>
+#include <QMutexLocker>
+#include "cxSettings.h"
+
+namespace cx
+{
+
+namespace
+{
+const double MB = 1024*1024;
+
+double getBudgetSetting()
+{
+	double budget = settings()->value("OutOfCore/memoryBudget").toDouble();
+	return (budget > 0) ? budget : 1024;
+}
+
+BrickCachePtr createSharedCache()
+{
+	BrickCachePtr retval(new BrickCache(getBudgetSetting()));
+	BrickCache* cache = retval.get();
+	QObject::connect(settings(), &Settings::valueChangedFor, [cache](QString key)
+	{
+		if (key == "OutOfCore/memoryBudget")
+			cache->setMemoryBudget(getBudgetSetting());
+	});
+	return retval;
+}
+} // namespace
+
+BrickCache::Statistics::Statistics() :
+	hits(0), misses(0), evictions(0), memory(0)
+{
+}
+
+double BrickCache::Statistics::getHitRate() const
+{
+	int total = hits + misses;
+	return total ? double(hits)/total : 0;
+}
+
+BrickCachePtr BrickCache::getShared()
+{
+	static BrickCachePtr shared = createSharedCache();
+	return shared;
+}
+
+BrickCache::BrickCache(double memoryBudget) :
+	mMemoryBudget(memoryBudget*MB),
+	mMemory(0),
+	mNextOwner(1)
+{
+}
+
+void BrickCache::setMemoryBudget(double megabytes)
+{
+	QMutexLocker locker(&mMutex);
+	mMemoryBudget = megabytes*MB;
+	this->evict();
+}
+
+double BrickCache::getMemoryBudget() const
+{
+	QMutexLocker locker(&mMutex);
+	return mMemoryBudget/MB;
+}
+
+quint64 BrickCache::createOwnerId()
+{
+	QMutexLocker locker(&mMutex);
+	return mNextOwner++;
+}
+
+BrickCache::BrickPtr BrickCache::find(quint64 owner, qint64 brick)
+{
+	QMutexLocker locker(&mMutex);
+	std::map<Key, Entry>::iterator iter = mEntries.find(Key(owner, brick));
+	if (iter == mEntries.end())
+	{
+		++mStatistics.misses;
+		return BrickPtr();
+	}
+	++mStatistics.hits;
+	mUse.splice(mUse.begin(), mUse, iter->second.use);
+	return iter->second.data;
+}
+
+/** Add a brick as the most recently used. If another thread
+ *  inserted the same brick meanwhile, the existing one is kept.
+ */
+void BrickCache::insert(quint64 owner, qint64 brick, BrickPtr data)
+{
+	if (!data)
+		return;
+	QMutexLocker locker(&mMutex);
+	Key key(owner, brick);
+	if (mEntries.count(key))
+		return;
+
+	mUse.push_front(key);
+	Entry& entry = mEntries[key];
+	entry.data = data;
+	entry.use = mUse.begin();
+	mMemory += data->size();
+	this->evict();
+}
+
+void BrickCache::remove(quint64 owner)
+{
+	QMutexLocker locker(&mMutex);
+	std::map<Key, Entry>::iterator iter = mEntries.lower_bound(Key(owner, std::numeric_limits<qint64>::min()));
+	while (iter != mEntries.end() && iter->first.first == owner)
+	{
+		mMemory -= iter->second.data->size();
+		mUse.erase(iter->second.use);
+		mEntries.erase(iter++);
+	}
+}
+
+void BrickCache::clear()
+{
+	QMutexLocker locker(&mMutex);
+	mEntries.clear();
+	mUse.clear();
+	mMemory = 0;
+}
+
+/** Remove least recently used bricks until inside the budget,
+ *  always keeping the most recent one.
+ */
+void BrickCache::evict()
+{
+	while (mMemory > mMemoryBudget && mUse.size() > 1)
+	{
+		std::map<Key, Entry>::iterator iter = mEntries.find(mUse.back());
+		mMemory -= iter->second.data->size();
+		mEntries.erase(iter);
+		mUse.pop_back();
+		++mStatistics.evictions;
+	}
+}
+
+BrickCache::Statistics BrickCache::getStatistics() const
+{
+	QMutexLocker locker(&mMutex);
+	Statistics retval = mStatistics;
+	retval.memory = mMemory/MB;
+	return retval;
+}
+
+void BrickCache::resetStatistics()
+{
+	QMutexLocker locker(&mMutex);
+	mStatistics = Statistics();
+}
+
+} // namespace cx
@@ -0,0 +1,91 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXBRICKCACHE_H
+#define CXBRICKCACHE_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <map>
+#include <list>
+#include <vector>
+#include <QMutex>
+#include <boost/shared_ptr.hpp>
+
+namespace cx
+{
+typedef boost::shared_ptr<class BrickCache> BrickCachePtr;
+
+/** \brief Least recently used cache of volume bricks with a memory budget.
+ *
+ * Holds bricks loaded by BrickedVolume, keyed on an owner id (one per
+ * volume) and the brick index. When the budget is exceeded, the least
+ * recently used bricks are evicted. Bricks are shared pointers, thus
+ * an evicted brick stays valid for the readers still using it.
+ *
+ * All methods are thread safe.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT BrickCache
+{
+public:
+	typedef boost::shared_ptr<const std::vector<char> > BrickPtr;
+
+	struct cxResource_EXPORT Statistics
+	{
+		Statistics();
+		int hits;
+		int misses;
+		int evictions;
+		double memory; ///< MB currently cached
+		double getHitRate() const;
+	};
+
+	static BrickCachePtr getShared(); ///< cache common to all volumes, with the budget given by the setting OutOfCore/memoryBudget
+
+	explicit BrickCache(double memoryBudget=1024); ///< budget in MB
+	void setMemoryBudget(double megabytes);
+	double getMemoryBudget() const; ///< MB
+
+	quint64 createOwnerId();
+	BrickPtr find(quint64 owner, qint64 brick); ///< zero if not cached
+	void insert(quint64 owner, qint64 brick, BrickPtr data);
+	void remove(quint64 owner); ///< forget all bricks of owner
+	void clear();
+
+	Statistics getStatistics() const;
+	void resetStatistics();
+
+private:
+	typedef std::pair<quint64, qint64> Key;
+	typedef std::list<Key> UseList; ///< most recently used first
+	struct Entry
+	{
+		BrickPtr data;
+		UseList::iterator use;
+	};
+
+	void evict();
+
+	mutable QMutex mMutex;
+	std::map<Key, Entry> mEntries;
+	UseList mUse;
+	double mMemoryBudget; ///< bytes
+	double mMemory; ///< bytes in mEntries
+	quint64 mNextOwner;
+	Statistics mStatistics;
+};
+
+} // namespace cx
+
+#endif // CXBRICKCACHE_H
@@ -0,0 +1,401 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxBrickedVolume.h"
+
+#include <string.h>
+#include <algorithm>
+#include <QFileInfo>
+#include <QDir>
+#include <QStringList>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include "cxLogger.h"
+#include "cxTracer.h"
+#include "cxMetaImageIO.h"
+
+namespace cx
+{
+
+namespace
+{
+const double MB = 1024*1024;
+
+inline int floorDiv(int a, int b)
+{
+	return (a >= 0) ? a/b : -((-a+b-1)/b);
+}
+
+inline int ceilDiv(int a, int b)
+{
+	return -floorDiv(-a, b);
+}
+
+/** Clamp extent to bounds, and convert to units of step voxels.
+ *  Return false if nothing is left.
+ */
+bool getOutputExtent(const IntBoundingBox3D& extent, const IntBoundingBox3D& bounds, int step, IntBoundingBox3D* output)
+{
+	for (int i=0; i<3; ++i)
+	{
+		(*output)[2*i] = ceilDiv(std::max(extent[2*i], bounds[2*i]), step);
+		(*output)[2*i+1] = floorDiv(std::min(extent[2*i+1], bounds[2*i+1]), step);
+		if ((*output)[2*i] > (*output)[2*i+1])
+			return false;
+	}
+	return true;
+}
+
+/** Copy the voxels inside region from a block of voxels with extent srcExtent
+ *  into dst. dst has extent dstExtent, region is a part of it. Both are in
+ *  units of step voxels, see BrickedVolume::readRegion(). Rows run along x.
+ */
+void copyBlock(const char* src, const IntBoundingBox3D& srcExtent,
+			   char* dst, const IntBoundingBox3D& dstExtent,
+			   const IntBoundingBox3D& region, int step, int voxelSize)
+{
+	int lo[3];
+	int hi[3];
+	for (int i=0; i<3; ++i)
+	{
+		lo[i] = std::max(ceilDiv(srcExtent[2*i], step), region[2*i]);
+		hi[i] = std::min(floorDiv(srcExtent[2*i+1], step), region[2*i+1]);
+		if (lo[i] > hi[i])
+			return;
+	}
+	const qint64 srcDim[2] = { srcExtent[1]-srcExtent[0]+1, srcExtent[3]-srcExtent[2]+1 };
+	const qint64 dstDim[2] = { dstExtent[1]-dstExtent[0]+1, dstExtent[3]-dstExtent[2]+1 };
+	const qint64 rowLength = hi[0]-lo[0]+1;
+	const qint64 srcStep = qint64(step)*voxelSize;
+
+	for (int z=lo[2]; z<=hi[2]; ++z)
+	{
+		for (int y=lo[1]; y<=hi[1]; ++y)
+		{
+			qint64 srcIndex = ((qint64(z)*step - srcExtent[4])*srcDim[1] + (qint64(y)*step - srcExtent[2]))*srcDim[0]
+					+ (qint64(lo[0])*step - srcExtent[0]);
+			qint64 dstIndex = ((qint64(z) - dstExtent[4])*dstDim[1] + (y - dstExtent[2]))*dstDim[0] + (lo[0] - dstExtent[0]);
+			const char* s = src + srcIndex*voxelSize;
+			char* d = dst + dstIndex*voxelSize;
+			if (step == 1)
+			{
+				memcpy(d, s, rowLength*voxelSize);
+				continue;
+			}
+			for (qint64 x=0; x<rowLength; ++x, d+=voxelSize, s+=srcStep)
+				memcpy(d, s, voxelSize);
+		}
+	}
+}
+} // namespace
+
+BrickedVolumePtr BrickedVolume::openMetaImage(QString filename, BrickCachePtr cache)
+{
+	MetaImageIO::Header header;
+	if (!MetaImageIO::readHeader(filename, &header) || header.compressed)
+		return BrickedVolumePtr();
+	int scalarSize = header.getScalarSize();
+	if (header.msb && scalarSize > 1)
+		return BrickedVolumePtr(); // must be swapped
+
+	if (!cache)
+		cache = BrickCache::getShared();
+	BrickedVolumePtr retval(new BrickedVolume(header.dataFile, cache));
+	for (int i=0; i<3; ++i)
+	{
+		retval->mDim[i] = header.dim[i];
+		retval->mSpacing[i] = header.spacing[i];
+	}
+	retval->mScalarType = header.scalarType;
+	retval->mNumComps = header.numComps;
+	retval->mVoxelSize = scalarSize*header.numComps;
+
+	if (!retval->map(header.headerSize))
+		return BrickedVolumePtr();
+	return retval;
+}
+
+vtkImageDataPtr BrickedVolume::extractRegion(vtkImageDataPtr image, const IntBoundingBox3D& extent, int step)
+{
+	if (!image || !image->GetPointData()->GetScalars())
+		return vtkImageDataPtr();
+	step = std::max(step, 1);
+	IntBoundingBox3D imageExtent(image->GetExtent());
+	IntBoundingBox3D outExtent;
+	if (!getOutputExtent(extent, imageExtent, step, &outExtent))
+		return vtkImageDataPtr();
+
+	double* spacing = image->GetSpacing();
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(outExtent[0], outExtent[1], outExtent[2], outExtent[3], outExtent[4], outExtent[5]);
+	retval->SetSpacing(spacing[0]*step, spacing[1]*step, spacing[2]*step);
+	retval->SetOrigin(image->GetOrigin());
+	retval->AllocateScalars(image->GetScalarType(), image->GetNumberOfScalarComponents());
+
+	int voxelSize = image->GetScalarSize()*image->GetNumberOfScalarComponents();
+	copyBlock(static_cast<const char*>(image->GetScalarPointer()), imageExtent,
+			  static_cast<char*>(retval->GetScalarPointer()), outExtent, outExtent, step, voxelSize);
+	return retval;
+}
+
+BrickedVolume::BrickedVolume(QString filename, BrickCachePtr cache) :
+	mFilename(filename),
+	mFile(filename),
+	mData(NULL),
+	mOffset(0),
+	mCache(cache),
+	mOwnerId(cache->createOwnerId()),
+	mScalarType(0),
+	mNumComps(1),
+	mVoxelSize(1)
+{
+	for (int i=0; i<3; ++i)
+	{
+		mDim[i] = 1;
+		mSpacing[i] = 1;
+	}
+}
+
+BrickedVolume::~BrickedVolume()
+{
+	mCache->remove(mOwnerId);
+	if (mData)
+		mFile.unmap(mData);
+}
+
+/** Map the scalars, starting at offset in the data file.
+ *  A negative offset means that the scalars are at the end of the file.
+ */
+bool BrickedVolume::map(qint64 offset)
+{
+	if (!mFile.open(QIODevice::ReadOnly))
+	{
+		CX_LOG_WARNING() << "BrickedVolume: Failed to open " << mFilename;
+		return false;
+	}
+	qint64 size = this->getSizeInBytes();
+	if (offset < 0)
+		offset = mFile.size() - size;
+	if (offset < 0 || offset + size > mFile.size())
+	{
+		CX_LOG_WARNING() << "BrickedVolume: Data file is too small: " << mFilename;
+		return false;
+	}
+	mOffset = offset;
+	mData = mFile.map(offset, size);
+	if (!mData)
+		CX_LOG_WARNING() << "BrickedVolume: Failed to map " << mFilename;
+	return mData != NULL;
+}
+
+QString BrickedVolume::getFilename() const
+{
+	return mFilename;
+}
+
+Eigen::Array3i BrickedVolume::getDimensions() const
+{
+	return Eigen::Array3i(mDim[0], mDim[1], mDim[2]);
+}
+
+Eigen::Array3d BrickedVolume::getSpacing() const
+{
+	return Eigen::Array3d(mSpacing[0], mSpacing[1], mSpacing[2]);
+}
+
+int BrickedVolume::getScalarType() const
+{
+	return mScalarType;
+}
+
+int BrickedVolume::getNumberOfScalarComponents() const
+{
+	return mNumComps;
+}
+
+IntBoundingBox3D BrickedVolume::getExtent() const
+{
+	return IntBoundingBox3D(0, mDim[0]-1, 0, mDim[1]-1, 0, mDim[2]-1);
+}
+
+qint64 BrickedVolume::getSizeInBytes() const
+{
+	return qint64(mDim[0]) * mDim[1] * mDim[2] * mVoxelSize;
+}
+
+Eigen::Array3i BrickedVolume::getBrickDimensions() const
+{
+	return (this->getDimensions() + (brickSize-1)) / brickSize;
+}
+
+IntBoundingBox3D BrickedVolume::getBrickExtent(int x, int y, int z) const
+{
+	int index[3] = { x, y, z };
+	IntBoundingBox3D retval;
+	for (int i=0; i<3; ++i)
+	{
+		retval[2*i] = index[i]*brickSize;
+		retval[2*i+1] = std::min((index[i]+1)*brickSize, mDim[i]) - 1;
+	}
+	return retval;
+}
+
+BrickCache::BrickPtr BrickedVolume::getBrick(int x, int y, int z) const
+{
+	Eigen::Array3i bricks = this->getBrickDimensions();
+	qint64 index = (qint64(z)*bricks[1] + y)*bricks[0] + x;
+	BrickCache::BrickPtr retval = mCache->find(mOwnerId, index);
+	if (retval)
+		return retval;
+
+	IntBoundingBox3D extent = this->getBrickExtent(x, y, z);
+	qint64 voxels = qint64(extent[1]-extent[0]+1) * (extent[3]-extent[2]+1) * (extent[5]-extent[4]+1);
+	boost::shared_ptr<std::vector<char> > brick(new std::vector<char>(voxels*mVoxelSize));
+	copyBlock(reinterpret_cast<const char*>(mData), this->getExtent(), &(*brick)[0], extent, extent, 1, mVoxelSize);
+	mCache->insert(mOwnerId, index, brick);
+	return brick;
+}
+
+vtkImageDataPtr BrickedVolume::createOutput(const IntBoundingBox3D& outExtent, int step) const
+{
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(outExtent[0], outExtent[1], outExtent[2], outExtent[3], outExtent[4], outExtent[5]);
+	retval->SetSpacing(mSpacing[0]*step, mSpacing[1]*step, mSpacing[2]*step);
+	retval->SetOrigin(0, 0, 0);
+	retval->AllocateScalars(mScalarType, mNumComps);
+	return retval;
+}
+
+vtkImageDataPtr BrickedVolume::readRegion(const IntBoundingBox3D& extent, int step) const
+{
+	CX_TRACE_SCOPE("outofcore", "read region");
+	step = std::max(step, 1);
+	IntBoundingBox3D outExtent;
+	if (!mData || !getOutputExtent(extent, this->getExtent(), step, &outExtent))
+		return vtkImageDataPtr();
+
+	vtkImageDataPtr retval = this->createOutput(outExtent, step);
+	char* output = static_cast<char*>(retval->GetScalarPointer());
+	const char* data = reinterpret_cast<const char*>(mData);
+
+	double bytes = double(retval->GetNumberOfPoints()) * mVoxelSize;
+	if (bytes > mCache->getMemoryBudget()*MB/2)
+	{
+		std::vector<int> slices;
+		for (int z=outExtent[4]; z<=outExtent[5]; ++z)
+			slices.push_back(z);
+		QtConcurrent::blockingMap(slices, [&](int z)
+		{
+			IntBoundingBox3D slice = outExtent;
+			slice[4] = slice[5] = z;
+			copyBlock(data, this->getExtent(), output, outExtent, slice, step, mVoxelSize);
+		});
+		return retval;
+	}
+
+	Eigen::Array3i first;
+	Eigen::Array3i last;
+	for (int i=0; i<3; ++i)
+	{
+		first[i] = (outExtent[2*i]*step) / brickSize;
+		last[i] = (outExtent[2*i+1]*step) / brickSize;
+	}
+	std::vector<Eigen::Vector3i> bricks;
+	for (int z=first[2]; z<=last[2]; ++z)
+		for (int y=first[1]; y<=last[1]; ++y)
+			for (int x=first[0]; x<=last[0]; ++x)
+				bricks.push_back(Eigen::Vector3i(x, y, z));
+
+	auto copyBrick = [&](const Eigen::Vector3i& index)
+	{
+		BrickCache::BrickPtr brick = this->getBrick(index[0], index[1], index[2]);
+		IntBoundingBox3D brickExtent = this->getBrickExtent(index[0], index[1], index[2]);
+		copyBlock(&(*brick)[0], brickExtent, output, outExtent, outExtent, step, mVoxelSize);
+	};
+	if (bricks.size() == 1)
+		copyBrick(bricks[0]);
+	else
+		QtConcurrent::blockingMap(bricks, copyBrick);
+	return retval;
+}
+
+vtkImageDataPtr BrickedVolume::materialize() const
+{
+	return this->readRegion(this->getExtent());
+}
+
+vtkImageDataPtr BrickedVolume::createDownsampled(long maxVoxels) const
+{
+	double voxels = double(mDim[0]) * mDim[1] * mDim[2];
+	int step = 1;
+	while (maxVoxels > 0 && voxels/(double(step)*step*step) > maxVoxels)
+		++step;
+	return this->readRegion(this->getExtent(), step);
+}
+
+bool BrickedVolume::writeMetaImage(QString filename) const
+{
+	QFileInfo info(filename);
+	QString dataFile = info.completeBaseName() + ".raw";
+	QString dataPath = info.absoluteDir().absoluteFilePath(dataFile);
+	QFileInfo dataInfo(dataPath);
+	bool mappedFile = dataInfo.exists() && dataInfo.canonicalFilePath() == QFileInfo(mFilename).canonicalFilePath();
+	QDir().mkpath(info.absolutePath());
+
+	MetaImageIO::Header header;
+	header.scalarType = mScalarType;
+	header.numComps = mNumComps;
+	for (int i=0; i<3; ++i)
+	{
+		header.dim[i] = mDim[i];
+		header.spacing[i] = mSpacing[i];
+	}
+	if (mappedFile)
+		header.headerSize = mOffset;
+	QStringList lines = MetaImageIO::createHeaderLines(header);
+	lines << QString("ElementDataFile = %1").arg(dataFile);
+
+	QFile headerFile(filename);
+	if (!headerFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		CX_LOG_WARNING() << "BrickedVolume: Failed to write " << filename;
+		return false;
+	}
+	headerFile.write((lines.join("\n") + "\n").toLatin1());
+	headerFile.close();
+
+	if (mappedFile)
+		return true;
+
+	CX_TRACE_SCOPE("outofcore", "write");
+	QFile data(dataPath);
+	if (!data.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "BrickedVolume: Failed to write " << dataPath;
+		return false;
+	}
+	const qint64 chunkSize = 64*1024*1024;
+	qint64 size = this->getSizeInBytes();
+	for (qint64 pos=0; pos<size; pos+=chunkSize)
+	{
+		qint64 count = std::min(chunkSize, size-pos);
+		if (data.write(reinterpret_cast<const char*>(mData) + pos, count) != count)
+		{
+			CX_LOG_WARNING() << "BrickedVolume: Failed to write " << dataPath;
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace cx
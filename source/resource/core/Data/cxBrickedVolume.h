@@ -0,0 +1,105 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXBRICKEDVOLUME_H
+#define CXBRICKEDVOLUME_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <QFile>
+#include "vtkForwardDeclarations.h"
+#include "cxBoundingBox3D.h"
+#include "cxBrickCache.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class BrickedVolume> BrickedVolumePtr;
+
+/** \brief Read-only volume kept on disk, read in bricks on demand.
+ *
+ * The scalars of an uncompressed MetaImage file are memory mapped and
+ * never loaded as a whole. readRegion() copies the voxels of a region
+ * out of the bricks of brickSize^3 voxels that it touches. The bricks
+ * are kept in a BrickCache, thus the memory used is bounded by the
+ * cache budget, and repeated access to a region does not touch the file.
+ *
+ * Regions larger than half the budget bypass the cache and are copied
+ * directly from the mapping, so that a full scan (materialize(),
+ * createDownsampled()) does not evict the bricks in use. The mapped pages
+ * are clean and are dropped by the OS under memory pressure.
+ *
+ * Extents are voxel index ranges, inclusive, as in vtkImageData.
+ * The origin is zero, as for Image.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT BrickedVolume
+{
+public:
+	static const int brickSize = 64;
+
+	/** Map the scalars of an uncompressed MetaImage file.
+	 *  Zero if the file cannot be mapped, e.g. if it is compressed.
+	 */
+	static BrickedVolumePtr openMetaImage(QString filename, BrickCachePtr cache = BrickCachePtr());
+	/** As readRegion(), for an image in memory. */
+	static vtkImageDataPtr extractRegion(vtkImageDataPtr image, const IntBoundingBox3D& extent, int step=1);
+
+	~BrickedVolume();
+
+	QString getFilename() const; ///< the data file
+	Eigen::Array3i getDimensions() const;
+	Eigen::Array3d getSpacing() const;
+	int getScalarType() const;
+	int getNumberOfScalarComponents() const;
+	IntBoundingBox3D getExtent() const;
+	qint64 getSizeInBytes() const;
+
+	Eigen::Array3i getBrickDimensions() const;
+	IntBoundingBox3D getBrickExtent(int x, int y, int z) const;
+
+	/** Copy of the voxels in extent, clamped to the volume. With step>1 only
+	 *  every step'th voxel along each axis is read, giving an image with
+	 *  spacing*step and extent divided by step, i.e. output voxel i is voxel i*step.
+	 *  Zero if extent is outside the volume. Safe to call from several threads.
+	 */
+	vtkImageDataPtr readRegion(const IntBoundingBox3D& extent, int step=1) const;
+	vtkImageDataPtr materialize() const; ///< the whole volume in memory
+	vtkImageDataPtr createDownsampled(long maxVoxels) const; ///< every n'th voxel, with at most maxVoxels voxels
+	/** Write as an uncompressed .mhd/.raw pair, copying the scalars directly
+	 *  from the mapping. The scalars are not written if the target is the mapped file.
+	 */
+	bool writeMetaImage(QString filename) const;
+	BrickCachePtr getCache() const { return mCache; }
+
+private:
+	BrickedVolume(QString filename, BrickCachePtr cache);
+	bool map(qint64 offset);
+	BrickCache::BrickPtr getBrick(int x, int y, int z) const;
+	vtkImageDataPtr createOutput(const IntBoundingBox3D& outExtent, int step) const;
+
+	QString mFilename;
+	QFile mFile;
+	uchar* mData; ///< mapped scalars, read only
+	qint64 mOffset; ///< position of the scalars in the data file
+	BrickCachePtr mCache;
+	quint64 mOwnerId; ///< key in mCache
+	int mDim[3];
+	double mSpacing[3];
+	int mScalarType;
+	int mNumComps;
+	int mVoxelSize; ///< bytes
+};
+
+} // namespace cx
+
+#endif // CXBRICKEDVOLUME_H
@@ -24,6 +24,7 @@ namespace cx
 {
 typedef boost::shared_ptr<class SpaceProvider> SpaceProviderPtr;
 typedef boost::shared_ptr<class SpaceListener> SpaceListenerPtr;
+typedef boost::shared_ptr<class MetricReferenceArgumentList> MetricReferenceArgumentListPtr;
 
 /**
  * \file
@@ -54,6 +55,7 @@ public:
 	virtual bool isValid() const { return true; }
 	virtual QString getValueAsString() const = 0;
 	virtual bool showValueInGraphics() const { return false; }
+	virtual MetricReferenceArgumentListPtr getArguments() { return MetricReferenceArgumentListPtr(); } ///< metrics this metric is computed from, if any
 
 	void setColor(const QColor& color);
 	QColor getColor();
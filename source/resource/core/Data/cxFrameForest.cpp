@@ -11,161 +11,335 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxFrameForest.h"
 
+#include <algorithm>
 #include "cxData.h"
+#include "cxRegistrationTransform.h"
 
 namespace cx
 {
 
+FrameForest::FrameForest() : mTourValid(false)
+{
+	this->rebuild();
+}
+
 /**Create a forest representing all Data objects and their spatial relationships.
  *
  */
-FrameForest::FrameForest(const std::map<QString, DataPtr> &source) : mSource(source)
+FrameForest::FrameForest(const std::map<QString, DataPtr> &source) : mTourValid(false)
 {
-//  std::cout << "Forrest doc2:" << std::endl;
-//	DataManager::DataMap allData = mDataManager->getData();
-	mDocument.appendChild(mDocument.createElement("root"));
+	mSource.insert(source.begin(), source.end());
+	this->rebuild();
+}
+
+/** Replace the data in the forest. Added data are inserted into the
+ *  existing forest, while removed or released data cause a rebuild.
+ */
+void FrameForest::setSource(const std::map<QString, DataPtr>& source)
+{
+	for (std::map<QString, boost::weak_ptr<Data> >::const_iterator iter = mSource.begin(); iter != mSource.end(); ++iter)
+	{
+		std::map<QString, DataPtr>::const_iterator found = source.find(iter->first);
+		if ((found == source.end()) || (found->second != iter->second.lock()))
+		{
+			this->disconnectSource();
+			mSource.clear();
+			mSource.insert(source.begin(), source.end());
+			this->rebuild();
+			return;
+		}
+	}
 
 	for (std::map<QString, DataPtr>::const_iterator iter = source.begin(); iter != source.end(); ++iter)
 	{
+		if (mSource.count(iter->first))
+			continue;
+		mSource[iter->first] = iter->second;
 		this->insertFrame(iter->second);
+		this->connectData(iter->second);
 	}
+}
+
+void FrameForest::rebuild()
+{
+	mFrames.assign(1, Frame());
+	mFree.clear();
+	mIndex.clear();
+	mModified.clear();
+	mTourValid = false;
+
+	for (std::map<QString, boost::weak_ptr<Data> >::const_iterator iter = mSource.begin(); iter != mSource.end(); ++iter)
+	{
+		DataPtr data = iter->second.lock();
+		if (!data)
+			continue;
+		this->insertFrame(data);
+		this->connectData(data);
+	}
+}
 
-//  std::cout << "Forrest doc:" << std::endl;
-//  std::cout << mDocument.toString(4) << std::endl;
+void FrameForest::connectData(DataPtr data)
+{
+	RegistrationHistoryPtr history = data->get_rMd_History();
+	mHistories[history.get()] = data->getUid();
+	connect(history.get(), &RegistrationHistory::currentChanged, this, &FrameForest::registrationChangedSlot);
 }
 
-QDomDocument FrameForest::getDocument()
+void FrameForest::disconnectSource()
 {
-	return mDocument;
+	for (std::map<QObject*, QString>::iterator iter = mHistories.begin(); iter != mHistories.end(); ++iter)
+		disconnect(iter->first, 0, this, 0);
+	mHistories.clear();
 }
 
-/** Insert one data in the correct position in the tree
+void FrameForest::registrationChangedSlot()
+{
+	std::map<QObject*, QString>::iterator iter = mHistories.find(this->sender());
+	if (iter != mHistories.end())
+		mModified.push_back(iter->second);
+}
+
+/** Insert one data in the correct position in the tree,
+ *  or move it there if the parent space has changed.
  */
 void FrameForest::insertFrame(DataPtr data)
 {
 	QString parentFrame = data->getParentSpace();
 	QString currentFrame = data->getSpace();
 
-//    if (parentFrame.isEmpty() || currentFrame.isEmpty())
-//    	return;
-
-	QDomNode parentNode = this->getNodeAnyway(parentFrame);
-	QDomNode currentNode = this->getNodeAnyway(currentFrame);
+	int parent = parentFrame.isEmpty() ? 0 : this->getIndexAnyway(parentFrame);
+	int current = this->getIndexAnyway(currentFrame);
+	if (current < 0)
+		return;
+	mFrames[current].data = data;
 
-	if (parentNode.isNull())
+	if (mFrames[current].parent == parent)
+		return;
+	// ignore parents that would create a cycle
+	if ((parent == current) || this->hasAncestor(parent, current))
 		return;
+	this->move(current, parent);
+}
+
+void FrameForest::move(int frame, int parent)
+{
+	int oldParent = mFrames[frame].parent;
+	std::vector<int>& siblings = mFrames[oldParent].children;
+	siblings.erase(std::find(siblings.begin(), siblings.end(), frame));
+
+	mFrames[parent].children.push_back(frame);
+	mFrames[frame].parent = parent;
+	mTourValid = false;
 
-	// move currentNode to child of parentNode
-	currentNode = currentNode.parentNode().removeChild(currentNode);
-	parentNode.appendChild(currentNode);
+	this->removeIfUnused(oldParent);
 }
 
-/** Given a frame uid, return the QDomNode representing that frame.
- *  Note: Lifetime of retval is controlled by the FrameForest object!
+/** Remove a pure space with no children, as it is no longer the parent of any data.
  */
-QDomNode FrameForest::getNode(QString frame)
+void FrameForest::removeIfUnused(int frame)
 {
-	QDomNodeList list = mDocument.elementsByTagName(frame);
-	if (list.isEmpty())
-		return QDomNode();
-	return list.item(0);
+	if ((frame <= 0) || mFrames[frame].data.lock() || !mFrames[frame].children.empty())
+		return;
+
+	std::vector<int>& siblings = mFrames[mFrames[frame].parent].children;
+	siblings.erase(std::find(siblings.begin(), siblings.end(), frame));
+	mIndex.erase(mFrames[frame].uid);
+	mFrames[frame] = Frame();
+	mFree.push_back(frame);
+	mTourValid = false;
 }
 
-/** As getNode(), but create the node if if doesn't exist.
+int FrameForest::getIndex(QString frame) const
+{
+	std::map<QString, int>::const_iterator iter = mIndex.find(frame);
+	if (iter == mIndex.end())
+		return -1;
+	return iter->second;
+}
+
+/** As getIndex(), but create the frame as an oldest ancestor if it doesn't exist.
  */
-QDomNode FrameForest::getNodeAnyway(QString frame)
+int FrameForest::getIndexAnyway(QString frame)
 {
-	QDomNode retval = this->getNode(frame);
-	if (retval.isNull())
+	if (frame.isEmpty())
+		return -1;
+	int retval = this->getIndex(frame);
+	if (retval >= 0)
+		return retval;
+
+	if (mFree.empty())
+	{
+		retval = mFrames.size();
+		mFrames.push_back(Frame());
+	}
+	else
 	{
-		retval = mDocument.createElement(frame);
-		mDocument.documentElement().appendChild(retval);
+		retval = mFree.back();
+		mFree.pop_back();
 	}
+	mFrames[retval].uid = frame;
+	mFrames[retval].parent = 0;
+	mFrames[0].children.push_back(retval);
+	mIndex[frame] = retval;
+	mTourValid = false;
 	return retval;
 }
 
-/** Return true if ancestor is an ancestor of node
+/** Return true if ancestor is a proper ancestor of frame, using the parent links.
+ */
+bool FrameForest::hasAncestor(int frame, int ancestor) const
+{
+	for (int i = mFrames[frame].parent; i > 0; i = mFrames[i].parent)
+	{
+		if (i == ancestor)
+			return true;
+	}
+	return false;
+}
+
+/** Apply pending registration changes, then recompute the tour if the
+ *  forest has changed.
  */
-bool FrameForest::isAncestorOf(QDomNode node, QDomNode ancestor)
+void FrameForest::update()
 {
-	//std::cout << "isAncestorOf : " << node.toElement().tagName() << "---"  << ancestor.toElement().tagName() << std::endl;
+	std::vector<QString> modified;
+	modified.swap(mModified);
+	for (unsigned i = 0; i < modified.size(); ++i)
+	{
+		std::map<QString, boost::weak_ptr<Data> >::iterator iter = mSource.find(modified[i]);
+		DataPtr data = (iter != mSource.end()) ? iter->second.lock() : DataPtr();
+		if (data)
+			this->insertFrame(data);
+	}
+
+	if (mTourValid)
+		return;
 
-	while (!this->isRootNode(node))
+	mTour.clear();
+	std::vector<std::pair<int, unsigned> > stack;
+	stack.push_back(std::make_pair(0, 0u));
+	while (!stack.empty())
 	{
-		if (node == ancestor)
+		int frame = stack.back().first;
+		if (stack.back().second < mFrames[frame].children.size())
 		{
-			//std::cout << "return true" << std::endl;;
-			return true;
+			int child = mFrames[frame].children[stack.back().second++];
+			mFrames[child].enter = mTour.size();
+			mFrames[child].oldest = (frame == 0) ? child : mFrames[frame].oldest;
+			mTour.push_back(child);
+			stack.push_back(std::make_pair(child, 0u));
+		}
+		else
+		{
+			mFrames[frame].exit = mTour.size();
+			stack.pop_back();
 		}
-		node = node.parentNode();
 	}
-	//std::cout << "return false" << std::endl;;
-	return false;
+	mTourValid = true;
 }
 
-bool FrameForest::isRootNode(QDomNode node)
+bool FrameForest::hasFrame(QString frame)
 {
-	return node == mDocument.documentElement();
+	this->update();
+	return this->getIndex(frame) > 0;
 }
 
-/** Find the oldest ancestor of node.
+QString FrameForest::getParent(QString frame)
+{
+	this->update();
+	int index = this->getIndex(frame);
+	if (index <= 0)
+		return "";
+	return mFrames[mFrames[index].parent].uid;
+}
+
+std::vector<QString> FrameForest::getChildren(QString frame)
+{
+	this->update();
+	int index = frame.isEmpty() ? 0 : this->getIndex(frame);
+	std::vector<QString> retval;
+	if (index < 0)
+		return retval;
+	for (unsigned i = 0; i < mFrames[index].children.size(); ++i)
+		retval.push_back(mFrames[mFrames[index].children[i]].uid);
+	return retval;
+}
+
+/** Return true if ancestor is an ancestor of frame, or frame itself.
+ */
+bool FrameForest::isAncestorOf(QString frame, QString ancestor)
+{
+	this->update();
+	return this->isAncestorOf(this->getIndex(frame), this->getIndex(ancestor));
+}
+
+bool FrameForest::isAncestorOf(int frame, int ancestor) const
+{
+	if ((frame <= 0) || (ancestor <= 0))
+		return false;
+	const Frame& a = mFrames[ancestor];
+	return (a.enter <= mFrames[frame].enter) && (mFrames[frame].enter < a.exit);
+}
+
+/** Find the oldest ancestor of frame.
  */
-QDomNode FrameForest::getOldestAncestor(QDomNode node)
+QString FrameForest::getOldestAncestor(QString frame)
 {
-	if (this->isRootNode(node))
-		return node;
-	while (!this->isRootNode(node.parentNode()))
-		node = node.parentNode();
-	return node;
+	this->update();
+	int index = this->getIndex(frame);
+	if (index <= 0)
+		return "";
+	return mFrames[mFrames[index].oldest].uid;
 }
 
-/** Find the oldest ancestor of child, that is not also an ancestor of ref.
+/** Find the oldest ancestor of frame, that is not also an ancestor of ref.
  */
-QDomNode FrameForest::getOldestAncestorNotCommonToRef(QDomNode node, QDomNode ref)
+QString FrameForest::getOldestAncestorNotCommonToRef(QString frame, QString ref)
 {
-	//std::cout << "getOldestAncestorNotCommonToRef " << node.toElement().tagName() << " - " << ref.toElement().tagName() << std::endl;
-	if (this->isAncestorOf(ref, node))
-		return QDomNode();
+	this->update();
+	int node = this->getIndex(frame);
+	int refNode = this->getIndex(ref);
+	if (node <= 0)
+		return "";
+	if (this->isAncestorOf(refNode, node))
+		return "";
 
-	while (!this->isRootNode(node.parentNode()))
+	while (mFrames[node].parent != 0)
 	{
-		//std::cout << "getOldestAncestorNotCommonToRef iterate start: " << node.toElement().tagName()  << std::endl;
-		if (this->isAncestorOf(ref, node.parentNode()))
+		if (this->isAncestorOf(refNode, mFrames[node].parent))
 			break;
-		node = node.parentNode();
-		//std::cout << "getOldestAncestorNotCommonToRef iterate stop: " << node.toElement().tagName()  << std::endl;
+		node = mFrames[node].parent;
 	}
-	//std::cout << std::endl;
-	return node;
+	return mFrames[node].uid;
 }
 
-/** Return the node and all its children recursively in one flat vector.
+/** Return the frame and all its children recursively in one flat vector.
  */
-std::vector<QDomNode> FrameForest::getDescendantsAndSelf(QDomNode node)
+std::vector<QString> FrameForest::getDescendantsAndSelf(QString frame)
 {
-	std::vector<QDomNode> retval;
-	retval.push_back(node);
-
-	for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling())
-	{
-		std::vector<QDomNode> subnodes = this->getDescendantsAndSelf(child);
-		std::copy(subnodes.begin(), subnodes.end(), back_inserter(retval));
-	}
+	this->update();
+	int index = this->getIndex(frame);
+	std::vector<QString> retval;
+	if (index <= 0)
+		return retval;
+	for (int i = mFrames[index].enter; i < mFrames[index].exit; ++i)
+		retval.push_back(mFrames[mTour[i]].uid);
 	return retval;
 }
 
-/** As getAllNodesFor(QDomNode), but return the nodes as data objects.
+/** As getDescendantsAndSelf(), but return the frames as data objects.
  *  Those frames not representing data are discarded.
  */
-std::vector<DataPtr> FrameForest::getDataFromDescendantsAndSelf(QDomNode node)
+std::vector<DataPtr> FrameForest::getDataFromDescendantsAndSelf(QString frame)
 {
-	std::vector<QDomNode> nodes = this->getDescendantsAndSelf(node);
+	this->update();
+	int index = this->getIndex(frame);
 	std::vector<DataPtr> retval;
-
-	for (unsigned i = 0; i < nodes.size(); ++i)
+	if (index <= 0)
+		return retval;
+	for (int i = mFrames[index].enter; i < mFrames[index].exit; ++i)
 	{
-		DataPtr data = mSource[nodes[i].toElement().tagName()];
-//		DataPtr data = mDataManager->getData(nodes[i].toElement().tagName());
+		DataPtr data = mFrames[mTour[i]].data.lock();
 		if (data)
 			retval.push_back(data);
 	}
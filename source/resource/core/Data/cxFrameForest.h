@@ -16,29 +16,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxForwardDeclarations.h"
 
-#include <QDomDocument>
-#include "cxTypeConversions.h"
-
-/*
-
-<root>
-    <frame uid="A">
-        <frame uid="MR1">
-            <frame uid="S1">
-            </frame>
-            <frame uid="S2">
-            </frame>
-        </frame>
-        <frame uid="CT1">
-        </frame>
-    </frame>
-    <frame uid="B">
-        <frame uid="MR2">
-        </frame>
-    </frame>
-</root>
-
- */
+#include <map>
+#include <vector>
+#include <QObject>
+#include <boost/weak_ptr.hpp>
 
 namespace cx
 {
@@ -56,31 +37,86 @@ namespace cx
  * Relations between coordinate spaces among Data are created by
  * this class.
  *
- * The graph consists of several directed acyclic graphs.
+ * The graph consists of several trees. Example with the spaces A and B,
+ * each shared by the data below it:
+ *
+ *     (root)
+ *     +-- A
+ *     |   +-- MR1
+ *     |   |   +-- S1
+ *     |   |   +-- S2
+ *     |   +-- CT1
+ *     +-- B
+ *         +-- MR2
+ *
+ * Frames are identified by their uid, an empty uid is used for no frame.
+ * The frames are stored with child lists and indexed by a preorder tour,
+ * giving ancestor tests in constant time and the descendants of a frame as
+ * one contiguous range. The graph is kept alive between uses: it listens to
+ * the registration history of all data and moves a frame when its parent
+ * space changes. The tour is recomputed on the next query after a change.
+ *
+ * The data are not owned by the forest: data removed from the patient
+ * are released, and dropped from the forest on the next setSource().
  *
  *  \date   Sep 23, 2010
  *  \author christiana
  */
-class cxResource_EXPORT FrameForest
+class cxResource_EXPORT FrameForest : public QObject
 {
+	Q_OBJECT
 public:
+	FrameForest();
 	explicit FrameForest(const std::map<QString, DataPtr>& source);
-	QDomNode getNode(QString frame);
-	QDomNode getOldestAncestor(QDomNode node);
+	void setSource(const std::map<QString, DataPtr>& source);
+
+	bool hasFrame(QString frame);
+	QString getParent(QString frame); ///< empty for the oldest ancestors
+	std::vector<QString> getChildren(QString frame); ///< the oldest ancestors if frame is empty
+	bool isAncestorOf(QString frame, QString ancestor); ///< true also if ancestor==frame
+	QString getOldestAncestor(QString frame);
+	QString getOldestAncestorNotCommonToRef(QString frame, QString ref);
+	std::vector<QString> getDescendantsAndSelf(QString frame);
+	std::vector<DataPtr> getDataFromDescendantsAndSelf(QString frame);
+
+private slots:
+	void registrationChangedSlot();
 
-	QDomNode getOldestAncestorNotCommonToRef(QDomNode child, QDomNode ref);
-	std::vector<QDomNode> getDescendantsAndSelf(QDomNode node);
-	std::vector<DataPtr> getDataFromDescendantsAndSelf(QDomNode node);
-	QDomDocument getDocument();
 private:
-	bool isRootNode(QDomNode node);
-	QDomNode getNodeAnyway(QString frame);
-	bool isAncestorOf(QDomNode node, QDomNode ancestor);
+	struct Frame
+	{
+		Frame() : parent(-1), enter(0), exit(0), oldest(-1) {}
+		QString uid;
+		boost::weak_ptr<Data> data;
+		int parent;
+		std::vector<int> children;
+		int enter; ///< position in the tour
+		int exit; ///< one past the last descendant in the tour
+		int oldest; ///< oldest ancestor
+	};
+
+	void rebuild();
+	void update();
 	void insertFrame(DataPtr data);
-	QDomDocument mDocument;
+	void move(int frame, int parent);
+	void removeIfUnused(int frame);
+	int getIndex(QString frame) const;
+	int getIndexAnyway(QString frame);
+	bool isAncestorOf(int frame, int ancestor) const;
+	bool hasAncestor(int frame, int ancestor) const;
+	void connectData(DataPtr data);
+	void disconnectSource();
 
-	std::map<QString, DataPtr> mSource;
+	std::map<QString, boost::weak_ptr<Data> > mSource;
+	std::vector<Frame> mFrames; ///< index 0 is the root above all frames
+	std::vector<int> mFree; ///< unused indices in mFrames
+	std::map<QString, int> mIndex;
+	std::vector<int> mTour; ///< frames in preorder
+	bool mTourValid;
+	std::map<QObject*, QString> mHistories; ///< data uid for each registration history
+	std::vector<QString> mModified; ///< data with changed registration
 };
+typedef boost::shared_ptr<FrameForest> FrameForestPtr;
 
 /**
 * @}
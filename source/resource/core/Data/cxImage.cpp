@@ -14,7 +14,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <QDomDocument>
 #include <QDir>
-#include <vtkImageAccumulate.h>
+#include <QMutexLocker>
 #include <vtkImageReslice.h>
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
@@ -23,7 +23,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageResample.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageClip.h>
-#include <vtkImageIterator.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkColorTransferFunction.h>
 #include "cxImageTF3D.h"
@@ -48,6 +47,11 @@ typedef vtkSmartPointer<vtkImageChangeInformation> vtkImageChangeInformationPtr;
 namespace cx
 {
 
+namespace
+{
+const long brickedPreviewVoxels = 16*1000*1000;
+}
+
 Image::ShadingStruct::ShadingStruct()
 {
 	on = settings()->value("View/shadingOn").value<bool>();
@@ -104,8 +108,14 @@ Image::~Image()
 }
 
 Image::Image(const QString& uid, const vtkImageDataPtr& data, const QString& name) :
-	Data(uid, name), mBaseImageData(data), mMaxRGBIntensity(-1), mThresholdPreview(false)
+	Data(uid, name), mBaseImageData(data), mThresholdPreview(false), mBrickedMutex(QMutex::Recursive)
 {
+	mStatistics.reset(new ImageStatistics());
+	connect(mStatistics.get(), &ImageStatistics::exactResultReady, this, &Image::statisticsChanged);
+	mPyramid.reset(new ImagePyramid());
+	mResampledModified = 0;
+	mResampledMaxVoxels = 0;
+
 	mInitialWindowWidth = -1;
 	mInitialWindowLevel = -1;
 
@@ -131,10 +141,10 @@ ImagePtr Image::copy()
 
 	ImagePtr retval = ImagePtr(new Image(mUid, baseImageDataCopy, mName));
 
+	retval->mBrickedVolume = this->getBrickedVolume(); // read only, can be shared
 	retval->mUnsigned = mUnsigned;
 	retval->mModality = mModality;
 	retval->mImageType = mImageType;
-	retval->mMaxRGBIntensity = mMaxRGBIntensity;
 	retval->mInterpolationType = mInterpolationType;
 	retval->mImageLookupTable2D = mImageLookupTable2D;
 	retval->mImageTransferFunctions3D = mImageTransferFunctions3D;
@@ -188,14 +198,14 @@ ImagePtr Image::getUnsigned(ImagePtr self)
 
 void Image::resetTransferFunctions(bool _2D, bool _3D)
 {
-	if (!mBaseImageData)
+	if (!mBaseImageData && !mBrickedVolume)
 	{
 		reportWarning("Image has no image data");
 		return;
 	}
 
-	mBaseImageData->GetScalarRange(); // this line updates some internal vtk value, and (on fedora) removes 4.5s in the second render().
-	mMaxRGBIntensity = -1;
+	if (mBaseImageData)
+		mBaseImageData->GetScalarRange(); // this line updates some internal vtk value, and (on fedora) removes 4.5s in the second render().
 
 	ImageDefaultTFGenerator tfGenerator(ImagePtr(this, null_deleter()));
 	if (_3D)
@@ -263,13 +273,20 @@ void Image::moveThisAndChildrenToThread(QThread* thread)
 	  this->getUnmodifiedTransferFunctions3D()->moveToThread(thread);
 	  this->getUnmodifiedLookupTable2D()->moveToThread(thread);
 	  this->get_rMd_History()->moveToThread(thread);
+	  mStatistics->moveToThread(thread);
+	  mPyramid->moveToThread(thread);
 }
 
 void Image::setVtkImageData(const vtkImageDataPtr& data, bool resetTransferFunctions)
 {
-	mBaseImageData = data;
+	{
+		QMutexLocker locker(&mBrickedMutex);
+		mBaseImageData = data;
+		mBrickedVolume.reset();
+		mBrickedPreview = NULL;
+		mBrickedStatistics = ImageStatistics::Result();
+	}
 	mBaseGrayScaleImageData = NULL;
-	mHistogramPtr = NULL;
 
 	if (resetTransferFunctions)
 		this->resetTransferFunctions();
@@ -334,11 +351,94 @@ void Image::setLookupTable2D(ImageLUT2DPtr imageLookupTable2D)
 
 vtkImageDataPtr Image::getBaseVtkImageData()
 {
+	QMutexLocker locker(&mBrickedMutex);
+	if (!mBaseImageData && mBrickedVolume)
+		this->materializeBrickedVolume();
 	return mBaseImageData;
 }
 
+/** Load the whole out-of-core volume, for callers that need a vtkImageData.
+ *  Call with mBrickedMutex locked.
+ */
+void Image::materializeBrickedVolume()
+{
+	CX_LOG_WARNING() << QString("Loading all of the out-of-core image %1 (%2 MB) into memory. "
+								"Use Image::getRegion() to read parts of it.")
+						.arg(this->getName())
+						.arg(mBrickedVolume->getSizeInBytes()/(1024*1024));
+	mBaseImageData = mBrickedVolume->materialize();
+}
+
+void Image::setBrickedVolume(BrickedVolumePtr volume, bool resetTransferFunctions)
+{
+	{
+		QMutexLocker locker(&mBrickedMutex);
+		mBrickedVolume = volume;
+		mBrickedPreview = NULL;
+		mBrickedStatistics = ImageStatistics::Result();
+		mBaseImageData = NULL;
+	}
+	mBaseGrayScaleImageData = NULL;
+	mResampled = NULL;
+
+	if (resetTransferFunctions)
+		this->resetTransferFunctions();
+	emit vtkImageDataChanged(mUid);
+}
+
+bool Image::isOutOfCore() const
+{
+	QMutexLocker locker(&mBrickedMutex);
+	return mBrickedVolume && !mBaseImageData;
+}
+
+BrickedVolumePtr Image::getBrickedVolume() const
+{
+	QMutexLocker locker(&mBrickedMutex);
+	return mBrickedVolume;
+}
+
+/** The pointers are copied under the lock, so that the region is read
+ *  without blocking other threads, even if the volume is replaced meanwhile.
+ */
+vtkImageDataPtr Image::getRegion(const IntBoundingBox3D& extent, int step)
+{
+	QMutexLocker locker(&mBrickedMutex);
+	bool outOfCore = this->isOutOfCore();
+	BrickedVolumePtr volume = mBrickedVolume;
+	vtkImageDataPtr data = mBaseImageData;
+	locker.unlock();
+
+	if (outOfCore)
+		return volume->readRegion(extent, step);
+	return BrickedVolume::extractRegion(data, extent, step);
+}
+
+Eigen::Array3i Image::getDimensions() const
+{
+	QMutexLocker locker(&mBrickedMutex);
+	if (this->isOutOfCore())
+		return mBrickedVolume->getDimensions();
+	int* dim = mBaseImageData->GetDimensions();
+	return Eigen::Array3i(dim[0], dim[1], dim[2]);
+}
+
+int Image::getScalarType() const
+{
+	QMutexLocker locker(&mBrickedMutex);
+	if (this->isOutOfCore())
+		return mBrickedVolume->getScalarType();
+	return mBaseImageData->GetScalarType();
+}
+
 DoubleBoundingBox3D Image::boundingBox() const
 {
+	QMutexLocker locker(&mBrickedMutex);
+	if (this->isOutOfCore())
+	{
+		Eigen::Array3d size = (mBrickedVolume->getDimensions()-1).cast<double>() * mBrickedVolume->getSpacing();
+		return DoubleBoundingBox3D(0, size[0], 0, size[1], 0, size[2]);
+	}
 //	mBaseImageData->UpdateInformation();
 	DoubleBoundingBox3D bounds(mBaseImageData->GetBounds());
 	return bounds;
@@ -346,93 +446,77 @@ DoubleBoundingBox3D Image::boundingBox() const
 
 Eigen::Array3d Image::getSpacing() const
 {
+	QMutexLocker locker(&mBrickedMutex);
+	if (this->isOutOfCore())
+		return mBrickedVolume->getSpacing();
 	return Eigen::Array3d(mBaseImageData->GetSpacing());
 }
 
-vtkImageAccumulatePtr Image::getHistogram()
+/** The input to the statistics: a downsampled copy when out of core,
+ *  giving estimates without loading the volume.
+ */
+vtkImageDataPtr Image::getStatisticsInput()
+{
+	QMutexLocker locker(&mBrickedMutex);
+	if (!this->isOutOfCore())
+		return mBaseImageData;
+	if (!mBrickedPreview)
+		mBrickedPreview = mBrickedVolume->createDownsampled(brickedPreviewVoxels);
+	return mBrickedPreview;
+}
+
+/** Out of core, this is the exact result if getExactStatistics() has been
+ *  called, otherwise the statistics of the preview scaled to the volume.
+ */
+ImageStatistics::Result Image::getStatistics()
 {
-	if (mHistogramPtr.GetPointer() == NULL)
+	QMutexLocker locker(&mBrickedMutex);
+	if (!this->isOutOfCore())
 	{
-		mHistogramPtr = vtkImageAccumulatePtr::New();
-		mHistogramPtr->SetInputData(this->getGrayScaleVtkImageData());
-		mHistogramPtr->IgnoreZeroOn(); // required for Sonowand CT volumes, where data are placed between 31K and 35K.
-		// Set up only a 1D histogram for now, so y and z values are set to 0
-		mHistogramPtr->SetComponentExtent(0, this->getRange(), 0, 0, 0, 0);
-		mHistogramPtr->SetComponentOrigin(this->getMin(), 0, 0);
-		mHistogramPtr->SetComponentSpacing(1, 0, 0);
+		vtkImageDataPtr data = mBaseImageData;
+		locker.unlock();
+		return mStatistics->get(data);
 	}
-	mHistogramPtr->Update();
-	return mHistogramPtr;
+
+	if (mBrickedStatistics.valid)
+		return mBrickedStatistics;
+	Eigen::Array3i dim = mBrickedVolume->getDimensions();
+	vtkIdType voxels = vtkIdType(dim[0])*dim[1]*dim[2];
+	return ImageStatistics::scale(mStatistics->get(this->getStatisticsInput()), voxels);
 }
 
-template<typename scalartype> static int getRGBMax(vtkImageDataPtr image)
+/** Out of core, the volume is streamed through once, and the result kept.
+ */
+ImageStatistics::Result Image::getExactStatistics()
 {
-	int max = 0;
-	vtkImageIterator<scalartype> iter(image, image->GetExtent());
-	while (!iter.IsAtEnd())
+	QMutexLocker locker(&mBrickedMutex);
+	if (!this->isOutOfCore())
 	{
-		typename vtkImageIterator<scalartype>::SpanIterator siter = iter.BeginSpan();
-		while (siter != iter.EndSpan())
-		{
-			int value = *siter;
-			++siter;
-			value += *siter;
-			++siter;
-			value += *siter;
-			++siter;
-			if (value > max)
-			{
-				max = value;
-			}
-		}
-		iter.NextSpan();
+		vtkImageDataPtr data = mBaseImageData;
+		locker.unlock();
+		return mStatistics->getExact(data);
 	}
-	return max/3;
-}
 
+	if (mBrickedStatistics.valid)
+		return mBrickedStatistics;
+	mBrickedStatistics = ImageStatistics::compute(mBrickedVolume);
+	ImageStatistics::Result retval = mBrickedStatistics;
+	locker.unlock();
+
+	emit statisticsChanged();
+	return retval;
+}
 
 int Image::getMax()
 {
-	// Alternatively create max from histogram
-	//IntIntMap::iterator iter = this->getHistogram()->end();
-	//iter--;
-	//return (*iter).first;
-	if (mBaseImageData->GetNumberOfScalarComponents() == 3)
-	{
-		if (mMaxRGBIntensity != -1)
-		{
-			return mMaxRGBIntensity;
-		}
-		double max = 0.0;
-		switch (mBaseImageData->GetScalarType())
-		{
-		case VTK_UNSIGNED_CHAR:
-			max = getRGBMax<unsigned char>(mBaseImageData);
-			break;
-		case VTK_UNSIGNED_SHORT:
-			max = getRGBMax<unsigned short>(mBaseImageData);
-			break;
-		default:
-			CX_LOG_ERROR() << "Unhandled RGB data type in image " << this->getUid();
-			break;
-		}
-		mMaxRGBIntensity = max;
-		return (int)mMaxRGBIntensity;
-	}
-	else
-	{
-//		return (int) this->getTransferFunctions3D()->getScalarMax();
-		return mBaseImageData->GetScalarRange()[1];
-	}
+	if (this->getStatisticsInput()->GetNumberOfScalarComponents() == 3)
+		return this->getStatistics().rgbMax;
+	return this->getStatistics().max;
 }
 
 int Image::getMin()
 {
-	// Alternatively create min from histogram
-	//IntIntMap::iterator iter = this->getHistogram()->begin();
-	//return (*iter).first;
-	return mBaseImageData->GetScalarRange()[0];
-//	return (int) this->getTransferFunctions3D()->getScalarMin();
+	return this->getStatistics().min;
 }
 
 int Image::getRange()
@@ -447,7 +531,7 @@ int Image::getMaxAlphaValue()
 
 double Image::getVTKMinValue()
 {
-	int vtkScalarType = mBaseImageData->GetScalarType();
+	int vtkScalarType = this->getScalarType();
 
 	if (vtkScalarType==VTK_CHAR)
 		return VTK_CHAR_MIN;
@@ -472,7 +556,7 @@ double Image::getVTKMinValue()
 
 double Image::getVTKMaxValue()
 {
-	int vtkScalarType = mBaseImageData->GetScalarType();
+	int vtkScalarType = this->getScalarType();
 
 	if (vtkScalarType==VTK_CHAR)
 		return VTK_CHAR_MAX;
@@ -497,7 +581,7 @@ double Image::getVTKMaxValue()
 
 bool Image::is2D()
 {
-	return this->getBaseVtkImageData()->GetDimensions()[2]==1;
+	return this->getDimensions()[2]==1;
 }
 
 void Image::addXml(QDomNode& dataNode)
@@ -871,9 +955,32 @@ int Image::getInterpolationType() const
 
 vtkImageDataPtr Image::resample(long maxVoxels)
 {
+	QMutexLocker locker(&mBrickedMutex);
+	bool outOfCore = this->isOutOfCore();
+	BrickedVolumePtr volume = mBrickedVolume;
+	locker.unlock();
+
+	if (outOfCore)
+	{
+		// read every n'th voxel instead of loading the volume
+		if (!mResampled || mResampledInput || mResampledMaxVoxels!=maxVoxels)
+		{
+			mResampled = convertImageDataToGrayScale(volume->createDownsampled(maxVoxels));
+			mResampledInput = NULL;
+			mResampledMaxVoxels = maxVoxels;
+		}
+		return mResampled;
+	}
+
 	// also use grayscale as vtk is incapable of rendering 3component color.
 	vtkImageDataPtr retval = this->getGrayScaleVtkImageData();
 
+	if (mResampled && mResampledInput==retval && mResampledModified==retval->GetMTime() && mResampledMaxVoxels==maxVoxels)
+		return mResampled;
+	mResampledInput = retval;
+	mResampledModified = retval->GetMTime();
+	mResampledMaxVoxels = maxVoxels;
+
 	double factor = computeResampleFactor(maxVoxels);
 
 	if (fabs(1.0-factor)>0.01) // resampling
@@ -897,9 +1004,22 @@ vtkImageDataPtr Image::resample(long maxVoxels)
 //									 + "Ratio: " + QString::number(factor, 'g', 2) + ", "
 //									 + "Original size: " + qstring_cast(voxelsOrig/1000/1000) + "M.");
 	}
+	mResampled = retval;
 	return retval;
 }
 
+vtkImageDataPtr Image::getPyramidLevel(int level)
+{
+	if (this->isOutOfCore())
+		return vtkImageDataPtr();
+	return mPyramid->getLevel(this->getGrayScaleVtkImageData(), level);
+}
+
+void Image::updatePyramidRegion(const IntBoundingBox3D& extent)
+{
+	mPyramid->updateRegion(this->getGrayScaleVtkImageData(), extent);
+}
+
 double Image::computeResampleFactor(long maxVoxels)
 {
 	if (maxVoxels==0)
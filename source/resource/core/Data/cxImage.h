@@ -18,11 +18,15 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <map>
 #include <vector>
+#include <QMutex>
 #include <boost/shared_ptr.hpp>
 #include "cxBoundingBox3D.h"
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 #include "cxData.h"
+#include "cxImageStatistics.h"
+#include "cxImagePyramid.h"
+#include "cxBrickedVolume.h"
 
 typedef boost::shared_ptr<std::map<int, int> > HistogramMapPtr;
 
@@ -74,7 +78,7 @@ public:
 	virtual void intitializeFromParentImage(ImagePtr parentImage);
 	virtual void setVtkImageData(const vtkImageDataPtr& data, bool resetTransferFunctions = true);
 
-	virtual vtkImageDataPtr getBaseVtkImageData(); ///< \return the vtkimagedata in the data coordinate space
+	virtual vtkImageDataPtr getBaseVtkImageData(); ///< \return the vtkimagedata in the data coordinate space. Loads the whole volume if out of core.
 	virtual vtkImageDataPtr getGrayScaleVtkImageData(); ///< as getBaseVtkImageData(), but constrained to 1 component if multicolor.
 	virtual vtkImageDataPtr get8bitGrayScaleVtkImageData();///< Have never been used or tested. Create a test for it
 	/** Return a version of this, containing image data and transfer functions converted to unsigned.
@@ -82,6 +86,20 @@ public:
 	  */
 	virtual ImagePtr getUnsigned(ImagePtr self);
 
+	/** Keep the voxels on disk instead of in a vtkImageData, for volumes too
+	 *  large for memory. Read parts of it with getRegion(). Calling
+	 *  getBaseVtkImageData() loads the whole volume, and logs a warning.
+	 */
+	virtual void setBrickedVolume(BrickedVolumePtr volume, bool resetTransferFunctions = true);
+	BrickedVolumePtr getBrickedVolume() const;
+	bool isOutOfCore() const; ///< the voxels are on disk only, see setBrickedVolume()
+	/** Copy of the voxels in extent, read through the bricks when out of core.
+	 *  See BrickedVolume::readRegion().
+	 */
+	vtkImageDataPtr getRegion(const IntBoundingBox3D& extent, int step=1);
+	Eigen::Array3i getDimensions() const;
+	int getScalarType() const;
+
 	virtual IMAGE_MODALITY getModality() const;
 	virtual void setModality(const IMAGE_MODALITY &val);
 	virtual IMAGE_SUBTYPE getImageType() const;
@@ -98,7 +116,8 @@ public:
 
 	virtual DoubleBoundingBox3D boundingBox() const; ///< bounding box in image space
 	virtual Eigen::Array3d getSpacing() const;
-	virtual vtkImageAccumulatePtr getHistogram();///< \return The histogram for the image
+	virtual ImageStatistics::Result getStatistics(); ///< Histogram, range etc. Exact when ready, otherwise a sampled estimate, see statisticsChanged().
+	virtual ImageStatistics::Result getExactStatistics(); ///< As getStatistics(), but waits for the exact values
 	virtual int getMax();	///< \return Return highest used value in the image
 	virtual int getMin();	///< \return Return lowest used value in the image
 	virtual int getRange();///< For convenience: getMax() - getMin()
@@ -148,7 +167,9 @@ public:
 	void setInterpolationType(int val);
 	int getInterpolationType() const;
 
-	vtkImageDataPtr resample(long maxVoxels);
+	vtkImageDataPtr resample(long maxVoxels); ///< grayscale image reduced below maxVoxels. The result is cached.
+	vtkImageDataPtr getPyramidLevel(int level); ///< grayscale image reduced by 2^level, zero if not built yet or out of core. See ImagePyramid.
+	void updatePyramidRegion(const IntBoundingBox3D& extent); ///< call after changing the voxels in extent in place, before emitting vtkImageDataChanged
 
 	virtual void save(const QString &basePath, FileManagerServicePtr filemanager);
 
@@ -162,6 +183,7 @@ signals:
 	void vtkImageDataChanged(QString uid = QString()); ///< emitted when the vktimagedata are invalidated and must be retrieved anew.
 	void transferFunctionsChanged(); ///< emitted when image transfer functions in 2D or 3D are changed.
 	void cropBoxChanged();
+	void statisticsChanged(); ///< emitted when exact statistics replace the sampled estimate.
 
 protected slots:
 	virtual void transformChangedSlot();
@@ -172,8 +194,16 @@ protected:
 //	vtkImageReslicePtr mOrientator; ///< converts imagedata to outputimagedata
 //	vtkMatrix4x4Ptr mOrientatorMatrix;
 //	vtkImageDataPtr mReferenceImageData; ///< imagedata after filtering through the orientatior, given in reference space
-	vtkImageAccumulatePtr mHistogramPtr;///< Histogram
+	ImageStatisticsPtr mStatistics; ///< cached histogram and range
+	ImagePyramidPtr mPyramid; ///< downsampled versions for interactive display
+	vtkImageDataPtr mResampled; ///< cached result of resample()
+	vtkImageDataPtr mResampledInput;
+	vtkMTimeType mResampledModified;
+	long mResampledMaxVoxels;
 	ImagePtr mUnsigned; ///< version of this containing unsigned data.
+	BrickedVolumePtr mBrickedVolume; ///< voxels on disk, see setBrickedVolume()
+	vtkImageDataPtr mBrickedPreview; ///< downsampled mBrickedVolume, for statistics
+	ImageStatistics::Result mBrickedStatistics; ///< exact statistics of mBrickedVolume, computed on demand
 
 //	LandmarksPtr mLandmarks;
 
@@ -184,7 +214,6 @@ protected:
 
 	IMAGE_MODALITY mModality; ///< modality of the image, defined as DICOM tag (0008,0060), Section 3, C.7.3.1.1.1
 	IMAGE_SUBTYPE mImageType; ///< type of the image, defined as DICOM tag (0008,0008) (mainly value 3, but might be a merge of value 4), Section 3, C.7.6.1.1.2
-	double mMaxRGBIntensity;
 	int mInterpolationType; ///< mirror the interpolationType in vtkVolumeProperty
 
 
@@ -198,6 +227,8 @@ private:
 	double loadAttribute(QDomNode dataNode, QString name, double defVal);
 
 	double computeResampleFactor(long maxVoxels);
+	vtkImageDataPtr getStatisticsInput();
+	void materializeBrickedVolume();
 
 	ColorMap createPreviewColorMap(const Eigen::Vector2d &threshold);
 	IntIntMap createPreviewOpacityMap(const Eigen::Vector2d &threshold);
@@ -216,6 +247,8 @@ private:
 	bool mThresholdPreview;
 	ImageTF3DPtr mTresholdPreviewTransferfunctions3D;
 	ImageLUT2DPtr mTresholdPreviewLookupTable2D;
+
+	mutable QMutex mBrickedMutex; ///< guards mBrickedVolume, the data created from it and mBaseImageData
 };
 
 } // end namespace cx
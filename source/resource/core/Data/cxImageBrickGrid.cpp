@@ -0,0 +1,309 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImageBrickGrid.h"
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkTemplateAliasMacro.h>
+
+namespace cx
+{
+
+namespace
+{
+const int refineSteps = 8;
+
+/** Voxel access for the first component of an image.
+ */
+template<class T>
+class Voxels
+{
+public:
+	Voxels(const T* data, const int* dim, int numComps) :
+		mData(data)
+	{
+		for (int i=0; i<3; ++i)
+		{
+			mMax[i] = dim[i]-1;
+			mStep[i] = (dim[i]>1) ? 1 : 0;
+		}
+		mInc[0] = numComps;
+		mInc[1] = mInc[0]*dim[0];
+		mInc[2] = mInc[1]*dim[1];
+	}
+
+	inline double at(int x, int y, int z) const
+	{
+		return mData[x*mInc[0] + y*mInc[1] + z*mInc[2]];
+	}
+
+	/** Linear interpolation at the continuous index p, clamped to the volume.
+	 */
+	inline double sample(const double* p) const
+	{
+		int i[3];
+		double f[3];
+		for (int k=0; k<3; ++k)
+		{
+			double x = std::min(std::max(p[k], 0.0), double(mMax[k]));
+			i[k] = std::max(0, std::min(int(x), mMax[k]-1));
+			f[k] = x - i[k];
+		}
+		int j[3] = { i[0]+mStep[0], i[1]+mStep[1], i[2]+mStep[2] };
+		double v00 = (1-f[0])*this->at(i[0],i[1],i[2]) + f[0]*this->at(j[0],i[1],i[2]);
+		double v10 = (1-f[0])*this->at(i[0],j[1],i[2]) + f[0]*this->at(j[0],j[1],i[2]);
+		double v01 = (1-f[0])*this->at(i[0],i[1],j[2]) + f[0]*this->at(j[0],i[1],j[2]);
+		double v11 = (1-f[0])*this->at(i[0],j[1],j[2]) + f[0]*this->at(j[0],j[1],j[2]);
+		return (1-f[2])*((1-f[1])*v00 + f[1]*v10) + f[2]*((1-f[1])*v01 + f[1]*v11);
+	}
+
+private:
+	const T* mData;
+	int mMax[3];
+	int mStep[3];
+	vtkIdType mInc[3];
+};
+
+template<class T>
+void computeRanges(const T* data, const int* dim, int numComps, const int* bricks, std::vector<float>& minValues, std::vector<float>& maxValues)
+{
+	Voxels<T> voxels(data, dim, numComps);
+	const int size = ImageBrickGrid::brickSize;
+
+	std::vector<int> layers;
+	for (int bz=0; bz<bricks[2]; ++bz)
+		layers.push_back(bz);
+
+	QtConcurrent::blockingMap(layers, [&](int bz)
+	{
+		int z0 = bz*size;
+		int z1 = std::min(z0+size, dim[2]-1);
+		for (int by=0; by<bricks[1]; ++by)
+		{
+			int y0 = by*size;
+			int y1 = std::min(y0+size, dim[1]-1);
+			for (int bx=0; bx<bricks[0]; ++bx)
+			{
+				int x0 = bx*size;
+				int x1 = std::min(x0+size, dim[0]-1);
+				double min = std::numeric_limits<double>::max();
+				double max = std::numeric_limits<double>::lowest();
+				for (int z=z0; z<=z1; ++z)
+					for (int y=y0; y<=y1; ++y)
+						for (int x=x0; x<=x1; ++x)
+						{
+							double value = voxels.at(x, y, z);
+							min = std::min(min, value);
+							max = std::max(max, value);
+						}
+				int index = (bz*bricks[1] + by)*bricks[0] + bx;
+				// round outwards to keep the range conservative
+				minValues[index] = std::nextafter(float(min), std::numeric_limits<float>::lowest());
+				maxValues[index] = std::nextafter(float(max), std::numeric_limits<float>::max());
+			}
+		}
+	});
+}
+
+inline bool isInside(double value, const ImageBrickGrid::Intervals& intervals)
+{
+	for (unsigned i=0; i<intervals.size(); ++i)
+		if (intervals[i].first<=value && value<=intervals[i].second)
+			return true;
+	return false;
+}
+
+/** Everything intersect needs, in continuous voxel index space.
+ */
+struct Ray
+{
+	double o[3];
+	double d[3];
+	double t0;
+	double t1;
+	double dt; ///< sample step, at most half a voxel along each axis
+};
+
+template<class T>
+bool intersectTyped(const Voxels<T>& voxels, const Ray& ray, const int* bricks,
+					const std::vector<float>& minValues, const std::vector<float>& maxValues,
+					const ImageBrickGrid::Intervals& intervals, double* result)
+{
+	const int size = ImageBrickGrid::brickSize;
+	std::vector<char> candidate(minValues.size());
+	for (unsigned i=0; i<minValues.size(); ++i)
+	{
+		candidate[i] = false;
+		for (unsigned j=0; j<intervals.size(); ++j)
+			if (intervals[j].first<=maxValues[i] && minValues[i]<=intervals[j].second)
+				candidate[i] = true;
+	}
+
+	double p[3];
+	for (long k=0; ; )
+	{
+		double t = ray.t0 + k*ray.dt;
+		if (t > ray.t1)
+			return false;
+		int b[3];
+		for (int i=0; i<3; ++i)
+		{
+			p[i] = ray.o[i] + t*ray.d[i];
+			b[i] = std::max(0, std::min(int(std::floor(p[i]/size)), bricks[i]-1));
+		}
+
+		if (!candidate[(b[2]*bricks[1] + b[1])*bricks[0] + b[0]])
+		{
+			// jump to the first sample after the brick exit
+			double exit = ray.t1;
+			for (int i=0; i<3; ++i)
+			{
+				if (ray.d[i]>0)
+					exit = std::min(exit, ((b[i]+1)*size - ray.o[i])/ray.d[i]);
+				else if (ray.d[i]<0)
+					exit = std::min(exit, (b[i]*size - ray.o[i])/ray.d[i]);
+			}
+			k = std::max(k+1, long(std::floor((exit-ray.t0)/ray.dt))+1);
+			continue;
+		}
+
+		if (!isInside(voxels.sample(p), intervals))
+		{
+			++k;
+			continue;
+		}
+
+		// the previous sample is outside, either sampled or in a skipped brick
+		double lo = std::max(ray.t0, t-ray.dt);
+		double hi = t;
+		if (k==0)
+			lo = hi;
+		for (int i=0; i<refineSteps && lo<hi; ++i)
+		{
+			double mid = (lo+hi)/2;
+			double q[3] = { ray.o[0]+mid*ray.d[0], ray.o[1]+mid*ray.d[1], ray.o[2]+mid*ray.d[2] };
+			if (isInside(voxels.sample(q), intervals))
+				hi = mid;
+			else
+				lo = mid;
+		}
+		*result = hi;
+		return true;
+	}
+}
+} // namespace
+
+ImageBrickGrid::ImageBrickGrid(vtkImageDataPtr image) :
+	mImage(image),
+	mSourceMTime(0)
+{
+	for (int i=0; i<3; ++i)
+	{
+		mDim[i] = 0;
+		mBricks[i] = 0;
+		mOrigin[i] = 0;
+		mSpacing[i] = 1;
+	}
+	if (!image || !image->GetPointData()->GetScalars())
+		return;
+
+	mSourceMTime = image->GetMTime();
+	int extent[6];
+	image->GetDimensions(mDim);
+	image->GetExtent(extent);
+	image->GetSpacing(mSpacing);
+	image->GetOrigin(mOrigin);
+	for (int i=0; i<3; ++i)
+	{
+		mOrigin[i] += extent[2*i]*mSpacing[i];
+		mBricks[i] = std::max(1, (mDim[i]-1+brickSize-1)/brickSize);
+	}
+
+	int count = mBricks[0]*mBricks[1]*mBricks[2];
+	mMin.resize(count);
+	mMax.resize(count);
+	int numComps = image->GetNumberOfScalarComponents();
+	void* data = image->GetScalarPointer();
+	switch (image->GetScalarType())
+	{
+		vtkTemplateAliasMacro(computeRanges(static_cast<VTK_TT*>(data), mDim, numComps, mBricks, mMin, mMax));
+	default:
+		mMin.clear();
+		mMax.clear();
+		break;
+	}
+}
+
+Eigen::Array3i ImageBrickGrid::getBrickDimensions() const
+{
+	return Eigen::Array3i(mBricks[0], mBricks[1], mBricks[2]);
+}
+
+std::pair<double,double> ImageBrickGrid::getBrickRange(int x, int y, int z) const
+{
+	int index = (z*mBricks[1] + y)*mBricks[0] + x;
+	return std::make_pair(mMin[index], mMax[index]);
+}
+
+vtkMTimeType ImageBrickGrid::getSourceMTime() const
+{
+	return mSourceMTime;
+}
+
+bool ImageBrickGrid::intersect(const Vector3D& origin, const Vector3D& direction, double tMin, double tMax, const Intervals& intervals, double* t) const
+{
+	if (mMin.empty() || intervals.empty())
+		return false;
+
+	// clip the ray to the volume, in voxel index space
+	Ray ray;
+	ray.t0 = tMin;
+	ray.t1 = tMax;
+	double maxStep = 0;
+	for (int i=0; i<3; ++i)
+	{
+		ray.o[i] = (origin[i]-mOrigin[i])/mSpacing[i];
+		ray.d[i] = direction[i]/mSpacing[i];
+		maxStep = std::max(maxStep, std::fabs(ray.d[i]));
+
+		double lo = 0;
+		double hi = mDim[i]-1;
+		if (ray.d[i]==0)
+		{
+			if (ray.o[i]<lo || ray.o[i]>hi)
+				return false;
+			continue;
+		}
+		double ta = (lo-ray.o[i])/ray.d[i];
+		double tb = (hi-ray.o[i])/ray.d[i];
+		ray.t0 = std::max(ray.t0, std::min(ta, tb));
+		ray.t1 = std::min(ray.t1, std::max(ta, tb));
+	}
+	if (ray.t0>ray.t1 || maxStep==0)
+		return false;
+	ray.dt = 0.5/maxStep;
+
+	void* data = mImage->GetScalarPointer();
+	int numComps = mImage->GetNumberOfScalarComponents();
+	switch (mImage->GetScalarType())
+	{
+		vtkTemplateAliasMacro(return intersectTyped(Voxels<VTK_TT>(static_cast<VTK_TT*>(data), mDim, numComps), ray, mBricks, mMin, mMax, intervals, t));
+	default:
+		return false;
+	}
+}
+
+} // namespace cx
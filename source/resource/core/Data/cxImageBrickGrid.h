@@ -0,0 +1,77 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGEBRICKGRID_H
+#define CXIMAGEBRICKGRID_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <vector>
+#include <utility>
+#include "vtkForwardDeclarations.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ImageBrickGrid> ImageBrickGridPtr;
+
+/** \brief Min/max of a volume in bricks, for ray casting with empty space skipping.
+ *
+ * The volume is divided into bricks of brickSize^3 voxel cells. Each brick
+ * stores the range of the voxels it touches, including the shared
+ * boundary voxels, thus the range also bounds every linearly
+ * interpolated value inside the brick.
+ *
+ * intersect() marches a ray through the volume and returns the first
+ * point where the interpolated value lies inside one of a set of
+ * value intervals, e.g. where the opacity of a transfer function is
+ * above a limit. Bricks with a range outside all intervals are
+ * skipped in one step.
+ *
+ * Only the first component of the scalars is used.
+ * The grid is a snapshot: rebuild it if the image changes.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ImageBrickGrid
+{
+public:
+	static const int brickSize = 8;
+	typedef std::vector<std::pair<double,double> > Intervals; ///< closed value intervals
+
+	explicit ImageBrickGrid(vtkImageDataPtr image); ///< computes the bricks in parallel
+
+	/** Find the first t in [tMin,tMax] where the value at origin + t*direction
+	 *  lies inside intervals. Positions are in the physical coordinates
+	 *  of the image. Return false if there is none.
+	 */
+	bool intersect(const Vector3D& origin, const Vector3D& direction, double tMin, double tMax, const Intervals& intervals, double* t) const;
+
+	Eigen::Array3i getBrickDimensions() const;
+	std::pair<double,double> getBrickRange(int x, int y, int z) const;
+	vtkMTimeType getSourceMTime() const; ///< modification time of the input when built
+
+private:
+	vtkImageDataPtr mImage;
+	int mDim[3];
+	int mBricks[3];
+	double mOrigin[3]; ///< physical position of voxel 0
+	double mSpacing[3];
+	std::vector<float> mMin;
+	std::vector<float> mMax;
+	vtkMTimeType mSourceMTime;
+};
+
+} // namespace cx
+
+#endif // CXIMAGEBRICKGRID_H
@@ -128,7 +128,7 @@ double_pair ImageDefaultTFGenerator::guessInitialScalarRange() const
 
 bool ImageDefaultTFGenerator::isUnsignedChar() const
 {
-	return mImage->getBaseVtkImageData()->GetScalarType() == VTK_UNSIGNED_CHAR;
+	return mImage->getScalarType() == VTK_UNSIGNED_CHAR;
 }
 
 bool ImageDefaultTFGenerator::looksLikeBinaryImage() const
@@ -148,9 +148,8 @@ double_pair ImageDefaultTFGenerator::ensureNonZeroRoundedRange(double_pair range
 
 double_pair ImageDefaultTFGenerator::getFullScalarRange() const
 {
-	double smin = mImage->getBaseVtkImageData()->GetScalarRange()[0];
-	double smax = mImage->getBaseVtkImageData()->GetScalarRange()[1];
-	return std::make_pair(smin, smax);
+	ImageStatistics::Result statistics = mImage->getStatistics();
+	return std::make_pair(statistics.min, statistics.max);
 }
 
 double_pair ImageDefaultTFGenerator::getInitialWindowRange() const
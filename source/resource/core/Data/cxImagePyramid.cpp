@@ -0,0 +1,243 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImagePyramid.h"
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkTemplateAliasMacro.h>
+
+namespace cx
+{
+
+namespace
+{
+template<class T>
+inline T roundTo(double value)
+{
+	if (std::numeric_limits<T>::is_integer)
+		return static_cast<T>(std::floor(value+0.5));
+	return static_cast<T>(value);
+}
+
+/** Compute the output voxels in region (inclusive) as the mean of the
+ *  corresponding 2x2x2 input voxels. Edge voxels are repeated for odd sizes.
+ */
+template<class T>
+void downsampleTyped(const T* in, const int* inDim, T* out, const int* outDim, int numComps, const IntBoundingBox3D& region)
+{
+	std::vector<int> slices;
+	for (int z=region[4]; z<=region[5]; ++z)
+		slices.push_back(z);
+
+	QtConcurrent::blockingMap(slices, [&](int z)
+	{
+		vtkIdType inSlice = vtkIdType(inDim[0])*inDim[1];
+		int zi[2] = { 2*z, std::min(2*z+1, inDim[2]-1) };
+		for (int y=region[2]; y<=region[3]; ++y)
+		{
+			int yi[2] = { 2*y, std::min(2*y+1, inDim[1]-1) };
+			T* dst = out + ((vtkIdType(z)*outDim[1] + y)*outDim[0] + region[0])*numComps;
+			for (int x=region[0]; x<=region[1]; ++x)
+			{
+				int xi[2] = { 2*x, std::min(2*x+1, inDim[0]-1) };
+				for (int c=0; c<numComps; ++c)
+				{
+					double sum = 0;
+					for (int k=0; k<2; ++k)
+						for (int j=0; j<2; ++j)
+						{
+							const T* row = in + (zi[k]*inSlice + vtkIdType(yi[j])*inDim[0])*numComps + c;
+							sum += row[xi[0]*numComps];
+							sum += row[xi[1]*numComps];
+						}
+					*dst++ = roundTo<T>(sum*0.125);
+				}
+			}
+		}
+	});
+}
+
+void downsampleRegion(vtkImageDataPtr input, vtkImageDataPtr output, const IntBoundingBox3D& region)
+{
+	int inDim[3];
+	int outDim[3];
+	input->GetDimensions(inDim);
+	output->GetDimensions(outDim);
+	int numComps = input->GetNumberOfScalarComponents();
+	void* in = input->GetScalarPointer();
+	void* out = output->GetScalarPointer();
+
+	switch (input->GetScalarType())
+	{
+		vtkTemplateAliasMacro(downsampleTyped(static_cast<VTK_TT*>(in), inDim, static_cast<VTK_TT*>(out), outDim, numComps, region));
+	default:
+		break;
+	}
+}
+} // namespace
+
+ImagePyramid::ImagePyramid() :
+	mModified(0),
+	mWatcher(this)
+{
+	connect(&mWatcher, &QFutureWatcher<std::vector<vtkImageDataPtr> >::finished, this, &ImagePyramid::buildFinishedSlot);
+}
+
+ImagePyramid::~ImagePyramid()
+{
+}
+
+vtkImageDataPtr ImagePyramid::downsample(vtkImageDataPtr input)
+{
+	int inDim[3];
+	int extent[6];
+	double spacing[3];
+	double origin[3];
+	input->GetDimensions(inDim);
+	input->GetExtent(extent);
+	input->GetSpacing(spacing);
+	input->GetOrigin(origin);
+
+	// keep the physical region: the center of output voxel 0 is between input voxel 0 and 1.
+	int outDim[3];
+	double outSpacing[3];
+	double outOrigin[3];
+	for (int i=0; i<3; ++i)
+	{
+		outDim[i] = (inDim[i]+1)/2;
+		outSpacing[i] = 2*spacing[i];
+		outOrigin[i] = origin[i] + extent[2*i]*spacing[i];
+		if (inDim[i]>1)
+			outOrigin[i] += 0.5*spacing[i];
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetDimensions(outDim);
+	retval->SetSpacing(outSpacing);
+	retval->SetOrigin(outOrigin);
+	retval->AllocateScalars(input->GetScalarType(), input->GetNumberOfScalarComponents());
+
+	downsampleRegion(input, retval, IntBoundingBox3D(0, outDim[0]-1, 0, outDim[1]-1, 0, outDim[2]-1));
+	return retval;
+}
+
+std::vector<vtkImageDataPtr> ImagePyramid::build(vtkImageDataPtr input)
+{
+	std::vector<vtkImageDataPtr> retval;
+	vtkImageDataPtr current = input;
+	for (int level=1; level<=maxLevel; ++level)
+	{
+		current = downsample(current);
+		retval.push_back(current);
+	}
+	return retval;
+}
+
+bool ImagePyramid::isCurrent(vtkImageDataPtr image) const
+{
+	return mImage==image && image->GetMTime()==mModified;
+}
+
+void ImagePyramid::start(vtkImageDataPtr image)
+{
+	mImage = image;
+	mModified = image->GetMTime();
+	mLevels.clear();
+
+	mFuture = QtConcurrent::run(&ImagePyramid::build, image);
+	mWatcher.setFuture(mFuture);
+}
+
+void ImagePyramid::buildFinishedSlot()
+{
+	if (!mImage || !mLevels.empty() || !mFuture.isFinished())
+		return;
+	if (!this->isCurrent(mImage))
+		return;
+	mLevels = mFuture.result();
+	emit levelsChanged();
+}
+
+vtkImageDataPtr ImagePyramid::getLevel(vtkImageDataPtr image, int level)
+{
+	if (!image || level<0 || level>maxLevel)
+		return vtkImageDataPtr();
+	if (level==0)
+		return image;
+
+	if (!this->isCurrent(image))
+		this->start(image);
+	if (mLevels.empty() && mFuture.isFinished())
+		this->buildFinishedSlot(); // no event loop might be running in this thread
+	if (mLevels.empty())
+		return vtkImageDataPtr();
+	return mLevels[level-1];
+}
+
+void ImagePyramid::waitForLevels(vtkImageDataPtr image)
+{
+	if (!image)
+		return;
+	if (!this->isCurrent(image))
+		this->start(image);
+	mFuture.waitForFinished();
+	this->buildFinishedSlot();
+}
+
+void ImagePyramid::updateRegion(vtkImageDataPtr image, const IntBoundingBox3D& extent)
+{
+	if (!image || mImage!=image)
+		return;
+	if (mLevels.empty())
+	{
+		// a build of the old data might be running: restart from the new data.
+		this->start(image);
+		return;
+	}
+
+	vtkImageDataPtr previous = image;
+	IntBoundingBox3D region = extent;
+	for (unsigned i=0; i<mLevels.size(); ++i)
+	{
+		int dim[3];
+		mLevels[i]->GetDimensions(dim);
+		for (int j=0; j<3; ++j)
+		{
+			region[2*j] = std::max(0, region[2*j]/2);
+			region[2*j+1] = std::min(dim[j]-1, region[2*j+1]/2);
+		}
+		if (region[0]>region[1] || region[2]>region[3] || region[4]>region[5])
+			break;
+
+		downsampleRegion(previous, mLevels[i], region);
+		mLevels[i]->Modified();
+		mLevels[i]->GetPointData()->GetScalars()->Modified();
+		previous = mLevels[i];
+	}
+
+	mModified = image->GetMTime();
+	emit levelsChanged();
+}
+
+void ImagePyramid::clear()
+{
+	mImage = vtkImageDataPtr();
+	mModified = 0;
+	mLevels.clear();
+}
+
+} // namespace cx
@@ -0,0 +1,82 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGEPYRAMID_H
+#define CXIMAGEPYRAMID_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <vector>
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include "vtkForwardDeclarations.h"
+#include "cxBoundingBox3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ImagePyramid> ImagePyramidPtr;
+
+/** \brief Downsampled versions of a volume for interactive display.
+ *
+ * Level 0 is the input, level n is reduced by a factor 2^n along
+ * each axis using a 2x2x2 box filter. Level n covers the same
+ * physical region as the input.
+ *
+ * The levels are built lazily in the background on the first
+ * request, and getLevel() returns zero until they are ready.
+ * levelsChanged() is emitted when they are.
+ *
+ * The levels follow the modification time of the input:
+ * if the input changes, they are rebuilt. If the changed region
+ * is known, call updateRegion() to recompute only the affected
+ * part of each level.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ImagePyramid : public QObject
+{
+	Q_OBJECT
+public:
+	static const int maxLevel = 3; ///< coarsest level, 8x reduction
+
+	ImagePyramid();
+	virtual ~ImagePyramid();
+
+	vtkImageDataPtr getLevel(vtkImageDataPtr image, int level); ///< the level if ready, otherwise zero. Starts building if necessary.
+	void waitForLevels(vtkImageDataPtr image); ///< build the levels if necessary, and block until ready
+	void updateRegion(vtkImageDataPtr image, const IntBoundingBox3D& extent); ///< image voxels in extent have changed, recompute the corresponding part of the levels
+	void clear();
+
+	static vtkImageDataPtr downsample(vtkImageDataPtr input); ///< 2x2x2 box filter, computed in parallel
+	static std::vector<vtkImageDataPtr> build(vtkImageDataPtr input); ///< all levels from 1 to maxLevel
+
+signals:
+	void levelsChanged();
+
+private slots:
+	void buildFinishedSlot();
+private:
+	bool isCurrent(vtkImageDataPtr image) const;
+	void start(vtkImageDataPtr image);
+
+	vtkImageDataPtr mImage;
+	vtkMTimeType mModified;
+	std::vector<vtkImageDataPtr> mLevels; ///< level 1..maxLevel, stored at index 0..maxLevel-1
+	QFuture<std::vector<vtkImageDataPtr> > mFuture;
+	QFutureWatcher<std::vector<vtkImageDataPtr> > mWatcher;
+};
+
+} // namespace cx
+
+#endif // CXIMAGEPYRAMID_H
@@ -0,0 +1,482 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImageStatistics.h"
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkTemplateAliasMacro.h>
+#include "cxBrickedVolume.h"
+
+namespace cx
+{
+
+namespace
+{
+const vtkIdType maxEstimateSamples = 1<<18;
+const qint64 maxSlabBytes = 64*1024*1024; ///< memory used per slab of a bricked volume
+
+/** Partial result for a range of samples.
+ */
+struct Chunk
+{
+	Chunk() : begin(0), end(0), min(0), max(0), rgbMax(0), nonZero(0) {}
+	vtkIdType begin; ///< first sample, voxel index is sample*stride
+	vtkIdType end;
+	double min;
+	double max;
+	double rgbMax; ///< max sum of three components
+	vtkIdType nonZero;
+	std::vector<vtkIdType> bins;
+};
+
+/** Division rounding towards minus infinity. */
+inline int floorDivide(int value, int divisor)
+{
+	int retval = value/divisor;
+	if (value%divisor && value<0)
+		--retval;
+	return retval;
+}
+
+/** Add the bins of source to target. The bin width of target is
+ *  a multiple of the source width, and both origins are multiples
+ *  of their width, so each source bin falls in one target bin.
+ */
+void addBins(ImageStatistics::Result& target, const ImageStatistics::Result& source)
+{
+	for (unsigned i=0; i<source.histogram.size(); ++i)
+	{
+		int value = source.histogramOrigin + int(i)*source.histogramBinWidth;
+		target.histogram[floorDivide(value - target.histogramOrigin, target.histogramBinWidth)] += source.histogram[i];
+	}
+}
+
+std::vector<Chunk> createChunks(vtkIdType samples)
+{
+	int numChunks = 1;
+	if (samples > maxEstimateSamples)
+		numChunks = QThread::idealThreadCount()*4;
+	numChunks = std::max<vtkIdType>(1, std::min<vtkIdType>(numChunks, samples));
+
+	std::vector<Chunk> chunks(numChunks);
+	for (int i=0; i<numChunks; ++i)
+	{
+		chunks[i].begin = (samples*i)/numChunks;
+		chunks[i].end = (samples*(i+1))/numChunks;
+	}
+	return chunks;
+}
+
+template<class T>
+void runChunks(std::vector<Chunk>& chunks, T function)
+{
+	if (chunks.size()==1)
+		function(chunks[0]);
+	else
+		QtConcurrent::blockingMap(chunks, function);
+}
+
+/** Gray value used for the histogram: the first component,
+ *  or luminance as vtkImageLuminance for multicomponent images.
+ */
+template<class T>
+inline double grayValue(const T* voxel, int numComps)
+{
+	if (numComps < 3)
+		return voxel[0];
+	return static_cast<T>(0.30*voxel[0] + 0.59*voxel[1] + 0.11*voxel[2]);
+}
+
+/** Single pass for 8 and 16 bit single component data:
+ *  bin over the full type range, and read min/max from the bins.
+ */
+template<class T>
+ImageStatistics::Result computeFused(const T* data, vtkIdType samples, int stride)
+{
+	const int typeMin = std::numeric_limits<T>::min();
+	const int typeBins = int(std::numeric_limits<T>::max()) - typeMin + 1;
+
+	std::vector<Chunk> chunks = createChunks(samples);
+	runChunks(chunks, [&](Chunk& chunk)
+	{
+		chunk.bins.assign(typeBins, 0);
+		vtkIdType* bins = &chunk.bins[0] - typeMin;
+		const T* ptr = data + chunk.begin*stride;
+		for (vtkIdType i=chunk.begin; i<chunk.end; ++i, ptr+=stride)
+			++bins[*ptr];
+	});
+
+	std::vector<vtkIdType> bins(typeBins, 0);
+	for (unsigned c=0; c<chunks.size(); ++c)
+		for (int i=0; i<typeBins; ++i)
+			bins[i] += chunks[c].bins[i];
+
+	int first = 0;
+	while (first<typeBins-1 && !bins[first])
+		++first;
+	int last = typeBins-1;
+	while (last>first && !bins[last])
+		--last;
+
+	ImageStatistics::Result retval;
+	retval.min = first + typeMin;
+	retval.max = last + typeMin;
+	retval.histogramOrigin = first + typeMin;
+	retval.histogram.assign(bins.begin()+first, bins.begin()+last+1);
+
+	vtkIdType zeros = 0;
+	if (retval.min<=0 && 0<=retval.max)
+	{
+		zeros = retval.histogram[-retval.histogramOrigin];
+		retval.histogram[-retval.histogramOrigin] = 0;
+	}
+	retval.nonZeroCount = samples - zeros;
+	return retval;
+}
+
+/** Two passes for other types and multicomponent data:
+ *  range first, then histogram over the range.
+ */
+template<class T>
+ImageStatistics::Result computeGeneric(const T* data, vtkIdType samples, int stride, int numComps)
+{
+	const vtkIdType step = vtkIdType(stride)*numComps;
+
+	std::vector<Chunk> chunks = createChunks(samples);
+	runChunks(chunks, [&](Chunk& chunk)
+	{
+		const T* ptr = data + chunk.begin*step;
+		double min = std::numeric_limits<double>::max();
+		double max = std::numeric_limits<double>::lowest();
+		double rgbMax = 0;
+		for (vtkIdType i=chunk.begin; i<chunk.end; ++i, ptr+=step)
+		{
+			double value = ptr[0];
+			min = std::min(min, value);
+			max = std::max(max, value);
+			if (numComps==3)
+				rgbMax = std::max(rgbMax, double(ptr[0])+double(ptr[1])+double(ptr[2]));
+		}
+		chunk.min = min;
+		chunk.max = max;
+		chunk.rgbMax = rgbMax;
+	});
+
+	ImageStatistics::Result retval;
+	retval.min = chunks[0].min;
+	retval.max = chunks[0].max;
+	double rgbMax = 0;
+	for (unsigned c=0; c<chunks.size(); ++c)
+	{
+		retval.min = std::min(retval.min, chunks[c].min);
+		retval.max = std::max(retval.max, chunks[c].max);
+		rgbMax = std::max(rgbMax, chunks[c].rgbMax);
+	}
+	retval.rgbMax = int(rgbMax)/3;
+
+	double lower = std::max(std::floor(retval.min), double(std::numeric_limits<int>::min()/2));
+	double upper = std::min((numComps==3) ? retval.rgbMax : std::floor(retval.max), double(std::numeric_limits<int>::max()/2));
+	int width = 1;
+	while ((upper-lower)/width+1 > ImageStatistics::maxHistogramBins)
+		width *= 2;
+	int origin = floorDivide(int(lower), width)*width;
+	int size = std::max(1, floorDivide(int(upper), width) - origin/width + 1);
+
+	runChunks(chunks, [&](Chunk& chunk)
+	{
+		chunk.bins.assign(size, 0);
+		const T* ptr = data + chunk.begin*step;
+		for (vtkIdType i=chunk.begin; i<chunk.end; ++i, ptr+=step)
+		{
+			double value = grayValue(ptr, numComps);
+			if (value==0)
+				continue;
+			++chunk.nonZero;
+			double bin = std::floor((value - origin)/width);
+			if (0<=bin && bin<size)
+				++chunk.bins[int(bin)];
+		}
+	});
+
+	retval.histogramOrigin = origin;
+	retval.histogramBinWidth = width;
+	retval.histogram.assign(size, 0);
+	retval.nonZeroCount = 0;
+	for (unsigned c=0; c<chunks.size(); ++c)
+	{
+		retval.nonZeroCount += chunks[c].nonZero;
+		for (int i=0; i<size; ++i)
+			retval.histogram[i] += chunks[c].bins[i];
+	}
+	return retval;
+}
+
+template<class T, bool SmallInteger = (std::numeric_limits<T>::is_integer && sizeof(T)<=2)>
+struct TypedStatistics
+{
+	static ImageStatistics::Result compute(const T* data, vtkIdType samples, int stride, int numComps)
+	{
+		return computeGeneric(data, samples, stride, numComps);
+	}
+};
+
+template<class T>
+struct TypedStatistics<T, true>
+{
+	static ImageStatistics::Result compute(const T* data, vtkIdType samples, int stride, int numComps)
+	{
+		if (numComps==1)
+			return computeFused(data, samples, stride);
+		return computeGeneric(data, samples, stride, numComps);
+	}
+};
+} // namespace
+
+ImageStatistics::Result::Result() :
+	valid(false),
+	exact(false),
+	min(0),
+	max(0),
+	rgbMax(0),
+	voxelCount(0),
+	nonZeroCount(0),
+	histogramOrigin(0),
+	histogramBinWidth(1)
+{
+}
+
+vtkIdType ImageStatistics::Result::getCount(int value) const
+{
+	int bin = floorDivide(value - histogramOrigin, histogramBinWidth);
+	if (bin<0 || bin>=int(histogram.size()))
+		return 0;
+	return histogram[bin];
+}
+
+vtkIdType ImageStatistics::Result::getMaxCount() const
+{
+	if (histogram.empty())
+		return 0;
+	return *std::max_element(histogram.begin(), histogram.end());
+}
+
+double ImageStatistics::Result::getPercentile(double fraction) const
+{
+	vtkIdType total = 0;
+	for (unsigned i=0; i<histogram.size(); ++i)
+		total += histogram[i];
+
+	vtkIdType sum = 0;
+	for (unsigned i=0; i<histogram.size(); ++i)
+	{
+		sum += histogram[i];
+		if (sum >= fraction*total)
+			return histogramOrigin + int(i)*histogramBinWidth;
+	}
+	return max;
+}
+
+ImageStatistics::ImageStatistics() :
+	mModified(0),
+	mWatcher(this)
+{
+	connect(&mWatcher, &QFutureWatcher<Result>::finished, this, &ImageStatistics::computationFinishedSlot);
+}
+
+ImageStatistics::~ImageStatistics()
+{
+}
+
+int ImageStatistics::getEstimateStride(vtkImageDataPtr image)
+{
+	vtkIdType voxels = image->GetNumberOfPoints();
+	return std::max<vtkIdType>(1, voxels/maxEstimateSamples);
+}
+
+ImageStatistics::Result ImageStatistics::compute(vtkImageDataPtr image, int stride)
+{
+	Result retval;
+	if (!image || !image->GetPointData()->GetScalars())
+		return retval;
+
+	vtkIdType voxels = image->GetNumberOfPoints();
+	vtkIdType samples = (voxels+stride-1)/stride;
+	if (!samples)
+		return retval;
+
+	int numComps = image->GetNumberOfScalarComponents();
+	void* data = image->GetScalarPointer();
+	switch (image->GetScalarType())
+	{
+		vtkTemplateAliasMacro(retval = TypedStatistics<VTK_TT>::compute(static_cast<VTK_TT*>(data), samples, stride, numComps));
+	default:
+		return retval;
+	}
+
+	retval.valid = true;
+	retval.exact = (stride==1);
+	retval.voxelCount = voxels;
+	if (stride>1)
+	{
+		retval.nonZeroCount *= stride;
+		for (unsigned i=0; i<retval.histogram.size(); ++i)
+			retval.histogram[i] *= stride;
+	}
+	return retval;
+}
+
+ImageStatistics::Result ImageStatistics::compute(BrickedVolumePtr volume)
+{
+	Result retval;
+	if (!volume)
+		return retval;
+
+	// slabs of whole bricks, small enough to keep the memory use bounded
+	Eigen::Array3i dim = volume->getDimensions();
+	qint64 sliceBytes = volume->getSizeInBytes()/std::max(1, dim[2]);
+	int slabSlices = int(std::max<qint64>(1, maxSlabBytes/std::max<qint64>(1, sliceBytes)));
+	if (slabSlices > BrickedVolume::brickSize)
+		slabSlices -= slabSlices % BrickedVolume::brickSize;
+
+	for (int z=0; z<dim[2]; z+=slabSlices)
+	{
+		IntBoundingBox3D extent(0, dim[0]-1, 0, dim[1]-1, z, std::min(z+slabSlices, dim[2])-1);
+		Result slab = compute(volume->readRegion(extent));
+		if (!slab.valid)
+			return Result();
+		retval = merge(retval, slab);
+	}
+	return retval;
+}
+
+ImageStatistics::Result ImageStatistics::merge(const Result& a, const Result& b)
+{
+	if (!a.valid)
+		return b;
+	if (!b.valid)
+		return a;
+
+	Result retval;
+	retval.valid = true;
+	retval.exact = a.exact && b.exact;
+	retval.min = std::min(a.min, b.min);
+	retval.max = std::max(a.max, b.max);
+	retval.rgbMax = std::max(a.rgbMax, b.rgbMax);
+	retval.voxelCount = a.voxelCount + b.voxelCount;
+	retval.nonZeroCount = a.nonZeroCount + b.nonZeroCount;
+
+	int width = std::max(a.histogramBinWidth, b.histogramBinWidth);
+	int begin = std::min(a.histogramOrigin, b.histogramOrigin);
+	int end = std::max(a.histogramOrigin + int(a.histogram.size())*a.histogramBinWidth,
+					   b.histogramOrigin + int(b.histogram.size())*b.histogramBinWidth);
+	while ((end-begin)/width+1 > maxHistogramBins)
+		width *= 2;
+	retval.histogramBinWidth = width;
+	retval.histogramOrigin = floorDivide(begin, width)*width;
+	retval.histogram.assign(floorDivide(end-1-retval.histogramOrigin, width)+1, 0);
+	addBins(retval, a);
+	addBins(retval, b);
+	return retval;
+}
+
+ImageStatistics::Result ImageStatistics::scale(Result estimate, vtkIdType voxelCount)
+{
+	if (!estimate.valid || !estimate.voxelCount || estimate.voxelCount==voxelCount)
+		return estimate;
+	double factor = double(voxelCount)/estimate.voxelCount;
+	estimate.exact = false;
+	estimate.voxelCount = voxelCount;
+	estimate.nonZeroCount = vtkIdType(estimate.nonZeroCount*factor + 0.5);
+	for (unsigned i=0; i<estimate.histogram.size(); ++i)
+		estimate.histogram[i] = vtkIdType(estimate.histogram[i]*factor + 0.5);
+	return estimate;
+}
+
+bool ImageStatistics::isCurrent(vtkImageDataPtr image) const
+{
+	return mImage==image && image->GetMTime()==mModified;
+}
+
+/** Compute the estimate and start the exact computation.
+ *  The range of the estimate is that of the samples.
+ */
+void ImageStatistics::start(vtkImageDataPtr image)
+{
+	mImage = image;
+	mExact = Result();
+
+	int stride = getEstimateStride(image);
+	mEstimate = compute(image, stride);
+	mModified = image->GetMTime();
+
+	if (stride==1)
+	{
+		mExact = mEstimate;
+		return;
+	}
+
+	mFuture = QtConcurrent::run(&ImageStatistics::compute, image, 1);
+	mWatcher.setFuture(mFuture);
+}
+
+void ImageStatistics::computationFinishedSlot()
+{
+	if (mExact.valid || !mImage || !mFuture.isFinished())
+		return;
+	if (!this->isCurrent(mImage))
+		return;
+	mExact = mFuture.result();
+	emit exactResultReady();
+}
+
+ImageStatistics::Result ImageStatistics::get(vtkImageDataPtr image)
+{
+	if (!image)
+		return Result();
+	if (!this->isCurrent(image))
+		this->start(image);
+	if (!mExact.valid && mFuture.isFinished())
+		this->computationFinishedSlot(); // no event loop might be running in this thread
+	if (mExact.valid)
+		return mExact;
+	return mEstimate;
+}
+
+ImageStatistics::Result ImageStatistics::getExact(vtkImageDataPtr image)
+{
+	if (!image)
+		return Result();
+	if (!this->isCurrent(image))
+		this->start(image);
+	if (!mExact.valid)
+	{
+		mFuture.waitForFinished();
+		mExact = mFuture.result();
+		emit exactResultReady();
+	}
+	return mExact;
+}
+
+void ImageStatistics::clear()
+{
+	mImage = vtkImageDataPtr();
+	mModified = 0;
+	mEstimate = Result();
+	mExact = Result();
+}
+
+} // namespace cx
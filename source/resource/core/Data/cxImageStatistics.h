@@ -0,0 +1,112 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGESTATISTICS_H
+#define CXIMAGESTATISTICS_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <vector>
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ImageStatistics> ImageStatisticsPtr;
+typedef boost::shared_ptr<class BrickedVolume> BrickedVolumePtr;
+
+/** \brief Cached statistics for one vtkImageData.
+ *
+ * Computes scalar range, histogram, RGB max and non-zero count
+ * in one parallel pass over the voxels. The result is cached
+ * and recomputed when the image or its modification time changes.
+ *
+ * get() never blocks on the full pass: until the exact result is
+ * ready, a sampled estimate is returned and the exact result
+ * is computed in the background. exactResultReady() is emitted
+ * when it arrives. getExact() blocks.
+ *
+ * The histogram matches the one previously generated by
+ * vtkImageAccumulate in Image: bins of width 1 from the min value,
+ * zero values are not counted, and multicomponent images are
+ * binned by luminance. Ranges wider than maxHistogramBins, e.g. for
+ * float images, use wider bins.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ImageStatistics : public QObject
+{
+	Q_OBJECT
+public:
+	struct cxResource_EXPORT Result
+	{
+		Result();
+		bool valid;
+		bool exact; ///< false for a sampled estimate
+		double min; ///< range of the first component, as vtkImageData::GetScalarRange()
+		double max;
+		int rgbMax; ///< max of (r+g+b)/3 for 3-component images
+		vtkIdType voxelCount;
+		vtkIdType nonZeroCount; ///< number of voxels with nonzero histogram value
+		int histogramOrigin; ///< value of the first histogram bin, a multiple of histogramBinWidth
+		int histogramBinWidth; ///< 1, or a power of two if the range is wider than maxHistogramBins
+		std::vector<vtkIdType> histogram; ///< Estimates are scaled to the full voxel count.
+
+		vtkIdType getCount(int value) const; ///< number of voxels in the bin containing value
+		vtkIdType getMaxCount() const; ///< size of the largest bin
+		double getPercentile(double fraction) const; ///< value below which fraction of the nonzero voxels lie
+	};
+
+	static const int maxHistogramBins = 1<<16;
+
+	ImageStatistics();
+	virtual ~ImageStatistics();
+
+	Result get(vtkImageDataPtr image); ///< exact result if available, otherwise a sampled estimate
+	Result getExact(vtkImageDataPtr image); ///< wait for the exact result
+	void clear();
+
+	/** Compute statistics for image using every stride'th voxel.
+	 *  The pass is split into chunks running in parallel.
+	 */
+	static Result compute(vtkImageDataPtr image, int stride=1);
+	/** Exact statistics for a volume on disk, computed slab by slab
+	 *  without loading the volume.
+	 */
+	static Result compute(BrickedVolumePtr volume);
+	static Result merge(const Result& a, const Result& b); ///< statistics of the union of two disjoint voxel sets
+	static Result scale(Result estimate, vtkIdType voxelCount); ///< scale the counts of an estimate to voxelCount voxels
+	static int getEstimateStride(vtkImageDataPtr image);
+
+signals:
+	void exactResultReady();
+
+private slots:
+	void computationFinishedSlot();
+private:
+	bool isCurrent(vtkImageDataPtr image) const;
+	void start(vtkImageDataPtr image);
+
+	vtkImageDataPtr mImage;
+	vtkMTimeType mModified;
+	Result mEstimate;
+	Result mExact;
+	QFuture<Result> mFuture;
+	QFutureWatcher<Result> mWatcher;
+};
+
+} // namespace cx
+
+#endif // CXIMAGESTATISTICS_H
@@ -15,6 +15,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkColorSeries.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkPoints.h>
 #include <QDomDocument>
 #include <QColor>
 #include <QDir>
@@ -32,6 +34,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFileManagerService.h"
 #include "cxLogger.h"
 #include "cxNullDeleter.h"
+#include "cxMeshHelpers.h"
+#include "cxMeshIO.h"
+#include "cxSettings.h"
 
 namespace cx
 {
@@ -48,7 +53,7 @@ MeshPtr Mesh::create(const QString& uid, const QString& name, PatientModelServic
 
 Mesh::Mesh(const QString& uid, const QString& name, vtkPolyDataPtr polyData, PatientModelServicePtr patientModelService, SpaceProviderPtr spaceProvider) :
 	Data(uid, name), mVtkPolyData(polyData), mHasGlyph(false), mOrientationArray(""), mColorArray(""), mPatientModelService(patientModelService),
-	mSpaceProvider(spaceProvider), mTextureData(patientModelService)
+	mSpaceProvider(spaceProvider), mTextureData(patientModelService), mBVHSource(NULL)
 {
 	if (!mVtkPolyData)
 		mVtkPolyData = vtkPolyDataPtr::New();
@@ -132,6 +137,17 @@ vtkPolyDataPtr Mesh::getVtkPolyData() const
 	return mVtkPolyData;
 }
 
+MeshBVHPtr Mesh::getBVH() const
+{
+	// the polydata may be replaced or modified in place
+	if (!mBVH || mBVHSource!=mVtkPolyData.GetPointer() || (mVtkPolyData && mBVH->getSourceMTime()!=mVtkPolyData->GetMTime()))
+	{
+		mBVH.reset(new MeshBVH(mVtkPolyData));
+		mBVHSource = mVtkPolyData.GetPointer();
+	}
+	return mBVH;
+}
+
 vtkTexturePtr Mesh::getVtkTexture() const
 {
 	return mVtkTexture;
@@ -439,6 +455,50 @@ vtkPolyDataPtr Mesh::getTransformedPolyDataCopy(Transform3D transform)
 	return poly;
 }
 
+vtkPolyDataPtr Mesh::getTransformedPolyData(Transform3D transform)
+{
+	return createTransformedPolyData(this->getVtkPolyData(), transform);
+}
+
+namespace
+{
+void addArray(std::set<vtkDataArray*>* arrays, vtkDataArray* array)
+{
+	if (array)
+		arrays->insert(array);
+}
+
+void addArrays(std::set<vtkDataArray*>* arrays, vtkPolyDataPtr poly)
+{
+	if (!poly)
+		return;
+	if (poly->GetPoints())
+		addArray(arrays, poly->GetPoints()->GetData());
+	vtkCellArray* cells[] = { poly->GetVerts(), poly->GetLines(), poly->GetPolys(), poly->GetStrips() };
+	for (int i=0; i<4; ++i)
+		if (cells[i])
+			addArray(arrays, cells[i]->GetData());
+	for (int i=0; i<poly->GetPointData()->GetNumberOfArrays(); ++i)
+		addArray(arrays, poly->GetPointData()->GetArray(i));
+	for (int i=0; i<poly->GetCellData()->GetNumberOfArrays(); ++i)
+		addArray(arrays, poly->GetCellData()->GetArray(i));
+}
+} // namespace
+
+qint64 Mesh::getMemoryUsage() const
+{
+	std::set<vtkDataArray*> arrays;
+	addArrays(&arrays, mVtkPolyData);
+	addArrays(&arrays, mVtkPolyDataOriginal);
+
+	qint64 retval = 0;
+	for (std::set<vtkDataArray*>::iterator iter=arrays.begin(); iter!=arrays.end(); ++iter)
+		retval += qint64((*iter)->GetActualMemorySize())*1024;
+	if (mBVH)
+		retval += mBVH->getSizeInBytes();
+	return retval;
+}
+
 bool Mesh::isFiberBundle() const
 {
 	vtkPolyDataPtr poly = getVtkPolyData();
@@ -447,11 +507,22 @@ bool Mesh::isFiberBundle() const
 
 void Mesh::save(const QString& basePath, FileManagerServicePtr fileManager)
 {
-	QString filename = basePath + "/Images/" + this->getUid() + ".vtk";
+	QString ending = "vtk";
+	if (settings()->value("Mesh/binaryPatientFiles").toBool())
+		ending = MeshIO::getFileEnding();
+	QString filename = basePath + "/Images/" + this->getUid() + "." + ending;
 	this->setFilename(QDir(basePath).relativeFilePath(filename));
 	MeshPtr self = MeshPtr(this, null_deleter());
 	fileManager->save(self, filename);
 
+	// the file written with the other format is kept unless the user asked for removal,
+	// e.g. older versions of the application might still read it
+	if (settings()->value("Mesh/removeOtherFormatFiles").toBool())
+	{
+		QString other = (ending=="vtk") ? MeshIO::getFileEnding() : QString("vtk");
+		QFile::remove(basePath + "/Images/" + this->getUid() + "." + other);
+	}
+
 }
 
 } // namespace cx
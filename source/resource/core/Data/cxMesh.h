@@ -27,6 +27,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <QColor>
 #include "cxData.h"
+#include "cxMeshBVH.h"
 
 class QDomNode;
 class QDomDocument;
@@ -40,6 +41,11 @@ namespace cx
  * A mesh is implemented as a vtkPolyData, and
  * thus can represent whatever that class can.
  *
+ * The arrays of the polydata are treated as immutable and are shared
+ * with exports and derived meshes, see getTransformedPolyData().
+ * Editors create new polydata and call setVtkPolyData(). Polydata that
+ * must be modified in place is detached with detachSharedArrays() first.
+ *
  * \ingroup cx_resource_core_data
  */
 class cxResource_EXPORT Mesh: public Data
@@ -56,6 +62,7 @@ public:
 
 	virtual vtkPolyDataPtr getVtkPolyData() const;
 	virtual vtkTexturePtr getVtkTexture() const;
+	MeshBVHPtr getBVH() const; ///< triangle hierarchy for ray picking, rebuilt when the polydata changes
 
 	void addXml(QDomNode& dataNode); ///< adds xml information about the image and its variabels
 	virtual void parseXml(QDomNode& dataNode);///< Use a XML node to load data. \param dataNode A XML data representation of this object.
@@ -80,6 +87,8 @@ public:
 	void setIsWireframe(bool on);///< Set rep to wireframe, false means surface
 	bool getIsWireframe() const;///< true=wireframe, false=surface
 	vtkPolyDataPtr getTransformedPolyDataCopy(Transform3D tranform);///< Create a new transformed polydata
+	vtkPolyDataPtr getTransformedPolyData(Transform3D transform);///< Transformed polydata sharing all but points and normals with this mesh, for read only use
+	qint64 getMemoryUsage() const;///< Bytes used by the polydata arrays and the picking hierarchy, shared arrays counted once
 	bool isFiberBundle() const;
 	bool showGlyph();
 	bool hasGlyph();
@@ -112,6 +121,8 @@ private:
 	vtkPolyDataPtr mVtkPolyData;
 	vtkPolyDataPtr mVtkPolyDataOriginal;
 	vtkTexturePtr mVtkTexture;
+	mutable MeshBVHPtr mBVH;
+	mutable vtkPolyData* mBVHSource;
 	bool createTextureMapper(vtkDataSetAlgorithmPtr &tMapper);
 	bool mHasGlyph;
 	bool mShowGlyph;
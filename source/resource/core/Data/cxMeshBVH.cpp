@@ -0,0 +1,330 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMeshBVH.h"
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <QtGlobal>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkIdList.h>
+
+namespace cx
+{
+
+MeshBVH::Hit::Hit() :
+	valid(false),
+	t(std::numeric_limits<double>::max()),
+	cellId(-1),
+	position(0,0,0)
+{
+}
+
+MeshBVH::MeshBVH(vtkPolyDataPtr polyData) :
+	mSourceMTime(0),
+	mDepth(0)
+{
+	if (!polyData || !polyData->GetPoints())
+		return;
+	mSourceMTime = polyData->GetMTime();
+
+	vtkPoints* points = polyData->GetPoints();
+	double a[3], b[3], c[3];
+	vtkIdListPtr ids = vtkIdListPtr::New();
+
+	// cell ids in vtkPolyData count verts, lines, polys, strips in that order
+	vtkIdType cellId = polyData->GetNumberOfVerts() + polyData->GetNumberOfLines();
+
+	vtkCellArray* polys = polyData->GetPolys();
+	for (polys->InitTraversal(); polys->GetNextCell(ids); ++cellId)
+	{
+		vtkIdType npts = ids->GetNumberOfIds();
+		if (npts<3)
+			continue;
+		points->GetPoint(ids->GetId(0), a);
+		for (vtkIdType i=1; i+1<npts; ++i)
+		{
+			points->GetPoint(ids->GetId(i), b);
+			points->GetPoint(ids->GetId(i+1), c);
+			this->addTriangle(cellId, a, b, c);
+		}
+	}
+
+	vtkCellArray* strips = polyData->GetStrips();
+	for (strips->InitTraversal(); strips->GetNextCell(ids); ++cellId)
+	{
+		vtkIdType npts = ids->GetNumberOfIds();
+		for (vtkIdType i=0; i+2<npts; ++i)
+		{
+			points->GetPoint(ids->GetId(i), a);
+			points->GetPoint(ids->GetId(i+1), b);
+			points->GetPoint(ids->GetId(i+2), c);
+			this->addTriangle(cellId, a, b, c);
+		}
+	}
+
+	int n = this->getNumberOfTriangles();
+	if (!n)
+		return;
+
+	std::vector<int> order(n);
+	for (int i=0; i<n; ++i)
+		order[i] = i;
+	mNodes.reserve(2*(n/leafSize+1));
+	this->build(order, 0, n, 1);
+
+	// store the triangles in leaf order
+	for (int k=0; k<3; ++k)
+	{
+		std::vector<double> v0(n), e1(n), e2(n);
+		for (int i=0; i<n; ++i)
+		{
+			v0[i] = mV0[k][order[i]];
+			e1[i] = mE1[k][order[i]];
+			e2[i] = mE2[k][order[i]];
+		}
+		mV0[k].swap(v0);
+		mE1[k].swap(e1);
+		mE2[k].swap(e2);
+	}
+	std::vector<vtkIdType> cellIds(n);
+	for (int i=0; i<n; ++i)
+		cellIds[i] = mCellIds[order[i]];
+	mCellIds.swap(cellIds);
+}
+
+void MeshBVH::addTriangle(vtkIdType cellId, const double* a, const double* b, const double* c)
+{
+	for (int k=0; k<3; ++k)
+	{
+		mV0[k].push_back(a[k]);
+		mE1[k].push_back(b[k]-a[k]);
+		mE2[k].push_back(c[k]-a[k]);
+	}
+	mCellIds.push_back(cellId);
+}
+
+int MeshBVH::getNumberOfTriangles() const
+{
+	return int(mCellIds.size());
+}
+
+qint64 MeshBVH::getSizeInBytes() const
+{
+	qint64 retval = mNodes.capacity()*sizeof(Node) + mCellIds.capacity()*sizeof(vtkIdType);
+	for (int i=0; i<3; ++i)
+		retval += (mV0[i].capacity() + mE1[i].capacity() + mE2[i].capacity())*sizeof(double);
+	return retval;
+}
+
+vtkMTimeType MeshBVH::getSourceMTime() const
+{
+	return mSourceMTime;
+}
+
+DoubleBoundingBox3D MeshBVH::getBounds() const
+{
+	if (mNodes.empty())
+		return DoubleBoundingBox3D::zero();
+	const Node& root = mNodes[0];
+	return DoubleBoundingBox3D(Vector3D(root.bbMin), Vector3D(root.bbMax));
+}
+
+/** Build the subtree for the triangles order[begin..end), return its node index.
+ *  Called before the triangles are reordered, i.e. order indexes the input.
+ */
+int MeshBVH::build(std::vector<int>& order, int begin, int end, int depth)
+{
+	mDepth = std::max(mDepth, depth);
+	int index = int(mNodes.size());
+	mNodes.push_back(Node());
+
+	double bbMin[3], bbMax[3], cMin[3], cMax[3];
+	for (int k=0; k<3; ++k)
+	{
+		bbMin[k] = cMin[k] = std::numeric_limits<double>::max();
+		bbMax[k] = cMax[k] = std::numeric_limits<double>::lowest();
+	}
+	for (int i=begin; i<end; ++i)
+	{
+		int tri = order[i];
+		for (int k=0; k<3; ++k)
+		{
+			double v0 = mV0[k][tri];
+			double v1 = v0 + mE1[k][tri];
+			double v2 = v0 + mE2[k][tri];
+			bbMin[k] = std::min(bbMin[k], std::min(v0, std::min(v1, v2)));
+			bbMax[k] = std::max(bbMax[k], std::max(v0, std::max(v1, v2)));
+			double centroid = (v0+v1+v2)/3;
+			cMin[k] = std::min(cMin[k], centroid);
+			cMax[k] = std::max(cMax[k], centroid);
+		}
+	}
+	std::copy(bbMin, bbMin+3, mNodes[index].bbMin);
+	std::copy(bbMax, bbMax+3, mNodes[index].bbMax);
+
+	int axis = 0;
+	for (int k=1; k<3; ++k)
+		if (cMax[k]-cMin[k] > cMax[axis]-cMin[axis])
+			axis = k;
+
+	if (end-begin <= leafSize)
+	{
+		mNodes[index].first = begin;
+		mNodes[index].count = end-begin;
+		mNodes[index].axis = 0;
+		return index;
+	}
+
+	// Always split at the median index: leaves never exceed leafSize and the
+	// tree stays balanced. Coinciding centroids (duplicate or degenerate
+	// triangles, common in marching cubes output) are split in any order.
+	int mid = (begin+end)/2;
+	if (cMax[axis] > cMin[axis])
+	{
+		const std::vector<double>& v0 = mV0[axis];
+		const std::vector<double>& e1 = mE1[axis];
+		const std::vector<double>& e2 = mE2[axis];
+		// compare 3*centroid
+		std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end, [&](int lhs, int rhs)
+		{
+			return 3*v0[lhs]+e1[lhs]+e2[lhs] < 3*v0[rhs]+e1[rhs]+e2[rhs];
+		});
+	}
+
+	this->build(order, begin, mid, depth+1);
+	int right = this->build(order, mid, end, depth+1);
+	mNodes[index].first = right;
+	mNodes[index].count = 0;
+	mNodes[index].axis = axis;
+	return index;
+}
+
+/** Moller-Trumbore for all triangles in the leaf. The loop
+ *  has no early exits so that it can be vectorized.
+ */
+void MeshBVH::intersectLeaf(const Node& node, const double* o, const double* d, double tMin, Hit* hit) const
+{
+	double tValues[leafSize];
+	const int first = node.first;
+	const int count = node.count;
+	Q_ASSERT(count <= leafSize);
+	const double inf = std::numeric_limits<double>::max();
+
+	for (int j=0; j<count; ++j)
+	{
+		int i = first+j;
+		double e1[3] = { mE1[0][i], mE1[1][i], mE1[2][i] };
+		double e2[3] = { mE2[0][i], mE2[1][i], mE2[2][i] };
+		double s[3] = { o[0]-mV0[0][i], o[1]-mV0[1][i], o[2]-mV0[2][i] };
+
+		double p[3] = { d[1]*e2[2]-d[2]*e2[1], d[2]*e2[0]-d[0]*e2[2], d[0]*e2[1]-d[1]*e2[0] };
+		double det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+		double inv = (det!=0) ? 1.0/det : 0;
+		double u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2]) * inv;
+
+		double q[3] = { s[1]*e1[2]-s[2]*e1[1], s[2]*e1[0]-s[0]*e1[2], s[0]*e1[1]-s[1]*e1[0] };
+		double v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]) * inv;
+		double t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv;
+
+		bool ok = (det!=0) && (u>=0) && (v>=0) && (u+v<=1) && (t>=tMin);
+		tValues[j] = ok ? t : inf;
+	}
+
+	for (int j=0; j<count; ++j)
+	{
+		if (tValues[j] < hit->t)
+		{
+			hit->t = tValues[j];
+			hit->cellId = mCellIds[first+j];
+			hit->valid = true;
+		}
+	}
+}
+
+MeshBVH::Hit MeshBVH::intersect(const Vector3D& origin, const Vector3D& direction, double tMin, double tMax) const
+{
+	Hit retval;
+	if (mNodes.empty())
+		return retval;
+
+	const double* o = origin.data();
+	const double* d = direction.data();
+	double invDir[3];
+	for (int k=0; k<3; ++k)
+		invDir[k] = (d[k]!=0) ? 1.0/d[k] : std::numeric_limits<double>::max();
+
+	// retval.t is the current far limit
+	retval.t = tMax;
+
+	// Depth-first traversal holds at most one pending sibling per level.
+	// The tree is balanced, so the fixed buffer nearly always suffices.
+	const int fixedStackSize = 64;
+	int fixedStack[fixedStackSize];
+	std::vector<int> largeStack;
+	int* stack = fixedStack;
+	if (mDepth+1 > fixedStackSize)
+	{
+		largeStack.resize(mDepth+1);
+		stack = &largeStack[0];
+	}
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		const Node& node = mNodes[stack[--top]];
+
+		double t0 = tMin;
+		double t1 = retval.t;
+		for (int k=0; k<3; ++k)
+		{
+			double ta = (node.bbMin[k]-o[k])*invDir[k];
+			double tb = (node.bbMax[k]-o[k])*invDir[k];
+			if (ta>tb)
+				std::swap(ta, tb);
+			t0 = std::max(t0, ta);
+			t1 = std::min(t1, tb);
+		}
+		if (t0>t1)
+			continue;
+
+		if (node.count)
+		{
+			this->intersectLeaf(node, o, d, tMin, &retval);
+			continue;
+		}
+
+		// visit the near child first: push it last
+		int left = int(&node - &mNodes[0]) + 1;
+		int right = node.first;
+		Q_ASSERT(top+2 <= std::max(mDepth+1, fixedStackSize));
+		if (d[node.axis] >= 0)
+		{
+			stack[top++] = right;
+			stack[top++] = left;
+		}
+		else
+		{
+			stack[top++] = left;
+			stack[top++] = right;
+		}
+	}
+
+	if (!retval.valid)
+		return Hit();
+	retval.position = origin + retval.t*direction;
+	return retval;
+}
+
+} // namespace cx
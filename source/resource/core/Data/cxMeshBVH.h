@@ -0,0 +1,94 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMESHBVH_H
+#define CXMESHBVH_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <vector>
+#include "vtkForwardDeclarations.h"
+#include "cxVector3D.h"
+#include "cxBoundingBox3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class MeshBVH> MeshBVHPtr;
+
+/** \brief Bounding volume hierarchy over the triangles of a vtkPolyData.
+ *
+ * Used for fast ray picking on large surfaces. Polygons and triangle
+ * strips are split into triangles, vertices and lines are ignored.
+ *
+ * The tree is built once, splitting at the median centroid along the
+ * longest axis. Each leaf holds at most leafSize triangles, stored
+ * as structure of arrays so that the ray/triangle test of a leaf
+ * is one vectorizable loop.
+ *
+ * The hierarchy is a snapshot: rebuild it if the polydata changes.
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT MeshBVH
+{
+public:
+	static const int leafSize = 4;
+
+	struct cxResource_EXPORT Hit
+	{
+		Hit();
+		bool valid;
+		double t; ///< ray parameter of the hit
+		vtkIdType cellId; ///< cell in the input polydata
+		Vector3D position;
+	};
+
+	explicit MeshBVH(vtkPolyDataPtr polyData);
+
+	/** Find the closest intersection along origin + t*direction,
+	 *  with t in [tMin, tMax].
+	 */
+	Hit intersect(const Vector3D& origin, const Vector3D& direction, double tMin, double tMax) const;
+
+	int getNumberOfTriangles() const;
+	DoubleBoundingBox3D getBounds() const;
+	vtkMTimeType getSourceMTime() const; ///< modification time of the input when built
+	qint64 getSizeInBytes() const;
+
+private:
+	struct Node
+	{
+		double bbMin[3];
+		double bbMax[3];
+		int first; ///< leaf: first triangle. inner: right child, the left child is the next node.
+		int count; ///< number of triangles, zero for inner nodes
+		int axis; ///< split axis of inner nodes, the left child has the lower centroids
+	};
+
+	void addTriangle(vtkIdType cellId, const double* a, const double* b, const double* c);
+	int build(std::vector<int>& order, int begin, int end, int depth);
+	void intersectLeaf(const Node& node, const double* o, const double* d, double tMin, Hit* hit) const;
+
+	std::vector<Node> mNodes;
+	// triangles as v0 and the edges e1=v1-v0, e2=v2-v0, one array per coordinate
+	std::vector<double> mV0[3];
+	std::vector<double> mE1[3];
+	std::vector<double> mE2[3];
+	std::vector<vtkIdType> mCellIds;
+	vtkMTimeType mSourceMTime;
+	int mDepth; ///< levels in the tree, bounds the traversal stack
+};
+
+} // namespace cx
+
+#endif // CXMESHBVH_H
@@ -0,0 +1,249 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMetricEvaluator.h"
+
+#include "cxMetricReferenceArgumentList.h"
+
+namespace cx
+{
+
+MetricEvaluator::MetricEvaluator() :
+	mUseVisible(false),
+	mChangeEmitted(false),
+	mTotalEvaluations(0),
+	mEvaluationsInWindow(0),
+	mMetricsPerSecond(0),
+	mDependencyRebuilds(0)
+{
+	mRateTimer.start();
+}
+
+MetricEvaluator::~MetricEvaluator()
+{
+	this->disconnectMetrics();
+}
+
+void MetricEvaluator::disconnectMetrics()
+{
+	for (std::map<QObject*, QString>::iterator iter=mSenders.begin(); iter!=mSenders.end(); ++iter)
+		disconnect(iter->first, 0, this, 0);
+	mSenders.clear();
+}
+
+void MetricEvaluator::setMetrics(std::vector<DataMetricPtr> metrics)
+{
+	this->disconnectMetrics();
+	mNodes.clear();
+
+	for (unsigned i=0; i<metrics.size(); ++i)
+	{
+		DataMetricPtr metric = metrics[i];
+		if (!metric)
+			continue;
+		mNodes[metric->getUid()].metric = metric;
+
+		mSenders[metric.get()] = metric->getUid();
+		connect(metric.get(), SIGNAL(transformChanged()), this, SLOT(metricChangedSlot()));
+		connect(metric.get(), SIGNAL(propertiesChanged()), this, SLOT(metricChangedSlot()));
+
+		MetricReferenceArgumentListPtr arguments = metric->getArguments();
+		if (arguments)
+		{
+			mSenders[arguments.get()] = metric->getUid();
+			connect(arguments.get(), SIGNAL(argumentsChanged()), this, SLOT(argumentsChangedSlot()));
+		}
+	}
+
+	this->rebuildDependencies();
+	mChangeEmitted = false;
+}
+
+std::vector<QString> MetricEvaluator::getArgumentUids(DataMetricPtr metric) const
+{
+	std::vector<QString> retval;
+	MetricReferenceArgumentListPtr arguments = metric->getArguments();
+	if (!arguments)
+		return retval;
+	for (unsigned i=0; i<arguments->getCount(); ++i)
+	{
+		DataPtr argument = arguments->get(i);
+		if (argument)
+			retval.push_back(argument->getUid());
+	}
+	return retval;
+}
+
+/** Invert the argument lists into lists of dependents,
+ *  i.e. edges point from an argument to the metrics using it.
+ */
+void MetricEvaluator::rebuildDependencies()
+{
+	for (NodeMap::iterator iter=mNodes.begin(); iter!=mNodes.end(); ++iter)
+		iter->second.dependents.clear();
+
+	for (NodeMap::iterator iter=mNodes.begin(); iter!=mNodes.end(); ++iter)
+	{
+		iter->second.arguments = this->getArgumentUids(iter->second.metric);
+		for (unsigned i=0; i<iter->second.arguments.size(); ++i)
+		{
+			NodeMap::iterator node = mNodes.find(iter->second.arguments[i]);
+			if (node!=mNodes.end())
+				node->second.dependents.push_back(iter->first);
+		}
+	}
+}
+
+void MetricEvaluator::setVisibleMetrics(std::set<QString> uids)
+{
+	mVisible = uids;
+	mUseVisible = true;
+}
+
+void MetricEvaluator::clearVisibleMetrics()
+{
+	mVisible.clear();
+	mUseVisible = false;
+}
+
+bool MetricEvaluator::isVisible(QString uid) const
+{
+	return !mUseVisible || mVisible.count(uid);
+}
+
+void MetricEvaluator::metricChangedSlot()
+{
+	std::map<QObject*, QString>::iterator iter = mSenders.find(this->sender());
+	if (iter==mSenders.end())
+		return;
+	this->markDirty(iter->second);
+}
+
+/** argumentsChanged() is also emitted when an argument moves, i.e. at
+ *  tracking rate. Rebuild the graph only if the set of arguments differs.
+ */
+void MetricEvaluator::argumentsChangedSlot()
+{
+	std::map<QObject*, QString>::iterator iter = mSenders.find(this->sender());
+	if (iter==mSenders.end())
+		return;
+	NodeMap::iterator node = mNodes.find(iter->second);
+	if ((node!=mNodes.end()) && (this->getArgumentUids(node->second.metric)!=node->second.arguments))
+	{
+		this->rebuildDependencies();
+		++mDependencyRebuilds;
+	}
+	this->markDirty(iter->second);
+}
+
+/** Mark uid and everything depending on it dirty.
+ *  Dependents are always traversed, even if uid already is dirty:
+ *  a dependent might have been evaluated while uid was hidden.
+ */
+void MetricEvaluator::markDirty(QString uid)
+{
+	std::set<QString> visited;
+	std::vector<QString> stack(1, uid);
+	while (!stack.empty())
+	{
+		QString current = stack.back();
+		stack.pop_back();
+		if (!visited.insert(current).second)
+			continue;
+		NodeMap::iterator node = mNodes.find(current);
+		if (node==mNodes.end())
+			continue;
+		node->second.dirty = true;
+		stack.insert(stack.end(), node->second.dependents.begin(), node->second.dependents.end());
+	}
+
+	if (!mChangeEmitted)
+	{
+		mChangeEmitted = true;
+		emit changed();
+	}
+}
+
+int MetricEvaluator::evaluate()
+{
+	int evaluations = 0;
+	for (NodeMap::iterator iter=mNodes.begin(); iter!=mNodes.end(); ++iter)
+	{
+		Node& node = iter->second;
+		if (!node.dirty || !this->isVisible(iter->first))
+			continue;
+
+		node.result.valid = node.metric->isValid();
+		node.result.value = node.metric->getValueAsString();
+		node.result.refCoord = node.result.valid ? node.metric->getRefCoord() : Vector3D(0,0,0);
+		node.dirty = false;
+		++evaluations;
+	}
+
+	mChangeEmitted = false;
+	this->updateRate(evaluations);
+	return evaluations;
+}
+
+void MetricEvaluator::updateRate(int evaluations)
+{
+	mTotalEvaluations += evaluations;
+	mEvaluationsInWindow += evaluations;
+
+	qint64 elapsed = mRateTimer.elapsed();
+	if (elapsed >= 1000)
+	{
+		mMetricsPerSecond = 1000.0 * mEvaluationsInWindow / elapsed;
+		mEvaluationsInWindow = 0;
+		mRateTimer.restart();
+	}
+}
+
+double MetricEvaluator::getMetricsPerSecond() const
+{
+	return mMetricsPerSecond;
+}
+
+MetricEvaluator::Result MetricEvaluator::getResult(QString uid) const
+{
+	NodeMap::const_iterator node = mNodes.find(uid);
+	if (node==mNodes.end())
+		return Result();
+	return node->second.result;
+}
+
+bool MetricEvaluator::isDirty(QString uid) const
+{
+	NodeMap::const_iterator node = mNodes.find(uid);
+	if (node==mNodes.end())
+		return false;
+	return node->second.dirty;
+}
+
+std::set<QString> MetricEvaluator::getDependents(QString uid) const
+{
+	std::set<QString> retval;
+	std::vector<QString> stack(1, uid);
+	while (!stack.empty())
+	{
+		QString current = stack.back();
+		stack.pop_back();
+		NodeMap::const_iterator node = mNodes.find(current);
+		if (node==mNodes.end())
+			continue;
+		for (unsigned i=0; i<node->second.dependents.size(); ++i)
+			if (retval.insert(node->second.dependents[i]).second)
+				stack.push_back(node->second.dependents[i]);
+	}
+	return retval;
+}
+
+} // namespace cx
@@ -0,0 +1,117 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMETRICEVALUATOR_H
+#define CXMETRICEVALUATOR_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <QObject>
+#include <QElapsedTimer>
+#include "cxDataMetric.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class MetricEvaluator> MetricEvaluatorPtr;
+
+/** \brief Cached evaluation of a set of metrics.
+ *
+ * Keeps a dependency graph of the metrics, built from
+ * DataMetric::getArguments(). A transform or property change
+ * in one metric marks it and all metrics depending on it
+ * dirty, everything else keeps its cached value.
+ *
+ * Nothing is computed when metrics change. Call evaluate()
+ * once per frame, typically before painting: only dirty
+ * metrics are recomputed, and if a visible set is given,
+ * only those. Hidden dirty metrics are recomputed when
+ * they become visible.
+ *
+ * changed() is emitted once per batch, i.e. on the first
+ * change after an evaluate().
+ *
+ * \ingroup cx_resource_core_data
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT MetricEvaluator : public QObject
+{
+	Q_OBJECT
+public:
+	struct Result
+	{
+		Result() : valid(false), refCoord(0,0,0) {}
+		bool valid;
+		QString value; ///< DataMetric::getValueAsString()
+		Vector3D refCoord;
+	};
+
+	MetricEvaluator();
+	virtual ~MetricEvaluator();
+
+	void setMetrics(std::vector<DataMetricPtr> metrics); ///< rebuild the graph, all metrics become dirty
+	void setVisibleMetrics(std::set<QString> uids); ///< limit evaluation to these metrics
+	void clearVisibleMetrics(); ///< evaluate all dirty metrics
+
+	int evaluate(); ///< recompute dirty and visible metrics, return number of evaluated metrics
+	Result getResult(QString uid) const; ///< cached result from the last evaluate()
+	bool isDirty(QString uid) const;
+	std::set<QString> getDependents(QString uid) const; ///< all metrics depending directly or indirectly on uid
+
+	double getMetricsPerSecond() const; ///< evaluation rate over the last completed second
+	int getTotalEvaluations() const { return mTotalEvaluations; }
+	int getDependencyRebuilds() const { return mDependencyRebuilds; } ///< graph rebuilds caused by changed arguments
+
+signals:
+	void changed(); ///< one or more metrics became dirty since last evaluate()
+
+private slots:
+	void metricChangedSlot();
+	void argumentsChangedSlot();
+private:
+	struct Node
+	{
+		Node() : dirty(true) {}
+		DataMetricPtr metric;
+		std::vector<QString> arguments; ///< uids of the arguments when the graph was built
+		std::vector<QString> dependents;
+		bool dirty;
+		Result result;
+	};
+	typedef std::map<QString, Node> NodeMap;
+
+	void disconnectMetrics();
+	void rebuildDependencies();
+	std::vector<QString> getArgumentUids(DataMetricPtr metric) const;
+	void markDirty(QString uid);
+	bool isVisible(QString uid) const;
+	void updateRate(int evaluations);
+
+	NodeMap mNodes;
+	std::map<QObject*, QString> mSenders;
+	std::set<QString> mVisible;
+	bool mUseVisible;
+	bool mChangeEmitted;
+
+	int mTotalEvaluations;
+	int mEvaluationsInWindow;
+	double mMetricsPerSecond;
+	QElapsedTimer mRateTimer;
+	int mDependencyRebuilds;
+};
+
+} // namespace cx
+
+#endif // CXMETRICEVALUATOR_H
@@ -41,6 +41,7 @@ void ActiveToolProxy::activeToolChangedSlot(const QString& uid)
 	{
 		disconnect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this,
 						SIGNAL(toolTransformAndTimestamp(Transform3D, double)));
+		disconnect(mTool.get(), &Tool::toolTransformCoalesced, this, &ActiveToolProxy::toolTransformCoalesced);
 		disconnect(mTool.get(), &Tool::toolVisible, this, &ActiveToolProxy::toolVisible);
 		disconnect(mTool.get(), &Tool::tooltipOffset, this, &ActiveToolProxy::tooltipOffset);
 		disconnect(mTool.get(), &Tool::toolProbeSector, this, &ActiveToolProxy::toolProbeSector);
@@ -55,6 +56,7 @@ void ActiveToolProxy::activeToolChangedSlot(const QString& uid)
 	{
 		connect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this,
 						SIGNAL(toolTransformAndTimestamp(Transform3D, double)));
+		connect(mTool.get(), &Tool::toolTransformCoalesced, this, &ActiveToolProxy::toolTransformCoalesced);
 		connect(mTool.get(), &Tool::toolVisible, this, &ActiveToolProxy::toolVisible);
 		connect(mTool.get(), &Tool::tooltipOffset, this, &ActiveToolProxy::tooltipOffset);
 		connect(mTool.get(), &Tool::toolProbeSector, this, &ActiveToolProxy::toolProbeSector);
@@ -63,6 +65,7 @@ void ActiveToolProxy::activeToolChangedSlot(const QString& uid)
 		emit activeToolChanged(mTool->getUid());
 		emit toolVisible(mTool->getVisible());
 		emit toolTransformAndTimestamp(mTool->get_prMt(), mTool->getTimestamp());
+		emit toolTransformCoalesced(mTool->get_prMt(), mTool->getTimestamp());
 		emit tooltipOffset(mTool->getTooltipOffset());
 	}
 }
@@ -55,6 +55,7 @@ signals:
 
 	// forwarding of active tool signals
 	void toolTransformAndTimestamp(Transform3D matrix, double timestamp);
+	void toolTransformCoalesced(Transform3D matrix, double timestamp);
 	void toolVisible(bool visible);
 	void tooltipOffset(double offset);
 	void toolProbeSector();
@@ -0,0 +1,267 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxProbeMask.h"
+
+#include <map>
+#include <deque>
+#include <cmath>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include "cxProbeSector.h"
+#include "cxVolumeHelpers.h"
+
+namespace cx
+{
+
+namespace
+{
+/**Function object for evaluating whether a pixel is inside the
+ * us mask.
+ */
+class InsideMaskFunctor
+{
+public:
+	InsideMaskFunctor(ProbeDefinition data, Transform3D uMv) :
+		mData(data), m_vMu(uMv.inv())
+	{
+		mCachedCenter_v = m_vMu.coord(mData.getOrigin_u());
+		mClipRect_v = transform(m_vMu, mData.getClipRect_u());
+		mClipRect_v[4] = -1;
+		mClipRect_v[5] = 1;
+	}
+	bool operator ()(int x, int y) const
+	{
+		Vector3D p_v = multiply_elems(Vector3D(x, y, 0), mData.getSpacing());
+
+		return this->insideClipRect(p_v) && this->insideSector(p_v);
+	}
+
+private:
+	/**return true if p_v, given in the upper-left space v,
+	 * is inside the us beam sector
+	 *
+	 * Prerequisite: mCachedCenter_v is updated!
+	 */
+	bool insideClipRect(const Vector3D& p_v) const
+	{
+		return mClipRect_v.contains(p_v);
+	}
+
+	/**return true if p_v, given in the upper-left space v,
+	 * is inside the us beam sector
+	 *
+	 * Prerequisite: mCachedCenter_v is updated!
+	 */
+	bool insideSector(const Vector3D& p_v) const
+	{
+		Vector3D d = p_v - mCachedCenter_v;
+
+		if (mData.getType() == ProbeDefinition::tSECTOR)
+		{
+			double angle = atan2(d[1], d[0]);
+			angle -= M_PI_2; // center angle on us probe axis at 90*.
+			if (angle < -M_PI)
+				angle += 2.0 * M_PI;
+
+			if (fabs(angle) > mData.getWidth() / 2.0)
+				return false;
+			if (d.length() < mData.getDepthStart())
+				return false;
+			if (d.length() > mData.getDepthEnd())
+				return false;
+			return true;
+		}
+		else // tLINEAR
+		{
+			if (fabs(d[0]) > mData.getWidth() / 2.0)
+				return false;
+			if (d[1] < mData.getDepthStart())
+				return false;
+			if (d[1] > mData.getDepthEnd())
+				return false;
+			return true;
+		}
+	}
+
+	ProbeDefinition mData;
+	Transform3D m_vMu;
+	Vector3D mCachedCenter_v; ///< center of beam sector for sector probes.
+	DoubleBoundingBox3D mClipRect_v;
+};
+
+typedef std::vector<double> MaskKey;
+
+/** The parameters used by InsideMaskFunctor.
+ */
+MaskKey createKey(const ProbeDefinition& probe)
+{
+	MaskKey key;
+	key.push_back(probe.getType());
+	key.push_back(probe.getDepthStart());
+	key.push_back(probe.getDepthEnd());
+	key.push_back(probe.getWidth());
+	key.push_back(probe.getSize().width());
+	key.push_back(probe.getSize().height());
+	Vector3D spacing = probe.getSpacing();
+	Vector3D origin_u = probe.getOrigin_u();
+	DoubleBoundingBox3D clipRect_u = probe.getClipRect_u();
+	key.insert(key.end(), spacing.data(), spacing.data()+3);
+	key.insert(key.end(), origin_u.data(), origin_u.data()+3);
+	key.insert(key.end(), clipRect_u.begin(), clipRect_u.end());
+	return key;
+}
+
+/** Process wide cache of the most recently created masks.
+ */
+class ProbeMaskCache
+{
+public:
+	static ProbeMaskCache& getInstance()
+	{
+		static ProbeMaskCache instance;
+		return instance;
+	}
+
+	ProbeMaskPtr get(const ProbeDefinition& probe)
+	{
+		MaskKey key = createKey(probe);
+		QMutexLocker locker(&mMutex);
+		std::map<MaskKey, ProbeMaskPtr>::iterator iter = mMasks.find(key);
+		if (iter != mMasks.end())
+			return iter->second;
+
+		// rasterizing holds the lock: concurrent requests usually want the same mask
+		ProbeMaskPtr mask(new ProbeMask(probe));
+		mMasks[key] = mask;
+		mOrder.push_back(key);
+		if (mOrder.size() > maxSize)
+		{
+			mMasks.erase(mOrder.front());
+			mOrder.pop_front();
+		}
+		return mask;
+	}
+
+	void clear()
+	{
+		QMutexLocker locker(&mMutex);
+		mMasks.clear();
+		mOrder.clear();
+	}
+
+private:
+	static const unsigned maxSize = 16;
+	QMutex mMutex;
+	std::map<MaskKey, ProbeMaskPtr> mMasks;
+	std::deque<MaskKey> mOrder; ///< insertion order, oldest first
+};
+} // namespace
+
+ProbeMaskPtr ProbeMask::get(const ProbeDefinition& probe)
+{
+	if (probe.getType()==ProbeDefinition::tNONE)
+		return ProbeMaskPtr();
+	return ProbeMaskCache::getInstance().get(probe);
+}
+
+void ProbeMask::clearCache()
+{
+	ProbeMaskCache::getInstance().clear();
+}
+
+ProbeMask::ProbeMask(const ProbeDefinition& probe) :
+	mInside(0)
+{
+	ProbeSector sector;
+	sector.setData(probe);
+	InsideMaskFunctor checkInside(probe, sector.get_uMv());
+
+	mImage = generateVtkImageData(Eigen::Array3i(probe.getSize().width(), probe.getSize().height(), 1),
+								  probe.getSpacing(), 0);
+	int* dim(mImage->GetDimensions());
+	unsigned char* dataPtr = static_cast<unsigned char*> (mImage->GetScalarPointer());
+
+	// rasterize rows in parallel, each row into its own runs
+	std::vector<std::vector<Span> > rows(dim[1]);
+	std::vector<int> indices(dim[1]);
+	for (int y = 0; y < dim[1]; ++y)
+		indices[y] = y;
+	QtConcurrent::blockingMap(indices, [&](int y)
+	{
+		unsigned char* row = dataPtr + y * dim[0];
+		for (int x = 0; x < dim[0]; x++)
+		{
+			bool inside = checkInside(x, y);
+			row[x] = inside ? 1 : 0;
+			if (!inside)
+				continue;
+			if (rows[y].empty() || rows[y].back().end != x)
+			{
+				Span span = { x, x };
+				rows[y].push_back(span);
+			}
+			rows[y].back().end = x+1;
+		}
+	});
+
+	mBoundingBox = IntBoundingBox3D(dim[0], 0, dim[1], 0, 0, 0);
+	mRowStart.resize(dim[1]+1);
+	for (int y = 0; y < dim[1]; ++y)
+	{
+		mRowStart[y] = int(mSpans.size());
+		for (unsigned i=0; i<rows[y].size(); ++i)
+		{
+			const Span& span = rows[y][i];
+			mSpans.push_back(span);
+			mInside += span.end - span.begin;
+			mBoundingBox[0] = std::min(mBoundingBox[0], span.begin);
+			mBoundingBox[1] = std::max(mBoundingBox[1], span.end-1);
+			mBoundingBox[2] = std::min(mBoundingBox[2], y);
+			mBoundingBox[3] = std::max(mBoundingBox[3], y);
+		}
+	}
+	mRowStart[dim[1]] = int(mSpans.size());
+}
+
+vtkImageDataPtr ProbeMask::getImage() const
+{
+	return mImage;
+}
+
+Eigen::Array3i ProbeMask::getDimensions() const
+{
+	return Eigen::Array3i(mImage->GetDimensions());
+}
+
+const ProbeMask::Span* ProbeMask::beginRow(int y) const
+{
+	return mSpans.data() + mRowStart[y];
+}
+
+const ProbeMask::Span* ProbeMask::endRow(int y) const
+{
+	return mSpans.data() + mRowStart[y+1];
+}
+
+int ProbeMask::getNumberOfInsidePixels() const
+{
+	return mInside;
+}
+
+IntBoundingBox3D ProbeMask::getBoundingBox() const
+{
+	return mBoundingBox;
+}
+
+} // namespace cx
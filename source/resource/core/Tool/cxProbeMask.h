@@ -0,0 +1,73 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXPROBEMASK_H_
+#define CXPROBEMASK_H_
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "vtkForwardDeclarations.h"
+#include "cxProbeDefinition.h"
+#include "cxBoundingBox3D.h"
+
+namespace cx
+{
+
+typedef boost::shared_ptr<const class ProbeMask> ProbeMaskPtr;
+
+/** \brief The US beam of a probe as a 2D mask, shared and immutable.
+ *
+ * The mask is stored both as an unsigned char 0/1 image with the size
+ * and spacing of the probe image, and as runs of inside pixels per
+ * row. Apply the mask using the runs: the inner loops are then
+ * contiguous and free of per-pixel tests.
+ *
+ * Masks are memoised: get() returns the same instance for probe
+ * definitions with equal sector geometry, independent of e.g. uid
+ * or temporal calibration. Never modify the image.
+ *
+ * \ingroup cx_resource_core_tool
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ProbeMask
+{
+public:
+	struct Span ///< inside pixels [begin, end) of a row
+	{
+		int begin;
+		int end;
+	};
+
+	static ProbeMaskPtr get(const ProbeDefinition& probe); ///< zero if the probe type is tNONE
+	static void clearCache();
+
+	vtkImageDataPtr getImage() const; ///< unsigned char, 1 inside. Shared, do not modify.
+	Eigen::Array3i getDimensions() const;
+	const Span* beginRow(int y) const;
+	const Span* endRow(int y) const;
+	int getNumberOfInsidePixels() const;
+	IntBoundingBox3D getBoundingBox() const; ///< pixel range of the inside pixels, xmin=dimX, xmax=0 if empty.
+
+	explicit ProbeMask(const ProbeDefinition& probe); ///< rasterize the probe sector. Use get() instead.
+
+private:
+	vtkImageDataPtr mImage;
+	std::vector<Span> mSpans;
+	std::vector<int> mRowStart; ///< spans of row y are mSpans[mRowStart[y]..mRowStart[y+1])
+	int mInside;
+	IntBoundingBox3D mBoundingBox;
+};
+
+} // namespace cx
+
+#endif // CXPROBEMASK_H_
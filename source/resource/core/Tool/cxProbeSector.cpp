@@ -11,6 +11,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 
 #include "cxProbeSector.h"
+#include "cxProbeMask.h"
 
 #include "vtkImageData.h"
 #include <vtkPointData.h>
@@ -51,101 +52,15 @@ void ProbeSector::setData(ProbeDefinition data)
 	//  this->test();
 }
 
-/**Function object for evaluating whether a pixel is inside the
- * us mask.
- */
-class InsideMaskFunctor
-{
-public:
-	InsideMaskFunctor(ProbeDefinition data, Transform3D uMv) :
-		mData(data), m_vMu(uMv.inv())
-	{
-		mCachedCenter_v = m_vMu.coord(mData.getOrigin_u());
-		mClipRect_v = transform(m_vMu, mData.getClipRect_u());
-		mClipRect_v[4] = -1;
-		mClipRect_v[5] = 1;
-	}
-	bool operator ()(int x, int y) const
-	{
-		Vector3D p_v = multiply_elems(Vector3D(x, y, 0), mData.getSpacing());
-
-		return this->insideClipRect(p_v) && this->insideSector(p_v);
-	}
-
-private:
-	/**return true if p_v, given in the upper-left space v,
-	 * is inside the us beam sector
-	 *
-	 * Prerequisite: mCachedCenter_v is updated!
-	 */
-	bool insideClipRect(const Vector3D& p_v) const
-	{
-		return mClipRect_v.contains(p_v);
-	}
-
-	/**return true if p_v, given in the upper-left space v,
-	 * is inside the us beam sector
-	 *
-	 * Prerequisite: mCachedCenter_v is updated!
-	 */
-	bool insideSector(const Vector3D& p_v) const
-	{
-		Vector3D d = p_v - mCachedCenter_v;
-
-		if (mData.getType() == ProbeDefinition::tSECTOR)
-		{
-			double angle = atan2(d[1], d[0]);
-			angle -= M_PI_2; // center angle on us probe axis at 90*.
-			if (angle < -M_PI)
-				angle += 2.0 * M_PI;
-
-			if (fabs(angle) > mData.getWidth() / 2.0)
-				return false;
-			if (d.length() < mData.getDepthStart())
-				return false;
-			if (d.length() > mData.getDepthEnd())
-				return false;
-			return true;
-		}
-		else // tLINEAR
-		{
-			if (fabs(d[0]) > mData.getWidth() / 2.0)
-				return false;
-			if (d[1] < mData.getDepthStart())
-				return false;
-			if (d[1] > mData.getDepthEnd())
-				return false;
-			return true;
-		}
-	}
-
-	ProbeDefinition mData;
-	Transform3D m_vMu;
-	Vector3D mCachedCenter_v; ///< center of beam sector for sector probes.
-	DoubleBoundingBox3D mClipRect_v;
-};
-
 /** Return a 2D mask image identifying the US beam inside the image
- *  data stream.
+ *  data stream. The mask is shared, see ProbeMask.
  */
 vtkImageDataPtr ProbeSector::getMask()
 {
-	if (mData.getType()==ProbeDefinition::tNONE)
+	ProbeMaskPtr mask = ProbeMask::get(mData);
+	if (!mask)
 		return vtkImageDataPtr();
-	InsideMaskFunctor checkInside(mData, this->get_uMv());
-	vtkImageDataPtr retval;
-	retval = generateVtkImageData(Eigen::Array3i(mData.getSize().width(), mData.getSize().height(), 1),
-																mData.getSpacing(), 0);
-
-	int* dim(retval->GetDimensions());
-	unsigned char* dataPtr = static_cast<unsigned char*> (retval->GetScalarPointer());
-	for (int x = 0; x < dim[0]; x++)
-		for (int y = 0; y < dim[1]; y++)
-		{
-			dataPtr[x + y * dim[0]] = checkInside(x, y) ? 1 : 0;
-		}
-
-	return retval;
+	return mask->getImage();
 }
 
 void ProbeSector::test()
@@ -41,7 +41,7 @@ public:
 	ProbeSector();
 	void setData(ProbeDefinition data);
 
-	vtkImageDataPtr getMask();
+	vtkImageDataPtr getMask(); ///< shared mask image, do not modify. See ProbeMask.
 	vtkPolyDataPtr getSector(); ///< get a polydata representation of the us sector
 	vtkPolyDataPtr getSectorLinesOnly(); ///< get a polydata representation of the us sector
 	vtkPolyDataPtr getSectorSectorOnlyLinesOnly(); ///< get a polydata representation of the us sector
@@ -23,6 +23,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageAppendComponents.h>
 
 #include "cxImage.h"
+#include "cxObliqueSlicer.h"
 #include "cxSliceProxy.h"
 #include "cxImageLUT2D.h"
 #include "cxTypeConversions.h"
@@ -134,6 +135,7 @@ SlicedImageProxy::SlicedImageProxy()
 	mImageWithLUTProxy.reset(new ApplyLUTToImage2DProxy());
 
 	mRedirecter = vtkImageChangeInformationPtr::New();
+	mBrickedSlicer.reset(new ObliqueSlicer());
 }
 
 SlicedImageProxy::~SlicedImageProxy()
@@ -148,6 +150,8 @@ void SlicedImageProxy::setOutputFormat(Vector3D origin, Eigen::Array3i dim, Vect
 	// TODO investigate
 //	mReslicer->SetOutputExtent(0, dim[0]-1, 0, dim[1]-1, 0, 0);
 	mReslicer->SetOutputSpacing(spacing.data());
+	// same output extent (0..dim) as the reslicer
+	mBrickedSlicer->setOutputFormat(origin, dim+1, spacing);
 }
 
 void SlicedImageProxy::setSliceProxy(SliceProxyInterfacePtr slicer)
@@ -166,14 +170,28 @@ void SlicedImageProxy::setSliceProxy(SliceProxyInterfacePtr slicer)
 
 void SlicedImageProxy::transferFunctionsChangedSlot()
 {
-	mReslicer->SetInputData(mImage->getBaseVtkImageData());
-	mReslicer->SetBackgroundLevel(mImage->getMin());
+	if (mImage->isOutOfCore())
+	{
+		mBrickedSlicer->setBackgroundLevel(mImage->getMin());
+		this->update();
+	}
+	else
+	{
+		mReslicer->SetInputData(mImage->getBaseVtkImageData());
+		mReslicer->SetBackgroundLevel(mImage->getMin());
+	}
 	mImageWithLUTProxy->setInput(mRedirecter, mImage->getLookupTable2D()->getOutputLookupTable());
 }
 
+/** Out-of-core images are sliced through the bricks by mBrickedSlicer,
+ *  as the reslicer needs the whole volume in memory.
+ */
 void SlicedImageProxy::updateRedirecterSlot()
 {
-	mRedirecter->SetInputConnection(mReslicer->GetOutputPort());
+	if (mImage && mImage->isOutOfCore())
+		mBrickedSlicer->setInput(mImage);
+	else
+		mRedirecter->SetInputConnection(mReslicer->GetOutputPort());
 	update();
 }
 
@@ -244,6 +262,13 @@ void SlicedImageProxy::update()
 	Transform3D iMr = mImage->get_rMd().inv();
 	Transform3D M = iMr * rMs;
 
+	if (mImage->isOutOfCore())
+	{
+		vtkImageDataPtr slice = mBrickedSlicer->slice(M);
+		if (slice)
+			mRedirecter->SetInputData(slice);
+		return;
+	}
 	mMatrixAxes->DeepCopy(M.getVtkMatrix());
 }
 
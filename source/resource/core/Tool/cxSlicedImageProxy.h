@@ -26,6 +26,7 @@ namespace cx
 typedef boost::shared_ptr<class Image> ImagePtr;
 typedef boost::shared_ptr<class SliceProxy> SliceProxyPtr;
 typedef boost::shared_ptr<class SliceProxyInterface> SliceProxyInterfacePtr;
+typedef boost::shared_ptr<class ObliqueSlicer> ObliqueSlicerPtr;
 
 typedef boost::shared_ptr<class SlicedImageProxy> SlicedImageProxyPtr;
 typedef boost::shared_ptr<class ApplyLUTToImage2DProxy> ApplyLUTToImage2DProxyPtr;
@@ -64,7 +65,8 @@ private:
 /**\brief Helper class for slicing an image given a SliceProxy and an image.
  *
  * The image is sliced in software using the slice definition from
- * the SliceProxy
+ * the SliceProxy. Out-of-core images are sliced with an ObliqueSlicer
+ * reading only the bricks around the slice.
  *
  * Used internally by BlendedSliceRep and SlicerRepSW as the slice engine.
  * 
@@ -105,6 +107,7 @@ private:
 	vtkMatrix4x4Ptr mMatrixAxes;
 
 	vtkImageChangeInformationPtr mRedirecter;
+	ObliqueSlicerPtr mBrickedSlicer; ///< used instead of mReslicer for out-of-core images
 };
 
 //---------------------------------------------------------
@@ -14,6 +14,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkConeSource.h>
 #include "cxToolNull.h"
 #include "cxNullDeleter.h"
+#include "cxToolTransformHub.h"
 
 namespace cx
 {
@@ -39,6 +40,7 @@ Tool::Tool(const QString &uid, const QString &name) :
 {
 	if (name.isEmpty())
 		mName = uid;
+	ToolTransformHub::getInstance()->addTool(this);
 }
 
 ToolPtr Tool::getNullObject()
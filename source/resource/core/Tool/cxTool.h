@@ -139,7 +139,8 @@ public:
 #endif
 
 signals:
-	void toolTransformAndTimestamp(Transform3D matrix, double timestamp);
+	void toolTransformAndTimestamp(Transform3D matrix, double timestamp); ///< emitted for every sample
+	void toolTransformCoalesced(Transform3D matrix, double timestamp); ///< latest sample, emitted at most once per rendered frame. See ToolTransformHub
 	void toolVisible(bool visible);
 	void tooltipOffset(double offset);
 	void toolProbeSector();
@@ -0,0 +1,170 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxToolTransformHub.h"
+
+#include <QTimer>
+#include <QCoreApplication>
+#include "cxTool.h"
+#include "cxTracer.h"
+
+namespace cx
+{
+
+ToolTransformHub* ToolTransformHub::mTheInstance = NULL;
+
+ToolTransformHub* ToolTransformHub::getInstance()
+{
+	if (mTheInstance == NULL)
+		mTheInstance = new ToolTransformHub();
+	return mTheInstance;
+}
+
+void ToolTransformHub::shutdown()
+{
+	delete mTheInstance;
+	mTheInstance = NULL;
+}
+
+ToolTransformHub::ToolTransformHub() :
+	mPendingCount(0)
+{
+	// flush at a low rate if nobody else does, e.g. when rendering is off.
+	mFallbackTimer = new QTimer(this);
+	mFallbackTimer->setSingleShot(true);
+	mFallbackTimer->setInterval(100);
+	connect(mFallbackTimer, &QTimer::timeout, this, &ToolTransformHub::flush);
+
+	// tools might be created in other threads, keep the hub with the render loop.
+	if (QCoreApplication::instance())
+		this->moveToThread(QCoreApplication::instance()->thread());
+}
+
+void ToolTransformHub::setFallbackInterval(int msecs)
+{
+	mFallbackTimer->setInterval(msecs);
+}
+
+void ToolTransformHub::addTool(Tool* tool)
+{
+	// The hub is the context object: samples from other threads are queued to
+	// the hub thread, and the connections are removed with either object.
+	QPointer<Tool> guard(tool);
+	connect(tool, &Tool::toolTransformAndTimestamp, this, [this, guard](Transform3D prMt, double timestamp)
+	{
+		if (guard)
+			this->push(guard.data(), prMt, timestamp);
+	});
+	connect(tool, &QObject::destroyed, this, [this, tool]() { this->removeTool(tool); });
+}
+
+void ToolTransformHub::removeTool(Tool* tool)
+{
+	EntryMap::iterator iter = mEntries.find(tool);
+	if (iter==mEntries.end())
+		return;
+	if (iter->second.pending)
+		--mPendingCount;
+	mEntries.erase(iter);
+}
+
+void ToolTransformHub::push(Tool* tool, const Transform3D& prMt, double timestamp)
+{
+	Entry& entry = mEntries[tool];
+	if (!entry.tool)
+	{
+		entry.tool = tool;
+		entry.uid = tool->getUid();
+	}
+	entry.prMt = prMt;
+	entry.timestamp = timestamp;
+	++entry.statistics.received;
+	CX_TRACE_INSTANT("tracking", "transform received");
+
+	if (!entry.pending)
+	{
+		entry.pending = true;
+		++mPendingCount;
+		if (mPendingCount==1)
+			emit transformsPending();
+	}
+
+	if (!mFallbackTimer->isActive())
+		mFallbackTimer->start();
+}
+
+int ToolTransformHub::flush()
+{
+	if (!mPendingCount)
+		return 0;
+	CX_TRACE_SCOPE("tracking", "flush transforms");
+	CX_TRACE_COUNTER("tracking", "pending tools", mPendingCount);
+
+	// collect before emitting: listeners might push new samples or delete tools
+	std::vector<Entry> pending;
+	for (EntryMap::iterator iter=mEntries.begin(); iter!=mEntries.end(); ++iter)
+	{
+		if (!iter->second.pending)
+			continue;
+		iter->second.pending = false;
+		++iter->second.statistics.delivered;
+		pending.push_back(iter->second);
+	}
+	mPendingCount = 0;
+	mFallbackTimer->stop();
+
+	int retval = 0;
+	for (unsigned i=0; i<pending.size(); ++i)
+	{
+		Entry& entry = pending[i];
+		if (!entry.tool)
+			continue;
+		++retval;
+		emit entry.tool->toolTransformCoalesced(entry.prMt, entry.timestamp);
+	}
+	return retval;
+}
+
+ToolTransformHub::Statistics ToolTransformHub::getStatistics(QString toolUid) const
+{
+	Statistics retval;
+	for (EntryMap::const_iterator iter=mEntries.begin(); iter!=mEntries.end(); ++iter)
+	{
+		if (iter->second.uid != toolUid)
+			continue;
+		retval.received += iter->second.statistics.received;
+		retval.delivered += iter->second.statistics.delivered;
+	}
+	return retval;
+}
+
+ToolTransformHub::Statistics ToolTransformHub::getTotalStatistics() const
+{
+	Statistics retval;
+	for (EntryMap::const_iterator iter=mEntries.begin(); iter!=mEntries.end(); ++iter)
+	{
+		retval.received += iter->second.statistics.received;
+		retval.delivered += iter->second.statistics.delivered;
+	}
+	return retval;
+}
+
+void ToolTransformHub::resetStatistics()
+{
+	for (EntryMap::iterator iter=mEntries.begin(); iter!=mEntries.end(); ++iter)
+		iter->second.statistics = Statistics();
+}
+
+int ToolTransformHub::getNumberOfTools() const
+{
+	return int(mEntries.size());
+}
+
+} // namespace cx
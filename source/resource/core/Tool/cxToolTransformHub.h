@@ -0,0 +1,100 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTOOLTRANSFORMHUB_H
+#define CXTOOLTRANSFORMHUB_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <QObject>
+#include <QPointer>
+#include "cxTransform3D.h"
+
+class QTimer;
+
+namespace cx
+{
+class Tool;
+
+/** \brief Coalesced delivery of tool transforms.
+ *
+ * Tools emit Tool::toolTransformAndTimestamp() for every sample,
+ * at tracking rate. Listeners that only redraw or recompute
+ * something for display need at most one update per rendered
+ * frame, and can instead connect to Tool::toolTransformCoalesced().
+ *
+ * Every Tool registers itself in its constructor, so all tool types
+ * reach the hub regardless of how they emit their samples. Entries are
+ * removed when the tool is destroyed.
+ *
+ * The hub keeps the latest sample per tool, and delivers it on
+ * flush(). The render loop calls flush() once per frame before
+ * rendering. A fallback timer flushes when no render loop is running.
+ * transformsPending() lets an idle render loop wake up for the flush.
+ *
+ * The position history of the tools is unaffected, all samples are
+ * still recorded.
+ *
+ * \ingroup cx_resource_core_tool
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ToolTransformHub : public QObject
+{
+	Q_OBJECT
+public:
+	struct Statistics
+	{
+		Statistics() : received(0), delivered(0) {}
+		int received; ///< samples pushed to the hub
+		int delivered; ///< samples emitted as coalesced transforms
+		int coalesced() const { return received-delivered; } ///< intermediate samples that were dropped
+	};
+
+	static ToolTransformHub* getInstance();
+	static void shutdown();
+
+	void addTool(Tool* tool); ///< listen to all samples from tool, called by the Tool constructor
+	void push(Tool* tool, const Transform3D& prMt, double timestamp); ///< store latest sample for tool, deliver on next flush()
+	int flush(); ///< deliver all pending samples, return number of tools updated
+	void setFallbackInterval(int msecs);
+
+	Statistics getStatistics(QString toolUid) const;
+	Statistics getTotalStatistics() const;
+	void resetStatistics();
+	int getNumberOfTools() const;
+
+signals:
+	void transformsPending(); ///< emitted when a sample arrives and nothing was pending, i.e. at most once per flush()
+
+private:
+	ToolTransformHub();
+	void removeTool(Tool* tool);
+	struct Entry
+	{
+		Entry() : pending(false), timestamp(0) {}
+		QPointer<Tool> tool;
+		QString uid;
+		bool pending;
+		Transform3D prMt;
+		double timestamp;
+		Statistics statistics;
+	};
+	typedef std::map<Tool*, Entry> EntryMap;
+	EntryMap mEntries;
+	QTimer* mFallbackTimer;
+	int mPendingCount;
+
+	static ToolTransformHub* mTheInstance;
+};
+
+} // namespace cx
+
+#endif // CXTOOLTRANSFORMHUB_H
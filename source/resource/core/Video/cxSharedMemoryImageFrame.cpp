@@ -0,0 +1,126 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxSharedMemoryImageFrame.h"
+
+#include <string.h>
+#include <QCoreApplication>
+#include <vtkImageData.h>
+#include "cxImage.h"
+#include "cxRegistrationTransform.h"
+
+namespace cx
+{
+
+namespace
+{
+const qint32 frameMagic = 0x43584946; // "CXIF"
+
+struct shm_image_header
+{
+	qint32 magic;
+	qint32 headerSize;
+	char name[64];
+	qint64 acquisitionTime;	// ms since epoch
+	qint32 dim[3];
+	qint32 scalarType;		// VTK scalar type
+	qint32 components;
+	qint32 scalarSize;
+	double spacing[3];
+	double rMd[16];			// row major
+};
+
+int getScalarBytes(vtkImageDataPtr image)
+{
+	int* dim = image->GetDimensions();
+	return dim[0] * dim[1] * dim[2] * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+}
+} // namespace
+
+QString SharedMemoryImageFrame::getKey(int port, int generation)
+{
+	// unique per server process and ring, a stale or attached ring never blocks a new one
+	return QString("cxVideo_%1_%2_%3").arg(port).arg(QCoreApplication::applicationPid()).arg(generation);
+}
+
+int SharedMemoryImageFrame::getHeaderSize()
+{
+	return (sizeof(shm_image_header) + 63) / 64 * 64;
+}
+
+int SharedMemoryImageFrame::getFrameSize(ImagePtr image)
+{
+	if (!image || !image->getBaseVtkImageData())
+		return 0;
+	return getHeaderSize() + getScalarBytes(image->getBaseVtkImageData());
+}
+
+int SharedMemoryImageFrame::encode(ImagePtr image, void* buffer, int bufferSize)
+{
+	int size = getFrameSize(image);
+	if (!buffer || size == 0 || size > bufferSize)
+		return 0;
+	vtkImageDataPtr data = image->getBaseVtkImageData();
+
+	shm_image_header* header = static_cast<shm_image_header*>(buffer);
+	header->magic = frameMagic;
+	header->headerSize = getHeaderSize();
+	QByteArray name = image->getName().toUtf8().left(sizeof(header->name) - 1);
+	memset(header->name, 0, sizeof(header->name));
+	memcpy(header->name, name.constData(), name.size());
+	header->acquisitionTime = image->getAcquisitionTime().toMSecsSinceEpoch();
+	int* dim = data->GetDimensions();
+	double* spacing = data->GetSpacing();
+	for (int i = 0; i < 3; ++i)
+	{
+		header->dim[i] = dim[i];
+		header->spacing[i] = spacing[i];
+	}
+	header->scalarType = data->GetScalarType();
+	header->components = data->GetNumberOfScalarComponents();
+	header->scalarSize = data->GetScalarSize();
+	Transform3D rMd = image->get_rMd();
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			header->rMd[4 * r + c] = rMd.matrix()(r, c);
+
+	memcpy(static_cast<char*>(buffer) + header->headerSize, data->GetScalarPointer(), getScalarBytes(data));
+	return size;
+}
+
+ImagePtr SharedMemoryImageFrame::decode(const void* buffer, int size)
+{
+	const shm_image_header* header = static_cast<const shm_image_header*>(buffer);
+	if (!header || size < getHeaderSize() || header->magic != frameMagic)
+		return ImagePtr();
+
+	vtkImageDataPtr data = vtkImageDataPtr::New();
+	data->SetDimensions(header->dim[0], header->dim[1], header->dim[2]);
+	data->SetExtent(0, header->dim[0]-1, 0, header->dim[1]-1, 0, header->dim[2]-1);
+	data->SetSpacing(header->spacing[0], header->spacing[1], header->spacing[2]);
+	data->AllocateScalars(header->scalarType, header->components);
+	int scalarBytes = getScalarBytes(data);
+	if (header->headerSize + scalarBytes > size)
+		return ImagePtr();
+	memcpy(data->GetScalarPointer(), static_cast<const char*>(buffer) + header->headerSize, scalarBytes);
+
+	QString name = QString::fromUtf8(header->name);
+	ImagePtr retval(new Image(name, data));
+	retval->setAcquisitionTime(QDateTime::fromMSecsSinceEpoch(header->acquisitionTime));
+	Transform3D rMd = Transform3D::Identity();
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			rMd.matrix()(r, c) = header->rMd[4 * r + c];
+	retval->get_rMd_History()->setRegistration(rMd);
+	return retval;
+}
+
+} // namespace cx
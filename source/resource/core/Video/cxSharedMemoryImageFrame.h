@@ -0,0 +1,52 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXSHAREDMEMORYIMAGEFRAME_H
+#define CXSHAREDMEMORYIMAGEFRAME_H
+
+#include "cxResourceExport.h"
+
+#include <QString>
+#include "cxForwardDeclarations.h"
+
+namespace cx
+{
+
+/** \brief Layout of a video frame in a SharedMemoryRingWriter slot.
+ *
+ * A fixed size header with name, acquisition time, dimensions, spacing,
+ * scalar type and rMd, followed by the raw scalars. This is the shared
+ * memory counterpart of IGTLinkConversionImage, used between a video server
+ * and a client on the same machine. As with IGTLink, the image name is
+ * used as the uid of the decoded image.
+ *
+ * The client asks for shared memory by sending a STRING message named
+ * getRequestDeviceName() over the IGTLink socket. The server answers
+ * with a STRING message named getKeyDeviceName() holding the ring key,
+ * each time it creates a ring. Until then, images go through the socket.
+ *
+ * \ingroup cx_resource_core_video
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT SharedMemoryImageFrame
+{
+public:
+	static QString getKey(int port, int generation); ///< Key of a ring created by the video server listening to port
+	static QString getRequestDeviceName() { return "CX_SHM_REQUEST"; } ///< IGTLink STRING from the client: send images through shared memory
+	static QString getKeyDeviceName() { return "CX_SHM_KEY"; } ///< IGTLink STRING from the server: key of the current ring
+	static int getHeaderSize();
+	static int getFrameSize(ImagePtr image); ///< Size needed to encode image
+	static int encode(ImagePtr image, void* buffer, int bufferSize); ///< Return the size used, 0 if the frame did not fit
+	static ImagePtr decode(const void* buffer, int size);
+};
+
+} // namespace cx
+
+#endif // CXSHAREDMEMORYIMAGEFRAME_H
@@ -17,7 +17,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <vtkImageResample.h>
 #include <vtkImageClip.h>
-#include <vtkImageChangeInformation.h>
 
 #include "cxImage.h"
 #include "cxPatientModelService.h"
@@ -29,7 +28,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTime.h"
 #include "cxVolumeHelpers.h"
 
-#include "cxSlicedImageProxy.h"
+#include "cxObliqueSlicer.h"
 #include "cxSliceProxy.h"
 #include "cxLogger.h"
 #include "cxEnumConversion.h"
@@ -233,13 +232,7 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D outpu
 	}
 
 	cx::SliceProxyPtr proxy = cx::SliceProxy::create(patientModel);
-	SlicedImageProxyPtr imageSlicer(new SlicedImageProxy);
-
 	proxy->setTool(sliceTool);
-
-	imageSlicer->setSliceProxy(proxy);
-	imageSlicer->setImage(image);
-
 	proxy->initializeFromPlane(planeType, false, false, 1, 0);
 	proxy->setClinicalApplicationToFixedValue(mdRADIOLOGICAL);//Always create slices in radiological view
 
@@ -247,21 +240,20 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D outpu
 	double screenX = outputDimensions[0]*outputSpacing[0] / 2;
 	double screenY = outputDimensions[1]*outputSpacing[1] / 2;
 
-	imageSlicer->setOutputFormat(Vector3D(-screenX,-screenY,0), outputDimensions, outputSpacing);
+	// same output extent (0..dim) as SlicedImageProxy::setOutputFormat()
+	Eigen::Array3i dim = outputDimensions + 1;
+	Transform3D iMs = image->get_rMd().inv() * proxy->get_sMr().inv();
 
-	imageSlicer->update();
+	ObliqueSlicer slicer;
+	slicer.setInput(image);
+	slicer.setBackgroundLevel(image->getMin());
 	if (applyLUT)
-	{
-		imageSlicer->getOutputPort()->Update();
-		retval->DeepCopy(imageSlicer->getOutput());
-	}
-	else //Don't use LUT
-	{
-		imageSlicer->getOutputPortWithoutLUT()->Update();
-		retval->DeepCopy(imageSlicer->getOutputWithoutLUT());
-
-	}
+		slicer.setLookupTable(image->getLookupTable2D()->getOutputLookupTable());
+	slicer.setOutputFormat(Vector3D(-screenX,-screenY,0), dim, outputSpacing);
 
+	vtkImageDataPtr slice = slicer.slice(iMs);
+	if (slice)
+		retval = slice;
 	return retval;
 }
 
@@ -269,24 +261,14 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 {
 	vtkImageDataPtr slicedImage = vtkImageDataPtr::New();
 
-	vtkImageReslicePtr imageReslicer = vtkImageReslicePtr::New();
-
-	imageReslicer->SetInputData(image->getBaseVtkImageData());
-	imageReslicer->SetBackgroundLevel(image->getMin());
-
-	imageReslicer->SetInterpolationModeToLinear();
-	imageReslicer->SetOutputDimensionality(2);
-
-
 	Eigen::Array3d inputSpacing = image->getSpacing();
 
-	//imageReslicer->SetOutputOrigin(image->getBaseVtkImageData()->GetOrigin()); // set to [0, 0, 0] ??
 //	double origin[3];
 //	image->getBaseVtkImageData()->GetOrigin(origin);
 
 //	Eigen::Array3d spacing = image->getSpacing();
-	int extent[6];
-	image->getBaseVtkImageData()->GetExtent(extent);
+	Eigen::Array3i dim = image->getDimensions();
+	int extent[6] = {0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1};
 
 	Transform3D rMd = image->get_rMd();
 
@@ -300,6 +282,8 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 	Vector3D up(0, -1, 0);
 	Vector3D xAxis;
 	Vector3D yAxis;
+	IntBoundingBox3D outExtent;
+	Vector3D outSpacing(1, 1, 1);
 
 
 	switch (planeType)
@@ -321,9 +305,8 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 		resliceAxes->SetElement(3, 1, 0);
 		resliceAxes->SetElement(3, 2, 0);
 		resliceAxes->SetElement(3, 3, 1);
-		imageReslicer->SetResliceAxes(resliceAxes);
-		imageReslicer->SetOutputExtent(extent[0], extent[1], extent[2], extent[3], 0, 0);
-		imageReslicer->SetOutputSpacing(inputSpacing[0], inputSpacing[1], 0);
+		outExtent = IntBoundingBox3D(extent[0], extent[1], extent[2], extent[3]);
+		outSpacing = Vector3D(inputSpacing[0], inputSpacing[1], 1);
 		break;
 	case ptCORONAL:
 		resliceAxes->SetElement(0, 0, 1);
@@ -342,9 +325,8 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 		resliceAxes->SetElement(3, 1, 0);
 		resliceAxes->SetElement(3, 2, 0);
 		resliceAxes->SetElement(3, 3, 1);
-		imageReslicer->SetResliceAxes(resliceAxes);
-		imageReslicer->SetOutputExtent(extent[0], extent[1], extent[4], extent[5], 0, 0);
-		imageReslicer->SetOutputSpacing(inputSpacing[0], inputSpacing[2], 0);
+		outExtent = IntBoundingBox3D(extent[0], extent[1], extent[4], extent[5]);
+		outSpacing = Vector3D(inputSpacing[0], inputSpacing[2], 1);
 		break;
 	case ptSAGITTAL:
 		resliceAxes->SetElement(0, 0, 0);
@@ -363,9 +345,8 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 		resliceAxes->SetElement(3, 1, 0);
 		resliceAxes->SetElement(3, 2, 0);
 		resliceAxes->SetElement(3, 3, 1);
-		imageReslicer->SetResliceAxes(resliceAxes);
-		imageReslicer->SetOutputExtent(extent[2], extent[3], extent[4], extent[5], 0, 0);
-		imageReslicer->SetOutputSpacing(inputSpacing[1], inputSpacing[2], 0);
+		outExtent = IntBoundingBox3D(extent[2], extent[3], extent[4], extent[5]);
+		outSpacing = Vector3D(inputSpacing[1], inputSpacing[2], 1);
 		break;
 	case ptRADIALPLANE:
 		targetTransform_d = rMd.inv() * createTransformTranslate(target_r);
@@ -392,30 +373,32 @@ vtkImageDataPtr createSlice(ImagePtr image, PLANE_TYPE planeType, Vector3D posit
 		resliceAxes->SetElement(3, 1, 0);
 		resliceAxes->SetElement(3, 2, 0);
 		resliceAxes->SetElement(3, 3, 1);
-		imageReslicer->SetResliceAxes(resliceAxes);
-		imageReslicer->SetOutputExtent(extent[0], extent[1], extent[2], extent[3], 0, 0);
-		imageReslicer->SetOutputSpacing(inputSpacing[0], inputSpacing[1], 0);
+		outExtent = IntBoundingBox3D(extent[0], extent[1], extent[2], extent[3]);
+		outSpacing = Vector3D(inputSpacing[0], inputSpacing[1], 1);
 		break;
 	default:
 		CX_LOG_WARNING() << "Not a valid plane type." << enum2string(planeType);
 	}
 
-	imageReslicer->Update();
+	// the output is centered on the input, as vtkImageReslice does when no origin is given.
+	Transform3D iMs(resliceAxes.GetPointer());
+	Vector3D center_s = transform(iMs.inv(), image->boundingBox()).center();
+	Vector3D origin(0, 0, 0);
+	for (int i=0; i<2; ++i)
+		origin[i] = center_s[i] - (outExtent[2*i+1]-outExtent[2*i])*outSpacing[i]/2;
 
+	ObliqueSlicer slicer;
+	slicer.setInput(image);
+	slicer.setBackgroundLevel(image->getMin());
 	if (applyLUT)
-	{
-		ApplyLUTToImage2DProxyPtr imageWithLUTProxyPtr = ApplyLUTToImage2DProxyPtr(new ApplyLUTToImage2DProxy());
-		vtkImageChangeInformationPtr redirecterPtr = vtkImageChangeInformationPtr::New();
-		redirecterPtr->SetInputConnection(imageReslicer->GetOutputPort());
-
-		imageWithLUTProxyPtr->setInput(redirecterPtr, image->getLookupTable2D()->getOutputLookupTable());
-
-		imageWithLUTProxyPtr->getOutputPort()->Update();
-		slicedImage->DeepCopy(imageWithLUTProxyPtr->getOutput());
-	}
-	else
-			slicedImage = imageReslicer->GetOutput();
-
+		slicer.setLookupTable(image->getLookupTable2D()->getOutputLookupTable());
+	slicer.setOutputFormat(origin,
+						   Eigen::Array3i(outExtent[1]-outExtent[0]+1, outExtent[3]-outExtent[2]+1, 1),
+						   outSpacing);
+
+	vtkImageDataPtr slice = slicer.slice(iMs);
+	if (slice)
+		slicedImage = slice;
 	return slicedImage;
 }
 
@@ -0,0 +1,584 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxObliqueSlicer.h"
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkLookupTable.h>
+#include <vtkTemplateAliasMacro.h>
+#include "cxImage.h"
+
+namespace cx
+{
+
+namespace
+{
+const int minRowsPerBand = 8;
+const int tileSize = 128; ///< output tile size in pixels, for bricked input
+
+/** Everything needed to compute one call, independent of the scalar type.
+ *  Positions are continuous voxel indices into the input.
+ */
+struct Job
+{
+	const void* input;
+	int inDim[3];
+	vtkIdType inInc[3];
+	int numComps;
+	bool linear;
+	double background;
+
+	Vector3D start; ///< position of output voxel (0,0,0)
+	Vector3D dx; ///< step along output x
+	Vector3D dy; ///< step along output y
+	Vector3D dz; ///< step between slices
+	int outDim[2];
+	int count; ///< number of slices
+	bool mip; ///< reduce the slices to one using max
+
+	const unsigned char* colors; ///< rgba table, zero gives raw output
+	const unsigned char* luminance;
+	int tableSize;
+	double tableOffset;
+	double tableScale;
+
+	void* output;
+	int outComps;
+	vtkIdType outRowStride; ///< values between output rows
+	vtkIdType outSliceStride; ///< values between output slices
+};
+
+template<class T>
+inline T clampRound(double value)
+{
+	if (std::numeric_limits<T>::is_integer)
+	{
+		value = std::floor(value+0.5);
+		value = std::max<double>(value, std::numeric_limits<T>::lowest());
+		value = std::min<double>(value, std::numeric_limits<T>::max());
+	}
+	return static_cast<T>(value);
+}
+
+template<class T>
+class Sampler
+{
+public:
+	explicit Sampler(const Job& job) :
+		mData(static_cast<const T*>(job.input)),
+		mNumComps(job.numComps)
+	{
+		for (int i=0; i<3; ++i)
+		{
+			mDim[i] = job.inDim[i];
+			mInc[i] = job.inInc[i];
+			mStep[i] = (mDim[i]>1) ? mInc[i] : 0;
+			mMax[i] = mDim[i]-1;
+		}
+	}
+
+	/** Sample numComps values at position p, using a half voxel border.
+	 *  Return false if outside.
+	 */
+	inline bool nearest(const double* p, double* out) const
+	{
+		if (!this->inside(p))
+			return false;
+		vtkIdType offset = 0;
+		for (int i=0; i<3; ++i)
+			offset += std::min(std::max(int(std::floor(p[i]+0.5)), 0), mMax[i]) * mInc[i];
+		const T* ptr = mData + offset;
+		for (int c=0; c<mNumComps; ++c)
+			out[c] = ptr[c];
+		return true;
+	}
+
+	inline bool linear(const double* p, double* out) const
+	{
+		if (!this->inside(p))
+			return false;
+		int index[3];
+		double f[3];
+		vtkIdType offset = 0;
+		for (int i=0; i<3; ++i)
+		{
+			double x = std::min(std::max(p[i], 0.0), double(mMax[i]));
+			index[i] = std::max(0, std::min(int(x), mMax[i]-1));
+			f[i] = x - index[i];
+			offset += index[i] * mInc[i];
+		}
+
+		const T* p000 = mData + offset;
+		const T* p100 = p000 + mStep[0];
+		const T* p010 = p000 + mStep[1];
+		const T* p110 = p010 + mStep[0];
+		const T* p001 = p000 + mStep[2];
+		const T* p101 = p001 + mStep[0];
+		const T* p011 = p001 + mStep[1];
+		const T* p111 = p011 + mStep[0];
+		double rx = 1.0-f[0];
+		double ry = 1.0-f[1];
+		double rz = 1.0-f[2];
+		for (int c=0; c<mNumComps; ++c)
+		{
+			double v00 = rx*p000[c] + f[0]*p100[c];
+			double v10 = rx*p010[c] + f[0]*p110[c];
+			double v01 = rx*p001[c] + f[0]*p101[c];
+			double v11 = rx*p011[c] + f[0]*p111[c];
+			out[c] = rz*(ry*v00 + f[1]*v10) + f[2]*(ry*v01 + f[1]*v11);
+		}
+		return true;
+	}
+
+private:
+	inline bool inside(const double* p) const
+	{
+		return p[0]>=-0.5 && p[0]<=mMax[0]+0.5
+			&& p[1]>=-0.5 && p[1]<=mMax[1]+0.5
+			&& p[2]>=-0.5 && p[2]<=mMax[2]+0.5;
+	}
+
+	const T* mData;
+	int mNumComps;
+	int mDim[3];
+	int mMax[3];
+	vtkIdType mInc[3];
+	vtkIdType mStep[3]; ///< increment to the next voxel used by the interpolation
+};
+
+/** Sample one output row into values, numComps values per voxel.
+ */
+template<class T>
+void sampleRow(const Job& job, const Sampler<T>& sampler, Vector3D pos, double* values)
+{
+	const int n = job.outDim[0];
+	const int nc = job.numComps;
+	double p[3] = { pos[0], pos[1], pos[2] };
+	const double d[3] = { job.dx[0], job.dx[1], job.dx[2] };
+	for (int x=0; x<n; ++x, values+=nc)
+	{
+		bool hit = job.linear ? sampler.linear(p, values) : sampler.nearest(p, values);
+		if (!hit)
+			for (int c=0; c<nc; ++c)
+				values[c] = job.background;
+		p[0] += d[0];
+		p[1] += d[1];
+		p[2] += d[2];
+	}
+}
+
+inline int tableIndex(const Job& job, double value)
+{
+	double index = (value - job.tableOffset) * job.tableScale;
+	index = std::min(std::max(index, 0.0), double(job.tableSize-1));
+	return int(index);
+}
+
+/** Map a row of values through the table, as vtkImageMapToColors:
+ *  RGBA for gray input, luminance per component for color input.
+ */
+void writeColors(const Job& job, const double* values, unsigned char* out)
+{
+	const int n = job.outDim[0];
+	if (job.numComps < 3)
+	{
+		for (int x=0; x<n; ++x, values+=job.numComps, out+=4)
+		{
+			const unsigned char* rgba = job.colors + 4*tableIndex(job, values[0]);
+			out[0] = rgba[0];
+			out[1] = rgba[1];
+			out[2] = rgba[2];
+			out[3] = rgba[3];
+		}
+		return;
+	}
+
+	for (int x=0; x<n; ++x, values+=job.numComps, out+=job.outComps)
+	{
+		for (int c=0; c<job.numComps; ++c)
+			out[c] = job.luminance[tableIndex(job, values[c])];
+		if (job.numComps==3)
+			out[3] = job.colors[4*tableIndex(job, values[2])+3];
+	}
+}
+
+template<class T>
+void writeRaw(const Job& job, const double* values, T* out)
+{
+	const vtkIdType n = vtkIdType(job.outDim[0])*job.numComps;
+	for (vtkIdType i=0; i<n; ++i)
+		out[i] = clampRound<T>(values[i]);
+}
+
+/** Compute the output rows in parallel bands. Each band
+ *  reuses its row buffers for all its rows.
+ */
+template<class T>
+void executeTyped(const Job& job)
+{
+	Sampler<T> sampler(job);
+	const int outputSlices = job.mip ? 1 : job.count;
+	const int rows = job.outDim[1]*outputSlices;
+	const vtkIdType rowSize = vtkIdType(job.outDim[0])*job.numComps;
+
+	int numBands = std::max(1, std::min(QThread::idealThreadCount()*4, rows/minRowsPerBand));
+	std::vector<std::pair<int,int> > bands(numBands);
+	for (int i=0; i<numBands; ++i)
+		bands[i] = std::make_pair((rows*i)/numBands, (rows*(i+1))/numBands);
+
+	auto computeBand = [&](const std::pair<int,int>& band)
+	{
+		std::vector<double> values(rowSize);
+		std::vector<double> sample(job.mip ? rowSize : 0);
+		for (int row=band.first; row<band.second; ++row)
+		{
+			int slice = row / job.outDim[1];
+			int y = row % job.outDim[1];
+			Vector3D pos = job.start + double(y)*job.dy + double(slice)*job.dz;
+
+			sampleRow(job, sampler, pos, &values[0]);
+			for (int s=1; job.mip && s<job.count; ++s)
+			{
+				sampleRow(job, sampler, pos + double(s)*job.dz, &sample[0]);
+				for (vtkIdType i=0; i<rowSize; ++i)
+					values[i] = std::max(values[i], sample[i]);
+			}
+
+			vtkIdType offset = slice*job.outSliceStride + y*job.outRowStride;
+			if (job.colors)
+				writeColors(job, &values[0], static_cast<unsigned char*>(job.output) + offset);
+			else
+				writeRaw(job, &values[0], static_cast<T*>(job.output) + offset);
+		}
+	};
+
+	if (numBands==1)
+		computeBand(bands[0]);
+	else
+		QtConcurrent::blockingMap(bands, computeBand);
+}
+
+void setJobInput(Job* job, vtkImageDataPtr input)
+{
+	job->input = input->GetScalarPointer();
+	input->GetDimensions(job->inDim);
+	job->inInc[0] = job->numComps;
+	job->inInc[1] = job->inInc[0]*job->inDim[0];
+	job->inInc[2] = job->inInc[1]*job->inDim[1];
+}
+
+/** Voxel extent needed for sampling job, with a one voxel border for
+ *  the interpolation. Clamped to bounds, but never empty: samples far
+ *  outside bounds are also outside the clamped extent.
+ */
+IntBoundingBox3D getSampleExtent(const Job& job, const IntBoundingBox3D& bounds)
+{
+	Vector3D lo = job.start;
+	Vector3D hi = job.start;
+	for (int k=0; k<2; ++k)
+		for (int j=0; j<2; ++j)
+			for (int i=0; i<2; ++i)
+			{
+				Vector3D p = job.start + double(i*(job.outDim[0]-1))*job.dx
+						+ double(j*(job.outDim[1]-1))*job.dy + double(k*(job.count-1))*job.dz;
+				lo = lo.cwiseMin(p);
+				hi = hi.cwiseMax(p);
+			}
+
+	IntBoundingBox3D retval;
+	for (int i=0; i<3; ++i)
+	{
+		double first = std::min(std::max(std::floor(lo[i])-1, double(bounds[2*i])), double(bounds[2*i+1]));
+		double last = std::max(std::min(std::ceil(hi[i])+1, double(bounds[2*i+1])), first);
+		retval[2*i] = int(first);
+		retval[2*i+1] = int(last);
+	}
+	return retval;
+}
+
+template<class T>
+void executeBrickedTyped(const Job& job, BrickedVolumePtr input, int outScalarSize)
+{
+	for (int y=0; y<job.outDim[1]; y+=tileSize)
+	{
+		for (int x=0; x<job.outDim[0]; x+=tileSize)
+		{
+			Job tile = job;
+			tile.outDim[0] = std::min(tileSize, job.outDim[0]-x);
+			tile.outDim[1] = std::min(tileSize, job.outDim[1]-y);
+			tile.start = job.start + double(x)*job.dx + double(y)*job.dy;
+			IntBoundingBox3D extent = getSampleExtent(tile, input->getExtent());
+			vtkImageDataPtr region = input->readRegion(extent);
+			setJobInput(&tile, region);
+			tile.start -= Vector3D(extent[0], extent[2], extent[4]);
+			vtkIdType offset = y*job.outRowStride + vtkIdType(x)*job.outComps;
+			tile.output = static_cast<char*>(job.output) + offset*outScalarSize;
+			executeTyped<T>(tile);
+		}
+	}
+}
+} // namespace
+
+ObliqueSlicer::ObliqueSlicer() :
+	mLinear(true),
+	mBackground(0),
+	mUseWindowLevel(false),
+	mWindow(1),
+	mLevel(0),
+	mOrigin(0,0,0),
+	mDim(0,0,1),
+	mSpacing(1,1,1),
+	mTableModified(0)
+{
+	mTableRange[0] = 0;
+	mTableRange[1] = 1;
+}
+
+ObliqueSlicer::~ObliqueSlicer()
+{
+}
+
+void ObliqueSlicer::setInput(vtkImageDataPtr input)
+{
+	mInput = input;
+	mBrickedInput.reset();
+}
+
+void ObliqueSlicer::setInput(BrickedVolumePtr input)
+{
+	mBrickedInput = input;
+	mInput = NULL;
+}
+
+void ObliqueSlicer::setInput(ImagePtr image)
+{
+	if (image && image->isOutOfCore())
+		this->setInput(image->getBrickedVolume());
+	else
+		this->setInput(image ? image->getBaseVtkImageData() : vtkImageDataPtr());
+}
+
+void ObliqueSlicer::setLinearInterpolation(bool on)
+{
+	mLinear = on;
+}
+
+void ObliqueSlicer::setBackgroundLevel(double value)
+{
+	mBackground = value;
+}
+
+void ObliqueSlicer::setLookupTable(vtkLookupTablePtr lut)
+{
+	if (mLut==lut)
+		return;
+	mLut = lut;
+	mColors.clear();
+	mTableModified = 0;
+}
+
+void ObliqueSlicer::setWindowLevel(double window, double level)
+{
+	mUseWindowLevel = true;
+	mWindow = window;
+	mLevel = level;
+}
+
+void ObliqueSlicer::clearWindowLevel()
+{
+	mUseWindowLevel = false;
+}
+
+void ObliqueSlicer::setOutputFormat(Vector3D origin, Eigen::Array3i dim, Vector3D spacing)
+{
+	mOrigin = origin;
+	mDim = dim;
+	mSpacing = spacing;
+}
+
+vtkImageDataPtr ObliqueSlicer::slice(const Transform3D& iMs)
+{
+	return this->execute(iMs, 1, 0, false);
+}
+
+vtkImageDataPtr ObliqueSlicer::slices(const Transform3D& iMs, int count, double distance)
+{
+	return this->execute(iMs, count, distance, false);
+}
+
+vtkImageDataPtr ObliqueSlicer::slab(const Transform3D& iMs, int count, double distance)
+{
+	Transform3D first = iMs * createTransformTranslate(Vector3D(0, 0, -0.5*(count-1)*distance));
+	return this->execute(first, count, distance, true);
+}
+
+/** Rebuild the rgba table if the lut has changed.
+ *  Return false if no table is used.
+ */
+bool ObliqueSlicer::updateColorTable()
+{
+	if (!mLut && !mUseWindowLevel)
+		return false;
+
+	if (mLut && !mColors.empty() && mLut->GetMTime()==mTableModified)
+		return true;
+	if (!mLut && !mColors.empty())
+		return true;
+
+	if (mLut)
+	{
+		int size = mLut->GetNumberOfTableValues();
+		const unsigned char* table = mLut->GetPointer(0);
+		mColors.assign(table, table+4*size);
+		mLut->GetTableRange(mTableRange);
+		mTableModified = mLut->GetMTime();
+	}
+	else
+	{
+		mColors.resize(4*256);
+		for (int i=0; i<256; ++i)
+		{
+			mColors[4*i+0] = mColors[4*i+1] = mColors[4*i+2] = i;
+			mColors[4*i+3] = 255;
+		}
+		mTableRange[0] = 0;
+		mTableRange[1] = 255;
+	}
+
+	int size = int(mColors.size()/4);
+	mLuminance.resize(size);
+	for (int i=0; i<size; ++i)
+	{
+		const unsigned char* rgba = &mColors[4*i];
+		mLuminance[i] = static_cast<unsigned char>(0.30*rgba[0] + 0.59*rgba[1] + 0.11*rgba[2] + 0.5);
+	}
+	return !mColors.empty();
+}
+
+vtkImageDataPtr ObliqueSlicer::getOutputBuffer(int count, int scalarType, int numComps)
+{
+	if (mOutput)
+	{
+		int dim[3];
+		mOutput->GetDimensions(dim);
+		if (dim[0]==mDim[0] && dim[1]==mDim[1] && dim[2]==count
+				&& mOutput->GetScalarType()==scalarType
+				&& mOutput->GetNumberOfScalarComponents()==numComps)
+			return mOutput;
+	}
+
+	mOutput = vtkImageDataPtr::New();
+	mOutput->SetDimensions(mDim[0], mDim[1], count);
+	mOutput->AllocateScalars(scalarType, numComps);
+	return mOutput;
+}
+
+vtkImageDataPtr ObliqueSlicer::execute(const Transform3D& iMs, int count, double distance, bool mip)
+{
+	bool hasInput = mBrickedInput || (mInput && mInput->GetPointData()->GetScalars());
+	if (!hasInput || mDim[0]<1 || mDim[1]<1 || count<1)
+		return vtkImageDataPtr();
+
+	Job job;
+	job.numComps = mBrickedInput ? mBrickedInput->getNumberOfScalarComponents() : mInput->GetNumberOfScalarComponents();
+	job.linear = mLinear;
+	job.background = mBackground;
+
+	// continuous voxel index from slice space
+	Vector3D corner(0, 0, 0);
+	Vector3D inSpacing;
+	if (mBrickedInput)
+	{
+		inSpacing = mBrickedInput->getSpacing().matrix();
+	}
+	else
+	{
+		int extent[6];
+		mInput->GetExtent(extent);
+		inSpacing = Vector3D(mInput->GetSpacing());
+		corner = Vector3D(mInput->GetOrigin()) + multiply_elems(Vector3D(extent[0], extent[2], extent[4]), inSpacing);
+	}
+	Transform3D vMi = createTransformScale(divide_elems(Vector3D(1,1,1), inSpacing))
+			* createTransformTranslate(-corner);
+	Transform3D vMs = vMi * iMs;
+	job.start = vMs.coord(mOrigin);
+	job.dx = vMs.vector(Vector3D(mSpacing[0], 0, 0));
+	job.dy = vMs.vector(Vector3D(0, mSpacing[1], 0));
+	job.dz = vMs.vector(Vector3D(0, 0, distance));
+	job.outDim[0] = mDim[0];
+	job.outDim[1] = mDim[1];
+	job.count = count;
+	job.mip = mip;
+
+	job.colors = NULL;
+	job.luminance = NULL;
+	job.tableSize = 0;
+	job.tableOffset = 0;
+	job.tableScale = 1;
+	job.outComps = job.numComps;
+	int inType = mBrickedInput ? mBrickedInput->getScalarType() : mInput->GetScalarType();
+	int outType = inType;
+	if (this->updateColorTable())
+	{
+		double range[2] = { mTableRange[0], mTableRange[1] };
+		if (mUseWindowLevel)
+		{
+			range[0] = mLevel - mWindow/2;
+			range[1] = mLevel + mWindow/2;
+		}
+		job.colors = &mColors[0];
+		job.luminance = &mLuminance[0];
+		job.tableSize = int(mColors.size()/4);
+		job.tableOffset = range[0];
+		job.tableScale = (range[1]>range[0]) ? job.tableSize/(range[1]-range[0]) : 0;
+		job.outComps = (job.numComps<=3) ? 4 : job.numComps;
+		outType = VTK_UNSIGNED_CHAR;
+	}
+
+	vtkImageDataPtr output = this->getOutputBuffer(mip ? 1 : count, outType, job.outComps);
+	output->SetOrigin(mOrigin.data());
+	output->SetSpacing(mSpacing[0], mSpacing[1], (distance!=0) ? distance : 1);
+	job.output = output->GetScalarPointer();
+	job.outRowStride = vtkIdType(mDim[0])*job.outComps;
+	job.outSliceStride = job.outRowStride*mDim[1];
+
+	if (mBrickedInput)
+	{
+		switch (inType)
+		{
+			vtkTemplateAliasMacro(executeBrickedTyped<VTK_TT>(job, mBrickedInput, output->GetScalarSize()));
+		default:
+			return vtkImageDataPtr();
+		}
+	}
+	else
+	{
+		setJobInput(&job, mInput);
+		switch (inType)
+		{
+			vtkTemplateAliasMacro(executeTyped<VTK_TT>(job));
+		default:
+			return vtkImageDataPtr();
+		}
+	}
+
+	output->Modified();
+	output->GetPointData()->GetScalars()->Modified();
+	return output;
+}
+
+} // namespace cx
@@ -0,0 +1,108 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXOBLIQUESLICER_H
+#define CXOBLIQUESLICER_H
+
+#include "cxResourceExport.h"
+#include "cxPrecompiledHeader.h"
+
+#include <vector>
+#include "vtkForwardDeclarations.h"
+#include "cxTransform3D.h"
+#include "cxBrickedVolume.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ObliqueSlicer> ObliqueSlicerPtr;
+typedef boost::shared_ptr<class Image> ImagePtr;
+
+/** \brief Reusable CPU slicing engine for 2D slices through a volume.
+ *
+ * Replaces a vtkImageReslice + vtkImageMapToColors pipeline for code
+ * that extracts many slices. Sampling, lut and window/level are done
+ * in one pass over the output, and the rows are processed in parallel.
+ *
+ * The slice is defined as in vtkImageReslice: iMs is the ResliceAxes,
+ * mapping from slice space to the physical space of the input, and the
+ * output format gives origin, dimension and spacing in slice space.
+ * Points outside the input, allowing a half voxel border, get
+ * the background level.
+ *
+ * With a lut or a window set, the output is RGBA unsigned char, mapped
+ * as vtkImageMapToColors. Color input is mapped per component as
+ * ApplyLUTToImage2DProxy does. Without, the output has the scalar type
+ * of the input.
+ *
+ * The output buffer is kept and reused by the next call with the same
+ * format, thus the returned image is only valid until then.
+ *
+ * With a BrickedVolume as input, the output is computed in tiles, and
+ * only the voxels around each tile are read, thus slicing a volume
+ * kept on disk does not load it.
+ *
+ * \ingroup cx_resource_core_algorithms
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT ObliqueSlicer
+{
+public:
+	ObliqueSlicer();
+	~ObliqueSlicer();
+
+	void setInput(vtkImageDataPtr input);
+	void setInput(BrickedVolumePtr input); ///< read the input through the bricks
+	void setInput(ImagePtr image); ///< through the bricks if image is out of core, without loading it
+	void setLinearInterpolation(bool on); ///< default on, off gives nearest neighbour
+	void setBackgroundLevel(double value);
+	void setLookupTable(vtkLookupTablePtr lut); ///< map output through lut. Zero gives output in the input scalar type
+	void setWindowLevel(double window, double level); ///< override the table range of the lut, use a gray ramp if there is no lut
+	void clearWindowLevel();
+	void setOutputFormat(Vector3D origin, Eigen::Array3i dim, Vector3D spacing); ///< dim[2] is ignored
+
+	vtkImageDataPtr slice(const Transform3D& iMs); ///< one slice, in the plane z=0 of slice space
+	/** count parallel slices at z=0, distance, 2*distance, ... in slice space,
+	 *  computed in one pass. Returned as a volume with count slices.
+	 */
+	vtkImageDataPtr slices(const Transform3D& iMs, int count, double distance);
+	/** Maximum intensity projection of count parallel slices centered on z=0
+	 *  with the given distance, i.e. a thick slice.
+	 */
+	vtkImageDataPtr slab(const Transform3D& iMs, int count, double distance);
+
+private:
+	vtkImageDataPtr execute(const Transform3D& iMs, int count, double distance, bool mip);
+	bool updateColorTable();
+	vtkImageDataPtr getOutputBuffer(int count, int scalarType, int numComps);
+
+	vtkImageDataPtr mInput;
+	BrickedVolumePtr mBrickedInput;
+	bool mLinear;
+	double mBackground;
+	vtkLookupTablePtr mLut;
+	bool mUseWindowLevel;
+	double mWindow;
+	double mLevel;
+
+	Vector3D mOrigin;
+	Eigen::Array3i mDim;
+	Vector3D mSpacing;
+
+	vtkImageDataPtr mOutput; ///< persistent output buffer
+	std::vector<unsigned char> mColors; ///< rgba table built from the lut
+	std::vector<unsigned char> mLuminance; ///< luminance of mColors, for color input
+	double mTableRange[2];
+	vtkMTimeType mTableModified;
+};
+
+} // namespace cx
+
+#endif // CXOBLIQUESLICER_H
@@ -118,10 +118,15 @@ void StateService::fillDefaultSettings()
 
 	this->fillDefault("optimizedViews", true);
 	this->fillDefault("smartRender", true);
+	this->fillDefault("OutOfCore/memoryBudget", 1024.0); // MB
+	this->fillDefault("OutOfCore/loadThreshold", 2048.0); // MB, larger images are loaded out of core. 0 is off
+	this->fillDefault("Mesh/binaryPatientFiles", false); // save patient meshes as .cxmesh instead of .vtk
+	this->fillDefault("Mesh/removeOtherFormatFiles", false); // when saving, delete the patient mesh file in the format not chosen above
 
 	this->fillDefault("IGSTKDebugLogging", false);
 	this->fillDefault("giveManualToolPhysicalProperties", false);
 	this->fillDefault("renderSpeedLogging", false);
+	this->fillDefault("performanceTracing", false);
 
 	this->fillDefault("applyTransferFunctionPresetsToAll", false);
 
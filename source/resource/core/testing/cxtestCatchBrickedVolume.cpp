@@ -0,0 +1,278 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vector>
+#include <cstdlib>
+#include <QDir>
+#include <QFile>
+#include <vtkImageData.h>
+#include "cxBrickedVolume.h"
+#include "cxBrickCache.h"
+#include "cxImage.h"
+#include "cxImageStatistics.h"
+#include "cxObliqueSlicer.h"
+#include "cxDataLocations.h"
+
+namespace
+{
+const int dimX = 70;
+const int dimY = 67;
+const int dimZ = 65;
+
+int voxelValue(int x, int y, int z)
+{
+	return x + 1000*y + 1000000*z;
+}
+
+/** Write a MET_INT volume spanning several bricks along each axis.
+ */
+QString writeTestVolume()
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/BrickedVolume/";
+	QDir().mkpath(folder);
+
+	std::vector<int> voxels;
+	for (int z=0; z<dimZ; ++z)
+		for (int y=0; y<dimY; ++y)
+			for (int x=0; x<dimX; ++x)
+				voxels.push_back(voxelValue(x, y, z));
+	QFile raw(folder + "volume.raw");
+	raw.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	raw.write(reinterpret_cast<const char*>(&voxels[0]), voxels.size()*sizeof(int));
+	raw.close();
+
+	QFile header(folder + "volume.mhd");
+	header.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+	header.write(QString("ObjectType = Image\n"
+						 "NDims = 3\n"
+						 "BinaryData = True\n"
+						 "BinaryDataByteOrderMSB = False\n"
+						 "CompressedData = False\n"
+						 "ElementSpacing = 0.5 0.25 2\n"
+						 "DimSize = %1 %2 %3\n"
+						 "ElementType = MET_INT\n"
+						 "ElementDataFile = volume.raw\n").arg(dimX).arg(dimY).arg(dimZ).toLatin1());
+	header.close();
+	return folder + "volume.mhd";
+}
+
+/** Write a MET_SHORT volume with a small value range, for statistics.
+ */
+QString writeShortTestVolume()
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/BrickedVolume/";
+	QDir().mkpath(folder);
+
+	std::vector<short> voxels;
+	for (int z=0; z<dimZ; ++z)
+		for (int y=0; y<dimY; ++y)
+			for (int x=0; x<dimX; ++x)
+				voxels.push_back(short((x+y+z)%300 - 20));
+	QFile raw(folder + "short.raw");
+	raw.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	raw.write(reinterpret_cast<const char*>(&voxels[0]), voxels.size()*sizeof(short));
+	raw.close();
+
+	QFile header(folder + "short.mhd");
+	header.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+	header.write(QString("ObjectType = Image\n"
+						 "NDims = 3\n"
+						 "BinaryData = True\n"
+						 "BinaryDataByteOrderMSB = False\n"
+						 "CompressedData = False\n"
+						 "ElementSpacing = 1 1 1\n"
+						 "DimSize = %1 %2 %3\n"
+						 "ElementType = MET_SHORT\n"
+						 "ElementDataFile = short.raw\n").arg(dimX).arg(dimY).arg(dimZ).toLatin1());
+	header.close();
+	return folder + "short.mhd";
+}
+
+void checkEqual(const cx::ImageStatistics::Result& a, const cx::ImageStatistics::Result& b)
+{
+	REQUIRE(a.valid);
+	REQUIRE(b.valid);
+	CHECK(a.min == b.min);
+	CHECK(a.max == b.max);
+	CHECK(a.voxelCount == b.voxelCount);
+	CHECK(a.nonZeroCount == b.nonZeroCount);
+	CHECK(a.histogramOrigin == b.histogramOrigin);
+	CHECK(a.histogram == b.histogram);
+}
+
+int getValue(vtkImageDataPtr image, int x, int y, int z)
+{
+	return *static_cast<int*>(image->GetScalarPointer(x, y, z));
+}
+
+/** Check that region contains the voxels of the test volume.
+ */
+bool hasTestVoxels(vtkImageDataPtr region, int step)
+{
+	int* extent = region->GetExtent();
+	for (int z=extent[4]; z<=extent[5]; ++z)
+		for (int y=extent[2]; y<=extent[3]; ++y)
+			for (int x=extent[0]; x<=extent[1]; ++x)
+				if (getValue(region, x, y, z) != voxelValue(x*step, y*step, z*step))
+					return false;
+	return true;
+}
+}
+
+TEST_CASE("BrickedVolume: Read regions across bricks", "[unit][resource][core]")
+{
+	cx::BrickCachePtr cache(new cx::BrickCache(1)); // large regions are read directly from the file
+	cx::BrickedVolumePtr volume = cx::BrickedVolume::openMetaImage(writeTestVolume(), cache);
+	REQUIRE(volume);
+	CHECK(volume->getDimensions()[0] == dimX);
+	CHECK(volume->getDimensions()[2] == dimZ);
+	CHECK(volume->getSpacing()[1] == Approx(0.25));
+	CHECK(volume->getScalarType() == VTK_INT);
+	CHECK(volume->getBrickDimensions()[0] == 2);
+
+	vtkImageDataPtr region = volume->readRegion(cx::IntBoundingBox3D(60, 68, 62, 66, 63, 64));
+	REQUIRE(region);
+	CHECK(region->GetExtent()[0] == 60);
+	CHECK(region->GetExtent()[5] == 64);
+	CHECK(hasTestVoxels(region, 1));
+
+	// clamped to the volume
+	region = volume->readRegion(cx::IntBoundingBox3D(-5, 100, 10, 10, 0, 0));
+	REQUIRE(region);
+	CHECK(region->GetExtent()[0] == 0);
+	CHECK(region->GetExtent()[1] == dimX-1);
+	CHECK(hasTestVoxels(region, 1));
+	CHECK(!volume->readRegion(cx::IntBoundingBox3D(100, 110, 0, 1, 0, 1)));
+
+	// every third voxel
+	region = volume->readRegion(volume->getExtent(), 3);
+	REQUIRE(region);
+	CHECK(region->GetExtent()[1] == (dimX-1)/3);
+	CHECK(region->GetSpacing()[2] == Approx(6));
+	CHECK(hasTestVoxels(region, 3));
+
+	vtkImageDataPtr full = volume->materialize();
+	REQUIRE(full);
+	CHECK(hasTestVoxels(full, 1));
+
+	// the same region from memory
+	vtkImageDataPtr extracted = cx::BrickedVolume::extractRegion(full, cx::IntBoundingBox3D(60, 68, 62, 66, 63, 64));
+	REQUIRE(extracted);
+	CHECK(extracted->GetExtent()[2] == 62);
+	CHECK(hasTestVoxels(extracted, 1));
+}
+
+TEST_CASE("BrickedVolume: Cache stays within the memory budget", "[unit][resource][core]")
+{
+	cx::BrickCachePtr cache(new cx::BrickCache(1));
+	cx::BrickedVolumePtr volume = cx::BrickedVolume::openMetaImage(writeTestVolume(), cache);
+	REQUIRE(volume);
+
+	for (int z=0; z<dimZ; z+=8)
+		CHECK(volume->readRegion(cx::IntBoundingBox3D(0, dimX-1, 0, dimY-1, z, z)));
+	CHECK(cache->getStatistics().memory <= 1);
+	CHECK(cache->getStatistics().evictions > 0);
+
+	cache->clear();
+	cache->resetStatistics();
+	volume->readRegion(cx::IntBoundingBox3D(0, 3, 0, 3, 64, 64));
+	volume->readRegion(cx::IntBoundingBox3D(0, 3, 0, 3, 64, 64));
+	CHECK(cache->getStatistics().hits == 1);
+
+	volume.reset();
+	CHECK(cache->getStatistics().memory == 0);
+}
+
+TEST_CASE("BrickedVolume: Image materialises lazily", "[unit][resource][core]")
+{
+	cx::BrickCachePtr cache(new cx::BrickCache(64));
+	cx::ImagePtr image = cx::Image::create("bricked", "bricked");
+	image->setBrickedVolume(cx::BrickedVolume::openMetaImage(writeTestVolume(), cache));
+	REQUIRE(image->isOutOfCore());
+	CHECK(image->getDimensions()[1] == dimY);
+	CHECK(image->getScalarType() == VTK_INT);
+	CHECK(image->boundingBox()[5] == Approx((dimZ-1)*2.0));
+
+	vtkImageDataPtr region = image->getRegion(cx::IntBoundingBox3D(1, 2, 3, 4, 5, 6));
+	REQUIRE(region);
+	CHECK(hasTestVoxels(region, 1));
+	CHECK(image->isOutOfCore());
+
+	vtkImageDataPtr full = image->getBaseVtkImageData();
+	REQUIRE(full);
+	CHECK(!image->isOutOfCore());
+	CHECK(hasTestVoxels(full, 1));
+	CHECK(hasTestVoxels(image->getRegion(cx::IntBoundingBox3D(1, 2, 3, 4, 5, 6)), 1));
+}
+
+TEST_CASE("BrickedVolume: ObliqueSlicer gives the same slice from bricks", "[unit][resource][core]")
+{
+	cx::BrickCachePtr cache(new cx::BrickCache(64));
+	cx::BrickedVolumePtr volume = cx::BrickedVolume::openMetaImage(writeTestVolume(), cache);
+	REQUIRE(volume);
+
+	cx::Transform3D iMs = cx::createTransformTranslate(cx::Vector3D(17.3, 8.1, 60.2))
+			* cx::createTransformRotateX(0.3) * cx::createTransformRotateZ(0.7);
+	Eigen::Array3i dim(300, 200, 1);
+
+	cx::ObliqueSlicer inMemory;
+	inMemory.setInput(volume->materialize());
+	inMemory.setOutputFormat(cx::Vector3D(-30, -20, 0), dim, cx::Vector3D(0.2, 0.2, 1));
+	inMemory.setBackgroundLevel(-1);
+	vtkImageDataPtr expected = inMemory.slab(iMs, 3, 1.5);
+
+	cx::ObliqueSlicer bricked;
+	bricked.setInput(volume);
+	bricked.setOutputFormat(cx::Vector3D(-30, -20, 0), dim, cx::Vector3D(0.2, 0.2, 1));
+	bricked.setBackgroundLevel(-1);
+	vtkImageDataPtr result = bricked.slab(iMs, 3, 1.5);
+
+	REQUIRE(expected);
+	REQUIRE(result);
+	int differences = 0;
+	int background = 0;
+	for (int y=0; y<dim[1]; ++y)
+		for (int x=0; x<dim[0]; ++x)
+		{
+			int value = getValue(result, x, y, 0);
+			differences += (std::abs(value - getValue(expected, x, y, 0)) > 1) ? 1 : 0;
+			background += (value == -1) ? 1 : 0;
+		}
+	CHECK(differences == 0);
+	CHECK(background > 0);
+	CHECK(background < dim[0]*dim[1]);
+}
+
+TEST_CASE("BrickedVolume: Exact statistics without loading the volume", "[unit][resource][core]")
+{
+	cx::BrickCachePtr cache(new cx::BrickCache(64));
+	cx::BrickedVolumePtr volume = cx::BrickedVolume::openMetaImage(writeShortTestVolume(), cache);
+	REQUIRE(volume);
+	cx::ImageStatistics::Result expected = cx::ImageStatistics::compute(volume->materialize());
+
+	// statistics of two halves merged
+	cx::ImageStatistics::Result lower = cx::ImageStatistics::compute(volume->readRegion(cx::IntBoundingBox3D(0, dimX-1, 0, dimY-1, 0, 20)));
+	cx::ImageStatistics::Result upper = cx::ImageStatistics::compute(volume->readRegion(cx::IntBoundingBox3D(0, dimX-1, 0, dimY-1, 21, dimZ-1)));
+	checkEqual(cx::ImageStatistics::merge(lower, upper), expected);
+
+	cx::ImagePtr image = cx::Image::create("bricked_statistics", "bricked_statistics");
+	image->setBrickedVolume(volume);
+	REQUIRE(image->isOutOfCore());
+	CHECK(image->getStatistics().voxelCount == expected.voxelCount);
+
+	checkEqual(image->getExactStatistics(), expected);
+	CHECK(image->getExactStatistics().exact);
+	CHECK(image->getExactStatistics().getCount(0) == 0);
+	CHECK(image->getExactStatistics().getCount(5) == expected.getCount(5));
+	CHECK(image->isOutOfCore());
+}
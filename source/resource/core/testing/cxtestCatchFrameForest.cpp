@@ -0,0 +1,125 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <set>
+#include <QStringList>
+
+#include "cxFrameForest.h"
+#include "cxMesh.h"
+#include "cxRegistrationTransform.h"
+
+namespace
+{
+cx::DataPtr createData(std::map<QString, cx::DataPtr>& source, QString frame, QString parentFrame)
+{
+	cx::MeshPtr mesh = cx::Mesh::create(frame);
+	mesh->get_rMd_History()->setParentSpace(parentFrame);
+	source[mesh->getUid()] = mesh;
+	return mesh;
+}
+
+std::set<QString> toSet(const std::vector<QString>& frames)
+{
+	return std::set<QString>(frames.begin(), frames.end());
+}
+
+std::set<QString> toSet(const QStringList& frames)
+{
+	return std::set<QString>(frames.begin(), frames.end());
+}
+}
+
+TEST_CASE("FrameForest answers ancestor and descendant queries", "[unit][resource][core]")
+{
+	//  A -> MR1 -> S1, S2
+	//    -> CT1
+	//  MR2
+	std::map<QString, cx::DataPtr> source;
+	createData(source, "MR1", "A");
+	createData(source, "S1", "MR1");
+	createData(source, "S2", "MR1");
+	createData(source, "CT1", "A");
+	createData(source, "MR2", "");
+
+	cx::FrameForest forest(source);
+
+	CHECK(forest.hasFrame("A"));
+	CHECK(!forest.hasFrame("B"));
+	CHECK(forest.getParent("S1") == "MR1");
+	CHECK(forest.getParent("A") == "");
+	CHECK(toSet(forest.getChildren("")) == toSet(QStringList() << "A" << "MR2"));
+
+	CHECK(forest.isAncestorOf("S1", "A"));
+	CHECK(forest.isAncestorOf("S1", "S1"));
+	CHECK(!forest.isAncestorOf("A", "S1"));
+	CHECK(!forest.isAncestorOf("CT1", "MR1"));
+
+	CHECK(forest.getOldestAncestor("S2") == "A");
+	CHECK(forest.getOldestAncestor("MR2") == "MR2");
+	CHECK(forest.getOldestAncestorNotCommonToRef("S1", "CT1") == "MR1");
+	CHECK(forest.getOldestAncestorNotCommonToRef("S1", "MR2") == "A");
+	CHECK(forest.getOldestAncestorNotCommonToRef("MR1", "S1") == "");
+
+	CHECK(toSet(forest.getDescendantsAndSelf("MR1")) == toSet(QStringList() << "MR1" << "S1" << "S2"));
+	CHECK(forest.getDataFromDescendantsAndSelf("A").size() == 4);
+	CHECK(forest.getDataFromDescendantsAndSelf("MR2").size() == 1);
+}
+
+TEST_CASE("FrameForest follows changes in parent space", "[unit][resource][core]")
+{
+	std::map<QString, cx::DataPtr> source;
+	cx::DataPtr mr1 = createData(source, "MR1", "A");
+	createData(source, "S1", "MR1");
+	cx::DataPtr mr2 = createData(source, "MR2", "");
+
+	cx::FrameForest forest(source);
+	CHECK(forest.getOldestAncestor("S1") == "A");
+
+	// registration moves the MR1 tree below MR2, pure space A is no longer used
+	mr1->get_rMd_History()->setParentSpace("MR2");
+	CHECK(forest.getOldestAncestor("S1") == "MR2");
+	CHECK(forest.isAncestorOf("S1", "MR2"));
+	CHECK(!forest.hasFrame("A"));
+	CHECK(forest.getDataFromDescendantsAndSelf("MR2").size() == 3);
+
+	// new data are inserted, removed data rebuild the forest
+	createData(source, "CT1", "MR2");
+	forest.setSource(source);
+	CHECK(forest.getParent("CT1") == "MR2");
+	CHECK(forest.getDataFromDescendantsAndSelf("MR2").size() == 4);
+
+	source.erase("MR1");
+	forest.setSource(source);
+	CHECK(forest.getParent("S1") == "MR1");
+	CHECK(forest.getOldestAncestor("S1") == "MR1");
+	CHECK(forest.getDataFromDescendantsAndSelf("MR2").size() == 2);
+}
+
+TEST_CASE("FrameForest does not keep removed data alive", "[unit][resource][core]")
+{
+	std::map<QString, cx::DataPtr> source;
+	createData(source, "MR1", "A");
+	createData(source, "CT1", "A");
+
+	cx::FrameForest forest(source);
+	CHECK(forest.getDataFromDescendantsAndSelf("A").size() == 2);
+
+	boost::weak_ptr<cx::Data> removed = source["CT1"];
+	source.erase("CT1");
+	CHECK(removed.expired());
+	CHECK(forest.getDataFromDescendantsAndSelf("A").size() == 1);
+
+	forest.setSource(source);
+	CHECK(!forest.hasFrame("CT1"));
+	CHECK(forest.getDataFromDescendantsAndSelf("A").size() == 1);
+}
@@ -0,0 +1,106 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <vtkImageData.h>
+#include "cxImageBrickGrid.h"
+
+namespace
+{
+/** Zero volume with a ball of value 100, radius r centered at c.
+ */
+vtkImageDataPtr createBallVolume(int dim, double r, const cx::Vector3D& c)
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(dim, dim, dim);
+	image->SetSpacing(0.5, 0.5, 0.5);
+	image->SetOrigin(10, 20, 30);
+	image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (int z=0; z<dim; ++z)
+		for (int y=0; y<dim; ++y)
+			for (int x=0; x<dim; ++x)
+				*ptr++ = ((cx::Vector3D(x, y, z) - c).norm() <= r) ? 100 : 0;
+	return image;
+}
+
+cx::ImageBrickGrid::Intervals above(double value)
+{
+	return cx::ImageBrickGrid::Intervals(1, std::make_pair(value, 1000.0));
+}
+}
+
+TEST_CASE("ImageBrickGrid: Bricks bound the voxels", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(17, 9, 1);
+	image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (int y=0; y<9; ++y)
+		for (int x=0; x<17; ++x)
+			*ptr++ = x + 100*y;
+
+	cx::ImageBrickGrid grid(image);
+	CHECK(grid.getBrickDimensions()[0] == 2);
+	CHECK(grid.getBrickDimensions()[1] == 1);
+	CHECK(grid.getBrickDimensions()[2] == 1);
+
+	// the boundary voxels are shared
+	std::pair<double,double> range = grid.getBrickRange(0, 0, 0);
+	CHECK(range.first <= 0);
+	CHECK(range.second >= 808);
+	CHECK(range.second < 809);
+	range = grid.getBrickRange(1, 0, 0);
+	CHECK(range.first <= 8);
+	CHECK(range.first > 7);
+	CHECK(range.second >= 816);
+}
+
+TEST_CASE("ImageBrickGrid: Ray hits the ball surface", "[unit][resource][core]")
+{
+	cx::Vector3D center(20, 24, 22);
+	vtkImageDataPtr image = createBallVolume(48, 6, center);
+	cx::ImageBrickGrid grid(image);
+
+	// along x through the center, starting outside the volume
+	cx::Vector3D center_w = cx::Vector3D(10, 20, 30) + 0.5*center;
+	cx::Vector3D origin = center_w - cx::Vector3D(20, 0, 0);
+	double t = -1;
+	REQUIRE(grid.intersect(origin, cx::Vector3D(1, 0, 0), 0, 100, above(50), &t));
+	// the interpolated value crosses 50 half a voxel outside the last voxel in the ball
+	CHECK(fabs(t - (20 - 0.5*6.5)) <= 0.05);
+
+	// oblique ray from the other side
+	cx::Vector3D d = cx::Vector3D(-1, -1, 1).normalized();
+	REQUIRE(grid.intersect(center_w - 30*d, d, 0, 100, above(50), &t));
+	CHECK(fabs(t - (30 - 3.25)) <= 0.3);
+}
+
+TEST_CASE("ImageBrickGrid: Misses", "[unit][resource][core]")
+{
+	cx::Vector3D center(20, 24, 22);
+	vtkImageDataPtr image = createBallVolume(48, 6, center);
+	cx::ImageBrickGrid grid(image);
+	cx::Vector3D center_w = cx::Vector3D(10, 20, 30) + 0.5*center;
+	cx::Vector3D origin = center_w - cx::Vector3D(20, 0, 0);
+	double t = -1;
+
+	// interval outside the values, ray beside the ball, ray stopped before the ball
+	CHECK_FALSE(grid.intersect(origin, cx::Vector3D(1, 0, 0), 0, 100, above(200), &t));
+	CHECK_FALSE(grid.intersect(origin + cx::Vector3D(0, 5, 0), cx::Vector3D(1, 0, 0), 0, 100, above(50), &t));
+	CHECK_FALSE(grid.intersect(origin, cx::Vector3D(1, 0, 0), 0, 15, above(50), &t));
+
+	// a hit at the start of the ray
+	REQUIRE(grid.intersect(center_w, cx::Vector3D(1, 0, 0), 0, 100, above(50), &t));
+	CHECK(t == Approx(0));
+}
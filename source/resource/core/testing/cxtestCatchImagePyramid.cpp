@@ -0,0 +1,105 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxImagePyramid.h"
+
+namespace
+{
+vtkImageDataPtr createRampVolume(int dimX, int dimY, int dimZ)
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(dimX, dimY, dimZ);
+	image->SetSpacing(0.5, 0.5, 1.0);
+	image->SetOrigin(10, 20, 30);
+	image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (int z=0; z<dimZ; ++z)
+		for (int y=0; y<dimY; ++y)
+			for (int x=0; x<dimX; ++x)
+				*ptr++ = x + 10*y + 100*z;
+	return image;
+}
+
+bool equalVoxels(vtkImageDataPtr a, vtkImageDataPtr b)
+{
+	if (a->GetNumberOfPoints() != b->GetNumberOfPoints())
+		return false;
+	unsigned short* pa = static_cast<unsigned short*>(a->GetScalarPointer());
+	unsigned short* pb = static_cast<unsigned short*>(b->GetScalarPointer());
+	return std::equal(pa, pa+a->GetNumberOfPoints(), pb);
+}
+}
+
+TEST_CASE("ImagePyramid: Downsample halves the size and keeps the region", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	vtkImageDataPtr half = cx::ImagePyramid::downsample(image);
+
+	int dim[3];
+	half->GetDimensions(dim);
+	CHECK(dim[0] == 4);
+	CHECK(dim[1] == 3);
+	CHECK(dim[2] == 3);
+	CHECK(half->GetSpacing()[0] == Approx(1.0));
+	CHECK(half->GetSpacing()[2] == Approx(2.0));
+	CHECK(half->GetOrigin()[0] == Approx(10.25));
+	CHECK(half->GetOrigin()[2] == Approx(30.5));
+
+	// mean of x in {2,3}, y in {0,1}, z in {0,1}: 2.5 + 10*0.5 + 100*0.5
+	unsigned short* ptr = static_cast<unsigned short*>(half->GetScalarPointer(1, 0, 0));
+	CHECK(*ptr == 58);
+}
+
+TEST_CASE("ImagePyramid: Levels are built in the background and follow the image", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(64, 64, 32);
+	cx::ImagePyramid pyramid;
+
+	CHECK(pyramid.getLevel(image, 0) == image);
+	pyramid.waitForLevels(image);
+	for (int level=1; level<=cx::ImagePyramid::maxLevel; ++level)
+	{
+		vtkImageDataPtr current = pyramid.getLevel(image, level);
+		REQUIRE(current);
+		CHECK(current->GetDimensions()[0] == 64>>level);
+	}
+
+	image->Modified();
+	CHECK_FALSE(pyramid.getLevel(image, 1));
+	pyramid.waitForLevels(image);
+	CHECK(pyramid.getLevel(image, 1));
+}
+
+TEST_CASE("ImagePyramid: Region update gives the same result as a rebuild", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(40, 30, 20);
+	cx::ImagePyramid pyramid;
+	pyramid.waitForLevels(image);
+
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (int z=5; z<=9; ++z)
+		for (int y=7; y<=12; ++y)
+			for (int x=3; x<=20; ++x)
+				ptr[x + 40*y + 40*30*z] = 4000;
+	image->Modified();
+	pyramid.updateRegion(image, cx::IntBoundingBox3D(3, 20, 7, 12, 5, 9));
+
+	std::vector<vtkImageDataPtr> rebuilt = cx::ImagePyramid::build(image);
+	for (int level=1; level<=cx::ImagePyramid::maxLevel; ++level)
+	{
+		vtkImageDataPtr updated = pyramid.getLevel(image, level);
+		REQUIRE(updated);
+		CHECK(equalVoxels(updated, rebuilt[level-1]));
+	}
+}
@@ -0,0 +1,150 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <vtkImageData.h>
+#include "cxImageStatistics.h"
+
+namespace
+{
+/** Short volume with a ramp of values in [offset, offset+period>
+ *  and every 7th voxel set to zero.
+ */
+vtkImageDataPtr createShortVolume(int dimX, int dimY, int dimZ, int offset, int period)
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(dimX, dimY, dimZ);
+	image->AllocateScalars(VTK_SHORT, 1);
+	short* ptr = static_cast<short*>(image->GetScalarPointer());
+	vtkIdType voxels = image->GetNumberOfPoints();
+	for (vtkIdType i=0; i<voxels; ++i)
+		ptr[i] = (i%7==0) ? 0 : short(offset + i%period);
+	return image;
+}
+}
+
+TEST_CASE("ImageStatistics: Exact statistics match a brute force count", "[unit][resource][core]")
+{
+	int offset = -100;
+	int period = 300;
+	vtkImageDataPtr image = createShortVolume(64, 64, 64, offset, period);
+	short* ptr = static_cast<short*>(image->GetScalarPointer());
+	vtkIdType voxels = image->GetNumberOfPoints();
+
+	std::map<int, vtkIdType> counts;
+	vtkIdType nonZero = 0;
+	for (vtkIdType i=0; i<voxels; ++i)
+	{
+		++counts[ptr[i]];
+		if (ptr[i])
+			++nonZero;
+	}
+
+	cx::ImageStatistics statistics;
+	cx::ImageStatistics::Result result = statistics.getExact(image);
+	REQUIRE(result.valid);
+	CHECK(result.exact);
+	CHECK(result.min == offset);
+	CHECK(result.max == offset+period-1);
+	CHECK(result.voxelCount == voxels);
+	CHECK(result.nonZeroCount == nonZero);
+	CHECK(result.getCount(0) == 0); // zeros are not counted
+	CHECK(result.getCount(offset) == counts[offset]);
+	CHECK(result.getCount(offset+period/2) == counts[offset+period/2]);
+	CHECK(result.getCount(offset+period) == 0);
+	CHECK(fabs(result.getPercentile(0.5) - (offset+period/2)) <= 2);
+}
+
+TEST_CASE("ImageStatistics: Estimate is available before the exact result", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createShortVolume(128, 128, 128, 1, 1000);
+
+	cx::ImageStatistics statistics;
+	cx::ImageStatistics::Result estimate = statistics.get(image);
+	REQUIRE(estimate.valid);
+	// the range of the estimate is that of the samples
+	CHECK(estimate.min == 0);
+	CHECK(estimate.max <= 1000);
+	CHECK(estimate.max >= 900);
+	if (!estimate.exact)
+		CHECK(double(estimate.nonZeroCount)/estimate.voxelCount == Approx(6.0/7).epsilon(0.05));
+
+	cx::ImageStatistics::Result exact = statistics.getExact(image);
+	CHECK(exact.exact);
+	CHECK(exact.max == 1000);
+	CHECK(exact.voxelCount == image->GetNumberOfPoints());
+	CHECK(statistics.get(image).exact);
+}
+
+TEST_CASE("ImageStatistics: Modified image is recomputed", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createShortVolume(32, 32, 32, 1, 100);
+
+	cx::ImageStatistics statistics;
+	CHECK(statistics.getExact(image).max == 100);
+
+	static_cast<short*>(image->GetScalarPointer())[1] = 2000;
+	image->Modified();
+	CHECK(statistics.getExact(image).max == 2000);
+	CHECK(statistics.getExact(image).getCount(2000) == 1);
+}
+
+TEST_CASE("ImageStatistics: RGB max is the max mean of the components", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(10, 10, 1);
+	image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+	unsigned char* ptr = static_cast<unsigned char*>(image->GetScalarPointer());
+	memset(ptr, 10, 10*10*3);
+	ptr[30] = 250;
+	ptr[31] = 200;
+	ptr[32] = 150;
+
+	cx::ImageStatistics statistics;
+	cx::ImageStatistics::Result result = statistics.getExact(image);
+	CHECK(result.rgbMax == 200);
+	CHECK(result.max == 250);
+	CHECK(result.nonZeroCount == 100);
+}
+
+TEST_CASE("ImageStatistics: Wide value ranges use a bounded number of bins", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(100, 100, 10);
+	image->AllocateScalars(VTK_FLOAT, 1);
+	float* ptr = static_cast<float*>(image->GetScalarPointer());
+	vtkIdType voxels = image->GetNumberOfPoints();
+	for (vtkIdType i=0; i<voxels; ++i)
+		ptr[i] = float(i)*1000.0f - 2.0E7f;
+
+	cx::ImageStatistics statistics;
+	cx::ImageStatistics::Result result = statistics.getExact(image);
+	REQUIRE(result.valid);
+	CHECK(result.histogram.size() <= size_t(cx::ImageStatistics::maxHistogramBins));
+	CHECK(result.histogramBinWidth > 1);
+	CHECK(result.histogramOrigin <= result.min);
+	CHECK(result.histogramOrigin + int(result.histogram.size())*result.histogramBinWidth > result.max);
+
+	vtkIdType sum = 0;
+	for (unsigned i=0; i<result.histogram.size(); ++i)
+		sum += result.histogram[i];
+	CHECK(sum == result.nonZeroCount);
+	CHECK(result.nonZeroCount == voxels-1); // one voxel is zero
+	CHECK(result.getCount(int(ptr[0])) >= 1);
+	CHECK(fabs(result.getPercentile(0.5) - 3.0E7) <= 2*result.histogramBinWidth);
+
+	cx::ImageStatistics::Result merged = cx::ImageStatistics::merge(result, result);
+	CHECK(merged.histogramBinWidth == result.histogramBinWidth);
+	CHECK(merged.histogramOrigin == result.histogramOrigin);
+	CHECK(merged.getMaxCount() == 2*result.getMaxCount());
+}
@@ -0,0 +1,187 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <QElapsedTimer>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include "cxMeshBVH.h"
+#include "cxLogger.h"
+
+namespace
+{
+/** Bumpy height field z=f(x,y) on [0,n]^2 as n*n*2 triangles.
+ */
+vtkPolyDataPtr createHeightField(int n)
+{
+	vtkPointsPtr points = vtkPointsPtr::New();
+	for (int y=0; y<=n; ++y)
+		for (int x=0; x<=n; ++x)
+			points->InsertNextPoint(x, y, std::sin(0.3*x)*std::cos(0.2*y));
+
+	vtkCellArrayPtr polys = vtkCellArrayPtr::New();
+	for (int y=0; y<n; ++y)
+		for (int x=0; x<n; ++x)
+		{
+			vtkIdType p = y*(n+1) + x;
+			vtkIdType lower[3] = { p, p+1, p+n+2 };
+			vtkIdType upper[3] = { p, p+n+2, p+n+1 };
+			polys->InsertNextCell(3, lower);
+			polys->InsertNextCell(3, upper);
+		}
+
+	vtkPolyDataPtr polyData = vtkPolyDataPtr::New();
+	polyData->SetPoints(points);
+	polyData->SetPolys(polys);
+	return polyData;
+}
+
+/** Reference: test every triangle.
+ */
+double bruteForceIntersect(vtkPolyDataPtr polyData, const cx::Vector3D& o, const cx::Vector3D& d)
+{
+	double best = -1;
+	vtkIdListPtr ids = vtkIdListPtr::New();
+	vtkCellArray* polys = polyData->GetPolys();
+	for (polys->InitTraversal(); polys->GetNextCell(ids); )
+	{
+		cx::Vector3D v0(polyData->GetPoint(ids->GetId(0)));
+		cx::Vector3D e1 = cx::Vector3D(polyData->GetPoint(ids->GetId(1))) - v0;
+		cx::Vector3D e2 = cx::Vector3D(polyData->GetPoint(ids->GetId(2))) - v0;
+		cx::Vector3D p = d.cross(e2);
+		double det = e1.dot(p);
+		if (det==0)
+			continue;
+		cx::Vector3D s = o - v0;
+		double u = s.dot(p)/det;
+		cx::Vector3D q = s.cross(e1);
+		double v = d.dot(q)/det;
+		double t = e2.dot(q)/det;
+		if (u>=0 && v>=0 && u+v<=1 && t>=0 && (best<0 || t<best))
+			best = t;
+	}
+	return best;
+}
+}
+
+TEST_CASE("MeshBVH: Hit a quad", "[unit][resource][core]")
+{
+	vtkPointsPtr points = vtkPointsPtr::New();
+	points->InsertNextPoint(0, 0, 5);
+	points->InsertNextPoint(10, 0, 5);
+	points->InsertNextPoint(10, 10, 5);
+	points->InsertNextPoint(0, 10, 5);
+	vtkCellArrayPtr verts = vtkCellArrayPtr::New();
+	vtkIdType vertex[1] = { 0 };
+	verts->InsertNextCell(1, vertex);
+	vtkCellArrayPtr polys = vtkCellArrayPtr::New();
+	vtkIdType quad[4] = { 0, 1, 2, 3 };
+	polys->InsertNextCell(4, quad);
+
+	vtkPolyDataPtr polyData = vtkPolyDataPtr::New();
+	polyData->SetPoints(points);
+	polyData->SetVerts(verts);
+	polyData->SetPolys(polys);
+
+	cx::MeshBVH bvh(polyData);
+	CHECK(bvh.getNumberOfTriangles() == 2);
+
+	cx::MeshBVH::Hit hit = bvh.intersect(cx::Vector3D(7, 2, 0), cx::Vector3D(0, 0, 2), 0, 100);
+	REQUIRE(hit.valid);
+	CHECK(hit.t == Approx(2.5));
+	CHECK(hit.cellId == 1); // the vertex is cell 0
+	CHECK(hit.position[2] == Approx(5));
+
+	// outside the quad, behind the origin and beyond tMax
+	CHECK_FALSE(bvh.intersect(cx::Vector3D(11, 2, 0), cx::Vector3D(0, 0, 1), 0, 100).valid);
+	CHECK_FALSE(bvh.intersect(cx::Vector3D(7, 2, 10), cx::Vector3D(0, 0, 1), 0, 100).valid);
+	CHECK_FALSE(bvh.intersect(cx::Vector3D(7, 2, 0), cx::Vector3D(0, 0, 1), 0, 4).valid);
+}
+
+TEST_CASE("MeshBVH: Closest hit equals brute force", "[unit][resource][core]")
+{
+	vtkPolyDataPtr polyData = createHeightField(40);
+	cx::MeshBVH bvh(polyData);
+	CHECK(bvh.getNumberOfTriangles() == 40*40*2);
+	CHECK(bvh.getSourceMTime() == polyData->GetMTime());
+
+	bool equal = true;
+	int hits = 0;
+	for (int i=0; i<200; ++i)
+	{
+		// oblique rays from above, some passing the surface twice
+		cx::Vector3D o(1+0.19*i, 39-0.17*i, 3);
+		cx::Vector3D d(0.3*std::cos(0.1*i), 0.3*std::sin(0.1*i), -1);
+		double expected = bruteForceIntersect(polyData, o, d);
+		cx::MeshBVH::Hit hit = bvh.intersect(o, d, 0, 1000);
+		equal = equal && (hit.valid == (expected>=0));
+		if (hit.valid && expected>=0)
+		{
+			equal = equal && (std::fabs(hit.t-expected) < 1E-9);
+			++hits;
+		}
+	}
+	CHECK(equal);
+	CHECK(hits > 100);
+}
+
+TEST_CASE("MeshBVH: Many duplicate triangles", "[unit][resource][core]")
+{
+	// coinciding centroids cannot be split spatially, e.g. duplicated marching cubes faces
+	vtkPointsPtr points = vtkPointsPtr::New();
+	points->InsertNextPoint(0, 0, 5);
+	points->InsertNextPoint(10, 0, 5);
+	points->InsertNextPoint(0, 10, 5);
+	vtkCellArrayPtr polys = vtkCellArrayPtr::New();
+	vtkIdType triangle[3] = { 0, 1, 2 };
+	int count = 10*cx::MeshBVH::leafSize + 3;
+	for (int i=0; i<count; ++i)
+		polys->InsertNextCell(3, triangle);
+
+	vtkPolyDataPtr polyData = vtkPolyDataPtr::New();
+	polyData->SetPoints(points);
+	polyData->SetPolys(polys);
+
+	cx::MeshBVH bvh(polyData);
+	CHECK(bvh.getNumberOfTriangles() == count);
+	cx::MeshBVH::Hit hit = bvh.intersect(cx::Vector3D(2, 2, 0), cx::Vector3D(0, 0, 1), 0, 100);
+	REQUIRE(hit.valid);
+	CHECK(hit.t == Approx(5));
+	CHECK(hit.cellId >= 0);
+	CHECK(hit.cellId < count);
+}
+
+TEST_CASE("Speed: MeshBVH rays per second", "[speed][resource][core]")
+{
+	vtkPolyDataPtr polyData = createHeightField(700);
+
+	QElapsedTimer timer;
+	timer.start();
+	cx::MeshBVH bvh(polyData);
+	int buildTime = timer.restart();
+
+	int count = 100000;
+	int hits = 0;
+	for (int i=0; i<count; ++i)
+	{
+		cx::Vector3D o(700.0*(i%317)/317, 700.0*(i%293)/293, 5);
+		hits += bvh.intersect(o, cx::Vector3D(0.1, 0.2, -1), 0, 100).valid;
+	}
+	double rate = count * 1000.0 / std::max<qint64>(1, timer.elapsed());
+
+	CHECK(hits > 0);
+	CX_LOG_INFO() << QString("MeshBVH %1 triangles: build %2 ms, %3 rays/s")
+					 .arg(bvh.getNumberOfTriangles()).arg(buildTime).arg(rate, 0, 'f', 0);
+}
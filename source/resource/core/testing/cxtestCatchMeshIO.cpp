@@ -0,0 +1,194 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkUnsignedCharArray.h>
+#include "cxMeshIO.h"
+#include "cxMeshHelpers.h"
+#include "cxMesh.h"
+#include "cxDataLocations.h"
+
+namespace
+{
+QString getTestFolder()
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/MeshIO/";
+	QDir().mkpath(folder);
+	return folder;
+}
+
+/** A grid of quads with point normals, point scalars and cell colors.
+ */
+vtkPolyDataPtr createTestPolyData()
+{
+	const int n = 20;
+	vtkPointsPtr points = vtkPointsPtr::New();
+	vtkFloatArrayPtr normals = vtkFloatArrayPtr::New();
+	normals->SetName("Normals");
+	normals->SetNumberOfComponents(3);
+	vtkFloatArrayPtr scalars = vtkFloatArrayPtr::New();
+	scalars->SetName("Distance");
+	for (int y=0; y<n; ++y)
+	{
+		for (int x=0; x<n; ++x)
+		{
+			points->InsertNextPoint(x, y, 0.1*x*y);
+			normals->InsertNextTuple3(0, 0, 1);
+			scalars->InsertNextValue(x+y);
+		}
+	}
+
+	vtkCellArrayPtr polys = vtkCellArrayPtr::New();
+	vtkUnsignedCharArrayPtr colors = vtkUnsignedCharArrayPtr::New();
+	colors->SetName("Colors");
+	colors->SetNumberOfComponents(3);
+	for (int y=0; y<n-1; ++y)
+	{
+		for (int x=0; x<n-1; ++x)
+		{
+			vtkIdType quad[4] = { y*n+x, y*n+x+1, (y+1)*n+x+1, (y+1)*n+x };
+			polys->InsertNextCell(4, quad);
+			colors->InsertNextTuple3(x, y, 255);
+		}
+	}
+
+	vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+	retval->SetPoints(points);
+	retval->SetPolys(polys);
+	retval->GetPointData()->SetNormals(normals);
+	retval->GetPointData()->AddArray(scalars);
+	retval->GetCellData()->SetScalars(colors);
+	return retval;
+}
+
+void checkTuplesEqual(vtkDataArray* a, vtkDataArray* b)
+{
+	REQUIRE(a);
+	REQUIRE(b);
+	REQUIRE(a->GetNumberOfTuples() == b->GetNumberOfTuples());
+	REQUIRE(a->GetNumberOfComponents() == b->GetNumberOfComponents());
+	CHECK(a->GetDataType() == b->GetDataType());
+	for (vtkIdType i=0; i<a->GetNumberOfTuples(); ++i)
+		for (int c=0; c<a->GetNumberOfComponents(); ++c)
+			CHECK(a->GetComponent(i, c) == Approx(b->GetComponent(i, c)));
+}
+
+cx::Transform3D createTestTransform()
+{
+	return cx::createTransformTranslate(cx::Vector3D(10, -5, 2)) * cx::createTransformRotateZ(M_PI/3);
+}
+} // namespace
+
+TEST_CASE("MeshIO: Write and read mesh", "[unit][resource][core]")
+{
+	vtkPolyDataPtr input = createTestPolyData();
+	QString filename = getTestFolder() + "mesh." + cx::MeshIO::getFileEnding();
+	REQUIRE(cx::MeshIO::write(filename, input));
+
+	vtkPolyDataPtr output = cx::MeshIO::read(filename);
+	REQUIRE(output);
+	CHECK(output->GetNumberOfPolys() == input->GetNumberOfPolys());
+	checkTuplesEqual(output->GetPoints()->GetData(), input->GetPoints()->GetData());
+	checkTuplesEqual(output->GetPolys()->GetData(), input->GetPolys()->GetData());
+	checkTuplesEqual(output->GetPointData()->GetNormals(), input->GetPointData()->GetNormals());
+	checkTuplesEqual(output->GetPointData()->GetArray("Distance"), input->GetPointData()->GetArray("Distance"));
+	checkTuplesEqual(output->GetCellData()->GetScalars(), input->GetCellData()->GetScalars());
+	CHECK(QString(output->GetCellData()->GetScalars()->GetName()) == "Colors");
+
+	QFile(filename).remove();
+	CHECK(!cx::MeshIO::read(filename));
+}
+
+TEST_CASE("MeshIO: Transform while writing equals transformed copy", "[unit][resource][core]")
+{
+	vtkPolyDataPtr input = createTestPolyData();
+	cx::Transform3D transform = createTestTransform();
+	QString filename = getTestFolder() + "transformed." + cx::MeshIO::getFileEnding();
+	REQUIRE(cx::MeshIO::write(filename, input, transform));
+
+	vtkPolyDataPtr output = cx::MeshIO::read(filename);
+	vtkPolyDataPtr expected = cx::createTransformedPolyData(input, transform);
+	REQUIRE(output);
+	checkTuplesEqual(output->GetPoints()->GetData(), expected->GetPoints()->GetData());
+	checkTuplesEqual(output->GetPointData()->GetNormals(), expected->GetPointData()->GetNormals());
+	CHECK(cx::Vector3D(output->GetPoint(1)).isApprox(transform.coord(cx::Vector3D(input->GetPoint(1)))));
+	QFile(filename).remove();
+}
+
+TEST_CASE("MeshIO: Transformed polydata shares cells with the original", "[unit][resource][core]")
+{
+	vtkPolyDataPtr input = createTestPolyData();
+	cx::Transform3D transform = createTestTransform();
+	vtkPolyDataPtr output = cx::createTransformedPolyData(input, transform);
+
+	CHECK(output->GetPolys() == input->GetPolys());
+	CHECK(output->GetCellData()->GetScalars() == input->GetCellData()->GetScalars());
+	CHECK(output->GetPoints() != input->GetPoints());
+	cx::Vector3D normal(output->GetPointData()->GetNormals()->GetTuple3(0));
+	CHECK(normal.isApprox(transform.vector(cx::Vector3D(0, 0, 1))));
+	CHECK(cx::Vector3D(input->GetPoint(1)) == cx::Vector3D(1, 0, 0));
+}
+
+TEST_CASE("Mesh: Memory usage counts shared arrays once", "[unit][resource][core]")
+{
+	vtkPolyDataPtr poly = createTestPolyData();
+	cx::MeshPtr mesh = cx::Mesh::create("mesh");
+	mesh->setVtkPolyData(poly);
+
+	qint64 usage = mesh->getMemoryUsage();
+	CHECK(usage > 0);
+	CHECK(usage < 2*qint64(poly->GetActualMemorySize())*1024);
+}
+
+TEST_CASE("MeshIO: Reject truncated files and invalid cells", "[unit][resource][core]")
+{
+	vtkPolyDataPtr input = createTestPolyData();
+	QString filename = getTestFolder() + "invalid." + cx::MeshIO::getFileEnding();
+
+	REQUIRE(cx::MeshIO::write(filename, input));
+	QFile file(filename);
+	REQUIRE(file.resize(file.size()/2));
+	CHECK(!cx::MeshIO::read(filename));
+
+	vtkIdType outside[3] = { 0, 1, input->GetNumberOfPoints() };
+	input->GetPolys()->InsertNextCell(3, outside);
+	input->GetCellData()->GetScalars()->InsertNextTuple3(0, 0, 0);
+	REQUIRE(cx::MeshIO::write(filename, input));
+	CHECK(!cx::MeshIO::read(filename));
+	QFile(filename).remove();
+}
+
+TEST_CASE("Mesh: Detached polydata does not change polydata sharing its arrays", "[unit][resource][core]")
+{
+	vtkPolyDataPtr original = createTestPolyData();
+	vtkPolyDataPtr editable = cx::createTransformedPolyData(original, createTestTransform());
+	REQUIRE(editable->GetPolys() == original->GetPolys());
+
+	cx::detachSharedArrays(editable);
+	CHECK(editable->GetPolys() != original->GetPolys());
+	CHECK(editable->GetCellData()->GetScalars() != original->GetCellData()->GetScalars());
+	checkTuplesEqual(editable->GetPolys()->GetData(), original->GetPolys()->GetData());
+
+	editable->GetCellData()->GetScalars()->SetComponent(0, 0, 42);
+	editable->GetPolys()->GetData()->SetComponent(1, 0, 1);
+	CHECK(original->GetCellData()->GetScalars()->GetComponent(0, 0) == 0);
+	CHECK(original->GetPolys()->GetData()->GetComponent(1, 0) == 0);
+	CHECK(QString(editable->GetCellData()->GetScalars()->GetName()) == "Colors");
+}
@@ -0,0 +1,141 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <string.h>
+#include <QDir>
+#include <QFile>
+#include <vtkImageData.h>
+#include <vtkMetaImageReader.h>
+#include <vtkMetaImageWriter.h>
+#include "cxMetaImageIO.h"
+#include "cxCustomMetaImage.h"
+#include "cxDataLocations.h"
+#include "cxTypeConversions.h"
+
+namespace
+{
+QString getTestFolder()
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/MetaImageIO/";
+	QDir().mkpath(folder);
+	return folder;
+}
+
+/** An unsigned short volume larger than one compression chunk.
+ */
+vtkImageDataPtr createTestImage()
+{
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetDimensions(150, 130, 70);
+	retval->SetSpacing(0.5, 0.25, 2);
+	retval->SetOrigin(1, 2, 3);
+	retval->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+	unsigned short* data = static_cast<unsigned short*>(retval->GetScalarPointer());
+	for (vtkIdType i=0; i<retval->GetNumberOfPoints(); ++i)
+		data[i] = (i%97 < 50) ? 0 : (i*7)%4096; // partly compressible
+	return retval;
+}
+
+bool isEqual(vtkImageDataPtr a, vtkImageDataPtr b)
+{
+	if (!a || !b)
+		return false;
+	for (int i=0; i<3; ++i)
+	{
+		if (a->GetDimensions()[i] != b->GetDimensions()[i] || a->GetSpacing()[i] != Approx(b->GetSpacing()[i]))
+			return false;
+	}
+	if (a->GetScalarType() != b->GetScalarType() || a->GetNumberOfScalarComponents() != b->GetNumberOfScalarComponents())
+		return false;
+	qint64 size = qint64(a->GetNumberOfPoints())*a->GetNumberOfScalarComponents()*a->GetScalarSize();
+	return memcmp(a->GetScalarPointer(), b->GetScalarPointer(), size) == 0;
+}
+} // namespace
+
+TEST_CASE("MetaImageIO: Write and read uncompressed and compressed files", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createTestImage();
+	QString filename = getTestFolder() + "image.mhd";
+
+	REQUIRE(cx::MetaImageIO::write(filename, image));
+	vtkImageDataPtr result = cx::MetaImageIO::read(filename);
+	CHECK(isEqual(image, result));
+	CHECK(result->GetOrigin()[2] == Approx(3));
+
+	REQUIRE(cx::MetaImageIO::write(filename, image, true));
+	cx::MetaImageIO::Header header;
+	REQUIRE(cx::MetaImageIO::readHeader(filename, &header));
+	CHECK(header.compressed);
+	qint64 chunkSize = cx::MetaImageIO::defaultChunkSize;
+	CHECK(header.chunkSize == chunkSize);
+	CHECK(header.chunks.size() == 2);
+	CHECK(QFile(getTestFolder() + "image.zraw").size() == header.compressedSize);
+	CHECK(header.compressedSize < header.getSizeInBytes());
+	CHECK(isEqual(image, cx::MetaImageIO::read(filename)));
+
+	// keys added by CustomMetaImage do not disturb reading
+	cx::Transform3D rMd = cx::createTransformTranslate(cx::Vector3D(4, 5, 6));
+	cx::CustomMetaImagePtr custom = cx::CustomMetaImage::create(filename);
+	custom->setTransform(rMd);
+	custom->setKey("WindowLevel", "100");
+	CHECK(cx::similar(custom->readTransform(), rMd));
+	CHECK(custom->readKey("WindowLevel") == "100");
+	CHECK(isEqual(image, cx::MetaImageIO::read(filename)));
+}
+
+TEST_CASE("MetaImageIO: Files are compatible with vtkMetaImageReader/Writer", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createTestImage();
+
+	QString ours = getTestFolder() + "ours.mhd";
+	REQUIRE(cx::MetaImageIO::write(ours, image, true));
+	vtkMetaImageReaderPtr reader = vtkMetaImageReaderPtr::New();
+	reader->SetFileName(cstring_cast(ours));
+	reader->Update();
+	CHECK(isEqual(image, reader->GetOutput()));
+
+	QString theirs = getTestFolder() + "theirs.mhd";
+	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
+	writer->SetInputData(image);
+	writer->SetFileName(cstring_cast(theirs));
+	writer->SetCompression(true);
+	writer->Write();
+	CHECK(isEqual(image, cx::MetaImageIO::read(theirs)));
+
+	// big endian data is swapped
+	QFile raw(getTestFolder() + "msb.raw");
+	raw.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	raw.write(QByteArray("\x01\x02\x03\x04", 4));
+	raw.close();
+	QFile header(getTestFolder() + "msb.mhd");
+	header.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	header.write("NDims = 2\nBinaryDataByteOrderMSB = True\nDimSize = 2 1\nElementType = MET_USHORT\nElementDataFile = msb.raw\n");
+	header.close();
+	vtkImageDataPtr msb = cx::MetaImageIO::read(getTestFolder() + "msb.mhd");
+	REQUIRE(msb);
+	CHECK(*static_cast<unsigned short*>(msb->GetScalarPointer(0, 0, 0)) == 0x0102);
+	CHECK(*static_cast<unsigned short*>(msb->GetScalarPointer(1, 0, 0)) == 0x0304);
+}
+
+TEST_CASE("MetaImageIO: Write and read asynchronously", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createTestImage();
+	QString filename = getTestFolder() + "async.mhd";
+
+	QFuture<bool> written = cx::MetaImageIO::writeAsync(filename, image, true);
+	CHECK(written.result());
+	QFuture<vtkImageDataPtr> read = cx::MetaImageIO::readAsync(filename);
+	CHECK(isEqual(image, read.result()));
+
+	CHECK(!cx::MetaImageIO::readAsync(getTestFolder() + "missing.mhd").result());
+}
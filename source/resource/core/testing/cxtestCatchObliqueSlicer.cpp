@@ -0,0 +1,191 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QElapsedTimer>
+#include <vtkImageData.h>
+#include <vtkLookupTable.h>
+#include "cxObliqueSlicer.h"
+#include "cxLogger.h"
+
+namespace
+{
+vtkImageDataPtr createRampVolume(int dimX, int dimY, int dimZ)
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(dimX, dimY, dimZ);
+	image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (int z=0; z<dimZ; ++z)
+		for (int y=0; y<dimY; ++y)
+			for (int x=0; x<dimX; ++x)
+				*ptr++ = x + 10*y + 100*z;
+	return image;
+}
+
+unsigned short getValue(vtkImageDataPtr image, int x, int y, int z=0)
+{
+	return *static_cast<unsigned short*>(image->GetScalarPointer(x, y, z));
+}
+
+cx::ObliqueSlicer createSlicer(vtkImageDataPtr image, int dimX, int dimY)
+{
+	cx::ObliqueSlicer slicer;
+	slicer.setInput(image);
+	slicer.setOutputFormat(cx::Vector3D(0,0,0), Eigen::Array3i(dimX, dimY, 1), cx::Vector3D(1,1,1));
+	return slicer;
+}
+}
+
+TEST_CASE("ObliqueSlicer: Axis aligned slice equals the input slice", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	cx::ObliqueSlicer slicer = createSlicer(image, 8, 6);
+	slicer.setLinearInterpolation(false);
+
+	vtkImageDataPtr slice = slicer.slice(cx::createTransformTranslate(cx::Vector3D(0,0,2)));
+	REQUIRE(slice);
+	CHECK(slice->GetScalarType() == VTK_UNSIGNED_SHORT);
+	CHECK(slice->GetDimensions()[0] == 8);
+	CHECK(slice->GetDimensions()[1] == 6);
+	CHECK(slice->GetDimensions()[2] == 1);
+
+	bool equal = true;
+	for (int y=0; y<6; ++y)
+		for (int x=0; x<8; ++x)
+			equal = equal && (getValue(slice, x, y) == x + 10*y + 200);
+	CHECK(equal);
+}
+
+TEST_CASE("ObliqueSlicer: Linear interpolation between slices", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	cx::ObliqueSlicer slicer = createSlicer(image, 8, 6);
+
+	vtkImageDataPtr slice = slicer.slice(cx::createTransformTranslate(cx::Vector3D(0,0,2.5)));
+	REQUIRE(slice);
+	CHECK(getValue(slice, 0, 0) == 250);
+	CHECK(getValue(slice, 3, 2) == 273);
+	CHECK(getValue(slice, 7, 5) == 307);
+}
+
+TEST_CASE("ObliqueSlicer: Outside the input gives the background level", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	cx::ObliqueSlicer slicer;
+	slicer.setInput(image);
+	slicer.setBackgroundLevel(7);
+	slicer.setOutputFormat(cx::Vector3D(-4,0,0), Eigen::Array3i(8, 6, 1), cx::Vector3D(1,1,1));
+
+	vtkImageDataPtr slice = slicer.slice(cx::Transform3D::Identity());
+	REQUIRE(slice);
+	CHECK(getValue(slice, 0, 0) == 7);
+	CHECK(getValue(slice, 3, 1) == 7);
+	CHECK(getValue(slice, 4, 1) == 10);
+	CHECK(getValue(slice, 7, 1) == 13);
+}
+
+TEST_CASE("ObliqueSlicer: Lut and window level are applied", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	cx::ObliqueSlicer slicer = createSlicer(image, 8, 6);
+
+	vtkLookupTablePtr lut = vtkLookupTablePtr::New();
+	lut->SetNumberOfTableValues(256);
+	lut->SetTableRange(0, 255);
+	for (int i=0; i<256; ++i)
+		lut->SetTableValue(i, i/255.0, 0, 1.0-i/255.0, 1);
+	slicer.setLookupTable(lut);
+
+	vtkImageDataPtr slice = slicer.slice(cx::Transform3D::Identity());
+	REQUIRE(slice);
+	CHECK(slice->GetScalarType() == VTK_UNSIGNED_CHAR);
+	CHECK(slice->GetNumberOfScalarComponents() == 4);
+	unsigned char* rgba = static_cast<unsigned char*>(slice->GetScalarPointer(2, 1, 0));
+	CHECK(int(rgba[0]) == 12);
+	CHECK(int(rgba[1]) == 0);
+	CHECK(int(rgba[2]) == 243);
+	CHECK(int(rgba[3]) == 255);
+
+	// narrow the window: everything above the window gets the last color
+	slicer.setWindowLevel(10, 5);
+	slice = slicer.slice(cx::Transform3D::Identity());
+	rgba = static_cast<unsigned char*>(slice->GetScalarPointer(2, 1, 0));
+	CHECK(int(rgba[0]) == 255);
+	rgba = static_cast<unsigned char*>(slice->GetScalarPointer(0, 0, 0));
+	CHECK(int(rgba[0]) == 0);
+
+	// window without lut gives a gray ramp
+	slicer.setLookupTable(vtkLookupTablePtr());
+	slicer.setWindowLevel(256, 128);
+	slice = slicer.slice(cx::Transform3D::Identity());
+	rgba = static_cast<unsigned char*>(slice->GetScalarPointer(2, 1, 0));
+	CHECK(int(rgba[0]) == 12);
+	CHECK(int(rgba[1]) == 12);
+	CHECK(int(rgba[2]) == 12);
+}
+
+TEST_CASE("ObliqueSlicer: Batch slices and slab", "[unit][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(8, 6, 5);
+	cx::ObliqueSlicer slicer = createSlicer(image, 8, 6);
+	slicer.setLinearInterpolation(false);
+
+	vtkImageDataPtr stack = slicer.slices(cx::createTransformTranslate(cx::Vector3D(0,0,1)), 3, 1);
+	REQUIRE(stack);
+	CHECK(stack->GetDimensions()[2] == 3);
+	CHECK(getValue(stack, 2, 1, 0) == 112);
+	CHECK(getValue(stack, 2, 1, 2) == 312);
+
+	// the output buffer is reused
+	vtkImageData* buffer = stack.GetPointer();
+	stack = vtkImageDataPtr();
+	CHECK(slicer.slices(cx::createTransformTranslate(cx::Vector3D(0,0,0)), 3, 1).GetPointer() == buffer);
+
+	vtkImageDataPtr slab = slicer.slab(cx::createTransformTranslate(cx::Vector3D(0,0,2)), 3, 1);
+	REQUIRE(slab);
+	CHECK(slab->GetDimensions()[2] == 1);
+	CHECK(getValue(slab, 2, 1) == 312);
+}
+
+TEST_CASE("Speed: ObliqueSlicer slices per second", "[speed][resource][core]")
+{
+	vtkImageDataPtr image = createRampVolume(256, 256, 256);
+	cx::ObliqueSlicer slicer;
+	slicer.setInput(image);
+	slicer.setOutputFormat(cx::Vector3D(-256,-256,0), Eigen::Array3i(512, 512, 1), cx::Vector3D(1,1,1));
+
+	cx::Transform3D iMs = cx::createTransformTranslate(cx::Vector3D(128,128,128))
+			* cx::createTransformRotateX(0.3) * cx::createTransformRotateY(0.2);
+
+	vtkLookupTablePtr lut = vtkLookupTablePtr::New();
+	lut->SetTableRange(0, 2000);
+	lut->Build();
+
+	int count = 50;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<count; ++i)
+		slicer.slice(iMs * cx::createTransformTranslate(cx::Vector3D(0,0,i)));
+	double raw = count * 1000.0 / std::max<qint64>(1, timer.restart());
+
+	slicer.setLookupTable(lut);
+	for (int i=0; i<count; ++i)
+		slicer.slice(iMs * cx::createTransformTranslate(cx::Vector3D(0,0,i)));
+	double colored = count * 1000.0 / std::max<qint64>(1, timer.restart());
+
+	slicer.slab(iMs, 16, 0.5);
+	int slabTime = timer.elapsed();
+
+	CX_LOG_INFO() << QString("ObliqueSlicer 512x512 from 256^3: %1 slices/s raw, %2 slices/s with lut, 16-slice slab %3 ms")
+					 .arg(raw, 0, 'f', 1).arg(colored, 0, 'f', 1).arg(slabTime);
+}
@@ -0,0 +1,173 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include "cxPositionStorageFile.h"
+#include "cxDataLocations.h"
+
+namespace
+{
+QString createFilename(QString name)
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/PositionStorageFile/";
+	QDir().mkpath(folder);
+	QString filename = folder + name;
+	QFile(filename).remove();
+	return filename;
+}
+
+cx::Transform3D createMatrix(int i)
+{
+	return cx::createTransformTranslate(cx::Vector3D(i, 2*i, 3)) * cx::createTransformRotateX(0.01*i);
+}
+
+/** Two tools with interleaved timestamps, written tool by tool as the tracking service does.
+ */
+void writeTools(QString filename, int first, int count)
+{
+	cx::PositionStorageWriter writer(filename);
+	for (int i=first; i<first+count; ++i)
+		writer.write(createMatrix(i), 1000+2*i, QString("tool0"));
+	for (int i=first; i<first+count; ++i)
+		writer.write(createMatrix(i), 1001+2*i, QString("tool1"));
+}
+
+bool similar(const cx::Transform3D& a, const cx::Transform3D& b)
+{
+	return a.matrix().isApprox(b.matrix(), 1E-9);
+}
+}
+
+TEST_CASE("PositionStorageFile: Read back sorted by time", "[unit][resource][core]")
+{
+	QString filename = createFilename("roundtrip.snwpos");
+	writeTools(filename, 0, 1000);
+
+	cx::PositionStorageReader reader(filename);
+	CHECK(reader.version() == 3);
+	CHECK(reader.isIndexed());
+
+	cx::Transform3D matrix;
+	double timestamp;
+	QString uid;
+	bool equal = true;
+	int count = 0;
+	while (!reader.atEnd())
+	{
+		REQUIRE(reader.read(&matrix, &timestamp, &uid));
+		int i = count/2;
+		equal = equal && (timestamp == 1000+count);
+		equal = equal && (uid == QString("tool%1").arg(count%2));
+		equal = equal && similar(matrix, createMatrix(i));
+		++count;
+	}
+	CHECK(equal);
+	CHECK(count == 2000);
+}
+
+TEST_CASE("PositionStorageFile: Seek and read a range", "[unit][resource][core]")
+{
+	QString filename = createFilename("range.snwpos");
+	writeTools(filename, 0, 1000);
+	writeTools(filename, 1000, 500); // appended as a second segment
+
+	cx::PositionStorageReader reader(filename);
+	REQUIRE(reader.isIndexed());
+
+	std::vector<cx::PositionStorageReader::Position> range = reader.readRange(1500.5, 3100);
+	REQUIRE(range.size() == 3100-1500);
+	bool equal = true;
+	for (unsigned i=0; i<range.size(); ++i)
+	{
+		int t = 1501+i;
+		equal = equal && (range[i].timestamp == t);
+		equal = equal && (range[i].toolUid == QString("tool%1").arg(t%2));
+		equal = equal && similar(range[i].matrix, createMatrix((t-1000)/2));
+	}
+	CHECK(equal);
+
+	CHECK(reader.readRange(5000, 6000).empty());
+	CHECK(reader.readRange(0, 1000).size() == 1);
+
+	cx::Transform3D matrix;
+	double timestamp;
+	QString uid;
+	REQUIRE(reader.seek(2999.5));
+	REQUIRE(reader.read(&matrix, &timestamp, &uid));
+	CHECK(timestamp == 3000); // first record of the second segment
+	CHECK(uid == "tool0");
+	REQUIRE(reader.read(&matrix, &timestamp, &uid));
+	CHECK(timestamp == 3001);
+
+	CHECK_FALSE(reader.seek(5000));
+	CHECK(reader.atEnd());
+}
+
+TEST_CASE("PositionStorageFile: Read version 2 files", "[unit][resource][core]")
+{
+	QString filename = createFilename("version2.snwpos");
+	{
+		QFile file(filename);
+		REQUIRE(file.open(QIODevice::WriteOnly));
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.writeRawData("SNWPOS", 6);
+		stream << (quint8)2;
+	}
+	writeTools(filename, 0, 100); // appends in the old format
+
+	cx::PositionStorageReader reader(filename);
+	CHECK(reader.version() == 2);
+	CHECK_FALSE(reader.isIndexed());
+
+	std::vector<cx::PositionStorageReader::Position> range = reader.readRange(1010, 1020);
+	REQUIRE(range.size() == 11);
+	CHECK(range[0].timestamp == 1010); // file order: all of tool0 before tool1
+	CHECK(range[6].timestamp == 1011);
+	CHECK(range[6].toolUid == "tool1");
+	CHECK(similar(range[6].matrix, createMatrix(5)));
+
+	cx::Transform3D matrix;
+	double timestamp;
+	QString uid;
+	REQUIRE(reader.seek(1100));
+	REQUIRE(reader.read(&matrix, &timestamp, &uid));
+	CHECK(timestamp == 1100);
+	CHECK(uid == "tool0");
+}
+
+TEST_CASE("PositionStorageFile: Skip an incomplete segment at the end", "[unit][resource][core]")
+{
+	QString filename = createFilename("interrupted.snwpos");
+	writeTools(filename, 0, 100);
+
+	// a segment interrupted while written, without footer
+	QFile file(filename);
+	REQUIRE(file.open(QIODevice::Append));
+	file.write(QByteArray(300, char(0x11)));
+	file.close();
+
+	{
+		cx::PositionStorageReader reader(filename);
+		CHECK(reader.readRange(0, 1E12).size() == 200);
+	}
+
+	// appended segments are chained to the last complete one
+	writeTools(filename, 100, 100);
+	cx::PositionStorageReader reader(filename);
+	std::vector<cx::PositionStorageReader::Position> positions = reader.readRange(0, 1E12);
+	REQUIRE(positions.size() == 400);
+	CHECK(positions.front().timestamp == 1000);
+	CHECK(positions.back().timestamp == 1399);
+}
@@ -0,0 +1,115 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <vtkImageData.h>
+#include "cxPrefetchingImageDataContainer.h"
+
+namespace
+{
+/** Source creating 256x256 frames slowly, counting loads and purges.
+ */
+class SlowFramesContainer : public cx::ImageDataContainer
+{
+public:
+	SlowFramesContainer(unsigned size, int loadTime) : mSize(size), mLoadTime(loadTime), mLoads(0), mPurges(0) {}
+	virtual vtkImageDataPtr get(unsigned index)
+	{
+		QThread::msleep(mLoadTime);
+		vtkImageDataPtr image = vtkImageDataPtr::New();
+		image->SetDimensions(256, 256, 1);
+		image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+		static_cast<unsigned char*>(image->GetScalarPointer())[0] = index%256;
+		QMutexLocker locker(&mMutex);
+		++mLoads;
+		return image;
+	}
+	virtual unsigned size() const { return mSize; }
+	virtual bool purge(unsigned index)
+	{
+		QMutexLocker locker(&mMutex);
+		++mPurges;
+		return true;
+	}
+	int getLoads() { QMutexLocker locker(&mMutex); return mLoads; }
+	int getPurges() { QMutexLocker locker(&mMutex); return mPurges; }
+
+private:
+	unsigned mSize;
+	int mLoadTime;
+	QMutex mMutex;
+	int mLoads;
+	int mPurges;
+};
+typedef boost::shared_ptr<SlowFramesContainer> SlowFramesContainerPtr;
+
+int valueOf(vtkImageDataPtr image)
+{
+	return image ? static_cast<unsigned char*>(image->GetScalarPointer())[0] : -1;
+}
+}
+
+TEST_CASE("PrefetchingImageDataContainer: Frames ahead are loaded in the background", "[unit][resource][core]")
+{
+	SlowFramesContainerPtr source(new SlowFramesContainer(100, 1));
+	cx::PrefetchingImageDataContainer cache(source, 10, 64);
+	CHECK(cache.size() == 100);
+
+	// play forward, slower than the source can load: wait for the prefetch of each frame
+	bool correct = true;
+	for (unsigned i=0; i<40; ++i)
+	{
+		correct = correct && (valueOf(cache.get(i)) == int(i));
+		cache.waitForPrefetch();
+	}
+	CHECK(correct);
+
+	cx::PrefetchingImageDataContainer::Statistics stats = cache.getStatistics();
+	CHECK(stats.hits + stats.misses == 40);
+	CHECK(stats.misses == 1); // only the first frame
+	CHECK(stats.loads >= 40);
+	CHECK(stats.getMeanLoadTime() > 0);
+
+	// play backward: misses at the jump and at the change of direction
+	cache.resetStatistics();
+	for (int i=60; i>=20; --i)
+	{
+		correct = correct && (valueOf(cache.get(i)) == i);
+		cache.waitForPrefetch();
+	}
+	CHECK(correct);
+	CHECK(cache.getStatistics().misses <= 2);
+}
+
+TEST_CASE("PrefetchingImageDataContainer: Memory limit evicts old frames", "[unit][resource][core]")
+{
+	SlowFramesContainerPtr source(new SlowFramesContainer(200, 0));
+	double frameMemory = 256.0*256/1024/1024;
+	cx::PrefetchingImageDataContainer cache(source, 5, 20*frameMemory);
+
+	for (unsigned i=0; i<200; ++i)
+		cache.get(i);
+
+	CHECK(cache.getStatistics().memory <= 20*frameMemory*1.01);
+	CHECK(source->getPurges() >= 150);
+
+	// the most recent frame is still cached
+	int loads = source->getLoads();
+	CHECK(valueOf(cache.get(199)) == 199);
+	CHECK(source->getLoads() == loads);
+
+	cache.purgeAll();
+	CHECK(cache.getStatistics().memory == Approx(0));
+}
@@ -0,0 +1,106 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxProbeMask.h"
+#include "cxProbeSector.h"
+#include "cxDummyTool.h"
+
+namespace
+{
+cx::ProbeDefinition createSectorProbe(double depthStart)
+{
+	cx::ProbeDefinition probe = cx::DummyToolTestUtilities::createProbeDefinition(cx::ProbeDefinition::tSECTOR, 40, 50, Eigen::Array2i(120, 80));
+	probe.setSector(depthStart, 40, M_PI/2, 0);
+	return probe;
+}
+
+/** True if the runs of every row cover exactly the nonzero pixels.
+ */
+bool spansEqualImage(cx::ProbeMaskPtr mask)
+{
+	Eigen::Array3i dim = mask->getDimensions();
+	unsigned char* ptr = static_cast<unsigned char*>(mask->getImage()->GetScalarPointer());
+	std::vector<unsigned char> fromSpans(dim[0]*dim[1], 0);
+	for (int y=0; y<dim[1]; ++y)
+		for (const cx::ProbeMask::Span* span = mask->beginRow(y); span != mask->endRow(y); ++span)
+			std::fill(fromSpans.begin() + y*dim[0] + span->begin, fromSpans.begin() + y*dim[0] + span->end, 1);
+	return std::equal(fromSpans.begin(), fromSpans.end(), ptr);
+}
+}
+
+TEST_CASE("ProbeMask: Masks are shared for equal sectors", "[unit][resource][core]")
+{
+	cx::ProbeMask::clearCache();
+	cx::ProbeDefinition probe = createSectorProbe(10);
+
+	cx::ProbeMaskPtr mask = cx::ProbeMask::get(probe);
+	REQUIRE(mask);
+	CHECK(mask->getDimensions()[0] == 120);
+	CHECK(mask->getDimensions()[1] == 80);
+
+	// uid and temporal calibration do not change the mask
+	probe.setUid("other");
+	probe.setTemporalCalibration(20);
+	CHECK(cx::ProbeMask::get(probe) == mask);
+
+	// geometry does
+	CHECK(cx::ProbeMask::get(createSectorProbe(5)) != mask);
+	CHECK(cx::ProbeMask::get(createSectorProbe(10)) == mask);
+
+	CHECK_FALSE(cx::ProbeMask::get(cx::ProbeDefinition()));
+}
+
+TEST_CASE("ProbeMask: Spans match the bitmap", "[unit][resource][core]")
+{
+	// the inner arc splits rows in two runs
+	cx::ProbeMaskPtr sector = cx::ProbeMask::get(createSectorProbe(10));
+	REQUIRE(sector);
+	CHECK(sector->getNumberOfInsidePixels() > 0);
+	CHECK(spansEqualImage(sector));
+
+	bool twoSpans = false;
+	for (int y=0; y<sector->getDimensions()[1]; ++y)
+		twoSpans = twoSpans || (sector->endRow(y) - sector->beginRow(y) == 2);
+	CHECK(twoSpans);
+
+	cx::ProbeMaskPtr linear = cx::ProbeMask::get(cx::DummyToolTestUtilities::createProbeDefinitionLinear(40, 50, Eigen::Array2i(80, 40)));
+	REQUIRE(linear);
+	CHECK(spansEqualImage(linear));
+
+	// bounding box of the nonzero pixels
+	int bb[4] = { 80, 0, 40, 0 };
+	int inside = 0;
+	unsigned char* ptr = static_cast<unsigned char*>(linear->getImage()->GetScalarPointer());
+	for (int y=0; y<40; ++y)
+		for (int x=0; x<80; ++x)
+			if (ptr[x + y*80])
+			{
+				bb[0] = std::min(bb[0], x);
+				bb[1] = std::max(bb[1], x);
+				bb[2] = std::min(bb[2], y);
+				bb[3] = std::max(bb[3], y);
+				++inside;
+			}
+	CHECK(linear->getNumberOfInsidePixels() == inside);
+	for (int i=0; i<4; ++i)
+		CHECK(linear->getBoundingBox()[i] == bb[i]);
+}
+
+TEST_CASE("ProbeMask: ProbeSector returns the shared image", "[unit][resource][core]")
+{
+	cx::ProbeDefinition probe = createSectorProbe(10);
+	cx::ProbeSector sector;
+	sector.setData(probe);
+	CHECK(sector.getMask() == cx::ProbeMask::get(probe)->getImage());
+}
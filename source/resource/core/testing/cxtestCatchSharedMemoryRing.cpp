@@ -0,0 +1,123 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <string.h>
+#include "cxSharedMemoryRing.h"
+
+namespace
+{
+void writeFrame(cx::SharedMemoryRingWriter& writer, int value)
+{
+	CHECK(writer.write(&value, sizeof(value)));
+}
+
+int readFrame(cx::SharedMemoryRingReader& reader, bool onlyLatest = false)
+{
+	const void* data = reader.beginRead(onlyLatest);
+	if (!data)
+		return -1;
+	int value = 0;
+	memcpy(&value, data, sizeof(value));
+	if (!reader.endRead())
+		return -2;
+	return value;
+}
+}
+
+TEST_CASE("SharedMemoryRing delivers frames in order to all readers", "[unit][resource][core]")
+{
+	cx::SharedMemoryRingWriter writer("test_ring_order", 4, 64);
+	REQUIRE(writer.isValid());
+
+	cx::SharedMemoryRingReader reader1;
+	cx::SharedMemoryRingReader reader2;
+	REQUIRE(reader1.attach(writer.key()));
+	REQUIRE(reader2.attach(writer.key()));
+	CHECK(reader1.slotCount() == 4);
+	CHECK(reader1.slotSize() == 64);
+	CHECK(readFrame(reader1) == -1);
+
+	writeFrame(writer, 10);
+	writeFrame(writer, 11);
+	CHECK(readFrame(reader1) == 10);
+	CHECK(reader1.size() == int(sizeof(int)));
+	CHECK(reader1.sequence() == 1);
+	CHECK(readFrame(reader1) == 11);
+	CHECK(readFrame(reader1) == -1);
+
+	CHECK(readFrame(reader2) == 10);
+	writeFrame(writer, 12);
+	CHECK(readFrame(reader2) == 11);
+	CHECK(readFrame(reader2) == 12);
+	CHECK(readFrame(reader1) == 12);
+
+	CHECK(writer.getFramesWritten() == 3);
+	CHECK(reader1.getDroppedCount() == 0);
+	CHECK(reader2.getDroppedCount() == 0);
+}
+
+TEST_CASE("SharedMemoryRing drops the oldest frames for slow readers", "[unit][resource][core]")
+{
+	cx::SharedMemoryRingWriter writer("test_ring_drop", 4, 64);
+	cx::SharedMemoryRingReader reader;
+	REQUIRE(reader.attach(writer.key()));
+
+	for (int i=1; i<=10; ++i)
+		writeFrame(writer, i);
+
+	// the writer is about to reuse the slot of frame 7, thus 8 is the oldest intact frame
+	CHECK(readFrame(reader) == 8);
+	CHECK(reader.getDroppedCount() == 7);
+	CHECK(readFrame(reader) == 9);
+	CHECK(readFrame(reader) == 10);
+
+	for (int i=11; i<=13; ++i)
+		writeFrame(writer, i);
+	CHECK(readFrame(reader, true) == 13);
+	CHECK(reader.getDroppedCount() == 9);
+	CHECK(readFrame(reader) == -1);
+}
+
+TEST_CASE("SharedMemoryRing detects frames overwritten during read", "[unit][resource][core]")
+{
+	cx::SharedMemoryRingWriter writer("test_ring_torn", 2, 64);
+	cx::SharedMemoryRingReader reader;
+	REQUIRE(reader.attach(writer.key()));
+
+	writeFrame(writer, 1);
+	const void* data = reader.beginRead();
+	REQUIRE(data);
+
+	// the writer laps the reader while it holds frame 1
+	writeFrame(writer, 2);
+	void* dst = writer.beginWrite();
+	REQUIRE(dst == data);
+	CHECK(!reader.endRead());
+	writer.endWrite(0);
+
+	CHECK(reader.getDroppedCount() == 1);
+	CHECK(!writer.write(data, 65));
+}
+
+TEST_CASE("SharedMemoryRing readers detect that the writer is gone", "[unit][resource][core]")
+{
+	cx::SharedMemoryRingReader reader;
+	CHECK(!reader.attach("test_ring_gone"));
+	{
+		cx::SharedMemoryRingWriter writer("test_ring_gone", 2, 64);
+		REQUIRE(reader.attach(writer.key()));
+		CHECK(reader.isValid());
+	}
+	CHECK(!reader.isValid());
+	CHECK(!reader.beginRead());
+}
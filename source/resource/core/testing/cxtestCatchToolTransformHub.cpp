@@ -0,0 +1,100 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxToolTransformHub.h"
+#include "cxManualTool.h"
+
+namespace
+{
+struct TransformCounter
+{
+	TransformCounter() : count(0), lastTimestamp(-1) {}
+	void receive(cx::Transform3D prMt, double timestamp)
+	{
+		++count;
+		last_prMt = prMt;
+		lastTimestamp = timestamp;
+	}
+	int count;
+	cx::Transform3D last_prMt;
+	double lastTimestamp;
+};
+}
+
+TEST_CASE("ToolTransformHub coalesces samples to the latest per flush", "[unit][resource][core]")
+{
+	cx::ToolTransformHub* hub = cx::ToolTransformHub::getInstance();
+	hub->flush();
+
+	boost::shared_ptr<cx::ManualTool> tool(new cx::ManualTool("hub_test_tool"));
+	tool->setVisible(true);
+	TransformCounter everySample;
+	TransformCounter coalesced;
+	QObject::connect(tool.get(), &cx::Tool::toolTransformAndTimestamp,
+					 [&](cx::Transform3D prMt, double ts) { everySample.receive(prMt, ts); });
+	QObject::connect(tool.get(), &cx::Tool::toolTransformCoalesced,
+					 [&](cx::Transform3D prMt, double ts) { coalesced.receive(prMt, ts); });
+
+	cx::ToolTransformHub::Statistics before = hub->getStatistics(tool->getUid());
+
+	int samples = 10;
+	for (int i=0; i<samples; ++i)
+		tool->set_prMt(cx::createTransformTranslate(cx::Vector3D(i,0,0)), 1000+i);
+
+	CHECK(everySample.count == samples);
+	CHECK(coalesced.count == 0);
+	CHECK(tool->getPositionHistory()->size() == samples);
+
+	CHECK(hub->flush() == 1);
+	CHECK(coalesced.count == 1);
+	CHECK(coalesced.lastTimestamp == Approx(1000+samples-1));
+	CHECK(cx::similar(coalesced.last_prMt, tool->get_prMt()));
+
+	CHECK(hub->flush() == 0);
+	CHECK(coalesced.count == 1);
+
+	cx::ToolTransformHub::Statistics after = hub->getStatistics(tool->getUid());
+	CHECK(after.received - before.received == samples);
+	CHECK(after.delivered - before.delivered == 1);
+	CHECK(after.coalesced() - before.coalesced() == samples-1);
+}
+
+TEST_CASE("ToolTransformHub receives samples emitted directly by any tool", "[unit][resource][core]")
+{
+	cx::ToolTransformHub* hub = cx::ToolTransformHub::getInstance();
+	hub->flush();
+	int tools = hub->getNumberOfTools();
+
+	TransformCounter coalesced;
+	{
+		boost::shared_ptr<cx::ManualTool> tool(new cx::ManualTool("hub_direct_tool"));
+		QObject::connect(tool.get(), &cx::Tool::toolTransformCoalesced,
+						 [&](cx::Transform3D prMt, double ts) { coalesced.receive(prMt, ts); });
+
+		// tracking tools like the OpenIGTLink and playback tools emit without set_prMt()
+		for (int i=0; i<5; ++i)
+			emit tool->toolTransformAndTimestamp(cx::createTransformTranslate(cx::Vector3D(0,i,0)), 2000+i);
+
+		CHECK(hub->flush() == 1);
+		CHECK(coalesced.count == 1);
+		CHECK(coalesced.lastTimestamp == Approx(2004));
+		CHECK(hub->getNumberOfTools() == tools+1);
+
+		emit tool->toolTransformAndTimestamp(cx::Transform3D::Identity(), 3000);
+	}
+
+	// destroyed tools are removed, including pending samples
+	CHECK(hub->getNumberOfTools() == tools);
+	CHECK(hub->flush() == 0);
+	CHECK(coalesced.count == 1);
+}
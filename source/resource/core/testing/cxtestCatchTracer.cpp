@@ -0,0 +1,133 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <thread>
+#include <QFile>
+#include "cxTracer.h"
+#include "cxDataLocations.h"
+
+namespace
+{
+void recordWork(int count)
+{
+	cx::Tracer::setThreadName("TracerTestWorker");
+	for (int i=0; i<count; ++i)
+	{
+		CX_TRACE_SCOPE("test", "work");
+		CX_TRACE_COUNTER("test", "iteration", i);
+	}
+}
+
+QByteArray readFile(QString filename)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	return file.readAll();
+}
+}
+
+TEST_CASE("Tracer records nothing when disabled", "[unit][resource][core]")
+{
+	cx::Tracer::setEnabled(false);
+	cx::Tracer::clear();
+
+	recordWork(10);
+	CX_TRACE_INSTANT("test", "instant");
+
+	CHECK(cx::Tracer::getEventCount() == 0);
+}
+
+TEST_CASE("Tracer writes events from several threads as a Chrome trace", "[unit][resource][core]")
+{
+	cx::Tracer::clear();
+	cx::Tracer::setEnabled(true);
+
+	std::thread worker(recordWork, 10);
+	recordWork(5);
+	CX_TRACE_INSTANT("test", cx::Tracer::intern("instant \"quoted\""));
+	worker.join();
+	cx::Tracer::setEnabled(false);
+
+	CHECK(cx::Tracer::getEventCount() == 2*15+1);
+
+	QString filename = cx::DataLocations::getTestDataPath() + "/temp/Tracer/trace.json";
+	REQUIRE(cx::Tracer::writeChromeTrace(filename));
+	QByteArray trace = readFile(filename);
+
+	CHECK(trace.startsWith("{"));
+	CHECK(trace.trimmed().endsWith("]}"));
+	CHECK(trace.count("\"name\":\"work\"") == 15);
+	CHECK(trace.count("\"ph\":\"C\"") == 15);
+	CHECK(trace.contains("\"name\":\"TracerTestWorker\""));
+	CHECK(trace.contains("instant \\\"quoted\\\""));
+
+	cx::Tracer::clear();
+	CHECK(cx::Tracer::getEventCount() == 0);
+	QFile(filename).remove();
+}
+
+TEST_CASE("Tracer keeps the latest events when a thread buffer is full", "[unit][resource][core]")
+{
+	cx::Tracer::clear();
+	cx::Tracer::setEnabled(true);
+
+	std::thread worker(recordWork, 100000);
+	worker.join();
+	cx::Tracer::setEnabled(false);
+
+	CHECK(cx::Tracer::getEventCount() == 1<<16);
+	cx::Tracer::clear();
+}
+
+TEST_CASE("Tracer releases the buffers of finished threads", "[unit][resource][core]")
+{
+	cx::Tracer::clear();
+	cx::Tracer::setEnabled(true);
+	int threads = cx::Tracer::getThreadCount();
+
+	std::thread worker(recordWork, 10);
+	worker.join();
+	std::thread idle(recordWork, 0);
+	idle.join();
+
+	// events from the finished thread are kept until cleared
+	CHECK(cx::Tracer::getThreadCount() == threads+1);
+	CHECK(cx::Tracer::getEventCount() == 20);
+
+	cx::Tracer::clear();
+	CHECK(cx::Tracer::getThreadCount() == threads);
+	cx::Tracer::setEnabled(false);
+}
+
+TEST_CASE("Tracer writes only whole events while a thread is recording", "[unit][resource][core]")
+{
+	cx::Tracer::clear();
+	cx::Tracer::setEnabled(true);
+
+	std::thread worker(recordWork, 300000);
+	QString filename = cx::DataLocations::getTestDataPath() + "/temp/Tracer/trace_concurrent.json";
+	REQUIRE(cx::Tracer::writeChromeTrace(filename));
+	worker.join();
+	cx::Tracer::setEnabled(false);
+
+	QByteArray trace = readFile(filename);
+	int events = trace.count("\"cat\":\"test\"");
+	int spans = trace.count("\"name\":\"work\",\"cat\":\"test\",\"ph\":\"X\"");
+	int counters = trace.count("\"name\":\"iteration\",\"cat\":\"test\",\"ph\":\"C\"");
+	CHECK(spans + counters == events);
+	CHECK(events <= 1<<16);
+
+	cx::Tracer::clear();
+	QFile(filename).remove();
+}
@@ -0,0 +1,149 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <boost/bind.hpp>
+#include "cxTransformGraph.h"
+#include "cxSpaceProviderImpl.h"
+#include "cxTrackingService.h"
+#include "cxRegistrationTransform.h"
+#include "cxtestPatientModelServiceMock.h"
+
+namespace
+{
+/** A transform that counts how often it is fetched.
+ */
+struct CountingTransform
+{
+	CountingTransform(cx::Transform3D M) : M(M), count(0) {}
+	cx::Transform3D get() { ++count; return M; }
+	cx::Transform3D M;
+	int count;
+};
+}
+
+TEST_CASE("TransformGraph composes transforms along the tree", "[unit][resource][core]")
+{
+	CountingTransform rMpr(cx::createTransformRotateZ(0.3)*cx::createTransformTranslate(cx::Vector3D(1,2,3)));
+	CountingTransform prMt(cx::createTransformRotateX(1.1)*cx::createTransformTranslate(cx::Vector3D(0,5,0)));
+	CountingTransform rMd(cx::createTransformTranslate(cx::Vector3D(-4,0,7)));
+	CountingTransform dMdv(cx::createTransformScale(cx::Vector3D(0.5,0.5,2)));
+
+	cx::TransformGraph graph;
+	cx::TransformGraph::Handle r = graph.getRoot();
+	cx::TransformGraph::Handle pr = graph.addNode(r, boost::bind(&CountingTransform::get, &rMpr));
+	cx::TransformGraph::Handle t = graph.addNode(pr, boost::bind(&CountingTransform::get, &prMt));
+	cx::TransformGraph::Handle d = graph.addNode(r, boost::bind(&CountingTransform::get, &rMd));
+	cx::TransformGraph::Handle dv = graph.addNode(d, boost::bind(&CountingTransform::get, &dMdv));
+
+	cx::Transform3D rMt = rMpr.M*prMt.M;
+	cx::Transform3D rMdv = rMd.M*dMdv.M;
+	CHECK(cx::similar(graph.get_toMfrom(t, r), rMt));
+	CHECK(cx::similar(graph.get_toMfrom(r, t), rMt.inv()));
+	CHECK(cx::similar(graph.get_toMfrom(t, d), rMd.M.inv()*rMt));
+	CHECK(cx::similar(graph.get_toMfrom(t, dv), rMdv.inv()*rMt));
+	CHECK(cx::similar(graph.get_toMfrom(dv, t), rMt.inv()*rMdv));
+	CHECK(cx::similar(graph.get_toMfrom(t, t), cx::Transform3D::Identity()));
+
+	std::vector<cx::TransformGraph::HandlePair> pairs;
+	pairs.push_back(cx::TransformGraph::HandlePair(t, d));
+	pairs.push_back(cx::TransformGraph::HandlePair(dv, pr));
+	std::vector<cx::Transform3D> batch = graph.get_toMfrom(pairs);
+	REQUIRE(batch.size() == 2);
+	CHECK(cx::similar(batch[0], rMd.M.inv()*rMt));
+	CHECK(cx::similar(batch[1], rMpr.M.inv()*rMdv));
+}
+
+TEST_CASE("TransformGraph fetches transforms only after invalidation", "[unit][resource][core]")
+{
+	CountingTransform rMpr(cx::createTransformTranslate(cx::Vector3D(1,0,0)));
+	CountingTransform prMt(cx::createTransformRotateY(0.7));
+	CountingTransform tMs(cx::createTransformTranslate(cx::Vector3D(0,0,3)));
+
+	cx::TransformGraph graph;
+	cx::TransformGraph::Handle pr = graph.addNode(graph.getRoot(), boost::bind(&CountingTransform::get, &rMpr));
+	cx::TransformGraph::Handle t = graph.addNode(pr, boost::bind(&CountingTransform::get, &prMt));
+	cx::TransformGraph::Handle s = graph.addNode(t, boost::bind(&CountingTransform::get, &tMs), true);
+
+	for (int i=0; i<10; ++i)
+		graph.get_toMfrom(t, graph.getRoot());
+	CHECK(prMt.count == 1);
+	CHECK(rMpr.count == 1);
+	CHECK(graph.getStatistics().lookups == 10);
+	CHECK(graph.getStatistics().hits == 9);
+	unsigned version = graph.getVersion(t);
+
+	// a new tool position propagates to the tool but not its parent
+	prMt.M = cx::createTransformRotateY(0.2);
+	graph.invalidate(t);
+	CHECK(cx::similar(graph.get_toMfrom(t, graph.getRoot()), rMpr.M*prMt.M));
+	CHECK(prMt.count == 2);
+	CHECK(rMpr.count == 1);
+	CHECK(graph.getVersion(t) == version+1);
+
+	// a new registration propagates to the children
+	rMpr.M = cx::createTransformTranslate(cx::Vector3D(0,4,0));
+	graph.invalidate(pr);
+	CHECK(cx::similar(graph.get_toMfrom(s, graph.getRoot()), rMpr.M*prMt.M*tMs.M));
+	CHECK(prMt.count == 2);
+
+	// polled nodes are fetched each time, and pick up changes without invalidation
+	int count = tMs.count;
+	tMs.M = cx::createTransformTranslate(cx::Vector3D(0,0,5));
+	CHECK(cx::similar(graph.get_toMfrom(s, t), tMs.M));
+	CHECK(tMs.count == count+1);
+
+	graph.resetStatistics();
+	CHECK(graph.getStatistics().lookups == 0);
+	CHECK(graph.getStatistics().getHitRate() == Approx(0));
+
+	graph.clear();
+	CHECK(!graph.isValid(t));
+	CHECK(cx::similar(graph.get_toMfrom(t, graph.getRoot()), cx::Transform3D::Identity()));
+}
+
+TEST_CASE("TransformGraph inverts rigid transforms by transposition", "[unit][resource][core]")
+{
+	cx::Transform3D M = cx::createTransformRotateX(0.4)*cx::createTransformRotateZ(-1.3)*cx::createTransformTranslate(cx::Vector3D(3,-2,8));
+	CHECK(cx::TransformGraph::isRigid(M));
+	CHECK(cx::similar(cx::TransformGraph::invertRigid(M), M.inv(), 1.0E-12));
+	CHECK(!cx::TransformGraph::isRigid(M*cx::createTransformScale(cx::Vector3D(1,1,2))));
+}
+
+TEST_CASE("SpaceProviderImpl handles are invalidated by change signals", "[unit][resource][core]")
+{
+	cxtest::PatientModelServiceMockPtr patientModel(new cxtest::PatientModelServiceMock());
+	cx::SpaceProviderImpl provider(cx::TrackingService::getNullObject(), patientModel);
+
+	cx::SpaceHandle pr = provider.getHandle(cx::CoordinateSystem(cx::csPATIENTREF));
+	cx::SpaceHandle r = provider.getHandle(cx::CoordinateSystem(cx::csREF));
+	CHECK(pr.node >= 0);
+	CHECK(cx::similar(provider.get_toMfrom(pr, r), cx::Transform3D::Identity()));
+
+	// the listener is connected after the provider, and must see the new transform
+	cx::Transform3D rMpr = cx::createTransformTranslate(cx::Vector3D(1,2,3));
+	cx::Transform3D seen = cx::Transform3D::Identity();
+	QObject::connect(patientModel.get(), &cx::PatientModelService::rMprChanged, [&]()
+	{
+		seen = provider.get_toMfrom(pr, r);
+	});
+	patientModel->get_rMpr_History()->setRegistration(rMpr);
+	CHECK(cx::similar(seen, rMpr));
+	CHECK(cx::similar(provider.get_rMpr(), rMpr));
+
+	// rebuilding the graph outdates the handle, it is then resolved again
+	unsigned generation = pr.generation;
+	emit patientModel->dataAddedOrRemoved();
+	CHECK(cx::similar(provider.get_toMfrom(pr, r), rMpr));
+	CHECK(pr.generation != generation);
+	CHECK(pr.node >= 0);
+}
@@ -26,6 +26,7 @@ public:
 	virtual ~SpaceListenerMock() {}
 	void setSpace(cx::CoordinateSystem space) { mSpace = space; }
 	cx::CoordinateSystem getSpace() const { return mSpace; }
+	cx::Transform3D get_rMs() { return cx::Transform3D::Identity(); }
 private:
 	cx::CoordinateSystem mSpace;
 };
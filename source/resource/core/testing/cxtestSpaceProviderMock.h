@@ -32,6 +32,7 @@ public:
 	SpaceProviderMock() {}
 	virtual ~SpaceProviderMock() {}
 
+	using cx::SpaceProvider::get_toMfrom;
 	virtual cx::Transform3D get_toMfrom(cx::CoordinateSystem from, cx::CoordinateSystem to) { return cx::Transform3D::Identity(); }
 	virtual std::vector<cx::CoordinateSystem> getSpacesToPresentInGUI() { return std::vector<cx::CoordinateSystem>(); }
 	virtual std::map<QString, QString> getDisplayNamesForCoordRefObjects() { return std::map<QString, QString>(); }
@@ -20,7 +20,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageLuminance.h>
 #include <vtkImageData.h>
 #include "vtkImageAppend.h"
-#include "vtkMetaImageWriter.h"
 
 #include "cxTypeConversions.h"
 #include "cxLogger.h"
@@ -28,6 +27,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxXmlOptionItem.h"
 #include "cxImageDataContainer.h"
 #include "cxVideoSource.h"
+#include "cxMetaImageIO.h"
 
 namespace cx
 {
@@ -121,11 +121,7 @@ void VideoRecorderSaveThread::write(VideoRecorderSaveThread::DataType data)
 	}
 
 	// write image
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
-	writer->SetInputData(data.mImage);
-	writer->SetFileName(cstring_cast(data.mImageFilename));
-	writer->SetCompression(mCompressed);
-	writer->Write();
+	MetaImageIO::write(data.mImageFilename, data.mImage, mCompressed);
 }
 
 void VideoRecorderSaveThread::writeTimeStampsFile(TimeInfo timeStamps)
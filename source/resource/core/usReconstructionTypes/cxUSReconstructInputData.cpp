@@ -21,6 +21,11 @@ vtkImageDataPtr USReconstructInputData::getMask()
 	return retval;
 }
 
+ProbeMaskPtr USReconstructInputData::getProbeMask()
+{
+	return ProbeMask::get(mProbeDefinition.mData);
+}
+
 bool USReconstructInputData::isValid() const
 {
 	if (mFrames.empty() || !mUsRaw || mPositions.empty())
@@ -15,6 +15,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <vector>
 #include "cxProbeSector.h"
+#include "cxProbeMask.h"
 #include "cxData.h"
 #include "cxTool.h"
 
@@ -59,6 +60,7 @@ struct cxResource_EXPORT USReconstructInputData
 	Transform3D rMpr; ///< patient registration
 
 	vtkImageDataPtr getMask();
+	ProbeMaskPtr getProbeMask(); ///< the mask as runs per row, zero if the probe is undefined
 	bool isValid() const;
 	bool is8bit() const;
 };
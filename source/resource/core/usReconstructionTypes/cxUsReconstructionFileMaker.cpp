@@ -15,10 +15,11 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
+#include <deque>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
 #include "vtkImageAppend.h"
-#include "vtkMetaImageWriter.h"
 #include "cxTypeConversions.h"
 #include "cxLogger.h"
 #include "cxSettings.h"
@@ -29,7 +30,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxImageDataContainer.h"
 #include "cxUSReconstructInputDataAlgoritms.h"
 #include "cxCustomMetaImage.h"
-#include "cxErrorObserver.h"
+#include "cxMetaImageIO.h"
 
 
 typedef vtkSmartPointer<vtkImageAppend> vtkImageAppendPtr;
@@ -334,26 +335,37 @@ void UsReconstructionFileMaker::report()
 void UsReconstructionFileMaker::writeUSImages(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos)
 {
 	CX_ASSERT(images->size()==pos.size());
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
 
-	for (unsigned i=0; i<images->size(); ++i)
-	{
-		vtkImageDataPtr currentImage = images->get(i);
-		QString filename = QString("%1/%2_%3.mhd").arg(path).arg(mSessionDescription).arg(i);
+	// write several frames at a time, but keep only a few of them in memory
+	const unsigned maxPending = std::max(QThread::idealThreadCount(), 1)*2;
+	typedef std::pair<unsigned, QFuture<bool> > PendingFrame;
+	std::deque<PendingFrame> pending;
 
-		writer->SetInputData(currentImage);
-		writer->SetFileName(cstring_cast(filename));
-		writer->SetCompression(compression);
+	auto getFilename = [&](unsigned i) { return QString("%1/%2_%3.mhd").arg(path).arg(mSessionDescription).arg(i); };
+	auto finishOldest = [&]()
+	{
+		unsigned i = pending.front().first;
+		bool ok = pending.front().second.result();
+		pending.pop_front();
+		if (!ok)
 		{
-			StaticMutexVtkLocker lock;
-			writer->Write();
+			reportError("Failed to write " + getFilename(i));
+			return;
 		}
-
-		CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
+		CustomMetaImagePtr customReader = CustomMetaImage::create(getFilename(i));
 		customReader->setTransform(pos[i].mPos);
 		customReader->setModality(imUS);
 		customReader->setImageType(convertToImageSubType(mSessionDescription));
+	};
+
+	for (unsigned i=0; i<images->size(); ++i)
+	{
+		if (pending.size() >= maxPending)
+			finishOldest();
+		pending.push_back(PendingFrame(i, MetaImageIO::writeAsync(getFilename(i), images->get(i), compression)));
 	}
+	while (!pending.empty())
+		finishOldest();
 }
 
 void UsReconstructionFileMaker::writeMask(QString path, QString session, vtkImageDataPtr mask)
@@ -365,11 +377,7 @@ void UsReconstructionFileMaker::writeMask(QString path, QString session, vtkImag
 		return;
 	}
 
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
-	writer->SetInputData(mask);
-	writer->SetFileName(cstring_cast(filename));
-	writer->SetCompression(false);
-	writer->Write();
+	MetaImageIO::write(filename, mask);
 }
 
 
@@ -11,6 +11,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxCyclicActionLogger.h"
 #include <numeric>
+#include <algorithm>
 #include <sstream>
 #include <QStringList>
 #include "cxTypeConversions.h"
@@ -64,6 +65,21 @@ void CyclicActionLogger::time(QString id)
 	  mTiming.push_back(newEntry);
 }
 
+void CyclicActionLogger::add(QString id, double time)
+{
+	std::vector<Entry>::iterator entry = this->getTimingVectorIterator(id);
+	if (entry != mTiming.end())
+	{
+		entry->time.push_back(time);
+		return;
+	}
+
+	Entry newEntry;
+	newEntry.id = id;
+	newEntry.time.push_back(time);
+	mTiming.push_back(newEntry);
+}
+
 /** return frames per second during the last interval.
  */
 double CyclicActionLogger::getFPS()
@@ -202,4 +218,32 @@ int CyclicActionLogger::getTotalLoggedTime()
 	return totalTime;
 }
 
+std::vector<int> CyclicActionLogger::getHistogram(QString id, std::vector<double> limits)
+{
+	std::vector<int> retval(limits.size()+1, 0);
+	std::vector<Entry>::iterator entry = this->getTimingVectorIterator(id);
+	if (entry == mTiming.end())
+		return retval;
+
+	std::sort(limits.begin(), limits.end());
+	for (unsigned i=0; i<entry->time.size(); ++i)
+	{
+		int bin = std::upper_bound(limits.begin(), limits.end(), entry->time[i]) - limits.begin();
+		++retval[bin];
+	}
+	return retval;
+}
+
+QString CyclicActionLogger::dumpHistogram(QString id, std::vector<double> limits)
+{
+	std::sort(limits.begin(), limits.end());
+	std::vector<int> histogram = this->getHistogram(id, limits);
+	QStringList bins;
+	for (unsigned i=0; i<limits.size(); ++i)
+		bins << QString("<%1:%2").arg(limits[i]).arg(histogram[i]);
+	if (!limits.empty())
+		bins << QString(">=%1:%2").arg(limits.back()).arg(histogram.back());
+	return QString("%1 %2 ms: %3").arg(mName).arg(id).arg(bins.join(" "));
+}
+
 } // namespace cx
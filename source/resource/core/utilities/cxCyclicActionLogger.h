@@ -42,6 +42,7 @@ public:
 
 	void begin(); ///< start timing for this cycle
 	void time(QString id); ///< store time from begin or last time()
+	void add(QString id, double time); ///< store a time measured elsewhere, e.g. a latency
 
 	double getFPS();
 	bool intervalPassed() const;
@@ -50,6 +51,8 @@ public:
 
 	int getTime(QString id);
 	int getTotalLoggedTime();///< Total time contained in entered id's (id outside is not counted)
+	std::vector<int> getHistogram(QString id, std::vector<double> limits); ///< count of times below limits[0], in [limits[i-1],limits[i]), ..., and at or above the last limit
+	QString dumpHistogram(QString id, std::vector<double> limits);
 
 private:
 	QString mName;
@@ -15,6 +15,12 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <vtkPoints.h>
 #include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkSmartPointer.h>
+#include <string.h>
 
 #include "cxPatientModelService.h"
 #include "cxMesh.h"
@@ -56,6 +62,155 @@ vtkPolyDataPtr polydataFromTransforms(TimedTransformMap transformMap_prMt, Trans
   return retval;
 }
 
+namespace
+{
+template<class T>
+void transformBlock(const T* input, T* output, vtkIdType count, const Eigen::Matrix3d& A, const Vector3D& t, bool normals)
+{
+	for (vtkIdType i=0; i<count; ++i, input+=3, output+=3)
+	{
+		Vector3D p = A*Vector3D(input[0], input[1], input[2]) + t;
+		if (normals && p.norm() > 0)
+			p.normalize();
+		output[0] = T(p[0]);
+		output[1] = T(p[1]);
+		output[2] = T(p[2]);
+	}
+}
+
+/** Replace the normals attribute of data with a transformed copy. */
+void transformNormals(vtkDataSetAttributes* data, const Transform3D& transform)
+{
+	vtkDataArray* normals = data->GetNormals();
+	if (!normals || normals->GetNumberOfComponents() != 3)
+		return;
+	vtkDataArrayPtr transformed = vtkDataArrayPtr::Take(normals->NewInstance());
+	transformed->SetName(normals->GetName());
+	transformed->SetNumberOfComponents(3);
+	transformed->SetNumberOfTuples(normals->GetNumberOfTuples());
+	transformTuples(normals, 0, normals->GetNumberOfTuples(), transform, true, transformed->GetVoidPointer(0));
+	data->SetNormals(transformed);
+}
+} // namespace
+
+void transformTuples(vtkDataArray* input, vtkIdType begin, vtkIdType end, const Transform3D& transform, bool normals, void* output)
+{
+	Eigen::Matrix3d A = transform.linear();
+	Vector3D t = transform.translation();
+	if (normals)
+	{
+		A = A.inverse().transpose().eval();
+		t = Vector3D::Zero();
+	}
+
+	vtkIdType count = end - begin;
+	int type = input->GetDataType();
+	if (input->GetNumberOfComponents() == 3 && type == VTK_FLOAT)
+		transformBlock(static_cast<const float*>(input->GetVoidPointer(3*begin)), static_cast<float*>(output), count, A, t, normals);
+	else if (input->GetNumberOfComponents() == 3 && type == VTK_DOUBLE)
+		transformBlock(static_cast<const double*>(input->GetVoidPointer(3*begin)), static_cast<double*>(output), count, A, t, normals);
+	else
+		memcpy(output, input->GetVoidPointer(begin*input->GetNumberOfComponents()),
+			   count*input->GetNumberOfComponents()*input->GetDataTypeSize());
+}
+
+vtkPolyDataPtr createTransformedPolyData(vtkPolyDataPtr poly, const Transform3D& transform)
+{
+	vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+	retval->ShallowCopy(poly);
+	if (similar(transform, Transform3D::Identity()) || !poly->GetPoints())
+		return retval;
+
+	vtkDataArray* points = poly->GetPoints()->GetData();
+	vtkPointsPtr transformed = vtkPointsPtr::New();
+	if (points->GetDataType() == VTK_FLOAT || points->GetDataType() == VTK_DOUBLE)
+	{
+		transformed->SetDataType(points->GetDataType());
+		transformed->SetNumberOfPoints(points->GetNumberOfTuples());
+		transformTuples(points, 0, points->GetNumberOfTuples(), transform, false, transformed->GetVoidPointer(0));
+	}
+	else
+	{
+		transformed->SetDataTypeToDouble();
+		transformed->SetNumberOfPoints(points->GetNumberOfTuples());
+		for (vtkIdType i=0; i<points->GetNumberOfTuples(); ++i)
+			transformed->SetPoint(i, transform.coord(Vector3D(poly->GetPoint(i))).data());
+	}
+	retval->SetPoints(transformed);
+
+	transformNormals(retval->GetPointData(), transform);
+	transformNormals(retval->GetCellData(), transform);
+	return retval;
+}
+
+namespace
+{
+bool isShared(vtkObjectBase* object)
+{
+	return object && object->GetReferenceCount() > 1;
+}
+
+vtkCellArrayPtr detachCells(vtkCellArray* cells)
+{
+	if (!isShared(cells) && !isShared(cells->GetData()))
+		return cells;
+	vtkCellArrayPtr retval = vtkCellArrayPtr::New();
+	retval->DeepCopy(cells);
+	return retval;
+}
+
+void detachArrays(vtkDataSetAttributes* data)
+{
+	bool sharedUnnamed = false;
+	for (int i=0; i<data->GetNumberOfArrays(); ++i)
+	{
+		vtkAbstractArray* array = data->GetAbstractArray(i);
+		if (!isShared(array))
+			continue;
+		if (!array->GetName())
+		{
+			sharedUnnamed = true;
+			continue;
+		}
+		vtkSmartPointer<vtkAbstractArray> copy = vtkSmartPointer<vtkAbstractArray>::Take(array->NewInstance());
+		copy->DeepCopy(array);
+		data->AddArray(copy); // replaces the array with the same name, keeping the index and thus the attributes
+	}
+
+	// unnamed arrays cannot be replaced in place, copy all
+	if (sharedUnnamed)
+	{
+		vtkSmartPointer<vtkDataSetAttributes> shared = vtkSmartPointer<vtkDataSetAttributes>::Take(data->NewInstance());
+		shared->ShallowCopy(data);
+		data->DeepCopy(shared);
+	}
+}
+} // namespace
+
+void detachSharedArrays(vtkPolyDataPtr poly)
+{
+	if (!poly)
+		return;
+	vtkPoints* points = poly->GetPoints();
+	if (points && (isShared(points) || isShared(points->GetData())))
+	{
+		vtkPointsPtr copy = vtkPointsPtr::New();
+		copy->DeepCopy(points);
+		poly->SetPoints(copy);
+	}
+	if (poly->GetVerts())
+		poly->SetVerts(detachCells(poly->GetVerts()));
+	if (poly->GetLines())
+		poly->SetLines(detachCells(poly->GetLines()));
+	if (poly->GetPolys())
+		poly->SetPolys(detachCells(poly->GetPolys()));
+	if (poly->GetStrips())
+		poly->SetStrips(detachCells(poly->GetStrips()));
+	detachArrays(poly->GetPointData());
+	detachArrays(poly->GetCellData());
+	poly->Modified();
+}
+
 void loadMeshFromToolTransforms(PatientModelServicePtr dataManager, TimedTransformMap transforms_prMt)
 {
   //create polydata from positions
@@ -94,6 +249,7 @@ std::map<std::string, std::string> getDisplayFriendlyInfo(MeshPtr mesh)
 	//vtkPolyData
 	float actualMemorySizeKB = (float)mesh->getVtkPolyData()->GetActualMemorySize();
 	retval["Actual memory size"] = string_cast(actualMemorySizeKB/(1024*1024))+" GB, "+string_cast(actualMemorySizeKB/1024)+" MB, "+string_cast(actualMemorySizeKB)+" kB";
+	retval["Memory used"] = string_cast(mesh->getMemoryUsage()/1024)+" kB";
 	retval["Points"] = string_cast(mesh->getVtkPolyData()->GetNumberOfPoints());
 	retval["Lines"] = string_cast(mesh->getVtkPolyData()->GetNumberOfLines());
 	retval["Pieces"] = string_cast(mesh->getVtkPolyData()->GetNumberOfPieces());
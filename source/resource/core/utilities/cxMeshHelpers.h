@@ -37,6 +37,29 @@ namespace cx
 cxResource_EXPORT vtkPolyDataPtr polydataFromTransforms(TimedTransformMap transformMap_prMt, Transform3D rMpr);
 cxResource_EXPORT void loadMeshFromToolTransforms(PatientModelServicePtr dataManager, TimedTransformMap transforms_prMt);
 
+/**
+ * Transform the 3-component tuples [begin, end) of input into output, which
+ * has the same data type. Points are transformed as coordinates, normals
+ * with the inverse transpose and normalized. Other types are copied as is.
+ */
+cxResource_EXPORT void transformTuples(vtkDataArray* input, vtkIdType begin, vtkIdType end, const Transform3D& transform, bool normals, void* output);
+
+/**
+ * A transformed copy of poly that shares the cells and data arrays with poly.
+ * Only the points and normals are copied. Replacing arrays in the copy is
+ * safe, writing into the shared arrays changes poly as well.
+ */
+cxResource_EXPORT vtkPolyDataPtr createTransformedPolyData(vtkPolyDataPtr poly, const Transform3D& transform);
+
+/**
+ * Copy on write for polydata sharing arrays, e.g. with the result of
+ * createTransformedPolyData(): deep copy the points, cells and data arrays
+ * of poly that are referenced elsewhere, so that poly can be modified in
+ * place without changing the other users. Arrays used by poly only are
+ * kept as they are.
+ */
+cxResource_EXPORT void detachSharedArrays(vtkPolyDataPtr poly);
+
 /**
  * Get information about a ssc mesh.
  */
@@ -0,0 +1,489 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMeshIO.h"
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <string.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QBuffer>
+#include <QDataStream>
+#include <QSysInfo>
+#include <QtConcurrent>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include "cxMeshHelpers.h"
+#include "cxLogger.h"
+#include "cxTracer.h"
+
+namespace cx
+{
+
+namespace
+{
+const char magic[8] = { 'C', 'X', 'M', 'E', 'S', 'H', '0', '1' };
+const qint64 alignment = 64;
+const qint64 copyChunkSize = 16*1024*1024;
+const qint64 writeChunkSize = 64*1024*1024;
+const vtkIdType transformBlockSize = 64*1024; ///< tuples
+const qint32 maxComponents = 1<<16;
+
+enum SectionKind
+{
+	skPOINTS,
+	skVERTS,
+	skLINES,
+	skPOLYS,
+	skSTRIPS,
+	skPOINT_DATA,
+	skCELL_DATA,
+	skCOUNT
+};
+
+struct Section
+{
+	Section() : kind(skPOINTS), dataType(0), numComponents(1), attribute(-1),
+		numTuples(0), numCells(0), offset(0), normals(false) {}
+	qint32 kind;
+	qint32 dataType;
+	qint32 numComponents;
+	qint32 attribute; ///< vtkDataSetAttributes::AttributeTypes, -1 if none
+	qint64 numTuples;
+	qint64 numCells; ///< for cell arrays
+	qint64 offset;
+	QByteArray name;
+	vtkDataArrayPtr array;
+	bool normals; ///< transform as normals
+
+	qint64 getSizeInBytes(int idSize) const
+	{
+		int typeSize = (dataType == VTK_ID_TYPE) ? idSize : vtkDataArray::GetDataTypeSize(dataType);
+		return numTuples*numComponents*typeSize;
+	}
+};
+
+qint64 align(qint64 pos)
+{
+	return (pos + alignment - 1)/alignment*alignment;
+}
+
+bool isLittleEndianHost()
+{
+	if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
+		return true;
+	CX_LOG_WARNING() << "MeshIO: Only little endian hosts are supported";
+	return false;
+}
+
+void addCells(std::vector<Section>* sections, SectionKind kind, vtkCellArray* cells)
+{
+	if (!cells || !cells->GetNumberOfCells())
+		return;
+	Section section;
+	section.kind = kind;
+	section.array = cells->GetData();
+	section.dataType = VTK_ID_TYPE;
+	section.numTuples = section.array->GetNumberOfTuples();
+	section.numCells = cells->GetNumberOfCells();
+	sections->push_back(section);
+}
+
+void addArrays(std::vector<Section>* sections, SectionKind kind, vtkDataSetAttributes* data, bool transform)
+{
+	for (int i=0; i<data->GetNumberOfArrays(); ++i)
+	{
+		vtkDataArray* array = data->GetArray(i);
+		if (!array)
+			continue; // not numeric
+		Section section;
+		section.kind = kind;
+		section.array = array;
+		section.dataType = array->GetDataType();
+		section.numComponents = array->GetNumberOfComponents();
+		section.numTuples = array->GetNumberOfTuples();
+		section.attribute = data->IsArrayAnAttribute(i);
+		section.name = array->GetName() ? QByteArray(array->GetName()) : QByteArray();
+		section.normals = transform && section.attribute == vtkDataSetAttributes::NORMALS && section.numComponents == 3;
+		sections->push_back(section);
+	}
+}
+
+std::vector<Section> createSections(vtkPolyDataPtr poly, bool transform)
+{
+	std::vector<Section> retval;
+	if (poly->GetPoints() && poly->GetNumberOfPoints())
+	{
+		Section points;
+		points.array = poly->GetPoints()->GetData();
+		points.dataType = points.array->GetDataType();
+		points.numComponents = 3;
+		points.numTuples = poly->GetNumberOfPoints();
+		retval.push_back(points);
+	}
+	addCells(&retval, skVERTS, poly->GetVerts());
+	addCells(&retval, skLINES, poly->GetLines());
+	addCells(&retval, skPOLYS, poly->GetPolys());
+	addCells(&retval, skSTRIPS, poly->GetStrips());
+	addArrays(&retval, skPOINT_DATA, poly->GetPointData(), transform);
+	addArrays(&retval, skCELL_DATA, poly->GetCellData(), transform);
+	return retval;
+}
+
+QByteArray createTable(const std::vector<Section>& sections)
+{
+	QByteArray retval;
+	QDataStream stream(&retval, QIODevice::WriteOnly);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.writeRawData(magic, sizeof(magic));
+	stream << qint32(sizeof(vtkIdType)) << qint32(sections.size());
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		const Section& s = sections[i];
+		stream << s.kind << s.dataType << s.numComponents << s.attribute;
+		stream << s.numTuples << s.numCells << s.offset << s.name;
+	}
+	return retval;
+}
+
+bool isNumericType(int dataType)
+{
+	if (dataType == VTK_ID_TYPE)
+		return true;
+	return dataType != VTK_BIT && vtkDataArray::GetDataTypeSize(dataType) > 0;
+}
+
+/** Check the section header against the file size, without overflow
+ *  for any values read from the file.
+ */
+bool isValidSection(const Section& s, qint64 fileSize, int idSize)
+{
+	if (s.kind < 0 || s.kind >= skCOUNT || !isNumericType(s.dataType))
+		return false;
+	if (s.numComponents < 1 || s.numComponents > maxComponents)
+		return false;
+	if (s.numTuples < 0 || s.numCells < 0 || s.offset < 0 || s.offset > fileSize)
+		return false;
+
+	bool isCells = (s.kind >= skVERTS && s.kind <= skSTRIPS);
+	if (isCells && (s.dataType != VTK_ID_TYPE || s.numComponents != 1 || s.numCells > s.numTuples))
+		return false;
+	if (s.kind == skPOINTS && s.numComponents != 3)
+		return false;
+
+	qint64 typeSize = (s.dataType == VTK_ID_TYPE) ? idSize : vtkDataArray::GetDataTypeSize(s.dataType);
+	qint64 tupleSize = s.numComponents*typeSize;
+	return s.numTuples <= (fileSize - s.offset)/tupleSize;
+}
+
+/** Check the sizes of the sections against each other.
+ */
+bool isConsistent(const std::vector<Section>& sections, qint64* numPoints)
+{
+	int pointSections = 0;
+	qint64 numCells = 0;
+	*numPoints = 0;
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		if (sections[i].kind == skPOINTS)
+		{
+			++pointSections;
+			*numPoints = sections[i].numTuples;
+		}
+		else if (sections[i].kind != skPOINT_DATA && sections[i].kind != skCELL_DATA)
+			numCells += sections[i].numCells;
+	}
+	if (pointSections > 1)
+		return false;
+
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		if (sections[i].kind == skPOINT_DATA && sections[i].numTuples != *numPoints)
+			return false;
+		if (sections[i].kind == skCELL_DATA && sections[i].numTuples != numCells)
+			return false;
+	}
+	return true;
+}
+
+/** Check that the cell array [n, id_0 .. id_n-1, n, ...] holds
+ *  numCells cells with point ids in [0, numPoints).
+ */
+bool isValidCells(vtkIdTypeArray* cells, qint64 numCells, qint64 numPoints)
+{
+	const vtkIdType* data = cells->GetPointer(0);
+	vtkIdType size = cells->GetNumberOfTuples();
+	vtkIdType pos = 0;
+	for (qint64 i=0; i<numCells; ++i)
+	{
+		if (pos >= size)
+			return false;
+		vtkIdType n = data[pos++];
+		if (n < 0 || n > size-pos)
+			return false;
+		for (vtkIdType j=0; j<n; ++j, ++pos)
+			if (data[pos] < 0 || data[pos] >= numPoints)
+				return false;
+	}
+	return pos == size;
+}
+
+bool readTable(const char* data, qint64 size, std::vector<Section>* sections, int* idSize)
+{
+	QByteArray raw = QByteArray::fromRawData(data, int(std::min<qint64>(size, std::numeric_limits<int>::max())));
+	QBuffer buffer(&raw);
+	buffer.open(QIODevice::ReadOnly);
+	QDataStream stream(&buffer);
+	stream.setByteOrder(QDataStream::LittleEndian);
+
+	char fileMagic[sizeof(magic)];
+	if (stream.readRawData(fileMagic, sizeof(magic)) != sizeof(magic) || memcmp(fileMagic, magic, sizeof(magic)) != 0)
+		return false;
+	qint32 count = 0;
+	stream >> *idSize >> count;
+	if ((*idSize != 4 && *idSize != 8) || count < 0)
+		return false;
+
+	for (qint32 i=0; i<count && stream.status() == QDataStream::Ok; ++i)
+	{
+		Section s;
+		stream >> s.kind >> s.dataType >> s.numComponents >> s.attribute;
+		stream >> s.numTuples >> s.numCells >> s.offset >> s.name;
+		if (!isValidSection(s, size, *idSize))
+			return false;
+		sections->push_back(s);
+	}
+	return stream.status() == QDataStream::Ok;
+}
+
+bool writeSection(QFile* file, const Section& section, const Transform3D& transform, bool transformPoints)
+{
+	if (file->pos() < section.offset && file->write(QByteArray(section.offset-file->pos(), 0)) < 0)
+		return false;
+
+	bool transformSection = (section.kind == skPOINTS && transformPoints) || section.normals;
+	if (transformSection)
+	{
+		std::vector<char> buffer(transformBlockSize*section.numComponents*section.array->GetDataTypeSize());
+		for (vtkIdType begin=0; begin<section.numTuples; begin+=transformBlockSize)
+		{
+			vtkIdType end = std::min(begin+transformBlockSize, vtkIdType(section.numTuples));
+			transformTuples(section.array, begin, end, transform, section.normals, &buffer[0]);
+			qint64 count = (end-begin)*section.numComponents*section.array->GetDataTypeSize();
+			if (file->write(&buffer[0], count) != count)
+				return false;
+		}
+		return true;
+	}
+
+	const char* data = static_cast<const char*>(section.array->GetVoidPointer(0));
+	qint64 size = section.getSizeInBytes(sizeof(vtkIdType));
+	for (qint64 pos=0; pos<size; pos+=writeChunkSize)
+	{
+		qint64 count = std::min(writeChunkSize, size-pos);
+		if (file->write(data + pos, count) != count)
+			return false;
+	}
+	return true;
+}
+
+/** Copy a range of a section from the file to its array,
+ *  converting ids if the file was written with another id size. */
+struct Job
+{
+	const char* input;
+	char* output;
+	qint64 count; ///< values
+	int inputSize; ///< bytes per value
+	int outputSize;
+};
+
+template<class IN, class OUT>
+void convert(const Job& job)
+{
+	const IN* in = reinterpret_cast<const IN*>(job.input);
+	OUT* out = reinterpret_cast<OUT*>(job.output);
+	for (qint64 i=0; i<job.count; ++i)
+		out[i] = OUT(in[i]);
+}
+
+void copyJob(const Job& job)
+{
+	if (job.inputSize == job.outputSize)
+		memcpy(job.output, job.input, job.count*job.inputSize);
+	else if (job.inputSize == 4)
+		convert<qint32, qint64>(job);
+	else
+		convert<qint64, qint32>(job);
+}
+
+void addCopyJobs(std::vector<Job>* jobs, const char* input, char* output, qint64 count, int inputSize, int outputSize)
+{
+	qint64 chunk = copyChunkSize/std::max(inputSize, outputSize);
+	for (qint64 pos=0; pos<count; pos+=chunk)
+	{
+		Job job;
+		job.input = input + pos*inputSize;
+		job.output = output + pos*outputSize;
+		job.count = std::min(chunk, count-pos);
+		job.inputSize = inputSize;
+		job.outputSize = outputSize;
+		jobs->push_back(job);
+	}
+}
+
+vtkCellArrayPtr createCells(const Section& section)
+{
+	vtkCellArrayPtr retval = vtkCellArrayPtr::New();
+	retval->SetCells(section.numCells, vtkIdTypeArray::SafeDownCast(section.array));
+	return retval;
+}
+
+} // namespace
+
+vtkPolyDataPtr MeshIO::read(QString filename)
+{
+	CX_TRACE_SCOPE("io", "read mesh");
+	if (!isLittleEndianHost())
+		return vtkPolyDataPtr();
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		CX_LOG_WARNING() << "MeshIO: Failed to open " << filename;
+		return vtkPolyDataPtr();
+	}
+
+	qint64 size = file.size();
+	const char* data = reinterpret_cast<const char*>(file.map(0, size));
+	QByteArray buffer;
+	if (!data)
+	{
+		buffer = file.readAll(); // mapping not supported
+		data = buffer.constData();
+		size = buffer.size();
+	}
+
+	std::vector<Section> sections;
+	int idSize = 0;
+	qint64 numPoints = 0;
+	if (!readTable(data, size, &sections, &idSize) || !isConsistent(sections, &numPoints))
+	{
+		CX_LOG_WARNING() << "MeshIO: " << filename << " is not a valid mesh file";
+		return vtkPolyDataPtr();
+	}
+
+	// allocate all arrays, then fill them in parallel
+	std::vector<Job> jobs;
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		Section& s = sections[i];
+		s.array = vtkDataArrayPtr::Take(vtkDataArray::CreateDataArray(s.dataType));
+		if (!s.array)
+			return vtkPolyDataPtr();
+		s.array->SetNumberOfComponents(s.numComponents);
+		s.array->SetNumberOfTuples(s.numTuples);
+		if (!s.name.isEmpty())
+			s.array->SetName(s.name.constData());
+		int inputSize = (s.dataType == VTK_ID_TYPE) ? idSize : s.array->GetDataTypeSize();
+		addCopyJobs(&jobs, data + s.offset, static_cast<char*>(s.array->GetVoidPointer(0)),
+					s.numTuples*s.numComponents, inputSize, s.array->GetDataTypeSize());
+	}
+	QtConcurrent::blockingMap(jobs, &copyJob);
+
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		const Section& s = sections[i];
+		if (s.kind >= skVERTS && s.kind <= skSTRIPS
+				&& !isValidCells(vtkIdTypeArray::SafeDownCast(s.array), s.numCells, numPoints))
+		{
+			CX_LOG_WARNING() << "MeshIO: " << filename << " has invalid cells";
+			return vtkPolyDataPtr();
+		}
+	}
+
+	vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		Section& s = sections[i];
+		if (s.kind == skPOINTS)
+		{
+			vtkPointsPtr points = vtkPointsPtr::New();
+			points->SetData(s.array);
+			retval->SetPoints(points);
+		}
+		else if (s.kind == skVERTS)
+			retval->SetVerts(createCells(s));
+		else if (s.kind == skLINES)
+			retval->SetLines(createCells(s));
+		else if (s.kind == skPOLYS)
+			retval->SetPolys(createCells(s));
+		else if (s.kind == skSTRIPS)
+			retval->SetStrips(createCells(s));
+		else
+		{
+			vtkDataSetAttributes* attributes = (s.kind == skPOINT_DATA)
+					? static_cast<vtkDataSetAttributes*>(retval->GetPointData())
+					: static_cast<vtkDataSetAttributes*>(retval->GetCellData());
+			int index = attributes->AddArray(s.array);
+			if (s.attribute >= 0)
+				attributes->SetActiveAttribute(index, s.attribute);
+		}
+	}
+	return retval;
+}
+
+bool MeshIO::write(QString filename, vtkPolyDataPtr poly, const Transform3D& transform)
+{
+	CX_TRACE_SCOPE("io", "write mesh");
+	if (!poly || !isLittleEndianHost())
+		return false;
+
+	bool transformPoints = !similar(transform, Transform3D::Identity());
+	if (transformPoints && poly->GetPoints())
+	{
+		int type = poly->GetPoints()->GetDataType();
+		if (type != VTK_FLOAT && type != VTK_DOUBLE)
+			return write(filename, createTransformedPolyData(poly, transform)); // rare, convert in memory
+	}
+
+	std::vector<Section> sections = createSections(poly, transformPoints);
+	qint64 pos = align(createTable(sections).size()); // offsets do not change the table size
+	for (unsigned i=0; i<sections.size(); ++i)
+	{
+		sections[i].offset = pos;
+		pos = align(pos + sections[i].getSizeInBytes(sizeof(vtkIdType)));
+	}
+
+	QDir().mkpath(QFileInfo(filename).absolutePath());
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "MeshIO: Failed to write " << filename;
+		return false;
+	}
+	QByteArray table = createTable(sections);
+	bool ok = file.write(table) == table.size();
+	for (unsigned i=0; ok && i<sections.size(); ++i)
+		ok = writeSection(&file, sections[i], transform, transformPoints);
+	if (!ok)
+		CX_LOG_WARNING() << "MeshIO: Failed to write " << filename;
+	return ok;
+}
+
+} // namespace cx
@@ -0,0 +1,54 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXMESHIO_H
+#define CXMESHIO_H
+
+#include "cxResourceExport.h"
+
+#include <QString>
+#include "vtkForwardDeclarations.h"
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+/** \brief Fast binary file format for meshes.
+ *
+ * A .cxmesh file holds the points, cells and point/cell data arrays of a
+ * vtkPolyData as raw arrays after a small table of contents:
+ *
+ *   "CXMESH01", id size, section count,
+ *   one entry per section: kind, data type, components, attribute,
+ *                          tuples, cells, offset, name
+ *   the sections, each aligned to 64 bytes
+ *
+ * read() maps the file and copies the sections in parallel.
+ * write() streams the arrays directly from the polydata, transforming the
+ * points and normals block by block, without copying the mesh.
+ *
+ * Cells are stored in the vtkCellArray legacy layout (n, id0, id1, ...).
+ * The table is little endian, the arrays are in host byte order.
+ *
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT MeshIO
+{
+public:
+	static QString getFileEnding() { return "cxmesh"; }
+	static vtkPolyDataPtr read(QString filename); ///< zero on failure
+	/** Write poly transformed by transform. */
+	static bool write(QString filename, vtkPolyDataPtr poly, const Transform3D& transform = Transform3D::Identity());
+};
+
+} // namespace cx
+
+#endif // CXMESHIO_H
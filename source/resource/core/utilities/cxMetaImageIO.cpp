@@ -0,0 +1,594 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMetaImageIO.h"
+
+#include <map>
+#include <algorithm>
+#include <string.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QtConcurrent>
+#include <vtkImageData.h>
+#include <vtkDataArray.h>
+#include <vtk_zlib.h>
+#include "cxLogger.h"
+#include "cxTracer.h"
+
+namespace cx
+{
+
+namespace
+{
+const qint64 copyChunkSize = 16*1024*1024;
+const qint64 writeChunkSize = 64*1024*1024;
+const qint64 maxZlibBlock = 1<<30; // zlib counts bytes in uInt
+const char zlibHeader[2] = { 0x78, 0x01 }; // deflate, 32K window, fastest
+
+bool isTrue(QString value)
+{
+	return value.compare("True", Qt::CaseInsensitive) == 0 || value == "1";
+}
+
+QString toString(const double* values)
+{
+	return QString("%1 %2 %3").arg(values[0], 0, 'g', 17).arg(values[1], 0, 'g', 17).arg(values[2], 0, 'g', 17);
+}
+
+/** A piece of work on a range of bytes. */
+struct Job
+{
+	Job() : input(NULL), inputSize(0), output(NULL), outputSize(0), adler(0), last(false), ok(false) {}
+	const char* input;
+	qint64 inputSize;
+	char* output;
+	qint64 outputSize;
+	std::vector<char> buffer; ///< compressed output
+	uLong adler; ///< checksum of the uncompressed bytes
+	bool last; ///< last chunk of a stream
+	bool ok;
+};
+
+std::vector<Job> splitCopy(const char* input, char* output, qint64 size)
+{
+	std::vector<Job> retval;
+	for (qint64 pos=0; pos<size; pos+=copyChunkSize)
+	{
+		Job job;
+		job.input = input + pos;
+		job.output = output + pos;
+		job.inputSize = job.outputSize = std::min(copyChunkSize, size-pos);
+		retval.push_back(job);
+	}
+	return retval;
+}
+
+void copyJob(Job& job)
+{
+	memcpy(job.output, job.input, job.inputSize);
+}
+
+void swapJob(Job& job, int size)
+{
+	for (qint64 i=0; i+size<=job.outputSize; i+=size)
+		std::reverse(job.output+i, job.output+i+size);
+}
+
+/** Compress one chunk as raw deflate data. All chunks except the last end
+ *  on a byte boundary after a sync flush, thus the chunks can be joined
+ *  into one stream, and each chunk can be inflated on its own.
+ */
+void deflateJob(Job& job)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (deflateInit2(&stream, MetaImageIO::compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+	job.buffer.resize(deflateBound(&stream, uLong(job.inputSize)) + 16); // room for the flush marker
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(job.input));
+	stream.avail_in = uInt(job.inputSize);
+	stream.next_out = reinterpret_cast<Bytef*>(&job.buffer[0]);
+	stream.avail_out = uInt(job.buffer.size());
+
+	int ret = deflate(&stream, job.last ? Z_FINISH : Z_SYNC_FLUSH);
+	job.ok = stream.avail_in == 0 && stream.avail_out > 0 && (job.last ? ret == Z_STREAM_END : ret == Z_OK);
+	job.buffer.resize(stream.total_out);
+	deflateEnd(&stream);
+
+	job.adler = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(job.input), uInt(job.inputSize));
+}
+
+/** Inflate one chunk written by deflateJob().
+ */
+void inflateJob(Job& job)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		return;
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(job.input));
+	stream.avail_in = uInt(job.inputSize);
+	stream.next_out = reinterpret_cast<Bytef*>(job.output);
+	stream.avail_out = uInt(job.outputSize);
+
+	int ret = inflate(&stream, Z_SYNC_FLUSH);
+	job.ok = (ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR) && stream.avail_out == 0;
+	inflateEnd(&stream);
+
+	job.adler = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(job.output), uInt(job.outputSize));
+}
+
+/** Inflate a zlib or gzip stream, single threaded.
+ */
+bool inflateStream(const char* input, qint64 inputSize, char* output, qint64 outputSize)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, MAX_WBITS+32) != Z_OK) // detect zlib or gzip header
+		return false;
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+	stream.next_out = reinterpret_cast<Bytef*>(output);
+
+	int ret = Z_OK;
+	qint64 produced = 0;
+	while (ret == Z_OK)
+	{
+		qint64 consumed = reinterpret_cast<const char*>(stream.next_in) - input;
+		produced = reinterpret_cast<char*>(stream.next_out) - output;
+		if (produced == outputSize)
+			break;
+		stream.avail_in = uInt(std::min(inputSize-consumed, maxZlibBlock));
+		stream.avail_out = uInt(std::min(outputSize-produced, maxZlibBlock));
+		ret = inflate(&stream, Z_NO_FLUSH);
+	}
+	produced = reinterpret_cast<char*>(stream.next_out) - output;
+	inflateEnd(&stream);
+	return produced == outputSize;
+}
+
+quint32 readBigEndian(const char* data)
+{
+	const unsigned char* d = reinterpret_cast<const unsigned char*>(data);
+	return (quint32(d[0])<<24) | (quint32(d[1])<<16) | (quint32(d[2])<<8) | quint32(d[3]);
+}
+
+void writeBigEndian(quint32 value, char* data)
+{
+	for (int i=0; i<4; ++i)
+		data[i] = char((value >> (24-8*i)) & 0xff);
+}
+
+/** Inflate the chunks listed in header in parallel, and check the stream checksum.
+ *  Return false if the chunk list does not match the stream.
+ */
+bool inflateChunks(const char* input, qint64 inputSize, char* output, qint64 outputSize, const MetaImageIO::Header& header)
+{
+	if (header.chunkSize > maxZlibBlock || (input[0] & 0x0f) != Z_DEFLATED)
+		return false;
+	qint64 numChunks = (outputSize + header.chunkSize - 1)/header.chunkSize;
+	if (qint64(header.chunks.size()) != numChunks)
+		return false;
+
+	std::vector<Job> jobs(numChunks);
+	qint64 pos = 2; // zlib header
+	for (qint64 i=0; i<numChunks; ++i)
+	{
+		jobs[i].input = input + pos;
+		jobs[i].inputSize = header.chunks[i];
+		jobs[i].output = output + i*header.chunkSize;
+		jobs[i].outputSize = std::min(header.chunkSize, outputSize - i*header.chunkSize);
+		pos += header.chunks[i];
+		if (header.chunks[i] < 0 || header.chunks[i] > maxZlibBlock || pos+4 > inputSize)
+			return false;
+	}
+
+	QtConcurrent::blockingMap(jobs, &inflateJob);
+
+	uLong adler = adler32(0L, Z_NULL, 0);
+	for (unsigned i=0; i<jobs.size(); ++i)
+	{
+		if (!jobs[i].ok)
+			return false;
+		adler = adler32_combine(adler, jobs[i].adler, jobs[i].outputSize);
+	}
+	return readBigEndian(input + pos) == quint32(adler);
+}
+
+/** Write data as one zlib stream, compressing chunks in parallel.
+ *  The chunk list is stored in header.
+ */
+bool writeCompressed(QFile* file, const char* data, qint64 size, MetaImageIO::Header* header)
+{
+	header->chunkSize = MetaImageIO::defaultChunkSize;
+	header->chunks.clear();
+	if (file->write(zlibHeader, 2) != 2)
+		return false;
+	qint64 written = 2;
+
+	// compress a few chunks per thread at a time, to bound the memory used
+	const qint64 batchSize = qint64(std::max(QThread::idealThreadCount(), 1))*4*header->chunkSize;
+	uLong adler = adler32(0L, Z_NULL, 0);
+	for (qint64 batchStart=0; batchStart<size; batchStart+=batchSize)
+	{
+		std::vector<Job> jobs;
+		qint64 batchEnd = std::min(batchStart+batchSize, size);
+		for (qint64 pos=batchStart; pos<batchEnd; pos+=header->chunkSize)
+		{
+			Job job;
+			job.input = data + pos;
+			job.inputSize = std::min(header->chunkSize, size-pos);
+			job.last = (pos + job.inputSize == size);
+			jobs.push_back(job);
+		}
+
+		QtConcurrent::blockingMap(jobs, &deflateJob);
+
+		for (unsigned i=0; i<jobs.size(); ++i)
+		{
+			qint64 count = jobs[i].buffer.size();
+			if (!jobs[i].ok || file->write(&jobs[i].buffer[0], count) != count)
+				return false;
+			header->chunks.push_back(count);
+			written += count;
+			adler = adler32_combine(adler, jobs[i].adler, jobs[i].inputSize);
+		}
+	}
+
+	char trailer[4];
+	writeBigEndian(quint32(adler), trailer);
+	if (file->write(trailer, 4) != 4)
+		return false;
+	header->compressedSize = written + 4;
+	return true;
+}
+
+bool writeRaw(QFile* file, const char* data, qint64 size)
+{
+	for (qint64 pos=0; pos<size; pos+=writeChunkSize)
+	{
+		qint64 count = std::min(writeChunkSize, size-pos);
+		if (file->write(data + pos, count) != count)
+			return false;
+	}
+	return true;
+}
+
+bool readRaw(QFile* file, qint64 offset, char* data, qint64 size)
+{
+	if (!file->seek(offset))
+		return false;
+	for (qint64 pos=0; pos<size; pos+=writeChunkSize)
+	{
+		qint64 count = std::min(writeChunkSize, size-pos);
+		if (file->read(data + pos, count) != count)
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+MetaImageIO::Header::Header() :
+	scalarType(0),
+	numComps(1),
+	msb(false),
+	compressed(false),
+	compressedSize(-1),
+	chunkSize(0),
+	headerSize(0)
+{
+	for (int i=0; i<3; ++i)
+	{
+		dim[i] = 1;
+		spacing[i] = 1;
+		origin[i] = 0;
+	}
+}
+
+int MetaImageIO::Header::getScalarSize() const
+{
+	return scalarType ? vtkDataArray::GetDataTypeSize(scalarType) : 0;
+}
+
+qint64 MetaImageIO::Header::getSizeInBytes() const
+{
+	return qint64(dim[0])*dim[1]*dim[2]*numComps*this->getScalarSize();
+}
+
+int MetaImageIO::getVtkScalarType(QString elementType)
+{
+	if (elementType == "MET_UCHAR")
+		return VTK_UNSIGNED_CHAR;
+	if (elementType == "MET_CHAR")
+		return VTK_SIGNED_CHAR;
+	if (elementType == "MET_USHORT")
+		return VTK_UNSIGNED_SHORT;
+	if (elementType == "MET_SHORT")
+		return VTK_SHORT;
+	if (elementType == "MET_UINT")
+		return VTK_UNSIGNED_INT;
+	if (elementType == "MET_INT")
+		return VTK_INT;
+	if (elementType == "MET_FLOAT")
+		return VTK_FLOAT;
+	if (elementType == "MET_DOUBLE")
+		return VTK_DOUBLE;
+	return 0;
+}
+
+QString MetaImageIO::getMetaElementType(int scalarType)
+{
+	switch (scalarType)
+	{
+	case VTK_UNSIGNED_CHAR: return "MET_UCHAR";
+	case VTK_CHAR:
+	case VTK_SIGNED_CHAR: return "MET_CHAR";
+	case VTK_UNSIGNED_SHORT: return "MET_USHORT";
+	case VTK_SHORT: return "MET_SHORT";
+	case VTK_UNSIGNED_INT: return "MET_UINT";
+	case VTK_INT: return "MET_INT";
+	case VTK_FLOAT: return "MET_FLOAT";
+	case VTK_DOUBLE: return "MET_DOUBLE";
+	default: return "";
+	}
+}
+
+bool MetaImageIO::readHeader(QString filename, Header* header)
+{
+	*header = Header();
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	std::map<QString, QString> keys;
+	while (!file.atEnd())
+	{
+		QString line = QString::fromLatin1(file.readLine()).trimmed();
+		int separator = line.indexOf('=');
+		if (separator < 0)
+			continue;
+		QString key = line.left(separator).trimmed();
+		keys[key] = line.mid(separator+1).trimmed();
+		if (key == "ElementDataFile" && keys[key] == "LOCAL")
+			break; // binary data follows
+	}
+
+	QString dataFile = keys["ElementDataFile"];
+	if (dataFile.isEmpty() || dataFile.startsWith("LIST") || dataFile.contains('%'))
+		return false; // one file per slice
+	if (keys.count("BinaryData") && !isTrue(keys["BinaryData"]))
+		return false; // ascii
+
+	QStringList dim = keys["DimSize"].split(" ", QString::SkipEmptyParts);
+	QStringList spacing = keys["ElementSpacing"].split(" ", QString::SkipEmptyParts);
+	QString originKey = keys.count("Offset") ? "Offset" : (keys.count("Position") ? "Position" : "Origin");
+	QStringList origin = keys[originKey].split(" ", QString::SkipEmptyParts);
+	if (dim.size() < 1 || dim.size() > 3)
+		return false;
+	for (int i=0; i<3; ++i)
+	{
+		header->dim[i] = (i < dim.size()) ? dim[i].toInt() : 1;
+		header->spacing[i] = (i < spacing.size()) ? spacing[i].toDouble() : 1.0;
+		header->origin[i] = (i < origin.size()) ? origin[i].toDouble() : 0.0;
+		if (header->dim[i] < 1)
+			return false;
+	}
+
+	header->scalarType = getVtkScalarType(keys["ElementType"]);
+	header->numComps = keys.count("ElementNumberOfChannels") ? keys["ElementNumberOfChannels"].toInt() : 1;
+	header->msb = isTrue(keys["BinaryDataByteOrderMSB"]) || isTrue(keys["ElementByteOrderMSB"]);
+	header->compressed = isTrue(keys["CompressedData"]);
+	header->compressedSize = keys.count("CompressedDataSize") ? keys["CompressedDataSize"].toLongLong() : -1;
+
+	QStringList chunks = keys["CompressedDataChunks"].split(" ", QString::SkipEmptyParts);
+	if (header->compressed && chunks.size() >= 2)
+	{
+		header->chunkSize = chunks[0].toLongLong();
+		for (int i=1; i<chunks.size(); ++i)
+			header->chunks.push_back(chunks[i].toLongLong());
+		if (header->chunkSize <= 0)
+		{
+			header->chunkSize = 0;
+			header->chunks.clear();
+		}
+	}
+
+	if (dataFile == "LOCAL")
+	{
+		header->dataFile = QFileInfo(filename).absoluteFilePath();
+		header->headerSize = file.pos();
+	}
+	else
+	{
+		header->dataFile = QFileInfo(filename).absoluteDir().absoluteFilePath(dataFile);
+		header->headerSize = keys.count("HeaderSize") ? keys["HeaderSize"].toLongLong() : 0;
+	}
+
+	return header->scalarType && header->numComps >= 1;
+}
+
+QStringList MetaImageIO::createHeaderLines(const Header& header)
+{
+	QStringList retval;
+	retval << "ObjectType = Image";
+	retval << "NDims = 3";
+	retval << "BinaryData = True";
+	retval << QString("BinaryDataByteOrderMSB = %1").arg(header.msb ? "True" : "False");
+	retval << QString("CompressedData = %1").arg(header.compressed ? "True" : "False");
+	if (header.compressed && header.compressedSize >= 0)
+		retval << QString("CompressedDataSize = %1").arg(header.compressedSize);
+	if (header.compressed && header.chunkSize > 0)
+	{
+		QStringList chunks;
+		chunks << QString::number(header.chunkSize);
+		for (unsigned i=0; i<header.chunks.size(); ++i)
+			chunks << QString::number(header.chunks[i]);
+		retval << QString("CompressedDataChunks = %1").arg(chunks.join(" "));
+	}
+	retval << "TransformMatrix = 1 0 0 0 1 0 0 0 1";
+	retval << QString("Offset = %1").arg(toString(header.origin));
+	retval << "CenterOfRotation = 0 0 0";
+	retval << "AnatomicalOrientation = RAI";
+	retval << QString("ElementSpacing = %1").arg(toString(header.spacing));
+	retval << QString("DimSize = %1 %2 %3").arg(header.dim[0]).arg(header.dim[1]).arg(header.dim[2]);
+	if (header.numComps > 1)
+		retval << QString("ElementNumberOfChannels = %1").arg(header.numComps);
+	retval << QString("ElementType = %1").arg(getMetaElementType(header.scalarType));
+	if (header.headerSize > 0)
+		retval << QString("HeaderSize = %1").arg(header.headerSize);
+	return retval;
+}
+
+vtkImageDataPtr MetaImageIO::read(QString filename)
+{
+	CX_TRACE_SCOPE("io", "read metaimage");
+	Header header;
+	if (!readHeader(filename, &header))
+		return vtkImageDataPtr();
+
+	QFile file(header.dataFile);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Failed to open " << header.dataFile;
+		return vtkImageDataPtr();
+	}
+
+	qint64 size = header.getSizeInBytes();
+	qint64 stored = header.compressed ? header.compressedSize : size;
+	qint64 offset = header.headerSize;
+	if (offset < 0 && stored >= 0)
+		offset = file.size() - stored;
+	if (stored < 0 && offset >= 0)
+		stored = file.size() - offset;
+	if (offset < 0 || stored <= 0 || offset + stored > file.size())
+	{
+		CX_LOG_WARNING() << "MetaImageIO: " << header.dataFile << " is smaller than given in " << filename;
+		return vtkImageDataPtr();
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetDimensions(header.dim);
+	retval->SetSpacing(header.spacing);
+	retval->SetOrigin(header.origin);
+	retval->AllocateScalars(header.scalarType, header.numComps);
+	char* output = static_cast<char*>(retval->GetScalarPointer());
+
+	const char* input = reinterpret_cast<const char*>(file.map(offset, stored));
+	QByteArray buffer;
+	if (!input && header.compressed && file.seek(offset))
+	{
+		buffer = file.read(stored); // mapping not supported
+		if (buffer.size() == stored)
+			input = buffer.constData();
+	}
+
+	bool ok = false;
+	if (!header.compressed)
+	{
+		if (input)
+		{
+			std::vector<Job> jobs = splitCopy(input, output, size);
+			QtConcurrent::blockingMap(jobs, &copyJob);
+			ok = true;
+		}
+		else
+		{
+			ok = readRaw(&file, offset, output, size);
+		}
+	}
+	else if (input)
+	{
+		if (header.chunkSize > 0)
+			ok = inflateChunks(input, stored, output, size, header);
+		if (!ok)
+			ok = inflateStream(input, stored, output, size);
+	}
+
+	if (!ok)
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Failed to read " << header.dataFile;
+		return vtkImageDataPtr();
+	}
+
+	int scalarSize = header.getScalarSize();
+	if (header.msb && scalarSize > 1)
+	{
+		std::vector<Job> jobs = splitCopy(output, output, size);
+		QtConcurrent::blockingMap(jobs, [scalarSize](Job& job) { swapJob(job, scalarSize); });
+	}
+	return retval;
+}
+
+bool MetaImageIO::write(QString filename, vtkImageDataPtr image, bool compress)
+{
+	CX_TRACE_SCOPE("io", "write metaimage");
+	if (!image || !image->GetScalarPointer())
+		return false;
+
+	Header header;
+	image->GetDimensions(header.dim);
+	image->GetSpacing(header.spacing);
+	image->GetOrigin(header.origin);
+	header.scalarType = image->GetScalarType();
+	header.numComps = image->GetNumberOfScalarComponents();
+	header.compressed = compress;
+	if (getMetaElementType(header.scalarType).isEmpty())
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Cannot write scalar type " << image->GetScalarTypeAsString();
+		return false;
+	}
+
+	QFileInfo info(filename);
+	QString dataFile = info.completeBaseName() + (compress ? ".zraw" : ".raw");
+	QDir().mkpath(info.absolutePath());
+
+	QFile data(info.absoluteDir().absoluteFilePath(dataFile));
+	if (!data.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Failed to write " << data.fileName();
+		return false;
+	}
+	const char* scalars = static_cast<const char*>(image->GetScalarPointer());
+	bool ok = compress ? writeCompressed(&data, scalars, header.getSizeInBytes(), &header)
+					   : writeRaw(&data, scalars, header.getSizeInBytes());
+	data.close();
+	if (!ok)
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Failed to write " << data.fileName();
+		return false;
+	}
+
+	// write the header last, it refers to complete data
+	QStringList lines = createHeaderLines(header);
+	lines << QString("ElementDataFile = %1").arg(dataFile);
+	QFile headerFile(filename);
+	if (!headerFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "MetaImageIO: Failed to write " << filename;
+		return false;
+	}
+	QByteArray text = (lines.join("\n") + "\n").toLatin1();
+	return headerFile.write(text) == text.size();
+}
+
+QFuture<vtkImageDataPtr> MetaImageIO::readAsync(QString filename)
+{
+	return QtConcurrent::run(&MetaImageIO::read, filename);
+}
+
+QFuture<bool> MetaImageIO::writeAsync(QString filename, vtkImageDataPtr image, bool compress)
+{
+	return QtConcurrent::run(&MetaImageIO::write, filename, image, compress);
+}
+
+} // namespace cx
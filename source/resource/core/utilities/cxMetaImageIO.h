@@ -0,0 +1,94 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXMETAIMAGEIO_H
+#define CXMETAIMAGEIO_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include <QFuture>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/** \brief Fast reader and writer for MetaImage (.mhd/.raw) files.
+ *
+ * Replaces vtkMetaImageReader/Writer for the common case of one data
+ * file per image. The files are compatible with vtk/ITK, and with the
+ * extra keys added by CustomMetaImage.
+ *
+ * Uncompressed scalars are memory mapped and copied in parallel.
+ *
+ * Compressed scalars are split into chunks that are compressed in
+ * parallel, then joined into one zlib stream, readable by any MetaImage
+ * reader. The compressed size of each chunk is stored in the header key
+ *
+ *   CompressedDataChunks = <chunk size> <compressed size 0> <compressed size 1> ...
+ *
+ * and lets read() decompress the chunks in parallel. Compressed files
+ * without the key, e.g. written by vtk, are decompressed serially.
+ *
+ * The async functions run in the global thread pool. The image passed to
+ * writeAsync() must not be modified until the future has finished.
+ *
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT MetaImageIO
+{
+public:
+	/** The parts of a MetaImage header used for reading the scalars. */
+	struct cxResource_EXPORT Header
+	{
+		Header();
+		int dim[3];
+		double spacing[3];
+		double origin[3];
+		int scalarType; ///< vtk scalar type, 0 if not supported
+		int numComps;
+		bool msb; ///< big endian scalars
+		bool compressed;
+		qint64 compressedSize; ///< -1 if unknown
+		qint64 chunkSize; ///< uncompressed size of each chunk, 0 if not chunked
+		std::vector<qint64> chunks; ///< compressed size of each chunk
+		QString dataFile; ///< absolute path, the header file itself for LOCAL data
+		qint64 headerSize; ///< offset of the scalars in dataFile, -1 means at the end
+
+		qint64 getSizeInBytes() const; ///< uncompressed scalars
+		int getScalarSize() const;
+	};
+
+	static const int compressionLevel = 1; ///< zlib level, favour speed
+	static const qint64 defaultChunkSize = 2*1024*1024;
+
+	/** Read the header. False if the scalars cannot be read by this class,
+	 *  e.g. one file per slice. */
+	static bool readHeader(QString filename, Header* header);
+	/** The header lines up to, but not including, ElementDataFile. */
+	static QStringList createHeaderLines(const Header& header);
+	static int getVtkScalarType(QString metaElementType); ///< 0 if not supported
+	static QString getMetaElementType(int vtkScalarType); ///< empty if not supported
+
+	/** Read the image, with origin from the Offset key. Zero on failure. */
+	static vtkImageDataPtr read(QString filename);
+	/** Write image to a .mhd file and a .raw or, if compressed, .zraw file. */
+	static bool write(QString filename, vtkImageDataPtr image, bool compress=false);
+
+	static QFuture<vtkImageDataPtr> readAsync(QString filename);
+	static QFuture<bool> writeAsync(QString filename, vtkImageDataPtr image, bool compress=false);
+};
+
+} // namespace cx
+
+#endif // CXMETAIMAGEIO_H
@@ -11,6 +11,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxPositionStorageFile.h"
 #include <QDateTime>
+#include <QtEndian>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
 #include <boost/cstdint.hpp>
 #include "cxFrame3D.h"
 #include "cxTime.h"
@@ -19,8 +23,106 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
+namespace
+{
+const quint8 indexedVersion = 3;
+const qint64 headerSize = 7;
+const qint64 recordSize = 64;
+const qint64 footerSize = 64;
+const quint32 indexStride = 256;
+const char footerMagic[] = "SNWPOSFT";
+
+quint64 readUInt64(const uchar* src)
+{
+	return qFromLittleEndian<quint64>(src);
+}
+
+quint32 readUInt32(const uchar* src)
+{
+	return qFromLittleEndian<quint32>(src);
+}
+
+double readDouble(const uchar* src)
+{
+	quint64 bits = readUInt64(src);
+	double retval;
+	memcpy(&retval, &bits, sizeof(retval));
+	return retval;
+}
+
+void writeUInt64(uchar* dst, quint64 value)
+{
+	qToLittleEndian<quint64>(value, dst);
+}
+
+void writeUInt32(uchar* dst, quint32 value)
+{
+	qToLittleEndian<quint32>(value, dst);
+}
+
+void writeDouble(uchar* dst, double value)
+{
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeUInt64(dst, bits);
+}
+
+struct Footer
+{
+	quint64 toolsOffset;
+	quint64 recordsOffset;
+	quint64 count;
+	quint64 indexOffset;
+	quint64 previous;
+	quint32 toolCount;
+	quint32 stride;
+};
+
+/** Read the footer at offset footer, false if it is not a consistent footer.
+ */
+bool readFooter(const uchar* data, qint64 footer, Footer* retval)
+{
+	if (footer < headerSize)
+		return false;
+	const uchar* f = data + footer;
+	if (memcmp(f, footerMagic, 8)!=0)
+		return false;
+	retval->toolsOffset = readUInt64(f+8);
+	retval->recordsOffset = readUInt64(f+16);
+	retval->count = readUInt64(f+24);
+	retval->indexOffset = readUInt64(f+32);
+	retval->previous = readUInt64(f+40);
+	retval->toolCount = readUInt32(f+48);
+	retval->stride = readUInt32(f+52);
+	quint64 indexCount = retval->stride ? (retval->count+retval->stride-1)/retval->stride : 0;
+
+	return !(retval->stride==0 || retval->toolsOffset<quint64(headerSize) || retval->recordsOffset<retval->toolsOffset
+		|| retval->indexOffset<retval->recordsOffset || (retval->indexOffset-retval->recordsOffset)/recordSize<retval->count
+		|| quint64(footer)<retval->indexOffset || (quint64(footer)-retval->indexOffset)/8<indexCount
+		|| retval->previous>=quint64(footer));
+}
+
+/** Offset of the last valid footer in the file, -1 if none.
+ *  Normally this is the end of the file. If writing a segment was
+ *  interrupted, the partial segment is skipped by searching backwards:
+ *  footers are 8 byte aligned.
+ */
+qint64 findLastFooter(const uchar* data, qint64 size)
+{
+	Footer footer;
+	qint64 last = size - footerSize;
+	if (last >= headerSize && readFooter(data, last, &footer))
+		return last;
+	for (qint64 pos = last - last%8; pos >= headerSize; pos -= 8)
+		if (readFooter(data, pos, &footer))
+			return pos;
+	return -1;
+}
+} // namespace
+
 
-PositionStorageReader::PositionStorageReader(QString filename) : positions(filename)
+PositionStorageReader::PositionStorageReader(QString filename) :
+	positions(filename), mData(NULL), mSegment(0), mRecord(0)
 {
   mError = false;
   positions.open(QIODevice::ReadOnly);
@@ -44,11 +146,92 @@ PositionStorageReader::PositionStorageReader(QString filename) : positions(filen
     std::cout << "Error in header for file [" << filename.toStdString() << "]" << std::endl;
     positions.close();
   }
+  else if (mVersion>indexedVersion)
+  {
+    std::cout << "Error: Unsupported version " << int(mVersion) << " in file [" << filename.toStdString() << "]" << std::endl;
+    positions.close();
+  }
+  else if (this->isIndexed())
+  {
+    this->openIndexed();
+  }
+}
+
+/** Map the file and follow the footer chain backwards from the end of the file.
+ */
+void PositionStorageReader::openIndexed()
+{
+  qint64 size = positions.size();
+  mData = positions.map(0, size);
+  if (!mData)
+  {
+    positions.seek(0);
+    mBuffer = positions.readAll();
+    mData = reinterpret_cast<const uchar*>(mBuffer.constData());
+  }
+
+  qint64 footer = findLastFooter(mData, size);
+  if (footer>=0 && footer!=size-footerSize)
+    std::cout << "Warning: Ignoring " << size-footer-footerSize << " bytes of incomplete data at the end of file ["
+              << positions.fileName().toStdString() << "]" << std::endl;
+
+  while (footer >= headerSize)
+  {
+    Footer f;
+    if (!readFooter(mData, footer, &f))
+    {
+      mError = true;
+      break;
+    }
+    quint64 toolsOffset = f.toolsOffset;
+    quint64 recordsOffset = f.recordsOffset;
+    quint64 count = f.count;
+    quint64 indexOffset = f.indexOffset;
+    quint64 previous = f.previous;
+    quint32 toolCount = f.toolCount;
+    quint32 stride = f.stride;
+
+    Segment segment;
+    const uchar* tool = mData + toolsOffset;
+    const uchar* toolsEnd = mData + recordsOffset;
+    for (quint32 i=0; i<toolCount && tool+2<=toolsEnd; ++i)
+    {
+      quint16 length = qFromLittleEndian<quint16>(tool);
+      tool += 2;
+      if (tool+length > toolsEnd)
+        break;
+      segment.tools << QString::fromLatin1(reinterpret_cast<const char*>(tool), length);
+      tool += length;
+    }
+    segment.records = mData + recordsOffset;
+    segment.count = count;
+    segment.index = mData + indexOffset;
+    segment.indexStride = stride;
+    mSegments.insert(mSegments.begin(), segment);
+
+    if (previous==0)
+      break;
+    footer = qint64(previous);
+  }
+
+  if (mError)
+    std::cout << "Error in index for file [" << positions.fileName().toStdString() << "]" << std::endl;
+
+  mSegment = 0;
+  mRecord = 0;
+  if (!mSegments.empty() && mSegments[0].count==0)
+    this->nextRecord();
 }
 
 PositionStorageReader::~PositionStorageReader()
 {
+  if (mData && mBuffer.isEmpty())
+    positions.unmap(const_cast<uchar*>(mData));
+}
 
+bool PositionStorageReader::isIndexed() const
+{
+  return mVersion==indexedVersion;
 }
 
 int PositionStorageReader::version()
@@ -61,6 +244,14 @@ bool PositionStorageReader::read(Transform3D* matrix, double* timestamp, int* to
   if (atEnd())
     return false;
 
+  if (this->isIndexed())
+  {
+    QString toolUid;
+    bool ok = this->read(matrix, timestamp, &toolUid);
+    *toolIndex = toolUid.toInt();
+    return ok;
+  }
+
   quint8 type;
   quint8 size;
   quint64 ts;
@@ -87,6 +278,16 @@ bool PositionStorageReader::read(Transform3D* matrix, double* timestamp, QString
   if (this->atEnd())
     return false;
 
+  if (this->isIndexed())
+  {
+    Position position = this->decode(mSegments[mSegment], mRecord);
+    this->nextRecord();
+    *matrix = position.matrix;
+    *timestamp = position.timestamp;
+    *toolUid = position.toolUid;
+    return true;
+  }
+
   quint8 type;
   quint8 size;
 
@@ -100,7 +301,7 @@ bool PositionStorageReader::read(Transform3D* matrix, double* timestamp, QString
     char* data = NULL;
     uint isize = 0;
     stream.readBytes(data, isize);
-	mCurrentToolUid = QString(QByteArray(data, size));
+	mCurrentToolUid = QString(QByteArray(data, isize));
     delete[] data;
 
     stream >> type; // read type and make ready for a new read below
@@ -165,9 +366,190 @@ Frame3D PositionStorageReader::frameFromStream()
 
 bool PositionStorageReader::atEnd() const
 {
+  if (this->isIndexed())
+    return mError || mSegment>=mSegments.size();
   return !positions.isReadable() || stream.atEnd() || mError;
 }
 
+void PositionStorageReader::nextRecord()
+{
+  ++mRecord;
+  while (mSegment<mSegments.size() && mRecord>=mSegments[mSegment].count)
+  {
+    ++mSegment;
+    mRecord = 0;
+  }
+}
+
+/** Binary search in the sparse index, then in the records between two index entries.
+ */
+quint64 PositionStorageReader::findRecord(const Segment& segment, double timestamp, bool after) const
+{
+  struct Before
+  {
+    double t;
+    bool after;
+    bool operator()(quint64 ts) const { return after ? (double(ts)<=t) : (double(ts)<t); }
+  } before = { timestamp, after };
+
+  quint64 indexCount = (segment.count+segment.indexStride-1)/segment.indexStride;
+  quint64 low = 0; // first index entry not before timestamp
+  quint64 high = indexCount;
+  while (low<high)
+  {
+    quint64 mid = low + (high-low)/2;
+    if (before(readUInt64(segment.index + 8*mid)))
+      low = mid+1;
+    else
+      high = mid;
+  }
+
+  // the record lies after index entry low-1 and at or before entry low
+  high = std::min(segment.count, low*segment.indexStride);
+  low = (low==0) ? 0 : (low-1)*segment.indexStride;
+  while (low<high)
+  {
+    quint64 mid = low + (high-low)/2;
+    if (before(readUInt64(segment.records + recordSize*mid + 48)))
+      low = mid+1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+PositionStorageReader::Position PositionStorageReader::decode(const Segment& segment, quint64 record) const
+{
+  const uchar* src = segment.records + recordSize*record;
+  boost::array<double, 6> rep;
+  for (unsigned i=0; i<6; ++i)
+    rep[i] = readDouble(src + 8*i);
+  quint32 tool = readUInt32(src + 56);
+
+  Position retval;
+  retval.matrix = Frame3D::fromCompactAxisAngleRep(rep).transform();
+  retval.timestamp = readUInt64(src + 48);
+  if (tool < quint32(segment.tools.size()))
+    retval.toolUid = segment.tools[tool];
+  return retval;
+}
+
+/** Version 3 files: O(log n) in each segment.
+ *  Older versions: scan from the start of the file.
+ */
+bool PositionStorageReader::seek(double timestamp)
+{
+  if (this->isIndexed())
+  {
+    if (mError)
+      return false;
+    for (mSegment=0; mSegment<mSegments.size(); ++mSegment)
+    {
+      mRecord = this->findRecord(mSegments[mSegment], timestamp, false);
+      if (mRecord<mSegments[mSegment].count)
+        return true;
+    }
+    mRecord = 0;
+    return false;
+  }
+
+  if (!positions.isReadable())
+    return false;
+  positions.seek(headerSize);
+  stream.resetStatus();
+  mError = false;
+  mCurrentToolUid = "";
+
+  Transform3D matrix;
+  double ts;
+  QString toolUid;
+  while (!this->atEnd())
+  {
+    qint64 pos = positions.pos();
+    QString currentToolUid = mCurrentToolUid;
+    if (!this->read(&matrix, &ts, &toolUid))
+      return false;
+    if (ts>=timestamp)
+    {
+      positions.seek(pos);
+      mCurrentToolUid = currentToolUid;
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Version 3 files are decoded in parallel, and the read position is unchanged.
+ *  Older versions are scanned sequentially, and the read position is restored.
+ */
+std::vector<PositionStorageReader::Position> PositionStorageReader::readRange(double start, double end)
+{
+  std::vector<Position> retval;
+
+  if (this->isIndexed())
+  {
+    if (mError)
+      return retval;
+
+    struct Chunk
+    {
+      const Segment* segment;
+      quint64 first;
+      quint64 last;
+      size_t target;
+    };
+    const quint64 chunkSize = 4096;
+    std::vector<Chunk> chunks;
+    size_t total = 0;
+    for (unsigned i=0; i<mSegments.size(); ++i)
+    {
+      const Segment& segment = mSegments[i];
+      quint64 first = this->findRecord(segment, start, false);
+      quint64 last = std::max(first, this->findRecord(segment, end, true));
+      for (quint64 r=first; r<last; r+=chunkSize)
+      {
+        Chunk chunk = { &segment, r, std::min(last, r+chunkSize), size_t(total + r-first) };
+        chunks.push_back(chunk);
+      }
+      total += last-first;
+    }
+
+    retval.resize(total);
+    QtConcurrent::blockingMap(chunks, [&](const Chunk& chunk)
+    {
+      for (quint64 r=chunk.first; r<chunk.last; ++r)
+        retval[chunk.target + (r-chunk.first)] = this->decode(*chunk.segment, r);
+    });
+    return retval;
+  }
+
+  if (!positions.isReadable())
+    return retval;
+  qint64 pos = positions.pos();
+  QString currentToolUid = mCurrentToolUid;
+  bool error = mError;
+
+  // older files are sorted per tool only: scan everything
+  positions.seek(headerSize);
+  stream.resetStatus();
+  mError = false;
+  mCurrentToolUid = "";
+  Position position;
+  while (!this->atEnd())
+  {
+    if (!this->read(&position.matrix, &position.timestamp, &position.toolUid))
+      break;
+    if (start<=position.timestamp && position.timestamp<=end)
+      retval.push_back(position);
+  }
+
+  positions.seek(pos);
+  stream.resetStatus();
+  mCurrentToolUid = currentToolUid;
+  mError = error;
+  return retval;
+}
+
 /** convert a timestamp to a string. Input format is 64 bit millisecond time.
  *
  */
@@ -186,26 +568,110 @@ QString PositionStorageReader::timestampToString(double timestamp)
 //---------------------------------------------------------
 
 
-PositionStorageWriter::PositionStorageWriter(QString filename) : positions(filename)
+PositionStorageWriter::PositionStorageWriter(QString filename) :
+	positions(filename), mVersion(indexedVersion), mPreviousFooter(0)
 {
-	positions.open(QIODevice::Append);
+	positions.open(QIODevice::ReadWrite);
 	stream.setDevice(&positions);
 	stream.setByteOrder(QDataStream::LittleEndian);
 	if (positions.size() == 0)
 	{
 		stream.writeRawData("SNWPOS", 6);
-		stream << (quint8)2; // version 1 had only 32 bit timestamps
+		stream << mVersion; // version 1 had only 32 bit timestamps, version 2 was not indexed
+		return;
 	}
+
+	// append to existing files in their own format
+	char header[6];
+	stream.readRawData(header, 6);
+	stream >> mVersion;
+	qint64 size = positions.size();
+	if (mVersion==indexedVersion)
+	{
+		// chain to the last complete segment, skipping a partial one at the end
+		qint64 footer = -1;
+		uchar* data = positions.map(0, size);
+		if (data)
+		{
+			footer = findLastFooter(data, size);
+			positions.unmap(data);
+		}
+		else
+		{
+			positions.seek(0);
+			QByteArray contents = positions.readAll();
+			footer = findLastFooter(reinterpret_cast<const uchar*>(contents.constData()), contents.size());
+		}
+		if (footer>0)
+			mPreviousFooter = footer;
+	}
+	positions.seek(size);
 }
 
 PositionStorageWriter::~PositionStorageWriter()
 {
+	if (mVersion==indexedVersion && !mRecords.empty())
+		this->writeSegment();
 	positions.close();
 }
 
+/** Write the buffered records sorted by timestamp, followed by the index and footer.
+ */
+void PositionStorageWriter::writeSegment()
+{
+	quint64 count = mRecords.size()/recordSize;
+	const uchar* records = reinterpret_cast<const uchar*>(mRecords.data());
+	std::vector<quint64> order(count);
+	for (quint64 i=0; i<count; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [records](quint64 a, quint64 b)
+	{
+		return readUInt64(records + recordSize*a + 48) < readUInt64(records + recordSize*b + 48);
+	});
+
+	quint64 toolsOffset = positions.pos();
+	for (int i=0; i<mTools.size(); ++i)
+	{
+		QByteArray name = mTools[i].toLatin1();
+		stream << (quint16)name.size();
+		stream.writeRawData(name.constData(), name.size());
+	}
+	while (positions.pos()%8)
+		stream << (quint8)0;
+
+	quint64 recordsOffset = positions.pos();
+	std::vector<char> sorted(mRecords.size());
+	std::vector<quint64> index;
+	for (quint64 i=0; i<count; ++i)
+	{
+		memcpy(&sorted[recordSize*i], &mRecords[recordSize*order[i]], recordSize);
+		if (i%indexStride==0)
+			index.push_back(readUInt64(records + recordSize*order[i] + 48));
+	}
+	stream.writeRawData(sorted.data(), int(sorted.size()));
+
+	quint64 indexOffset = positions.pos();
+	for (unsigned i=0; i<index.size(); ++i)
+		stream << index[i];
+
+	quint64 footer = positions.pos();
+	stream.writeRawData(footerMagic, 8);
+	stream << toolsOffset << recordsOffset << count << indexOffset << mPreviousFooter;
+	stream << (quint32)mTools.size() << indexStride;
+	stream << (quint64)0;
+
+	mPreviousFooter = footer;
+	mRecords.clear();
+}
 
 void PositionStorageWriter::write(Transform3D matrix, uint64_t timestamp, int toolIndex)
 {
+	if (mVersion==indexedVersion)
+	{
+		this->write(matrix, timestamp, QString::number(toolIndex));
+		return;
+	}
+
 	Frame3D frame = Frame3D::create(matrix);
 
 	stream << (quint8)1;	// Type - there is only one
@@ -225,6 +691,26 @@ void PositionStorageWriter::write(Transform3D matrix, uint64_t timestamp, int to
 
 void PositionStorageWriter::write(Transform3D matrix, uint64_t timestamp, QString toolUid)
 {
+  if (mVersion==indexedVersion)
+  {
+    int tool = mTools.indexOf(toolUid);
+    if (tool<0)
+    {
+      tool = mTools.size();
+      mTools << toolUid;
+    }
+    boost::array<double, 6> rep = Frame3D::create(matrix).getCompactAxisAngleRep();
+
+    size_t offset = mRecords.size();
+    mRecords.resize(offset + recordSize, 0);
+    uchar* dst = reinterpret_cast<uchar*>(&mRecords[offset]);
+    for (unsigned i=0; i<6; ++i)
+      writeDouble(dst + 8*i, rep[i]);
+    writeUInt64(dst + 48, timestamp);
+    writeUInt32(dst + 56, tool);
+    return;
+  }
+
   if (toolUid!=mCurrentToolUid)
   {
     QByteArray name = toolUid.toLatin1();
@@ -234,7 +720,7 @@ void PositionStorageWriter::write(Transform3D matrix, uint64_t timestamp, QStrin
     stream.writeBytes(name.data(), name.size());
     mCurrentToolUid = toolUid;
   }
-  else
+
   {
     Frame3D frame = Frame3D::create(matrix);
     boost::array<double, 6> rep = frame.getCompactAxisAngleRep();
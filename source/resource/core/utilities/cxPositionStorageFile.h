@@ -17,6 +17,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QString>
 #include <QFile>
 #include <QDataStream>
+#include <QStringList>
+#include <vector>
 #include <boost/cstdint.hpp>
 
 #include "cxTransform3D.h"
@@ -28,10 +30,11 @@ namespace cx {
  * Each call to read() gives the next position entry from the file.
  * When atEnd() returns true, all positions have been read. 
  *
+ * Version 3 files are indexed: seek() and readRange() use binary
+ * search in the memory mapped file, and readRange() decodes in
+ * parallel. For older versions they scan the file from the start.
  *
- *
- *
- * Binary file format description
+ * Binary file format description, version 1 and 2
    \verbatim
   Header:
     "SNWPOS"<version>
@@ -51,12 +54,36 @@ namespace cx {
    Where the parameters are found from a matrix using the class CGFrame.
    \endverbatim
  *
+ * Version 3: The header is followed by segments, one for each writer.
+ * All numbers are little endian.
+   \verbatim
+  Segment:
+    <tools><pad to 8 bytes><records><index><footer>
+
+   * tools: for each tool <quint16 length><latin1 uid>
+   * records: sorted by timestamp, 64 bytes each:
+      <double position[6]><quint64 timestamp><quint32 tool><quint32 reserved>
+   * index: <quint64 timestamp> of every indexStride'th record
+   * footer, 64 bytes:
+      "SNWPOSFT"<quint64 toolsOffset><quint64 recordsOffset><quint64 recordCount>
+      <quint64 indexOffset><quint64 previousFooterOffset, 0 if first>
+      <quint32 toolCount><quint32 indexStride><8 bytes reserved>
+   \endverbatim
+ * The reader starts at the footer at the end of the file.
+ *
  * \sa PositionStorageWriter
  * \ingroup cx_resource_core_utilities
  */
 class cxResource_EXPORT PositionStorageReader
 {
 public:
+	struct Position
+	{
+		Transform3D matrix;
+		double timestamp;
+		QString toolUid;
+	};
+
 	PositionStorageReader(QString filename);
 	~PositionStorageReader();
 	bool read(Transform3D* matrix, double* timestamp, int* toolIndex); // reads only tool data in integer format.
@@ -64,13 +91,37 @@ public:
 	bool atEnd() const;
 	static QString timestampToString(double timestamp);
 	int version();
+
+	bool isIndexed() const; ///< true for version 3 files
+	bool seek(double timestamp); ///< next read() gives the first position at or after timestamp
+	std::vector<Position> readRange(double start, double end); ///< all positions with start <= timestamp <= end, in file order
+
 private:
+	struct Segment
+	{
+		QStringList tools;
+		const uchar* records;
+		quint64 count;
+		const uchar* index;
+		quint32 indexStride;
+	};
+
 	QString mCurrentToolUid; ///< the tool currently being written.
 	QFile positions;
 	QDataStream stream;
 	quint8 mVersion;
 	bool mError;
 	class Frame3D frameFromStream();
+
+	void openIndexed();
+	quint64 findRecord(const Segment& segment, double timestamp, bool after) const; ///< first record with timestamp >= (> if after) the given
+	void nextRecord();
+	Position decode(const Segment& segment, quint64 record) const;
+	const uchar* mData; ///< the mapped file, version 3
+	QByteArray mBuffer; ///< file contents if mapping failed
+	std::vector<Segment> mSegments; ///< in file order
+	unsigned mSegment; ///< read cursor
+	quint64 mRecord;
 };
 
 typedef boost::shared_ptr<PositionStorageReader> PositionStorageReaderPtr;
@@ -82,6 +133,9 @@ typedef boost::shared_ptr<PositionStorageReader> PositionStorageReaderPtr;
  * Extract the info with class PositionStorageReader.
  *
  * For a description of the file format, see PositionStorageReader.
+ * New files are written as version 3, the positions are kept in
+ * memory and written as one segment when the writer is destroyed.
+ * Existing files are appended to in their own version.
  *
  * \sa PositionStorageReader
  * \ingroup sscUtility
@@ -90,13 +144,19 @@ class cxResource_EXPORT PositionStorageWriter
 {
 public:
 	PositionStorageWriter(QString filename);
-	~PositionStorageWriter();
+	~PositionStorageWriter(); ///< writes the segment for version 3 files
 	void write(Transform3D matrix, uint64_t timestamp, int toolIndex);
 	void write(Transform3D matrix, uint64_t timestamp, QString toolUid);
 private:
 	QString mCurrentToolUid; ///< the tool currently being written.
 	QFile positions;
 	QDataStream stream;
+
+	void writeSegment();
+	quint8 mVersion;
+	quint64 mPreviousFooter;
+	QStringList mTools;
+	std::vector<char> mRecords;
 };
 
 } // namespace cx 
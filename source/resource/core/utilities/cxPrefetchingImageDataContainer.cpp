@@ -0,0 +1,268 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxPrefetchingImageDataContainer.h"
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <boost/bind.hpp>
+#include <vtkImageData.h>
+
+namespace cx
+{
+
+PrefetchingImageDataContainer::Statistics::Statistics() :
+	hits(0), misses(0), loads(0), totalLoadTime(0), maxLoadTime(0), maxWaitTime(0), memory(0)
+{
+}
+
+double PrefetchingImageDataContainer::Statistics::getHitRate() const
+{
+	if (hits+misses==0)
+		return 0;
+	return double(hits)/(hits+misses);
+}
+
+double PrefetchingImageDataContainer::Statistics::getMeanLoadTime() const
+{
+	if (loads==0)
+		return 0;
+	return totalLoadTime/loads;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+PrefetchingImageDataContainer::PrefetchingImageDataContainer(ImageDataContainerPtr source, int readAhead, double memoryLimit) :
+	mSource(source),
+	mReadAhead(readAhead),
+	mMemoryLimit(memoryLimit*1024*1024),
+	mUseCount(0),
+	mMemory(0),
+	mFrameMemory(0),
+	mCurrent(0),
+	mDirection(1)
+{
+}
+
+PrefetchingImageDataContainer::~PrefetchingImageDataContainer()
+{
+	// queued loads are outside the empty window and return at once
+	{
+		QMutexLocker locker(&mMutex);
+		mReadAhead = 0;
+	}
+	mPool.clear();
+	mPool.waitForDone();
+}
+
+unsigned PrefetchingImageDataContainer::size() const
+{
+	return mSource->size();
+}
+
+vtkImageDataPtr PrefetchingImageDataContainer::get(unsigned index)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QMutexLocker locker(&mMutex);
+	if (index >= mSource->size())
+		return vtkImageDataPtr();
+
+	if (index != mCurrent)
+		mDirection = (index < mCurrent) ? -1 : 1;
+	mCurrent = index;
+
+	std::map<unsigned, Entry>::iterator iter = mEntries.find(index);
+	if ((iter != mEntries.end()) && iter->second.image)
+		++mStatistics.hits;
+	else
+		++mStatistics.misses;
+
+	while (true)
+	{
+		iter = mEntries.find(index);
+		if (iter==mEntries.end() || (!iter->second.image && !iter->second.pending))
+		{
+			// load here instead of waiting for the pool
+			mEntries[index].pending = true;
+			locker.unlock();
+			this->load(index);
+			locker.relock();
+			iter = mEntries.find(index);
+			break;
+		}
+		if (!iter->second.pending)
+			break;
+		mLoaded.wait(&mMutex);
+	}
+
+	vtkImageDataPtr retval;
+	if (iter != mEntries.end())
+	{
+		retval = iter->second.image;
+		iter->second.lastUse = ++mUseCount;
+	}
+
+	this->prefetch();
+	this->evict();
+	mStatistics.maxWaitTime = std::max<double>(mStatistics.maxWaitTime, timer.elapsed());
+	return retval;
+}
+
+/** Load a frame marked as pending, in the calling thread.
+ *  Prefetches that have left the window are dropped unloaded.
+ */
+void PrefetchingImageDataContainer::load(unsigned index)
+{
+	{
+		QMutexLocker locker(&mMutex);
+		if (!this->insideWindow(index))
+		{
+			mEntries.erase(index);
+			mLoaded.wakeAll();
+			return;
+		}
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	vtkImageDataPtr image = mSource->get(index);
+	double elapsed = timer.nsecsElapsed()/1.0E6;
+
+	QMutexLocker locker(&mMutex);
+	Entry& entry = mEntries[index];
+	entry.pending = false;
+	entry.image = image;
+	entry.lastUse = ++mUseCount;
+	if (image)
+	{
+		double memory = 1024.0*image->GetActualMemorySize();
+		mMemory += memory;
+		if (mFrameMemory==0)
+			mFrameMemory = memory;
+	}
+	++mStatistics.loads;
+	mStatistics.totalLoadTime += elapsed;
+	mStatistics.maxLoadTime = std::max(mStatistics.maxLoadTime, elapsed);
+	this->evict();
+	mLoaded.wakeAll();
+}
+
+/** Schedule the frames in the window ahead of the current, nearest first.
+ */
+void PrefetchingImageDataContainer::prefetch()
+{
+	int window = this->getWindow();
+	for (int i=1; i<=window; ++i)
+	{
+		int index = int(mCurrent) + i*mDirection;
+		if (index<0 || index>=int(mSource->size()))
+			break;
+		if (mEntries.count(index))
+			continue;
+		mEntries[index].pending = true;
+		QtConcurrent::run(&mPool, boost::bind(&PrefetchingImageDataContainer::load, this, unsigned(index)));
+	}
+}
+
+/** Remove the least recently used frames outside the window
+ *  until the memory limit is met.
+ */
+void PrefetchingImageDataContainer::evict()
+{
+	while (mMemory > mMemoryLimit)
+	{
+		std::map<unsigned, Entry>::iterator oldest = mEntries.end();
+		for (std::map<unsigned, Entry>::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			if (!iter->second.image || this->insideWindow(iter->first))
+				continue;
+			if (oldest==mEntries.end() || iter->second.lastUse < oldest->second.lastUse)
+				oldest = iter;
+		}
+		if (oldest==mEntries.end())
+			return;
+
+		mMemory -= 1024.0*oldest->second.image->GetActualMemorySize();
+		mSource->purge(oldest->first);
+		mEntries.erase(oldest);
+	}
+}
+
+bool PrefetchingImageDataContainer::insideWindow(unsigned index) const
+{
+	int offset = (int(index) - int(mCurrent)) * mDirection;
+	return (0 <= offset) && (offset <= this->getWindow());
+}
+
+/** Number of frames to read ahead: mReadAhead, reduced so that the
+ *  window fits in memory.
+ */
+int PrefetchingImageDataContainer::getWindow() const
+{
+	if (mFrameMemory==0)
+		return mReadAhead;
+	return std::max(0, std::min(mReadAhead, int(mMemoryLimit/mFrameMemory) - 1));
+}
+
+bool PrefetchingImageDataContainer::purge(unsigned index)
+{
+	QMutexLocker locker(&mMutex);
+	std::map<unsigned, Entry>::iterator iter = mEntries.find(index);
+	if (iter != mEntries.end())
+	{
+		if (iter->second.pending)
+			return false;
+		if (iter->second.image)
+			mMemory -= 1024.0*iter->second.image->GetActualMemorySize();
+		mEntries.erase(iter);
+	}
+	mSource->purge(index);
+	return true;
+}
+
+void PrefetchingImageDataContainer::waitForPrefetch()
+{
+	mPool.waitForDone();
+}
+
+void PrefetchingImageDataContainer::setReadAhead(int frames)
+{
+	QMutexLocker locker(&mMutex);
+	mReadAhead = std::max(frames, 0);
+}
+
+void PrefetchingImageDataContainer::setMemoryLimit(double megabytes)
+{
+	QMutexLocker locker(&mMutex);
+	mMemoryLimit = megabytes*1024*1024;
+	this->evict();
+}
+
+PrefetchingImageDataContainer::Statistics PrefetchingImageDataContainer::getStatistics() const
+{
+	QMutexLocker locker(&mMutex);
+	Statistics retval = mStatistics;
+	retval.memory = mMemory/1024/1024;
+	return retval;
+}
+
+void PrefetchingImageDataContainer::resetStatistics()
+{
+	QMutexLocker locker(&mMutex);
+	mStatistics = Statistics();
+}
+
+} // namespace cx
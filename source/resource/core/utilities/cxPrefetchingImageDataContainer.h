@@ -0,0 +1,103 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXPREFETCHINGIMAGEDATACONTAINER_H
+#define CXPREFETCHINGIMAGEDATACONTAINER_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include "cxImageDataContainer.h"
+
+namespace cx
+{
+
+/** \brief Playback cache in front of another ImageDataContainer.
+ *
+ * Frames are kept in memory until the memory limit is reached, then
+ * the least recently used frames are evicted and purged from the source.
+ *
+ * Each get() schedules loading of the next frames in the direction of
+ * play (given by the previous index) on a background thread pool,
+ * several frames in parallel. Frames scheduled for an earlier position
+ * are skipped when a jump makes them obsolete.
+ *
+ * The source must allow concurrent get() of different indices,
+ * as CachedImageDataContainer does.
+ *
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT PrefetchingImageDataContainer : public ImageDataContainer
+{
+public:
+	struct cxResource_EXPORT Statistics
+	{
+		Statistics();
+		int hits; ///< get() found the frame loaded
+		int misses; ///< get() had to load or wait for the frame
+		int loads;
+		double totalLoadTime; ///< ms, sum of the time used by the source to load each frame
+		double maxLoadTime; ///< ms
+		double maxWaitTime; ///< ms, longest time get() was blocked
+		double memory; ///< MB currently cached
+		double getHitRate() const;
+		double getMeanLoadTime() const; ///< ms
+	};
+
+	explicit PrefetchingImageDataContainer(ImageDataContainerPtr source, int readAhead=30, double memoryLimit=256);
+	virtual ~PrefetchingImageDataContainer();
+	virtual vtkImageDataPtr get(unsigned index);
+	virtual unsigned size() const;
+	virtual bool purge(unsigned index);
+
+	void waitForPrefetch(); ///< block until all scheduled frames are loaded
+	void setReadAhead(int frames);
+	void setMemoryLimit(double megabytes);
+	Statistics getStatistics() const;
+	void resetStatistics();
+
+private:
+	struct Entry
+	{
+		Entry() : pending(false), lastUse(0) {}
+		vtkImageDataPtr image;
+		bool pending; ///< being loaded
+		quint64 lastUse;
+	};
+
+	void load(unsigned index);
+	void prefetch();
+	void evict();
+	bool insideWindow(unsigned index) const;
+	int getWindow() const;
+
+	ImageDataContainerPtr mSource;
+	int mReadAhead;
+	double mMemoryLimit; ///< bytes
+	mutable QMutex mMutex;
+	QWaitCondition mLoaded;
+	QThreadPool mPool;
+	std::map<unsigned, Entry> mEntries;
+	quint64 mUseCount;
+	double mMemory; ///< bytes in mEntries
+	double mFrameMemory; ///< bytes in the first loaded frame
+	unsigned mCurrent; ///< last index from get()
+	int mDirection; ///< +1 or -1, direction of play
+	Statistics mStatistics;
+};
+typedef boost::shared_ptr<PrefetchingImageDataContainer> PrefetchingImageDataContainerPtr;
+
+} // namespace cx
+
+#endif // CXPREFETCHINGIMAGEDATACONTAINER_H
@@ -0,0 +1,284 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxSharedMemoryRing.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace cx
+{
+
+namespace
+{
+const qint32 ringMagic = 0x43585247; // "CXRG"
+
+struct shm_ring_slot
+{
+	qint64 sequence;	// sequence number of the frame in this slot, 0 while being written
+	qint64 timestamp;	// time of writing, ms since epoch
+	qint32 size;		// size of the frame
+	qint32 pad;
+};
+
+// Shared header kept first in shared memory area, followed by the slot
+// descriptors, then the slot data starting at headerSize.
+struct shm_ring_header
+{
+	qint32 magic;
+	qint32 numSlots;
+	qint32 slotSize;
+	qint32 headerSize;
+	qint64 written;		// sequence number of the last completed frame
+	shm_ring_slot slot[0];
+};
+
+int getHeaderSize(int slotCount)
+{
+	int size = sizeof(shm_ring_header) + slotCount * sizeof(shm_ring_slot);
+	return (size + 63) / 64 * 64; // keep the frames cache line aligned
+}
+
+shm_ring_header* getHeader(QSharedMemory& buffer)
+{
+	shm_ring_header* header = static_cast<shm_ring_header*>(buffer.data());
+	if (!header || header->magic != ringMagic)
+		return NULL;
+	return header;
+}
+
+char* getSlotData(shm_ring_header* header, int slot)
+{
+	return reinterpret_cast<char*>(header) + header->headerSize + qint64(header->slotSize) * slot;
+}
+} // namespace
+
+SharedMemoryRingWriter::SharedMemoryRingWriter(QString key, int slotCount, int slotSize, QObject* parent) :
+	mBuffer(key, parent),
+	mSlots(std::max(slotCount, 2)),
+	mSlotSize(slotSize),
+	mCurrentSlot(-1)
+{
+	int headerSize = getHeaderSize(mSlots);
+	int size = headerSize + mSlots * mSlotSize;
+	if (!mBuffer.create(size))
+	{
+		if (mBuffer.error() == QSharedMemory::AlreadyExists && mBuffer.attach() && mBuffer.size() >= size)
+		{
+			qWarning("Reusing existing buffer -- this should generally not happen");
+		}
+		else
+		{
+			qWarning("Failed to create shared memory ring of size %d: %s",
+					 size, mBuffer.errorString().toLatin1().constData());
+			mBuffer.detach();
+			return;
+		}
+	}
+
+	mBuffer.lock();
+	shm_ring_header* header = static_cast<shm_ring_header*>(mBuffer.data());
+	header->numSlots = mSlots;
+	header->slotSize = mSlotSize;
+	header->headerSize = headerSize;
+	header->written = 0;
+	memset(header->slot, 0, sizeof(shm_ring_slot) * mSlots);
+	header->magic = ringMagic;
+	mBuffer.unlock();
+}
+
+SharedMemoryRingWriter::~SharedMemoryRingWriter()
+{
+	// tell attached readers that the ring is gone
+	if (mBuffer.isAttached())
+	{
+		mBuffer.lock();
+		static_cast<shm_ring_header*>(mBuffer.data())->magic = 0;
+		mBuffer.unlock();
+	}
+}
+
+bool SharedMemoryRingWriter::isValid() const
+{
+	return mBuffer.isAttached();
+}
+
+/** The slot after the last written frame holds the oldest frame.
+ *  Invalidate it so that readers in the middle of it can detect the overwrite.
+ */
+void* SharedMemoryRingWriter::beginWrite()
+{
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header)
+		return NULL;
+
+	mBuffer.lock();
+	mCurrentSlot = (header->written + 1) % mSlots;
+	header->slot[mCurrentSlot].sequence = 0;
+	mBuffer.unlock();
+
+	return getSlotData(header, mCurrentSlot);
+}
+
+void SharedMemoryRingWriter::endWrite(int size, QDateTime timestamp)
+{
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header || mCurrentSlot < 0)
+		return;
+
+	mBuffer.lock();
+	shm_ring_slot& slot = header->slot[mCurrentSlot];
+	slot.size = std::min(size, mSlotSize);
+	slot.timestamp = timestamp.toMSecsSinceEpoch();
+	slot.sequence = ++header->written;
+	mBuffer.unlock();
+
+	mCurrentSlot = -1;
+}
+
+bool SharedMemoryRingWriter::write(const void* data, int size, QDateTime timestamp)
+{
+	if (size > mSlotSize)
+		return false;
+	void* dst = this->beginWrite();
+	if (!dst)
+		return false;
+	memcpy(dst, data, size);
+	this->endWrite(size, timestamp);
+	return true;
+}
+
+qint64 SharedMemoryRingWriter::getFramesWritten() const
+{
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header)
+		return 0;
+	mBuffer.lock();
+	qint64 retval = header->written;
+	mBuffer.unlock();
+	return retval;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+SharedMemoryRingReader::SharedMemoryRingReader(QObject* parent) :
+	mBuffer(parent),
+	mSlots(0),
+	mSlotSize(0),
+	mLastRead(0),
+	mSequence(0),
+	mSize(0),
+	mDropped(0)
+{
+}
+
+SharedMemoryRingReader::~SharedMemoryRingReader()
+{
+}
+
+bool SharedMemoryRingReader::attach(const QString& key)
+{
+	if (mBuffer.isAttached())
+		mBuffer.detach();
+	mBuffer.setKey(key);
+	if (!mBuffer.attach(QSharedMemory::ReadOnly))
+		return false;
+
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header)
+	{
+		mBuffer.detach();
+		return false;
+	}
+
+	mBuffer.lock();
+	mSlots = header->numSlots;
+	mSlotSize = header->slotSize;
+	mLastRead = header->written;
+	mBuffer.unlock();
+	mSequence = 0;
+	mSize = 0;
+	mDropped = 0;
+	return true;
+}
+
+bool SharedMemoryRingReader::detach()
+{
+	return mBuffer.detach();
+}
+
+bool SharedMemoryRingReader::isAttached() const
+{
+	return mBuffer.isAttached();
+}
+
+bool SharedMemoryRingReader::isValid() const
+{
+	return getHeader(mBuffer) != NULL;
+}
+
+/** Frames 1..written have been written, and the slot of the oldest of these
+ *  is the next to be overwritten. Thus only the numSlots-1 latest frames are
+ *  guaranteed to be available.
+ */
+const void* SharedMemoryRingReader::beginRead(bool onlyLatest)
+{
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header)
+		return NULL;
+
+	mBuffer.lock();
+	qint64 written = header->written;
+	if (written < mLastRead) // writer restarted
+		mLastRead = 0;
+	if (written == mLastRead)
+	{
+		mBuffer.unlock();
+		return NULL;
+	}
+
+	qint64 oldest = std::max<qint64>(written - mSlots + 2, 1);
+	qint64 next = onlyLatest ? written : std::max(mLastRead + 1, oldest);
+	mDropped += next - (mLastRead + 1);
+
+	const shm_ring_slot& slot = header->slot[next % mSlots];
+	if (slot.sequence != next)
+	{
+		mBuffer.unlock();
+		return NULL;
+	}
+	mSequence = next;
+	mSize = slot.size;
+	mTimestamp.setMSecsSinceEpoch(slot.timestamp);
+	mLastRead = next;
+	mBuffer.unlock();
+
+	return getSlotData(header, next % mSlots);
+}
+
+bool SharedMemoryRingReader::endRead()
+{
+	shm_ring_header* header = getHeader(mBuffer);
+	if (!header || mSequence == 0)
+		return false;
+
+	mBuffer.lock();
+	bool intact = (header->slot[mSequence % mSlots].sequence == mSequence);
+	mBuffer.unlock();
+
+	if (!intact)
+		++mDropped;
+	return intact;
+}
+
+} // namespace cx
@@ -0,0 +1,119 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXSHAREDMEMORYRING_H
+#define CXSHAREDMEMORYRING_H
+
+#include "cxResourceExport.h"
+
+#include <QSharedMemory>
+#include <QDateTime>
+#include <boost/shared_ptr.hpp>
+
+namespace cx
+{
+
+/**\brief Writer end of a ring of frames in shared memory.
+ *
+ * One writer fills the slots in turn, always overwriting the oldest frame.
+ * The writer never waits for readers: a reader that falls behind loses
+ * frames, instead of stalling the writer as SharedMemoryServer does.
+ *
+ * Each frame gets a sequence number, stored in its slot when the frame is
+ * complete. Readers use the sequence number to detect frames that have been
+ * overwritten while they were read.
+ *
+ * \sa SharedMemoryRingReader
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT SharedMemoryRingWriter
+{
+public:
+	/**
+	 * \param key A string identifying this resource. Must be unique system wide
+	 * \param slotCount Number of frames kept in the ring. Must be at least 2.
+	 * \param slotSize Max size of each frame
+	 */
+	SharedMemoryRingWriter(QString key, int slotCount, int slotSize, QObject* parent = 0);
+	~SharedMemoryRingWriter();
+
+	bool isValid() const;
+	QString key() const { return mBuffer.key(); }
+	int slotCount() const { return mSlots; }
+	int slotSize() const { return mSlotSize; }
+
+	void* beginWrite(); ///< Return the slot of the oldest frame, it is invalid until endWrite().
+	void endWrite(int size, QDateTime timestamp = QDateTime::currentDateTime()); ///< Publish the frame started by beginWrite().
+	bool write(const void* data, int size, QDateTime timestamp = QDateTime::currentDateTime()); ///< Copy and publish a frame
+	qint64 getFramesWritten() const;
+
+private:
+	mutable QSharedMemory mBuffer;
+	int mSlots;
+	int mSlotSize;
+	int mCurrentSlot; ///< slot held between beginWrite() and endWrite(), -1 if none
+};
+typedef boost::shared_ptr<SharedMemoryRingWriter> SharedMemoryRingWriterPtr;
+
+/**\brief Reader end of a ring of frames in shared memory.
+ *
+ * Any number of readers can attach to the same ring. Each reader keeps
+ * track of the last frame it has read, and gets the frames in order until
+ * it falls behind, then skips to the oldest frame still in the ring.
+ *
+ * The frame is read directly from shared memory between beginRead() and
+ * endRead(). endRead() returns false if the writer has overwritten the frame
+ * in the meantime; the data must then be discarded.
+ *
+ * \sa SharedMemoryRingWriter
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT SharedMemoryRingReader
+{
+public:
+	SharedMemoryRingReader(QObject* parent = 0);
+	~SharedMemoryRingReader();
+
+	bool attach(const QString& key); ///< Attach and skip all frames written so far
+	bool detach();
+	bool isAttached() const;
+	bool isValid() const; ///< Attached, and the writer still exists
+	QString key() const { return mBuffer.key(); }
+	int slotCount() const { return mSlots; }
+	int slotSize() const { return mSlotSize; }
+
+	/** Return the next unread frame, or NULL if there is none.
+	 *  If onlyLatest, skip all frames except the latest.
+	 */
+	const void* beginRead(bool onlyLatest = false);
+	bool endRead(); ///< Return true if the frame from beginRead() was intact.
+
+	int size() const { return mSize; } ///< Size of the current frame
+	QDateTime timestamp() const { return mTimestamp; } ///< Time of writing of the current frame
+	qint64 sequence() const { return mSequence; } ///< Sequence number of the current frame
+	qint64 getDroppedCount() const { return mDropped; } ///< Number of frames that were overwritten before they could be read
+
+private:
+	mutable QSharedMemory mBuffer;
+	int mSlots;
+	int mSlotSize;
+	qint64 mLastRead;
+	qint64 mSequence;
+	int mSize;
+	QDateTime mTimestamp;
+	qint64 mDropped;
+};
+typedef boost::shared_ptr<SharedMemoryRingReader> SharedMemoryRingReaderPtr;
+
+} // namespace cx
+
+#endif // CXSHAREDMEMORYRING_H
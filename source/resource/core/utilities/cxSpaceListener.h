@@ -14,6 +14,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxResourceExport.h"
 
 #include "cxCoordinateSystemHelpers.h"
+#include "cxTransform3D.h"
 #include <QObject>
 
 namespace cx
@@ -35,6 +36,7 @@ public:
 	virtual ~SpaceListener() {}
 	virtual void setSpace(CoordinateSystem space) = 0;
 	virtual CoordinateSystem getSpace() const = 0;
+	virtual Transform3D get_rMs() = 0; ///< ref_M_space, through a handle cached in the SpaceProvider
 signals:
 	void changed();
 };
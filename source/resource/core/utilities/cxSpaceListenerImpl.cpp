@@ -22,10 +22,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
-SpaceListenerImpl::SpaceListenerImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager)
+SpaceListenerImpl::SpaceListenerImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager, SpaceProvider* spaceProvider)
 {
 	mTrackingService = trackingService;
 	mDataManager = dataManager;
+	mSpaceProvider = spaceProvider;
+	if (mSpaceProvider)
+		mRefHandle = mSpaceProvider->getHandle(CoordinateSystem(csREF));
 }
 
 SpaceListenerImpl::~SpaceListenerImpl()
@@ -36,6 +39,8 @@ void SpaceListenerImpl::setSpace(CoordinateSystem space)
 {
 	this->doDisconnect();
 	mSpace = space;
+	if (mSpaceProvider)
+		mHandle = mSpaceProvider->getHandle(mSpace);
 	this->doConnect();
 	emit changed();
 }
@@ -52,6 +57,13 @@ CoordinateSystem SpaceListenerImpl::getSpace() const
 	return mSpace;
 }
 
+Transform3D SpaceListenerImpl::get_rMs()
+{
+	if (!mSpaceProvider)
+		return Transform3D::Identity();
+	return mSpaceProvider->get_toMfrom(mHandle, mRefHandle);
+}
+
 void SpaceListenerImpl::doConnect()
 {
 	if (mSpace.mId == csDATA)
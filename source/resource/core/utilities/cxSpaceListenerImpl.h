@@ -14,6 +14,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxResourceExport.h"
 
 #include "cxSpaceListener.h"
+#include <QPointer>
+#include "cxSpaceProvider.h"
 
 namespace cx
 {
@@ -32,11 +34,12 @@ class cxResource_EXPORT SpaceListenerImpl: public SpaceListener
 Q_OBJECT
 
 public:
-	SpaceListenerImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager);
+	SpaceListenerImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager, SpaceProvider* spaceProvider=NULL);
 //	SpaceListenerImpl(CoordinateSystem space);
 	virtual ~SpaceListenerImpl();
 	void setSpace(CoordinateSystem space);
 	CoordinateSystem getSpace() const;
+	Transform3D get_rMs();
 //signals:
 //	void changed();
 private slots:
@@ -49,6 +52,9 @@ private:
 	TrackingServicePtr mTrackingService;
 	PatientModelServicePtr mDataManager;
 	ActiveToolProxyPtr mActiveTool;
+	QPointer<SpaceProvider> mSpaceProvider;
+	SpaceHandle mHandle;
+	SpaceHandle mRefHandle;
 };
 
 } // namespace cx
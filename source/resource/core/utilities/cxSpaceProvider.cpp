@@ -23,5 +23,24 @@ SpaceProviderPtr SpaceProvider::getNullObject()
 	return mNull;
 }
 
+std::vector<Transform3D> SpaceProvider::get_toMfromBatch(const std::vector<std::pair<CoordinateSystem, CoordinateSystem> >& fromTo)
+{
+	std::vector<Transform3D> retval;
+	retval.reserve(fromTo.size());
+	for (unsigned i=0; i<fromTo.size(); ++i)
+		retval.push_back(this->get_toMfrom(fromTo[i].first, fromTo[i].second));
+	return retval;
+}
+
+SpaceHandle SpaceProvider::getHandle(CoordinateSystem space)
+{
+	return SpaceHandle(space);
+}
+
+Transform3D SpaceProvider::get_toMfrom(SpaceHandle& from, SpaceHandle& to)
+{
+	return this->get_toMfrom(from.space, to.space);
+}
+
 
 } // namespace cx
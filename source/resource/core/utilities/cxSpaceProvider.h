@@ -22,6 +22,19 @@ namespace cx
 typedef boost::shared_ptr<class SpaceListener> SpaceListenerPtr;
 typedef boost::shared_ptr<class SpaceProvider> SpaceProviderPtr;
 
+/** A space resolved once by a SpaceProvider, for repeated lookups.
+ *  Handles outdated by added or removed spaces are resolved again
+ *  when used. "active" spaces are resolved on each lookup.
+ */
+struct cxResource_EXPORT SpaceHandle
+{
+	SpaceHandle() : node(-1), generation(0) {}
+	explicit SpaceHandle(CoordinateSystem space_) : space(space_), node(-1), generation(0) {}
+	CoordinateSystem space;
+	int node; ///< provider internal, -1 if unresolved
+	unsigned generation; ///< provider internal, node set the node belongs to
+};
+
 /** Provides information about all the coordinate systems in the application.
  *
  *
@@ -36,6 +49,9 @@ public:
 	virtual ~SpaceProvider() {}
 
 	virtual Transform3D get_toMfrom(CoordinateSystem from, CoordinateSystem to) = 0; ///< to_M_from
+	virtual std::vector<Transform3D> get_toMfromBatch(const std::vector<std::pair<CoordinateSystem, CoordinateSystem> >& fromTo); ///< to_M_from for each (from,to)
+	virtual SpaceHandle getHandle(CoordinateSystem space); ///< resolve space once, for use in get_toMfrom(SpaceHandle&, SpaceHandle&)
+	virtual Transform3D get_toMfrom(SpaceHandle& from, SpaceHandle& to); ///< to_M_from, outdated handles are resolved again in place
 	virtual std::vector<CoordinateSystem> getSpacesToPresentInGUI() = 0;
 	virtual std::map<QString, QString> getDisplayNamesForCoordRefObjects() = 0;
 	virtual SpaceListenerPtr createListener() = 0;
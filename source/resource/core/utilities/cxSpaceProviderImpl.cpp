@@ -19,6 +19,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxSpaceListenerImpl.h"
 #include "cxTool.h"
 #include "cxActiveData.h"
+#include "boost/bind.hpp"
+#include <QMutexLocker>
 
 
 namespace cx
@@ -26,16 +28,23 @@ namespace cx
 
 SpaceProviderImpl::SpaceProviderImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager) :
 	mTrackingService(trackingService),
-	mDataManager(dataManager)
+	mDataManager(dataManager),
+	mGeneration(0),
+	mCreatingNodes(false),
+	mNodesMutex(QMutex::Recursive)
 {
-//	connect(mTrackingService.get(), SIGNAL(stateChanged()), this, SIGNAL(spaceAddedOrRemoved()));
-	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceProvider::spaceAddedOrRemoved);
-	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceProvider::spaceAddedOrRemoved);
+	// spaceAddedOrRemoved() is emitted after the graph is rebuilt
+	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceProviderImpl::clearGraphSlot);
+	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceProviderImpl::clearGraphSlot);
+	connect(mDataManager.get(), &PatientModelService::patientChanged, this, &SpaceProviderImpl::clearGraphSlot);
+
+	QMutexLocker locker(&mNodesMutex);
+	this->createNodes();
 }
 
 SpaceListenerPtr SpaceProviderImpl::createListener()
 {
-	return SpaceListenerPtr(new SpaceListenerImpl(mTrackingService, mDataManager));
+	return SpaceListenerPtr(new SpaceListenerImpl(mTrackingService, mDataManager, this));
 }
 
 std::vector<CoordinateSystem> SpaceProviderImpl::getSpacesToPresentInGUI()
@@ -128,43 +137,295 @@ Transform3D SpaceProviderImpl::getActiveToolTipTransform(CoordinateSystem to, bo
 
 Transform3D SpaceProviderImpl::get_toMfrom(CoordinateSystem from, CoordinateSystem to)
 {
-	Transform3D to_M_from = get_rMfrom(to).inv() * get_rMfrom(from);
+	QMutexLocker locker(&mNodesMutex);
+	Transform3D to_M_from = mGraph.get_toMfrom(this->getNode(from), this->getNode(to));
 	return to_M_from;
 }
 
-Transform3D SpaceProviderImpl::get_rMfrom(CoordinateSystem from)
+std::vector<Transform3D> SpaceProviderImpl::get_toMfromBatch(const std::vector<std::pair<CoordinateSystem, CoordinateSystem> >& fromTo)
+{
+	QMutexLocker locker(&mNodesMutex);
+	std::vector<TransformGraph::HandlePair> handles(fromTo.size());
+	for (unsigned i=0; i<fromTo.size(); ++i)
+		handles[i] = TransformGraph::HandlePair(this->getNode(fromTo[i].first), this->getNode(fromTo[i].second));
+	return mGraph.get_toMfrom(handles);
+}
+
+SpaceHandle SpaceProviderImpl::getHandle(CoordinateSystem space)
+{
+	QMutexLocker locker(&mNodesMutex);
+	SpaceHandle retval(space);
+	this->resolve(retval);
+	return retval;
+}
+
+Transform3D SpaceProviderImpl::get_toMfrom(SpaceHandle& from, SpaceHandle& to)
 {
-	Transform3D rMfrom = Transform3D::Identity();
+	QMutexLocker locker(&mNodesMutex);
+	return mGraph.get_toMfrom(this->resolve(from), this->resolve(to));
+}
 
-	switch(from.mId)
+/** Return the node of handle, and store it in the handle if it can be reused.
+ */
+TransformGraph::Handle SpaceProviderImpl::resolve(SpaceHandle& handle)
+{
+	if ((handle.node>=0) && (handle.generation==mGeneration))
+		return handle.node;
+
+	TransformGraph::Handle node = this->getNode(handle.space);
+	bool reusable = (handle.space.mRefObject!="active") && (node!=mGraph.getRoot());
+	handle.node = reusable ? node : -1;
+	handle.generation = mGeneration;
+	return node;
+}
+
+TransformGraph::Statistics SpaceProviderImpl::getStatistics() const
+{
+	return mGraph.getStatistics();
+}
+
+void SpaceProviderImpl::resetStatistics()
+{
+	mGraph.resetStatistics();
+}
+
+/** Find the node for a space. Only unknown or "active" spaces are resolved
+ *  through the tracking and patient services. Unknown spaces are identical to ref.
+ */
+TransformGraph::Handle SpaceProviderImpl::getNode(CoordinateSystem space)
+{
+	if (space.mId==csREF)
+		return mGraph.getRoot();
+
+	if (space.mRefObject!="active")
+	{
+		std::map<NodeKey, TransformGraph::Handle>::iterator iter = mNodes.find(NodeKey(space.mId, space.mRefObject));
+		if (iter!=mNodes.end())
+			return iter->second;
+	}
+
+	TransformGraph::Handle node = this->findNode(space);
+	if ((space.mRefObject!="active") && (node!=mGraph.getRoot()))
+		mNodes[NodeKey(space.mId, space.mRefObject)] = node; // alias, e.g. pr with a tool uid
+	return node;
+}
+
+TransformGraph::Handle SpaceProviderImpl::findNode(CoordinateSystem space)
+{
+	bool isDataSpace = (space.mId==csDATA) || (space.mId==csDATA_VOXEL);
+	if (isDataSpace && !mDataManager->isPatientValid())
+		return mGraph.getRoot();
+
+	switch(space.mId)
 	{
-	case csREF:
-		rMfrom = get_rMr();
-		break;
 	case csDATA:
-		rMfrom = get_rMd(from.mRefObject);
-		break;
+		return this->getDataNode(this->findData(space.mRefObject));
 	case csPATIENTREF:
-		rMfrom = get_rMpr();
-		break;
+		return this->getPatientRefNode();
 	case csTOOL:
-		rMfrom = get_rMt(from.mRefObject);
-		break;
+		return this->getToolNode(this->findTool(space.mRefObject));
 	case csSENSOR:
-		rMfrom = get_rMs(from.mRefObject);
-		break;
+		return this->getSensorNode(this->findTool(space.mRefObject));
 	case csTOOL_OFFSET:
-		rMfrom = get_rMto(from.mRefObject);
-		break;
+		return this->getToolOffsetNode(this->findTool(space.mRefObject));
 	case csDATA_VOXEL:
-		rMfrom = get_rMdv(from.mRefObject);
-		break;
+		return this->getDataVoxelNode(this->findData(space.mRefObject));
+	case csREF:
 	default:
-
-		break;
+		return mGraph.getRoot();
 	};
+}
+
+namespace
+{
+Transform3D get_dMdv(DataPtr data)
+{
+	ImagePtr image = boost::dynamic_pointer_cast<Image>(data);
+	if (!image)
+		return Transform3D::Identity();
+	return createTransformScale(Vector3D(image->getSpacing().matrix()));
+}
+
+Transform3D get_tMto(ToolPtr tool)
+{
+	return createTransformTranslate(Vector3D(0,0,tool->getTooltipOffset()));
+}
+
+Transform3D get_tMs(ToolPtr tool)
+{
+	return tool->getCalibration_sMt().inv();
+}
+} // namespace
+
+TransformGraph::Handle SpaceProviderImpl::getPatientRefNode()
+{
+	NodeKey key(csPATIENTREF, "");
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, mGraph.getRoot(), boost::bind(&PatientModelService::get_rMpr, mDataManager));
+}
+
+TransformGraph::Handle SpaceProviderImpl::getDataNode(DataPtr data)
+{
+	if (!data)
+		return mGraph.getRoot();
+
+	NodeKey key(csDATA, data->getUid());
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, mGraph.getRoot(), boost::bind(&Data::get_rMd, data));
+}
+
+TransformGraph::Handle SpaceProviderImpl::getDataVoxelNode(DataPtr data)
+{
+	if (!data)
+		return mGraph.getRoot();
+
+	NodeKey key(csDATA_VOXEL, data->getUid());
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, this->getDataNode(data), boost::bind(&get_dMdv, data));
+}
+
+TransformGraph::Handle SpaceProviderImpl::getToolNode(ToolPtr tool)
+{
+	if (!tool)
+		return mGraph.getRoot();
+
+	NodeKey key(csTOOL, tool->getUid());
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, this->getPatientRefNode(), boost::bind(&Tool::get_prMt, tool));
+}
+
+TransformGraph::Handle SpaceProviderImpl::getToolOffsetNode(ToolPtr tool)
+{
+	if (!tool)
+		return mGraph.getRoot();
+
+	NodeKey key(csTOOL_OFFSET, tool->getUid());
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, this->getToolNode(tool), boost::bind(&get_tMto, tool));
+}
+
+/** The calibration has no change signal, so the sensor node is polled.
+ */
+TransformGraph::Handle SpaceProviderImpl::getSensorNode(ToolPtr tool)
+{
+	if (!tool)
+		return mGraph.getRoot();
+
+	NodeKey key(csSENSOR, tool->getUid());
+	if (mNodes.count(key))
+		return mNodes[key];
+
+	return this->addNode(key, this->getToolNode(tool), boost::bind(&get_tMs, tool), true);
+}
+
+TransformGraph::Handle SpaceProviderImpl::addNode(NodeKey key, TransformGraph::Handle parent, TransformGraph::TransformFunction parentMnode, bool polled)
+{
+	TransformGraph::Handle node = mGraph.addNode(parent, parentMnode, polled || !mCreatingNodes);
+	mNodes[key] = node;
+	return node;
+}
+
+/** Invalidate node each time source emits signal. Direct connections are
+ *  used, as tools might emit from other threads.
+ */
+template<class SOURCE, class SIGNAL_FUNC>
+void SpaceProviderImpl::invalidateOn(SOURCE* source, SIGNAL_FUNC signal, TransformGraph::Handle node)
+{
+	TransformGraph* graph = &mGraph;
+	mInvalidations.push_back(connect(source, signal, this, [graph, node]() { graph->invalidate(node); }, Qt::DirectConnection));
+}
+
+/** Create the nodes of all current tools and data, and invalidate them on
+ *  their change signals. This runs when the tools or data appear, before
+ *  most other objects connect to their signals. Spaces that appear without
+ *  notification get polled nodes on first lookup.
+ */
+void SpaceProviderImpl::createNodes()
+{
+	mCreatingNodes = true;
+	this->createAndConnectNodes();
+	mCreatingNodes = false;
+}
+
+void SpaceProviderImpl::createAndConnectNodes()
+{
+	this->invalidateOn(mDataManager.get(), &PatientModelService::rMprChanged, this->getPatientRefNode());
+
+	std::map<QString, ToolPtr> tools = mTrackingService->getTools();
+	for (std::map<QString, ToolPtr>::iterator i=tools.begin(); i!=tools.end(); ++i)
+	{
+		ToolPtr tool = i->second;
+		this->invalidateOn(tool.get(), &Tool::toolTransformAndTimestamp, this->getToolNode(tool));
+		this->invalidateOn(tool.get(), &Tool::tooltipOffset, this->getToolOffsetNode(tool));
+		this->getSensorNode(tool);
+	}
+
+	if (!mDataManager->isPatientValid())
+		return;
+	std::map<QString, DataPtr> data = mDataManager->getDatas();
+	for (std::map<QString, DataPtr>::iterator i=data.begin(); i!=data.end(); ++i)
+	{
+		DataPtr current = i->second;
+		this->invalidateOn(current.get(), &Data::transformChanged, this->getDataNode(current));
+		TransformGraph::Handle voxelNode = this->getDataVoxelNode(current);
+		ImagePtr image = boost::dynamic_pointer_cast<Image>(current);
+		if (image)
+			this->invalidateOn(image.get(), &Image::vtkImageDataChanged, voxelNode);
+	}
+}
+
+/** Rebuild all nodes from the current tools and data.
+ */
+void SpaceProviderImpl::clearGraphSlot()
+{
+	{
+		QMutexLocker locker(&mNodesMutex);
+		for (unsigned i=0; i<mInvalidations.size(); ++i)
+			QObject::disconnect(mInvalidations[i]);
+		mInvalidations.clear();
+		mNodes.clear();
+		mGraph.clear();
+		++mGeneration;
+		this->createNodes();
+	}
+	emit spaceAddedOrRemoved();
+}
+
+DataPtr SpaceProviderImpl::findData(QString uid)
+{
+	DataPtr data = mDataManager->getData(uid);
+
+	if (!data && uid=="active")
+	{
+		ActiveDataPtr activeData = mDataManager->getActiveData();
+		data = activeData->getActive<Image>();
+	}
 
-	return rMfrom;
+	if(!data)
+		reportWarning("Could not find data with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
+	return data;
+}
+
+ToolPtr SpaceProviderImpl::findTool(QString uid)
+{
+	ToolPtr tool = mTrackingService->getTool(uid);
+
+	if (!tool && uid=="active")
+		tool = mTrackingService->getActiveTool();
+
+	if(!tool)
+		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
+	return tool;
 }
 
 CoordinateSystem SpaceProviderImpl::getS(ToolPtr tool)
@@ -261,117 +522,9 @@ CoordinateSystem SpaceProviderImpl::convertToSpecific(CoordinateSystem space)
 	return space;
 }
 
-Transform3D SpaceProviderImpl::get_rMr()
-{
-	return Transform3D::Identity(); // ref_M_ref
-}
-
-Transform3D SpaceProviderImpl::get_rMd(QString uid)
-{
-	if (!mDataManager->isPatientValid())
-		return Transform3D::Identity();
-
-	DataPtr data = mDataManager->getData(uid);
-
-	if (!data && uid=="active")
-	{
-		ActiveDataPtr activeData = mDataManager->getActiveData();
-		data = activeData->getActive<Image>();
-	}
-
-	if(!data)
-	{
-		reportWarning("Could not find data with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
-		return Transform3D::Identity();
-	}
-	return data->get_rMd(); // ref_M_d
-}
-
-Transform3D SpaceProviderImpl::get_rMdv(QString uid)
-{
-	if (!mDataManager->isPatientValid())
-		return Transform3D::Identity();
-
-	DataPtr data = mDataManager->getData(uid);
-
-	if (!data && uid=="active")
-	{
-		ActiveDataPtr activeData = mDataManager->getActiveData();
-		data = activeData->getActive<Image>();
-	}
-
-	if(!data)
-	{
-		reportWarning("Could not find data with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
-		return Transform3D::Identity();
-	}
-
-	ImagePtr image = boost::dynamic_pointer_cast<Image>(data);
-	if (!image)
-		return data->get_rMd();
-	return data->get_rMd()*createTransformScale(Vector3D(image->getBaseVtkImageData()->GetSpacing())); // ref_M_d
-}
-
 Transform3D SpaceProviderImpl::get_rMpr()
 {
-	Transform3D rMpr = mDataManager->get_rMpr();
-	return rMpr; //ref_M_pr
-}
-
-Transform3D SpaceProviderImpl::get_rMt(QString uid)
-{
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
-	if(!tool)
-	{
-		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
-		return Transform3D::Identity();
-	}
-	return get_rMpr() * tool->get_prMt(); // ref_M_t
-}
-
-Transform3D SpaceProviderImpl::get_rMto(QString uid)
-{
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
-	if(!tool)
-	{
-		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
-		return Transform3D::Identity();
-	}
-
-	double offset = tool->getTooltipOffset();
-	Transform3D tMto = createTransformTranslate(Vector3D(0,0,offset));
-	return get_rMpr() * tool->get_prMt() * tMto; // ref_M_to
-}
-
-Transform3D SpaceProviderImpl::get_rMs(QString uid)
-{
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
-	if(!tool)
-	{
-		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
-		return Transform3D::Identity();
-	}
-
-	Transform3D tMs = tool->getCalibration_sMt().inv();
-
-	Transform3D rMpr = get_rMpr();
-	Transform3D prMt = tool->get_prMt();
-
-	Transform3D rMs = rMpr * prMt * tMs;
-
-	return rMs; //ref_M_s
+	return mGraph.get_rootMnode(this->getPatientRefNode()); //ref_M_pr
 }
 
 
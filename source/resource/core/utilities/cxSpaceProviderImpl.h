@@ -13,14 +13,31 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxResourceExport.h"
 
+#include <QMutex>
 #include "cxSpaceProvider.h"
 #include "cxForwardDeclarations.h"
+#include "cxTransformGraph.h"
 
 namespace cx
 {
 
 /** Provides information about all the coordinate systems in the application.
  *
+ * The spaces are nodes in a TransformGraph, created for all tools and
+ * data when the graph is rebuilt, i.e. when tools or data are added or
+ * removed. The nodes are cached by space, so only "active" spaces are
+ * resolved through the tracking and patient services on lookup.
+ *
+ * A node is invalidated directly from the change signal of its tool or
+ * data, and its version stamp is increased on the next lookup, see
+ * TransformGraph. The provider connects to the signals as soon as the
+ * tools and data appear, before views and listeners connect to them, so
+ * their slots see the new transforms. The sensor calibration has no
+ * change signal and is polled. Composed and inverted transforms are
+ * cached until a local transform along the path changes.
+ *
+ * Lookups are thread safe. The tools and data themselves are read
+ * without locking, as before.
  *
  * \ingroup cx_resource_core_utilities
  * \date 2014-02-21
@@ -28,11 +45,15 @@ namespace cx
  */
 class cxResource_EXPORT SpaceProviderImpl : public SpaceProvider
 {
+	Q_OBJECT
 public:
 	SpaceProviderImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager);
 	virtual ~SpaceProviderImpl() {}
 
 	virtual Transform3D get_toMfrom(CoordinateSystem from, CoordinateSystem to); ///< to_M_from
+	virtual std::vector<Transform3D> get_toMfromBatch(const std::vector<std::pair<CoordinateSystem, CoordinateSystem> >& fromTo);
+	virtual SpaceHandle getHandle(CoordinateSystem space);
+	virtual Transform3D get_toMfrom(SpaceHandle& from, SpaceHandle& to);
 	virtual std::vector<CoordinateSystem> getSpacesToPresentInGUI();
 	virtual std::map<QString, QString> getDisplayNamesForCoordRefObjects();
 	virtual SpaceListenerPtr createListener();
@@ -49,21 +70,42 @@ public:
 	virtual CoordinateSystem getR(); ///<data references coordinate system
 	virtual CoordinateSystem convertToSpecific(CoordinateSystem space);
 
+	TransformGraph::Statistics getStatistics() const; ///< cache hit rate and lookup cost
+	void resetStatistics();
+
+private slots:
+	void clearGraphSlot();
+
 private:
-	Transform3D get_rMfrom(CoordinateSystem from); ///< ref_M_from
+	typedef std::pair<int, QString> NodeKey; ///< (COORDINATE_SYSTEM, uid)
 
-	Transform3D get_rMr(); ///< ref_M_ref
-	Transform3D get_rMd(QString uid);
-	Transform3D get_rMdv(QString uid);
-//	Transform3D get_rMpr();
-	Transform3D get_rMt(QString uid);
-	Transform3D get_rMto(QString uid);
-	Transform3D get_rMs(QString uid);
+	TransformGraph::Handle getNode(CoordinateSystem space);
+	TransformGraph::Handle resolve(SpaceHandle& handle);
+	TransformGraph::Handle findNode(CoordinateSystem space);
+	TransformGraph::Handle getPatientRefNode();
+	TransformGraph::Handle getDataNode(DataPtr data);
+	TransformGraph::Handle getDataVoxelNode(DataPtr data);
+	TransformGraph::Handle getToolNode(ToolPtr tool);
+	TransformGraph::Handle getToolOffsetNode(ToolPtr tool);
+	TransformGraph::Handle getSensorNode(ToolPtr tool);
+	TransformGraph::Handle addNode(NodeKey key, TransformGraph::Handle parent, TransformGraph::TransformFunction parentMnode, bool polled=false);
+	void createNodes();
+	void createAndConnectNodes();
+	template<class SOURCE, class SIGNAL_FUNC>
+	void invalidateOn(SOURCE* source, SIGNAL_FUNC signal, TransformGraph::Handle node);
+	DataPtr findData(QString uid);
+	ToolPtr findTool(QString uid);
 
 	CoordinateSystem getToolCoordinateSystem(ToolPtr tool);
 
 	TrackingServicePtr mTrackingService;
 	PatientModelServicePtr mDataManager;
+	TransformGraph mGraph;
+	std::map<NodeKey, TransformGraph::Handle> mNodes; ///< node for each space
+	unsigned mGeneration; ///< increased when the graph is rebuilt, see SpaceHandle
+	bool mCreatingNodes; ///< nodes created outside createNodes() have no invalidation and are polled
+	std::vector<QMetaObject::Connection> mInvalidations; ///< from tools and data to their nodes
+	QMutex mNodesMutex; ///< protects mNodes and node creation
 };
 
 } // namespace cx
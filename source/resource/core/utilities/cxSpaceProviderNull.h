@@ -20,6 +20,7 @@ class cxResource_EXPORT SpaceProviderNull : public SpaceProvider
 {
 public:
 	SpaceProviderNull();
+	using SpaceProvider::get_toMfrom;
 	Transform3D get_toMfrom(CoordinateSystem from, CoordinateSystem to);
 	std::vector<CoordinateSystem> getSpacesToPresentInGUI();
 	std::map<QString, QString> getDisplayNamesForCoordRefObjects();
@@ -0,0 +1,107 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxTraceController.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include "cxTracer.h"
+#include "cxSettings.h"
+#include "cxReporter.h"
+#include "cxTime.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+TraceController* TraceController::mInstance = NULL;
+
+void TraceController::initialize()
+{
+	if (mInstance)
+		return;
+	mInstance = new TraceController();
+}
+
+void TraceController::shutdown()
+{
+	if (!mInstance)
+		return;
+	if (Tracer::isEnabled())
+		writeTrace();
+	Tracer::setEnabled(false);
+	delete mInstance;
+	mInstance = NULL;
+}
+
+TraceController::TraceController() :
+	mCommandLineTrace(false)
+{
+	QStringList args = QCoreApplication::arguments();
+	for (int i=0; i<args.size(); ++i)
+	{
+		if (args[i] == "--trace")
+			mCommandLineTrace = true;
+		if (args[i].startsWith("--trace="))
+		{
+			mCommandLineTrace = true;
+			mFilename = args[i].mid(QString("--trace=").size());
+		}
+	}
+
+	connect(settings(), &Settings::valueChangedFor, this, &TraceController::settingsChangedSlot);
+	Tracer::setThreadName("Main");
+	this->setEnabled(mCommandLineTrace || settings()->value("performanceTracing").toBool());
+}
+
+void TraceController::settingsChangedSlot(QString key)
+{
+	if (key != "performanceTracing")
+		return;
+	bool on = settings()->value("performanceTracing").toBool() || mCommandLineTrace;
+	if (on == Tracer::isEnabled())
+		return;
+	if (!on)
+		writeTrace();
+	this->setEnabled(on);
+}
+
+void TraceController::setEnabled(bool on)
+{
+	if (on)
+	{
+		Tracer::clear();
+		CX_LOG_INFO() << "Performance tracing enabled, trace is written to " << this->getTraceFilename() << " when disabled";
+	}
+	Tracer::setEnabled(on);
+}
+
+QString TraceController::getTraceFilename() const
+{
+	if (!mFilename.isEmpty())
+		return mFilename;
+	QString timestamp = QDateTime::currentDateTime().toString(timestampSecondsFormat());
+	return QString("%1/trace_%2.json").arg(reporter()->getLoggingFolder()).arg(timestamp);
+}
+
+bool TraceController::writeTrace()
+{
+	if (!mInstance)
+		return false;
+	QString filename = mInstance->getTraceFilename();
+	bool success = Tracer::writeChromeTrace(filename);
+	if (success)
+		CX_LOG_INFO() << "Wrote performance trace with " << Tracer::getEventCount() << " events to " << filename;
+	Tracer::clear();
+	return success;
+}
+
+} // namespace cx
@@ -0,0 +1,57 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTRACECONTROLLER_H
+#define CXTRACECONTROLLER_H
+
+#include "cxResourceExport.h"
+
+#include <QObject>
+
+namespace cx
+{
+
+/**\brief Turn Tracer on and off from settings and the command line.
+ *
+ * Tracing is enabled by the setting "performanceTracing" (Preferences->Debug),
+ * or by starting the application with --trace or --trace=<filename>.
+ * When tracing is turned off or the application shuts down, the trace is
+ * written to the filename given on the command line, or to
+ * trace_<timestamp>.json in the logging folder.
+ *
+ * \sa Tracer
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT TraceController : public QObject
+{
+	Q_OBJECT
+public:
+	static void initialize();
+	static void shutdown();
+
+	static bool writeTrace(); ///< write and clear the events recorded so far
+
+private slots:
+	void settingsChangedSlot(QString key);
+
+private:
+	TraceController();
+	void setEnabled(bool on);
+	QString getTraceFilename() const;
+
+	static TraceController* mInstance;
+	QString mFilename; ///< from the command line, empty gives a default name
+	bool mCommandLineTrace;
+};
+
+} // namespace cx
+
+#endif // CXTRACECONTROLLER_H
@@ -0,0 +1,355 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxTracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCoreApplication>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+
+const quint64 bufferCapacity = 1 << 16; ///< events per thread
+const unsigned maxFinishedThreads = 64; ///< finished threads with events kept for the trace
+
+struct TraceEvent
+{
+	const char* category;
+	const char* name;
+	qint64 timestamp; ///< ns
+	qint64 duration; ///< ns
+	double value;
+	char phase; ///< Chrome trace phase: 'X' span, 'i' instant, 'C' counter
+};
+
+/** Ring of events written by one thread, read by the trace writer.
+ *  head is the total number of events written, events before tail
+ *  have been cleared.
+ *
+ *  The writer does not lock. Readers copy the events and then check
+ *  head again: events the writer might have overwritten during the copy
+ *  are discarded, see snapshot().
+ *
+ *  When the thread exits, the live events are moved to the smaller
+ *  retained list and the ring is freed.
+ */
+struct ThreadBuffer
+{
+	ThreadBuffer(int id, QString name) : events(bufferCapacity), head(0), tail(0), threadId(id), threadName(name), finished(false) {}
+
+	void push(const TraceEvent& event)
+	{
+		quint64 h = head.load(std::memory_order_relaxed);
+		events[h % bufferCapacity] = event;
+		head.store(h+1, std::memory_order_release);
+	}
+
+	/** Consistent copy of the events held, oldest first.
+	 *  Set writing if the thread might push during the copy.
+	 *  Call with the registry mutex locked.
+	 */
+	std::vector<TraceEvent> snapshot(bool writing=true) const
+	{
+		if (finished)
+			return retained;
+
+		quint64 h = head.load(std::memory_order_acquire);
+		quint64 first = std::max(tail.load(), h > bufferCapacity ? h - bufferCapacity : 0);
+		std::vector<TraceEvent> retval;
+		retval.reserve(h-first);
+		for (quint64 j=first; j<h; ++j)
+			retval.push_back(events[j % bufferCapacity]);
+
+		if (!writing)
+			return retval;
+
+		// event j is overwritten by event j+bufferCapacity, which may be
+		// in progress when head has reached it
+		std::atomic_thread_fence(std::memory_order_acquire);
+		quint64 h2 = head.load(std::memory_order_relaxed);
+		quint64 valid = (h2 >= bufferCapacity) ? h2 - bufferCapacity + 1 : 0;
+		if (valid > first)
+			retval.erase(retval.begin(), retval.begin() + std::min<quint64>(valid-first, retval.size()));
+		return retval;
+	}
+
+	std::vector<TraceEvent> events;
+	std::atomic<quint64> head;
+	std::atomic<quint64> tail;
+	int threadId;
+	QString threadName; ///< guarded by the registry mutex
+	bool finished; ///< the thread has exited, guarded by the registry mutex
+	std::vector<TraceEvent> retained; ///< events of a finished thread, guarded by the registry mutex
+};
+typedef boost::shared_ptr<ThreadBuffer> ThreadBufferPtr;
+
+/** All thread buffers. Events from finished threads are kept, in order
+ *  to write events from finished worker threads, but only for the last
+ *  maxFinishedThreads of them.
+ */
+struct TraceRegistry
+{
+	std::mutex mutex;
+	std::vector<ThreadBufferPtr> buffers;
+	std::set<std::string> strings;
+	int nextThreadId;
+
+	TraceRegistry() : nextThreadId(1) {}
+
+	/** Keep the events of a finished thread and free its ring. */
+	void finish(ThreadBuffer* buffer)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffer->retained = buffer->snapshot(false);
+		buffer->finished = true;
+		std::vector<TraceEvent>().swap(buffer->events);
+
+		unsigned finishedCount = 0;
+		for (int i=int(buffers.size())-1; i>=0; --i)
+		{
+			if (!buffers[i]->finished)
+				continue;
+			++finishedCount;
+			if (buffers[i]->retained.empty() || finishedCount > maxFinishedThreads)
+				buffers.erase(buffers.begin()+i);
+		}
+	}
+};
+
+TraceRegistry& getRegistry()
+{
+	static TraceRegistry registry;
+	return registry;
+}
+
+/** Owns the buffer of one thread, and releases it when the thread exits.
+ */
+struct ThreadBufferHolder
+{
+	ThreadBufferHolder() : buffer(NULL) {}
+	~ThreadBufferHolder()
+	{
+		if (buffer)
+			getRegistry().finish(buffer);
+	}
+	ThreadBuffer* buffer;
+};
+
+thread_local ThreadBufferHolder threadBuffer;
+
+ThreadBuffer* getThreadBuffer()
+{
+	if (threadBuffer.buffer)
+		return threadBuffer.buffer;
+
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	int id = registry.nextThreadId++;
+
+	QString name;
+	QThread* thread = QThread::currentThread();
+	if (thread)
+		name = thread->objectName();
+	if (name.isEmpty() && QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+		name = "Main";
+	if (name.isEmpty())
+		name = QString("Thread %1").arg(id);
+
+	ThreadBufferPtr buffer(new ThreadBuffer(id, name));
+	registry.buffers.push_back(buffer);
+	threadBuffer.buffer = buffer.get();
+	return threadBuffer.buffer;
+}
+
+void record(char phase, const char* category, const char* name, qint64 timestamp, qint64 duration, double value)
+{
+	TraceEvent event;
+	event.category = category;
+	event.name = name;
+	event.timestamp = timestamp;
+	event.duration = duration;
+	event.value = value;
+	event.phase = phase;
+	getThreadBuffer()->push(event);
+}
+
+QByteArray toJsonString(const char* text)
+{
+	QByteArray retval("\"");
+	for (const char* c = text; c && *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			retval += '\\';
+		if (static_cast<unsigned char>(*c) < 0x20)
+			continue;
+		retval += *c;
+	}
+	retval += "\"";
+	return retval;
+}
+
+QByteArray toMicroseconds(qint64 ns)
+{
+	return QByteArray::number(double(ns) / 1000.0, 'f', 3);
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::mEnabled(false);
+
+void Tracer::setEnabled(bool on)
+{
+	mEnabled.store(on);
+}
+
+qint64 Tracer::now()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Tracer::span(const char* category, const char* name, qint64 start, qint64 duration)
+{
+	record('X', category, name, start, duration, 0);
+}
+
+void Tracer::instant(const char* category, const char* name)
+{
+	record('i', category, name, now(), 0, 0);
+}
+
+void Tracer::counter(const char* category, const char* name, double value)
+{
+	record('C', category, name, now(), 0, value);
+}
+
+void Tracer::setThreadName(QString name)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(getRegistry().mutex);
+	buffer->threadName = name;
+}
+
+const char* Tracer::intern(QString text)
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return registry.strings.insert(text.toStdString()).first->c_str();
+}
+
+void Tracer::clear()
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (int i=int(registry.buffers.size())-1; i>=0; --i)
+	{
+		if (registry.buffers[i]->finished)
+			registry.buffers.erase(registry.buffers.begin()+i);
+		else
+			registry.buffers[i]->tail.store(registry.buffers[i]->head.load());
+	}
+}
+
+int Tracer::getEventCount()
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	quint64 retval = 0;
+	for (unsigned i=0; i<registry.buffers.size(); ++i)
+	{
+		ThreadBuffer* buffer = registry.buffers[i].get();
+		if (buffer->finished)
+			retval += buffer->retained.size();
+		else
+			retval += std::min(buffer->head.load() - buffer->tail.load(), bufferCapacity);
+	}
+	return int(retval);
+}
+
+int Tracer::getThreadCount()
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return int(registry.buffers.size());
+}
+
+/** Write all events in the Chrome trace event format.
+ *  Events overwritten while a buffer is copied are left out.
+ */
+bool Tracer::writeChromeTrace(QString filename)
+{
+	QDir().mkpath(QFileInfo(filename).absolutePath());
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		CX_LOG_WARNING() << "Tracer: Failed to write trace to " << filename;
+		return false;
+	}
+
+	QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+	QByteArray processName = QCoreApplication::applicationName().toUtf8();
+
+	QByteArray out;
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"args\":{\"name\":" + toJsonString(processName.constData()) + "}}";
+
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (unsigned i=0; i<registry.buffers.size(); ++i)
+	{
+		ThreadBuffer* buffer = registry.buffers[i].get();
+		QByteArray tid = QByteArray::number(buffer->threadId);
+		out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+				+ ",\"args\":{\"name\":" + toJsonString(buffer->threadName.toUtf8().constData()) + "}}";
+
+		std::vector<TraceEvent> events = buffer->snapshot();
+		for (unsigned j=0; j<events.size(); ++j)
+		{
+			const TraceEvent& event = events[j];
+			out += ",\n{\"name\":" + toJsonString(event.name) + ",\"cat\":" + toJsonString(event.category);
+			out += ",\"ph\":\"" + QByteArray(1, event.phase) + "\",\"ts\":" + toMicroseconds(event.timestamp);
+			out += ",\"pid\":" + pid + ",\"tid\":" + tid;
+			if (event.phase == 'X')
+				out += ",\"dur\":" + toMicroseconds(event.duration);
+			if (event.phase == 'i')
+				out += ",\"s\":\"t\"";
+			if (event.phase == 'C')
+				out += ",\"args\":{" + toJsonString(event.name) + ":" + QByteArray::number(event.value, 'g', 10) + "}";
+			out += "}";
+		}
+
+		if (out.size() > 1<<20)
+		{
+			file.write(out);
+			out.clear();
+		}
+	}
+
+	out += "\n]}\n";
+	file.write(out);
+	return true;
+}
+
+} // namespace cx
@@ -0,0 +1,108 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTRACER_H
+#define CXTRACER_H
+
+#include "cxResourceExport.h"
+
+#include <atomic>
+#include <QString>
+
+namespace cx
+{
+
+/**\brief Low overhead timeline tracing of the processing pipeline.
+ *
+ * Records spans (a named piece of work on a thread), instant events and
+ * counter values, and writes them as a Chrome trace, viewable in
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Each thread writes to its own ring buffer without locking, keeping the
+ * latest events. When tracing is disabled, the macros cost one relaxed
+ * atomic load.
+ *
+ * Category and name must be string literals, or strings returned by
+ * intern(), as only the pointers are stored.
+ *
+ * Usage:
+ * \code
+ *   void Reconstructer::reconstruct()
+ *   {
+ *       CX_TRACE_SCOPE("reconstruction", "reconstruct");
+ *       ...
+ *       CX_TRACE_COUNTER("video", "queue size", queue.size());
+ *   }
+ * \endcode
+ *
+ * \sa TraceController
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT Tracer
+{
+public:
+	static bool isEnabled() { return mEnabled.load(std::memory_order_relaxed); }
+	static void setEnabled(bool on);
+
+	static qint64 now(); ///< ns since the trace clock started
+	static void span(const char* category, const char* name, qint64 start, qint64 duration); ///< a completed piece of work, times from now()
+	static void instant(const char* category, const char* name);
+	static void counter(const char* category, const char* name, double value);
+	static void setThreadName(QString name); ///< name the current thread in the trace, default is the QThread object name
+	static const char* intern(QString text); ///< return a pointer to a permanent copy of text, for use as a name
+
+	static void clear(); ///< forget all events recorded so far
+	static int getEventCount(); ///< number of events currently held in the buffers
+	static int getThreadCount(); ///< number of threads with events or a live buffer
+	static bool writeChromeTrace(QString filename);
+
+private:
+	static std::atomic<bool> mEnabled;
+};
+
+/**\brief Record the lifetime of this object as a span.
+ *
+ * Use through CX_TRACE_SCOPE.
+ */
+class cxResource_EXPORT ScopedTraceSpan
+{
+public:
+	ScopedTraceSpan(const char* category, const char* name) :
+		mCategory(category), mName(name), mStart(-1)
+	{
+		if (Tracer::isEnabled())
+			mStart = Tracer::now();
+	}
+	~ScopedTraceSpan()
+	{
+		if (mStart >= 0 && Tracer::isEnabled())
+			Tracer::span(mCategory, mName, mStart, Tracer::now()-mStart);
+	}
+
+private:
+	const char* mCategory;
+	const char* mName;
+	qint64 mStart;
+};
+
+} // namespace cx
+
+#define CX_TRACE_CONCAT_IMPL(a, b) a##b
+#define CX_TRACE_CONCAT(a, b) CX_TRACE_CONCAT_IMPL(a, b)
+
+/** Record the rest of the enclosing scope as a span. */
+#define CX_TRACE_SCOPE(category, name) cx::ScopedTraceSpan CX_TRACE_CONCAT(cxTraceSpan, __LINE__)(category, name)
+/** Record a point in time. */
+#define CX_TRACE_INSTANT(category, name) do { if (cx::Tracer::isEnabled()) cx::Tracer::instant(category, name); } while (0)
+/** Record a value on a counter track. */
+#define CX_TRACE_COUNTER(category, name, value) do { if (cx::Tracer::isEnabled()) cx::Tracer::counter(category, name, value); } while (0)
+
+#endif // CXTRACER_H
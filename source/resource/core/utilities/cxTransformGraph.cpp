@@ -0,0 +1,215 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxTransformGraph.h"
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+namespace cx
+{
+
+TransformGraph::Statistics::Statistics() :
+	lookups(0), hits(0), nodeUpdates(0), totalTime(0)
+{
+}
+
+double TransformGraph::Statistics::getHitRate() const
+{
+	if (lookups==0)
+		return 0;
+	return double(hits)/lookups;
+}
+
+double TransformGraph::Statistics::getMeanLookupTime() const
+{
+	if (lookups==0)
+		return 0;
+	return totalTime/lookups;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+TransformGraph::TransformGraph()
+{
+	this->clear();
+}
+
+TransformGraph::Handle TransformGraph::getRoot() const
+{
+	return 0;
+}
+
+TransformGraph::Handle TransformGraph::addNode(Handle parent, TransformFunction parentMnode, bool polled)
+{
+	QMutexLocker locker(&mMutex);
+	Node node;
+	node.parent = this->isValid(parent) ? parent : this->getRoot();
+	node.parentMnode = parentMnode;
+	node.polled = polled;
+	mNodes.push_back(node);
+	return Handle(mNodes.size()-1);
+}
+
+bool TransformGraph::isValid(Handle node) const
+{
+	return (0 <= node) && (node < int(mNodes.size()));
+}
+
+void TransformGraph::invalidate(Handle node)
+{
+	QMutexLocker locker(&mMutex);
+	if (this->isValid(node) && node!=this->getRoot())
+		mNodes[node].dirty = true;
+}
+
+void TransformGraph::clear()
+{
+	QMutexLocker locker(&mMutex);
+	Node root;
+	root.dirty = false;
+	root.local = Transform3D::Identity();
+	root.rootMnode = Transform3D::Identity();
+	root.version = 1;
+	mNodes.assign(1, root);
+	mPairs.clear();
+}
+
+Transform3D TransformGraph::get_toMfrom(Handle from, Handle to)
+{
+	QMutexLocker locker(&mMutex);
+	return this->lookup(from, to);
+}
+
+/** Evaluate many pairs while holding the lock once.
+ */
+std::vector<Transform3D> TransformGraph::get_toMfrom(const std::vector<HandlePair>& fromTo)
+{
+	QMutexLocker locker(&mMutex);
+	std::vector<Transform3D> retval;
+	retval.reserve(fromTo.size());
+	for (unsigned i=0; i<fromTo.size(); ++i)
+		retval.push_back(this->lookup(fromTo[i].first, fromTo[i].second));
+	return retval;
+}
+
+Transform3D TransformGraph::get_rootMnode(Handle node)
+{
+	QMutexLocker locker(&mMutex);
+	if (!this->isValid(node))
+		return Transform3D::Identity();
+	this->update(node);
+	return mNodes[node].rootMnode;
+}
+
+unsigned TransformGraph::getVersion(Handle node)
+{
+	QMutexLocker locker(&mMutex);
+	if (!this->isValid(node))
+		return 0;
+	this->update(node);
+	return mNodes[node].version;
+}
+
+Transform3D TransformGraph::lookup(Handle from, Handle to)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	if (!this->isValid(from))
+		from = this->getRoot();
+	if (!this->isValid(to))
+		to = this->getRoot();
+	this->update(from);
+	this->update(to);
+	const Node& fromNode = mNodes[from];
+	const Node& toNode = mNodes[to];
+
+	++mStatistics.lookups;
+	PairEntry& entry = mPairs[HandlePair(from, to)];
+	if ((entry.fromVersion==fromNode.version) && (entry.toVersion==toNode.version))
+	{
+		++mStatistics.hits;
+	}
+	else
+	{
+		Transform3D toMroot = toNode.rigid ? invertRigid(toNode.rootMnode) : toNode.rootMnode.inv();
+		entry.toMfrom = toMroot * fromNode.rootMnode;
+		entry.fromVersion = fromNode.version;
+		entry.toVersion = toNode.version;
+	}
+
+	mStatistics.totalTime += timer.nsecsElapsed()/1.0E6;
+	return entry.toMfrom;
+}
+
+/** Bring rootMnode up to date, parents first.
+ */
+void TransformGraph::update(Handle node)
+{
+	if (node==this->getRoot())
+		return;
+	this->update(mNodes[node].parent);
+
+	Node& current = mNodes[node];
+	const Node& parent = mNodes[current.parent];
+	bool changed = (current.version==0) || (current.parentVersion!=parent.version);
+
+	if (current.dirty || current.polled)
+	{
+		Transform3D local = current.parentMnode ? current.parentMnode() : Transform3D::Identity();
+		if ((current.version==0) || (local.matrix()!=current.local.matrix()))
+			changed = true;
+		current.local = local;
+		current.dirty = false;
+	}
+
+	if (!changed)
+		return;
+
+	current.rootMnode = parent.rootMnode * current.local;
+	current.rigid = parent.rigid && isRigid(current.local);
+	current.parentVersion = parent.version;
+	++current.version;
+	++mStatistics.nodeUpdates;
+}
+
+bool TransformGraph::isRigid(const Transform3D& M)
+{
+	Eigen::Matrix3d RtR = M.linear().transpose() * M.linear();
+	return RtR.isIdentity(1.0E-9) && (M.matrix().row(3) - Eigen::RowVector4d(0,0,0,1)).isZero();
+}
+
+/** Invert a rigid transform: [R t]^-1 = [R' -R't].
+ */
+Transform3D TransformGraph::invertRigid(const Transform3D& M)
+{
+	Transform3D retval = Transform3D::Identity();
+	retval.linear() = M.linear().transpose();
+	retval.translation() = -(retval.linear() * M.translation());
+	return retval;
+}
+
+TransformGraph::Statistics TransformGraph::getStatistics() const
+{
+	QMutexLocker locker(&mMutex);
+	return mStatistics;
+}
+
+void TransformGraph::resetStatistics()
+{
+	QMutexLocker locker(&mMutex);
+	mStatistics = Statistics();
+}
+
+} // namespace cx
@@ -0,0 +1,113 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTRANSFORMGRAPH_H
+#define CXTRANSFORMGRAPH_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <vector>
+#include <QMutex>
+#include <boost/function.hpp>
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+/** \brief Tree of coordinate spaces with cached transforms.
+ *
+ * Each node is a space given by a transform parent_M_node, fetched
+ * through a function when the node has been invalidated. The composed
+ * root_M_node is cached along with a version stamp that is increased
+ * each time it changes, so that a change propagates to all descendants
+ * without visiting them. Composed to_M_from pairs are cached in the
+ * same way and reused until one of the versions change.
+ *
+ * Polled nodes have no change notification: their transform is fetched
+ * on each lookup, and the version increased only if it has changed.
+ *
+ * Inverses of rigid transforms are computed by transposing the rotation.
+ *
+ * \ingroup cx_resource_core_utilities
+ * \date Oct 19, 2026
+ */
+class cxResource_EXPORT TransformGraph
+{
+public:
+	typedef int Handle;
+	typedef boost::function<Transform3D()> TransformFunction; ///< returns parent_M_node
+	typedef std::pair<Handle, Handle> HandlePair; ///< (from, to)
+
+	struct cxResource_EXPORT Statistics
+	{
+		Statistics();
+		int lookups; ///< number of to_M_from requested
+		int hits; ///< lookups found in the pair cache
+		int nodeUpdates; ///< number of root_M_node recomputed
+		double totalTime; ///< ms used by all lookups
+		double getHitRate() const;
+		double getMeanLookupTime() const; ///< ms
+	};
+
+	TransformGraph();
+
+	Handle getRoot() const;
+	Handle addNode(Handle parent, TransformFunction parentMnode, bool polled=false);
+	bool isValid(Handle node) const;
+	void invalidate(Handle node);
+	void clear(); ///< remove all nodes except the root
+
+	Transform3D get_toMfrom(Handle from, Handle to);
+	std::vector<Transform3D> get_toMfrom(const std::vector<HandlePair>& fromTo);
+	Transform3D get_rootMnode(Handle node);
+	unsigned getVersion(Handle node);
+
+	Statistics getStatistics() const;
+	void resetStatistics();
+
+	static bool isRigid(const Transform3D& M);
+	static Transform3D invertRigid(const Transform3D& M);
+
+private:
+	struct Node
+	{
+		Node() : parent(-1), polled(false), dirty(true), version(0), parentVersion(0), rigid(true) {}
+		Handle parent;
+		TransformFunction parentMnode;
+		bool polled;
+		bool dirty; ///< parentMnode must be fetched
+		Transform3D local; ///< last fetched parent_M_node
+		Transform3D rootMnode;
+		unsigned version; ///< increased when rootMnode changes
+		unsigned parentVersion; ///< parent version used in rootMnode
+		bool rigid; ///< rootMnode is rigid
+	};
+	struct PairEntry
+	{
+		PairEntry() : fromVersion(0), toVersion(0) {}
+		Transform3D toMfrom;
+		unsigned fromVersion;
+		unsigned toVersion;
+	};
+
+	Transform3D lookup(Handle from, Handle to);
+	void update(Handle node);
+
+	mutable QMutex mMutex;
+	std::vector<Node> mNodes;
+	std::map<HandlePair, PairEntry> mPairs;
+	Statistics mStatistics;
+};
+typedef boost::shared_ptr<TransformGraph> TransformGraphPtr;
+
+} // namespace cx
+
+#endif // CXTRANSFORMGRAPH_H
@@ -255,6 +255,7 @@ std::map<std::string, std::string> getDisplayFriendlyInfo(ImagePtr image)
 	retval["Acquisition time"] = string_cast(image->getAcquisitionTime().toString(timestampSecondsFormatNice()));
 	retval["Voxels with min value"] = string_cast(calculateNumVoxelsWithMinValue(image));
 	retval["Voxels with max value"] = string_cast(calculateNumVoxelsWithMaxValue(image));
+	retval["Voxels with nonzero value"] = string_cast(image->getExactStatistics().nonZeroCount);
 	retval["rMd"] = matrixAsSingleLineString(image->get_rMd());
 
 	std::map<std::string, std::string> volumeMap = getDisplayFriendlyInfo(image->getBaseVtkImageData());
@@ -303,11 +304,11 @@ void printDisplayFriendlyInfo(std::map<std::string, std::string> map)
 
 int calculateNumVoxelsWithMaxValue(ImagePtr image)
 {
-	return static_cast<int*>(image->getHistogram()->GetOutput()->GetScalarPointer(image->getRange(), 0, 0))[0];
+	return image->getExactStatistics().getCount(image->getMax());
 }
 int calculateNumVoxelsWithMinValue(ImagePtr image)
 {
-	return static_cast<int*>(image->getHistogram()->GetOutput()->GetScalarPointer(0,0,0))[0];
+	return image->getExactStatistics().getCount(image->getMin());
 }
 
 DoubleBoundingBox3D findEnclosingBoundingBox(std::vector<DataPtr> data, Transform3D qMr)
@@ -12,6 +12,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFilterTimedAlgorithm.h"
 #include "cxLogger.h"
 #include "cxFilter.h"
+#include "cxTracer.h"
 
 namespace cx
 {
@@ -58,6 +59,7 @@ void FilterTimedAlgorithm::postProcessingSlot()
 
 bool FilterTimedAlgorithm::calculate()
 {
+	ScopedTraceSpan span("filter", Tracer::isEnabled() ? Tracer::intern(mFilter->getName()) : "");
 	return mFilter->execute();
 }
 
@@ -130,7 +130,8 @@ MeshPtr ColorVariationFilter::execute(MeshPtr inputMesh, double globaleVariance,
 	if (!inputMesh)
 		return MeshPtr();
 
-	vtkPolyDataPtr polyData = inputMesh->getTransformedPolyDataCopy(inputMesh->get_rMd());
+	// only the cell scalars are replaced, the other arrays can be shared with the input
+	vtkPolyDataPtr polyData = inputMesh->getTransformedPolyData(inputMesh->get_rMd());
 	mGlobalVariance = globaleVariance;
 	mLocalVariance = localeVariance;
 	
@@ -197,7 +198,7 @@ vtkUnsignedCharArrayPtr ColorVariationFilter::colorPolyData(MeshPtr mesh)
 	if(mPolyToPointsArray.empty() || mPointToPolysArray.empty())
 		return mColors;
 
-	vtkPolyDataPtr polyData = mesh->getTransformedPolyDataCopy(Transform3D::Identity());
+	vtkPolyDataPtr polyData = mesh->getVtkPolyData();
 
 	mAssignedColorValues.clear();
 	mColors = vtkUnsignedCharArrayPtr::New();
@@ -12,12 +12,18 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxContourFilter.h"
 
 #include <vtkImageShrink3D.h>
-#include <vtkMarchingCubes.h>
+#include <vtkFlyingEdges3D.h>
 #include <vtkWindowedSincPolyDataFilter.h>
-#include <vtkTriangleFilter.h>
 #include <vtkDecimatePro.h>
 #include <vtkPolyDataNormals.h>
+#include <vtkAppendPolyData.h>
+#include <vtkCleanPolyData.h>
 #include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <QThread>
+#include <QtConcurrent>
+#include <QElapsedTimer>
 
 
 #include "cxRegistrationTransform.h"
@@ -31,12 +37,22 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxPatientModelService.h"
 #include "cxViewService.h"
 #include "cxVisServices.h"
+#include "cxView.h"
+#include "cxGeometricRep.h"
 
 namespace cx
 {
 
+namespace
+{
+const double previewFrameBudget = 50; ///< ms
+const double previewMaxVoxels = 8*1024*1024; ///< initial preview resolution
+const int previewMaxStep = 8;
+}
+
 ContourFilter::ContourFilter(VisServicesPtr services) :
-	FilterImpl(services)
+	FilterImpl(services),
+	mPreviewStep(0)
 {
 }
 
@@ -54,9 +70,10 @@ QString ContourFilter::getHelp() const
 {
 	return	"<html>"
 					"<h3>Surfacing.</h3>"
-					"<p><i>Find the surface of a binary volume using marching cubes.</i></p>"
+					"<p><i>Find the surface of a binary volume using flying edges.</i></p>"
 					"<p>- Optional factor 2 reduction</p>"
-					"<p>- Marching Cubes contouring</p>"
+					"<p>- Flying Edges contouring, in parallel slabs</p>"
+					"<p>- A coarse contour is previewed in the 3D view while the threshold is changed</p>"
 					"<p>- Optional Windowed Sinc smoothing</p>"
 					"<p>- Decimation of triangles</p>"
 				"</html>";
@@ -177,6 +194,14 @@ void ContourFilter::stopPreview()
 	if(mPreviewImage)
 		mPreviewImage->stopThresholdPreview();
 	mPreviewImage.reset();
+
+	if (mPreviewRep)
+	{
+		ViewPtr view = mServices->view()->get3DView();
+		if (view)
+			view->removeRep(mPreviewRep);
+	}
+	mPreviewRep.reset();
 }
 
 void ContourFilter::imageChangedSlot(QString uid)
@@ -187,13 +212,13 @@ void ContourFilter::imageChangedSlot(QString uid)
 
 	this->updateThresholdFromImageChange(uid, mSurfaceThresholdOption);
 	this->stopPreview();
+	mPreviewStep = 0;
 
-	int extent[6];
-	image->getBaseVtkImageData()->GetExtent(extent);
-	mReduceResolutionOption->setHelp( "Current input resolution: " + qstring_cast(extent[1])
-																		+ " " + qstring_cast(extent[3]) + " " + qstring_cast(extent[5])
-																		+ " (If checked: " + qstring_cast(extent[1]/2)+ " " + qstring_cast(extent[3]/2) + " "
-																		+ qstring_cast(extent[5]/2) + ")");
+	Eigen::Array3i extent = image->getDimensions() - 1;
+	mReduceResolutionOption->setHelp( "Current input resolution: " + qstring_cast(extent[0])
+																		+ " " + qstring_cast(extent[1]) + " " + qstring_cast(extent[2])
+																		+ " (If checked: " + qstring_cast(extent[0]/2)+ " " + qstring_cast(extent[1]/2) + " "
+																		+ qstring_cast(extent[2]/2) + ")");
 }
 
 void ContourFilter::thresholdSlot()
@@ -205,10 +230,52 @@ void ContourFilter::thresholdSlot()
 		{
 			Eigen::Vector2d threshold = Eigen::Vector2d(mSurfaceThresholdOption->getValue(),  mPreviewImage->getMax());
 			mPreviewImage->startThresholdPreview(threshold);
+			this->updateContourPreview();
 		}
 	}
 }
 
+/** Show a coarse contour at the current threshold in the 3D view.
+ *  The resolution starts at about previewMaxVoxels voxels, and is then
+ *  adjusted so that each update fits within the frame budget.
+ */
+void ContourFilter::updateContourPreview()
+{
+	if (mPreviewStep <= 0)
+	{
+		Eigen::Array3i dim = mPreviewImage->getDimensions();
+		double voxels = double(dim[0])*dim[1]*dim[2];
+		mPreviewStep = 1;
+		while ((mPreviewStep < previewMaxStep) && (voxels/(mPreviewStep*mPreviewStep*mPreviewStep) > previewMaxVoxels))
+			mPreviewStep *= 2;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	vtkPolyDataPtr contour = this->createPreview(mPreviewImage, mSurfaceThresholdOption->getValue(), mPreviewStep);
+	double elapsed = timer.elapsed();
+	if ((elapsed > previewFrameBudget) && (mPreviewStep < previewMaxStep))
+		mPreviewStep *= 2;
+	else if ((elapsed < previewFrameBudget/16) && (mPreviewStep > 1))
+		mPreviewStep /= 2;
+	if (!contour)
+		return;
+
+	if (!mPreviewRep)
+	{
+		MeshPtr mesh(new Mesh("contour_preview", "contour preview"));
+		mesh->setColor(this->getColorOption(mOptions)->getValue());
+		mPreviewRep = GeometricRep::New();
+		mPreviewRep->setMesh(mesh);
+		ViewPtr view = mServices->view()->get3DView();
+		if (view)
+			view->addRep(mPreviewRep);
+	}
+	MeshPtr mesh = mPreviewRep->getMesh();
+	mesh->get_rMd_History()->setRegistration(mPreviewImage->get_rMd());
+	mesh->setVtkPolyData(contour);
+}
+
 bool ContourFilter::preProcess()
 {
 	this->stopPreview();
@@ -233,6 +300,19 @@ bool ContourFilter::execute()
 
 	//report(QString("Creating contour from \"%1\"...").arg(input->getName()));
 
+	if (input->isOutOfCore())
+	{
+		mRawResult = this->execute( input->getBrickedVolume(),
+									surfaceThresholdOption->getValue(),
+									reduceResolutionOption->getValue(),
+									smoothingOption->getValue(),
+									preserveTopologyOption->getValue(),
+									decimationOption->getValue(),
+									numberOfIterationsOption->getValue(),
+									passBandOption->getValue());
+		return true;
+	}
+
 	mRawResult = this->execute( input->getBaseVtkImageData(),
 															surfaceThresholdOption->getValue(),
 															reduceResolutionOption->getValue(),
@@ -244,47 +324,85 @@ bool ContourFilter::execute()
 	return true;
 }
 
-vtkPolyDataPtr ContourFilter::execute(vtkImageDataPtr input,
-																			double threshold,
-																			bool reduceResolution,
-																			bool smoothing,
-																			bool preserveTopology,
-																			double decimation,
-																			double numberOfIterations,
-																			double passBand)
+namespace
 {
-	if (!input)
-		return vtkPolyDataPtr();
+typedef vtkSmartPointer<vtkFlyingEdges3D> vtkFlyingEdges3DPtr;
+typedef vtkSmartPointer<vtkCleanPolyData> vtkCleanPolyDataPtr;
 
-	//Shrink input volume
-	vtkImageShrink3DPtr shrinker = vtkImageShrink3DPtr::New();
-	if(reduceResolution)
-	{
-//		std::cout << "smooth" << std::endl;
-		shrinker->SetInputData(input);
-		shrinker->SetShrinkFactors(2,2,2);
-		shrinker->Update();
-	}
-
-	// Find countour
-	vtkMarchingCubesPtr convert = vtkMarchingCubesPtr::New();
-	if(reduceResolution)
-		convert->SetInputConnection(shrinker->GetOutputPort());
-	else
-		convert->SetInputData(input);
+/** Create an image covering slices [zMin,zMax] of input.
+ *  The scalars point into the input buffer, no voxels are copied.
+ */
+vtkImageDataPtr createSlabView(vtkImageDataPtr input, int zMin, int zMax)
+{
+	int extent[6];
+	input->GetExtent(extent);
+	extent[4] = zMin;
+	extent[5] = zMax;
+
+	int numComps = input->GetNumberOfScalarComponents();
+	vtkIdType numberOfTuples = vtkIdType(extent[1]-extent[0]+1) * (extent[3]-extent[2]+1) * (zMax-zMin+1);
+
+	vtkDataArrayPtr scalars;
+	scalars.TakeReference(vtkDataArray::CreateDataArray(input->GetScalarType()));
+	scalars->SetNumberOfComponents(numComps);
+	scalars->SetVoidArray(input->GetScalarPointer(extent[0], extent[2], zMin), numberOfTuples*numComps, 1);
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetOrigin(input->GetOrigin());
+	retval->SetSpacing(input->GetSpacing());
+	retval->SetExtent(extent);
+	retval->GetPointData()->SetScalars(scalars);
+	return retval;
+}
 
+/** Contour one slab. Normals and scalars are not needed, normals are generated at the end.
+ */
+vtkPolyDataPtr contourSlab(vtkImageDataPtr slab, double threshold)
+{
+	vtkFlyingEdges3DPtr convert = vtkFlyingEdges3DPtr::New();
+	convert->SetInputData(slab);
 	convert->SetValue(0, threshold);
+	convert->ComputeNormalsOff();
+	convert->ComputeGradientsOff();
+	convert->ComputeScalarsOff();
 	convert->Update();
+	return convert->GetOutput();
+}
 
-	vtkPolyDataPtr cubesPolyData = convert->GetOutput();
-//	vtkPolyDataPtr cubesPolyData = vtkPolyDataPtr::New();
-//	cubesPolyData = convert->GetOutput();
-//	std::cout << "convert->GetOutput(); " << cubesPolyData.GetPointer() << std::endl;
+/** Stitch the slab contours.
+ */
+vtkPolyDataPtr mergeSlabs(const std::vector<vtkPolyDataPtr>& parts)
+{
+	if (parts.size() == 1)
+		return parts[0];
+
+	// stitch: points on the shared slices are computed from the same voxels in both slabs, thus identical
+	vtkAppendPolyDataPtr append = vtkAppendPolyDataPtr::New();
+	for (unsigned i=0; i<parts.size(); ++i)
+		append->AddInputData(parts[i]);
+	vtkCleanPolyDataPtr clean = vtkCleanPolyDataPtr::New();
+	clean->SetInputConnection(append->GetOutputPort());
+	clean->SetTolerance(0);
+	clean->ConvertPolysToLinesOff();
+	clean->ConvertLinesToPointsOff();
+	clean->ConvertStripsToPolysOff();
+	clean->Update();
+	return clean->GetOutput();
+}
+
+/** Smooth, decimate and add normals to the stitched contour.
+ *  This is done on the whole surface, so that there are no seams between slabs.
+ */
+vtkPolyDataPtr finishSurface(vtkPolyDataPtr cubesPolyData, bool smoothing, bool preserveTopology,
+							 double decimation, double numberOfIterations, double passBand)
+{
+	if (!cubesPolyData->GetNumberOfPolys())
+		return cubesPolyData;
 
 	// Smooth surface model
-	vtkWindowedSincPolyDataFilterPtr smoother = vtkWindowedSincPolyDataFilterPtr::New();
 	if(smoothing)
 	{
+		vtkWindowedSincPolyDataFilterPtr smoother = vtkWindowedSincPolyDataFilterPtr::New();
 		smoother->SetInputData(cubesPolyData);
 		smoother->SetNumberOfIterations(numberOfIterations);// Higher number = more smoothing  -  default 15
 		smoother->SetBoundarySmoothing(false);
@@ -296,32 +414,152 @@ vtkPolyDataPtr ContourFilter::execute(vtkImageDataPtr input,
 		cubesPolyData = smoother->GetOutput();
 	}
 
-	//Create a surface of triangles
-
 	//Decimate surface model (remove a percentage of the polygons)
-	vtkTriangleFilterPtr trifilt = vtkTriangleFilterPtr::New();
-	vtkDecimateProPtr deci = vtkDecimateProPtr::New();
-	vtkPolyDataNormalsPtr normals = vtkPolyDataNormalsPtr::New();
+	// The contour output consists of triangles only, thus no vtkTriangleFilter is needed.
 	if (decimation > 0.000001)
 	{
-		trifilt->SetInputData(cubesPolyData);
-		trifilt->Update();
-		deci->SetInputConnection(trifilt->GetOutputPort());
+		vtkDecimateProPtr deci = vtkDecimateProPtr::New();
+		deci->SetInputData(cubesPolyData);
 		deci->SetTargetReduction(decimation);
 		deci->SetPreserveTopology(preserveTopology);
-		//deci->PreserveTopologyOn();
 		deci->Update();
 		cubesPolyData = deci->GetOutput();
 	}
 
+	vtkPolyDataNormalsPtr normals = vtkPolyDataNormalsPtr::New();
+	normals->SetInputData(cubesPolyData);
+	normals->SetComputeCellNormals(true);
+	normals->AutoOrientNormalsOn();
+	normals->Update();
+
+	vtkPolyDataPtr retval = normals->GetOutput();
+	return retval;
+}
+}
+
+vtkPolyDataPtr ContourFilter::execute(vtkImageDataPtr input,
+																			double threshold,
+																			bool reduceResolution,
+																			bool smoothing,
+																			bool preserveTopology,
+																			double decimation,
+																			double numberOfIterations,
+																			double passBand,
+																			int numberOfSlabs)
+{
+	if (!input)
+		return vtkPolyDataPtr();
+
+	//Shrink input volume
+	vtkImageDataPtr volume = input;
+	if(reduceResolution)
+	{
+		vtkImageShrink3DPtr shrinker = vtkImageShrink3DPtr::New();
+		shrinker->SetInputData(input);
+		shrinker->SetShrinkFactors(2,2,2);
+		shrinker->Update();
+		volume = shrinker->GetOutput();
+	}
+
+	// Split the volume into z slabs overlapping by one slice, and contour them in parallel.
+	const int minSlabThickness = 32;
+	int extent[6];
+	volume->GetExtent(extent);
+	int slices = extent[5]-extent[4];
+	if (numberOfSlabs <= 0)
+		numberOfSlabs = QThread::idealThreadCount();
+	numberOfSlabs = std::max(1, std::min(numberOfSlabs, slices/minSlabThickness));
+
+	std::vector<vtkImageDataPtr> slabs(numberOfSlabs);
+	for (int i=0; i<numberOfSlabs; ++i)
+	{
+		int zMin = extent[4] + (slices*i)/numberOfSlabs;
+		int zMax = extent[4] + (slices*(i+1))/numberOfSlabs;
+		slabs[i] = (numberOfSlabs==1) ? volume : createSlabView(volume, zMin, zMax);
+	}
+
+	std::vector<vtkPolyDataPtr> parts(numberOfSlabs);
+	std::vector<int> indices(numberOfSlabs);
+	for (int i=0; i<numberOfSlabs; ++i)
+		indices[i] = i;
+	QtConcurrent::blockingMap(indices, [&](int i)
+	{
+		parts[i] = contourSlab(slabs[i], threshold);
+	});
+
+	return finishSurface(mergeSlabs(parts), smoothing, preserveTopology, decimation, numberOfIterations, passBand);
+}
+
+vtkPolyDataPtr ContourFilter::execute(BrickedVolumePtr input,
+									  double threshold,
+									  bool reduceResolution,
+									  bool smoothing,
+									  bool preserveTopology,
+									  double decimation,
+									  double numberOfIterations,
+									  double passBand)
+{
+	if (!input)
+		return vtkPolyDataPtr();
+
+	// Slabs along z overlapping by one slice, in units of step voxels. Each
+	// batch of slabs is read and then processed in parallel, using at most
+	// half the memory budget.
+	const int step = reduceResolution ? 2 : 1;
+	const int threads = QThread::idealThreadCount();
+	Eigen::Array3i dim = input->getDimensions();
+	double voxelSize = double(input->getSizeInBytes()) / (double(dim[0])*dim[1]*dim[2]);
+	double sliceBytes = double((dim[0]-1)/step+1) * ((dim[1]-1)/step+1) * voxelSize;
+	double slabBytes = input->getCache()->getMemoryBudget()*1024*1024 / (2*threads);
+	int thickness = std::max(2, int(slabBytes/sliceBytes));
+	int slices = (dim[2]-1)/step;
+	int numberOfSlabs = std::max(1, (slices+thickness-1)/thickness);
+
+	std::vector<vtkPolyDataPtr> parts(numberOfSlabs);
+	for (int first=0; first<numberOfSlabs; first+=threads)
+	{
+		int count = std::min(threads, numberOfSlabs-first);
+		std::vector<vtkImageDataPtr> slabs(count);
+		for (int i=0; i<count; ++i)
+		{
+			int zMin = (slices*(first+i))/numberOfSlabs;
+			int zMax = (slices*(first+i+1))/numberOfSlabs;
+			IntBoundingBox3D extent = input->getExtent();
+			extent[4] = zMin*step;
+			extent[5] = zMax*step;
+			slabs[i] = input->readRegion(extent, step);
+		}
+
+		std::vector<int> indices(count);
+		for (int i=0; i<count; ++i)
+			indices[i] = i;
+		QtConcurrent::blockingMap(indices, [&](int i)
+		{
+			parts[first+i] = contourSlab(slabs[i], threshold);
+		});
+	}
+
+	return finishSurface(mergeSlabs(parts), smoothing, preserveTopology, decimation, numberOfIterations, passBand);
+}
+
+vtkPolyDataPtr ContourFilter::createPreview(ImagePtr image, double threshold, int step)
+{
+	if (!image)
+		return vtkPolyDataPtr();
+
+	vtkImageDataPtr volume;
+	if (image->isOutOfCore())
+	{
+		BrickedVolumePtr bricked = image->getBrickedVolume();
+		volume = bricked->readRegion(bricked->getExtent(), step);
+	}
+	else
+	{
+		vtkImageDataPtr base = image->getBaseVtkImageData();
+		volume = (step>1) ? BrickedVolume::extractRegion(base, IntBoundingBox3D(base->GetExtent()), step) : base;
+	}
 
-		normals->SetInputData(cubesPolyData);
-		normals->SetComputeCellNormals(true);
-		normals->AutoOrientNormalsOn();
-		normals->Update();
-		cubesPolyData->DeepCopy(normals->GetOutput());
-	
-	return cubesPolyData;
+	return execute(volume, threshold, false, false, false, 0);
 }
 
 bool ContourFilter::postProcess()
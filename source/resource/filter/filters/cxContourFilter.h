@@ -13,12 +13,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #define CXCONTOURFILTER_H
 
 #include "cxFilterImpl.h"
+#include "cxBrickedVolume.h"
 class QColor;
 
 namespace cx
 {
 
-/** Marching cubes surface generation.
+/** Flying edges surface generation.
  *
  *
  * \ingroup cx
@@ -55,6 +56,10 @@ public:
 
 	/** This is the core algorithm, call this if you dont need all the filter stuff.
 	    Generate a contour from a vtkImageData.
+
+	    The volume is split into numberOfSlabs slabs along z that are contoured
+	    in parallel and stitched. The stitched surface is then smoothed and
+	    decimated as a whole. 0 means one slab per core.
 	  */
 	static vtkPolyDataPtr execute(vtkImageDataPtr input,
 			                              double threshold,
@@ -63,7 +68,25 @@ public:
 	                                      bool preserveTopology=true,
                                           double decimation=0.2,
                                           double numberOfIterations = 15,
-                                          double passBand = 0.3);
+                                          double passBand = 0.3,
+                                          int numberOfSlabs = 0);
+	/** As above, for a volume kept on disk. The slabs are read through the
+	    bricks, sized to fit the memory budget of the brick cache. Reduced
+	    resolution reads every second voxel instead of averaging.
+	  */
+	static vtkPolyDataPtr execute(BrickedVolumePtr input,
+								  double threshold,
+								  bool reduceResolution=false,
+								  bool smoothing=true,
+								  bool preserveTopology=true,
+								  double decimation=0.2,
+								  double numberOfIterations = 15,
+								  double passBand = 0.3);
+	/** Contour for interactive preview: every step'th voxel along each axis is
+	    used, and there is no smoothing or decimation. Out-of-core images are
+	    read through the bricks.
+	  */
+	static vtkPolyDataPtr createPreview(ImagePtr image, double threshold, int step);
 	/** Generate a mesh from the contour using base to generate name.
 	  * Save to dataManager.
 	  */
@@ -82,11 +105,14 @@ private slots:
 
 private:
 	void stopPreview();
+	void updateContourPreview();
 
 	BoolPropertyPtr mReduceResolutionOption;
 	DoublePropertyPtr mSurfaceThresholdOption;
 	vtkPolyDataPtr mRawResult;
 	ImagePtr mPreviewImage;
+	GeometricRepPtr mPreviewRep; ///< preview contour in the 3D view
+	int mPreviewStep; ///< voxel step used by the preview contour, adjusted to the frame budget
 };
 typedef boost::shared_ptr<class ContourFilter> ContourFilterPtr;
 
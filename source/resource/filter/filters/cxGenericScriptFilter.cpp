@@ -16,6 +16,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QDir>
 #include <QDirIterator>
 #include <QTextStream>
+#include <QCoreApplication>
+#include <QUuid>
 
 #include "cxAlgorithmHelpers.h"
 #include "cxSelectDataStringProperty.h"
@@ -40,6 +42,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFilePathProperty.h"
 #include "cxProfile.h"
 #include "cxLogger.h"
+#include "cxScriptDataExchange.h"
+#include "cxScriptWorker.h"
 
 namespace cx
 {
@@ -56,7 +60,11 @@ CommandStringVariables::CommandStringVariables(QString parameterFilePath, ImageP
 	cArguments = settings.value("arguments").toString();
 	scriptEngine = settings.value("engine").toString();
 	model = settings.value("model").toString();
+	useWorker = settings.value("worker", false).toBool();
     settings.endGroup();
+	settings.beginGroup("exchange");
+	useMemoryExchange = (settings.value("mode").toString() == "memory");
+	settings.endGroup();
 }
 
 OutputVariables::OutputVariables(QString parameterFilePath)
@@ -83,6 +91,8 @@ GenericScriptFilter::GenericScriptFilter(VisServicesPtr services) :
 
 GenericScriptFilter::~GenericScriptFilter()
 {
+	this->removeMemoryExchangeFiles();
+	this->removeMemoryExchangeOutputFiles();
 }
 
 void GenericScriptFilter::processStateChanged()
@@ -239,8 +249,11 @@ void GenericScriptFilter::scriptFileChanged()
 
 QString GenericScriptFilter::createCommandString(ImagePtr input)
 {
-	CommandStringVariables variables = createCommandStringVariables(input);
+	return this->createCommandString(createCommandStringVariables(input));
+}
 
+QString GenericScriptFilter::createCommandString(CommandStringVariables variables)
+{
 	CX_LOG_DEBUG() << "deepSintefCommandString(variables): " << deepSintefCommandString(variables);
 
 	if(isUsingDeepSintefEngine(variables))
@@ -297,6 +310,18 @@ QString GenericScriptFilter::deepSintefCommandString(CommandStringVariables vari
 	return commandString;
 }
 
+/** The worker is started once without input and output,
+ *  these are sent for each run instead.
+ */
+QString GenericScriptFilter::workerCommandString(CommandStringVariables variables)
+{
+	QString commandString = variables.envPath;
+	commandString.append(" " + variables.scriptFilePath);
+	commandString.append(" --worker");
+	commandString.append(" " + variables.cArguments);
+	return commandString;
+}
+
 bool GenericScriptFilter::environmentExist(QString path)
 {
 	return QFileInfo(path).exists();
@@ -460,6 +485,63 @@ bool GenericScriptFilter::runCommandStringAndWait(QString command)
 	}
 }
 
+bool GenericScriptFilter::runWorkerAndWait(CommandStringVariables variables)
+{
+	ScriptWorker* worker = ScriptWorker::get(this->workerCommandString(variables), this->getScriptPath());
+	return worker->run(variables.inputFilePath, variables.outputFilePath, 1000*60*30);//Wait at least 30 min
+}
+
+/** Write the input to a memory mapped exchange file, and let the script
+ *  write its output to the same place. Keep the patient folder files if
+ *  this fails.
+ *
+ *  The exchange folder is shared by all processes, so the names get a
+ *  process and run unique suffix.
+ */
+bool GenericScriptFilter::prepareMemoryExchange(ImagePtr input, CommandStringVariables& variables)
+{
+	QString folder = ScriptDataExchange::getExchangeFolder();
+	QString ending = "." + ScriptDataExchange::getFileEnding();
+	QString suffix = QString("_%1_%2")
+			.arg(QCoreApplication::applicationPid())
+			.arg(QUuid::createUuid().toString().remove('{').remove('}'));
+	QString inputFilePath = folder + "/" + QFileInfo(variables.inputFilePath).baseName() + suffix + ending;
+	QString outputFilePath = folder + "/" + QFileInfo(variables.outputFilePath).baseName() + suffix + ending;
+	mExchangeSuffix = suffix;
+
+	if (!ScriptDataExchange::write(inputFilePath, input->getBaseVtkImageData()))
+	{
+		CX_LOG_WARNING() << "GenericScriptFilter: Memory exchange failed, using files in the patient folder";
+		return false;
+	}
+
+	mExchangeInputFilePath = variables.inputFilePath = inputFilePath;
+	mExchangeOutputFilePath = variables.outputFilePath = outputFilePath;
+	return true;
+}
+
+void GenericScriptFilter::removeMemoryExchangeFiles()
+{
+	if (!mExchangeInputFilePath.isEmpty())
+		QFile(mExchangeInputFilePath).remove();
+	mExchangeInputFilePath.clear();
+}
+
+/** Remove output the script wrote to exchange files that will not be
+ *  read, e.g. after a failed run. They would otherwise fill /dev/shm.
+ */
+void GenericScriptFilter::removeMemoryExchangeOutputFiles()
+{
+	if (mExchangeOutputFilePath.isEmpty())
+		return;
+	QFileInfo outputFileInfo(mExchangeOutputFilePath);
+	QStringList nameFilter(outputFileInfo.baseName() + "*." + ScriptDataExchange::getFileEnding());
+	QDirIterator fileIterator(outputFileInfo.absolutePath(), nameFilter, QDir::Files);
+	while (fileIterator.hasNext())
+		QFile(fileIterator.next()).remove();
+	mExchangeOutputFilePath.clear();
+}
+
 void GenericScriptFilter::createInputTypes()
 {
 	SelectDataStringPropertyBasePtr temp;
@@ -486,25 +568,47 @@ void GenericScriptFilter::createOutputTypes()
 
 bool GenericScriptFilter::execute()
 {
-	if (!createProcess())
-		return false;
+	// output from a previous run that was never post processed
+	this->removeMemoryExchangeOutputFiles();
+	mExchangeInputFilePath.clear();
 
 	ImagePtr input = this->getCopiedInputImage();
 	// get output also?
 	if (!input)
 		return false;
 
-	// Parse .ini file, create command string to run
-	QString command = this->createCommandString(input);
-
-	//command = QString("echo test");//Test simple command
+	// Parse .ini file
+	CommandStringVariables variables = this->createCommandStringVariables(input);
+	if (isUsingDeepSintefEngine(variables) && (variables.useWorker || variables.useMemoryExchange))
+	{
+		// DeepSintef takes its own argument list and reads ordinary image files only
+		CX_LOG_WARNING() << "GenericScriptFilter: The DeepSintef engine does not support worker or memory exchange, running it as a process with files";
+		variables.useWorker = false;
+		variables.useMemoryExchange = false;
+	}
+	if (variables.useMemoryExchange)
+		this->prepareMemoryExchange(input, variables);
 
-	// Run command string on console
-	bool retval = this->runCommandStringAndWait(command);
-	if(!retval)
-		CX_LOG_WARNING() << "External process failed. QProcess::ProcessError: " << mCommandLine->getProcess()->error();
-	retval = retval & deleteProcess();
+	bool retval = false;
+	if (variables.useWorker)
+	{
+		retval = this->runWorkerAndWait(variables);
+		if(!retval)
+			CX_LOG_WARNING() << "External worker process failed.";
+	}
+	else if (createProcess())
+	{
+		// Run command string on console
+		QString command = this->createCommandString(variables);
+		retval = this->runCommandStringAndWait(command);
+		if(!retval)
+			CX_LOG_WARNING() << "External process failed. QProcess::ProcessError: " << mCommandLine->getProcess()->error();
+		retval = retval & deleteProcess();
+	}
 
+	this->removeMemoryExchangeFiles();
+	if (!retval)
+		this->removeMemoryExchangeOutputFiles();
 	return retval; // Check for error?
 }
 
@@ -648,9 +752,13 @@ bool GenericScriptFilter::readGeneratedSegmentationFiles(bool createOutputVolume
 	if(!parentImage)
 	{
 		CX_LOG_WARNING() << "GenericScriptFilter::readGeneratedSegmentationFiles: No input image";
+		this->removeMemoryExchangeOutputFiles();
 		return false;
 	}
 
+	if (this->readExchangedSegmentationFiles(parentImage, createOutputVolume, createOutputMesh))
+		return true;
+
 	QFileInfo fileInfoInput(parentImage->getFilename());
 	QString outputFileName = fileInfoInput.baseName();
 	QFileInfo outputFileInfo(outputFileName.append(mResultFileEnding));
@@ -673,33 +781,8 @@ bool GenericScriptFilter::readGeneratedSegmentationFiles(bool createOutputVolume
 				continue;
 			}
 
-			mOutputImage = createDerivedImage(mServices->patient(),
-												uid, createImageName(parentImage->getName(), filePath),
-												newImage->getBaseVtkImageData(), parentImage);
-			if(!mOutputImage)
-			{
-				CX_LOG_WARNING() << "GenericScriptFilter::readGeneratedSegmentationFiles: Problem creating derived image";
+			if(!this->addOutputImage(parentImage, uid, filePath, newImage->getBaseVtkImageData(), createOutputVolume, createOutputMesh))
 				continue;
-			}
-			if (createOutputVolume)
-				this->createOutputVolume();
-
-			if(createOutputMesh && mOutputImage)
-			{
-				int colorNumber = 0;
-				for(int i=0; i<mOutputClasses.size(); i++)
-				{
-					if(filePath.contains(mOutputClasses[i], Qt::CaseSensitive))
-					{
-						colorNumber = i;
-						break;
-					}
-				}
-				QColor outputColor = getDefaultColor();
-				if(mOutputColors.size() > colorNumber)
-					outputColor = mOutputColors.at(colorNumber);
-				this->createOutputMesh(outputColor);
-			}
 			this->deleteNotUsedFiles(filePath, createOutputVolume);
 		}
 		else if(filePath.contains(outputFileNamesNoExtention) && filePath.contains(".vtk"))
@@ -723,6 +806,70 @@ bool GenericScriptFilter::readGeneratedSegmentationFiles(bool createOutputVolume
 	return true;
 }
 
+/** Read output written by the script to memory mapped exchange files.
+ *  Return false if there were none, e.g. if the script only writes files.
+ */
+bool GenericScriptFilter::readExchangedSegmentationFiles(ImagePtr parentImage, bool createOutputVolume, bool createOutputMesh)
+{
+	if (mExchangeOutputFilePath.isEmpty())
+		return false;
+
+	QFileInfo outputFileInfo(mExchangeOutputFilePath);
+	QStringList nameFilter(outputFileInfo.baseName() + "*." + ScriptDataExchange::getFileEnding());
+
+	bool found = false;
+	QDirIterator fileIterator(outputFileInfo.absolutePath(), nameFilter, QDir::Files);
+	while (fileIterator.hasNext())
+	{
+		QString filePath = fileIterator.next();
+		vtkImageDataPtr rawImage = ScriptDataExchange::read(filePath);
+		QFile(filePath).remove();
+		if (!rawImage)
+			continue;
+
+		found = true;
+		QString uid = QFileInfo(filePath).completeBaseName().remove(mExchangeSuffix); // as if read from the patient folder
+		this->addOutputImage(parentImage, uid, filePath, rawImage, createOutputVolume, createOutputMesh);
+	}
+	this->removeMemoryExchangeOutputFiles();
+
+	if (!found)
+		CX_LOG_INFO() << "GenericScriptFilter: No exchange output from script, looking for output files in the patient folder";
+	return found;
+}
+
+bool GenericScriptFilter::addOutputImage(ImagePtr parentImage, QString uid, QString filePath, vtkImageDataPtr rawImage, bool createOutputVolume, bool createOutputMesh)
+{
+	mOutputImage = createDerivedImage(mServices->patient(),
+										uid, createImageName(parentImage->getName(), filePath),
+										rawImage, parentImage);
+	if(!mOutputImage)
+	{
+		CX_LOG_WARNING() << "GenericScriptFilter::readGeneratedSegmentationFiles: Problem creating derived image";
+		return false;
+	}
+	if (createOutputVolume)
+		this->createOutputVolume();
+
+	if(createOutputMesh && mOutputImage)
+	{
+		int colorNumber = 0;
+		for(int i=0; i<mOutputClasses.size(); i++)
+		{
+			if(filePath.contains(mOutputClasses[i], Qt::CaseSensitive))
+			{
+				colorNumber = i;
+				break;
+			}
+		}
+		QColor outputColor = getDefaultColor();
+		if(mOutputColors.size() > colorNumber)
+			outputColor = mOutputColors.at(colorNumber);
+		this->createOutputMesh(outputColor);
+	}
+	return true;
+}
+
 QString GenericScriptFilter::createImageName(QString parentName, QString filePath)
 {
 	QString retval = parentName;
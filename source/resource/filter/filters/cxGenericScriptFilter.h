@@ -31,6 +31,8 @@ struct cxResourceFilter_EXPORT CommandStringVariables
 	QString cArguments;
 	QString scriptEngine;
 	QString model;
+	bool useMemoryExchange; ///< [exchange] mode=memory: exchange volumes through memory mapped files
+	bool useWorker; ///< [script] worker=true: keep the script running between runs
 
     CommandStringVariables(QString parameterFilePath, ImagePtr input);
 };
@@ -79,7 +81,15 @@ protected:
 	virtual void createInputTypes();
 	virtual void createOutputTypes();
 	QString createCommandString(ImagePtr input);
+	QString createCommandString(CommandStringVariables variables);
 	bool runCommandStringAndWait(QString command);
+	bool runWorkerAndWait(CommandStringVariables variables);
+	QString workerCommandString(CommandStringVariables variables);
+	bool prepareMemoryExchange(ImagePtr input, CommandStringVariables& variables);
+	void removeMemoryExchangeFiles();
+	void removeMemoryExchangeOutputFiles();
+	bool readExchangedSegmentationFiles(ImagePtr parentImage, bool createOutputVolume, bool createOutputMesh);
+	bool addOutputImage(ImagePtr parentImage, QString uid, QString filePath, vtkImageDataPtr rawImage, bool createOutputVolume, bool createOutputMesh);
 	QString getCustomPath();
 	void setupOutputColors(QStringList colorList);
 	QColor createColor(QStringList color);
@@ -118,6 +128,9 @@ protected:
 	ImagePtr mOutputImage;
 	QList<QColor> mOutputColors;
 	QStringList mOutputClasses;
+	QString mExchangeInputFilePath; ///< empty if volumes are exchanged through the patient folder
+	QString mExchangeOutputFilePath;
+	QString mExchangeSuffix; ///< makes the exchange file names unique, not part of the output uids
 
     SelectDataStringPropertyBasePtr mOutputImageSelectDataPtr;
     StringPropertySelectMeshPtr mOutputMeshSelectMeshPtr;
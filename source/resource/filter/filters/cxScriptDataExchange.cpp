@@ -0,0 +1,170 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxScriptDataExchange.h"
+
+#include <string.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStorageInfo>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+#include <vtkImageData.h>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const char exchangeMagic[8] = {'C','X','I','M','G','0','0','1'};
+
+struct ExchangeHeader
+{
+	char magic[8];
+	qint32 headerSize;
+	qint32 scalarType;
+	qint32 components;
+	qint32 dim[3];
+	double spacing[3];
+	double origin[3];
+	char reserved[48];
+};
+
+qint64 getScalarBytes(vtkImageDataPtr image)
+{
+	int* dim = image->GetDimensions();
+	return qint64(dim[0]) * dim[1] * dim[2] * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+}
+/** Allocate all blocks of the file, so that a later write through
+ *  a mapping cannot fail.
+ */
+bool reserve(QFile& file, qint64 size)
+{
+#ifdef Q_OS_LINUX
+	return posix_fallocate(file.handle(), 0, size) == 0;
+#else
+	return file.resize(size);
+#endif
+}
+} // namespace
+
+QString ScriptDataExchange::getFileEnding()
+{
+	return "cximg";
+}
+
+QString ScriptDataExchange::getExchangeFolder()
+{
+	QFileInfo shm("/dev/shm");
+	if (shm.isDir() && shm.isWritable())
+		return shm.absoluteFilePath();
+	return QDir::tempPath();
+}
+
+bool ScriptDataExchange::isExchangeFile(QString filePath)
+{
+	return QFileInfo(filePath).suffix() == getFileEnding();
+}
+
+bool ScriptDataExchange::write(QString filePath, vtkImageDataPtr image)
+{
+	if (!image)
+		return false;
+
+	qint64 scalarBytes = getScalarBytes(image);
+	qint64 size = sizeof(ExchangeHeader) + scalarBytes;
+
+	// Writing through a mapping into a sparse file on a full tmpfs raises
+	// SIGBUS instead of returning an error: check the space up front, and
+	// reserve the blocks before mapping.
+	QStorageInfo storage(QFileInfo(filePath).absolutePath());
+	if (!storage.isValid() || storage.bytesAvailable() < size)
+	{
+		CX_LOG_WARNING() << "ScriptDataExchange: Not enough space for " << filePath
+						 << ", need " << size << " bytes, have " << storage.bytesAvailable();
+		return false;
+	}
+
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !reserve(file, size))
+	{
+		CX_LOG_WARNING() << "ScriptDataExchange: Failed to create " << filePath;
+		file.remove();
+		return false;
+	}
+	uchar* buffer = file.map(0, size);
+	if (!buffer)
+	{
+		CX_LOG_WARNING() << "ScriptDataExchange: Failed to map " << filePath;
+		file.remove();
+		return false;
+	}
+
+	ExchangeHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, exchangeMagic, sizeof(header.magic));
+	header.headerSize = sizeof(ExchangeHeader);
+	header.scalarType = image->GetScalarType();
+	header.components = image->GetNumberOfScalarComponents();
+	for (int i = 0; i < 3; ++i)
+	{
+		header.dim[i] = image->GetDimensions()[i];
+		header.spacing[i] = image->GetSpacing()[i];
+		header.origin[i] = image->GetOrigin()[i];
+	}
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + sizeof(header), image->GetScalarPointer(), scalarBytes);
+
+	file.unmap(buffer);
+	return true;
+}
+
+vtkImageDataPtr ScriptDataExchange::read(QString filePath)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(ExchangeHeader)))
+		return vtkImageDataPtr();
+	uchar* buffer = file.map(0, file.size());
+	if (!buffer)
+		return vtkImageDataPtr();
+
+	ExchangeHeader header;
+	memcpy(&header, buffer, sizeof(header));
+	if (memcmp(header.magic, exchangeMagic, sizeof(header.magic)) != 0)
+	{
+		CX_LOG_WARNING() << "ScriptDataExchange: Not an exchange file: " << filePath;
+		file.unmap(buffer);
+		return vtkImageDataPtr();
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetDimensions(header.dim[0], header.dim[1], header.dim[2]);
+	retval->SetSpacing(header.spacing[0], header.spacing[1], header.spacing[2]);
+	retval->SetOrigin(header.origin[0], header.origin[1], header.origin[2]);
+	retval->AllocateScalars(header.scalarType, header.components);
+
+	qint64 scalarBytes = getScalarBytes(retval);
+	if (header.headerSize + scalarBytes > file.size())
+	{
+		CX_LOG_WARNING() << "ScriptDataExchange: Truncated exchange file: " << filePath;
+		file.unmap(buffer);
+		return vtkImageDataPtr();
+	}
+	memcpy(retval->GetScalarPointer(), buffer + header.headerSize, scalarBytes);
+
+	file.unmap(buffer);
+	return retval;
+}
+
+} // namespace cx
@@ -0,0 +1,59 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXSCRIPTDATAEXCHANGE_H
+#define CXSCRIPTDATAEXCHANGE_H
+
+#include "cxResourceFilterExport.h"
+
+#include <QString>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/** Exchange of volumes with external scripts through memory mapped files.
+ *
+ * The files are placed in shared memory (/dev/shm) where available, and
+ * are mapped directly by both sides, avoiding the .mhd/.raw round trip
+ * through the patient folder.
+ *
+ * File layout, little endian, 128 byte header followed by the scalars
+ * with x running fastest:
+ *
+ *   offset  0: char[8]   magic "CXIMG001"
+ *   offset  8: int32     header size (128)
+ *   offset 12: int32     VTK scalar type (3=uchar, 4=short, 5=ushort, 6=int, 10=float, 11=double)
+ *   offset 16: int32     number of components
+ *   offset 20: int32[3]  dimensions
+ *   offset 32: double[3] spacing
+ *   offset 56: double[3] origin
+ *
+ * write() fails if the exchange folder has too little space for the
+ * volume, callers should then exchange through ordinary files.
+ *
+ * In Python: np.memmap(path, dtype, mode='r', offset=128, shape=(dim[2], dim[1], dim[0], components)).
+ *
+ * \ingroup cx_resource_filter
+ * \date Oct 19, 2026
+ */
+class cxResourceFilter_EXPORT ScriptDataExchange
+{
+public:
+	static QString getFileEnding(); ///< "cximg"
+	static QString getExchangeFolder();
+	static bool write(QString filePath, vtkImageDataPtr image);
+	static vtkImageDataPtr read(QString filePath);
+	static bool isExchangeFile(QString filePath);
+};
+
+} // namespace cx
+
+#endif // CXSCRIPTDATAEXCHANGE_H
@@ -0,0 +1,190 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxScriptWorker.h"
+
+#include <map>
+#include <QCoreApplication>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const QByteArray doneTag("CX_DONE");
+const int failedStatus = -1;
+}
+
+ScriptWorker* ScriptWorker::get(QString command, QString workingDirectory)
+{
+	static QMutex registryMutex;
+	static std::map<QString, ScriptWorker*> registry;
+
+	QMutexLocker locker(&registryMutex);
+	QString key = workingDirectory + "|" + command;
+	ScriptWorker*& worker = registry[key];
+	if (worker)
+		return worker;
+
+	worker = new ScriptWorker(command, workingDirectory);
+	QCoreApplication* app = QCoreApplication::instance();
+	if (app)
+	{
+		worker->moveToThread(app->thread());
+		connect(app, &QCoreApplication::aboutToQuit, worker, &ScriptWorker::shutdown, Qt::DirectConnection);
+	}
+	return worker;
+}
+
+ScriptWorker::ScriptWorker(QString command, QString workingDirectory) :
+	mCommand(command),
+	mWorkingDirectory(workingDirectory),
+	mStatus(0),
+	mLastRequestId(0),
+	mPendingRequestId(0)
+{
+}
+
+ScriptWorker::~ScriptWorker()
+{
+	this->shutdown();
+}
+
+/** Send a request and wait for the reply. Return true if the script reported success.
+ */
+bool ScriptWorker::run(QString inputFilePath, QString outputFilePath, int timeout)
+{
+	QMutexLocker locker(&mRunMutex);
+
+	// the process lives in the main thread, call it there
+	bool sameThread = (QThread::currentThread() == this->thread());
+	Qt::ConnectionType connection = sameThread ? Qt::DirectConnection : Qt::BlockingQueuedConnection;
+
+	bool started = false;
+	QMetaObject::invokeMethod(this, "start", connection, Q_RETURN_ARG(bool, started));
+	if (!started)
+		return false;
+
+	while (mReplies.tryAcquire()); // discard wakeups from earlier requests
+	int id = ++mLastRequestId;
+	mPendingRequestId = id;
+	QMetaObject::invokeMethod(this, "send", connection, Q_ARG(QString, QString("%1\t%2\t%3").arg(id).arg(inputFilePath).arg(outputFilePath)));
+
+	bool replied = this->waitForReply(sameThread, timeout);
+	mPendingRequestId = 0;
+	if (!replied)
+	{
+		CX_LOG_WARNING() << "ScriptWorker: No reply from worker within " << timeout << " ms";
+		return false;
+	}
+	return mStatus.load() == 0;
+}
+
+/** Without an event loop in the main thread, read the process output here.
+ */
+bool ScriptWorker::waitForReply(bool sameThread, int timeout)
+{
+	if (!sameThread)
+		return mReplies.tryAcquire(1, timeout);
+
+	QElapsedTimer timer;
+	timer.start();
+	while (!mReplies.tryAcquire())
+	{
+		if (timer.elapsed() > timeout || !mProcess)
+			return false;
+		mProcess->getProcess()->waitForReadyRead(100);
+	}
+	return true;
+}
+
+bool ScriptWorker::start()
+{
+	if (mProcess && mProcess->isRunning())
+		return true;
+
+	mProcess.reset(new ProcessWrapper("ScriptWorker"));
+	mProcess->turnOffReporting();
+	mProcess->getProcess()->setWorkingDirectory(mWorkingDirectory);
+	connect(mProcess->getProcess(), &QProcess::readyRead, this, &ScriptWorker::processReadyRead);
+	connect(mProcess->getProcess(), static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+			this, &ScriptWorker::processFinished);
+
+	CX_LOG_INFO() << "Starting script worker: " << mCommand;
+	if (!mProcess->launch(mCommand) || !mProcess->waitForStarted())
+	{
+		CX_LOG_WARNING() << "ScriptWorker: Failed to start " << mCommand;
+		mProcess.reset();
+		return false;
+	}
+	return true;
+}
+
+void ScriptWorker::send(QString line)
+{
+	if (mProcess)
+		mProcess->write(QString(line + "\n").toUtf8().constData());
+}
+
+void ScriptWorker::shutdown()
+{
+	if (!mProcess)
+		return;
+	disconnect(mProcess->getProcess(), 0, this, 0);
+	mProcess->getProcess()->closeWriteChannel(); // the worker exits on end of input
+	mProcess->waitForFinished(3000);
+	mProcess.reset();
+}
+
+void ScriptWorker::processReadyRead()
+{
+	if (!mProcess)
+		return;
+	mPartialLine += mProcess->getProcess()->readAll();
+
+	int end;
+	while ((end = mPartialLine.indexOf('\n')) >= 0)
+	{
+		QByteArray line = mPartialLine.left(end).trimmed();
+		mPartialLine.remove(0, end + 1);
+
+		if (line.startsWith(doneTag))
+		{
+			QList<QByteArray> fields = line.mid(doneTag.size()).simplified().split(' ');
+			int id = (fields.size() > 1) ? fields[1].toInt() : 0;
+			if (id == 0 || id != mPendingRequestId.load())
+			{
+				CX_LOG_WARNING() << "ScriptWorker: Discarding reply to request " << id << ", it is not pending";
+				continue;
+			}
+			mStatus = fields[0].toInt();
+			mReplies.release();
+		}
+		else if (!line.isEmpty())
+		{
+			CX_LOG_CHANNEL_INFO("ExternalScript") << QString(line);
+		}
+	}
+}
+
+void ScriptWorker::processFinished(int code, QProcess::ExitStatus status)
+{
+	CX_LOG_WARNING() << "ScriptWorker: Worker process exited with code " << code
+					 << (status == QProcess::CrashExit ? " (crash)" : "");
+	mStatus = failedStatus;
+	mReplies.release(); // wake up a waiting request, start() restarts the process on the next request
+}
+
+} // namespace cx
@@ -0,0 +1,86 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXSCRIPTWORKER_H
+#define CXSCRIPTWORKER_H
+
+#include "cxResourceFilterExport.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QProcess>
+#include "cxProcessWrapper.h"
+
+namespace cx
+{
+
+/** A script process kept alive between filter runs.
+ *
+ * Scripts that load large models (e.g. deep learning segmentation) pay the
+ * startup cost once per session instead of once per run. The script is
+ * started with the argument --worker and then reads one request per line
+ * on stdin:
+ *
+ *   <request id>\t<input path>\t<output path>
+ *
+ * and answers each request with a line on stdout:
+ *
+ *   CX_DONE <exit code> <request id>
+ *
+ * Replies to other requests, e.g. a late reply to a request that timed
+ * out, are discarded.
+ *
+ * Other output is forwarded to the log. The script should exit when stdin
+ * is closed.
+ *
+ * There is one worker per command line, owned by the main thread. run()
+ * can be called from any thread, e.g. from a filter thread.
+ *
+ * \ingroup cx_resource_filter
+ * \date Oct 19, 2026
+ */
+class cxResourceFilter_EXPORT ScriptWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	static ScriptWorker* get(QString command, QString workingDirectory);
+	virtual ~ScriptWorker();
+
+	bool run(QString inputFilePath, QString outputFilePath, int timeout);
+	QString getCommand() const { return mCommand; }
+
+private slots:
+	bool start();
+	void send(QString line);
+	void shutdown();
+	void processReadyRead();
+	void processFinished(int code, QProcess::ExitStatus status);
+
+private:
+	ScriptWorker(QString command, QString workingDirectory);
+	bool waitForReply(bool sameThread, int timeout);
+
+	QString mCommand;
+	QString mWorkingDirectory;
+	ProcessWrapperPtr mProcess;
+	QByteArray mPartialLine;
+	QMutex mRunMutex; ///< one request at a time
+	QSemaphore mReplies;
+	QAtomicInt mStatus;
+	int mLastRequestId; ///< guarded by mRunMutex
+	QAtomicInt mPendingRequestId; ///< the request waiting for a reply, 0 if none
+};
+
+} // namespace cx
+
+#endif // CXSCRIPTWORKER_H
@@ -0,0 +1,144 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QElapsedTimer>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkFeatureEdges.h>
+#include "cxContourFilter.h"
+#include "cxImage.h"
+#include "cxLogger.h"
+
+namespace
+{
+/** Binary mask of a sphere centered in a volume of dim^3 voxels.
+ */
+vtkImageDataPtr createSphereMask(int dim)
+{
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetDimensions(dim, dim, dim);
+	image->SetSpacing(0.5, 0.5, 0.5);
+	image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+	unsigned char* ptr = static_cast<unsigned char*>(image->GetScalarPointer());
+	double center = (dim-1)/2.0;
+	double radius2 = (dim/3.0)*(dim/3.0);
+	for (int z=0; z<dim; ++z)
+		for (int y=0; y<dim; ++y)
+			for (int x=0; x<dim; ++x)
+			{
+				double r2 = (x-center)*(x-center) + (y-center)*(y-center) + (z-center)*(z-center);
+				*ptr++ = (r2 < radius2) ? 1 : 0;
+			}
+	return image;
+}
+
+int countBoundaryEdges(vtkPolyDataPtr polydata)
+{
+	vtkSmartPointer<vtkFeatureEdges> edges = vtkSmartPointer<vtkFeatureEdges>::New();
+	edges->SetInputData(polydata);
+	edges->BoundaryEdgesOn();
+	edges->FeatureEdgesOff();
+	edges->NonManifoldEdgesOff();
+	edges->ManifoldEdgesOff();
+	edges->Update();
+	return edges->GetOutput()->GetNumberOfLines();
+}
+}
+
+TEST_CASE("ContourFilter: Slabs give the same surface as a single pass", "[unit][modules][Algorithm][ContourFilter]")
+{
+	vtkImageDataPtr mask = createSphereMask(128);
+
+	vtkPolyDataPtr single = cx::ContourFilter::execute(mask, 1, false, true, true, 0.2, 15, 0.3, 1);
+	vtkPolyDataPtr slabs = cx::ContourFilter::execute(mask, 1, false, true, true, 0.2, 15, 0.3, 4);
+	REQUIRE(single);
+	REQUIRE(slabs);
+	REQUIRE(single->GetNumberOfPolys() > 0);
+
+	// seams are welded, the sphere is still closed
+	CHECK(countBoundaryEdges(single) == 0);
+	CHECK(countBoundaryEdges(slabs) == 0);
+
+	// smoothing and decimation run on the welded surface, decimation may differ due to point order
+	double ratio = double(slabs->GetNumberOfPolys()) / single->GetNumberOfPolys();
+	CHECK(ratio > 0.9);
+	CHECK(ratio < 1.2);
+
+	double singleBounds[6];
+	double slabBounds[6];
+	single->GetBounds(singleBounds);
+	slabs->GetBounds(slabBounds);
+	for (int i=0; i<6; ++i)
+		CHECK(slabBounds[i] == Approx(singleBounds[i]).epsilon(0.02));
+}
+
+TEST_CASE("ContourFilter: Slabs are welded before smoothing", "[unit][modules][Algorithm][ContourFilter]")
+{
+	vtkImageDataPtr mask = createSphereMask(128);
+
+	vtkPolyDataPtr single = cx::ContourFilter::execute(mask, 1, false, true, true, 0, 15, 0.3, 1);
+	vtkPolyDataPtr slabs = cx::ContourFilter::execute(mask, 1, false, true, true, 0, 15, 0.3, 4);
+	REQUIRE(single);
+	REQUIRE(slabs);
+	CHECK(slabs->GetNumberOfPoints() == single->GetNumberOfPoints());
+	CHECK(slabs->GetNumberOfPolys() == single->GetNumberOfPolys());
+	CHECK(countBoundaryEdges(slabs) == 0);
+}
+
+TEST_CASE("ContourFilter: Preview contours a reduced volume", "[unit][modules][Algorithm][ContourFilter]")
+{
+	cx::ImagePtr image(new cx::Image("sphere", createSphereMask(128)));
+
+	vtkPolyDataPtr full = cx::ContourFilter::createPreview(image, 1, 1);
+	vtkPolyDataPtr preview = cx::ContourFilter::createPreview(image, 1, 4);
+	REQUIRE(full);
+	REQUIRE(preview);
+	REQUIRE(preview->GetNumberOfPolys() > 0);
+	CHECK(preview->GetNumberOfPolys() < full->GetNumberOfPolys()/8);
+	CHECK(countBoundaryEdges(preview) == 0);
+
+	double fullBounds[6];
+	double previewBounds[6];
+	full->GetBounds(fullBounds);
+	preview->GetBounds(previewBounds);
+	// at most one reduced voxel apart
+	for (int i=0; i<6; ++i)
+		CHECK(fabs(previewBounds[i]-fullBounds[i]) <= 4*0.5);
+}
+
+TEST_CASE("ContourFilter: Empty volume gives an empty surface", "[unit][modules][Algorithm][ContourFilter]")
+{
+	vtkImageDataPtr mask = vtkImageDataPtr::New();
+	mask->SetDimensions(64, 64, 256);
+	mask->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+	memset(mask->GetScalarPointer(), 0, 64*64*256);
+
+	vtkPolyDataPtr result = cx::ContourFilter::execute(mask, 1);
+	REQUIRE(result);
+	CHECK(result->GetNumberOfPolys() == 0);
+}
+
+TEST_CASE("Speed: ContourFilter single pass vs parallel slabs", "[speed][modules][Algorithm][ContourFilter]")
+{
+	vtkImageDataPtr mask = createSphereMask(256);
+
+	QElapsedTimer timer;
+	timer.start();
+	cx::ContourFilter::execute(mask, 1, false, true, true, 0.2, 15, 0.3, 1);
+	int singleTime = timer.restart();
+	cx::ContourFilter::execute(mask, 1);
+	int slabTime = timer.elapsed();
+
+	CX_LOG_INFO() << QString("Contour 256^3 sphere: single pass %1 ms, parallel slabs %2 ms")
+					 .arg(singleTime).arg(slabTime);
+}
@@ -0,0 +1,65 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <vtkImageData.h>
+#include "cxScriptDataExchange.h"
+#include "cxScriptWorker.h"
+#include "cxDataLocations.h"
+#include "cxtestUtilities.h"
+
+TEST_CASE("ScriptDataExchange: Write and read volume through memory mapped file", "[unit][modules][Algorithm][GenericScriptFilter]")
+{
+	vtkImageDataPtr image = cxtest::Utilities::create3DVtkImageData(Eigen::Array3i(5,6,7), 42);
+	image->SetSpacing(0.5, 0.75, 2.0);
+	static_cast<unsigned char*>(image->GetScalarPointer(1,2,3))[0] = 7;
+
+	QString filePath = cx::ScriptDataExchange::getExchangeFolder() + "/cxtest_exchange." + cx::ScriptDataExchange::getFileEnding();
+	REQUIRE(cx::ScriptDataExchange::isExchangeFile(filePath));
+	REQUIRE(cx::ScriptDataExchange::write(filePath, image));
+
+	vtkImageDataPtr result = cx::ScriptDataExchange::read(filePath);
+	REQUIRE(result);
+	CHECK(result->GetDimensions()[0] == 5);
+	CHECK(result->GetDimensions()[2] == 7);
+	CHECK(result->GetSpacing()[1] == Approx(0.75));
+	CHECK(result->GetScalarType() == image->GetScalarType());
+	CHECK(static_cast<unsigned char*>(result->GetScalarPointer(0,0,0))[0] == 42);
+	CHECK(static_cast<unsigned char*>(result->GetScalarPointer(1,2,3))[0] == 7);
+
+	QFile(filePath).remove();
+	CHECK(!cx::ScriptDataExchange::read(filePath));
+}
+
+TEST_CASE("ScriptWorker: Run several requests in one script process", "[integration][modules][Algorithm][GenericScriptFilter]")
+{
+	QString scriptFolder = cx::DataLocations::getRootConfigPath() + "/profiles/Laboratory/filter_scripts";
+	QString command = "python3 -u ./scripts/python_example/test.py --worker";
+	cx::ScriptWorker* worker = cx::ScriptWorker::get(command, scriptFolder);
+	REQUIRE(worker);
+	CHECK(worker == cx::ScriptWorker::get(command, scriptFolder));
+
+	QString folder = cx::ScriptDataExchange::getExchangeFolder();
+	QString input = folder + "/cxtest_worker.cximg";
+	REQUIRE(cx::ScriptDataExchange::write(input, cxtest::Utilities::create3DVtkImageData()));
+
+	for (int i=0; i<2; ++i)
+	{
+		QString output = folder + QString("/cxtest_worker_out%1.mhd").arg(i);
+		QString expected = folder + QString("/cxtest_worker_out%1.cximg").arg(i);
+		CHECK(worker->run(input, output, 10000));
+		CHECK(cx::ScriptDataExchange::read(expected));
+		QFile(expected).remove();
+	}
+	QFile(input).remove();
+}
@@ -0,0 +1,162 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxGrabberSenderSharedMemory.h"
+
+#include <string.h>
+#include <QTcpSocket>
+#include "igtlMessageHeader.h"
+#include "igtlStringMessage.h"
+#include "cxGrabberSenderQTcpSocket.h"
+#include "cxSharedMemoryImageFrame.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const int ringSlots = 8;
+const int retryInterval = 1000; ///< ms between attempts to create a ring
+const int maxRequestSize = 1024*1024; ///< the client sends only small messages
+}
+
+GrabberSenderSharedMemory::GrabberSenderSharedMemory(QTcpSocket* socket, int port) :
+	mSocket(socket),
+	mPort(port),
+	mControl(new GrabberSenderQTcpSocket(socket)),
+	mRequested(false),
+	mGeneration(0)
+{
+	if (socket)
+		connect(socket, &QTcpSocket::readyRead, this, [this]() { this->readRequests(); });
+}
+
+bool GrabberSenderSharedMemory::isReady() const
+{
+	return mControl && mControl->isReady();
+}
+
+QString GrabberSenderSharedMemory::getKey() const
+{
+	return mRing ? mRing->key() : QString();
+}
+
+/** Look for the shared memory request among the IGTLink messages from the client,
+ *  ignore all other messages.
+ */
+void GrabberSenderSharedMemory::readRequests()
+{
+	if (!mSocket)
+		return;
+	mReceived += mSocket->readAll();
+
+	igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+	while (mReceived.size() >= header->GetPackSize())
+	{
+		header->InitPack();
+		memcpy(header->GetPackPointer(), mReceived.constData(), header->GetPackSize());
+		header->Unpack();
+		qint64 total = header->GetPackSize() + header->GetBodySizeToRead();
+		if (total > maxRequestSize)
+		{
+			mReceived.clear(); // not a client we understand
+			return;
+		}
+		if (mReceived.size() < total)
+			return;
+
+		if ((QString(header->GetDeviceType()) == "STRING") &&
+			(QString(header->GetDeviceName()) == SharedMemoryImageFrame::getRequestDeviceName()))
+		{
+			if (!mRequested)
+				report("Client requested images through shared memory");
+			mRequested = true;
+		}
+		mReceived.remove(0, int(total));
+	}
+}
+
+void GrabberSenderSharedMemory::send(ImagePtr msg)
+{
+	if (!this->isReady())
+		return;
+	if (!mRequested)
+	{
+		this->sendThroughSocket(msg);
+		return;
+	}
+
+	int size = SharedMemoryImageFrame::getFrameSize(msg);
+	if (size == 0)
+		return;
+
+	// the ring is sized after the largest frame seen, recreate if it grows
+	bool retry = !mRing && (!mRetryTimer.isValid() || mRetryTimer.elapsed() > retryInterval);
+	if (retry || (mRing && size > mRing->slotSize()))
+		this->createRing(size);
+
+	void* buffer = mRing ? mRing->beginWrite() : NULL;
+	if (!buffer)
+	{
+		this->sendThroughSocket(msg);
+		return;
+	}
+
+	size = SharedMemoryImageFrame::encode(msg, buffer, mRing->slotSize());
+	mRing->endWrite(size);
+}
+
+/** Create a ring with a new key. Readers of the old ring keep it alive
+ *  until they have attached to the new one.
+ */
+bool GrabberSenderSharedMemory::createRing(int size)
+{
+	mRing.reset();
+	QString key = SharedMemoryImageFrame::getKey(mPort, ++mGeneration);
+	SharedMemoryRingWriterPtr ring(new SharedMemoryRingWriter(key, ringSlots, size));
+	if (!ring->isValid())
+	{
+		reportWarning("Failed to create shared memory " + key + ", sending images through the socket");
+		mRetryTimer.start();
+		return false;
+	}
+	mRing = ring;
+	this->announceKey(key);
+	return true;
+}
+
+void GrabberSenderSharedMemory::announceKey(QString key)
+{
+	if (!mSocket)
+		return;
+	igtl::StringMessage::Pointer msg = igtl::StringMessage::New();
+	msg->SetDeviceName(SharedMemoryImageFrame::getKeyDeviceName().toStdString().c_str());
+	msg->SetString(key.toStdString().c_str());
+	msg->Pack();
+	mSocket->write(reinterpret_cast<const char*>(msg->GetPackPointer()), msg->GetPackSize());
+}
+
+void GrabberSenderSharedMemory::sendThroughSocket(ImagePtr msg)
+{
+	PackagePtr package(new Package());
+	package->mImage = msg;
+	mControl->send(package);
+}
+
+void GrabberSenderSharedMemory::send(ProbeDefinitionPtr msg)
+{
+	PackagePtr package(new Package());
+	package->mProbe = msg;
+	mControl->send(package);
+}
+
+} /* namespace cx */
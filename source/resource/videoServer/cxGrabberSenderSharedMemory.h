@@ -0,0 +1,86 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXGRABBERSENDERSHAREDMEMORY_H_
+#define CXGRABBERSENDERSHAREDMEMORY_H_
+
+#include "cxGrabberExport.h"
+
+#include <QElapsedTimer>
+#include <QPointer>
+#include "cxSenderImpl.h"
+#include "cxSharedMemoryRing.h"
+
+class QTcpSocket;
+
+namespace cx
+{
+
+/**
+* \file
+* \addtogroup cx_resource_videoserver
+* @{
+*/
+
+/** Sender for clients on the same machine.
+ *
+ * Images are sent through the IGTLink socket until the client asks
+ * for shared memory, see SharedMemoryImageFrame. They are then written
+ * to a SharedMemoryRingWriter, thus avoiding the serialization and
+ * socket copies of the IGTLink path. Slow clients lose the oldest frames
+ * instead of blocking the server.
+ *
+ * Each ring gets a new key, announced to the client through the socket.
+ * A ring that cannot be created, e.g. because of a stale segment, is
+ * retried later with a new key, while images go through the socket.
+ *
+ * Probe definitions are rare and small, and are always sent through the
+ * socket, which also tells if the client is connected.
+ *
+ * \sa SharedMemoryImageFrame
+ * \date Oct 19, 2026
+ */
+class cxGrabber_EXPORT GrabberSenderSharedMemory : public SenderImpl
+{
+public:
+	GrabberSenderSharedMemory(QTcpSocket* socket, int port);
+	virtual ~GrabberSenderSharedMemory() {}
+
+	bool isReady() const;
+	bool isSharedMemoryRequested() const { return mRequested; }
+	QString getKey() const; ///< key of the current ring, empty if none
+
+protected:
+	virtual void send(ImagePtr msg);
+	virtual void send(ProbeDefinitionPtr msg);
+
+private:
+	void readRequests();
+	bool createRing(int size);
+	void announceKey(QString key);
+	void sendThroughSocket(ImagePtr msg);
+
+	QPointer<QTcpSocket> mSocket;
+	int mPort;
+	SenderPtr mControl;
+	SharedMemoryRingWriterPtr mRing;
+	bool mRequested;
+	int mGeneration;
+	QElapsedTimer mRetryTimer; ///< time since a ring failed to be created
+	QByteArray mReceived;
+};
+
+/**
+* @}
+*/
+
+} /* namespace cx */
+#endif /* CXGRABBERSENDERSHAREDMEMORY_H_ */
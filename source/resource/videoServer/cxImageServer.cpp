@@ -21,12 +21,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxCommandlineImageStreamerFactory.h"
 //#include "cxSender.h"
 #include "cxGrabberSenderQTcpSocket.h"
+#include "cxGrabberSenderSharedMemory.h"
 
 namespace cx
 {
 
 ImageServer::ImageServer(QObject* parent) :
-	QTcpServer(parent)
+	QTcpServer(parent),
+	mUseSharedMemory(true)
 {}
 
 bool ImageServer::initialize()
@@ -34,6 +36,7 @@ bool ImageServer::initialize()
 	bool ok = false;
 
 	StringMap args = cx::extractCommandlineOptions(QCoreApplication::arguments());
+	mUseSharedMemory = (args["sharedmemory"] != "off");
 	mImageSender = CommandlineImageStreamerFactory().getFromArguments(args);
 	if(!mImageSender)
 		return false;
@@ -90,11 +93,21 @@ void ImageServer::incomingConnection(qintptr socketDescriptor)
 	mSocket->setSocketDescriptor(socketDescriptor);
 	QString clientName = mSocket->localAddress().toString();
 	report("Connected to "+clientName+". Session started.");
-	SenderPtr sender(new GrabberSenderQTcpSocket(mSocket));
+	SenderPtr sender = this->createSender(mSocket);
 
 	mImageSender->startStreaming(sender);
 }
 
+/** Clients on the same machine can ask for the images through shared memory,
+ *  all other clients get them through the socket.
+ */
+SenderPtr ImageServer::createSender(QTcpSocket* socket)
+{
+	if (!mUseSharedMemory || !socket->peerAddress().isLoopback())
+		return SenderPtr(new GrabberSenderQTcpSocket(socket));
+	return SenderPtr(new GrabberSenderSharedMemory(socket, this->serverPort()));
+}
+
 void ImageServer::socketDisconnectedSlot()
 {
 	if (mImageSender)
@@ -124,6 +137,7 @@ QString ImageServer::getArgumentHelpText(QString applicationName)
 
 	ss << "Usage: " << applicationName << " (--arg <argval>)*" << std::endl;
 	ss << "    --port   : Tcp/IP port # (default=18333)" << std::endl;
+	ss << "    --sharedmemory : Allow local clients to request images through shared memory, on/off (default=on)" << std::endl;
 	ss << "    --type   : Grabber type  (default=" << factory.getDefaultSenderType().toStdString() << ")"
 		<< std::endl;
 	ss << std::endl;
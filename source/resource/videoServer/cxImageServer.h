@@ -22,6 +22,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 typedef boost::shared_ptr<class Streamer> StreamerPtr;
+typedef boost::shared_ptr<class Sender> SenderPtr;
 
 /**
  * \brief ImageServer
@@ -47,8 +48,10 @@ protected:
 private slots:
 	void socketDisconnectedSlot();
 private:
+	SenderPtr createSender(QTcpSocket* socket);
 	StreamerPtr mImageSender;
 	QPointer<QTcpSocket> mSocket;
+	bool mUseSharedMemory;
 };
 
 } // namespace cx
@@ -0,0 +1,399 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxRayPicker.h"
+
+#include <limits>
+#include <algorithm>
+#include <vtkRenderer.h>
+#include <vtkPropCollection.h>
+#include <vtkActor.h>
+#include <vtkVolume.h>
+#include <vtkMapper.h>
+#include <vtkVolumeMapper.h>
+#include <vtkVolumeProperty.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPlaneCollection.h>
+#include <vtkPlane.h>
+#include <vtkPolyData.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkMatrix4x4.h>
+#include "vtkVolumePicker.h"
+#include "cxTransform3D.h"
+#include "cxPatientModelService.h"
+#include "cxMesh.h"
+#include "cxImage.h"
+
+#include "cxConfig.h"
+#ifdef CX_BUILD_MEHDI_VTKMULTIVOLUME
+	#include "vtkMultiVolumePicker.h"
+	typedef vtkSmartPointer<class vtkMultiVolumePicker> vtkMultiVolumePickerPtr;
+#else
+	typedef vtkSmartPointer<class vtkVolumePicker> vtkMultiVolumePickerPtr;
+#endif
+
+namespace cx
+{
+
+namespace
+{
+/** Value intervals where the piecewise linear function f is at least limit.
+ *  f is clamped outside its nodes, as in vtkPiecewiseFunction.
+ */
+ImageBrickGrid::Intervals getIntervalsAbove(vtkPiecewiseFunction* f, double limit)
+{
+	ImageBrickGrid::Intervals retval;
+	int size = f ? f->GetSize() : 0;
+	if (!size)
+		return retval;
+
+	const double lowest = std::numeric_limits<double>::lowest();
+	const double highest = std::numeric_limits<double>::max();
+	double node[4];
+	f->GetNodeValue(0, node);
+	double x0 = node[0];
+	double y0 = node[1];
+	bool inside = (y0 >= limit);
+	double begin = lowest;
+
+	for (int i=1; i<size; ++i)
+	{
+		f->GetNodeValue(i, node);
+		double x1 = node[0];
+		double y1 = node[1];
+		if ((y1 >= limit) != inside)
+		{
+			// crossing inside the segment
+			double x = (y1!=y0) ? x0 + (limit-y0)/(y1-y0)*(x1-x0) : x1;
+			if (inside)
+				retval.push_back(std::make_pair(begin, x));
+			else
+				begin = x;
+			inside = !inside;
+		}
+		x0 = x1;
+		y0 = y1;
+	}
+	if (inside)
+		retval.push_back(std::make_pair(begin, highest));
+	return retval;
+}
+
+/** Clip the ray to the axis aligned box bb. Return false if nothing is left.
+ */
+bool clipToBox(const double* bb, const Vector3D& origin, const Vector3D& direction, double* tMin, double* tMax)
+{
+	for (int i=0; i<3; ++i)
+	{
+		if (direction[i]==0)
+		{
+			if (origin[i]<bb[2*i] || origin[i]>bb[2*i+1])
+				return false;
+			continue;
+		}
+		double ta = (bb[2*i]-origin[i])/direction[i];
+		double tb = (bb[2*i+1]-origin[i])/direction[i];
+		*tMin = std::max(*tMin, std::min(ta, tb));
+		*tMax = std::min(*tMax, std::max(ta, tb));
+	}
+	return *tMin <= *tMax;
+}
+} // namespace
+
+const double RayPicker::opacityLimit = 0.05;
+
+RayPicker::RayPicker(PatientModelServicePtr patientModel) :
+	mPatientModel(patientModel),
+	mDataMapDirty(true),
+	mPickPosition(0,0,0),
+	mDataSet(NULL),
+	mProp(NULL)
+{
+	if (mPatientModel)
+		connect(mPatientModel.get(), &PatientModelService::dataAddedOrRemoved, this, &RayPicker::invalidateDataMap);
+}
+
+RayPicker::~RayPicker()
+{
+}
+
+Vector3D RayPicker::getPickPosition() const
+{
+	return mPickPosition;
+}
+
+vtkDataSet* RayPicker::getDataSet() const
+{
+	return mDataSet;
+}
+
+vtkProp3D* RayPicker::getProp() const
+{
+	return mProp;
+}
+
+DataPtr RayPicker::getData() const
+{
+	// the map was updated by pick()
+	return mDataMap.value(mDataSet);
+}
+
+void RayPicker::invalidateDataMap()
+{
+	mDataMapDirty = true;
+}
+
+void RayPicker::updateDataMap()
+{
+	if (!mDataMapDirty || !mPatientModel)
+		return;
+
+	for (QHash<vtkDataSet*, DataPtr>::iterator iter=mDataMap.begin(); iter!=mDataMap.end(); ++iter)
+		disconnect(iter.value().get(), NULL, this, NULL);
+	mDataMap.clear();
+
+	std::map<QString, DataPtr> datas = mPatientModel->getDatas();
+	for (std::map<QString, DataPtr>::iterator iter = datas.begin(); iter != datas.end(); ++iter)
+	{
+		MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(iter->second);
+		if (mesh)
+		{
+			mDataMap.insert(mesh->getVtkPolyData().GetPointer(), mesh);
+			connect(mesh.get(), &Mesh::meshChanged, this, &RayPicker::invalidateDataMap);
+		}
+
+		ImagePtr image = boost::dynamic_pointer_cast<Image>(iter->second);
+		if (image)
+		{
+			mDataMap.insert(image->getBaseVtkImageData().GetPointer(), image);
+			connect(image.get(), &Image::vtkImageDataChanged, this, &RayPicker::invalidateDataMap);
+		}
+	}
+	mDataMap.remove(NULL);
+	mDataMapDirty = false;
+}
+
+bool RayPicker::pick(const Vector3D& p_d, vtkRendererPtr renderer)
+{
+	mDataSet = NULL;
+	mProp = NULL;
+	if (!renderer)
+		return false;
+	this->updateDataMap();
+
+	// ray from the near to the far clipping plane, t in [0,1]
+	double p0[4], p1[4];
+	renderer->SetDisplayPoint(p_d[0], p_d[1], 0);
+	renderer->DisplayToWorld();
+	renderer->GetWorldPoint(p0);
+	renderer->SetDisplayPoint(p_d[0], p_d[1], 1);
+	renderer->DisplayToWorld();
+	renderer->GetWorldPoint(p1);
+	if (p0[3]==0 || p1[3]==0)
+		return false;
+	Ray ray_w;
+	ray_w.origin = Vector3D(p0)/p0[3];
+	ray_w.direction = Vector3D(p1)/p1[3] - ray_w.origin;
+	ray_w.tMin = 0;
+	ray_w.tMax = 1;
+
+	mPreviousBVHs.swap(mBVHs);
+	mBVHs.clear();
+	mPreviousBrickGrids.swap(mBrickGrids);
+	mBrickGrids.clear();
+
+	double best = std::numeric_limits<double>::max();
+	QList<vtkProp3D*> others;
+	vtkPropCollection* props = renderer->GetViewProps();
+	props->InitTraversal();
+	while (vtkProp* prop = props->GetNextProp())
+	{
+		vtkProp3D* prop3D = vtkProp3D::SafeDownCast(prop);
+		if (!prop3D || !prop3D->GetVisibility() || !prop3D->GetPickable())
+			continue;
+
+		double t = best;
+		bool handled = false;
+		bool hit = false;
+		if (vtkActor* actor = vtkActor::SafeDownCast(prop3D))
+		{
+			vtkPolyData* polyData = actor->GetMapper() ? vtkPolyData::SafeDownCast(actor->GetMapper()->GetInputAsDataSet()) : NULL;
+			handled = polyData && (polyData->GetNumberOfPolys() || polyData->GetNumberOfStrips())
+					&& !polyData->GetNumberOfLines() && !polyData->GetNumberOfVerts();
+			if (handled)
+				hit = this->pickActor(actor, ray_w, &t);
+		}
+		else if (vtkVolume* volume = vtkVolume::SafeDownCast(prop3D))
+		{
+			vtkVolumeMapper* mapper = vtkVolumeMapper::SafeDownCast(volume->GetMapper());
+			vtkImageData* image = mapper ? vtkImageData::SafeDownCast(mapper->GetDataSetInput()) : NULL;
+			handled = image && image->GetNumberOfScalarComponents()==1
+					&& (!mapper->GetCropping() || mapper->GetCroppingRegionFlags()==VTK_CROPPING_SUBVOLUME);
+			if (handled)
+				hit = this->pickVolume(volume, ray_w, &t);
+		}
+
+		if (!handled)
+			others.push_back(prop3D);
+		else if (hit && t < best)
+		{
+			best = t;
+			mProp = prop3D;
+		}
+	}
+
+	mPreviousBVHs.clear();
+	mPreviousBrickGrids.clear();
+
+	if (!others.isEmpty())
+	{
+		double t = best;
+		if (this->pickFallback(others, p_d, renderer, ray_w, &t) && t < best)
+			best = t;
+	}
+
+	if (!mProp)
+		return false;
+	if (!mDataSet)
+	{
+		if (vtkActor* actor = vtkActor::SafeDownCast(mProp))
+			mDataSet = actor->GetMapper()->GetInputAsDataSet();
+		else if (vtkVolume* volume = vtkVolume::SafeDownCast(mProp))
+			mDataSet = volume->GetMapper()->GetDataSetInput();
+	}
+	mPickPosition = ray_w.origin + best*ray_w.direction;
+	return true;
+}
+
+/** Transform the ray into the data space of the prop. t is unchanged.
+ */
+RayPicker::Ray RayPicker::toDataSpace(vtkProp3D* prop, const Ray& ray_w) const
+{
+	Transform3D dMw = Transform3D(prop->GetMatrix()).inv();
+	Ray retval = ray_w;
+	retval.origin = dMw.coord(ray_w.origin);
+	retval.direction = dMw.vector(ray_w.direction);
+	return retval;
+}
+
+/** Clip the ray to the positive side of the mapper clipping planes, given in world.
+ */
+bool RayPicker::clipToPlanes(vtkAbstractMapper* mapper, Ray* ray_w) const
+{
+	vtkPlaneCollection* planes = mapper->GetClippingPlanes();
+	if (!planes)
+		return true;
+	planes->InitTraversal();
+	while (vtkPlane* plane = planes->GetNextItem())
+	{
+		Vector3D n(plane->GetNormal());
+		Vector3D p(plane->GetOrigin());
+		double distance = dot(n, ray_w->origin - p);
+		double speed = dot(n, ray_w->direction);
+		if (speed==0)
+		{
+			if (distance<0)
+				return false;
+			continue;
+		}
+		double t = -distance/speed;
+		if (speed>0)
+			ray_w->tMin = std::max(ray_w->tMin, t);
+		else
+			ray_w->tMax = std::min(ray_w->tMax, t);
+	}
+	return ray_w->tMin <= ray_w->tMax;
+}
+
+bool RayPicker::pickActor(vtkActor* actor, Ray ray_w, double* t)
+{
+	ray_w.tMax = std::min(ray_w.tMax, *t);
+	if (!this->clipToPlanes(actor->GetMapper(), &ray_w))
+		return false;
+
+	vtkPolyData* polyData = vtkPolyData::SafeDownCast(actor->GetMapper()->GetInputAsDataSet());
+	MeshBVHPtr bvh = this->getBVH(polyData);
+	Ray ray_d = this->toDataSpace(actor, ray_w);
+	MeshBVH::Hit hit = bvh->intersect(ray_d.origin, ray_d.direction, ray_d.tMin, ray_d.tMax);
+	if (!hit.valid)
+		return false;
+	*t = hit.t;
+	return true;
+}
+
+bool RayPicker::pickVolume(vtkVolume* volume, Ray ray_w, double* t)
+{
+	ray_w.tMax = std::min(ray_w.tMax, *t);
+	vtkVolumeMapper* mapper = vtkVolumeMapper::SafeDownCast(volume->GetMapper());
+	if (!this->clipToPlanes(mapper, &ray_w))
+		return false;
+
+	Ray ray_d = this->toDataSpace(volume, ray_w);
+	if (mapper->GetCropping() && !clipToBox(mapper->GetCroppingRegionPlanes(), ray_d.origin, ray_d.direction, &ray_d.tMin, &ray_d.tMax))
+		return false;
+
+	vtkPiecewiseFunction* opacity = volume->GetProperty() ? volume->GetProperty()->GetScalarOpacity(0) : NULL;
+	ImageBrickGrid::Intervals intervals = getIntervalsAbove(opacity, opacityLimit);
+	if (intervals.empty())
+		return false;
+
+	ImageBrickGridPtr grid = this->getBrickGrid(vtkImageData::SafeDownCast(mapper->GetDataSetInput()));
+	return grid->intersect(ray_d.origin, ray_d.direction, ray_d.tMin, ray_d.tMax, intervals, t);
+}
+
+bool RayPicker::pickFallback(const QList<vtkProp3D*>& props, const Vector3D& p_d, vtkRendererPtr renderer, const Ray& ray_w, double* t)
+{
+	vtkMultiVolumePickerPtr picker = vtkMultiVolumePickerPtr::New();
+	picker->PickFromListOn();
+	for (int i=0; i<props.size(); ++i)
+		picker->AddPickList(props[i]);
+	if (!picker->Pick(p_d[0], p_d[1], 0, renderer))
+		return false;
+
+	Vector3D p_w(picker->GetPickPosition());
+	double length2 = ray_w.direction.squaredNorm();
+	double tHit = length2 ? dot(p_w - ray_w.origin, ray_w.direction)/length2 : 0;
+	if (tHit >= *t)
+		return false;
+	*t = tHit;
+	mProp = picker->GetProp3D();
+	mDataSet = picker->GetDataSet();
+	return true;
+}
+
+MeshBVHPtr RayPicker::getBVH(vtkPolyData* polyData)
+{
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(mDataMap.value(polyData));
+	if (mesh && mesh->getVtkPolyData().GetPointer()==polyData)
+		return mesh->getBVH();
+
+	std::pair<vtkPolyDataPtr, MeshBVHPtr> entry = mBVHs.value(polyData);
+	if (!entry.second)
+		entry = mPreviousBVHs.value(polyData);
+	if (!entry.second || entry.second->getSourceMTime()!=polyData->GetMTime())
+		entry = std::make_pair(vtkPolyDataPtr(polyData), MeshBVHPtr(new MeshBVH(polyData)));
+	mBVHs.insert(polyData, entry);
+	return entry.second;
+}
+
+ImageBrickGridPtr RayPicker::getBrickGrid(vtkImageData* image)
+{
+	ImageBrickGridPtr grid = mBrickGrids.value(image);
+	if (!grid)
+		grid = mPreviousBrickGrids.value(image);
+	if (!grid || grid->getSourceMTime()!=image->GetMTime())
+		grid.reset(new ImageBrickGrid(image));
+	mBrickGrids.insert(image, grid);
+	return grid;
+}
+
+} // namespace cx
@@ -0,0 +1,113 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXRAYPICKER_H_
+#define CXRAYPICKER_H_
+
+#include "cxResourceVisualizationExport.h"
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <utility>
+#include "cxForwardDeclarations.h"
+#include "vtkForwardDeclarations.h"
+#include "cxVector3D.h"
+#include "cxMeshBVH.h"
+#include "cxImageBrickGrid.h"
+
+class vtkProp3D;
+class vtkActor;
+class vtkVolume;
+class vtkDataSet;
+class vtkAbstractMapper;
+
+namespace cx
+{
+typedef boost::shared_ptr<class RayPicker> RayPickerPtr;
+
+/** \brief Pick the closest prop along a ray from the camera through a display position.
+ *
+ * Replacement for vtkVolumePicker for the common props in a 3D view:
+ *  - Surfaces are intersected using a MeshBVH. The hierarchy of a Mesh
+ *    is owned by the Mesh, other polydata get one cached here.
+ *  - Single component volumes are marched using an ImageBrickGrid, hitting
+ *    the first point with scalar opacity above opacityLimit, as vtkVolumePicker.
+ *
+ * Clipping planes and volume cropping are respected. Props not handled
+ * (lines, assemblies, multicomponent volumes, ...) are picked using a
+ * vtkVolumePicker restricted to those props, and the closest hit wins.
+ *
+ * The Data owning the picked dataset is found using a hash from dataset
+ * to Data, rebuilt when data are added, removed or changed.
+ *
+ * \ingroup cx_resource_view
+ * \date Oct 19, 2026
+ */
+class cxResourceVisualization_EXPORT RayPicker : public QObject
+{
+	Q_OBJECT
+public:
+	static const double opacityLimit;
+
+	explicit RayPicker(PatientModelServicePtr patientModel);
+	virtual ~RayPicker();
+
+	/** Pick at position p_d in display coordinates. Return true on hit.
+	 */
+	bool pick(const Vector3D& p_d, vtkRendererPtr renderer);
+
+	Vector3D getPickPosition() const; ///< last hit, world coordinates
+	vtkDataSet* getDataSet() const; ///< dataset of the last hit prop, valid until the next pick
+	vtkProp3D* getProp() const; ///< the last hit prop, valid until the next pick
+	DataPtr getData() const; ///< Data owning the last hit dataset, if any
+
+private slots:
+	void invalidateDataMap();
+
+private:
+	struct Ray
+	{
+		Vector3D origin;
+		Vector3D direction;
+		double tMin;
+		double tMax;
+	};
+
+	bool clipToPlanes(vtkAbstractMapper* mapper, Ray* ray_w) const;
+	bool pickActor(vtkActor* actor, Ray ray_w, double* t);
+	bool pickVolume(vtkVolume* volume, Ray ray_w, double* t);
+	bool pickFallback(const QList<vtkProp3D*>& props, const Vector3D& p_d, vtkRendererPtr renderer, const Ray& ray_w, double* t);
+	Ray toDataSpace(vtkProp3D* prop, const Ray& ray_w) const;
+	MeshBVHPtr getBVH(vtkPolyData* polyData);
+	ImageBrickGridPtr getBrickGrid(vtkImageData* image);
+	void updateDataMap();
+
+	PatientModelServicePtr mPatientModel;
+	QHash<vtkDataSet*, DataPtr> mDataMap;
+	bool mDataMapDirty;
+
+	// caches for datasets not owned by a Mesh, pruned to the datasets seen in the last pick.
+	typedef QHash<vtkPolyData*, std::pair<vtkPolyDataPtr, MeshBVHPtr> > BVHCache;
+	typedef QHash<vtkImageData*, ImageBrickGridPtr> BrickGridCache;
+	BVHCache mBVHs;
+	BVHCache mPreviousBVHs;
+	BrickGridCache mBrickGrids;
+	BrickGridCache mPreviousBrickGrids;
+
+	Vector3D mPickPosition;
+	vtkDataSet* mDataSet;
+	vtkProp3D* mProp;
+};
+
+} // namespace cx
+
+#endif // CXRAYPICKER_H_
@@ -343,7 +343,7 @@ std::vector<ImagePtr> elementsInAButNotInB(std::vector<ImagePtr> A, std::vector<
 
 void Texture3DSlicerProxyImpl::updateAndUploadImages(std::vector<ImagePtr> new_images_raw)
 {
-	//only unsigned images are supported on the gpu
+	//signed short/char are sampled directly, other signed types are converted to unsigned
 	std::vector<ImagePtr> unsigned_images = convertToUnsigned(new_images_raw);
 
 	//removing unused textures from the gpu
@@ -401,7 +401,10 @@ std::vector<ImagePtr> Texture3DSlicerProxyImpl::convertToUnsigned(std::vector<Im
 
 	for (unsigned i=0; i<images.size(); ++i)
 	{
-		images[i] = images_raw[i]->getUnsigned(images_raw[i]);
+		if (SharedOpenGLContext::canUploadAsSignedTexture(images_raw[i]->getBaseVtkImageData()))
+			images[i] = images_raw[i];
+		else
+			images[i] = images_raw[i]->getUnsigned(images_raw[i]);
 	}
 
 	return images;
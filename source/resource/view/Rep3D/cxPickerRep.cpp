@@ -38,16 +38,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxGeometricRep.h"
 #include <vtkRenderWindowInteractor.h>
 #include "cxLogger.h"
-#include "vtkVolumePicker.h"
-
-#include "cxConfig.h"
-#ifdef CX_BUILD_MEHDI_VTKMULTIVOLUME
-	#include "vtkMultiVolumePicker.h"
-		typedef vtkSmartPointer<class vtkMultiVolumePicker> vtkMultiVolumePickerPtr;
-//		typedef vtkSmartPointer<class vtkVolumePicker> vtkMultiVolumePickerPtr;
-#else
-    typedef vtkSmartPointer<class vtkVolumePicker> vtkMultiVolumePickerPtr;
-#endif
 
 namespace cx
 {
@@ -60,6 +50,7 @@ PickerRep::PickerRep(PatientModelServicePtr dataManager) :
 	mDataManager(dataManager),
 	mPickedPoint(), mSphereRadius(2) //, mConnections(vtkEventQtSlotConnectPtr::New())
 {
+	mRayPicker.reset(new RayPicker(dataManager));
 	mIsDragging = false;
 	mViewportListener.reset(new ViewportListener);
 	mViewportListener->setCallback(boost::bind(&PickerRep::scaleSphere, this));
@@ -105,7 +96,7 @@ void PickerRep::setTool(ToolPtr tool)
 
 	if (mTool)
 	{
-		disconnect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this,
+		disconnect(mTool.get(), SIGNAL(toolTransformCoalesced(Transform3D, double)), this,
 				SLOT(setModified()));
 	}
 
@@ -113,7 +104,7 @@ void PickerRep::setTool(ToolPtr tool)
 
 	if (mTool)
 	{
-		connect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this,
+		connect(mTool.get(), SIGNAL(toolTransformCoalesced(Transform3D, double)), this,
 				SLOT(setModified()));
 		this->setModified();
 	}
@@ -149,35 +140,23 @@ void PickerRep::pickLandmark(const Vector3D& clickPosition, vtkRendererPtr rende
 {
 	if (!this->mEnabled)
 		return;
-	vtkMultiVolumePickerPtr picker = vtkMultiVolumePickerPtr::New();
-	int hit = picker->Pick(clickPosition[0], clickPosition[1], 0, renderer);
+	int hit = mRayPicker->pick(clickPosition, renderer);
 	if (!hit)
 	{
 		mIsDragging = false;
 		return;
 	}
 
-	// search for picked data in manager, emit uid if found.
-	vtkDataSetPtr data = picker->GetDataSet();
-	if (data)
-	{
-		std::map<QString, DataPtr> allData = mDataManager->getDatas();
-		for (std::map<QString, DataPtr>::iterator iter = allData.begin(); iter != allData.end(); ++iter)
-		{
-			MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(iter->second);
-			if (mesh && mesh->getVtkPolyData() == data)
-				emit dataPicked(iter->first);
-
-			ImagePtr image = boost::dynamic_pointer_cast<Image>(iter->second);
-			if (image && image->getBaseVtkImageData() == data)
-				emit dataPicked(iter->first);
-		}
-	}
+	// emit uid of the picked data, if any.
+	DataPtr pickedData = mRayPicker->getData();
+	if (pickedData)
+		emit dataPicked(pickedData->getUid());
 
-	Vector3D pick_w(picker->GetPickPosition());
+	vtkDataSetPtr data = mRayPicker->getDataSet();
+	Vector3D pick_w(mRayPicker->getPickPosition());
 
 	if ( data &&
-		((mGraphicalPoint && (data == mGraphicalPoint->getPolyData() ))
+		((mGraphicalPoint && (data == mGraphicalPoint->getPolyData() || mRayPicker->getProp() == mGraphicalPoint->getActor().GetPointer()))
 	   ||(mGlyph          && (data == mGlyph->getVtkPolyData()       ))
 	   ||(mTool           && (data == mTool->getGraphicsPolyData()   )))
 	   )
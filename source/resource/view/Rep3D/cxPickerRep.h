@@ -22,6 +22,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxGraphicalPrimitives.h"
 #include "cxViewportListener.h"
 #include "cxForwardDeclarations.h"
+#include "cxRayPicker.h"
 
 class vtkCommand;
 typedef vtkSmartPointer<class vtkCallbackCommand> vtkCallbackCommandPtr;
@@ -109,6 +110,7 @@ protected:
 	ViewportListenerPtr mViewportListener;
 	vtkCallbackCommandPtr mCallbackCommand;
 	PatientModelServicePtr mDataManager;
+	RayPickerPtr mRayPicker;
 };
 
 typedef boost::shared_ptr<PickerRep> PickerRepPtr;
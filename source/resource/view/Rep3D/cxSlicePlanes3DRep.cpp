@@ -300,6 +300,7 @@ void SlicePlanes3DRep::setProxy(SlicePlanesProxyPtr proxy)
 	mProxy = proxy;
 	mProxy->connectTo3D(true);
 	connect(mProxy.get(), SIGNAL(changed()), this, SLOT(changedSlot()));
+	connect(mProxy.get(), SIGNAL(changed()), this, SLOT(setModified()));
 	changedSlot();
 }
 
@@ -357,6 +358,7 @@ void SlicePlanes3DMarkerIn2DRep::setProxy(PLANE_TYPE type, SlicePlanesProxyPtr p
 	mType = type;
 	mProxy = proxy;
 	connect(mProxy.get(), SIGNAL(changed()), this, SLOT(changedSlot()));
+	connect(mProxy.get(), SIGNAL(changed()), this, SLOT(setModified()));
 	changedSlot();
 }
 
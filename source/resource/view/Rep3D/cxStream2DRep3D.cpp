@@ -33,6 +33,7 @@ Stream2DRep3D::Stream2DRep3D(SpaceProviderPtr spaceProvider) :
 {
 	bool useMask = true;
 	mRTStream.reset(new VideoSourceGraphics(mSpaceProvider, useMask));
+	connect(mRTStream.get(), &VideoSourceGraphics::newData, this, &Stream2DRep3D::setModified);
 }
 
 QString Stream2DRep3D::getType() const
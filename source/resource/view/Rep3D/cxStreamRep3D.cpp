@@ -52,6 +52,7 @@ void StreamRep3D::setTrackedStream(TrackedStreamPtr trackedStream)
 		disconnect(mTrackedStream.get(), &TrackedStream::newTool, this, &StreamRep3D::newTool);
 		disconnect(mTrackedStream.get(), &TrackedStream::newVideoSource, this, &StreamRep3D::newVideoSource);
 		disconnect(mTrackedStream.get(), &TrackedStream::newFrame, this, &StreamRep3D::vtkImageDataChangedSlot);
+		disconnect(mTrackedStream.get(), &TrackedStream::newFrame, this, &StreamRep3D::setModified);
 	}
 
 	mTrackedStream = trackedStream;
@@ -61,6 +62,7 @@ void StreamRep3D::setTrackedStream(TrackedStreamPtr trackedStream)
 		connect(mTrackedStream.get(), &TrackedStream::newTool, this, &StreamRep3D::newTool);
 		connect(mTrackedStream.get(), &TrackedStream::newVideoSource, this, &StreamRep3D::newVideoSource);
 		connect(mTrackedStream.get(), &TrackedStream::newFrame, this, &StreamRep3D::vtkImageDataChangedSlot);
+		connect(mTrackedStream.get(), &TrackedStream::newFrame, this, &StreamRep3D::setModified);
 		this->newTool(mTrackedStream->getProbeTool());
 		this->newVideoSource(mTrackedStream->getVideoSource());
 	}
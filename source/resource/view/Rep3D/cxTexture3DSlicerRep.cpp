@@ -87,7 +87,11 @@ std::vector<ImagePtr> Texture3DSlicerRep::getImages()
 
 void Texture3DSlicerRep::setSliceProxy(SliceProxyPtr slicer)
 {
+	if (mProxy->getSliceProxy())
+		disconnect(mProxy->getSliceProxy().get(), SIGNAL(transformChanged(Transform3D)), this, SLOT(setModified()));
 	mProxy->setSliceProxy(slicer);
+	if (slicer)
+		connect(slicer.get(), SIGNAL(transformChanged(Transform3D)), this, SLOT(setModified()), Qt::UniqueConnection);
 }
 
 void Texture3DSlicerRep::addRepActorsToViewRenderer(ViewPtr view)
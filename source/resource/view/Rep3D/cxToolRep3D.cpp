@@ -125,7 +125,7 @@ void ToolRep3D::setTool(ToolPtr tool)
 
 	if (mTool)
 	{
-		disconnect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this, SLOT(setModified()));
+		disconnect(mTool.get(), SIGNAL(toolTransformCoalesced(Transform3D, double)), this, SLOT(setModified()));
 		disconnect(mTool.get(), SIGNAL(toolVisible(bool)), this, SLOT(receiveVisible(bool)));
 		disconnect(mTool.get(), SIGNAL(tooltipOffset(double)), this, SLOT(tooltipOffsetSlot(double)));
 		disconnect(mTool.get(), SIGNAL(toolProbeSector()), this, SLOT(probeSectorChanged()));
@@ -136,7 +136,7 @@ void ToolRep3D::setTool(ToolPtr tool)
 
 	if (mTool)
 	{
-		connect(mTool.get(), SIGNAL(toolTransformAndTimestamp(Transform3D, double)), this, SLOT(setModified()));
+		connect(mTool.get(), SIGNAL(toolTransformCoalesced(Transform3D, double)), this, SLOT(setModified()));
 		connect(mTool.get(), SIGNAL(toolVisible(bool)), this, SLOT(receiveVisible(bool)));
 		connect(mTool.get(), SIGNAL(tooltipOffset(double)), this, SLOT(tooltipOffsetSlot(double)));
 		connect(mTool.get(), SIGNAL(toolProbeSector()), this, SLOT(probeSectorChanged()));
@@ -26,6 +26,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkVolume.h>
 #include <vtkRenderer.h>
 #include <vtkMatrix4x4.h>
+#include <vtkCallbackCommand.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <QTimer>
 
 #include "cxView.h"
 #include "cxImage.h"
@@ -42,14 +46,31 @@ typedef vtkSmartPointer<class vtkGPUVolumeRayCastMapper> vtkGPUVolumeRayCastMapp
 
 namespace cx
 {
+namespace
+{
+const int idleInterval = 500; ///< ms without interaction before restoring the full volume
+const vtkIdType minVoxelsForInteractiveLevel = 16*1024*1024; ///< smaller volumes render fast enough as they are
+}
+
 VolumetricRep::VolumetricRep() :
 	VolumetricBaseRep(),
 	mVolume(vtkVolumePtr::New()),
 	mVolumeProperty(cx::VolumeProperty::create()),
-	mMaxVoxels(0)
+	mMaxVoxels(0),
+	mInteracting(false),
+	mButtonDown(false)
 {
 	this->setUseVolumeTextureMapper();
 	mVolume->SetProperty(mVolumeProperty->getVolumeProperty());
+
+	mIdleTimer = new QTimer(this);
+	mIdleTimer->setSingleShot(true);
+	mIdleTimer->setInterval(idleInterval);
+	connect(mIdleTimer, &QTimer::timeout, this, &VolumetricRep::idleSlot);
+
+	mInteractionCommand = vtkCallbackCommandPtr::New();
+	mInteractionCommand->SetClientData(this);
+	mInteractionCommand->SetCallback(VolumetricRep::processInteractionEvents);
 }
 
 VolumetricRep::~VolumetricRep()
@@ -83,11 +104,78 @@ void VolumetricRep::setUseVolumeTextureMapper()
 void VolumetricRep::addRepActorsToViewRenderer(ViewPtr view)
 {
 	view->getRenderer()->AddVolume(mVolume);
+
+	mInteractor = view->getRenderWindow()->GetInteractor();
+	if (mInteractor)
+	{
+		unsigned long events[] = { vtkCommand::LeftButtonPressEvent, vtkCommand::MiddleButtonPressEvent, vtkCommand::RightButtonPressEvent,
+								   vtkCommand::LeftButtonReleaseEvent, vtkCommand::MiddleButtonReleaseEvent, vtkCommand::RightButtonReleaseEvent,
+								   vtkCommand::MouseMoveEvent, vtkCommand::MouseWheelForwardEvent, vtkCommand::MouseWheelBackwardEvent };
+		for (unsigned i=0; i<sizeof(events)/sizeof(events[0]); ++i)
+			mInteractor->AddObserver(events[i], mInteractionCommand);
+	}
 }
 
 void VolumetricRep::removeRepActorsFromViewRenderer(ViewPtr view)
 {
 	view->getRenderer()->RemoveVolume(mVolume);
+
+	if (mInteractor)
+		mInteractor->RemoveObserver(mInteractionCommand);
+	mInteractor = NULL;
+	mIdleTimer->stop();
+	mButtonDown = false;
+	this->setInteracting(false);
+}
+
+void VolumetricRep::processInteractionEvents(vtkObject* object, unsigned long event, void* clientdata, void* calldata)
+{
+	VolumetricRep* self = static_cast<VolumetricRep*>(clientdata);
+	switch (event)
+	{
+	case vtkCommand::LeftButtonPressEvent:
+	case vtkCommand::MiddleButtonPressEvent:
+	case vtkCommand::RightButtonPressEvent:
+		self->mButtonDown = true;
+		break;
+	case vtkCommand::MouseMoveEvent:
+		// dragging, clicks alone are not interaction
+		if (self->mButtonDown)
+			self->setInteracting(true);
+		break;
+	case vtkCommand::LeftButtonReleaseEvent:
+	case vtkCommand::MiddleButtonReleaseEvent:
+	case vtkCommand::RightButtonReleaseEvent:
+		self->mButtonDown = false;
+		if (self->mInteracting)
+			self->mIdleTimer->start();
+		break;
+	case vtkCommand::MouseWheelForwardEvent:
+	case vtkCommand::MouseWheelBackwardEvent:
+		self->setInteracting(true);
+		self->mIdleTimer->start();
+		break;
+	default:
+		break;
+	}
+}
+
+void VolumetricRep::setInteracting(bool on)
+{
+	if (on)
+		mIdleTimer->stop();
+	if (mInteracting==on)
+		return;
+	mInteracting = on;
+	this->updateVtkImageDataSlot();
+}
+
+void VolumetricRep::idleSlot()
+{
+	if (mButtonDown)
+		return;
+	this->setInteracting(false);
+	this->setModified();
 }
 
 ImagePtr VolumetricRep::getImage()
@@ -154,7 +242,39 @@ void VolumetricRep::updateVtkImageDataSlot()
 		return;
 
 	vtkImageDataPtr volume = mImage->resample(this->mMaxVoxels);
-	mMapper->SetInputData(volume);
+
+	if (mInteracting)
+	{
+		vtkImageDataPtr coarse = this->getInteractiveVolume(volume);
+		if (coarse)
+			volume = coarse;
+	}
+	else if (volume->GetNumberOfPoints() > minVoxelsForInteractiveLevel)
+	{
+		mImage->getPyramidLevel(1); // start building in the background, ready for the next interaction
+	}
+
+	if (mMapper->GetInput() != volume.GetPointer())
+		mMapper->SetInputData(volume);
+}
+
+/** Return the finest pyramid level that is at least 2x coarser
+ *  along each axis than stillVolume, or zero if none is ready.
+ */
+vtkImageDataPtr VolumetricRep::getInteractiveVolume(vtkImageDataPtr stillVolume)
+{
+	if (stillVolume->GetNumberOfPoints() <= minVoxelsForInteractiveLevel)
+		return vtkImageDataPtr();
+
+	for (int level=1; level<=ImagePyramid::maxLevel; ++level)
+	{
+		vtkImageDataPtr candidate = mImage->getPyramidLevel(level);
+		if (!candidate)
+			return vtkImageDataPtr();
+		if (candidate->GetNumberOfPoints()*8 <= stillVolume->GetNumberOfPoints())
+			return candidate;
+	}
+	return vtkImageDataPtr();
 }
 
 void VolumetricRep::setMaxVolumeSize(long maxVoxels)
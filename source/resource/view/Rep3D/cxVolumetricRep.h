@@ -20,6 +20,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 
+class QTimer;
+class vtkObject;
+
 
 namespace cx
 {
@@ -59,6 +62,11 @@ protected:
  *
  * Use this to render volumetric image data in a 3D scene. Both
  * texture rendering and GPU raycasting are available.
+ *
+ * While the user rotates or drags in the view, a coarser level
+ * from the image pyramid is rendered if available. The full
+ * volume (limited by the max volume size) is restored when the
+ * interaction has been idle for a short while.
  * 
  * Used by Sonowand.
  * Used by CustusX.
@@ -95,10 +103,20 @@ protected:
 	ImagePtr mImage;
 	cx::ImageMapperMonitorPtr mMonitor; ///< helper object for visualizing clipping/cropping
 
+	void setInteracting(bool on);
+	vtkImageDataPtr getInteractiveVolume(vtkImageDataPtr stillVolume);
+	static void processInteractionEvents(vtkObject* object, unsigned long event, void* clientdata, void* calldata);
+	vtkCallbackCommandPtr mInteractionCommand;
+	vtkRenderWindowInteractorPtr mInteractor;
+	QTimer* mIdleTimer;
+	bool mInteracting; ///< render the coarse pyramid level
+	bool mButtonDown;
+
 protected slots:
 	void transformChangedSlot();
 	void vtkImageDataChangedSlot();
 	void updateVtkImageDataSlot();
+	void idleSlot();
 };
 //---------------------------------------------------------
 } // namespace cx
@@ -126,6 +126,7 @@ void VideoFixedPlaneRep::newDataSlot()
 	mOrientationVText->getActor()->SetVisibility(mData->validData());
 	this->setCamera();
 	this->updateSector();
+	this->setModified();
 }
 
 /**We need this here, even if it belongs in singlelayout.
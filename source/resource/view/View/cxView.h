@@ -87,6 +87,7 @@ signals:
 	void shown();
 	void focusChange(bool gotFocus, Qt::FocusReason reason);
 	void customContextMenuRequested(const QPoint&);
+	void modified(); ///< emitted by setModified(): the view should be rendered
 };
 typedef boost::shared_ptr<View> ViewPtr;
 
@@ -51,6 +51,7 @@ public:
 	virtual void clearViews() = 0;
 	virtual void setModified() = 0;
 	virtual void render() = 0;
+	virtual bool renderView(ViewPtr view) = 0; ///< Render the view if its scene has changed, return true if rendered. Views sharing a render window are rendered together.
 	virtual void setGridSpacing(int val) = 0;
 	virtual void setGridMargin(int val) = 0;
     virtual int getGridSpacing() const = 0;
@@ -85,6 +85,14 @@ void ViewCollectionWidgetUsingViewContainer::render()
     emit rendered();
 }
 
+bool ViewCollectionWidgetUsingViewContainer::renderView(ViewPtr view)
+{
+	// all views share one render window
+	if (std::find(mViews.begin(), mViews.end(), view) == mViews.end())
+		return false;
+	return mViewContainer->renderAll();
+}
+
 void ViewCollectionWidgetUsingViewContainer::setGridSpacing(int val)
 {
 	mViewContainer->getGridLayout()->setSpacing(val);
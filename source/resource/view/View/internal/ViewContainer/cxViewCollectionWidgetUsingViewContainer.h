@@ -45,6 +45,7 @@ public:
 	void clearViews();
 	virtual void setModified();
 	virtual void render();
+	virtual bool renderView(ViewPtr view);
 	virtual void setGridSpacing(int val);
 	virtual void setGridMargin(int val);
     virtual int getGridSpacing() const;
@@ -262,7 +262,7 @@ void ViewContainer::showEvent(QShowEvent* event)
 	inherited_widget::showEvent(event);
 }
 
-void ViewContainer::renderAll()
+bool ViewContainer::renderAll()
 {
 	// First, calculate if anything has changed
 	long hash = 0;
@@ -279,7 +279,9 @@ void ViewContainer::renderAll()
 
 		QString msg("During rendering of ViewContainer");
 		report_gl_error_text(cstring_cast(msg));
+		return true;
 	}
+	return false;
 }
 
 void ViewContainer::doRender()
@@ -47,7 +47,7 @@ public:
 
 	ViewItem *addView(QString uid, LayoutRegion region, QString name = "");
 	virtual void clear();
-	void renderAll(); ///< Use this function to render all views at once. Do not call render on each view.
+	bool renderAll(); ///< Use this function to render all views at once. Do not call render on each view. Return true if rendered.
 
 	virtual void setOffScreenRenderingAndClear(bool on);
 	virtual bool getOffScreenRendering() const;
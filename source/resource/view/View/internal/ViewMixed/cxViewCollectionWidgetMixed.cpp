@@ -132,6 +132,16 @@ void ViewCollectionWidgetMixed::render()
     emit rendered();
 }
 
+bool ViewCollectionWidgetMixed::renderView(ViewPtr view)
+{
+	for (unsigned i=0; i<mOverlays.size(); ++i)
+	{
+		if (mOverlays[i]->getView() == view)
+			return mOverlays[i]->render();
+	}
+	return mBaseLayout->renderView(view);
+}
+
 void ViewCollectionWidgetMixed::setGridSpacing(int val)
 {
 	mLayout->setSpacing(val);
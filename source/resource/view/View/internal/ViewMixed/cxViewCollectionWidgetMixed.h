@@ -63,6 +63,7 @@ public:
 	virtual void clearViews();
 	virtual void setModified();
 	virtual void render();
+	virtual bool renderView(ViewPtr view);
 	virtual void setGridSpacing(int val);
 	virtual void setGridMargin(int val);
     virtual int getGridSpacing() const;
@@ -96,6 +96,14 @@ void LayoutWidgetUsingViewWidgets::render()
     emit rendered();
 }
 
+bool LayoutWidgetUsingViewWidgets::renderView(ViewPtr view)
+{
+	ViewWidget* widget = this->WidgetFromView(view);
+	if (!widget)
+		return false;
+	return widget->render();
+}
+
 QPoint LayoutWidgetUsingViewWidgets::getPosition(ViewPtr view)
 {
     ViewWidget* widget = this->WidgetFromView(view);
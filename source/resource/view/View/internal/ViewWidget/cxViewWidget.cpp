@@ -63,7 +63,7 @@ vtkRendererPtr ViewWidget::getRenderer()
 	return this->getView()->getRenderer();
 }
 
-void ViewWidget::render()
+bool ViewWidget::render()
 {
 	// Render is called only when mtime is changed.
 	// At least on MaxOS, this is not done automatically.
@@ -76,7 +76,9 @@ void ViewWidget::render()
 
 		QString msg("During rendering of view: " + this->getView()->getName());
 		report_gl_error_text(cstring_cast(msg));
+		return true;
 	}
+	return false;
 }
 
 void ViewWidget::resizeEvent(QResizeEvent * event)
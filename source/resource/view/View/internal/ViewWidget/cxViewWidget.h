@@ -48,7 +48,7 @@ public:
 	virtual DoubleBoundingBox3D getViewport_s() const;
 
 	virtual void setModified() { mView->setModified(); }
-	void render();
+	bool render(); ///< render if the scene has changed, return true if rendered
 
 signals:
 	void resized(QSize size);
@@ -87,6 +87,7 @@ void ViewRepCollection::addRep(const RepPtr& rep)
 
 	rep->connectToView(mSelf.lock());
 	mReps.push_back(rep);
+	this->setModified();
 }
 
 void ViewRepCollection::setBackgroundColor(QColor color)
@@ -135,6 +136,7 @@ void ViewRepCollection::removeRep(const RepPtr& rep)
 
 	rep->disconnectFromView(mSelf.lock());
 	mReps.erase(it);
+	this->setModified();
 }
 
 std::vector<RepPtr> ViewRepCollection::getReps()
@@ -193,6 +195,7 @@ void ViewRepCollection::setModified()
 {
 	this->getRenderer()->Modified();
 	this->getRenderWindow()->Modified();
+	emit modified();
 }
 
 int ViewRepCollection::computeTotalMTime()
@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxSharedOpenGLContext.h"
 
+#include <vtk_glew.h>
 #include <vtkOpenGLRenderWindow.h>
 #include <vtkNew.h>
 #include <vtkTextureObject.h>
@@ -394,6 +395,32 @@ vtkOpenGLBufferObjectPtr SharedOpenGLContext::getTextureCoordinates(QString uid)
 	return retval;
 }
 
+namespace
+{
+/** Signed types are uploaded to normalized signed textures, sampled as value/scalarTypeMax
+ *  in [-1,1]. This is the same normalization as used for unsigned types, thus the window/level
+ *  computed from the original lookup table can be used unchanged.
+ *  Return 0 (use vtk default) for all other types.
+ */
+unsigned int getSignedNormalizedInternalFormat(int dataType, int numComps)
+{
+	if (numComps != 1)
+		return 0;
+	if (dataType == VTK_SHORT)
+		return GL_R16_SNORM;
+	if (dataType == VTK_SIGNED_CHAR)
+		return GL_R8_SNORM;
+	return 0;
+}
+}
+
+bool SharedOpenGLContext::canUploadAsSignedTexture(vtkImageDataPtr image)
+{
+	if (!image)
+		return false;
+	return getSignedNormalizedInternalFormat(image->GetScalarType(), image->GetNumberOfScalarComponents()) != 0;
+}
+
 bool SharedOpenGLContext::create3DTextureObject(vtkTextureObjectPtr texture_object, unsigned int width, unsigned int height,  unsigned int depth, int dataType, int numComps, void *data, vtkOpenGLRenderWindowPtr opengl_renderwindow) const
 {
 
@@ -405,6 +432,7 @@ bool SharedOpenGLContext::create3DTextureObject(vtkTextureObjectPtr texture_obje
 
 	texture_object->SetContext(opengl_renderwindow);
 	//opengl_renderwindow->ActivateTexture(texture_object);
+	texture_object->SetInternalFormat(getSignedNormalizedInternalFormat(dataType, numComps));
 
 	if(texture_object->Create3DFromRaw(width, height, depth, numComps, dataType, data))
 	{
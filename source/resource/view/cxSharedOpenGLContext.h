@@ -45,6 +45,7 @@ class cxResourceVisualization_EXPORT SharedOpenGLContext
 {
 public:
 	static bool isValid(vtkOpenGLRenderWindowPtr opengl_renderwindow, bool print=false);
+	static bool canUploadAsSignedTexture(vtkImageDataPtr image); ///< signed volumes of these types are sampled directly, no unsigned copy needed
 
 	SharedOpenGLContext(vtkOpenGLRenderWindowPtr sharedContext);
 	~SharedOpenGLContext();
@@ -23,7 +23,8 @@ namespace cx
 
 FrameTreeWidget::FrameTreeWidget(PatientModelServicePtr patientService, QWidget* parent) :
   BaseWidget(parent, "frame_tree_widget", "Frame Tree"),
-  mPatientService(patientService)
+  mPatientService(patientService),
+  mForest(new FrameForest())
 {
   QVBoxLayout* layout = new QVBoxLayout(this);
 
@@ -63,20 +64,19 @@ void FrameTreeWidget::rebuild()
 {
   mTreeWidget->clear();
 
-  FrameForest forest(mPatientService->getDatas());
-  QDomElement root = forest.getDocument().documentElement();
-
-  this->fill(mTreeWidget->invisibleRootItem(), root);
+  mForest->setSource(mPatientService->getDatas());
+  this->fill(mTreeWidget->invisibleRootItem(), "");
 
   mTreeWidget->expandToDepth(10);
   mTreeWidget->resizeColumnToContents(0);
 }
 
-void FrameTreeWidget::fill(QTreeWidgetItem* parent, QDomNode node)
+void FrameTreeWidget::fill(QTreeWidgetItem* parent, QString frame)
 {
-  for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling())
+  std::vector<QString> children = mForest->getChildren(frame);
+  for (unsigned i=0; i<children.size(); ++i)
   {
-    QString frameName = child.toElement().tagName();
+    QString frameName = children[i];
 
     // if frame refers to a data, use its name instead.
 	DataPtr data = mPatientService->getData(frameName);
@@ -84,7 +84,7 @@ void FrameTreeWidget::fill(QTreeWidgetItem* parent, QDomNode node)
       frameName = data->getName();
 
     QTreeWidgetItem* item = new QTreeWidgetItem(parent, QStringList() << frameName);
-    this->fill(item, child);
+    this->fill(item, children[i]);
   }
 }
 
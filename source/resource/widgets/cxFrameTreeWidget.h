@@ -22,10 +22,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxForwardDeclarations.h"
 class QTreeWidget;
 class QTreeWidgetItem;
-class QDomNode;
 
 namespace cx
 {
+typedef boost::shared_ptr<class FrameForest> FrameForestPtr;
 
 /**
  * \class FrameTreeWidget
@@ -48,7 +48,8 @@ protected:
 private:
   PatientModelServicePtr mPatientService;
   QTreeWidget* mTreeWidget;
-  void fill(QTreeWidgetItem* parent, QDomNode node);
+  FrameForestPtr mForest;
+  void fill(QTreeWidgetItem* parent, QString frame);
   std::map<QString, DataPtr> mConnectedData;
 
 private slots: